@@ -0,0 +1,57 @@
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+	std::atomic<uint64_t> gAllocations(0);
+	std::atomic<uint64_t> gAllocatedBytes(0);
+}
+
+AllocationCounts GetAllocationCounts()
+{
+	AllocationCounts Counts;
+	Counts.Allocations = gAllocations.load(std::memory_order_relaxed);
+	Counts.Bytes = gAllocatedBytes.load(std::memory_order_relaxed);
+	return Counts;
+}
+
+void* operator new(std::size_t Size)
+{
+	gAllocations.fetch_add(1, std::memory_order_relaxed);
+	gAllocatedBytes.fetch_add(Size, std::memory_order_relaxed);
+
+	void* Memory = malloc(Size > 0 ? Size : 1);
+	if (!Memory)
+	{
+		throw std::bad_alloc();
+	}
+	return Memory;
+}
+
+void* operator new[](std::size_t Size)
+{
+	return operator new(Size);
+}
+
+void operator delete(void* Memory) noexcept
+{
+	free(Memory);
+}
+
+void operator delete[](void* Memory) noexcept
+{
+	free(Memory);
+}
+
+void operator delete(void* Memory, std::size_t) noexcept
+{
+	free(Memory);
+}
+
+void operator delete[](void* Memory, std::size_t) noexcept
+{
+	free(Memory);
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+
+//Counts every global operator new made by the program. AllocationCounter.cpp
+//replaces the global operator new/delete, so it is only linked in to the
+//benchmark tools that report allocations - never in to the engine itself.
+//
+//Array, nothrow and sized forms go through the replaced ones. Over aligned
+//allocations (alignas > 16) and direct malloc calls aren't counted.
+struct AllocationCounts
+{
+	uint64_t Allocations = 0;
+	uint64_t Bytes = 0;
+};
+
+//Totals since startup, from any thread. Take the difference of two to count
+//the allocations made in between.
+AllocationCounts GetAllocationCounts();
@@ -0,0 +1,185 @@
+#include "ArchiveBenchmark.h"
+#include "Common.h"
+#include "FileUtils.h"
+#include "JobSystem.h"
+#include "PackArchive.h"
+#include "PackArchiveBuilder.h"
+
+#include <chrono>
+#include <cstring>
+#include <stdio.h>
+
+namespace
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	double MillisecondsSince(Clock::time_point Start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - Start).count();
+	}
+}
+
+ArchiveBenchmark::ArchiveBenchmark(const ArchiveBenchmarkSettings& Settings)
+	: mSettings(Settings), mFileCount(0)
+{
+	Assert(mSettings.Iterations > 0);
+}
+
+ArchiveBenchmark::~ArchiveBenchmark()
+{}
+
+bool ArchiveBenchmark::Run()
+{
+	mResults.clear();
+
+	std::vector<std::string> Files;
+	ListFilesRecursive(mSettings.SourceDirectory, Files);
+	mFileCount = static_cast<uint32_t>(Files.size());
+	if (Files.empty())
+	{
+		mLastError = "No files in " + mSettings.SourceDirectory;
+		return false;
+	}
+
+	std::string CompressedPath = JoinPath(mSettings.WorkingDirectory, "ArchiveBenchmarkCompressed.pack");
+	std::string StoredPath = JoinPath(mSettings.WorkingDirectory, "ArchiveBenchmarkStored.pack");
+
+	PackArchiveBuilderSettings BuilderSettings;
+	BuilderSettings.BlockSize = mSettings.BlockSize;
+	BuilderSettings.ThreadCount = mSettings.ThreadCount;
+
+	for (int Stored = 0; Stored < 2; ++Stored)
+	{
+		BuilderSettings.bCompress = Stored == 0;
+		PackArchiveBuilder Builder(BuilderSettings);
+		Builder.AddDirectory(mSettings.SourceDirectory);
+		if (!Builder.Write(Stored ? StoredPath.c_str() : CompressedPath.c_str()))
+		{
+			mLastError = Builder.GetLastError();
+			return false;
+		}
+	}
+
+	//Every mode reads in to the same buffer so allocation isn't measured
+	std::vector<uint8_t> Buffer;
+	uint32_t Passes = mSettings.Iterations + 1;
+
+	//Loose files
+	{
+		uint64_t Bytes = 0;
+		uint64_t StorageBytes = 0;
+		double Milliseconds = 0.0;
+		for (uint32_t Pass = 0; Pass < Passes; ++Pass)
+		{
+			auto Start = Clock::now();
+			Bytes = 0;
+			for (const std::string& Name : Files)
+			{
+				FILE* File = fopen(JoinPath(mSettings.SourceDirectory, Name).c_str(), "rb");
+				if (!File)
+				{
+					continue;
+				}
+				fseek(File, 0, SEEK_END);
+				size_t Size = static_cast<size_t>(ftell(File));
+				fseek(File, 0, SEEK_SET);
+				if (Buffer.size() < Size)
+				{
+					Buffer.resize(Size);
+				}
+				Bytes += fread(Buffer.data(), 1, Size, File);
+				fclose(File);
+			}
+			Milliseconds += Pass > 0 ? MillisecondsSince(Start) : 0.0;
+		}
+		StorageBytes = Bytes;
+		AddResult("Loose", Bytes, StorageBytes, Milliseconds);
+	}
+
+	//Archives
+	JobSystem Jobs(mSettings.ThreadCount);
+	const char* Modes[] = { "Compressed", "CompressedParallel", "StoredMapped" };
+	for (int Mode = 0; Mode < 3; ++Mode)
+	{
+		PackArchive Archive;
+		if (!Archive.Open(Mode == 2 ? StoredPath.c_str() : CompressedPath.c_str()))
+		{
+			mLastError = "Couldn't open archive";
+			return false;
+		}
+
+		uint64_t Bytes = 0;
+		double Milliseconds = 0.0;
+		for (uint32_t Pass = 0; Pass < Passes; ++Pass)
+		{
+			auto Start = Clock::now();
+			Bytes = 0;
+			for (const std::string& Name : Files)
+			{
+				uint32_t Entry = Archive.FindEntry(Name);
+				if (Entry == PackArchive::InvalidEntry)
+				{
+					mLastError = "Missing entry " + Name;
+					return false;
+				}
+
+				size_t Size = static_cast<size_t>(Archive.GetEntrySize(Entry));
+				if (Buffer.size() < Size)
+				{
+					Buffer.resize(Size);
+				}
+
+				if (Mode == 2)
+				{
+					//The copy stands in for the upload - the data is usable in place
+					memcpy(Buffer.data(), Archive.GetEntryData(Entry), Size);
+				}
+				else if (!Archive.ReadEntry(Entry, Buffer.data(), Mode == 1 ? &Jobs : nullptr))
+				{
+					mLastError = "Corrupt entry " + Name;
+					return false;
+				}
+				Bytes += Size;
+			}
+			Milliseconds += Pass > 0 ? MillisecondsSince(Start) : 0.0;
+		}
+
+		AddResult(Modes[Mode], Bytes, Archive.GetArchiveSize(), Milliseconds);
+	}
+
+	return true;
+}
+
+void ArchiveBenchmark::AddResult(const char* Mode, uint64_t Bytes, uint64_t StorageBytes, double TotalMilliseconds)
+{
+	ArchiveBenchmarkResult Result;
+	Result.Mode = Mode;
+	Result.Bytes = Bytes;
+	Result.StorageBytes = StorageBytes;
+	Result.Milliseconds = TotalMilliseconds / mSettings.Iterations;
+	Result.MegabytesPerSecond = Result.Milliseconds > 0.0 ?
+		(Bytes / (1024.0 * 1024.0)) / (Result.Milliseconds / 1000.0) : 0.0;
+	mResults.push_back(Result);
+}
+
+bool ArchiveBenchmark::WriteReport(const char* Filename) const
+{
+	FILE* File = fopen(Filename, "w");
+	if (!File)
+	{
+		return false;
+	}
+
+	fprintf(File, "Source:      %s (%u files)\n", mSettings.SourceDirectory.c_str(), mFileCount);
+	fprintf(File, "Block size:  %u\n", mSettings.BlockSize);
+	fprintf(File, "Iterations:  %u\n\n", mSettings.Iterations);
+	fprintf(File, "Mode,MB,StorageMB,MsPerPass,MBPerSecond\n");
+	for (const ArchiveBenchmarkResult& Result : mResults)
+	{
+		fprintf(File, "%s,%.2f,%.2f,%.3f,%.1f\n", Result.Mode.c_str(), Result.Bytes / (1024.0 * 1024.0),
+			Result.StorageBytes / (1024.0 * 1024.0), Result.Milliseconds, Result.MegabytesPerSecond);
+	}
+
+	fclose(File);
+	return true;
+}
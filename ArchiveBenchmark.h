@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//Read throughput of the same content as loose files, a compressed archive
+//(serial and with parallel block decompression) and a stored archive used in
+//place through its memory mapping. Archives are built in to WorkingDirectory.
+//
+//Runs Iterations passes after one warm up pass, so these are warm cache
+//numbers - they measure per file overhead and decompression cost rather than
+//the device.
+struct ArchiveBenchmarkSettings
+{
+	std::string SourceDirectory;
+	std::string WorkingDirectory = ".";
+	uint32_t Iterations = 5;
+	uint32_t BlockSize = 64 * 1024;
+	uint32_t ThreadCount = 0;
+};
+
+struct ArchiveBenchmarkResult
+{
+	std::string Mode;
+	uint64_t Bytes = 0;				//Uncompressed bytes read per pass
+	uint64_t StorageBytes = 0;		//On disk
+	double Milliseconds = 0.0;		//Per pass
+	double MegabytesPerSecond = 0.0;
+};
+
+class ArchiveBenchmark
+{
+public:
+	ArchiveBenchmark(const ArchiveBenchmarkSettings& Settings);
+	~ArchiveBenchmark();
+
+	bool Run();
+	bool WriteReport(const char* Filename) const;
+
+	const std::string& GetLastError() const { return mLastError; }
+
+private:
+	void AddResult(const char* Mode, uint64_t Bytes, uint64_t StorageBytes, double TotalMilliseconds);
+
+private:
+	ArchiveBenchmarkSettings mSettings;
+	uint32_t mFileCount;
+	std::vector<ArchiveBenchmarkResult> mResults;
+	std::string mLastError;
+};
@@ -0,0 +1,384 @@
+#include "AssetCooker.h"
+#include "Common.h"
+#include "FileUtils.h"
+#include "Hash.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <stdio.h>
+
+namespace
+{
+	const char* DatabaseHeader = "# AssetCooker database v1";
+	const char* SourceDirectoryToken = "$(Source)/";
+
+	void SplitTabs(const std::string& Line, std::vector<std::string>& OutFields)
+	{
+		OutFields.clear();
+		size_t Start = 0;
+		for (;;)
+		{
+			size_t Tab = Line.find('\t', Start);
+			OutFields.push_back(Line.substr(Start, Tab == std::string::npos ? std::string::npos : Tab - Start));
+			if (Tab == std::string::npos)
+			{
+				break;
+			}
+			Start = Tab + 1;
+		}
+	}
+}
+
+AssetCooker::AssetCooker(const AssetCookerSettings& Settings)
+	: mSettings(Settings)
+{}
+
+AssetCooker::~AssetCooker()
+{}
+
+void AssetCooker::AddCooker(IAssetTypeCooker* Cooker)
+{
+	Assert(Cooker);
+	mCookers.push_back(Cooker);
+}
+
+bool AssetCooker::Run()
+{
+	auto Start = std::chrono::high_resolution_clock::now();
+
+	mAssets.clear();
+	mRecords.clear();
+	mStats = AssetCookerStats();
+	mDependencyHashes.clear();
+
+	if (!mSettings.bForce)
+	{
+		LoadDatabase();
+	}
+
+	std::vector<std::string> Files;
+	ListFilesRecursive(mSettings.SourceDirectory, Files);
+	for (const std::string& File : Files)
+	{
+		for (IAssetTypeCooker* Cooker : mCookers)
+		{
+			if (Cooker->Accepts(File))
+			{
+				PendingAsset Asset;
+				Asset.RelativePath = File;
+				Asset.Cooker = Cooker;
+				Asset.bHasEntry = false;
+				mAssets.push_back(Asset);
+				break;
+			}
+		}
+	}
+
+	//One job per asset - cook times vary far too much for bigger batches
+	mRecords.resize(mAssets.size());
+	{
+		JobSystem Jobs(mSettings.ThreadCount);
+		Jobs.ParallelFor(static_cast<uint32_t>(mAssets.size()), 1, [this](uint32_t Begin, uint32_t End)
+		{
+			for (uint32_t i = Begin; i < End; ++i)
+			{
+				CookAsset(mAssets[i], mRecords[i]);
+			}
+		});
+	}
+
+	//Failed assets drop out of the database so they are retried next run
+	mDatabase.clear();
+	for (size_t i = 0; i < mAssets.size(); ++i)
+	{
+		switch (mRecords[i].Result)
+		{
+		case AssetCookResult::Cooked:
+			++mStats.CookedCount;
+			break;
+		case AssetCookResult::Cached:
+			++mStats.CachedCount;
+			break;
+		case AssetCookResult::Failed:
+			++mStats.FailedCount;
+			break;
+		}
+
+		if (mAssets[i].bHasEntry)
+		{
+			mDatabase[mAssets[i].RelativePath] = mAssets[i].NewEntry;
+		}
+	}
+	mStats.AssetCount = static_cast<uint32_t>(mAssets.size());
+
+	bool bSaved = SaveDatabase();
+
+	mStats.WallMilliseconds = std::chrono::duration<double, std::milli>(
+		std::chrono::high_resolution_clock::now() - Start).count();
+
+	return bSaved && mStats.FailedCount == 0;
+}
+
+void AssetCooker::CookAsset(PendingAsset& Asset, AssetCookRecord& Record)
+{
+	auto Start = std::chrono::high_resolution_clock::now();
+
+	Record.RelativePath = Asset.RelativePath;
+	Record.CookerName = Asset.Cooker->GetName();
+	Record.Result = AssetCookResult::Failed;
+
+	std::string SourcePath = JoinPath(mSettings.SourceDirectory, Asset.RelativePath);
+	std::string OutputPath = JoinPath(mSettings.OutputDirectory, Asset.Cooker->GetOutputPath(Asset.RelativePath));
+
+	std::vector<uint8_t> SourceData;
+	if (!ReadWholeFile(SourcePath, SourceData))
+	{
+		Record.Error = "Couldn't read source";
+	}
+	else
+	{
+		uint64_t SourceHash = HashBytes(SourceData.data(), SourceData.size());
+
+		if (!mSettings.bForce && IsUpToDate(Asset, SourceHash, OutputPath))
+		{
+			Asset.NewEntry = mDatabase.find(Asset.RelativePath)->second;
+			Asset.bHasEntry = true;
+			Record.Result = AssetCookResult::Cached;
+		}
+		else if (!CreateDirectories(GetDirectory(OutputPath)))
+		{
+			Record.Error = "Couldn't create output directory";
+		}
+		else
+		{
+			AssetCookJob Job;
+			Job.SourcePath = SourcePath;
+			Job.OutputPath = OutputPath;
+			Job.SourceData = &SourceData;
+
+			if (!Asset.Cooker->Cook(Job))
+			{
+				Record.Error = Job.Error;
+			}
+			else
+			{
+				Asset.NewEntry.CookerName = Asset.Cooker->GetName();
+				Asset.NewEntry.CookerVersion = Asset.Cooker->GetVersion();
+				Asset.NewEntry.SourceHash = SourceHash;
+
+				bool bDependenciesHashed = true;
+				for (const std::string& Dependency : Job.Dependencies)
+				{
+					std::string DatabasePath = ToDatabasePath(Dependency);
+					uint64_t DependencyHash = 0;
+					bDependenciesHashed &= HashDependency(DatabasePath, DependencyHash);
+					Asset.NewEntry.Dependencies.push_back(std::make_pair(DatabasePath, DependencyHash));
+				}
+
+				//Cooked fine, but can't be cached without knowing its inputs
+				Asset.bHasEntry = bDependenciesHashed;
+				Record.Result = AssetCookResult::Cooked;
+			}
+		}
+	}
+
+	Record.Milliseconds = std::chrono::duration<double, std::milli>(
+		std::chrono::high_resolution_clock::now() - Start).count();
+}
+
+bool AssetCooker::IsUpToDate(const PendingAsset& Asset, uint64_t SourceHash, const std::string& OutputPath)
+{
+	auto Found = mDatabase.find(Asset.RelativePath);
+	if (Found == mDatabase.end())
+	{
+		return false;
+	}
+
+	const DatabaseEntry& Entry = Found->second;
+	if (Entry.SourceHash != SourceHash || Entry.CookerName != Asset.Cooker->GetName() ||
+		Entry.CookerVersion != Asset.Cooker->GetVersion() || !FileExists(OutputPath))
+	{
+		return false;
+	}
+
+	for (const auto& Dependency : Entry.Dependencies)
+	{
+		uint64_t DependencyHash = 0;
+		if (!HashDependency(Dependency.first, DependencyHash) || DependencyHash != Dependency.second)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool AssetCooker::HashDependency(const std::string& DatabasePath, uint64_t& OutHash)
+{
+	{
+		std::lock_guard<std::mutex> Lock(mDependencyHashMutex);
+		auto Found = mDependencyHashes.find(DatabasePath);
+		if (Found != mDependencyHashes.end())
+		{
+			OutHash = Found->second.second;
+			return Found->second.first;
+		}
+	}
+
+	//Hash outside the lock - two threads may both hash a file the first time,
+	//which is harmless.
+	std::vector<uint8_t> Data;
+	bool bRead = ReadWholeFile(FromDatabasePath(DatabasePath), Data);
+	OutHash = bRead ? HashBytes(Data.data(), Data.size()) : 0;
+
+	std::lock_guard<std::mutex> Lock(mDependencyHashMutex);
+	mDependencyHashes[DatabasePath] = std::make_pair(bRead, OutHash);
+	return bRead;
+}
+
+std::string AssetCooker::ToDatabasePath(const std::string& Path) const
+{
+	//Files under the source directory are stored relative to it so the
+	//database survives the tree moving
+	std::string SourcePrefix = JoinPath(mSettings.SourceDirectory, "");
+	if (Path.compare(0, SourcePrefix.size(), SourcePrefix) == 0)
+	{
+		return SourceDirectoryToken + Path.substr(SourcePrefix.size());
+	}
+	return Path;
+}
+
+std::string AssetCooker::FromDatabasePath(const std::string& Path) const
+{
+	if (Path.compare(0, strlen(SourceDirectoryToken), SourceDirectoryToken) == 0)
+	{
+		return JoinPath(mSettings.SourceDirectory, Path.substr(strlen(SourceDirectoryToken)));
+	}
+	return Path;
+}
+
+bool AssetCooker::LoadDatabase()
+{
+	mDatabase.clear();
+
+	std::vector<uint8_t> Data;
+	if (!ReadWholeFile(GetDatabasePath(), Data))
+	{
+		return false;
+	}
+
+	std::string Text(Data.begin(), Data.end());
+	if (Text.compare(0, strlen(DatabaseHeader), DatabaseHeader) != 0)
+	{
+		return false;
+	}
+
+	//asset	<path>	<cooker>	<version>	<hash>
+	//dep	<path>	<hash>		(belongs to the asset above)
+	DatabaseEntry* Current = nullptr;
+	std::vector<std::string> Fields;
+
+	size_t LineStart = 0;
+	while (LineStart < Text.size())
+	{
+		size_t LineEnd = Text.find('\n', LineStart);
+		if (LineEnd == std::string::npos)
+		{
+			LineEnd = Text.size();
+		}
+		std::string Line = Text.substr(LineStart, LineEnd - LineStart);
+		LineStart = LineEnd + 1;
+
+		if (Line.empty() || Line[0] == '#')
+		{
+			continue;
+		}
+
+		SplitTabs(Line, Fields);
+		uint64_t Hash = 0;
+		if (Fields[0] == "asset" && Fields.size() == 5 && ParseHash(Fields[4].c_str(), Hash))
+		{
+			Current = &mDatabase[Fields[1]];
+			Current->CookerName = Fields[2];
+			Current->CookerVersion = static_cast<uint32_t>(strtoul(Fields[3].c_str(), nullptr, 10));
+			Current->SourceHash = Hash;
+		}
+		else if (Fields[0] == "dep" && Fields.size() == 3 && Current && ParseHash(Fields[2].c_str(), Hash))
+		{
+			Current->Dependencies.push_back(std::make_pair(Fields[1], Hash));
+		}
+		else
+		{
+			//Corrupt - cook everything rather than trust any of it
+			mDatabase.clear();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool AssetCooker::SaveDatabase() const
+{
+	if (!CreateDirectories(mSettings.OutputDirectory))
+	{
+		return false;
+	}
+
+	std::string Text = DatabaseHeader;
+	Text += "\n";
+
+	//Sorted so the file diffs cleanly between runs
+	std::vector<const std::pair<const std::string, DatabaseEntry>*> Entries;
+	for (const auto& Entry : mDatabase)
+	{
+		Entries.push_back(&Entry);
+	}
+	std::sort(Entries.begin(), Entries.end(), [](const std::pair<const std::string, DatabaseEntry>* A,
+		const std::pair<const std::string, DatabaseEntry>* B) { return A->first < B->first; });
+
+	for (const auto* Entry : Entries)
+	{
+		Text += "asset\t" + Entry->first + "\t" + Entry->second.CookerName + "\t" +
+			std::to_string(Entry->second.CookerVersion) + "\t" + HashToString(Entry->second.SourceHash) + "\n";
+		for (const auto& Dependency : Entry->second.Dependencies)
+		{
+			Text += "dep\t" + Dependency.first + "\t" + HashToString(Dependency.second) + "\n";
+		}
+	}
+
+	return WriteWholeFile(GetDatabasePath(), Text.data(), Text.size());
+}
+
+std::string AssetCooker::GetDatabasePath() const
+{
+	return JoinPath(mSettings.OutputDirectory, mSettings.DatabaseFilename);
+}
+
+bool AssetCooker::WriteReport(const char* Filename) const
+{
+	FILE* File = fopen(Filename, "w");
+	if (!File)
+	{
+		return false;
+	}
+
+	fprintf(File, "Asset,Cooker,Result,Milliseconds,Error\n");
+	for (const AssetCookRecord& Record : mRecords)
+	{
+		const char* Result = Record.Result == AssetCookResult::Cooked ? "Cooked" :
+			Record.Result == AssetCookResult::Cached ? "Cached" : "Failed";
+		fprintf(File, "%s,%s,%s,%.3f,%s\n", Record.RelativePath.c_str(), Record.CookerName, Result,
+			Record.Milliseconds, Record.Error.c_str());
+	}
+
+	fprintf(File, "\nAssets,%u\nCooked,%u\nCached,%u\nFailed,%u\nCacheHitRate,%.3f\nWallMilliseconds,%.3f\n",
+		mStats.AssetCount, mStats.CookedCount, mStats.CachedCount, mStats.FailedCount,
+		mStats.GetCacheHitRate(), mStats.WallMilliseconds);
+
+	fclose(File);
+	return true;
+}
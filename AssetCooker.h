@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//One cook: convert SourcePath in to OutputPath.
+struct AssetCookJob
+{
+	std::string SourcePath;
+	std::string OutputPath;
+	const std::vector<uint8_t>* SourceData;	//Already loaded for hashing
+
+	//Filled by the cooker - every other file the output depends on (includes etc).
+	std::vector<std::string> Dependencies;
+	std::string Error;
+};
+
+//Converts one kind of source asset. Cook() is called from several threads at
+//once so must not touch shared state.
+class IAssetTypeCooker
+{
+public:
+	IAssetTypeCooker() {};
+	virtual ~IAssetTypeCooker() {};
+
+	virtual const char* GetName() const = 0;
+
+	//Bump when the output format or conversion changes - invalidates every
+	//asset previously cooked by this cooker.
+	virtual uint32_t GetVersion() const = 0;
+
+	virtual bool Accepts(const std::string& RelativePath) const = 0;
+	virtual std::string GetOutputPath(const std::string& RelativePath) const = 0;
+
+	virtual bool Cook(AssetCookJob& Job) = 0;
+};
+
+struct AssetCookerSettings
+{
+	std::string SourceDirectory;
+	std::string OutputDirectory;
+	std::string DatabaseFilename = "CookDatabase.txt";	//Within OutputDirectory
+	uint32_t ThreadCount = 0;							//0 = all cores
+	bool bForce = false;								//Ignore the database and cook everything
+};
+
+enum class AssetCookResult
+{
+	Cooked,
+	Cached,
+	Failed
+};
+
+struct AssetCookRecord
+{
+	std::string RelativePath;
+	const char* CookerName = "";
+	AssetCookResult Result = AssetCookResult::Failed;
+	double Milliseconds = 0.0;
+	std::string Error;
+};
+
+struct AssetCookerStats
+{
+	uint32_t AssetCount = 0;
+	uint32_t CookedCount = 0;
+	uint32_t CachedCount = 0;
+	uint32_t FailedCount = 0;
+	double WallMilliseconds = 0.0;
+
+	double GetCacheHitRate() const { return AssetCount ? static_cast<double>(CachedCount) / AssetCount : 0.0; }
+};
+
+//Offline, incremental, parallel asset conversion.
+//
+//Every file under the source directory that a registered cooker accepts is
+//cooked in to the output directory (same relative path, cooker's extension).
+//The database records, per asset, the content hash of the source and of every
+//dependency the cooker reported plus the cooker's version. An asset is skipped
+//when all of those still match and its output exists - timestamps are never
+//trusted, so touching or checking out a file doesn't cause a recook.
+class AssetCooker
+{
+public:
+	AssetCooker(const AssetCookerSettings& Settings);
+	~AssetCooker();
+
+	//Not owned. Earlier cookers win when several accept a file.
+	void AddCooker(IAssetTypeCooker* Cooker);
+
+	//Returns false if anything failed to cook.
+	bool Run();
+
+	const std::vector<AssetCookRecord>& GetRecords() const { return mRecords; }
+	const AssetCookerStats& GetStats() const { return mStats; }
+
+	//Per asset cook times as CSV.
+	bool WriteReport(const char* Filename) const;
+
+private:
+	struct DatabaseEntry
+	{
+		std::string CookerName;
+		uint32_t CookerVersion = 0;
+		uint64_t SourceHash = 0;
+		std::vector<std::pair<std::string, uint64_t>> Dependencies;
+	};
+
+	struct PendingAsset
+	{
+		std::string RelativePath;
+		IAssetTypeCooker* Cooker;
+		DatabaseEntry NewEntry;
+		bool bHasEntry;
+	};
+
+	void CookAsset(PendingAsset& Asset, AssetCookRecord& Record);
+	bool IsUpToDate(const PendingAsset& Asset, uint64_t SourceHash, const std::string& OutputPath);
+	bool HashDependency(const std::string& DatabasePath, uint64_t& OutHash);
+
+	std::string ToDatabasePath(const std::string& Path) const;
+	std::string FromDatabasePath(const std::string& DatabasePath) const;
+
+	bool LoadDatabase();
+	bool SaveDatabase() const;
+	std::string GetDatabasePath() const;
+
+private:
+	AssetCookerSettings mSettings;
+	std::vector<IAssetTypeCooker*> mCookers;
+
+	//Read only while cooking
+	std::unordered_map<std::string, DatabaseEntry> mDatabase;
+
+	//Dependencies (shared includes etc) are hashed once per run
+	std::mutex mDependencyHashMutex;
+	std::unordered_map<std::string, std::pair<bool, uint64_t>> mDependencyHashes;
+
+	std::vector<PendingAsset> mAssets;
+	std::vector<AssetCookRecord> mRecords;
+	AssetCookerStats mStats;
+};
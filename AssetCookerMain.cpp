@@ -0,0 +1,76 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "AssetCooker.h"
+#include "AssetTypeCookers.h"
+
+//Offline asset cooker:
+//	AssetCooker <source dir> <output dir> [-j threads] [-force] [-report report.csv]
+//Per asset cook times go to the report (default <output dir>/CookReport.csv).
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		fprintf(stderr, "Usage: AssetCooker <source dir> <output dir> [-j threads] [-force] [-report report.csv]\n");
+		return 1;
+	}
+
+	AssetCookerSettings Settings;
+	Settings.SourceDirectory = argv[1];
+	Settings.OutputDirectory = argv[2];
+	std::string ReportFilename = Settings.OutputDirectory + "/CookReport.csv";
+
+	for (int i = 3; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+		{
+			Settings.ThreadCount = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-force") == 0)
+		{
+			Settings.bForce = true;
+		}
+		else if (strcmp(argv[i], "-report") == 0 && i + 1 < argc)
+		{
+			ReportFilename = argv[++i];
+		}
+		else
+		{
+			fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	MeshAssetCooker MeshCooker;
+	TextureAssetCooker TextureCooker;
+	ShaderAssetCooker ShaderCooker;
+
+	AssetCooker Cooker(Settings);
+	Cooker.AddCooker(&MeshCooker);
+	Cooker.AddCooker(&TextureCooker);
+	Cooker.AddCooker(&ShaderCooker);
+
+	bool bSucceeded = Cooker.Run();
+
+	for (const AssetCookRecord& Record : Cooker.GetRecords())
+	{
+		if (Record.Result == AssetCookResult::Failed)
+		{
+			fprintf(stderr, "FAILED %s: %s\n", Record.RelativePath.c_str(), Record.Error.c_str());
+		}
+	}
+
+	const AssetCookerStats& Stats = Cooker.GetStats();
+	printf("%u assets: %u cooked, %u cached, %u failed (%.1f%% cache hits) in %.1f ms\n",
+		Stats.AssetCount, Stats.CookedCount, Stats.CachedCount, Stats.FailedCount,
+		Stats.GetCacheHitRate() * 100.0, Stats.WallMilliseconds);
+
+	if (!Cooker.WriteReport(ReportFilename.c_str()))
+	{
+		fprintf(stderr, "Couldn't write %s\n", ReportFilename.c_str());
+		return 1;
+	}
+
+	return bSucceeded ? 0 : 1;
+}
@@ -0,0 +1,355 @@
+#include "AssetTypeCookers.h"
+#include "CookedTexture.h"
+#include "FileUtils.h"
+#include "ObjMeshConverter.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <d3dcompiler.h>
+
+#pragma comment(lib, "d3dcompiler.lib")
+#endif
+
+//Mesh
+
+bool MeshAssetCooker::Accepts(const std::string& RelativePath) const
+{
+	return GetExtension(RelativePath) == ".obj";
+}
+
+std::string MeshAssetCooker::GetOutputPath(const std::string& RelativePath) const
+{
+	return ReplaceExtension(RelativePath, ".mesh");
+}
+
+bool MeshAssetCooker::Cook(AssetCookJob& Job)
+{
+	ObjMeshConverter Converter;
+	std::string Text(Job.SourceData->begin(), Job.SourceData->end());
+	if (!Converter.AddLodFromMemory(Job.SourcePath.c_str(), Text, 1.0f))
+	{
+		Job.Error = Converter.GetLastError();
+		return false;
+	}
+
+	if (!Converter.Write(Job.OutputPath.c_str(), false))
+	{
+		Job.Error = "Couldn't write output";
+		return false;
+	}
+	return true;
+}
+
+//Texture
+
+namespace
+{
+	const uint32_t DxgiFormatR8G8B8A8Unorm = 28;
+
+	bool DecodeTga(const std::vector<uint8_t>& Data, uint32_t& OutWidth, uint32_t& OutHeight,
+		std::vector<uint8_t>& OutRgba, std::string& OutError)
+	{
+		if (Data.size() < 18)
+		{
+			OutError = "Truncated TGA header";
+			return false;
+		}
+
+		uint8_t IdLength = Data[0];
+		uint8_t ColourMapType = Data[1];
+		uint8_t ImageType = Data[2];
+		uint32_t Width = Data[12] | (Data[13] << 8);
+		uint32_t Height = Data[14] | (Data[15] << 8);
+		uint32_t BitsPerPixel = Data[16];
+		bool bTopDown = (Data[17] & 0x20) != 0;
+
+		if (ColourMapType != 0 || (ImageType != 2 && ImageType != 10) || (BitsPerPixel != 24 && BitsPerPixel != 32) ||
+			Width == 0 || Height == 0)
+		{
+			OutError = "Unsupported TGA - needs 24/32 bit true colour";
+			return false;
+		}
+
+		uint32_t BytesPerPixel = BitsPerPixel / 8;
+		size_t PixelCount = static_cast<size_t>(Width) * Height;
+		OutRgba.resize(PixelCount * 4);
+
+		const uint8_t* Cursor = Data.data() + 18 + IdLength;
+		const uint8_t* End = Data.data() + Data.size();
+
+		size_t Pixel = 0;
+		while (Pixel < PixelCount)
+		{
+			//RLE packets - a header then either one pixel repeated or raw pixels
+			size_t Count = 1;
+			bool bRun = false;
+			if (ImageType == 10)
+			{
+				if (Cursor >= End)
+				{
+					break;
+				}
+				uint8_t PacketHeader = *Cursor++;
+				Count = (PacketHeader & 0x7F) + 1;
+				bRun = (PacketHeader & 0x80) != 0;
+			}
+			Count = std::min(Count, PixelCount - Pixel);
+
+			for (size_t i = 0; i < Count; ++i, ++Pixel)
+			{
+				const uint8_t* Source = bRun ? Cursor : Cursor + i * BytesPerPixel;
+				if (Source + BytesPerPixel > End)
+				{
+					OutError = "Truncated TGA data";
+					return false;
+				}
+
+				//BGR(A), bottom up unless flagged otherwise
+				size_t Row = Pixel / Width;
+				size_t Column = Pixel % Width;
+				size_t DestRow = bTopDown ? Row : Height - 1 - Row;
+				uint8_t* Dest = &OutRgba[(DestRow * Width + Column) * 4];
+				Dest[0] = Source[2];
+				Dest[1] = Source[1];
+				Dest[2] = Source[0];
+				Dest[3] = BytesPerPixel == 4 ? Source[3] : 0xFF;
+			}
+			Cursor += (bRun ? 1 : Count) * BytesPerPixel;
+		}
+
+		if (Pixel < PixelCount)
+		{
+			OutError = "Truncated TGA data";
+			return false;
+		}
+
+		OutWidth = Width;
+		OutHeight = Height;
+		return true;
+	}
+
+	void DownsampleBox(const uint8_t* Source, uint32_t SourceWidth, uint32_t SourceHeight, uint8_t* Dest)
+	{
+		uint32_t DestWidth = std::max(SourceWidth / 2, 1u);
+		uint32_t DestHeight = std::max(SourceHeight / 2, 1u);
+
+		for (uint32_t Y = 0; Y < DestHeight; ++Y)
+		{
+			uint32_t Y0 = std::min(Y * 2, SourceHeight - 1);
+			uint32_t Y1 = std::min(Y * 2 + 1, SourceHeight - 1);
+			for (uint32_t X = 0; X < DestWidth; ++X)
+			{
+				uint32_t X0 = std::min(X * 2, SourceWidth - 1);
+				uint32_t X1 = std::min(X * 2 + 1, SourceWidth - 1);
+				for (uint32_t Channel = 0; Channel < 4; ++Channel)
+				{
+					uint32_t Sum = Source[(Y0 * SourceWidth + X0) * 4 + Channel] + Source[(Y0 * SourceWidth + X1) * 4 + Channel] +
+						Source[(Y1 * SourceWidth + X0) * 4 + Channel] + Source[(Y1 * SourceWidth + X1) * 4 + Channel];
+					Dest[(Y * DestWidth + X) * 4 + Channel] = static_cast<uint8_t>((Sum + 2) / 4);
+				}
+			}
+		}
+	}
+}
+
+bool TextureAssetCooker::Accepts(const std::string& RelativePath) const
+{
+	return GetExtension(RelativePath) == ".tga";
+}
+
+std::string TextureAssetCooker::GetOutputPath(const std::string& RelativePath) const
+{
+	return ReplaceExtension(RelativePath, ".tex");
+}
+
+bool TextureAssetCooker::Cook(AssetCookJob& Job)
+{
+	uint32_t Width = 0;
+	uint32_t Height = 0;
+	std::vector<uint8_t> Mip0;
+	if (!DecodeTga(*Job.SourceData, Width, Height, Mip0, Job.Error))
+	{
+		return false;
+	}
+
+	CookedTextureHeader Header = {};
+	Header.Magic = CookedTextureMagic;
+	Header.Version = CookedTextureVersion;
+	Header.Width = Width;
+	Header.Height = Height;
+	Header.Format = DxgiFormatR8G8B8A8Unorm;
+	Header.BytesPerPixel = 4;
+
+	//Full chain down to 1x1
+	Header.MipCount = 1;
+	while (Header.MipCount < CookedTextureMaxMips && ((Width >> Header.MipCount) > 0 || (Height >> Header.MipCount) > 0))
+	{
+		++Header.MipCount;
+	}
+
+	uint64_t Offset = sizeof(CookedTextureHeader);
+	for (uint32_t Mip = 0; Mip < Header.MipCount; ++Mip)
+	{
+		Header.MipOffsets[Mip] = Offset;
+		Offset += static_cast<uint64_t>(std::max(Width >> Mip, 1u)) * std::max(Height >> Mip, 1u) * 4;
+	}
+
+	std::vector<uint8_t> Output(static_cast<size_t>(Offset));
+	memcpy(Output.data(), &Header, sizeof(Header));
+	memcpy(Output.data() + Header.MipOffsets[0], Mip0.data(), Mip0.size());
+
+	for (uint32_t Mip = 1; Mip < Header.MipCount; ++Mip)
+	{
+		DownsampleBox(Output.data() + Header.MipOffsets[Mip - 1], std::max(Width >> (Mip - 1), 1u),
+			std::max(Height >> (Mip - 1), 1u), Output.data() + Header.MipOffsets[Mip]);
+	}
+
+	if (!WriteWholeFile(Job.OutputPath, Output.data(), Output.size()))
+	{
+		Job.Error = "Couldn't write output";
+		return false;
+	}
+	return true;
+}
+
+//Shader
+
+namespace
+{
+	const char* GetShaderProfile(const std::string& RelativePath)
+	{
+		std::string Stage = GetExtension(ReplaceExtension(RelativePath, ""));
+		if (Stage == ".vs") return "vs_5_1";
+		if (Stage == ".ps") return "ps_5_1";
+		if (Stage == ".cs") return "cs_5_1";
+		if (Stage == ".gs") return "gs_5_1";
+		if (Stage == ".hs") return "hs_5_1";
+		if (Stage == ".ds") return "ds_5_1";
+		return nullptr;
+	}
+}
+
+bool ShaderAssetCooker::Accepts(const std::string& RelativePath) const
+{
+	return GetExtension(RelativePath) == ".hlsl" && GetShaderProfile(RelativePath) != nullptr;
+}
+
+std::string ShaderAssetCooker::GetOutputPath(const std::string& RelativePath) const
+{
+#if defined(_WIN32)
+	return ReplaceExtension(RelativePath, ".cso");
+#else
+	return RelativePath;
+#endif
+}
+
+bool ShaderAssetCooker::Cook(AssetCookJob& Job)
+{
+	std::string Source(Job.SourceData->begin(), Job.SourceData->end());
+	std::string Flattened;
+	std::vector<std::string> IncludeStack(1, Job.SourcePath);
+	if (!Flatten(Job.SourcePath, Source, Flattened, IncludeStack, Job))
+	{
+		return false;
+	}
+
+#if defined(_WIN32)
+	ID3DBlob* Code = nullptr;
+	ID3DBlob* Errors = nullptr;
+	HRESULT Result = D3DCompile(Flattened.data(), Flattened.size(), Job.SourcePath.c_str(), nullptr, nullptr,
+		"main", GetShaderProfile(Job.SourcePath), D3DCOMPILE_OPTIMIZATION_LEVEL3, 0, &Code, &Errors);
+
+	if (Errors)
+	{
+		Job.Error.assign(static_cast<const char*>(Errors->GetBufferPointer()), Errors->GetBufferSize());
+		Errors->Release();
+	}
+
+	bool bWritten = false;
+	if (SUCCEEDED(Result))
+	{
+		bWritten = WriteWholeFile(Job.OutputPath, Code->GetBufferPointer(), Code->GetBufferSize());
+		Code->Release();
+		if (!bWritten)
+		{
+			Job.Error = "Couldn't write output";
+		}
+	}
+	return bWritten;
+#else
+	if (!WriteWholeFile(Job.OutputPath, Flattened.data(), Flattened.size()))
+	{
+		Job.Error = "Couldn't write output";
+		return false;
+	}
+	return true;
+#endif
+}
+
+bool ShaderAssetCooker::Flatten(const std::string& Path, const std::string& Text, std::string& Out,
+	std::vector<std::string>& IncludeStack, AssetCookJob& Job) const
+{
+	unsigned LineNumber = 0;
+	size_t LineStart = 0;
+	while (LineStart < Text.size())
+	{
+		size_t LineEnd = Text.find('\n', LineStart);
+		if (LineEnd == std::string::npos)
+		{
+			LineEnd = Text.size();
+		}
+		std::string Line = Text.substr(LineStart, LineEnd - LineStart);
+		LineStart = LineEnd + 1;
+		++LineNumber;
+
+		size_t First = Line.find_first_not_of(" \t");
+		if (First == std::string::npos || Line.compare(First, 8, "#include") != 0)
+		{
+			Out += Line;
+			Out += '\n';
+			continue;
+		}
+
+		size_t NameStart = Line.find('"', First);
+		size_t NameEnd = NameStart == std::string::npos ? std::string::npos : Line.find('"', NameStart + 1);
+		if (NameEnd == std::string::npos)
+		{
+			Job.Error = Path + "(" + std::to_string(LineNumber) + "): only quoted includes are supported";
+			return false;
+		}
+
+		std::string IncludePath = JoinPath(GetDirectory(Path), Line.substr(NameStart + 1, NameEnd - NameStart - 1));
+		if (std::find(IncludeStack.begin(), IncludeStack.end(), IncludePath) != IncludeStack.end())
+		{
+			Job.Error = Path + "(" + std::to_string(LineNumber) + "): recursive include of " + IncludePath;
+			return false;
+		}
+
+		std::vector<uint8_t> IncludeData;
+		if (!ReadWholeFile(IncludePath, IncludeData))
+		{
+			Job.Error = Path + "(" + std::to_string(LineNumber) + "): can't open " + IncludePath;
+			return false;
+		}
+
+		if (std::find(Job.Dependencies.begin(), Job.Dependencies.end(), IncludePath) == Job.Dependencies.end())
+		{
+			Job.Dependencies.push_back(IncludePath);
+		}
+
+		//#line keeps compiler errors pointing at the original files
+		Out += "#line 1 \"" + IncludePath + "\"\n";
+		IncludeStack.push_back(IncludePath);
+		if (!Flatten(IncludePath, std::string(IncludeData.begin(), IncludeData.end()), Out, IncludeStack, Job))
+		{
+			return false;
+		}
+		IncludeStack.pop_back();
+		Out += "#line " + std::to_string(LineNumber + 1) + " \"" + Path + "\"\n";
+	}
+
+	return true;
+}
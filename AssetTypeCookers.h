@@ -0,0 +1,50 @@
+#pragma once
+
+#include "AssetCooker.h"
+
+//OBJ -> PackedMesh (.mesh), split streams.
+class MeshAssetCooker : public IAssetTypeCooker
+{
+public:
+	const char* GetName() const override { return "Mesh"; }
+	uint32_t GetVersion() const override { return 1; }
+
+	bool Accepts(const std::string& RelativePath) const override;
+	std::string GetOutputPath(const std::string& RelativePath) const override;
+
+	bool Cook(AssetCookJob& Job) override;
+};
+
+//Uncompressed or RLE 24/32 bit TGA -> CookedTexture (.tex), RGBA8 with a box
+//filtered mip chain.
+class TextureAssetCooker : public IAssetTypeCooker
+{
+public:
+	const char* GetName() const override { return "Texture"; }
+	uint32_t GetVersion() const override { return 1; }
+
+	bool Accepts(const std::string& RelativePath) const override;
+	std::string GetOutputPath(const std::string& RelativePath) const override;
+
+	bool Cook(AssetCookJob& Job) override;
+};
+
+//<Name>.<vs|ps|cs|gs|hs|ds>.hlsl with a "main" entry point. Includes are
+//resolved by the cooker and reported as dependencies. On Windows the result
+//is compiled to bytecode (.cso, shader model 5.1); elsewhere the flattened
+//source is written (.hlsl) for the runtime to compile.
+class ShaderAssetCooker : public IAssetTypeCooker
+{
+public:
+	const char* GetName() const override { return "Shader"; }
+	uint32_t GetVersion() const override { return 1; }
+
+	bool Accepts(const std::string& RelativePath) const override;
+	std::string GetOutputPath(const std::string& RelativePath) const override;
+
+	bool Cook(AssetCookJob& Job) override;
+
+private:
+	bool Flatten(const std::string& Path, const std::string& Text, std::string& Out,
+		std::vector<std::string>& IncludeStack, AssetCookJob& Job) const;
+};
@@ -0,0 +1,47 @@
+#include "AsyncAwaitables.h"
+
+AsyncTask<bool> LoadFileAsync(const AsyncLoadContext& Context, std::string Filename, std::vector<uint8_t>& OutData,
+	AsyncIOPriority Priority)
+{
+	//Context is copied so the caller's doesn't need to outlive the first suspension
+	AsyncLoadContext Load = Context;
+
+	struct OpenedFile
+	{
+		AsyncFileHandle Handle;
+		uint64_t Size;
+	};
+
+	OpenedFile File = co_await RunJobAsync(*Load.Jobs, *Load.Scheduler, [&Filename]()
+	{
+		OpenedFile Opened;
+		Opened.Handle = AsyncIOQueue::OpenFile(Filename.c_str());
+		Opened.Size = Opened.Handle != InvalidAsyncFileHandle ? AsyncIOQueue::GetFileSize(Opened.Handle) : 0;
+		return Opened;
+	});
+
+	if (File.Handle == InvalidAsyncFileHandle)
+	{
+		co_return false;
+	}
+
+	//Reads are 32 bit, anything bigger shouldn't be loaded in one go
+	if (File.Size > 0xFFFFFFFFull)
+	{
+		AsyncIOQueue::CloseFile(File.Handle);
+		co_return false;
+	}
+
+	OutData.resize(static_cast<size_t>(File.Size));
+
+	bool bSucceeded = true;
+	if (File.Size > 0)
+	{
+		AsyncReadResult Result = co_await ReadFileAsync(*Load.IOQueue, *Load.Scheduler, File.Handle, 0,
+			static_cast<uint32_t>(File.Size), OutData.data(), Priority);
+		bSucceeded = Result.bSucceeded;
+	}
+
+	AsyncIOQueue::CloseFile(File.Handle);
+	co_return bSucceeded;
+}
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "AsyncIOQueue.h"
+#include "AsyncTask.h"
+#include "CoroutineScheduler.h"
+#include "IFence.h"
+#include "JobSystem.h"
+
+//Awaitables for AsyncTask coroutines. Each one resumes the coroutine through
+//a CoroutineScheduler, so code after a co_await always runs on the scheduler
+//(main) thread whichever thread did the work.
+
+//Resume on the next Pump() - spreads long loops over several frames.
+class YieldFrameAwaitable
+{
+public:
+	explicit YieldFrameAwaitable(CoroutineScheduler& Scheduler) : mScheduler(Scheduler) {}
+
+	bool await_ready() const { return false; }
+	void await_suspend(CoroutineStd::coroutine_handle<> Handle) { mScheduler.Post(Handle); }
+	void await_resume() const {}
+
+private:
+	CoroutineScheduler& mScheduler;
+};
+
+inline YieldFrameAwaitable YieldFrame(CoroutineScheduler& Scheduler)
+{
+	return YieldFrameAwaitable(Scheduler);
+}
+
+//Resume once Fence reaches Value. Doesn't suspend if it already has.
+class FenceAwaitable
+{
+public:
+	FenceAwaitable(CoroutineScheduler& Scheduler, const IFence& Fence, uint64_t Value)
+		: mScheduler(Scheduler), mFence(Fence), mValue(Value) {}
+
+	bool await_ready() const { return mFence.IsComplete(mValue); }
+	void await_suspend(CoroutineStd::coroutine_handle<> Handle) { mScheduler.WaitForFence(mFence, mValue, Handle); }
+	void await_resume() const {}
+
+private:
+	CoroutineScheduler& mScheduler;
+	const IFence& mFence;
+	uint64_t mValue;
+};
+
+inline FenceAwaitable WaitForFenceAsync(CoroutineScheduler& Scheduler, const IFence& Fence, uint64_t Value)
+{
+	return FenceAwaitable(Scheduler, Fence, Value);
+}
+
+//Read through an AsyncIOQueue, resuming with the AsyncReadResult.
+class FileReadAwaitable
+{
+public:
+	FileReadAwaitable(AsyncIOQueue& Queue, CoroutineScheduler& Scheduler, const AsyncReadRequest& Request)
+		: mQueue(Queue), mScheduler(Scheduler), mRequest(Request), mResult() {}
+
+	bool await_ready() const { return false; }
+
+	void await_suspend(CoroutineStd::coroutine_handle<> Handle)
+	{
+		mHandle = Handle;
+		mRequest.Callback = &FileReadAwaitable::OnReadComplete;
+		mRequest.Context = this;
+		mQueue.Read(mRequest);
+	}
+
+	AsyncReadResult await_resume() const { return mResult; }
+
+private:
+	static void OnReadComplete(void* Context, const AsyncReadResult& Result)
+	{
+		//I/O completion thread - the awaitable lives in the suspended frame
+		FileReadAwaitable* Self = static_cast<FileReadAwaitable*>(Context);
+		Self->mResult = Result;
+		Self->mScheduler.Post(Self->mHandle);
+	}
+
+private:
+	AsyncIOQueue& mQueue;
+	CoroutineScheduler& mScheduler;
+	AsyncReadRequest mRequest;
+	AsyncReadResult mResult;
+	CoroutineStd::coroutine_handle<> mHandle;
+};
+
+inline FileReadAwaitable ReadFileAsync(AsyncIOQueue& Queue, CoroutineScheduler& Scheduler, AsyncFileHandle File,
+	uint64_t Offset, uint32_t Size, void* Dest, AsyncIOPriority Priority = AsyncIOPriority::Normal)
+{
+	AsyncReadRequest Request;
+	Request.File = File;
+	Request.Offset = Offset;
+	Request.Size = Size;
+	Request.Dest = Dest;
+	Request.Priority = Priority;
+	return FileReadAwaitable(Queue, Scheduler, Request);
+}
+
+//Run Function on a JobSystem worker, resuming with its return value.
+template<typename Function, typename Result = decltype(std::declval<Function&>()())>
+class JobAwaitable
+{
+public:
+	JobAwaitable(JobSystem& Jobs, CoroutineScheduler& Scheduler, Function&& ToRun)
+		: mJobs(Jobs), mScheduler(Scheduler), mFunction(std::move(ToRun)) {}
+
+	bool await_ready() const { return false; }
+
+	void await_suspend(CoroutineStd::coroutine_handle<> Handle)
+	{
+		mJobs.Submit([this, Handle]()
+		{
+			mResult.emplace(mFunction());
+			mScheduler.Post(Handle);
+		});
+	}
+
+	Result await_resume() { return std::move(*mResult); }
+
+private:
+	JobSystem& mJobs;
+	CoroutineScheduler& mScheduler;
+	Function mFunction;
+	std::optional<Result> mResult;
+};
+
+template<typename Function>
+class JobAwaitable<Function, void>
+{
+public:
+	JobAwaitable(JobSystem& Jobs, CoroutineScheduler& Scheduler, Function&& ToRun)
+		: mJobs(Jobs), mScheduler(Scheduler), mFunction(std::move(ToRun)) {}
+
+	bool await_ready() const { return false; }
+
+	void await_suspend(CoroutineStd::coroutine_handle<> Handle)
+	{
+		mJobs.Submit([this, Handle]()
+		{
+			mFunction();
+			mScheduler.Post(Handle);
+		});
+	}
+
+	void await_resume() const {}
+
+private:
+	JobSystem& mJobs;
+	CoroutineScheduler& mScheduler;
+	Function mFunction;
+};
+
+template<typename Function>
+JobAwaitable<typename std::decay<Function>::type> RunJobAsync(JobSystem& Jobs, CoroutineScheduler& Scheduler, Function&& ToRun)
+{
+	return JobAwaitable<typename std::decay<Function>::type>(Jobs, Scheduler, typename std::decay<Function>::type(std::forward<Function>(ToRun)));
+}
+
+//What a loader coroutine needs to get at.
+struct AsyncLoadContext
+{
+	CoroutineScheduler* Scheduler = nullptr;
+	AsyncIOQueue* IOQueue = nullptr;
+	JobSystem* Jobs = nullptr;
+};
+
+//Reads a whole file without blocking the scheduler thread - the open and
+//size query run as a job, the read goes through the I/O queue.
+AsyncTask<bool> LoadFileAsync(const AsyncLoadContext& Context, std::string Filename, std::vector<uint8_t>& OutData,
+	AsyncIOPriority Priority = AsyncIOPriority::Normal);
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+
+//One positional read handed to a backend. File is the native handle (fd or
+//HANDLE), Tag comes back with the completion.
+struct AsyncIOBackendRead
+{
+	intptr_t File;
+	uint64_t Offset;
+	uint32_t Size;
+	void* Dest;
+	uint64_t Tag;
+};
+
+struct AsyncIOBackendCompletion
+{
+	uint64_t Tag;
+	int64_t Result;		//Bytes read, negative on error
+};
+
+//Tag of the completion Wake() produces.
+const uint64_t AsyncIOWakeTag = ~0ull;
+
+//Executes reads for the AsyncIOQueue. Submit() and Wake() are only called
+//from the queue's submission thread and WaitForCompletions() only from its
+//completion thread, so a backend needs no locking of its own beyond what
+//passes work between those two.
+class IAsyncIOBackend
+{
+public:
+	IAsyncIOBackend() {};
+	virtual ~IAsyncIOBackend() {};
+
+	virtual const char* GetName() const = 0;
+
+	//Count never exceeds the queue's MaxInFlight less what is already in flight.
+	virtual bool Submit(const AsyncIOBackendRead* Reads, uint32_t Count) = 0;
+
+	//Blocks until at least one read completes. Returns how many were written,
+	//or 0 if the backend has failed for good - nothing in flight will complete
+	//and it mustn't be waited on again.
+	virtual uint32_t WaitForCompletions(AsyncIOBackendCompletion* OutCompletions, uint32_t MaxCount) = 0;
+
+	//Makes WaitForCompletions return an AsyncIOWakeTag completion.
+	virtual void Wake() = 0;
+};
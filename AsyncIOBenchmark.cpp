@@ -0,0 +1,246 @@
+#include "AsyncIOBenchmark.h"
+#include "AsyncIOQueue.h"
+#include "Common.h"
+#include "FileUtils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <stdio.h>
+
+namespace
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	//Every 8 byte word of the test file holds its own offset, so reads can be
+	//checked without keeping a copy
+	const uint64_t WordSize = sizeof(uint64_t);
+
+	struct ReadTracker
+	{
+		std::vector<double> Latencies;
+		uint32_t FailedCount = 0;
+	};
+
+	void OnReadComplete(void* Context, const AsyncReadResult& Result)
+	{
+		//Requests complete on the single completion thread, so no locking
+		ReadTracker* Tracker = static_cast<ReadTracker*>(Context);
+		Tracker->Latencies[static_cast<size_t>(Result.UserData)] = Result.LatencyMilliseconds;
+		if (!Result.bSucceeded)
+		{
+			++Tracker->FailedCount;
+		}
+	}
+
+	double Percentile(const std::vector<double>& Sorted, double Fraction)
+	{
+		size_t Index = static_cast<size_t>(Fraction * (Sorted.size() - 1) + 0.5);
+		return Sorted[std::min(Index, Sorted.size() - 1)];
+	}
+}
+
+AsyncIOBenchmark::AsyncIOBenchmark(const AsyncIOBenchmarkSettings& Settings)
+	: mSettings(Settings)
+{
+	Assert(mSettings.SmallReadSize % WordSize == 0 && mSettings.LargeReadSize % WordSize == 0);
+}
+
+AsyncIOBenchmark::~AsyncIOBenchmark()
+{}
+
+bool AsyncIOBenchmark::Run()
+{
+	mResults.clear();
+
+	if (!CreateTestFile())
+	{
+		return false;
+	}
+
+	uint64_t FileSize = static_cast<uint64_t>(mSettings.FileSizeMB) * 1024 * 1024;
+	if (FileSize < mSettings.LargeReadSize || FileSize < static_cast<uint64_t>(mSettings.SmallReadCount) * mSettings.SmallReadSize)
+	{
+		mLastError = "Test file too small for the configured reads";
+		return false;
+	}
+
+	std::mt19937_64 Random(1234);
+
+	Scenario SmallRandom = { "SmallRandom", mSettings.SmallReadSize, {} };
+	uint64_t SmallSlots = FileSize / mSettings.SmallReadSize;
+	for (uint32_t i = 0; i < mSettings.SmallReadCount; ++i)
+	{
+		SmallRandom.Offsets.push_back((Random() % SmallSlots) * mSettings.SmallReadSize);
+	}
+
+	//Consecutive blocks - the queue merges these up to MaxCoalescedBytes
+	Scenario SmallAdjacent = { "SmallAdjacent", mSettings.SmallReadSize, {} };
+	for (uint32_t i = 0; i < mSettings.SmallReadCount; ++i)
+	{
+		SmallAdjacent.Offsets.push_back(static_cast<uint64_t>(i) * mSettings.SmallReadSize);
+	}
+
+	Scenario Large = { "Large", mSettings.LargeReadSize, {} };
+	uint64_t LargeSlots = FileSize / mSettings.LargeReadSize;
+	for (uint32_t i = 0; i < mSettings.LargeReadCount; ++i)
+	{
+		Large.Offsets.push_back((Random() % LargeSlots) * mSettings.LargeReadSize);
+	}
+
+	const Scenario* Scenarios[] = { &SmallRandom, &SmallAdjacent, &Large };
+
+	//Thread pool always, io_uring too where the queue managed to create it
+	bool bHaveIoUring = false;
+	{
+		AsyncIOQueueSettings ProbeSettings;
+		ProbeSettings.MaxInFlight = 1;
+		AsyncIOQueue Probe(ProbeSettings);
+		bHaveIoUring = strcmp(Probe.GetBackendName(), "ThreadPool") != 0;
+	}
+
+	for (const Scenario* ToRun : Scenarios)
+	{
+		if (!RunScenario(false, *ToRun) || (bHaveIoUring && !RunScenario(true, *ToRun)))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool AsyncIOBenchmark::CreateTestFile()
+{
+	mTestFilename = JoinPath(mSettings.WorkingDirectory, "AsyncIOBenchmark.bin");
+
+	FILE* File = fopen(mTestFilename.c_str(), "wb");
+	if (!File)
+	{
+		mLastError = "Couldn't create " + mTestFilename;
+		return false;
+	}
+
+	const uint64_t ChunkWords = 1024 * 1024 / WordSize;
+	std::vector<uint64_t> Chunk(ChunkWords);
+	uint64_t Offset = 0;
+	for (uint32_t ChunkIdx = 0; ChunkIdx < mSettings.FileSizeMB; ++ChunkIdx)
+	{
+		for (uint64_t& Word : Chunk)
+		{
+			Word = Offset;
+			Offset += WordSize;
+		}
+
+		if (fwrite(Chunk.data(), WordSize, ChunkWords, File) != ChunkWords)
+		{
+			fclose(File);
+			mLastError = "Couldn't write " + mTestFilename;
+			return false;
+		}
+	}
+
+	fclose(File);
+	return true;
+}
+
+bool AsyncIOBenchmark::RunScenario(bool bAllowIoUring, const Scenario& ToRun)
+{
+	AsyncIOQueueSettings QueueSettings;
+	QueueSettings.MaxInFlight = mSettings.MaxInFlight;
+	QueueSettings.bAllowIoUring = bAllowIoUring;
+
+	AsyncFileHandle File = AsyncIOQueue::OpenFile(mTestFilename.c_str());
+	if (File == InvalidAsyncFileHandle)
+	{
+		mLastError = "Couldn't open " + mTestFilename;
+		return false;
+	}
+
+	uint32_t RequestCount = static_cast<uint32_t>(ToRun.Offsets.size());
+	std::vector<uint8_t> Buffer(static_cast<size_t>(RequestCount) * ToRun.ReadSize);
+
+	ReadTracker Tracker;
+	Tracker.Latencies.resize(RequestCount);
+
+	AsyncIOStats Stats;
+	std::string BackendName;
+	double Milliseconds;
+	{
+		AsyncIOQueue Queue(QueueSettings);
+		BackendName = Queue.GetBackendName();
+
+		Clock::time_point Start = Clock::now();
+		for (uint32_t i = 0; i < RequestCount; ++i)
+		{
+			AsyncReadRequest Request;
+			Request.File = File;
+			Request.Offset = ToRun.Offsets[i];
+			Request.Size = ToRun.ReadSize;
+			Request.Dest = Buffer.data() + static_cast<size_t>(i) * ToRun.ReadSize;
+			Request.Callback = &OnReadComplete;
+			Request.Context = &Tracker;
+			Request.UserData = i;
+			Queue.Read(Request);
+		}
+		Queue.WaitIdle();
+		Milliseconds = std::chrono::duration<double, std::milli>(Clock::now() - Start).count();
+
+		Stats = Queue.GetStats();
+	}
+
+	AsyncIOQueue::CloseFile(File);
+
+	//Check the first and last word of every read landed in the right place
+	for (uint32_t i = 0; i < RequestCount; ++i)
+	{
+		const uint8_t* Data = Buffer.data() + static_cast<size_t>(i) * ToRun.ReadSize;
+		uint64_t First, Last;
+		memcpy(&First, Data, WordSize);
+		memcpy(&Last, Data + ToRun.ReadSize - WordSize, WordSize);
+		if (Tracker.FailedCount > 0 || First != ToRun.Offsets[i] || Last != ToRun.Offsets[i] + ToRun.ReadSize - WordSize)
+		{
+			mLastError = BackendName + " returned wrong data for " + ToRun.Name;
+			return false;
+		}
+	}
+
+	std::sort(Tracker.Latencies.begin(), Tracker.Latencies.end());
+
+	AsyncIOBenchmarkResult Result;
+	Result.Backend = BackendName;
+	Result.Scenario = ToRun.Name;
+	Result.RequestCount = RequestCount;
+	Result.BackendReads = Stats.BackendReads;
+	Result.Milliseconds = Milliseconds;
+	Result.RequestsPerSecond = RequestCount / (Milliseconds / 1000.0);
+	Result.MegabytesPerSecond = (Stats.BytesRead / (1024.0 * 1024.0)) / (Milliseconds / 1000.0);
+	Result.LatencyP50 = Percentile(Tracker.Latencies, 0.5);
+	Result.LatencyP90 = Percentile(Tracker.Latencies, 0.9);
+	Result.LatencyP99 = Percentile(Tracker.Latencies, 0.99);
+	mResults.push_back(Result);
+
+	return true;
+}
+
+bool AsyncIOBenchmark::WriteReport(const char* Filename) const
+{
+	FILE* File = fopen(Filename, "w");
+	if (!File)
+	{
+		return false;
+	}
+
+	fprintf(File, "Test file:      %s (%u MB)\n", mTestFilename.c_str(), mSettings.FileSizeMB);
+	fprintf(File, "Max in flight:  %u\n\n", mSettings.MaxInFlight);
+	fprintf(File, "Backend,Scenario,Requests,BackendReads,Ms,RequestsPerSecond,MBPerSecond,P50Ms,P90Ms,P99Ms\n");
+	for (const AsyncIOBenchmarkResult& Result : mResults)
+	{
+		fprintf(File, "%s,%s,%u,%llu,%.3f,%.0f,%.1f,%.3f,%.3f,%.3f\n", Result.Backend.c_str(), Result.Scenario.c_str(),
+			Result.RequestCount, (unsigned long long)Result.BackendReads, Result.Milliseconds, Result.RequestsPerSecond,
+			Result.MegabytesPerSecond, Result.LatencyP50, Result.LatencyP90, Result.LatencyP99);
+	}
+
+	fclose(File);
+	return true;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//Throughput and latency of the AsyncIOQueue on each available backend, for
+//many small random reads, many small adjacent reads (which coalesce) and a
+//few large reads, all from one generated test file.
+//
+//The file was just written so these are page cache numbers unless it is
+//larger than memory - they measure queue and submission overhead rather than
+//the device.
+struct AsyncIOBenchmarkSettings
+{
+	std::string WorkingDirectory = ".";
+	uint32_t FileSizeMB = 256;
+	uint32_t SmallReadCount = 16384;
+	uint32_t SmallReadSize = 4096;
+	uint32_t LargeReadCount = 64;
+	uint32_t LargeReadSize = 1024 * 1024;
+	uint32_t MaxInFlight = 64;
+};
+
+struct AsyncIOBenchmarkResult
+{
+	std::string Backend;
+	std::string Scenario;
+	uint32_t RequestCount = 0;
+	uint64_t BackendReads = 0;
+	double Milliseconds = 0.0;
+	double RequestsPerSecond = 0.0;
+	double MegabytesPerSecond = 0.0;
+	double LatencyP50 = 0.0;		//Milliseconds
+	double LatencyP90 = 0.0;
+	double LatencyP99 = 0.0;
+};
+
+class AsyncIOBenchmark
+{
+public:
+	AsyncIOBenchmark(const AsyncIOBenchmarkSettings& Settings);
+	~AsyncIOBenchmark();
+
+	bool Run();
+	bool WriteReport(const char* Filename) const;
+
+	const std::string& GetLastError() const { return mLastError; }
+
+private:
+	struct Scenario
+	{
+		const char* Name;
+		uint32_t ReadSize;
+		std::vector<uint64_t> Offsets;
+	};
+
+	bool CreateTestFile();
+	bool RunScenario(bool bAllowIoUring, const Scenario& ToRun);
+
+private:
+	AsyncIOBenchmarkSettings mSettings;
+	std::string mTestFilename;
+	std::vector<AsyncIOBenchmarkResult> mResults;
+	std::string mLastError;
+};
@@ -0,0 +1,47 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "AsyncIOBenchmark.h"
+
+//Async I/O benchmark:
+//	AsyncIOBenchmark [working dir] [-filesize MB] [-inflight N]
+//Writes AsyncIOBenchmark.txt to the current directory.
+int main(int argc, char** argv)
+{
+	AsyncIOBenchmarkSettings Settings;
+	bool bValid = true;
+	for (int i = 1; i < argc && bValid; ++i)
+	{
+		if (strcmp(argv[i], "-filesize") == 0 && i + 1 < argc)
+		{
+			Settings.FileSizeMB = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-inflight") == 0 && i + 1 < argc)
+		{
+			Settings.MaxInFlight = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (argv[i][0] != '-')
+		{
+			Settings.WorkingDirectory = argv[i];
+		}
+		else
+		{
+			bValid = false;
+		}
+	}
+
+	if (!bValid || Settings.FileSizeMB == 0 || Settings.MaxInFlight == 0)
+	{
+		fprintf(stderr, "Usage: AsyncIOBenchmark [working dir] [-filesize MB] [-inflight N]\n");
+		return 1;
+	}
+
+	AsyncIOBenchmark Benchmark(Settings);
+	if (!Benchmark.Run())
+	{
+		fprintf(stderr, "%s\n", Benchmark.GetLastError().c_str());
+		return 1;
+	}
+	return Benchmark.WriteReport("AsyncIOBenchmark.txt") ? 0 : 1;
+}
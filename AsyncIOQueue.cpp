@@ -0,0 +1,408 @@
+#include "AsyncIOQueue.h"
+#include "Common.h"
+#include "ThreadPoolIOBackend.h"
+
+#if defined(__linux__)
+#include "IoUringIOBackend.h"
+#endif
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+
+AsyncIOQueue::AsyncIOQueue(const AsyncIOQueueSettings& Settings)
+	: mSettings(Settings), mNextId(1), mOutstanding(0), mQueuedCount(0), mShutdown(false),
+	mBackendFailed(false)
+{
+	mSettings.MaxInFlight = std::max(mSettings.MaxInFlight, 1u);
+	mSettings.MaxBatch = std::max(mSettings.MaxBatch, 1u);
+
+#if defined(__linux__)
+	if (mSettings.bAllowIoUring)
+	{
+		mBackend.reset(IoUringIOBackend::Create(mSettings.MaxInFlight));
+	}
+#endif
+	if (!mBackend)
+	{
+		mBackend.reset(new ThreadPoolIOBackend(mSettings.ThreadPoolThreads));
+	}
+
+	mSlots.resize(mSettings.MaxInFlight);
+	for (uint32_t SlotIdx = mSettings.MaxInFlight; SlotIdx > 0; --SlotIdx)
+	{
+		mFreeSlots.push_back(SlotIdx - 1);
+	}
+
+	mSubmitThread = std::thread(&AsyncIOQueue::SubmitThreadMain, this);
+	mCompletionThread = std::thread(&AsyncIOQueue::CompletionThreadMain, this);
+}
+
+AsyncIOQueue::~AsyncIOQueue()
+{
+	WaitIdle();
+
+	{
+		std::lock_guard<std::mutex> Lock(mMutex);
+		mShutdown = true;
+	}
+	mWorkAvailable.notify_all();
+	mSubmitThread.join();
+
+	//Submission thread has gone so this thread may talk to the backend
+	mBackend->Wake();
+	mCompletionThread.join();
+}
+
+AsyncFileHandle AsyncIOQueue::OpenFile(const char* Filename)
+{
+#if defined(_WIN32)
+	HANDLE File = CreateFileA(Filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	return reinterpret_cast<AsyncFileHandle>(File);		//INVALID_HANDLE_VALUE is -1
+#else
+	return open(Filename, O_RDONLY | O_CLOEXEC);
+#endif
+}
+
+void AsyncIOQueue::CloseFile(AsyncFileHandle File)
+{
+	if (File == InvalidAsyncFileHandle)
+	{
+		return;
+	}
+#if defined(_WIN32)
+	CloseHandle(reinterpret_cast<HANDLE>(File));
+#else
+	close(static_cast<int>(File));
+#endif
+}
+
+uint64_t AsyncIOQueue::GetFileSize(AsyncFileHandle File)
+{
+#if defined(_WIN32)
+	LARGE_INTEGER Size;
+	return GetFileSizeEx(reinterpret_cast<HANDLE>(File), &Size) ? static_cast<uint64_t>(Size.QuadPart) : 0;
+#else
+	struct stat Stat;
+	return fstat(static_cast<int>(File), &Stat) == 0 ? static_cast<uint64_t>(Stat.st_size) : 0;
+#endif
+}
+
+uint64_t AsyncIOQueue::Read(const AsyncReadRequest& Request)
+{
+	Assert(Request.File != InvalidAsyncFileHandle);
+	Assert(Request.Dest || Request.Size == 0);
+	Assert(Request.Priority < AsyncIOPriority::Count);
+
+	uint64_t Id;
+	{
+		std::lock_guard<std::mutex> Lock(mMutex);
+		Id = mNextId++;
+
+		PendingRead Pending;
+		Pending.Request = Request;
+		Pending.Id = Id;
+		Pending.QueueTime = Clock::now();
+		mQueues[static_cast<uint32_t>(Request.Priority)].push_back(Pending);
+
+		++mQueuedCount;
+		++mOutstanding;
+	}
+	mWorkAvailable.notify_one();
+	return Id;
+}
+
+void AsyncIOQueue::WaitIdle()
+{
+	std::unique_lock<std::mutex> Lock(mMutex);
+	mIdle.wait(Lock, [this]() { return mOutstanding == 0; });
+}
+
+AsyncIOStats AsyncIOQueue::GetStats() const
+{
+	std::lock_guard<std::mutex> Lock(mMutex);
+	return mStats;
+}
+
+bool AsyncIOQueue::HasBackendFailed() const
+{
+	std::lock_guard<std::mutex> Lock(mMutex);
+	return mBackendFailed;
+}
+
+void AsyncIOQueue::SubmitThreadMain()
+{
+	std::vector<PendingRead> Batch;
+	std::vector<AsyncIOBackendRead> BackendReads;
+	std::vector<uint32_t> Slots;
+
+	for (;;)
+	{
+		Batch.clear();
+		Slots.clear();
+		{
+			std::unique_lock<std::mutex> Lock(mMutex);
+			mWorkAvailable.wait(Lock, [this]() { return mShutdown || (mQueuedCount > 0 && !mFreeSlots.empty()); });
+
+			if (mQueuedCount == 0)
+			{
+				return;
+			}
+
+			//Never take more requests than there are free slots, so however
+			//the batch coalesces every read has somewhere to go
+			size_t MaxRequests = std::min<size_t>(mSettings.MaxBatch, mFreeSlots.size());
+			for (std::deque<PendingRead>& Queue : mQueues)
+			{
+				while (!Queue.empty() && Batch.size() < MaxRequests)
+				{
+					Batch.push_back(Queue.front());
+					Queue.pop_front();
+				}
+			}
+			mQueuedCount -= Batch.size();
+		}
+
+		//Adjacent requests end up next to each other. Stable so equal offsets
+		//keep their priority order.
+		std::stable_sort(Batch.begin(), Batch.end(), [](const PendingRead& A, const PendingRead& B)
+		{
+			if (A.Request.File != B.Request.File)
+			{
+				return A.Request.File < B.Request.File;
+			}
+			return A.Request.Offset < B.Request.Offset;
+		});
+
+		//Group in to backend reads. Slots can only be taken by this thread so
+		//taking them one at a time under the lock is safe.
+		BackendReads.clear();
+		uint64_t BatchCoalesced = 0;
+		for (size_t First = 0; First < Batch.size();)
+		{
+			const AsyncReadRequest& Start = Batch[First].Request;
+			uint64_t End = Start.Offset + Start.Size;
+
+			size_t Last = First + 1;
+			while (Last < Batch.size())
+			{
+				const AsyncReadRequest& Next = Batch[Last].Request;
+				if (Next.File != Start.File || Next.Offset != End || End + Next.Size - Start.Offset > mSettings.MaxCoalescedBytes)
+				{
+					break;
+				}
+				End += Next.Size;
+				++Last;
+			}
+
+			uint32_t SlotIdx;
+			{
+				std::lock_guard<std::mutex> Lock(mMutex);
+				SlotIdx = mFreeSlots.back();
+				mFreeSlots.pop_back();
+			}
+
+			ReadSlot& Slot = mSlots[SlotIdx];
+			Slot.Reads.assign(Batch.begin() + First, Batch.begin() + Last);
+			Slot.Offset = Start.Offset;
+			Slot.Size = static_cast<uint32_t>(End - Start.Offset);
+
+			AsyncIOBackendRead Read;
+			Read.File = Start.File;
+			Read.Offset = Slot.Offset;
+			Read.Size = Slot.Size;
+			Read.Tag = SlotIdx;
+			if (Last - First == 1)
+			{
+				Read.Dest = Start.Dest;
+			}
+			else
+			{
+				Slot.Staging.resize(Slot.Size);
+				Read.Dest = Slot.Staging.data();
+				BatchCoalesced += Last - First;
+			}
+
+			BackendReads.push_back(Read);
+			Slots.push_back(SlotIdx);
+			First = Last;
+		}
+
+		//Marked submitted before the backend sees them, so if it fails in the
+		//meantime the completion thread fails them
+		bool bBackendFailed;
+		{
+			std::lock_guard<std::mutex> Lock(mMutex);
+			bBackendFailed = mBackendFailed;
+			for (uint32_t SlotIdx : Slots)
+			{
+				mSlots[SlotIdx].bSubmitted = true;
+			}
+			if (!bBackendFailed)
+			{
+				mStats.BackendReads += BackendReads.size();
+				mStats.CoalescedRequests += BatchCoalesced;
+			}
+		}
+
+		if (bBackendFailed || !mBackend->Submit(BackendReads.data(), static_cast<uint32_t>(BackendReads.size())))
+		{
+			//Backend has failed or rejected the lot - fail them here rather than lose them
+			FailSubmittedSlots(Slots);
+		}
+	}
+}
+
+void AsyncIOQueue::FailSubmittedSlots(const std::vector<uint32_t>& Slots)
+{
+	//Only those nobody else has completed (or failed) yet
+	std::vector<uint32_t> Failed;
+	{
+		std::lock_guard<std::mutex> Lock(mMutex);
+		for (uint32_t SlotIdx : Slots)
+		{
+			if (mSlots[SlotIdx].bSubmitted)
+			{
+				mSlots[SlotIdx].bSubmitted = false;
+				Failed.push_back(SlotIdx);
+			}
+		}
+	}
+
+	for (uint32_t SlotIdx : Failed)
+	{
+		CompleteSlot(mSlots[SlotIdx], -1);
+	}
+}
+
+void AsyncIOQueue::CompletionThreadMain()
+{
+	std::vector<AsyncIOBackendCompletion> Completions(mSettings.MaxInFlight + 1);
+	std::vector<uint32_t> AllSlots(mSlots.size());
+	for (uint32_t SlotIdx = 0; SlotIdx < AllSlots.size(); ++SlotIdx)
+	{
+		AllSlots[SlotIdx] = SlotIdx;
+	}
+
+	for (;;)
+	{
+		uint32_t Count = mBackend->WaitForCompletions(Completions.data(), static_cast<uint32_t>(Completions.size()));
+
+		//Backend is gone for good. Fail what it holds and leave the submission
+		//thread to fail everything after - waiting again would spin forever.
+		if (Count == 0)
+		{
+			{
+				std::lock_guard<std::mutex> Lock(mMutex);
+				mBackendFailed = true;
+			}
+			FailSubmittedSlots(AllSlots);
+			return;
+		}
+
+		bool bExit = false;
+		for (uint32_t i = 0; i < Count; ++i)
+		{
+			if (Completions[i].Tag == AsyncIOWakeTag)
+			{
+				std::lock_guard<std::mutex> Lock(mMutex);
+				bExit = mShutdown;
+				continue;
+			}
+
+			Assert(Completions[i].Tag < mSlots.size());
+			ReadSlot& Slot = mSlots[static_cast<size_t>(Completions[i].Tag)];
+			{
+				//Already failed if the backend rejected the submission it was in
+				std::lock_guard<std::mutex> Lock(mMutex);
+				if (!Slot.bSubmitted)
+				{
+					continue;
+				}
+				Slot.bSubmitted = false;
+			}
+			CompleteSlot(Slot, Completions[i].Result);
+		}
+
+		if (bExit)
+		{
+			return;
+		}
+	}
+}
+
+void AsyncIOQueue::CompleteSlot(ReadSlot& Slot, int64_t Result)
+{
+	//Slot is ours until it goes back on the free list, so scatter and build
+	//the results first
+	std::vector<PendingRead> Reads;
+	Reads.swap(Slot.Reads);
+
+	uint64_t BytesAvailable = Result > 0 ? static_cast<uint64_t>(Result) : 0;
+	bool bCoalesced = Reads.size() > 1;
+
+	std::vector<AsyncReadResult> Results(Reads.size());
+	uint64_t TotalBytes = 0;
+	uint64_t FailedCount = 0;
+	Clock::time_point Now = Clock::now();
+
+	for (size_t i = 0; i < Reads.size(); ++i)
+	{
+		const AsyncReadRequest& Request = Reads[i].Request;
+		uint64_t Start = Request.Offset - Slot.Offset;
+		uint64_t Available = BytesAvailable > Start ? BytesAvailable - Start : 0;
+		uint32_t BytesRead = static_cast<uint32_t>(std::min<uint64_t>(Available, Request.Size));
+
+		if (bCoalesced && BytesRead > 0)
+		{
+			memcpy(Request.Dest, Slot.Staging.data() + Start, BytesRead);
+		}
+
+		AsyncReadResult& ReadResult = Results[i];
+		ReadResult.RequestId = Reads[i].Id;
+		ReadResult.Dest = Request.Dest;
+		ReadResult.BytesRead = BytesRead;
+		ReadResult.bSucceeded = Result >= 0 && BytesRead == Request.Size;
+		ReadResult.UserData = Request.UserData;
+		ReadResult.LatencyMilliseconds = std::chrono::duration<double, std::milli>(Now - Reads[i].QueueTime).count();
+
+		TotalBytes += BytesRead;
+		FailedCount += ReadResult.bSucceeded ? 0 : 1;
+	}
+
+	uint32_t SlotIdx = static_cast<uint32_t>(&Slot - mSlots.data());
+	{
+		std::lock_guard<std::mutex> Lock(mMutex);
+		mFreeSlots.push_back(SlotIdx);
+		mStats.BytesRead += TotalBytes;
+		mStats.RequestsFailed += FailedCount;
+	}
+	mWorkAvailable.notify_one();
+
+	for (size_t i = 0; i < Reads.size(); ++i)
+	{
+		if (Reads[i].Request.Callback)
+		{
+			Reads[i].Request.Callback(Reads[i].Request.Context, Results[i]);
+		}
+	}
+
+	bool bIdle;
+	{
+		std::lock_guard<std::mutex> Lock(mMutex);
+		mStats.RequestsCompleted += Reads.size();
+		mOutstanding -= Reads.size();
+		bIdle = mOutstanding == 0;
+	}
+	if (bIdle)
+	{
+		mIdle.notify_all();
+	}
+}
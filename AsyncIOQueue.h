@@ -0,0 +1,148 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "AsyncIOBackend.h"
+
+//Native file handle (fd / HANDLE) opened for positional reads.
+typedef intptr_t AsyncFileHandle;
+const AsyncFileHandle InvalidAsyncFileHandle = -1;
+
+//Lower values are issued first. Within a priority requests go in order.
+enum class AsyncIOPriority : uint32_t
+{
+	Critical,		//Stalls the frame if late (missing mip of a visible texture)
+	High,
+	Normal,
+	Low,			//Prefetch
+	Count
+};
+
+struct AsyncReadResult
+{
+	uint64_t RequestId;
+	void* Dest;
+	uint32_t BytesRead;
+	bool bSucceeded;				//Whole request read
+	uint64_t UserData;
+	double LatencyMilliseconds;		//From Read() to the data being in Dest
+};
+
+//Runs on the queue's completion thread, so should be short - hand anything
+//heavy (decompression, uploads) to a JobSystem.
+typedef void (*AsyncReadCallback)(void* Context, const AsyncReadResult& Result);
+
+struct AsyncReadRequest
+{
+	AsyncFileHandle File = InvalidAsyncFileHandle;
+	uint64_t Offset = 0;
+	uint32_t Size = 0;
+	void* Dest = nullptr;			//Must stay valid until the callback
+	AsyncIOPriority Priority = AsyncIOPriority::Normal;
+	AsyncReadCallback Callback = nullptr;
+	void* Context = nullptr;
+	uint64_t UserData = 0;
+};
+
+struct AsyncIOQueueSettings
+{
+	uint32_t MaxInFlight = 64;					//Reads outstanding at the backend
+	uint32_t MaxBatch = 32;						//Requests taken per submission
+	uint32_t MaxCoalescedBytes = 256 * 1024;	//Largest merged read
+	uint32_t ThreadPoolThreads = 4;				//Thread pool backend only
+	bool bAllowIoUring = true;
+};
+
+struct AsyncIOStats
+{
+	uint64_t RequestsCompleted = 0;
+	uint64_t RequestsFailed = 0;
+	uint64_t BackendReads = 0;			//Reads actually issued, after coalescing
+	uint64_t CoalescedRequests = 0;		//Requests served by a merged read
+	uint64_t BytesRead = 0;
+};
+
+//Asynchronous read queue for streaming.
+//
+//Requests are queued per priority. A submission thread takes batches in
+//priority order, sorts each batch by file and offset and merges requests
+//that are exactly adjacent in the same file in to one larger read through a
+//staging buffer. Reads go to an io_uring backend on Linux when the kernel
+//supports it, otherwise to a pool of threads doing blocking positional reads.
+//A completion thread copies merged data out to each request's Dest and calls
+//its callback.
+//
+//If the backend fails for good every read in flight fails, and so does every
+//request after it - nothing is left waiting for a completion that can't come.
+class AsyncIOQueue
+{
+public:
+	AsyncIOQueue(const AsyncIOQueueSettings& Settings = AsyncIOQueueSettings());
+	~AsyncIOQueue();
+
+	static AsyncFileHandle OpenFile(const char* Filename);
+	static void CloseFile(AsyncFileHandle File);
+	static uint64_t GetFileSize(AsyncFileHandle File);
+
+	//Thread safe. Returns the request id passed back in AsyncReadResult.
+	uint64_t Read(const AsyncReadRequest& Request);
+
+	//Blocks until every request so far has completed and had its callback run.
+	void WaitIdle();
+
+	AsyncIOStats GetStats() const;
+	const char* GetBackendName() const { return mBackend->GetName(); }
+	bool HasBackendFailed() const;
+
+private:
+	typedef std::chrono::high_resolution_clock Clock;
+
+	struct PendingRead
+	{
+		AsyncReadRequest Request;
+		uint64_t Id;
+		Clock::time_point QueueTime;
+	};
+
+	//One backend read in flight. Indexed by the backend tag.
+	struct ReadSlot
+	{
+		std::vector<PendingRead> Reads;		//Several if coalesced
+		std::vector<uint8_t> Staging;		//Coalesced reads land here first
+		uint64_t Offset = 0;
+		uint32_t Size = 0;
+		bool bSubmitted = false;			//Handed to the backend and not yet completed
+	};
+
+	void SubmitThreadMain();
+	void CompletionThreadMain();
+	void FailSubmittedSlots(const std::vector<uint32_t>& Slots);
+	void CompleteSlot(ReadSlot& Slot, int64_t Result);
+
+private:
+	AsyncIOQueueSettings mSettings;
+	std::unique_ptr<IAsyncIOBackend> mBackend;
+
+	mutable std::mutex mMutex;
+	std::condition_variable mWorkAvailable;
+	std::condition_variable mIdle;
+	std::deque<PendingRead> mQueues[static_cast<uint32_t>(AsyncIOPriority::Count)];
+	std::vector<ReadSlot> mSlots;
+	std::vector<uint32_t> mFreeSlots;
+	uint64_t mNextId;
+	uint64_t mOutstanding;		//Queued or in flight, until the callback has returned
+	uint64_t mQueuedCount;
+	bool mShutdown;
+	bool mBackendFailed;
+	AsyncIOStats mStats;
+
+	std::thread mSubmitThread;
+	std::thread mCompletionThread;
+};
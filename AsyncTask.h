@@ -0,0 +1,180 @@
+#pragma once
+
+#include <atomic>
+#include <cstdlib>
+#include <optional>
+#include <utility>
+
+//C++20 coroutines, or the Coroutines TS (MSVC /await) on older toolsets.
+#if defined(__cpp_impl_coroutine)
+#include <coroutine>
+namespace CoroutineStd = std;
+#else
+#include <experimental/coroutine>
+namespace CoroutineStd = std::experimental;
+#endif
+
+template<typename T>
+class AsyncTask;
+
+namespace AsyncTaskDetail
+{
+	//The awaiter and the finishing task both set mState and whichever is
+	//second carries on. If the task finished before its awaiter suspended the
+	//awaiter just continues (so a loop awaiting tasks that finish
+	//synchronously doesn't grow the stack), otherwise the task resumes it.
+	struct FinalAwaiter
+	{
+		bool await_ready() const noexcept { return false; }
+
+		template<typename Promise>
+		void await_suspend(CoroutineStd::coroutine_handle<Promise> Handle) noexcept
+		{
+			Promise& Finished = Handle.promise();
+			if (Finished.mState.exchange(true, std::memory_order_acq_rel) && Finished.mContinuation)
+			{
+				Finished.mContinuation.resume();
+			}
+		}
+
+		void await_resume() const noexcept {}
+	};
+
+	struct PromiseBase
+	{
+		CoroutineStd::coroutine_handle<> mContinuation;
+		std::atomic<bool> mState{ false };
+
+		//Lazy - nothing runs until the task is awaited or started
+		CoroutineStd::suspend_always initial_suspend() const noexcept { return {}; }
+		FinalAwaiter final_suspend() const noexcept { return {}; }
+
+		//Nothing in the engine throws
+		void unhandled_exception() { std::abort(); }
+	};
+
+	template<typename T>
+	struct Promise : PromiseBase
+	{
+		std::optional<T> mResult;
+
+		AsyncTask<T> get_return_object();
+		void return_value(T Value) { mResult.emplace(std::move(Value)); }
+		T TakeResult() { return std::move(*mResult); }
+	};
+
+	template<>
+	struct Promise<void> : PromiseBase
+	{
+		AsyncTask<void> get_return_object();
+		void return_void() {}
+		void TakeResult() {}
+	};
+}
+
+//A coroutine returning T. Starts when first awaited (or Start()ed) and resumes
+//its awaiter when it finishes. Owns the coroutine frame.
+//
+//	AsyncTask<bool> LoadThing(...)
+//	{
+//		AsyncReadResult Read = co_await ReadFileAsync(...);
+//		co_await RunJobAsync(Jobs, Scheduler, [&]() { Decompress(...); });
+//		co_return true;
+//	}
+template<typename T>
+class AsyncTask
+{
+public:
+	typedef AsyncTaskDetail::Promise<T> promise_type;
+	typedef CoroutineStd::coroutine_handle<promise_type> HandleType;
+
+	AsyncTask() : mHandle(nullptr), mStarted(false) {}
+	explicit AsyncTask(HandleType Handle) : mHandle(Handle), mStarted(false) {}
+	AsyncTask(AsyncTask&& Other) noexcept : mHandle(Other.mHandle), mStarted(Other.mStarted) { Other.mHandle = nullptr; }
+
+	AsyncTask& operator=(AsyncTask&& Other) noexcept
+	{
+		if (this != &Other)
+		{
+			Reset();
+			mHandle = Other.mHandle;
+			mStarted = Other.mStarted;
+			Other.mHandle = nullptr;
+		}
+		return *this;
+	}
+
+	~AsyncTask() { Reset(); }
+
+	bool IsValid() const { return mHandle != nullptr; }
+	bool IsDone() const { return !mHandle || mHandle.done(); }
+
+	//Runs a top level task up to its first suspension. Whatever it awaits
+	//resumes it from then on (see CoroutineScheduler).
+	void Start()
+	{
+		if (mHandle && !mStarted)
+		{
+			mStarted = true;
+			mHandle.resume();
+		}
+	}
+
+	//Once IsDone(). Moves the result out.
+	T GetResult() { return mHandle.promise().TakeResult(); }
+
+	struct Awaiter
+	{
+		HandleType mHandle;
+
+		bool await_ready() const noexcept { return !mHandle || mHandle.done(); }
+
+		//Returns false (don't suspend) if the task finished synchronously
+		bool await_suspend(CoroutineStd::coroutine_handle<> Awaiting) noexcept
+		{
+			mHandle.promise().mContinuation = Awaiting;
+			mHandle.resume();
+			return !mHandle.promise().mState.exchange(true, std::memory_order_acq_rel);
+		}
+
+		T await_resume() { return mHandle.promise().TakeResult(); }
+	};
+
+	Awaiter operator co_await() &&
+	{
+		mStarted = true;
+		return Awaiter{ mHandle };
+	}
+
+private:
+	AsyncTask(const AsyncTask&) = delete;
+	AsyncTask& operator=(const AsyncTask&) = delete;
+
+	void Reset()
+	{
+		if (mHandle)
+		{
+			mHandle.destroy();
+			mHandle = nullptr;
+		}
+		mStarted = false;
+	}
+
+private:
+	HandleType mHandle;
+	bool mStarted;
+};
+
+namespace AsyncTaskDetail
+{
+	template<typename T>
+	AsyncTask<T> Promise<T>::get_return_object()
+	{
+		return AsyncTask<T>(CoroutineStd::coroutine_handle<Promise<T>>::from_promise(*this));
+	}
+
+	inline AsyncTask<void> Promise<void>::get_return_object()
+	{
+		return AsyncTask<void>(CoroutineStd::coroutine_handle<Promise<void>>::from_promise(*this));
+	}
+}
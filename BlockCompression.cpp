@@ -0,0 +1,240 @@
+#include "BlockCompression.h"
+
+#include <cstring>
+
+namespace
+{
+	const size_t MinMatch = 4;
+	const size_t MaxOffset = 0xFFFF;
+	const uint32_t HashBits = 12;
+
+	//Matches can't start in the last MatchLimit bytes and the last
+	//LastLiterals bytes are always literals
+	const size_t MatchLimit = 12;
+	const size_t LastLiterals = 5;
+
+	inline uint32_t Read32(const uint8_t* Data)
+	{
+		uint32_t Value;
+		memcpy(&Value, Data, sizeof(Value));
+		return Value;
+	}
+
+	inline uint32_t HashSequence(uint32_t Sequence)
+	{
+		return (Sequence * 2654435761u) >> (32 - HashBits);
+	}
+
+	//Length continuation bytes - 255 means more follow
+	inline bool WriteLength(size_t Length, uint8_t*& Out, const uint8_t* OutEnd)
+	{
+		while (Length >= 255)
+		{
+			if (Out >= OutEnd)
+			{
+				return false;
+			}
+			*Out++ = 255;
+			Length -= 255;
+		}
+		if (Out >= OutEnd)
+		{
+			return false;
+		}
+		*Out++ = static_cast<uint8_t>(Length);
+		return true;
+	}
+
+	inline bool ReadLength(const uint8_t*& In, const uint8_t* InEnd, size_t& Length)
+	{
+		uint8_t Byte;
+		do
+		{
+			if (In >= InEnd)
+			{
+				return false;
+			}
+			Byte = *In++;
+			Length += Byte;
+		} while (Byte == 255);
+		return true;
+	}
+
+	bool WriteSequence(const uint8_t* Literals, size_t LiteralCount, size_t Offset, size_t MatchLength,
+		uint8_t*& Out, const uint8_t* OutEnd)
+	{
+		if (Out >= OutEnd)
+		{
+			return false;
+		}
+
+		bool bHasMatch = MatchLength != 0;
+		size_t MatchCode = bHasMatch ? MatchLength - MinMatch : 0;
+		uint8_t* Token = Out++;
+		*Token = static_cast<uint8_t>(((LiteralCount < 15 ? LiteralCount : 15) << 4) | (MatchCode < 15 ? MatchCode : 15));
+
+		if (LiteralCount >= 15 && !WriteLength(LiteralCount - 15, Out, OutEnd))
+		{
+			return false;
+		}
+
+		if (static_cast<size_t>(OutEnd - Out) < LiteralCount)
+		{
+			return false;
+		}
+		if (LiteralCount > 0)
+		{
+			memcpy(Out, Literals, LiteralCount);
+			Out += LiteralCount;
+		}
+
+		if (!bHasMatch)
+		{
+			return true;
+		}
+
+		if (OutEnd - Out < 2)
+		{
+			return false;
+		}
+		*Out++ = static_cast<uint8_t>(Offset & 0xFF);
+		*Out++ = static_cast<uint8_t>(Offset >> 8);
+
+		return MatchCode < 15 || WriteLength(MatchCode - 15, Out, OutEnd);
+	}
+}
+
+size_t BlockCompressBound(size_t Size)
+{
+	return Size + Size / 255 + 16;
+}
+
+size_t BlockCompress(const uint8_t* Source, size_t SourceSize, uint8_t* Dest, size_t DestCapacity)
+{
+	//Positions of recent 4 byte sequences. Stale or colliding entries are
+	//fine - every candidate is verified before use.
+	uint32_t Table[1 << HashBits];
+	memset(Table, 0, sizeof(Table));
+
+	uint8_t* Out = Dest;
+	const uint8_t* OutEnd = Dest + DestCapacity;
+
+	size_t Anchor = 0;
+	size_t Position = 0;
+
+	if (SourceSize > MatchLimit)
+	{
+		size_t Limit = SourceSize - MatchLimit;
+		size_t MatchEnd = SourceSize - LastLiterals;
+
+		while (Position < Limit)
+		{
+			uint32_t Sequence = Read32(Source + Position);
+			uint32_t Hash = HashSequence(Sequence);
+			size_t Candidate = Table[Hash];
+			Table[Hash] = static_cast<uint32_t>(Position);
+
+			if (Candidate >= Position || Position - Candidate > MaxOffset || Read32(Source + Candidate) != Sequence)
+			{
+				++Position;
+				continue;
+			}
+
+			size_t MatchLength = MinMatch;
+			while (Position + MatchLength < MatchEnd && Source[Candidate + MatchLength] == Source[Position + MatchLength])
+			{
+				++MatchLength;
+			}
+
+			if (!WriteSequence(Source + Anchor, Position - Anchor, Position - Candidate, MatchLength, Out, OutEnd))
+			{
+				return 0;
+			}
+
+			Position += MatchLength;
+			Anchor = Position;
+		}
+	}
+
+	if (!WriteSequence(Source + Anchor, SourceSize - Anchor, 0, 0, Out, OutEnd))
+	{
+		return 0;
+	}
+
+	return static_cast<size_t>(Out - Dest);
+}
+
+bool BlockDecompress(const uint8_t* Source, size_t SourceSize, uint8_t* Dest, size_t DestSize)
+{
+	const uint8_t* In = Source;
+	const uint8_t* InEnd = Source + SourceSize;
+	uint8_t* Out = Dest;
+	uint8_t* OutEnd = Dest + DestSize;
+
+	for (;;)
+	{
+		if (In >= InEnd)
+		{
+			return false;
+		}
+		uint8_t Token = *In++;
+
+		size_t LiteralCount = Token >> 4;
+		if (LiteralCount == 15 && !ReadLength(In, InEnd, LiteralCount))
+		{
+			return false;
+		}
+
+		if (static_cast<size_t>(InEnd - In) < LiteralCount || static_cast<size_t>(OutEnd - Out) < LiteralCount)
+		{
+			return false;
+		}
+		if (LiteralCount > 0)
+		{
+			memcpy(Out, In, LiteralCount);
+			In += LiteralCount;
+			Out += LiteralCount;
+		}
+
+		//Final sequence has no match
+		if (In == InEnd)
+		{
+			return Out == OutEnd;
+		}
+
+		if (InEnd - In < 2)
+		{
+			return false;
+		}
+		size_t Offset = In[0] | (In[1] << 8);
+		In += 2;
+
+		size_t MatchLength = Token & 0xF;
+		if (MatchLength == 15 && !ReadLength(In, InEnd, MatchLength))
+		{
+			return false;
+		}
+		MatchLength += MinMatch;
+
+		if (Offset == 0 || Offset > static_cast<size_t>(Out - Dest) || static_cast<size_t>(OutEnd - Out) < MatchLength)
+		{
+			return false;
+		}
+
+		//Overlapping copies repeat the last Offset bytes, so go a byte at a
+		//time unless the source is entirely behind us
+		const uint8_t* Match = Out - Offset;
+		if (Offset >= MatchLength)
+		{
+			memcpy(Out, Match, MatchLength);
+			Out += MatchLength;
+		}
+		else
+		{
+			for (size_t i = 0; i < MatchLength; ++i)
+			{
+				*Out++ = *Match++;
+			}
+		}
+	}
+}
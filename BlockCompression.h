@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+//Byte oriented LZ77 block compression in the style of LZ4: favours very fast,
+//branch light decompression over ratio, which is the right trade for data that
+//is decompressed every load. Blocks are independent so they can be
+//(de)compressed in parallel.
+//
+//A block is a run of sequences: a token (4 bits literal length, 4 bits match
+//length - 4), extended lengths as runs of 255, the literals, then a 16 bit
+//offset back in to the output and extended match length. The final sequence
+//is literals only.
+
+//Worst case compressed size of Size bytes.
+size_t BlockCompressBound(size_t Size);
+
+//Returns the compressed size, or 0 if it didn't fit in DestCapacity.
+size_t BlockCompress(const uint8_t* Source, size_t SourceSize, uint8_t* Dest, size_t DestCapacity);
+
+//Source must decompress to exactly DestSize bytes. Safe against corrupt input -
+//returns false rather than reading or writing out of bounds.
+bool BlockDecompress(const uint8_t* Source, size_t SourceSize, uint8_t* Dest, size_t DestSize);
@@ -0,0 +1,429 @@
+#include "BvhBenchmark.h"
+#include "Common.h"
+#include "JobSystem.h"
+#include "VectorMath.h"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <stdio.h>
+
+namespace
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	double MillisecondsSince(Clock::time_point Start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - Start).count();
+	}
+
+	const float WorldSize = 1000.0f;
+	const float SphereRadius = 20.0f;
+
+	//Queries checked against brute force at each stage
+	const uint32_t VerifiedQueries = 50;
+
+	//Camera at the origin, a full turn over the run
+	Frustum MakeView(uint32_t Pass, uint32_t PassCount)
+	{
+		float Angle = 6.2831853f * static_cast<float>(Pass) / static_cast<float>(PassCount);
+		Float3 Eye = MakeFloat3(0.0f, 0.0f, 0.0f);
+		Float3 Target = MakeFloat3(sinf(Angle), 0.2f, cosf(Angle));
+		Matrix4x4 View = MatrixLookAtLH(Eye, Target, MakeFloat3(0.0f, 1.0f, 0.0f));
+		Matrix4x4 Projection = MatrixPerspectiveFovLH(1.0472f, 16.0f / 9.0f, 0.1f, WorldSize);
+		return FrustumFromViewProjection(Multiply(Projection, View));
+	}
+
+	struct Ray
+	{
+		Float3 Origin;
+		Float3 Direction;
+	};
+
+	std::vector<Ray> MakeRays(uint32_t Count)
+	{
+		std::mt19937 Random(99);
+		std::uniform_real_distribution<float> Position(-WorldSize, WorldSize);
+		std::uniform_real_distribution<float> Axis(-1.0f, 1.0f);
+		std::vector<Ray> Rays(Count);
+		for (Ray& Query : Rays)
+		{
+			Query.Origin = MakeFloat3(Position(Random), Position(Random), Position(Random));
+			Query.Direction = Normalize(MakeFloat3(Axis(Random), Axis(Random), Axis(Random)));
+		}
+		return Rays;
+	}
+
+	std::vector<Float3> MakeSphereCentres(uint32_t Count)
+	{
+		std::mt19937 Random(98);
+		std::uniform_real_distribution<float> Position(-WorldSize, WorldSize);
+		std::vector<Float3> Centres(Count);
+		for (Float3& Centre : Centres)
+		{
+			Centre = MakeFloat3(Position(Random), Position(Random), Position(Random));
+		}
+		return Centres;
+	}
+
+	bool SphereTouches(const Float3& Centre, float Radius, const Aabb& Box)
+	{
+		Float3 Nearest = Min(Max(Centre, Box.Min), Box.Max);
+		Float3 Delta = Nearest - Centre;
+		return Dot(Delta, Delta) <= Radius * Radius;
+	}
+
+	bool RayEnters(const Ray& Query, const Aabb& Box, float MaxDistance, float& OutDistance)
+	{
+		const float Origin[3] = { Query.Origin.X, Query.Origin.Y, Query.Origin.Z };
+		const float Direction[3] = { Query.Direction.X, Query.Direction.Y, Query.Direction.Z };
+		const float Low[3] = { Box.Min.X, Box.Min.Y, Box.Min.Z };
+		const float High[3] = { Box.Max.X, Box.Max.Y, Box.Max.Z };
+
+		float Enter = 0.0f;
+		float Exit = MaxDistance;
+		for (int Axis = 0; Axis < 3; ++Axis)
+		{
+			float Inverse = fabsf(Direction[Axis]) > 1e-20f ? 1.0f / Direction[Axis] : copysignf(1e30f, Direction[Axis]);
+			float T0 = (Low[Axis] - Origin[Axis]) * Inverse;
+			float T1 = (High[Axis] - Origin[Axis]) * Inverse;
+			Enter = std::max(Enter, std::min(T0, T1));
+			Exit = std::min(Exit, std::max(T0, T1));
+		}
+		OutDistance = Enter;
+		return Enter <= Exit;
+	}
+
+	//Every object that must be in Found is, and everything in Found could be
+	bool ResultsMatch(std::vector<uint32_t>& Found, const std::vector<uint32_t>& Required, const std::vector<uint8_t>& Allowed)
+	{
+		std::sort(Found.begin(), Found.end());
+		if (std::adjacent_find(Found.begin(), Found.end()) != Found.end())
+		{
+			return false;
+		}
+		for (uint32_t Object : Required)
+		{
+			if (!std::binary_search(Found.begin(), Found.end(), Object))
+			{
+				return false;
+			}
+		}
+		for (uint32_t Object : Found)
+		{
+			if (!Allowed[Object])
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+BvhBenchmark::BvhBenchmark(const BvhBenchmarkSettings& Settings)
+	: mSettings(Settings)
+{
+	Assert(mSettings.Iterations > 0);
+}
+
+BvhBenchmark::~BvhBenchmark()
+{}
+
+bool BvhBenchmark::Run()
+{
+	mResults.clear();
+	mTrees.clear();
+	if (mSettings.MovingFraction < 0.0f || mSettings.MovingFraction > 1.0f || mSettings.Margin < 0.0f)
+	{
+		mLastError = "Moving fraction must be 0 to 1 and the margin at least 0";
+		return false;
+	}
+
+	for (uint32_t ObjectCount : mSettings.ObjectCounts)
+	{
+		if (ObjectCount == 0 || !RunObjectCount(ObjectCount))
+		{
+			if (mLastError.empty())
+			{
+				mLastError = "Object counts must be above 0";
+			}
+			return false;
+		}
+	}
+	return true;
+}
+
+bool BvhBenchmark::RunObjectCount(uint32_t ObjectCount)
+{
+	std::mt19937 Random(1234);
+	std::uniform_real_distribution<float> Position(-WorldSize, WorldSize);
+	std::uniform_real_distribution<float> Size(0.5f, 5.0f);
+	std::uniform_real_distribution<float> Step(-1.0f, 1.0f);
+
+	std::vector<Aabb> Bounds(ObjectCount);
+	for (Aabb& Box : Bounds)
+	{
+		Box.Min = MakeFloat3(Position(Random), Position(Random), Position(Random));
+		Box.Max = Box.Min + MakeFloat3(Size(Random), Size(Random), Size(Random));
+	}
+
+	DynamicBvh Bvh(mSettings.Margin);
+	std::vector<uint32_t> Objects(ObjectCount);
+
+	auto Start = Clock::now();
+	for (uint32_t i = 0; i < ObjectCount; ++i)
+	{
+		Objects[i] = Bvh.Insert(Bounds[i]);
+	}
+	AddResult(ObjectCount, "Insert", MillisecondsSince(Start), ObjectCount);
+	AddTree(ObjectCount, "Inserted", Bvh);
+	if (!Verify(Bvh, Bounds, "after inserts"))
+	{
+		return false;
+	}
+
+	//Objects are inserted in order in to an empty tree, so index i is object i
+	Check(Objects[ObjectCount - 1] == ObjectCount - 1);
+
+	//A different slice of objects moves each frame
+	uint32_t MoveCount = static_cast<uint32_t>(ObjectCount * mSettings.MovingFraction);
+	uint32_t NextMover = 0;
+	auto MoveFrame = [&]()
+	{
+		for (uint32_t i = 0; i < MoveCount; ++i)
+		{
+			uint32_t Object = NextMover;
+			NextMover = NextMover + 1 < ObjectCount ? NextMover + 1 : 0;
+
+			Float3 Offset = MakeFloat3(Step(Random), Step(Random), Step(Random));
+			Bounds[Object].Min = Bounds[Object].Min + Offset;
+			Bounds[Object].Max = Bounds[Object].Max + Offset;
+			Bvh.Move(Object, Bounds[Object]);
+		}
+	};
+
+	Start = Clock::now();
+	for (uint32_t Frame = 0; Frame < mSettings.Iterations; ++Frame)
+	{
+		MoveFrame();
+	}
+	AddResult(ObjectCount, "Move", MillisecondsSince(Start), static_cast<uint64_t>(MoveCount) * mSettings.Iterations);
+	AddTree(ObjectCount, "Moved", Bvh);
+	if (!Verify(Bvh, Bounds, "after moves"))
+	{
+		return false;
+	}
+
+	Start = Clock::now();
+	Bvh.Rebuild();
+	AddResult(ObjectCount, "Rebuild", MillisecondsSince(Start), ObjectCount);
+	AddTree(ObjectCount, "Rebuilt", Bvh);
+	if (!Verify(Bvh, Bounds, "after a rebuild"))
+	{
+		return false;
+	}
+
+	//Moving on while a worker rebuilds, so the swap has changes to replay -
+	//including some objects removed and added again
+	{
+		JobSystem Jobs(1);
+		Start = Clock::now();
+		Bvh.BeginRebuild(Jobs);
+		for (uint32_t Frame = 0; Frame < 4; ++Frame)
+		{
+			MoveFrame();
+		}
+		for (uint32_t Object = 0; Object < ObjectCount; Object += 97)
+		{
+			Bvh.Remove(Object);
+		}
+		std::vector<Aabb> Removed = Bounds;
+		for (uint32_t Object = 0; Object < ObjectCount; Object += 97)
+		{
+			uint32_t Reinserted = Bvh.Insert(Removed[Object]);
+			Check(Reinserted < ObjectCount);
+			Bounds[Reinserted] = Removed[Object];
+		}
+		Bvh.FinishRebuild();
+		AddResult(ObjectCount, "Background", MillisecondsSince(Start), ObjectCount);
+	}
+	AddTree(ObjectCount, "Background", Bvh);
+	if (!Verify(Bvh, Bounds, "after a background rebuild"))
+	{
+		return false;
+	}
+
+	//Queries on the rebuilt tree
+	std::vector<uint32_t> Found;
+	uint64_t FoundCount = 0;
+	Start = Clock::now();
+	for (uint32_t Pass = 0; Pass < mSettings.Iterations; ++Pass)
+	{
+		Found.clear();
+		Bvh.QueryFrustum(MakeView(Pass, mSettings.Iterations), Found);
+		FoundCount += Found.size();
+	}
+	AddResult(ObjectCount, "Frustum", MillisecondsSince(Start), mSettings.Iterations,
+		static_cast<double>(FoundCount) / mSettings.Iterations);
+
+	std::vector<Float3> Centres = MakeSphereCentres(mSettings.QueryCount);
+	FoundCount = 0;
+	Start = Clock::now();
+	for (const Float3& Centre : Centres)
+	{
+		Found.clear();
+		Bvh.QuerySphere(Centre, SphereRadius, Found);
+		FoundCount += Found.size();
+	}
+	AddResult(ObjectCount, "Sphere", MillisecondsSince(Start), mSettings.QueryCount,
+		mSettings.QueryCount > 0 ? static_cast<double>(FoundCount) / mSettings.QueryCount : 0.0);
+
+	std::vector<Ray> Rays = MakeRays(mSettings.QueryCount);
+	FoundCount = 0;
+	Start = Clock::now();
+	for (const Ray& Query : Rays)
+	{
+		float Distance;
+		FoundCount += Bvh.RayCast(Query.Origin, Query.Direction, 2.0f * WorldSize, Distance) != DynamicBvh::NullIndex ? 1 : 0;
+	}
+	AddResult(ObjectCount, "Ray", MillisecondsSince(Start), mSettings.QueryCount,
+		mSettings.QueryCount > 0 ? static_cast<double>(FoundCount) / mSettings.QueryCount : 0.0);
+
+	return true;
+}
+
+bool BvhBenchmark::Verify(const DynamicBvh& Bvh, const std::vector<Aabb>& Bounds, const char* Stage)
+{
+	//Tree bounds are grown by the margin and may lag a move by up to it again
+	uint32_t ObjectCount = static_cast<uint32_t>(Bounds.size());
+	float Slack = 2.0f * mSettings.Margin;
+	std::vector<uint32_t> Found;
+	std::vector<uint32_t> Required;
+	std::vector<uint8_t> Allowed(ObjectCount);
+
+	auto Fail = [this, Stage](const char* Query, uint32_t Index)
+	{
+		char Error[128];
+		snprintf(Error, sizeof(Error), "%s query %u disagrees with brute force %s", Query, Index, Stage);
+		mLastError = Error;
+		return false;
+	};
+
+	for (uint32_t Pass = 0; Pass < 4; ++Pass)
+	{
+		Frustum View = MakeView(Pass, 4);
+		Required.clear();
+		for (uint32_t Object = 0; Object < ObjectCount; ++Object)
+		{
+			if (IsAabbInFrustum(View, Bounds[Object]))
+			{
+				Required.push_back(Object);
+			}
+			Allowed[Object] = IsAabbInFrustum(View, Expand(Bounds[Object], Slack)) ? 1 : 0;
+		}
+
+		Found.clear();
+		Bvh.QueryFrustum(View, Found);
+		if (!ResultsMatch(Found, Required, Allowed))
+		{
+			return Fail("Frustum", Pass);
+		}
+	}
+
+	std::vector<Float3> Centres = MakeSphereCentres(VerifiedQueries);
+	for (uint32_t Query = 0; Query < VerifiedQueries; ++Query)
+	{
+		Required.clear();
+		for (uint32_t Object = 0; Object < ObjectCount; ++Object)
+		{
+			if (SphereTouches(Centres[Query], SphereRadius, Bounds[Object]))
+			{
+				Required.push_back(Object);
+			}
+			Allowed[Object] = SphereTouches(Centres[Query], SphereRadius, Expand(Bounds[Object], Slack)) ? 1 : 0;
+		}
+
+		Found.clear();
+		Bvh.QuerySphere(Centres[Query], SphereRadius, Found);
+		if (!ResultsMatch(Found, Required, Allowed))
+		{
+			return Fail("Sphere", Query);
+		}
+	}
+
+	//Ties can pick either object, so only the distance has to match
+	std::vector<Ray> Rays = MakeRays(VerifiedQueries);
+	for (uint32_t Query = 0; Query < VerifiedQueries; ++Query)
+	{
+		float Expected = 2.0f * WorldSize;
+		bool bExpectedHit = false;
+		for (uint32_t Object = 0; Object < ObjectCount; ++Object)
+		{
+			float Distance;
+			if (RayEnters(Rays[Query], Bounds[Object], Expected, Distance) && Distance <= Expected)
+			{
+				Expected = Distance;
+				bExpectedHit = true;
+			}
+		}
+
+		float Distance = 0.0f;
+		uint32_t Hit = Bvh.RayCast(Rays[Query].Origin, Rays[Query].Direction, 2.0f * WorldSize, Distance);
+		if ((Hit != DynamicBvh::NullIndex) != bExpectedHit || (bExpectedHit && fabsf(Distance - Expected) > 1e-3f))
+		{
+			return Fail("Ray", Query);
+		}
+	}
+	return true;
+}
+
+void BvhBenchmark::AddResult(uint32_t ObjectCount, const std::string& Mode, double Milliseconds, uint64_t Items, double ResultsPerQuery)
+{
+	BvhBenchmarkResult Result;
+	Result.ObjectCount = ObjectCount;
+	Result.Mode = Mode;
+	Result.Milliseconds = Milliseconds;
+	Result.ItemsPerMillisecond = Milliseconds > 0.0 ? Items / Milliseconds : 0.0;
+	Result.ResultsPerQuery = ResultsPerQuery;
+	mResults.push_back(Result);
+}
+
+void BvhBenchmark::AddTree(uint32_t ObjectCount, const std::string& Stage, const DynamicBvh& Bvh)
+{
+	BvhBenchmarkTree Tree;
+	Tree.ObjectCount = ObjectCount;
+	Tree.Stage = Stage;
+	Tree.Stats = Bvh.ComputeStats();
+	mTrees.push_back(Tree);
+}
+
+bool BvhBenchmark::WriteReport(const char* Filename) const
+{
+	FILE* File = fopen(Filename, "w");
+	if (!File)
+	{
+		return false;
+	}
+
+	fprintf(File, "Backend:     %s\n", GetSimdBackendName());
+	fprintf(File, "Iterations:  %u\n", mSettings.Iterations);
+	fprintf(File, "Moving:      %.0f%% per frame\n", mSettings.MovingFraction * 100.0f);
+	fprintf(File, "Margin:      %.2f\n\n", mSettings.Margin);
+
+	fprintf(File, "Objects,Mode,Ms,ItemsPerMs,ResultsPerQuery\n");
+	for (const BvhBenchmarkResult& Result : mResults)
+	{
+		fprintf(File, "%u,%s,%.3f,%.1f,%.2f\n", Result.ObjectCount, Result.Mode.c_str(), Result.Milliseconds,
+			Result.ItemsPerMillisecond, Result.ResultsPerQuery);
+	}
+
+	fprintf(File, "\nObjects,Tree,Nodes,Depth,Cost\n");
+	for (const BvhBenchmarkTree& Tree : mTrees)
+	{
+		fprintf(File, "%u,%s,%u,%u,%.1f\n", Tree.ObjectCount, Tree.Stage.c_str(), Tree.Stats.NodeCount, Tree.Stats.Depth,
+			Tree.Stats.Cost);
+	}
+
+	fclose(File);
+	return true;
+}
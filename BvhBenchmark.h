@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "DynamicBvh.h"
+
+//DynamicBvh build, update and query speed for each of ObjectCounts random
+//boxes. Modes:
+//	Insert			- every object inserted one at a time, in objects per ms
+//	Rebuild			- a surface area heuristic rebuild, in objects per ms
+//	Move			- MovingFraction of objects nudged each frame, in moves per ms
+//	Background		- frames moved while a rebuild runs on a worker, then the
+//					  swap; BeginRebuild() to FinishRebuild(), in objects per ms
+//	Frustum			- a camera turning on the spot, in queries per ms
+//	Sphere, Ray		- QueryCount random queries, in queries per ms
+//
+//Times are totals for the mode's items. Tree quality is recorded after the
+//inserts, the moves and the rebuilds.
+//Run() fails if a query disagrees with a brute force pass over the bounds.
+struct BvhBenchmarkSettings
+{
+	std::vector<uint32_t> ObjectCounts = { 10000, 100000, 1000000 };
+	uint32_t Iterations = 20;
+	float MovingFraction = 0.1f;
+	uint32_t QueryCount = 10000;
+	float Margin = 0.5f;
+};
+
+struct BvhBenchmarkResult
+{
+	uint32_t ObjectCount = 0;
+	std::string Mode;
+	double Milliseconds = 0.0;
+	double ItemsPerMillisecond = 0.0;
+	double ResultsPerQuery = 0.0;
+};
+
+struct BvhBenchmarkTree
+{
+	uint32_t ObjectCount = 0;
+	std::string Stage;
+	DynamicBvhStats Stats;
+};
+
+class BvhBenchmark
+{
+public:
+	BvhBenchmark(const BvhBenchmarkSettings& Settings);
+	~BvhBenchmark();
+
+	bool Run();
+	bool WriteReport(const char* Filename) const;
+
+	const std::string& GetLastError() const { return mLastError; }
+
+private:
+	bool RunObjectCount(uint32_t ObjectCount);
+
+	//Spot checks every query type against the bounds
+	bool Verify(const DynamicBvh& Bvh, const std::vector<Aabb>& Bounds, const char* Stage);
+
+	void AddResult(uint32_t ObjectCount, const std::string& Mode, double Milliseconds, uint64_t Items, double ResultsPerQuery = 0.0);
+	void AddTree(uint32_t ObjectCount, const std::string& Stage, const DynamicBvh& Bvh);
+
+private:
+	BvhBenchmarkSettings mSettings;
+	std::vector<BvhBenchmarkResult> mResults;
+	std::vector<BvhBenchmarkTree> mTrees;
+
+	std::string mLastError;
+};
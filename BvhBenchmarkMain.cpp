@@ -0,0 +1,61 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "BvhBenchmark.h"
+
+//Dynamic BVH benchmark:
+//	BvhBenchmark [-iterations N] [-objects N ...] [-moving F] [-queries N] [-margin F]
+//Writes BvhBenchmark.txt to the current directory.
+int main(int argc, char** argv)
+{
+	BvhBenchmarkSettings Settings;
+	bool bCustomObjects = false;
+	bool bValid = true;
+	for (int i = 1; i < argc && bValid; ++i)
+	{
+		if (strcmp(argv[i], "-iterations") == 0 && i + 1 < argc)
+		{
+			Settings.Iterations = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-objects") == 0 && i + 1 < argc)
+		{
+			if (!bCustomObjects)
+			{
+				Settings.ObjectCounts.clear();
+				bCustomObjects = true;
+			}
+			Settings.ObjectCounts.push_back(static_cast<uint32_t>(atoi(argv[++i])));
+		}
+		else if (strcmp(argv[i], "-moving") == 0 && i + 1 < argc)
+		{
+			Settings.MovingFraction = static_cast<float>(atof(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-queries") == 0 && i + 1 < argc)
+		{
+			Settings.QueryCount = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-margin") == 0 && i + 1 < argc)
+		{
+			Settings.Margin = static_cast<float>(atof(argv[++i]));
+		}
+		else
+		{
+			bValid = false;
+		}
+	}
+
+	if (!bValid || Settings.Iterations == 0)
+	{
+		fprintf(stderr, "Usage: BvhBenchmark [-iterations N] [-objects N ...] [-moving F] [-queries N] [-margin F]\n");
+		return 1;
+	}
+
+	BvhBenchmark Benchmark(Settings);
+	if (!Benchmark.Run())
+	{
+		fprintf(stderr, "%s\n", Benchmark.GetLastError().c_str());
+		return 1;
+	}
+	return Benchmark.WriteReport("BvhBenchmark.txt") ? 0 : 1;
+}
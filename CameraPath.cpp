@@ -0,0 +1,96 @@
+#include "CameraPath.h"
+
+#include <cmath>
+#include <stdio.h>
+
+CameraPath::CameraPath()
+{}
+
+CameraPath::~CameraPath()
+{}
+
+bool CameraPath::LoadFromFile(const char* Filename)
+{
+	FILE* File = fopen(Filename, "r");
+	if (!File)
+	{
+		return false;
+	}
+
+	mSamples.clear();
+
+	char Line[512];
+	while (fgets(Line, sizeof(Line), File))
+	{
+		if (Line[0] == '#' || Line[0] == '\n' || Line[0] == '\r')
+		{
+			continue;
+		}
+
+		CameraPathSample Sample;
+		int Read = sscanf(Line, "%f %f %f %f %f %f",
+			&Sample.Position[0], &Sample.Position[1], &Sample.Position[2],
+			&Sample.Forward[0], &Sample.Forward[1], &Sample.Forward[2]);
+		if (Read == 6)
+		{
+			mSamples.push_back(Sample);
+		}
+	}
+
+	fclose(File);
+	return !mSamples.empty();
+}
+
+bool CameraPath::SaveToFile(const char* Filename) const
+{
+	FILE* File = fopen(Filename, "w");
+	if (!File)
+	{
+		return false;
+	}
+
+	fprintf(File, "# PosX PosY PosZ ForwardX ForwardY ForwardZ\n");
+	for (const CameraPathSample& Sample : mSamples)
+	{
+		fprintf(File, "%.6f %.6f %.6f %.6f %.6f %.6f\n",
+			Sample.Position[0], Sample.Position[1], Sample.Position[2],
+			Sample.Forward[0], Sample.Forward[1], Sample.Forward[2]);
+	}
+
+	fclose(File);
+	return true;
+}
+
+void CameraPath::AddSample(const CameraPathSample& Sample)
+{
+	mSamples.push_back(Sample);
+}
+
+void CameraPath::Clear()
+{
+	mSamples.clear();
+}
+
+void CameraPath::GenerateCircuit(unsigned FrameCount, float Radius, float Height)
+{
+	mSamples.clear();
+	mSamples.reserve(FrameCount);
+
+	const float TwoPi = 6.28318530718f;
+	for (unsigned i = 0; i < FrameCount; ++i)
+	{
+		float Angle = TwoPi * (static_cast<float>(i) / static_cast<float>(FrameCount));
+
+		CameraPathSample Sample;
+		Sample.Position[0] = std::cos(Angle) * Radius;
+		Sample.Position[1] = Height;
+		Sample.Position[2] = std::sin(Angle) * Radius;
+
+		//Tangent to the circle
+		Sample.Forward[0] = -std::sin(Angle);
+		Sample.Forward[1] = 0.0f;
+		Sample.Forward[2] = std::cos(Angle);
+
+		mSamples.push_back(Sample);
+	}
+}
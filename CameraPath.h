@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+//A recorded camera path - one sample per frame. Used to drive headless
+//(GPU-less) simulations deterministically.
+//
+//File format is plain text, one sample per line:
+//	PosX PosY PosZ ForwardX ForwardY ForwardZ
+//Blank lines and lines starting with '#' are ignored.
+struct CameraPathSample
+{
+	float Position[3];
+	float Forward[3];
+};
+
+class CameraPath
+{
+public:
+	CameraPath();
+	~CameraPath();
+
+	bool LoadFromFile(const char* Filename);
+	bool SaveToFile(const char* Filename) const;
+
+	//Record a sample (eg: from the live camera each frame).
+	void AddSample(const CameraPathSample& Sample);
+	void Clear();
+
+	//Deterministic fallback path when nothing has been recorded: flies along a
+	//circle of Radius at Height, looking along the direction of travel.
+	void GenerateCircuit(unsigned FrameCount, float Radius, float Height);
+
+	unsigned GetSampleCount() const { return static_cast<unsigned>(mSamples.size()); }
+	const CameraPathSample& GetSample(unsigned Idx) const { return mSamples[Idx]; }
+
+private:
+	std::vector<CameraPathSample> mSamples;
+};
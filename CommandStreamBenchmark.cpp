@@ -0,0 +1,506 @@
+#include "CommandStreamBenchmark.h"
+#include "Common.h"
+#include "JobSystem.h"
+#include "RenderCommandStream.h"
+#include "StandInCommandList.h"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <stdio.h>
+#include <string.h>
+
+namespace
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	double MillisecondsSince(Clock::time_point Start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - Start).count();
+	}
+
+	const uint32_t InstanceDataRootParameter = 0;
+	const uint32_t MaterialRootParameter = 1;
+	const uint32_t RootSignatureCount = 8;
+
+	//Resource ids: the upload buffer, each pass's target, then copy destinations
+	const uint32_t UploadBuffer = 0;
+	const uint32_t FirstRenderTarget = 1;
+
+	struct Call
+	{
+		RenderCommandType Type;
+		uint32_t Args[5];
+		uint64_t Wide[3];
+
+		bool operator==(const Call& Other) const
+		{
+			return Type == Other.Type && memcmp(Args, Other.Args, sizeof(Args)) == 0 && memcmp(Wide, Other.Wide, sizeof(Wide)) == 0;
+		}
+	};
+
+	//Keeps every call, with viewports and render target lists to one side
+	class CallRecorder : public IRenderCommandList
+	{
+	public:
+		void SetPipelineState(uint32_t PipelineState) override { Add(RenderCommandType::SetPipelineState, PipelineState); }
+		void SetGraphicsRootSignature(uint32_t RootSignature) override { Add(RenderCommandType::SetRootSignature, RootSignature); }
+		void SetGraphicsRootDescriptorTable(uint32_t RootParameter, uint32_t Table) override
+		{
+			Add(RenderCommandType::SetDescriptorTable, RootParameter, Table);
+		}
+		void SetGraphicsRootShaderResourceView(uint32_t RootParameter, uint64_t GpuAddress) override
+		{
+			Add(RenderCommandType::SetRootShaderResourceView, RootParameter).Wide[0] = GpuAddress;
+		}
+		void SetMesh(uint32_t Mesh) override { Add(RenderCommandType::SetMesh, Mesh); }
+		void SetViewport(const RenderViewport& Viewport) override
+		{
+			Add(RenderCommandType::SetViewport, static_cast<uint32_t>(mViewports.size()));
+			mViewports.push_back(Viewport);
+		}
+		void SetRenderTargets(uint32_t Count, const uint64_t* RenderTargets, uint64_t DepthStencil) override
+		{
+			Add(RenderCommandType::SetRenderTargets, Count, static_cast<uint32_t>(mTargets.size())).Wide[0] = DepthStencil;
+			mTargets.insert(mTargets.end(), RenderTargets, RenderTargets + Count);
+		}
+		void DrawIndexedInstanced(uint32_t IndexCountPerInstance, uint32_t InstanceCount, uint32_t StartIndexLocation,
+			int32_t BaseVertexLocation, uint32_t StartInstanceLocation) override
+		{
+			Call& Entry = Add(RenderCommandType::DrawIndexedInstanced, IndexCountPerInstance, InstanceCount);
+			Entry.Args[2] = StartIndexLocation;
+			Entry.Args[3] = static_cast<uint32_t>(BaseVertexLocation);
+			Entry.Args[4] = StartInstanceLocation;
+		}
+		void ResourceBarrier(uint32_t Resource, RenderResourceState Before, RenderResourceState After) override
+		{
+			Add(RenderCommandType::ResourceBarrier, Resource, static_cast<uint32_t>(Before)).Args[2] = static_cast<uint32_t>(After);
+		}
+		void CopyBufferRegion(uint32_t Destination, uint64_t DestinationOffset, uint32_t Source, uint64_t SourceOffset,
+			uint64_t Size) override
+		{
+			Call& Entry = Add(RenderCommandType::CopyBufferRegion, Destination, Source);
+			Entry.Wide[0] = DestinationOffset;
+			Entry.Wide[1] = SourceOffset;
+			Entry.Wide[2] = Size;
+		}
+
+		//Starts the calls of the next stream
+		void BeginSegment() { mSegments.push_back(static_cast<uint32_t>(mCalls.size())); }
+
+		uint32_t GetSegmentCount() const { return static_cast<uint32_t>(mSegments.size()); }
+
+		void Replay(uint32_t Segment, IRenderCommandList& Target) const
+		{
+			uint32_t End = Segment + 1 < mSegments.size() ? mSegments[Segment + 1] : static_cast<uint32_t>(mCalls.size());
+			for (uint32_t i = mSegments[Segment]; i < End; ++i)
+			{
+				const Call& Entry = mCalls[i];
+				switch (Entry.Type)
+				{
+				case RenderCommandType::SetPipelineState:
+					Target.SetPipelineState(Entry.Args[0]);
+					break;
+				case RenderCommandType::SetRootSignature:
+					Target.SetGraphicsRootSignature(Entry.Args[0]);
+					break;
+				case RenderCommandType::SetDescriptorTable:
+					Target.SetGraphicsRootDescriptorTable(Entry.Args[0], Entry.Args[1]);
+					break;
+				case RenderCommandType::SetRootShaderResourceView:
+					Target.SetGraphicsRootShaderResourceView(Entry.Args[0], Entry.Wide[0]);
+					break;
+				case RenderCommandType::SetMesh:
+					Target.SetMesh(Entry.Args[0]);
+					break;
+				case RenderCommandType::SetViewport:
+					Target.SetViewport(mViewports[Entry.Args[0]]);
+					break;
+				case RenderCommandType::SetRenderTargets:
+					Target.SetRenderTargets(Entry.Args[0], &mTargets[Entry.Args[1]], Entry.Wide[0]);
+					break;
+				case RenderCommandType::DrawIndexedInstanced:
+					Target.DrawIndexedInstanced(Entry.Args[0], Entry.Args[1], Entry.Args[2], static_cast<int32_t>(Entry.Args[3]), Entry.Args[4]);
+					break;
+				case RenderCommandType::ResourceBarrier:
+					Target.ResourceBarrier(Entry.Args[0], static_cast<RenderResourceState>(Entry.Args[1]),
+						static_cast<RenderResourceState>(Entry.Args[2]));
+					break;
+				case RenderCommandType::CopyBufferRegion:
+					Target.CopyBufferRegion(Entry.Args[0], Entry.Wide[0], Entry.Args[1], Entry.Wide[1], Entry.Wide[2]);
+					break;
+				default:
+					Assert(false);
+					break;
+				}
+			}
+		}
+
+		bool Matches(const CallRecorder& Other) const
+		{
+			return mCalls == Other.mCalls && mTargets == Other.mTargets && mViewports.size() == Other.mViewports.size() &&
+				(mViewports.empty() || memcmp(mViewports.data(), Other.mViewports.data(), mViewports.size() * sizeof(RenderViewport)) == 0);
+		}
+
+		uint32_t GetCallCount() const { return static_cast<uint32_t>(mCalls.size()); }
+
+	private:
+		Call& Add(RenderCommandType Type, uint32_t Arg0, uint32_t Arg1 = 0)
+		{
+			Call Entry = {};
+			Entry.Type = Type;
+			Entry.Args[0] = Arg0;
+			Entry.Args[1] = Arg1;
+			mCalls.push_back(Entry);
+			return mCalls.back();
+		}
+
+	private:
+		std::vector<Call> mCalls;
+		std::vector<uint32_t> mSegments;
+		std::vector<RenderViewport> mViewports;
+		std::vector<uint64_t> mTargets;
+	};
+
+	//Counts what it's given, so decoding can't be skipped
+	class CountingCommandList : public IRenderCommandList
+	{
+	public:
+		CountingCommandList() : mCount(0), mSum(0) {}
+
+		void SetPipelineState(uint32_t PipelineState) override { Count(PipelineState); }
+		void SetGraphicsRootSignature(uint32_t RootSignature) override { Count(RootSignature); }
+		void SetGraphicsRootDescriptorTable(uint32_t, uint32_t Table) override { Count(Table); }
+		void SetGraphicsRootShaderResourceView(uint32_t, uint64_t GpuAddress) override { Count(GpuAddress); }
+		void SetMesh(uint32_t Mesh) override { Count(Mesh); }
+		void SetViewport(const RenderViewport&) override { Count(0); }
+		void SetRenderTargets(uint32_t, const uint64_t* RenderTargets, uint64_t) override { Count(RenderTargets[0]); }
+		void DrawIndexedInstanced(uint32_t IndexCountPerInstance, uint32_t, uint32_t StartIndexLocation, int32_t, uint32_t) override
+		{
+			Count(IndexCountPerInstance + StartIndexLocation);
+		}
+		void ResourceBarrier(uint32_t Resource, RenderResourceState, RenderResourceState) override { Count(Resource); }
+		void CopyBufferRegion(uint32_t, uint64_t, uint32_t, uint64_t, uint64_t Size) override { Count(Size); }
+
+		uint64_t GetCount() const { return mCount; }
+		uint64_t GetSum() const { return mSum; }
+
+	private:
+		void Count(uint64_t Value)
+		{
+			++mCount;
+			mSum += Value;
+		}
+
+	private:
+		uint64_t mCount;
+		uint64_t mSum;
+	};
+
+	struct DrawState
+	{
+		uint32_t PipelineState;
+		uint32_t Material;
+		uint32_t Mesh;
+
+		bool operator<(const DrawState& Other) const
+		{
+			if (PipelineState != Other.PipelineState)
+			{
+				return PipelineState < Other.PipelineState;
+			}
+			return Material != Other.Material ? Material < Other.Material : Mesh < Other.Mesh;
+		}
+	};
+
+	//Uploads, then passes of sorted draws. One segment for the uploads and
+	//one for each pass.
+	void MakeFrame(const CommandStreamBenchmarkSettings& Settings, uint32_t DrawCount, CallRecorder& Frame)
+	{
+		std::mt19937 Random(1234);
+		std::uniform_int_distribution<uint32_t> CopySize(1, 256);
+		std::uniform_int_distribution<uint32_t> Material(0, Settings.MaterialCount - 1);
+		std::uniform_int_distribution<uint32_t> Mesh(0, Settings.MeshCount - 1);
+
+		const uint32_t FirstBuffer = FirstRenderTarget + Settings.PassCount;
+
+		Frame.BeginSegment();
+		uint64_t UploadOffset = 0;
+		for (uint32_t Copy = 0; Copy < Settings.CopyCount; ++Copy)
+		{
+			uint64_t Size = CopySize(Random) * 256ull;
+			Frame.ResourceBarrier(FirstBuffer + Copy, RenderResourceState::VertexAndConstantBuffer, RenderResourceState::CopyDest);
+			Frame.CopyBufferRegion(FirstBuffer + Copy, 0, UploadBuffer, UploadOffset, Size);
+			Frame.ResourceBarrier(FirstBuffer + Copy, RenderResourceState::CopyDest, RenderResourceState::VertexAndConstantBuffer);
+			UploadOffset += Size;
+		}
+
+		const RenderViewport Viewport = { 0.0f, 0.0f, 1920.0f, 1080.0f, 0.0f, 1.0f };
+		const uint64_t DepthStencil = 0x80000;
+		const uint32_t StatesPerRootSignature = (Settings.PipelineStateCount + RootSignatureCount - 1) / RootSignatureCount;
+
+		std::vector<DrawState> Draws;
+		uint64_t InstanceData = 0x100000000ull;
+		for (uint32_t Pass = 0; Pass < Settings.PassCount; ++Pass)
+		{
+			Frame.BeginSegment();
+			uint32_t Target = FirstRenderTarget + Pass;
+			uint64_t TargetHandle = 0x10000 + Pass * 64ull;
+			Frame.ResourceBarrier(Target, RenderResourceState::ShaderResource, RenderResourceState::RenderTarget);
+			Frame.SetRenderTargets(1, &TargetHandle, DepthStencil);
+			Frame.SetViewport(Viewport);
+
+			uint32_t PassDraws = DrawCount / Settings.PassCount + (Pass < DrawCount % Settings.PassCount ? 1 : 0);
+			Draws.resize(PassDraws);
+			for (DrawState& Draw : Draws)
+			{
+				Draw.Material = Material(Random);
+				Draw.PipelineState = Draw.Material % Settings.PipelineStateCount;
+				Draw.Mesh = Mesh(Random);
+			}
+			std::sort(Draws.begin(), Draws.end());
+
+			const DrawState* Previous = nullptr;
+			for (const DrawState& Draw : Draws)
+			{
+				uint32_t RootSignature = Draw.PipelineState / StatesPerRootSignature;
+				bool bNewRootSignature = !Previous || RootSignature != Previous->PipelineState / StatesPerRootSignature;
+				if (bNewRootSignature)
+				{
+					Frame.SetGraphicsRootSignature(RootSignature);
+				}
+				if (!Previous || Draw.PipelineState != Previous->PipelineState)
+				{
+					Frame.SetPipelineState(Draw.PipelineState);
+				}
+				if (bNewRootSignature || Draw.Material != Previous->Material)
+				{
+					Frame.SetGraphicsRootDescriptorTable(MaterialRootParameter, Draw.Material);
+				}
+				if (!Previous || Draw.Mesh != Previous->Mesh)
+				{
+					Frame.SetMesh(Draw.Mesh);
+				}
+				Frame.SetGraphicsRootShaderResourceView(InstanceDataRootParameter, InstanceData);
+				Frame.DrawIndexedInstanced(36 + 6 * (Draw.Mesh % 64), 1, Draw.Mesh * 420, static_cast<int32_t>(Draw.Mesh * 1024), 0);
+				InstanceData += 64;
+				Previous = &Draw;
+			}
+
+			Frame.ResourceBarrier(Target, RenderResourceState::RenderTarget, RenderResourceState::ShaderResource);
+		}
+	}
+}
+
+CommandStreamBenchmark::CommandStreamBenchmark(const CommandStreamBenchmarkSettings& Settings)
+	: mSettings(Settings)
+{
+	Assert(mSettings.Frames > 0);
+}
+
+CommandStreamBenchmark::~CommandStreamBenchmark()
+{}
+
+bool CommandStreamBenchmark::Run()
+{
+	mResults.clear();
+	mSizes.clear();
+	for (uint32_t ThreadCount : mSettings.ThreadCounts)
+	{
+		if (ThreadCount < 2)
+		{
+			mLastError = "Thread counts must be at least 2 - one thread is always run";
+			return false;
+		}
+	}
+	if (mSettings.PassCount == 0 || mSettings.PipelineStateCount < RootSignatureCount || mSettings.MaterialCount == 0 ||
+		mSettings.MeshCount == 0)
+	{
+		mLastError = "Pass, material and mesh counts must be above 0, and pipeline states at least 8";
+		return false;
+	}
+
+	for (uint32_t DrawCount : mSettings.DrawCounts)
+	{
+		if (DrawCount == 0 || !RunDrawCount(DrawCount))
+		{
+			if (mLastError.empty())
+			{
+				mLastError = "Draw counts must be above 0";
+			}
+			return false;
+		}
+	}
+	return true;
+}
+
+bool CommandStreamBenchmark::RunDrawCount(uint32_t DrawCount)
+{
+	CallRecorder Frame;
+	MakeFrame(mSettings, DrawCount, Frame);
+	const uint32_t SegmentCount = Frame.GetSegmentCount();
+	const uint64_t Commands = static_cast<uint64_t>(Frame.GetCallCount()) * mSettings.Frames;
+
+	RenderCommandArena Arena;
+	std::vector<std::unique_ptr<RenderCommandStream>> Streams;
+	for (uint32_t Segment = 0; Segment < SegmentCount; ++Segment)
+	{
+		Streams.emplace_back(new RenderCommandStream(&Arena));
+	}
+
+	//Encoding, every stream then the arena reset each frame
+	std::vector<uint32_t> ThreadCounts = mSettings.ThreadCounts;
+	ThreadCounts.insert(ThreadCounts.begin(), 1);
+	uint32_t ArenaPages = 0;
+	for (uint32_t ThreadCount : ThreadCounts)
+	{
+		std::unique_ptr<JobSystem> Jobs;
+		if (ThreadCount > 1)
+		{
+			Jobs.reset(new JobSystem(ThreadCount - 1));
+		}
+
+		auto Encode = [&Frame, &Streams](uint32_t Begin, uint32_t End)
+		{
+			for (uint32_t Segment = Begin; Segment < End; ++Segment)
+			{
+				Streams[Segment]->Reset();
+				Frame.Replay(Segment, *Streams[Segment]);
+			}
+		};
+
+		double Milliseconds = 0.0;
+		for (uint32_t FrameIndex = 0; FrameIndex < mSettings.Frames; ++FrameIndex)
+		{
+			Arena.Reset();
+
+			auto Start = Clock::now();
+			if (Jobs)
+			{
+				Jobs->ParallelFor(SegmentCount, 1, Encode);
+			}
+			else
+			{
+				Encode(0, SegmentCount);
+			}
+			Milliseconds += MillisecondsSince(Start);
+
+			if (FrameIndex == 0 && ThreadCount == 1)
+			{
+				ArenaPages = Arena.GetPageCount();
+			}
+			else if (Arena.GetPageCount() != ArenaPages)
+			{
+				mLastError = "Command arena grew after the first frame with " + std::to_string(DrawCount) + " draws";
+				return false;
+			}
+		}
+		AddResult(DrawCount, ThreadCount > 1 ? "Encode x" + std::to_string(ThreadCount) : "Encode", Milliseconds, Commands);
+	}
+
+	CallRecorder Decoded;
+	for (uint32_t Segment = 0; Segment < SegmentCount; ++Segment)
+	{
+		Decoded.BeginSegment();
+		Streams[Segment]->Replay(Decoded);
+	}
+	if (!Decoded.Matches(Frame))
+	{
+		mLastError = "Decoded commands differ from those encoded with " + std::to_string(DrawCount) + " draws";
+		return false;
+	}
+
+	CountingCommandList Counter;
+	double Milliseconds = 0.0;
+	for (uint32_t FrameIndex = 0; FrameIndex < mSettings.Frames; ++FrameIndex)
+	{
+		auto Start = Clock::now();
+		for (const std::unique_ptr<RenderCommandStream>& Stream : Streams)
+		{
+			Stream->Replay(Counter);
+		}
+		Milliseconds += MillisecondsSince(Start);
+	}
+	Check(Counter.GetCount() == Commands);
+	AddResult(DrawCount, "Decode", Milliseconds, Commands);
+
+	StandInCommandList StandIn;
+	for (uint32_t bDirect = 0; bDirect < 2; ++bDirect)
+	{
+		Milliseconds = 0.0;
+		for (uint32_t FrameIndex = 0; FrameIndex < mSettings.Frames; ++FrameIndex)
+		{
+			StandIn.Reset();
+			auto Start = Clock::now();
+			for (uint32_t Segment = 0; Segment < SegmentCount; ++Segment)
+			{
+				if (bDirect)
+				{
+					Frame.Replay(Segment, StandIn);
+				}
+				else
+				{
+					Streams[Segment]->Replay(StandIn);
+				}
+			}
+			Milliseconds += MillisecondsSince(Start);
+		}
+		AddResult(DrawCount, bDirect ? "Stand-in direct" : "Decode to stand-in", Milliseconds, Commands);
+	}
+
+	CommandStreamBenchmarkSize Size;
+	Size.DrawCount = DrawCount;
+	Size.Commands = Frame.GetCallCount();
+	for (const std::unique_ptr<RenderCommandStream>& Stream : Streams)
+	{
+		Size.StreamBytes += Stream->GetByteSize();
+	}
+	Size.StandInBytes = StandIn.GetRecordedBytes();
+	Size.ArenaPages = Arena.GetPageCount();
+	mSizes.push_back(Size);
+	return true;
+}
+
+void CommandStreamBenchmark::AddResult(uint32_t DrawCount, const std::string& Mode, double Milliseconds, uint64_t Commands)
+{
+	CommandStreamBenchmarkResult Result;
+	Result.DrawCount = DrawCount;
+	Result.Mode = Mode;
+	Result.MillisecondsPerFrame = Milliseconds / mSettings.Frames;
+	Result.CommandsPerMillisecond = Milliseconds > 0.0 ? Commands / Milliseconds : 0.0;
+	mResults.push_back(Result);
+}
+
+bool CommandStreamBenchmark::WriteReport(const char* Filename) const
+{
+	FILE* File = fopen(Filename, "w");
+	if (!File)
+	{
+		return false;
+	}
+
+	fprintf(File, "Frames:          %u\n", mSettings.Frames);
+	fprintf(File, "Passes:          %u\n", mSettings.PassCount);
+	fprintf(File, "Copies:          %u\n", mSettings.CopyCount);
+	fprintf(File, "Pipeline states: %u\n", mSettings.PipelineStateCount);
+	fprintf(File, "Materials:       %u\n", mSettings.MaterialCount);
+	fprintf(File, "Meshes:          %u\n\n", mSettings.MeshCount);
+
+	fprintf(File, "Draws,Mode,MsPerFrame,CommandsPerMs\n");
+	for (const CommandStreamBenchmarkResult& Result : mResults)
+	{
+		fprintf(File, "%u,%s,%.3f,%.1f\n", Result.DrawCount, Result.Mode.c_str(), Result.MillisecondsPerFrame, Result.CommandsPerMillisecond);
+	}
+
+	fprintf(File, "\nDraws,Commands,StreamBytes,BytesPerCommand,StandInBytes,ArenaPages\n");
+	for (const CommandStreamBenchmarkSize& Size : mSizes)
+	{
+		fprintf(File, "%u,%u,%llu,%.2f,%llu,%u\n", Size.DrawCount, Size.Commands, static_cast<unsigned long long>(Size.StreamBytes),
+			Size.Commands > 0 ? static_cast<double>(Size.StreamBytes) / Size.Commands : 0.0,
+			static_cast<unsigned long long>(Size.StandInBytes), Size.ArenaPages);
+	}
+
+	fclose(File);
+	return true;
+}
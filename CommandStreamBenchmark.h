@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//Encode and decode throughput of RenderCommandStream for each of DrawCounts
+//draws a frame.
+//
+//A frame starts with CopyCount buffer uploads, then PassCount passes, each
+//with its barriers, render targets and viewport, then draws in sort order.
+//The frame's calls are generated once and replayed each frame. Encoding
+//writes one stream per pass, on one thread and split across each of
+//ThreadCounts threads, all sharing one arena. Decoding replays the streams
+//in to a list that only counts them, and in to a recording stand-in, which
+//is also timed recording the calls directly for reference.
+//Run() fails if decoding doesn't give back every call exactly, or the arena
+//grows after the first frame.
+struct CommandStreamBenchmarkSettings
+{
+	std::vector<uint32_t> DrawCounts = { 10000, 100000 };
+	std::vector<uint32_t> ThreadCounts = { 2, 4, 8 };
+	uint32_t Frames = 20;
+	uint32_t PassCount = 8;
+	uint32_t CopyCount = 256;
+	uint32_t PipelineStateCount = 64;
+	uint32_t MaterialCount = 1024;
+	uint32_t MeshCount = 256;
+};
+
+struct CommandStreamBenchmarkResult
+{
+	uint32_t DrawCount = 0;
+	std::string Mode;
+	double MillisecondsPerFrame = 0.0;
+	double CommandsPerMillisecond = 0.0;
+};
+
+struct CommandStreamBenchmarkSize
+{
+	uint32_t DrawCount = 0;
+	uint32_t Commands = 0;			//Per frame
+	uint64_t StreamBytes = 0;
+	uint64_t StandInBytes = 0;		//Fixed layout records, for comparison
+	uint32_t ArenaPages = 0;
+};
+
+class CommandStreamBenchmark
+{
+public:
+	CommandStreamBenchmark(const CommandStreamBenchmarkSettings& Settings);
+	~CommandStreamBenchmark();
+
+	bool Run();
+	bool WriteReport(const char* Filename) const;
+
+	const std::string& GetLastError() const { return mLastError; }
+
+private:
+	bool RunDrawCount(uint32_t DrawCount);
+
+	void AddResult(uint32_t DrawCount, const std::string& Mode, double Milliseconds, uint64_t Commands);
+
+private:
+	CommandStreamBenchmarkSettings mSettings;
+	std::vector<CommandStreamBenchmarkResult> mResults;
+	std::vector<CommandStreamBenchmarkSize> mSizes;
+
+	std::string mLastError;
+};
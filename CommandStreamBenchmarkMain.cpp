@@ -0,0 +1,79 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CommandStreamBenchmark.h"
+
+//Command stream benchmark:
+//	CommandStreamBenchmark [-frames N] [-draws N ...] [-threads N ...] [-passes N] [-copies N] [-states N] [-materials N] [-meshes N]
+//Writes CommandStreamBenchmark.txt to the current directory.
+int main(int argc, char** argv)
+{
+	CommandStreamBenchmarkSettings Settings;
+	bool bCustomDraws = false;
+	bool bCustomThreads = false;
+	bool bValid = true;
+	for (int i = 1; i < argc && bValid; ++i)
+	{
+		if (strcmp(argv[i], "-frames") == 0 && i + 1 < argc)
+		{
+			Settings.Frames = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-draws") == 0 && i + 1 < argc)
+		{
+			if (!bCustomDraws)
+			{
+				Settings.DrawCounts.clear();
+				bCustomDraws = true;
+			}
+			Settings.DrawCounts.push_back(static_cast<uint32_t>(atoi(argv[++i])));
+		}
+		else if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc)
+		{
+			if (!bCustomThreads)
+			{
+				Settings.ThreadCounts.clear();
+				bCustomThreads = true;
+			}
+			Settings.ThreadCounts.push_back(static_cast<uint32_t>(atoi(argv[++i])));
+		}
+		else if (strcmp(argv[i], "-passes") == 0 && i + 1 < argc)
+		{
+			Settings.PassCount = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-copies") == 0 && i + 1 < argc)
+		{
+			Settings.CopyCount = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-states") == 0 && i + 1 < argc)
+		{
+			Settings.PipelineStateCount = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-materials") == 0 && i + 1 < argc)
+		{
+			Settings.MaterialCount = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-meshes") == 0 && i + 1 < argc)
+		{
+			Settings.MeshCount = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else
+		{
+			bValid = false;
+		}
+	}
+
+	if (!bValid || Settings.Frames == 0)
+	{
+		fprintf(stderr, "Usage: CommandStreamBenchmark [-frames N] [-draws N ...] [-threads N ...] [-passes N] [-copies N] [-states N] [-materials N] [-meshes N]\n");
+		return 1;
+	}
+
+	CommandStreamBenchmark Benchmark(Settings);
+	if (!Benchmark.Run())
+	{
+		fprintf(stderr, "%s\n", Benchmark.GetLastError().c_str());
+		return 1;
+	}
+	return Benchmark.WriteReport("CommandStreamBenchmark.txt") ? 0 : 1;
+}
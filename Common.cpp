@@ -0,0 +1,20 @@
+#include "Common.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <stdio.h>
+#else
+#include <stdio.h>
+#endif
+
+void ReportCheckFailure(const char* Expression, const char* Title, const char* File, int Line)
+{
+#if defined(_WIN32)
+	char Message[1024];
+	_snprintf_s(Message, sizeof(Message), _TRUNCATE, "%s\n\n%s(%d)", Expression, File, Line);
+	MessageBoxA(0, Message, Title, MB_OK);
+#else
+	fprintf(stderr, "%s: %s (%s:%d)\n", Title, Expression, File, Line);
+	fflush(stderr);
+#endif
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+
+//Shared assert/check macros. On Windows a failure raises a message box and breaks
+//into the debugger (as WinMain always did), on other platforms (tools, headless
+//simulation runs) the failure is printed to stderr before trapping.
+void ReportCheckFailure(const char* Expression, const char* Title, const char* File, int Line);
+
+#if defined(_MSC_VER)
+#define DebugBreakHere() __debugbreak()
+#else
+#define DebugBreakHere() __builtin_trap()
+#endif
+
+#define Assert(x) \
+	if (!(x)) { ReportCheckFailure(#x, "Assert Failed", __FILE__, __LINE__); DebugBreakHere(); }
+
+#define Check(x) \
+	if (!(x)) { ReportCheckFailure(#x, "Check Failed", __FILE__, __LINE__); DebugBreakHere(); }
+
+#define CheckHResult(HResult) \
+	Check(SUCCEEDED(HResult))
+
+#define RIID(x) \
+	IID_PPV_ARGS(x)
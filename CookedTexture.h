@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+
+//Runtime texture written by the asset cooker: header followed by every mip,
+//largest first, rows tightly packed.
+const uint32_t CookedTextureMagic = 0x58455443;		//"CTEX"
+const uint32_t CookedTextureVersion = 1;
+const uint32_t CookedTextureMaxMips = 16;
+
+struct CookedTextureHeader
+{
+	uint32_t Magic;
+	uint32_t Version;
+	uint32_t Width;
+	uint32_t Height;
+	uint32_t MipCount;
+	uint32_t Format;			//DXGI_FORMAT
+	uint32_t BytesPerPixel;
+	uint32_t Padding;
+	uint64_t MipOffsets[CookedTextureMaxMips];	//From the start of the file
+};
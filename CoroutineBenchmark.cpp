@@ -0,0 +1,432 @@
+#include "CoroutineBenchmark.h"
+#include "AsyncAwaitables.h"
+#include "Common.h"
+#include "FileUtils.h"
+#include "ObjMeshConverter.h"
+#include "PackedMesh.h"
+#include "SimulatedFence.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdio.h>
+#include <thread>
+
+namespace
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	double MillisecondsSince(Clock::time_point Start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - Start).count();
+	}
+
+	//Pumps until Task finishes, yielding when there was nothing to resume so
+	//worker threads get a look in
+	template<typename T>
+	void PumpUntilDone(CoroutineScheduler& Scheduler, AsyncTask<T>& Task)
+	{
+		Task.Start();
+		while (!Task.IsDone())
+		{
+			if (Scheduler.Pump() == 0)
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	AsyncTask<uint32_t> Immediate(uint32_t Value)
+	{
+		co_return Value;
+	}
+
+	AsyncTask<uint64_t> AwaitImmediateLoop(uint32_t Count)
+	{
+		uint64_t Sum = 0;
+		for (uint32_t i = 0; i < Count; ++i)
+		{
+			Sum += co_await Immediate(i);
+		}
+		co_return Sum;
+	}
+
+	AsyncTask<void> YieldLoop(CoroutineScheduler& Scheduler, uint32_t Count)
+	{
+		for (uint32_t i = 0; i < Count; ++i)
+		{
+			co_await YieldFrame(Scheduler);
+		}
+	}
+
+	AsyncTask<void> FenceLoop(CoroutineScheduler& Scheduler, SimulatedFence& Fence, uint32_t Count)
+	{
+		for (uint32_t i = 0; i < Count; ++i)
+		{
+			co_await WaitForFenceAsync(Scheduler, Fence, Fence.Signal());
+		}
+	}
+
+	AsyncTask<void> FenceWaiter(CoroutineScheduler& Scheduler, const IFence& Fence, uint64_t Value, uint32_t Count)
+	{
+		for (uint32_t i = 0; i < Count; ++i)
+		{
+			co_await WaitForFenceAsync(Scheduler, Fence, Value + i);
+		}
+	}
+
+	AsyncTask<uint64_t> JobLoop(CoroutineScheduler& Scheduler, JobSystem& Jobs, uint32_t Count)
+	{
+		uint64_t Sum = 0;
+		for (uint32_t i = 0; i < Count; ++i)
+		{
+			Sum += co_await RunJobAsync(Jobs, Scheduler, [i]() { return static_cast<uint64_t>(i); });
+		}
+		co_return Sum;
+	}
+
+	AsyncTask<bool> ReadLoop(CoroutineScheduler& Scheduler, AsyncIOQueue& Queue, AsyncFileHandle File, uint32_t Count)
+	{
+		uint8_t Buffer[4096];
+		for (uint32_t i = 0; i < Count; ++i)
+		{
+			AsyncReadResult Result = co_await ReadFileAsync(Queue, Scheduler, File, (i % 16) * sizeof(Buffer), sizeof(Buffer), Buffer);
+			if (!Result.bSucceeded)
+			{
+				co_return false;
+			}
+		}
+		co_return true;
+	}
+
+	//Records the state of the fence when the coroutine resumed
+	struct FenceResume
+	{
+		uint32_t Waiter;
+		uint64_t Value;
+		uint64_t CompletedAtResume;
+		bool bSuspended;
+	};
+
+	AsyncTask<void> RecordFenceWait(CoroutineScheduler& Scheduler, const IFence& Fence, uint32_t Waiter, uint64_t Value,
+		std::vector<FenceResume>& OutResumes)
+	{
+		FenceAwaitable Wait = WaitForFenceAsync(Scheduler, Fence, Value);
+		bool bSuspended = !Wait.await_ready();
+		co_await Wait;
+		OutResumes.push_back({ Waiter, Value, Fence.GetCompletedValue(), bSuspended });
+	}
+
+	//Typical multi step load: read the file, validate it on a worker, "upload"
+	//and wait for the upload's fence before using it
+	AsyncTask<bool> LoadMesh(AsyncLoadContext Context, SimulatedFence& UploadFence, std::string Filename,
+		std::vector<uint8_t>& FileData, PackedMesh& Mesh, uint64_t& OutUploadValue)
+	{
+		if (!co_await LoadFileAsync(Context, Filename, FileData))
+		{
+			co_return false;
+		}
+
+		bool bValid = co_await RunJobAsync(*Context.Jobs, *Context.Scheduler, [&FileData, &Mesh]()
+		{
+			return Mesh.LoadFromMemory(FileData.data(), FileData.size());
+		});
+		if (!bValid)
+		{
+			co_return false;
+		}
+
+		OutUploadValue = UploadFence.Signal();
+		co_await WaitForFenceAsync(*Context.Scheduler, UploadFence, OutUploadValue);
+		co_return UploadFence.IsComplete(OutUploadValue);
+	}
+}
+
+CoroutineBenchmark::CoroutineBenchmark(const CoroutineBenchmarkSettings& Settings)
+	: mSettings(Settings)
+{
+	Assert(mSettings.Iterations > 0 && mSettings.ConcurrentTasks > 0);
+}
+
+CoroutineBenchmark::~CoroutineBenchmark()
+{}
+
+bool CoroutineBenchmark::Run()
+{
+	mResults.clear();
+	mChecks.clear();
+
+	if (!CheckFenceOrdering() || !CheckLoader())
+	{
+		return false;
+	}
+
+	CoroutineScheduler Scheduler;
+	uint32_t Iterations = mSettings.Iterations;
+
+	//Synchronous await of a finished child - the floor for any await
+	{
+		Clock::time_point Start = Clock::now();
+		AsyncTask<uint64_t> Task = AwaitImmediateLoop(Iterations);
+		PumpUntilDone(Scheduler, Task);
+		AddResult("TaskAwait", Iterations, MillisecondsSince(Start));
+		Check(Task.GetResult() == static_cast<uint64_t>(Iterations) * (Iterations - 1) / 2);
+	}
+
+	//Post + Pump round trip
+	{
+		Clock::time_point Start = Clock::now();
+		AsyncTask<void> Task = YieldLoop(Scheduler, Iterations);
+		PumpUntilDone(Scheduler, Task);
+		AddResult("YieldFrame", Iterations, MillisecondsSince(Start));
+	}
+
+	//One coroutine waiting on one fence value after another, the "GPU"
+	//catching up after every pump
+	{
+		SimulatedFence Fence;
+		Clock::time_point Start = Clock::now();
+		AsyncTask<void> Task = FenceLoop(Scheduler, Fence, Iterations);
+		Task.Start();
+		while (!Task.IsDone())
+		{
+			Fence.AdvanceTo(Fence.GetLastSignalledValue());
+			Scheduler.Pump();
+		}
+		AddResult("FenceAwait", Iterations, MillisecondsSince(Start));
+	}
+
+	//Many coroutines waiting on the same fence - per wait polling cost
+	{
+		SimulatedFence Fence;
+		uint32_t WaitsPerTask = std::max(Iterations / mSettings.ConcurrentTasks, 1u);
+		for (uint32_t i = 0; i < WaitsPerTask; ++i)
+		{
+			Fence.Signal();
+		}
+
+		Clock::time_point Start = Clock::now();
+		for (uint32_t TaskIdx = 0; TaskIdx < mSettings.ConcurrentTasks; ++TaskIdx)
+		{
+			Scheduler.Spawn(FenceWaiter(Scheduler, Fence, 1, WaitsPerTask));
+		}
+		while (Scheduler.GetRunningTaskCount() > 0)
+		{
+			Fence.AdvanceTo(Fence.GetCompletedValue() + 1);
+			Scheduler.Pump();
+		}
+		AddResult("FenceAwaitConcurrent", WaitsPerTask * mSettings.ConcurrentTasks, MillisecondsSince(Start));
+	}
+
+	//Worker round trip: submit, run, post back, resume
+	{
+		JobSystem Jobs(mSettings.ThreadCount);
+		uint32_t JobIterations = std::max(Iterations / 10, 1u);
+
+		Clock::time_point Start = Clock::now();
+		AsyncTask<uint64_t> Task = JobLoop(Scheduler, Jobs, JobIterations);
+		PumpUntilDone(Scheduler, Task);
+		AddResult("JobAwait", JobIterations, MillisecondsSince(Start));
+		Check(Task.GetResult() == static_cast<uint64_t>(JobIterations) * (JobIterations - 1) / 2);
+	}
+
+	//I/O round trip for a cached 4KB read
+	{
+		std::string Filename = JoinPath(mSettings.WorkingDirectory, "CoroutineBenchmark.bin");
+		std::vector<uint8_t> Data(16 * 4096, 0xCD);
+		if (!WriteWholeFile(Filename, Data.data(), Data.size()))
+		{
+			mLastError = "Couldn't write " + Filename;
+			return false;
+		}
+
+		AsyncIOQueue Queue;
+		AsyncFileHandle File = AsyncIOQueue::OpenFile(Filename.c_str());
+		if (File == InvalidAsyncFileHandle)
+		{
+			mLastError = "Couldn't open " + Filename;
+			return false;
+		}
+
+		uint32_t ReadIterations = std::max(Iterations / 10, 1u);
+		Clock::time_point Start = Clock::now();
+		AsyncTask<bool> Task = ReadLoop(Scheduler, Queue, File, ReadIterations);
+		PumpUntilDone(Scheduler, Task);
+		double Milliseconds = MillisecondsSince(Start);
+		AsyncIOQueue::CloseFile(File);
+
+		if (!Task.GetResult())
+		{
+			mLastError = "Benchmark reads failed";
+			return false;
+		}
+		AddResult(("FileRead (" + std::string(Queue.GetBackendName()) + ")").c_str(), ReadIterations, Milliseconds);
+	}
+
+	return true;
+}
+
+bool CoroutineBenchmark::CheckFenceOrdering()
+{
+	CoroutineScheduler Scheduler;
+	SimulatedFence Fence;
+
+	const uint32_t WaiterCount = 64;
+	const uint64_t MaxValue = 16;
+	for (uint64_t i = 0; i < MaxValue; ++i)
+	{
+		Fence.Signal();
+	}
+	Fence.AdvanceTo(2);
+
+	//Waiter N waits on value (N * 7) % MaxValue + 1, so waits go in out of
+	//order and several share a value. Values 1 and 2 are already complete.
+	std::vector<FenceResume> Resumes;
+	for (uint32_t Waiter = 0; Waiter < WaiterCount; ++Waiter)
+	{
+		uint64_t Value = (Waiter * 7) % MaxValue + 1;
+		Scheduler.Spawn(RecordFenceWait(Scheduler, Fence, Waiter, Value, Resumes));
+	}
+
+	//Already complete values must not have suspended at all
+	uint32_t ImmediateCount = 0;
+	for (const FenceResume& Resume : Resumes)
+	{
+		ImmediateCount += Resume.bSuspended ? 0 : 1;
+	}
+
+	//Pumping without progress resumes nothing
+	size_t ResumedBeforeProgress = Resumes.size();
+	Scheduler.Pump();
+	Scheduler.Pump();
+	bool bNoEarlyResume = Resumes.size() == ResumedBeforeProgress;
+
+	for (uint64_t Value = Fence.GetCompletedValue() + 1; Value <= MaxValue; ++Value)
+	{
+		Fence.AdvanceTo(Value);
+		Scheduler.Pump();
+	}
+
+	bool bAllResumed = Resumes.size() == WaiterCount && Scheduler.GetFenceWaitCount() == 0 && Scheduler.GetRunningTaskCount() == 0;
+
+	//Every suspended waiter resumed on the pump right after its value
+	//completed, and waits on the same value resumed in the order made
+	bool bInOrder = true;
+	for (size_t i = 0; i < Resumes.size(); ++i)
+	{
+		const FenceResume& Resume = Resumes[i];
+		if (Resume.bSuspended ? Resume.CompletedAtResume != Resume.Value : Resume.Value > 2)
+		{
+			bInOrder = false;
+		}
+		if (i > 0 && Resume.bSuspended && Resumes[i - 1].bSuspended &&
+			(Resumes[i - 1].Value > Resume.Value || (Resumes[i - 1].Value == Resume.Value && Resumes[i - 1].Waiter > Resume.Waiter)))
+		{
+			bInOrder = false;
+		}
+	}
+
+	if (ImmediateCount != WaiterCount / MaxValue * 2 || !bNoEarlyResume || !bAllResumed || !bInOrder)
+	{
+		mLastError = "Fence ordering check failed";
+		return false;
+	}
+
+	mChecks.push_back("FenceOrdering: passed (" + std::to_string(WaiterCount) + " waiters, " +
+		std::to_string(ImmediateCount) + " already complete)");
+	return true;
+}
+
+bool CoroutineBenchmark::CheckLoader()
+{
+	//Small two LOD cube mesh written through the converter
+	static const char* CubeObj =
+		"v -1 -1 -1\nv 1 -1 -1\nv 1 1 -1\nv -1 1 -1\nv -1 -1 1\nv 1 -1 1\nv 1 1 1\nv -1 1 1\n"
+		"f 1 2 3 4\nf 5 8 7 6\nf 1 5 6 2\nf 2 6 7 3\nf 3 7 8 4\nf 5 1 4 8\n";
+
+	std::string Filename = JoinPath(mSettings.WorkingDirectory, "CoroutineBenchmark.mesh");
+	ObjMeshConverter Converter;
+	if (!Converter.AddLodFromMemory("Cube", CubeObj, 1.0f) || !Converter.AddLodFromMemory("Cube", CubeObj, 0.5f) ||
+		!Converter.Write(Filename.c_str(), false))
+	{
+		mLastError = "Couldn't write " + Filename;
+		return false;
+	}
+
+	CoroutineScheduler Scheduler;
+	AsyncIOQueue IOQueue;
+	JobSystem Jobs(mSettings.ThreadCount);
+	SimulatedFence UploadFence;
+
+	AsyncLoadContext Context;
+	Context.Scheduler = &Scheduler;
+	Context.IOQueue = &IOQueue;
+	Context.Jobs = &Jobs;
+
+	std::vector<uint8_t> FileData;
+	PackedMesh Mesh;
+	uint64_t UploadValue = 0;
+	AsyncTask<bool> Task = LoadMesh(Context, UploadFence, Filename, FileData, Mesh, UploadValue);
+	Task.Start();
+
+	//Hold the "GPU" back for a few pumps once the upload is signalled to
+	//check the loader really waits for it
+	uint32_t PumpsWhileUploading = 0;
+	while (!Task.IsDone())
+	{
+		if (UploadValue != 0 && ++PumpsWhileUploading > 4)
+		{
+			UploadFence.AdvanceTo(UploadValue);
+		}
+		if (Scheduler.Pump() == 0)
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	if (!Task.GetResult() || !Mesh.IsLoaded() || Mesh.GetHeader().LodCount != 2 || PumpsWhileUploading <= 4 ||
+		UploadFence.GetStallCount() != 0)
+	{
+		mLastError = "Loader check failed";
+		return false;
+	}
+
+	mChecks.push_back("Loader: passed (read, validate on worker, upload fence wait of " +
+		std::to_string(FileData.size()) + " byte mesh)");
+	return true;
+}
+
+void CoroutineBenchmark::AddResult(const char* Scenario, uint32_t Awaits, double Milliseconds)
+{
+	CoroutineBenchmarkResult Result;
+	Result.Scenario = Scenario;
+	Result.Awaits = Awaits;
+	Result.Milliseconds = Milliseconds;
+	Result.AwaitsPerSecond = Awaits / (Milliseconds / 1000.0);
+	Result.NanosecondsPerAwait = Milliseconds * 1000000.0 / Awaits;
+	mResults.push_back(Result);
+}
+
+bool CoroutineBenchmark::WriteReport(const char* Filename) const
+{
+	FILE* File = fopen(Filename, "w");
+	if (!File)
+	{
+		return false;
+	}
+
+	for (const std::string& CheckResult : mChecks)
+	{
+		fprintf(File, "%s\n", CheckResult.c_str());
+	}
+
+	fprintf(File, "\nScenario,Awaits,Ms,AwaitsPerSecond,NsPerAwait\n");
+	for (const CoroutineBenchmarkResult& Result : mResults)
+	{
+		fprintf(File, "%s,%u,%.3f,%.0f,%.1f\n", Result.Scenario.c_str(), Result.Awaits, Result.Milliseconds,
+			Result.AwaitsPerSecond, Result.NanosecondsPerAwait);
+	}
+
+	fclose(File);
+	return true;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//Scheduling overhead of the coroutine loading API, as awaits per second:
+//awaiting a task that completes immediately, yielding a frame, fence waits
+//on a SimulatedFence (one coroutine, and many at once), job round trips and
+//small file reads through the AsyncIOQueue.
+//
+//Also checks the scheduler's behaviour against a SimulatedFence - that fence
+//waits resume in order, never before their value completes and not at all if
+//it already had - and runs a full read/parse/upload-wait loader. Run()
+//fails if any check does.
+struct CoroutineBenchmarkSettings
+{
+	std::string WorkingDirectory = ".";
+	uint32_t Iterations = 100000;
+	uint32_t ConcurrentTasks = 1024;
+	uint32_t ThreadCount = 0;
+};
+
+struct CoroutineBenchmarkResult
+{
+	std::string Scenario;
+	uint32_t Awaits = 0;
+	double Milliseconds = 0.0;
+	double AwaitsPerSecond = 0.0;
+	double NanosecondsPerAwait = 0.0;
+};
+
+class CoroutineBenchmark
+{
+public:
+	CoroutineBenchmark(const CoroutineBenchmarkSettings& Settings);
+	~CoroutineBenchmark();
+
+	bool Run();
+	bool WriteReport(const char* Filename) const;
+
+	const std::string& GetLastError() const { return mLastError; }
+
+private:
+	bool CheckFenceOrdering();
+	bool CheckLoader();
+
+	void AddResult(const char* Scenario, uint32_t Awaits, double Milliseconds);
+
+private:
+	CoroutineBenchmarkSettings mSettings;
+	std::vector<CoroutineBenchmarkResult> mResults;
+	std::vector<std::string> mChecks;
+	std::string mLastError;
+};
@@ -0,0 +1,93 @@
+#include "CoroutineScheduler.h"
+#include "Common.h"
+#include "IFence.h"
+
+CoroutineScheduler::CoroutineScheduler()
+{}
+
+CoroutineScheduler::~CoroutineScheduler()
+{
+	//Destroying a suspended task frees its frame, but whatever it is waiting
+	//on would still resume it - everything must have finished
+	Assert(mTasks.empty());
+	Assert(mPosted.empty());
+	Assert(mFenceWaits.empty());
+}
+
+void CoroutineScheduler::Spawn(AsyncTask<void> Task)
+{
+	Task.Start();
+	if (!Task.IsDone())
+	{
+		mTasks.push_back(std::move(Task));
+	}
+}
+
+void CoroutineScheduler::Post(CoroutineStd::coroutine_handle<> Handle)
+{
+	std::lock_guard<std::mutex> Lock(mPostMutex);
+	mPosted.push_back(Handle);
+}
+
+void CoroutineScheduler::WaitForFence(const IFence& Fence, uint64_t Value, CoroutineStd::coroutine_handle<> Handle)
+{
+	FenceWait Wait;
+	Wait.Fence = &Fence;
+	Wait.Value = Value;
+	Wait.Handle = Handle;
+	mFenceWaits.push_back(Wait);
+}
+
+uint32_t CoroutineScheduler::Pump()
+{
+	uint32_t ResumedCount = 0;
+
+	{
+		std::lock_guard<std::mutex> Lock(mPostMutex);
+		mResuming.swap(mPosted);
+	}
+	for (CoroutineStd::coroutine_handle<> Handle : mResuming)
+	{
+		Handle.resume();
+	}
+	ResumedCount += static_cast<uint32_t>(mResuming.size());
+	mResuming.clear();
+
+	//Take the ready waits out first - resuming can add new ones. Keeps the
+	//order waits were made in.
+	size_t Kept = 0;
+	for (size_t WaitIdx = 0; WaitIdx < mFenceWaits.size(); ++WaitIdx)
+	{
+		if (mFenceWaits[WaitIdx].Fence->IsComplete(mFenceWaits[WaitIdx].Value))
+		{
+			mFenceReady.push_back(mFenceWaits[WaitIdx].Handle);
+		}
+		else
+		{
+			mFenceWaits[Kept++] = mFenceWaits[WaitIdx];
+		}
+	}
+	mFenceWaits.resize(Kept);
+
+	for (size_t ReadyIdx = 0; ReadyIdx < mFenceReady.size(); ++ReadyIdx)
+	{
+		mFenceReady[ReadyIdx].resume();
+	}
+	ResumedCount += static_cast<uint32_t>(mFenceReady.size());
+	mFenceReady.clear();
+
+	for (size_t TaskIdx = 0; TaskIdx < mTasks.size();)
+	{
+		if (mTasks[TaskIdx].IsDone())
+		{
+			mTasks[TaskIdx] = std::move(mTasks.back());
+			mTasks.pop_back();
+		}
+		else
+		{
+			++TaskIdx;
+		}
+	}
+
+	return ResumedCount;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "AsyncTask.h"
+
+class IFence;
+
+//Resumes coroutines on the thread that calls Pump() (the main thread, once a
+//frame). Awaitables that complete elsewhere - I/O completion, job workers -
+//Post() their coroutine here rather than resuming it on their own thread, so
+//loader code always runs on the main thread between frames and never blocks
+//it. Fence waits are polled each Pump() rather than blocking on an event.
+class CoroutineScheduler
+{
+public:
+	CoroutineScheduler();
+	~CoroutineScheduler();
+
+	//Starts Task now (it runs up to its first suspension) and keeps it alive
+	//until it finishes. Scheduler thread only.
+	void Spawn(AsyncTask<void> Task);
+
+	//Thread safe. Handle resumes during the next Pump().
+	void Post(CoroutineStd::coroutine_handle<> Handle);
+
+	//Handle resumes during the first Pump() after Fence reaches Value.
+	//Scheduler thread only.
+	void WaitForFence(const IFence& Fence, uint64_t Value, CoroutineStd::coroutine_handle<> Handle);
+
+	//Resumes everything posted before the call and every fence wait that has
+	//completed, then frees finished spawned tasks. Returns how many coroutines
+	//were resumed. Anything posted while pumping waits for the next call.
+	uint32_t Pump();
+
+	//Spawned tasks still running (whatever they're waiting on).
+	uint32_t GetRunningTaskCount() const { return static_cast<uint32_t>(mTasks.size()); }
+	uint32_t GetFenceWaitCount() const { return static_cast<uint32_t>(mFenceWaits.size()); }
+
+private:
+	struct FenceWait
+	{
+		const IFence* Fence;
+		uint64_t Value;
+		CoroutineStd::coroutine_handle<> Handle;
+	};
+
+	CoroutineScheduler(const CoroutineScheduler&) = delete;
+	CoroutineScheduler& operator=(const CoroutineScheduler&) = delete;
+
+private:
+	std::mutex mPostMutex;
+	std::vector<CoroutineStd::coroutine_handle<>> mPosted;
+	std::vector<CoroutineStd::coroutine_handle<>> mResuming;	//Swapped with mPosted each Pump
+
+	std::vector<FenceWait> mFenceWaits;
+	std::vector<CoroutineStd::coroutine_handle<>> mFenceReady;
+
+	std::vector<AsyncTask<void>> mTasks;
+};
@@ -0,0 +1,225 @@
+#include "CullingBenchmark.h"
+#include "Common.h"
+#include "FrustumCuller.h"
+#include "JobSystem.h"
+#include "VectorMath.h"
+
+#include <chrono>
+#include <memory>
+#include <random>
+#include <stdio.h>
+
+namespace
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	double MillisecondsSince(Clock::time_point Start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - Start).count();
+	}
+
+	const float WorldSize = 1000.0f;
+
+	//Camera at the origin, a full turn over the run
+	Frustum MakeView(uint32_t Pass, uint32_t PassCount)
+	{
+		float Angle = 6.2831853f * static_cast<float>(Pass) / static_cast<float>(PassCount);
+		Float3 Eye = MakeFloat3(0.0f, 0.0f, 0.0f);
+		Float3 Target = MakeFloat3(sinf(Angle), 0.2f, cosf(Angle));
+		Matrix4x4 View = MatrixLookAtLH(Eye, Target, MakeFloat3(0.0f, 1.0f, 0.0f));
+		Matrix4x4 Projection = MatrixPerspectiveFovLH(1.0472f, 16.0f / 9.0f, 0.1f, WorldSize);
+		return FrustumFromViewProjection(Multiply(Projection, View));
+	}
+
+	//Closest any plane comes to deciding the box the other way
+	bool IsBorderline(const Frustum& View, const Aabb& Box)
+	{
+		Float3 Centre = (Box.Min + Box.Max) * 0.5f;
+		Float3 Extents = (Box.Max - Box.Min) * 0.5f;
+		for (const Plane& Side : View.Planes)
+		{
+			float Distance = Dot(Side.Normal, Centre) + Side.Distance;
+			float Radius = fabsf(Side.Normal.X) * Extents.X + fabsf(Side.Normal.Y) * Extents.Y + fabsf(Side.Normal.Z) * Extents.Z;
+			if (fabsf(Distance + Radius) <= 1e-3f)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	//Both sorted. True if they only differ by borderline boxes.
+	bool VisibleListsMatch(const Frustum& View, const std::vector<Aabb>& Boxes, const std::vector<uint32_t>& Expected,
+		const std::vector<uint32_t>& Actual)
+	{
+		size_t i = 0, j = 0;
+		while (i < Expected.size() || j < Actual.size())
+		{
+			if (i < Expected.size() && j < Actual.size() && Expected[i] == Actual[j])
+			{
+				++i;
+				++j;
+				continue;
+			}
+
+			bool bTakeExpected = j == Actual.size() || (i < Expected.size() && Expected[i] < Actual[j]);
+			uint32_t Object = bTakeExpected ? Expected[i++] : Actual[j++];
+			if (!IsBorderline(View, Boxes[Object]))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+CullingBenchmark::CullingBenchmark(const CullingBenchmarkSettings& Settings)
+	: mSettings(Settings)
+{
+	Assert(mSettings.Iterations > 0);
+}
+
+CullingBenchmark::~CullingBenchmark()
+{}
+
+bool CullingBenchmark::Run()
+{
+	mResults.clear();
+	for (uint32_t ThreadCount : mSettings.ThreadCounts)
+	{
+		if (ThreadCount < 2)
+		{
+			mLastError = "Thread counts must be at least 2 - one thread is always run";
+			return false;
+		}
+	}
+
+	for (uint32_t ObjectCount : mSettings.ObjectCounts)
+	{
+		if (ObjectCount == 0 || !RunObjectCount(ObjectCount))
+		{
+			if (mLastError.empty())
+			{
+				mLastError = "Object counts must be above 0";
+			}
+			return false;
+		}
+	}
+	return true;
+}
+
+bool CullingBenchmark::RunObjectCount(uint32_t ObjectCount)
+{
+	std::mt19937 Random(1234);
+	std::uniform_real_distribution<float> Position(-WorldSize, WorldSize);
+	std::uniform_real_distribution<float> Size(0.5f, 20.0f);
+
+	std::vector<Aabb> Boxes(ObjectCount);
+	FrustumCuller Culler;
+	Culler.Reserve(ObjectCount);
+	for (uint32_t i = 0; i < ObjectCount; ++i)
+	{
+		Boxes[i].Min = MakeFloat3(Position(Random), Position(Random), Position(Random));
+		Boxes[i].Max = Boxes[i].Min + MakeFloat3(Size(Random), Size(Random), Size(Random));
+		Culler.AddObject(Boxes[i]);
+	}
+
+	//AoS, keeping every pass's list to check the others against
+	std::vector<std::vector<uint32_t>> Expected(mSettings.Iterations);
+	for (std::vector<uint32_t>& List : Expected)
+	{
+		List.reserve(ObjectCount);
+	}
+
+	double Milliseconds = 0.0;
+	uint64_t Visible = 0;
+	for (uint32_t Pass = 0; Pass < mSettings.Iterations; ++Pass)
+	{
+		Frustum View = MakeView(Pass, mSettings.Iterations);
+		std::vector<uint32_t>& List = Expected[Pass];
+
+		auto Start = Clock::now();
+		for (uint32_t i = 0; i < ObjectCount; ++i)
+		{
+			if (IsAabbInFrustum(View, Boxes[i]))
+			{
+				List.push_back(i);
+			}
+		}
+		Milliseconds += MillisecondsSince(Start);
+		Visible += List.size();
+	}
+	AddResult(ObjectCount, "AoS", Milliseconds, Visible);
+
+	//Culler, on this thread then across each thread count
+	std::vector<uint32_t> ThreadCounts = mSettings.ThreadCounts;
+	ThreadCounts.insert(ThreadCounts.begin(), 1);
+
+	std::vector<uint32_t> VisibleList;
+	for (uint32_t ThreadCount : ThreadCounts)
+	{
+		std::unique_ptr<JobSystem> Jobs;
+		if (ThreadCount > 1)
+		{
+			Jobs.reset(new JobSystem(ThreadCount - 1));
+		}
+
+		Milliseconds = 0.0;
+		Visible = 0;
+		for (uint32_t Pass = 0; Pass < mSettings.Iterations; ++Pass)
+		{
+			Frustum View = MakeView(Pass, mSettings.Iterations);
+
+			auto Start = Clock::now();
+			Culler.Cull(View, VisibleList, Jobs.get());
+			Milliseconds += MillisecondsSince(Start);
+			Visible += VisibleList.size();
+
+			if (!VisibleListsMatch(View, Boxes, Expected[Pass], VisibleList))
+			{
+				char Error[128];
+				snprintf(Error, sizeof(Error), "Visible objects differ from AoS with %u objects, %u threads, pass %u",
+					ObjectCount, ThreadCount, Pass);
+				mLastError = Error;
+				return false;
+			}
+		}
+
+		char Mode[32];
+		snprintf(Mode, sizeof(Mode), ThreadCount > 1 ? "Culler x%u" : "Culler", ThreadCount);
+		AddResult(ObjectCount, Mode, Milliseconds, Visible);
+	}
+	return true;
+}
+
+void CullingBenchmark::AddResult(uint32_t ObjectCount, const std::string& Mode, double Milliseconds, uint64_t Visible)
+{
+	CullingBenchmarkResult Result;
+	Result.ObjectCount = ObjectCount;
+	Result.Mode = Mode;
+	Result.MillisecondsPerPass = Milliseconds / mSettings.Iterations;
+	Result.ObjectsPerMicrosecond = Result.MillisecondsPerPass > 0.0 ? ObjectCount / (Result.MillisecondsPerPass * 1000.0) : 0.0;
+	Result.VisiblePerPass = static_cast<uint32_t>(Visible / mSettings.Iterations);
+	mResults.push_back(Result);
+}
+
+bool CullingBenchmark::WriteReport(const char* Filename) const
+{
+	FILE* File = fopen(Filename, "w");
+	if (!File)
+	{
+		return false;
+	}
+
+	fprintf(File, "Backend:     %s\n", GetSimdBackendName());
+	fprintf(File, "Iterations:  %u\n\n", mSettings.Iterations);
+	fprintf(File, "Objects,Mode,MsPerPass,ObjectsPerUs,VisiblePerPass\n");
+	for (const CullingBenchmarkResult& Result : mResults)
+	{
+		fprintf(File, "%u,%s,%.3f,%.1f,%u\n", Result.ObjectCount, Result.Mode.c_str(), Result.MillisecondsPerPass,
+			Result.ObjectsPerMicrosecond, Result.VisiblePerPass);
+	}
+
+	fclose(File);
+	return true;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//Frustum culling throughput, in objects per microsecond, for each of
+//ObjectCounts random boxes viewed by a camera turning on the spot. Modes:
+//	AoS			- IsAabbInFrustum on each object in turn
+//	Culler		- FrustumCuller on this thread
+//	Culler xN	- FrustumCuller split across N threads, for each ThreadCounts
+//
+//Run() fails if a culler's visible list differs from the AoS one other than
+//for boxes within rounding of a plane.
+struct CullingBenchmarkSettings
+{
+	std::vector<uint32_t> ObjectCounts = { 100000, 1000000 };
+	std::vector<uint32_t> ThreadCounts = { 2, 4, 8 };
+	uint32_t Iterations = 50;
+};
+
+struct CullingBenchmarkResult
+{
+	uint32_t ObjectCount = 0;
+	std::string Mode;
+	double MillisecondsPerPass = 0.0;
+	double ObjectsPerMicrosecond = 0.0;
+	uint32_t VisiblePerPass = 0;
+};
+
+class CullingBenchmark
+{
+public:
+	CullingBenchmark(const CullingBenchmarkSettings& Settings);
+	~CullingBenchmark();
+
+	bool Run();
+	bool WriteReport(const char* Filename) const;
+
+	const std::string& GetLastError() const { return mLastError; }
+
+private:
+	bool RunObjectCount(uint32_t ObjectCount);
+
+	void AddResult(uint32_t ObjectCount, const std::string& Mode, double Milliseconds, uint64_t Visible);
+
+private:
+	CullingBenchmarkSettings mSettings;
+	std::vector<CullingBenchmarkResult> mResults;
+	std::string mLastError;
+};
@@ -0,0 +1,59 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CullingBenchmark.h"
+
+//Frustum culling benchmark:
+//	CullingBenchmark [-iterations N] [-objects N ...] [-threads N ...]
+//Writes CullingBenchmark.txt to the current directory.
+int main(int argc, char** argv)
+{
+	CullingBenchmarkSettings Settings;
+	bool bCustomObjects = false;
+	bool bCustomThreads = false;
+	bool bValid = true;
+	for (int i = 1; i < argc && bValid; ++i)
+	{
+		if (strcmp(argv[i], "-iterations") == 0 && i + 1 < argc)
+		{
+			Settings.Iterations = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-objects") == 0 && i + 1 < argc)
+		{
+			if (!bCustomObjects)
+			{
+				Settings.ObjectCounts.clear();
+				bCustomObjects = true;
+			}
+			Settings.ObjectCounts.push_back(static_cast<uint32_t>(atoi(argv[++i])));
+		}
+		else if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc)
+		{
+			if (!bCustomThreads)
+			{
+				Settings.ThreadCounts.clear();
+				bCustomThreads = true;
+			}
+			Settings.ThreadCounts.push_back(static_cast<uint32_t>(atoi(argv[++i])));
+		}
+		else
+		{
+			bValid = false;
+		}
+	}
+
+	if (!bValid || Settings.Iterations == 0)
+	{
+		fprintf(stderr, "Usage: CullingBenchmark [-iterations N] [-objects N ...] [-threads N ...]\n");
+		return 1;
+	}
+
+	CullingBenchmark Benchmark(Settings);
+	if (!Benchmark.Run())
+	{
+		fprintf(stderr, "%s\n", Benchmark.GetLastError().c_str());
+		return 1;
+	}
+	return Benchmark.WriteReport("CullingBenchmark.txt") ? 0 : 1;
+}
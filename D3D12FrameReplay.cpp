@@ -0,0 +1,340 @@
+#include "D3D12FrameReplay.h"
+#include "Common.h"
+#include "FrameCapture.h"
+
+#include "d3dx12.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+
+using namespace Microsoft::WRL;
+
+namespace
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	double MillisecondsSince(Clock::time_point Start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - Start).count();
+	}
+
+	//Swaps captured addresses and handles for the replay's on the way through
+	class RemappingCommandList : public IRenderCommandList
+	{
+	public:
+		RemappingCommandList(const D3D12FrameReplay& Replay, IRenderCommandList& Target)
+			: mReplay(Replay), mTarget(Target)
+		{}
+
+		void SetPipelineState(uint32_t PipelineState) override { mTarget.SetPipelineState(PipelineState); }
+		void SetGraphicsRootSignature(uint32_t RootSignature) override { mTarget.SetGraphicsRootSignature(RootSignature); }
+		void SetGraphicsRootDescriptorTable(uint32_t RootParameter, uint32_t Table) override
+		{
+			mTarget.SetGraphicsRootDescriptorTable(RootParameter, Table);
+		}
+		void SetGraphicsRootShaderResourceView(uint32_t RootParameter, uint64_t GpuAddress) override
+		{
+			mTarget.SetGraphicsRootShaderResourceView(RootParameter, mReplay.RemapGpuAddress(GpuAddress));
+		}
+		void SetMesh(uint32_t Mesh) override { mTarget.SetMesh(Mesh); }
+		void SetViewport(const RenderViewport& Viewport) override { mTarget.SetViewport(Viewport); }
+		void SetRenderTargets(uint32_t Count, const uint64_t* RenderTargets, uint64_t DepthStencil) override
+		{
+			uint64_t Remapped[MaxRenderTargets];
+			for (uint32_t i = 0; i < Count; ++i)
+			{
+				Remapped[i] = mReplay.RemapDescriptor(RenderTargets[i]);
+			}
+			mTarget.SetRenderTargets(Count, Remapped, DepthStencil != 0 ? mReplay.RemapDescriptor(DepthStencil) : 0);
+		}
+		void DrawIndexedInstanced(uint32_t IndexCountPerInstance, uint32_t InstanceCount, uint32_t StartIndexLocation,
+			int32_t BaseVertexLocation, uint32_t StartInstanceLocation) override
+		{
+			mTarget.DrawIndexedInstanced(IndexCountPerInstance, InstanceCount, StartIndexLocation, BaseVertexLocation, StartInstanceLocation);
+		}
+		void ResourceBarrier(uint32_t Resource, RenderResourceState Before, RenderResourceState After) override
+		{
+			mTarget.ResourceBarrier(Resource, Before, After);
+		}
+		void CopyBufferRegion(uint32_t Destination, uint64_t DestinationOffset, uint32_t Source, uint64_t SourceOffset,
+			uint64_t Size) override
+		{
+			mTarget.CopyBufferRegion(Destination, DestinationOffset, Source, SourceOffset, Size);
+		}
+
+	private:
+		const D3D12FrameReplay& mReplay;
+		IRenderCommandList& mTarget;
+	};
+}
+
+D3D12FrameReplay::D3D12FrameReplay(ID3D12Device* Device, ID3D12CommandQueue* Queue, const D3D12RenderObjects& Objects,
+	ID3D12DescriptorHeap* DescriptorHeap)
+	: mDevice(Device), mQueue(Queue), mDescriptorHeap(DescriptorHeap), mCapture(nullptr), mObjects(Objects), mFenceEvent(nullptr),
+	mFenceValue(0)
+{
+	Assert(Device);
+	Assert(Queue);
+	mObjects.Resources.clear();
+}
+
+D3D12FrameReplay::~D3D12FrameReplay()
+{
+	if (mFenceEvent)
+	{
+		CloseHandle(mFenceEvent);
+	}
+}
+
+bool D3D12FrameReplay::Create(const FrameCapture* Capture)
+{
+	Assert(!mCapture);
+	if (!Capture || !Capture->IsLoaded())
+	{
+		mLastError = "No capture loaded";
+		return false;
+	}
+	mCapture = Capture;
+
+	const uint32_t ResourceCount = Capture->GetResourceCount();
+	std::vector<bool> Uploaded(ResourceCount, false);
+	for (uint32_t i = 0; i < Capture->GetUploadCount(); ++i)
+	{
+		Uploaded[Capture->GetUpload(i).Resource] = true;
+	}
+
+	uint32_t RenderTargetCount = 0;
+	uint32_t DepthStencilCount = 0;
+	for (uint32_t i = 0; i < ResourceCount; ++i)
+	{
+		const FrameCaptureResource& Resource = Capture->GetResource(i);
+		RenderTargetCount += (Resource.Flags & FrameCaptureResource_RenderTarget) ? 1 : 0;
+		DepthStencilCount += (Resource.Flags & FrameCaptureResource_DepthStencil) ? 1 : 0;
+	}
+
+	D3D12_DESCRIPTOR_HEAP_DESC HeapDesc = {};
+	HeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+	if (RenderTargetCount > 0)
+	{
+		HeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
+		HeapDesc.NumDescriptors = RenderTargetCount;
+		CheckHResult(mDevice->CreateDescriptorHeap(&HeapDesc, IID_PPV_ARGS(mRenderTargetHeap.GetAddressOf())));
+	}
+	if (DepthStencilCount > 0)
+	{
+		HeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
+		HeapDesc.NumDescriptors = DepthStencilCount;
+		CheckHResult(mDevice->CreateDescriptorHeap(&HeapDesc, IID_PPV_ARGS(mDepthStencilHeap.GetAddressOf())));
+	}
+	const UINT RenderTargetStride = mDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+	const UINT DepthStencilStride = mDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_DSV);
+
+	//Buffers given uploads live on the upload heap; everything else starts in its captured state
+	const D3D12_HEAP_PROPERTIES UploadHeapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
+	const D3D12_HEAP_PROPERTIES DefaultHeapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+	mResources.resize(ResourceCount);
+	uint32_t RenderTargetViews = 0;
+	uint32_t DepthStencilViews = 0;
+	for (uint32_t i = 0; i < ResourceCount; ++i)
+	{
+		const FrameCaptureResource& Resource = Capture->GetResource(i);
+		if (Resource.Dimension == FrameCaptureDimension::Buffer)
+		{
+			D3D12_RESOURCE_DESC Desc = CD3DX12_RESOURCE_DESC::Buffer(Resource.Width);
+			HRESULT Result = mDevice->CreateCommittedResource(Uploaded[i] ? &UploadHeapProps : &DefaultHeapProps, D3D12_HEAP_FLAG_NONE,
+				&Desc, Uploaded[i] ? D3D12_RESOURCE_STATE_GENERIC_READ : GetD3D12ResourceState(Resource.InitialState), nullptr,
+				IID_PPV_ARGS(mResources[i].GetAddressOf()));
+			if (FAILED(Result))
+			{
+				mLastError = std::string("Couldn't create buffer ") + Capture->GetString(Resource.NameOffset);
+				return false;
+			}
+		}
+		else
+		{
+			D3D12_RESOURCE_FLAGS Flags = D3D12_RESOURCE_FLAG_NONE;
+			Flags |= (Resource.Flags & FrameCaptureResource_RenderTarget) ? D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET : D3D12_RESOURCE_FLAG_NONE;
+			Flags |= (Resource.Flags & FrameCaptureResource_DepthStencil) ? D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL : D3D12_RESOURCE_FLAG_NONE;
+			D3D12_RESOURCE_DESC Desc = CD3DX12_RESOURCE_DESC::Tex2D(static_cast<DXGI_FORMAT>(Resource.Format), Resource.Width,
+				Resource.Height, Resource.ArraySize, Resource.MipLevels, 1, 0, Flags);
+			HRESULT Result = mDevice->CreateCommittedResource(&DefaultHeapProps, D3D12_HEAP_FLAG_NONE, &Desc,
+				GetD3D12ResourceState(Resource.InitialState), nullptr, IID_PPV_ARGS(mResources[i].GetAddressOf()));
+			if (FAILED(Result))
+			{
+				mLastError = std::string("Couldn't create texture ") + Capture->GetString(Resource.NameOffset);
+				return false;
+			}
+		}
+
+		//Views in the order the resources come
+		if (Resource.Flags & FrameCaptureResource_RenderTarget)
+		{
+			D3D12_CPU_DESCRIPTOR_HANDLE Handle = mRenderTargetHeap->GetCPUDescriptorHandleForHeapStart();
+			Handle.ptr += static_cast<SIZE_T>(RenderTargetViews++) * RenderTargetStride;
+			mDevice->CreateRenderTargetView(mResources[i].Get(), nullptr, Handle);
+			mDescriptors.push_back(std::make_pair(Resource.Descriptor, static_cast<uint64_t>(Handle.ptr)));
+		}
+		if (Resource.Flags & FrameCaptureResource_DepthStencil)
+		{
+			D3D12_CPU_DESCRIPTOR_HANDLE Handle = mDepthStencilHeap->GetCPUDescriptorHandleForHeapStart();
+			Handle.ptr += static_cast<SIZE_T>(DepthStencilViews++) * DepthStencilStride;
+			mDevice->CreateDepthStencilView(mResources[i].Get(), nullptr, Handle);
+			mDescriptors.push_back(std::make_pair(Resource.Descriptor, static_cast<uint64_t>(Handle.ptr)));
+		}
+
+		mObjects.Resources.push_back(mResources[i].Get());
+	}
+
+	//Captured contents, written once - replayed frames only read them
+	for (uint32_t i = 0; i < Capture->GetUploadCount(); ++i)
+	{
+		const FrameCaptureUpload& Upload = Capture->GetUpload(i);
+		uint8_t* Mapped = nullptr;
+		D3D12_RANGE ReadRange = { 0, 0 };
+		CheckHResult(mResources[Upload.Resource]->Map(0, &ReadRange, reinterpret_cast<void**>(&Mapped)));
+		memcpy(Mapped + Upload.ResourceOffset, Capture->GetUploadData(i), static_cast<size_t>(Upload.Size));
+		D3D12_RANGE WrittenRange = { static_cast<SIZE_T>(Upload.ResourceOffset), static_cast<SIZE_T>(Upload.ResourceOffset + Upload.Size) };
+		mResources[Upload.Resource]->Unmap(0, &WrittenRange);
+	}
+
+	CheckHResult(mDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(mAllocator.GetAddressOf())));
+	CheckHResult(mDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, mAllocator.Get(), nullptr,
+		IID_PPV_ARGS(mCommandList.GetAddressOf())));
+	CheckHResult(mCommandList->Close());
+
+	CheckHResult(mDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(mFence.GetAddressOf())));
+	mFenceEvent = CreateEventA(nullptr, FALSE, FALSE, nullptr);
+	Check(mFenceEvent);
+
+	const uint32_t TimestampCount = Capture->GetPassCount() + 1;
+	D3D12_QUERY_HEAP_DESC QueryHeapDesc = {};
+	QueryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+	QueryHeapDesc.Count = TimestampCount;
+	CheckHResult(mDevice->CreateQueryHeap(&QueryHeapDesc, IID_PPV_ARGS(mTimestampHeap.GetAddressOf())));
+
+	const D3D12_HEAP_PROPERTIES ReadbackHeapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK);
+	D3D12_RESOURCE_DESC ReadbackDesc = CD3DX12_RESOURCE_DESC::Buffer(TimestampCount * sizeof(uint64_t));
+	CheckHResult(mDevice->CreateCommittedResource(&ReadbackHeapProps, D3D12_HEAP_FLAG_NONE, &ReadbackDesc,
+		D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(mTimestampReadback.GetAddressOf())));
+	return true;
+}
+
+bool D3D12FrameReplay::Run(uint32_t Frames, std::vector<D3D12FrameReplayPassTiming>& OutTimings)
+{
+	Assert(mCapture && Frames > 0);
+
+	UINT64 Frequency = 0;
+	if (FAILED(mQueue->GetTimestampFrequency(&Frequency)) || Frequency == 0)
+	{
+		mLastError = "The queue has no timestamp frequency";
+		return false;
+	}
+
+	const uint32_t PassCount = mCapture->GetPassCount();
+	const uint32_t TimestampCount = PassCount + 1;
+	OutTimings.assign(PassCount, D3D12FrameReplayPassTiming());
+	for (uint32_t Pass = 0; Pass < PassCount; ++Pass)
+	{
+		OutTimings[Pass].Name = mCapture->GetString(mCapture->GetPass(Pass).NameOffset);
+	}
+
+	for (uint32_t Frame = 0; Frame < Frames; ++Frame)
+	{
+		CheckHResult(mAllocator->Reset());
+		CheckHResult(mCommandList->Reset(mAllocator.Get(), nullptr));
+		if (mDescriptorHeap)
+		{
+			ID3D12DescriptorHeap* Heaps[] = { mDescriptorHeap };
+			mCommandList->SetDescriptorHeaps(1, Heaps);
+		}
+
+		D3D12RenderCommandList Commands(mCommandList.Get(), &mObjects);
+		RemappingCommandList Remapped(*this, Commands);
+
+		mCommandList->EndQuery(mTimestampHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, 0);
+		for (uint32_t Pass = 0; Pass < PassCount; ++Pass)
+		{
+			auto Start = Clock::now();
+			mCapture->ReplayPass(Pass, Remapped);
+			OutTimings[Pass].CpuMilliseconds += MillisecondsSince(Start);
+			mCommandList->EndQuery(mTimestampHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, Pass + 1);
+		}
+		mCommandList->ResolveQueryData(mTimestampHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, 0, TimestampCount, mTimestampReadback.Get(), 0);
+		CheckHResult(mCommandList->Close());
+
+		ID3D12CommandList* CommandLists[] = { mCommandList.Get() };
+		mQueue->ExecuteCommandLists(1, CommandLists);
+		CheckHResult(mQueue->Signal(mFence.Get(), ++mFenceValue));
+		if (mFence->GetCompletedValue() < mFenceValue)
+		{
+			CheckHResult(mFence->SetEventOnCompletion(mFenceValue, mFenceEvent));
+			WaitForSingleObject(mFenceEvent, INFINITE);
+		}
+
+		void* Mapped = nullptr;
+		D3D12_RANGE ReadRange = { 0, TimestampCount * sizeof(uint64_t) };
+		CheckHResult(mTimestampReadback->Map(0, &ReadRange, &Mapped));
+		const uint64_t* Timestamps = static_cast<const uint64_t*>(Mapped);
+		for (uint32_t Pass = 0; Pass < PassCount; ++Pass)
+		{
+			OutTimings[Pass].GpuMilliseconds += static_cast<double>(Timestamps[Pass + 1] - Timestamps[Pass]) * 1000.0 / Frequency;
+		}
+		D3D12_RANGE WrittenRange = { 0, 0 };
+		mTimestampReadback->Unmap(0, &WrittenRange);
+	}
+
+	for (D3D12FrameReplayPassTiming& Timing : OutTimings)
+	{
+		Timing.CpuMilliseconds /= Frames;
+		Timing.GpuMilliseconds /= Frames;
+	}
+	return true;
+}
+
+uint64_t D3D12FrameReplay::RemapDescriptor(uint64_t CapturedDescriptor) const
+{
+	for (const std::pair<uint64_t, uint64_t>& Descriptor : mDescriptors)
+	{
+		if (Descriptor.first == CapturedDescriptor)
+		{
+			return Descriptor.second;
+		}
+	}
+	return 0;
+}
+
+uint64_t D3D12FrameReplay::RemapGpuAddress(uint64_t CapturedGpuAddress) const
+{
+	uint32_t Resource = 0;
+	uint64_t Offset = 0;
+	if (!mCapture->FindBuffer(CapturedGpuAddress, Resource, Offset))
+	{
+		return 0;
+	}
+	return mResources[Resource]->GetGPUVirtualAddress() + Offset;
+}
+
+bool D3D12FrameReplay::WriteReport(const char* Filename, uint32_t Frames, const std::vector<D3D12FrameReplayPassTiming>& Timings) const
+{
+	FILE* File = fopen(Filename, "w");
+	if (!File)
+	{
+		return false;
+	}
+
+	fprintf(File, "Frames: %u\n\n", Frames);
+	fprintf(File, "Pass,CpuMs,GpuMs\n");
+	double CpuTotal = 0.0;
+	double GpuTotal = 0.0;
+	for (const D3D12FrameReplayPassTiming& Timing : Timings)
+	{
+		fprintf(File, "%s,%.4f,%.4f\n", Timing.Name.c_str(), Timing.CpuMilliseconds, Timing.GpuMilliseconds);
+		CpuTotal += Timing.CpuMilliseconds;
+		GpuTotal += Timing.GpuMilliseconds;
+	}
+	fprintf(File, "Frame,%.4f,%.4f\n", CpuTotal, GpuTotal);
+
+	fclose(File);
+	return true;
+}
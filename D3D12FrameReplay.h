@@ -0,0 +1,84 @@
+#pragma once
+
+#include <windows.h>
+#include <wrl.h>
+#include <d3d12.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "D3D12RenderCommandList.h"
+
+class FrameCapture;
+
+struct D3D12FrameReplayPassTiming
+{
+	std::string Name;
+	double CpuMilliseconds = 0.0;	//Recording, mean per frame
+	double GpuMilliseconds = 0.0;	//Between timestamps either side of the pass, mean per frame
+};
+
+//Replays a FrameCapture on a device, frame after frame, timing each pass on
+//the CPU and the GPU.
+//
+//Captures hold no pipeline states, root signatures, descriptor tables or
+//meshes - those come from the renderer that made the capture, through
+//Objects, indexed by the same ids. Everything in the capture's resource table
+//is created fresh: buffers given uploads on the upload heap, holding the
+//captured contents, and the rest on the default heap with views for render
+//targets and depth stencils. Root shader resource view addresses and render
+//target handles are remapped from the captured resources to these.
+//Each frame must leave its resources in the states it started them in.
+class D3D12FrameReplay
+{
+public:
+	//DescriptorHeap holds Objects' descriptor tables; null if there are none
+	D3D12FrameReplay(ID3D12Device* Device, ID3D12CommandQueue* Queue, const D3D12RenderObjects& Objects,
+		ID3D12DescriptorHeap* DescriptorHeap);
+	~D3D12FrameReplay();
+
+	//Capture must outlive the replay
+	bool Create(const FrameCapture* Capture);
+
+	//Waits for the GPU after each frame
+	bool Run(uint32_t Frames, std::vector<D3D12FrameReplayPassTiming>& OutTimings);
+
+	bool WriteReport(const char* Filename, uint32_t Frames, const std::vector<D3D12FrameReplayPassTiming>& Timings) const;
+
+	const std::string& GetLastError() const { return mLastError; }
+
+	//Replay handles for the captured ones; 0 for none
+	uint64_t RemapDescriptor(uint64_t CapturedDescriptor) const;
+	uint64_t RemapGpuAddress(uint64_t CapturedGpuAddress) const;
+
+private:
+	D3D12FrameReplay(const D3D12FrameReplay&) = delete;
+	D3D12FrameReplay& operator=(const D3D12FrameReplay&) = delete;
+
+private:
+	Microsoft::WRL::ComPtr<ID3D12Device> mDevice;
+	Microsoft::WRL::ComPtr<ID3D12CommandQueue> mQueue;
+	ID3D12DescriptorHeap* mDescriptorHeap;
+	const FrameCapture* mCapture;
+
+	//The renderer's objects with the replay's resources
+	D3D12RenderObjects mObjects;
+	std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> mResources;
+
+	//Captured descriptor and the replay's, for each render target and depth stencil
+	std::vector<std::pair<uint64_t, uint64_t>> mDescriptors;
+	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> mRenderTargetHeap;
+	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> mDepthStencilHeap;
+
+	Microsoft::WRL::ComPtr<ID3D12CommandAllocator> mAllocator;
+	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> mCommandList;
+	Microsoft::WRL::ComPtr<ID3D12Fence> mFence;
+	HANDLE mFenceEvent;
+	uint64_t mFenceValue;
+
+	//One timestamp before the first pass and one after each
+	Microsoft::WRL::ComPtr<ID3D12QueryHeap> mTimestampHeap;
+	Microsoft::WRL::ComPtr<ID3D12Resource> mTimestampReadback;
+
+	std::string mLastError;
+};
@@ -0,0 +1,110 @@
+#include "D3D12PackedMesh.h"
+#include "Common.h"
+#include "DeferredReleaseQueue.h"
+
+#include "d3dx12.h"
+
+#include <cstring>
+
+using namespace Microsoft::WRL;
+
+D3D12PackedMesh::D3D12PackedMesh()
+	: mVertexBufferViews(), mVertexBufferViewCount(0), mIndexBufferView()
+{}
+
+D3D12PackedMesh::~D3D12PackedMesh()
+{
+	Assert(!mBuffer);
+}
+
+void D3D12PackedMesh::Create(ID3D12Device* Device, ID3D12GraphicsCommandList* CommandList,
+	DeferredReleaseQueue* ReleaseQueue, const PackedMesh& Mesh)
+{
+	Assert(Mesh.IsLoaded());
+	Assert(!mBuffer);
+
+	const PackedMeshHeader& Header = Mesh.GetHeader();
+	UINT64 GpuDataSize = Mesh.GetGpuDataSize();
+
+	//Buffers start in COMMON and are promoted to COPY_DEST by the copy
+	D3D12_HEAP_PROPERTIES DefaultHeapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+	D3D12_RESOURCE_DESC BufferDesc = CD3DX12_RESOURCE_DESC::Buffer(GpuDataSize);
+	CheckHResult(Device->CreateCommittedResource(&DefaultHeapProps, D3D12_HEAP_FLAG_NONE,
+		&BufferDesc, D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(mBuffer.GetAddressOf())));
+
+	ComPtr<ID3D12Resource> UploadBuffer;
+	D3D12_HEAP_PROPERTIES UploadHeapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
+	CheckHResult(Device->CreateCommittedResource(&UploadHeapProps, D3D12_HEAP_FLAG_NONE,
+		&BufferDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(UploadBuffer.GetAddressOf())));
+
+	void* UploadData = nullptr;
+	D3D12_RANGE ReadRange = { 0, 0 };
+	CheckHResult(UploadBuffer->Map(0, &ReadRange, &UploadData));
+	memcpy(UploadData, Mesh.GetGpuData(), static_cast<size_t>(GpuDataSize));
+	UploadBuffer->Unmap(0, nullptr);
+
+	CommandList->CopyBufferRegion(mBuffer.Get(), 0, UploadBuffer.Get(), 0, GpuDataSize);
+
+	D3D12_RESOURCE_BARRIER ToVertexAndIndex = CD3DX12_RESOURCE_BARRIER::Transition(mBuffer.Get(),
+		D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER | D3D12_RESOURCE_STATE_INDEX_BUFFER);
+	CommandList->ResourceBarrier(1, &ToVertexAndIndex);
+
+	ReleaseQueue->ReleaseObject(UploadBuffer.Detach());
+
+	//Views
+	D3D12_GPU_VIRTUAL_ADDRESS BaseAddress = mBuffer->GetGPUVirtualAddress();
+	mVertexBufferViewCount = Mesh.IsInterleaved() ? 1 : PackedMeshStream_Count;
+	for (uint32_t Slot = 0; Slot < mVertexBufferViewCount; ++Slot)
+	{
+		const PackedMeshStreamDesc& Stream = Header.Streams[Slot];
+		mVertexBufferViews[Slot].BufferLocation = BaseAddress + Stream.Offset;
+		mVertexBufferViews[Slot].StrideInBytes = Stream.Stride;
+		mVertexBufferViews[Slot].SizeInBytes = Header.VertexCount * Stream.Stride;
+	}
+
+	mIndexBufferView.BufferLocation = BaseAddress + Header.IndexDataOffset;
+	mIndexBufferView.Format = Header.IndexSize == 2 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+	mIndexBufferView.SizeInBytes = Header.IndexCount * Header.IndexSize;
+}
+
+void D3D12PackedMesh::Destroy(DeferredReleaseQueue* ReleaseQueue)
+{
+	if (mBuffer)
+	{
+		ReleaseQueue->ReleaseObject(mBuffer.Detach());
+	}
+	mVertexBufferViewCount = 0;
+}
+
+uint32_t D3D12PackedMesh::GetVertexBufferViews(D3D12_VERTEX_BUFFER_VIEW OutViews[PackedMeshStream_Count]) const
+{
+	for (uint32_t Slot = 0; Slot < mVertexBufferViewCount; ++Slot)
+	{
+		OutViews[Slot] = mVertexBufferViews[Slot];
+	}
+	return mVertexBufferViewCount;
+}
+
+void D3D12PackedMesh::GetInputElements(const PackedMeshHeader& Header, D3D12_INPUT_ELEMENT_DESC OutElements[PackedMeshStream_Count])
+{
+	static const char* SemanticNames[PackedMeshStream_Count] = { "POSITION", "NORMAL", "TEXCOORD" };
+	static const DXGI_FORMAT Formats[PackedMeshStream_Count] =
+	{
+		DXGI_FORMAT_R16G16B16A16_UNORM,
+		DXGI_FORMAT_R16G16_SNORM,
+		DXGI_FORMAT_R16G16_FLOAT
+	};
+
+	bool bInterleaved = (Header.Flags & PackedMeshFlag_Interleaved) != 0;
+	for (uint32_t StreamIdx = 0; StreamIdx < PackedMeshStream_Count; ++StreamIdx)
+	{
+		D3D12_INPUT_ELEMENT_DESC& Element = OutElements[StreamIdx];
+		Element.SemanticName = SemanticNames[StreamIdx];
+		Element.SemanticIndex = 0;
+		Element.Format = Formats[StreamIdx];
+		Element.InputSlot = bInterleaved ? 0 : StreamIdx;
+		Element.AlignedByteOffset = Header.Streams[StreamIdx].AttributeOffset;
+		Element.InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA;
+		Element.InstanceDataStepRate = 0;
+	}
+}
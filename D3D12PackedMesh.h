@@ -0,0 +1,40 @@
+#pragma once
+
+#include <windows.h>
+#include <wrl.h>
+#include <d3d12.h>
+
+#include "PackedMesh.h"
+
+class DeferredReleaseQueue;
+
+//GPU copy of a PackedMesh. The file's GPU data block goes in to one default
+//heap buffer holding every vertex stream and the index buffer - a single
+//memcpy from the (mapped) file in to the upload buffer and a single
+//CopyBufferRegion. The upload buffer is handed to the release queue.
+class D3D12PackedMesh
+{
+public:
+	D3D12PackedMesh();
+	~D3D12PackedMesh();
+
+	//Records the upload on CommandList. Usable once that has executed.
+	void Create(ID3D12Device* Device, ID3D12GraphicsCommandList* CommandList,
+		DeferredReleaseQueue* ReleaseQueue, const PackedMesh& Mesh);
+
+	//Releases the buffer through the queue.
+	void Destroy(DeferredReleaseQueue* ReleaseQueue);
+
+	//One view per input slot (1 interleaved, 3 split). Returns the count.
+	uint32_t GetVertexBufferViews(D3D12_VERTEX_BUFFER_VIEW OutViews[PackedMeshStream_Count]) const;
+	const D3D12_INDEX_BUFFER_VIEW& GetIndexBufferView() const { return mIndexBufferView; }
+
+	//POSITION/NORMAL/TEXCOORD elements matching the mesh's stream layout.
+	static void GetInputElements(const PackedMeshHeader& Header, D3D12_INPUT_ELEMENT_DESC OutElements[PackedMeshStream_Count]);
+
+private:
+	Microsoft::WRL::ComPtr<ID3D12Resource> mBuffer;
+	D3D12_VERTEX_BUFFER_VIEW mVertexBufferViews[PackedMeshStream_Count];
+	uint32_t mVertexBufferViewCount;
+	D3D12_INDEX_BUFFER_VIEW mIndexBufferView;
+};
@@ -0,0 +1,35 @@
+#include "D3D12QueueFence.h"
+#include "Common.h"
+
+D3D12QueueFence::D3D12QueueFence(ID3D12Device* Device, ID3D12CommandQueue* Queue)
+	: mQueue(Queue), mEvent(0), mLastSignalledValue(0)
+{
+	CheckHResult(Device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(mFence.GetAddressOf())));
+	mEvent = CreateEventEx(nullptr, false, false, EVENT_ALL_ACCESS);
+}
+
+D3D12QueueFence::~D3D12QueueFence()
+{
+	CloseHandle(mEvent);
+}
+
+uint64_t D3D12QueueFence::Signal()
+{
+	++mLastSignalledValue;
+	CheckHResult(mQueue->Signal(mFence.Get(), mLastSignalledValue));
+	return mLastSignalledValue;
+}
+
+uint64_t D3D12QueueFence::GetCompletedValue() const
+{
+	return mFence->GetCompletedValue();
+}
+
+void D3D12QueueFence::WaitForValue(uint64_t Value)
+{
+	if (mFence->GetCompletedValue() < Value)
+	{
+		CheckHResult(mFence->SetEventOnCompletion(Value, mEvent));
+		WaitForSingleObject(mEvent, INFINITE);
+	}
+}
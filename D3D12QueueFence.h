@@ -0,0 +1,31 @@
+#pragma once
+
+#include <windows.h>
+#include <wrl.h>
+#include <d3d12.h>
+
+#include "IFence.h"
+
+//ID3D12Fence bound to the queue that signals it.
+class D3D12QueueFence : public IFence
+{
+public:
+	D3D12QueueFence(ID3D12Device* Device, ID3D12CommandQueue* Queue);
+	~D3D12QueueFence();
+
+	uint64_t Signal() override;
+
+	uint64_t GetLastSignalledValue() const override { return mLastSignalledValue; }
+	uint64_t GetCompletedValue() const override;
+
+	void WaitForValue(uint64_t Value) override;
+
+	ID3D12Fence* GetFence() const { return mFence.Get(); }
+	ID3D12CommandQueue* GetQueue() const { return mQueue.Get(); }
+
+private:
+	Microsoft::WRL::ComPtr<ID3D12CommandQueue> mQueue;
+	Microsoft::WRL::ComPtr<ID3D12Fence> mFence;
+	HANDLE mEvent;
+	uint64_t mLastSignalledValue;
+};
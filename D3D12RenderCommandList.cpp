@@ -0,0 +1,120 @@
+#include "D3D12RenderCommandList.h"
+#include "Common.h"
+#include "D3D12PackedMesh.h"
+
+D3D12_RESOURCE_STATES GetD3D12ResourceState(RenderResourceState State)
+{
+	switch (State)
+	{
+	case RenderResourceState::Common:					return D3D12_RESOURCE_STATE_COMMON;
+	case RenderResourceState::VertexAndConstantBuffer:	return D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER;
+	case RenderResourceState::IndexBuffer:				return D3D12_RESOURCE_STATE_INDEX_BUFFER;
+	case RenderResourceState::RenderTarget:				return D3D12_RESOURCE_STATE_RENDER_TARGET;
+	case RenderResourceState::DepthWrite:				return D3D12_RESOURCE_STATE_DEPTH_WRITE;
+	case RenderResourceState::DepthRead:				return D3D12_RESOURCE_STATE_DEPTH_READ;
+	case RenderResourceState::ShaderResource:			return D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
+	case RenderResourceState::CopyDest:					return D3D12_RESOURCE_STATE_COPY_DEST;
+	case RenderResourceState::CopySource:				return D3D12_RESOURCE_STATE_COPY_SOURCE;
+	case RenderResourceState::Present:					return D3D12_RESOURCE_STATE_PRESENT;
+	default:
+		Assert(false);
+		return D3D12_RESOURCE_STATE_COMMON;
+	}
+}
+
+D3D12RenderCommandList::D3D12RenderCommandList(ID3D12GraphicsCommandList* CommandList, const D3D12RenderObjects* Objects)
+	: mCommandList(CommandList), mObjects(Objects)
+{
+	Assert(mCommandList);
+}
+
+D3D12RenderCommandList::~D3D12RenderCommandList()
+{}
+
+void D3D12RenderCommandList::SetPipelineState(uint32_t PipelineState)
+{
+	Assert(mObjects && PipelineState < mObjects->PipelineStates.size());
+	mCommandList->SetPipelineState(mObjects->PipelineStates[PipelineState]);
+}
+
+void D3D12RenderCommandList::SetGraphicsRootSignature(uint32_t RootSignature)
+{
+	Assert(mObjects && RootSignature < mObjects->RootSignatures.size());
+	mCommandList->SetGraphicsRootSignature(mObjects->RootSignatures[RootSignature]);
+}
+
+void D3D12RenderCommandList::SetGraphicsRootDescriptorTable(uint32_t RootParameter, uint32_t Table)
+{
+	Assert(mObjects && Table < mObjects->DescriptorTables.size());
+	mCommandList->SetGraphicsRootDescriptorTable(RootParameter, mObjects->DescriptorTables[Table]);
+}
+
+void D3D12RenderCommandList::SetGraphicsRootShaderResourceView(uint32_t RootParameter, uint64_t GpuAddress)
+{
+	mCommandList->SetGraphicsRootShaderResourceView(RootParameter, GpuAddress);
+}
+
+void D3D12RenderCommandList::SetMesh(uint32_t Mesh)
+{
+	Assert(mObjects && Mesh < mObjects->Meshes.size());
+	const D3D12PackedMesh* PackedMesh = mObjects->Meshes[Mesh];
+
+	D3D12_VERTEX_BUFFER_VIEW Views[PackedMeshStream_Count];
+	uint32_t ViewCount = PackedMesh->GetVertexBufferViews(Views);
+	mCommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	mCommandList->IASetVertexBuffers(0, ViewCount, Views);
+	mCommandList->IASetIndexBuffer(&PackedMesh->GetIndexBufferView());
+}
+
+void D3D12RenderCommandList::SetViewport(const RenderViewport& Viewport)
+{
+	D3D12_VIEWPORT D3DViewport;
+	D3DViewport.TopLeftX = Viewport.X;
+	D3DViewport.TopLeftY = Viewport.Y;
+	D3DViewport.Width = Viewport.Width;
+	D3DViewport.Height = Viewport.Height;
+	D3DViewport.MinDepth = Viewport.MinDepth;
+	D3DViewport.MaxDepth = Viewport.MaxDepth;
+	mCommandList->RSSetViewports(1, &D3DViewport);
+}
+
+void D3D12RenderCommandList::SetRenderTargets(uint32_t Count, const uint64_t* RenderTargets, uint64_t DepthStencil)
+{
+	Assert(Count <= MaxRenderTargets);
+	D3D12_CPU_DESCRIPTOR_HANDLE RenderTargetHandles[MaxRenderTargets];
+	for (uint32_t i = 0; i < Count; ++i)
+	{
+		RenderTargetHandles[i].ptr = static_cast<SIZE_T>(RenderTargets[i]);
+	}
+
+	D3D12_CPU_DESCRIPTOR_HANDLE DepthStencilHandle;
+	DepthStencilHandle.ptr = static_cast<SIZE_T>(DepthStencil);
+	mCommandList->OMSetRenderTargets(Count, Count > 0 ? RenderTargetHandles : nullptr, false,
+		DepthStencil != 0 ? &DepthStencilHandle : nullptr);
+}
+
+void D3D12RenderCommandList::DrawIndexedInstanced(uint32_t IndexCountPerInstance, uint32_t InstanceCount, uint32_t StartIndexLocation,
+	int32_t BaseVertexLocation, uint32_t StartInstanceLocation)
+{
+	mCommandList->DrawIndexedInstanced(IndexCountPerInstance, InstanceCount, StartIndexLocation, BaseVertexLocation, StartInstanceLocation);
+}
+
+void D3D12RenderCommandList::ResourceBarrier(uint32_t Resource, RenderResourceState Before, RenderResourceState After)
+{
+	Assert(mObjects && Resource < mObjects->Resources.size());
+	D3D12_RESOURCE_BARRIER Barrier = {};
+	Barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+	Barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+	Barrier.Transition.pResource = mObjects->Resources[Resource];
+	Barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+	Barrier.Transition.StateBefore = GetD3D12ResourceState(Before);
+	Barrier.Transition.StateAfter = GetD3D12ResourceState(After);
+	mCommandList->ResourceBarrier(1, &Barrier);
+}
+
+void D3D12RenderCommandList::CopyBufferRegion(uint32_t Destination, uint64_t DestinationOffset, uint32_t Source, uint64_t SourceOffset,
+	uint64_t Size)
+{
+	Assert(mObjects && Destination < mObjects->Resources.size() && Source < mObjects->Resources.size());
+	mCommandList->CopyBufferRegion(mObjects->Resources[Destination], DestinationOffset, mObjects->Resources[Source], SourceOffset, Size);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <windows.h>
+#include <d3d12.h>
+#include <vector>
+
+#include "RenderCommandList.h"
+
+class D3D12PackedMesh;
+
+//The API objects behind renderer ids, indexed by them. Owned by the renderer.
+struct D3D12RenderObjects
+{
+	std::vector<ID3D12PipelineState*> PipelineStates;
+	std::vector<ID3D12RootSignature*> RootSignatures;
+	std::vector<D3D12_GPU_DESCRIPTOR_HANDLE> DescriptorTables;
+	std::vector<const D3D12PackedMesh*> Meshes;			//Triangle lists
+	std::vector<ID3D12Resource*> Resources;
+};
+
+D3D12_RESOURCE_STATES GetD3D12ResourceState(RenderResourceState State);
+
+//IRenderCommandList recording in to an ID3D12GraphicsCommandList. Every call
+//goes straight to the API; put a StateFilteringCommandList in front of it to
+//drop redundant ones.
+class D3D12RenderCommandList : public IRenderCommandList
+{
+public:
+	//Objects may be null for lists that only set render targets and viewports
+	D3D12RenderCommandList(ID3D12GraphicsCommandList* CommandList, const D3D12RenderObjects* Objects);
+	~D3D12RenderCommandList();
+
+	void SetPipelineState(uint32_t PipelineState) override;
+	void SetGraphicsRootSignature(uint32_t RootSignature) override;
+	void SetGraphicsRootDescriptorTable(uint32_t RootParameter, uint32_t Table) override;
+	void SetGraphicsRootShaderResourceView(uint32_t RootParameter, uint64_t GpuAddress) override;
+	void SetMesh(uint32_t Mesh) override;
+	void SetViewport(const RenderViewport& Viewport) override;
+	void SetRenderTargets(uint32_t Count, const uint64_t* RenderTargets, uint64_t DepthStencil) override;
+	void DrawIndexedInstanced(uint32_t IndexCountPerInstance, uint32_t InstanceCount, uint32_t StartIndexLocation,
+		int32_t BaseVertexLocation, uint32_t StartInstanceLocation) override;
+	void ResourceBarrier(uint32_t Resource, RenderResourceState Before, RenderResourceState After) override;
+	void CopyBufferRegion(uint32_t Destination, uint64_t DestinationOffset, uint32_t Source, uint64_t SourceOffset,
+		uint64_t Size) override;
+
+	ID3D12GraphicsCommandList* GetCommandList() const { return mCommandList; }
+
+private:
+	ID3D12GraphicsCommandList* mCommandList;
+	const D3D12RenderObjects* mObjects;
+};
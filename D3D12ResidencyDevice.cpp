@@ -0,0 +1,38 @@
+#include "D3D12ResidencyDevice.h"
+#include "Common.h"
+
+using namespace Microsoft::WRL;
+
+D3D12ResidencyDevice::D3D12ResidencyDevice(ID3D12Device* Device)
+	: mDevice(Device)
+{
+	Assert(Device);
+}
+
+D3D12ResidencyDevice::~D3D12ResidencyDevice()
+{}
+
+void D3D12ResidencyDevice::MakeResident(void* const* Objects, uint32_t Count, uint64_t TotalSize)
+{
+	mPageables.assign(reinterpret_cast<ID3D12Pageable* const*>(Objects),
+		reinterpret_cast<ID3D12Pageable* const*>(Objects) + Count);
+	CheckHResult(mDevice->MakeResident(Count, mPageables.data()));
+}
+
+void D3D12ResidencyDevice::Evict(void* const* Objects, uint32_t Count, uint64_t TotalSize)
+{
+	mPageables.assign(reinterpret_cast<ID3D12Pageable* const*>(Objects),
+		reinterpret_cast<ID3D12Pageable* const*>(Objects) + Count);
+	CheckHResult(mDevice->Evict(Count, mPageables.data()));
+}
+
+uint64_t D3D12ResidencyDevice::QueryLocalBudget(IDXGIFactory4* Factory, ID3D12Device* Device, uint64_t ReservedBytes)
+{
+	ComPtr<IDXGIAdapter3> Adapter;
+	CheckHResult(Factory->EnumAdapterByLuid(Device->GetAdapterLuid(), IID_PPV_ARGS(Adapter.GetAddressOf())));
+
+	DXGI_QUERY_VIDEO_MEMORY_INFO MemoryInfo = {};
+	CheckHResult(Adapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &MemoryInfo));
+
+	return MemoryInfo.Budget > ReservedBytes ? MemoryInfo.Budget - ReservedBytes : 0;
+}
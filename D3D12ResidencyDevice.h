@@ -0,0 +1,28 @@
+#pragma once
+
+#include <windows.h>
+#include <wrl.h>
+#include <d3d12.h>
+#include <dxgi1_4.h>
+
+#include "ResidencyManager.h"
+
+//Pages ID3D12Pageable objects (heaps, committed resources) tracked by a
+//ResidencyManager in and out through the device.
+class D3D12ResidencyDevice : public IResidencyDevice
+{
+public:
+	D3D12ResidencyDevice(ID3D12Device* Device);
+	~D3D12ResidencyDevice();
+
+	void MakeResident(void* const* Objects, uint32_t Count, uint64_t TotalSize) override;
+	void Evict(void* const* Objects, uint32_t Count, uint64_t TotalSize) override;
+
+	//Local (video) memory budget the OS currently grants us, minus what is used
+	//outside the residency manager (swapchain, depth buffer etc).
+	static uint64_t QueryLocalBudget(IDXGIFactory4* Factory, ID3D12Device* Device, uint64_t ReservedBytes);
+
+private:
+	Microsoft::WRL::ComPtr<ID3D12Device> mDevice;
+	std::vector<ID3D12Pageable*> mPageables;
+};
@@ -0,0 +1,60 @@
+#include "D3D12StaticBundle.h"
+#include "Common.h"
+#include "DeferredReleaseQueue.h"
+#include "StateFilteringCommandList.h"
+#include "StaticCommandCache.h"
+
+D3D12StaticBundle::D3D12StaticBundle(ID3D12Device* Device, DeferredReleaseQueue* ReleaseQueue)
+	: mDevice(Device), mReleaseQueue(ReleaseQueue), mRecordCount(0)
+{
+	Assert(Device);
+	Assert(ReleaseQueue);
+}
+
+D3D12StaticBundle::~D3D12StaticBundle()
+{
+	if (mBundle)
+	{
+		mReleaseQueue->ReleaseObject(mBundle.Detach());
+		mReleaseQueue->ReleaseObject(mAllocator.Detach());
+	}
+}
+
+void D3D12StaticBundle::Update(const StaticCommandCache& Cache, const D3D12RenderObjects& Objects, ID3D12DescriptorHeap* DescriptorHeap)
+{
+	Assert(Cache.IsRecorded());
+	if (mBundle && mRecordCount == Cache.GetRecordCount())
+	{
+		return;
+	}
+
+	//Frames in flight may still execute the old one
+	if (mBundle)
+	{
+		mReleaseQueue->ReleaseObject(mBundle.Detach());
+		mReleaseQueue->ReleaseObject(mAllocator.Detach());
+	}
+
+	CheckHResult(mDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_BUNDLE, IID_PPV_ARGS(mAllocator.GetAddressOf())));
+	CheckHResult(mDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_BUNDLE, mAllocator.Get(), nullptr,
+		IID_PPV_ARGS(mBundle.GetAddressOf())));
+
+	if (DescriptorHeap)
+	{
+		ID3D12DescriptorHeap* Heaps[] = { DescriptorHeap };
+		mBundle->SetDescriptorHeaps(1, Heaps);
+	}
+
+	D3D12RenderCommandList Commands(mBundle.Get(), &Objects);
+	Cache.Execute(Commands);
+	CheckHResult(mBundle->Close());
+
+	mRecordCount = Cache.GetRecordCount();
+}
+
+void D3D12StaticBundle::Execute(ID3D12GraphicsCommandList* CommandList, StateFilteringCommandList& Filter) const
+{
+	Assert(mBundle);
+	CommandList->ExecuteBundle(mBundle.Get());
+	Filter.Invalidate();
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <windows.h>
+#include <wrl.h>
+#include <d3d12.h>
+
+#include "D3D12RenderCommandList.h"
+
+class DeferredReleaseQueue;
+class StateFilteringCommandList;
+class StaticCommandCache;
+
+//A StaticCommandCache's commands translated once in to a D3D12 bundle, so
+//each frame executes them with one ExecuteBundle rather than translating
+//every call again. A cache only holds pipeline state, bindings and draws,
+//all of which bundles can record. A bundle inherits the calling list's
+//descriptor heaps, which must be the ones given here, and its root arguments.
+//What the bundle sets leaks back out: after it the calling list has the
+//bundle's pipeline state, root signature, root arguments, topology and
+//vertex/index buffers.
+class D3D12StaticBundle
+{
+public:
+	D3D12StaticBundle(ID3D12Device* Device, DeferredReleaseQueue* ReleaseQueue);
+	~D3D12StaticBundle();
+
+	//Re-records the bundle if the cache has been recorded since the last
+	//Update(). The old bundle is freed once the GPU is done with it.
+	void Update(const StaticCommandCache& Cache, const D3D12RenderObjects& Objects, ID3D12DescriptorHeap* DescriptorHeap);
+
+	//Filter must be the filter over CommandList. It's invalidated after the
+	//bundle, as the state it knew was bound no longer is.
+	void Execute(ID3D12GraphicsCommandList* CommandList, StateFilteringCommandList& Filter) const;
+
+private:
+	Microsoft::WRL::ComPtr<ID3D12Device> mDevice;
+	DeferredReleaseQueue* mReleaseQueue;
+
+	Microsoft::WRL::ComPtr<ID3D12CommandAllocator> mAllocator;
+	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> mBundle;
+	uint32_t mRecordCount;		//Of the cache when the bundle was recorded
+};
@@ -0,0 +1,413 @@
+#include "D3D12StaticScene.h"
+#include "Common.h"
+#include "DeferredReleaseQueue.h"
+#include "StateFilteringCommandList.h"
+
+#include "d3dx12.h"
+#include <d3dcompiler.h>
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <stdio.h>
+#include <string.h>
+
+using namespace Microsoft::WRL;
+
+namespace
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	double MillisecondsSince(Clock::time_point Start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - Start).count();
+	}
+
+	const uint32_t OpaquePass = 0;
+
+	//Per object data, read through the root SRV at SV_InstanceID
+	struct StaticObject
+	{
+		float Origin[4];
+		float Extent[4];
+	};
+
+	//Positions are quantised over the mesh bounds, so [0, 1] here is the
+	//whole mesh, scaled in to the object's cell
+	const char* StaticSceneShaders =
+		"struct StaticObject { float4 Origin; float4 Extent; };\n"
+		"StructuredBuffer<StaticObject> Objects : register(t0);\n"
+		"StructuredBuffer<float4> Material : register(t1);\n"
+		"struct VertexOutput { float4 Position : SV_Position; float3 Normal : NORMAL; };\n"
+		"float3 DecodeOctahedral(float2 Encoded)\n"
+		"{\n"
+		"	float3 Normal = float3(Encoded, 1.0f - abs(Encoded.x) - abs(Encoded.y));\n"
+		"	if (Normal.z < 0.0f) { Normal.xy = (1.0f - abs(Normal.yx)) * (Normal.xy >= 0.0f ? 1.0f : -1.0f); }\n"
+		"	return normalize(Normal);\n"
+		"}\n"
+		"VertexOutput VSMain(float4 Position : POSITION, float2 Normal : NORMAL, uint InstanceId : SV_InstanceID)\n"
+		"{\n"
+		"	StaticObject Object = Objects[InstanceId];\n"
+		"	float3 World = Object.Origin.xyz + Object.Extent.xyz * (Position.xyz - 0.5f);\n"
+		"	VertexOutput Output;\n"
+		"	Output.Position = float4(World, 1.0f);\n"
+		"	Output.Normal = DecodeOctahedral(Normal);\n"
+		"	return Output;\n"
+		"}\n"
+		"float4 PSMain(VertexOutput Input) : SV_Target\n"
+		"{\n"
+		"	float Light = 0.3f + 0.7f * saturate(dot(normalize(Input.Normal), float3(0.4f, 0.6f, -0.7f)));\n"
+		"	return float4(Material[0].rgb * Light, 1.0f);\n"
+		"}\n";
+
+	bool CompileShader(const char* Entry, const char* Profile, ComPtr<ID3DBlob>& OutCode, std::string& OutError)
+	{
+		ComPtr<ID3DBlob> Errors;
+		HRESULT Result = D3DCompile(StaticSceneShaders, strlen(StaticSceneShaders), "StaticScene", nullptr, nullptr,
+			Entry, Profile, D3DCOMPILE_OPTIMIZATION_LEVEL3, 0, OutCode.ReleaseAndGetAddressOf(), Errors.GetAddressOf());
+		if (FAILED(Result))
+		{
+			OutError = Errors ? std::string(static_cast<const char*>(Errors->GetBufferPointer()), Errors->GetBufferSize()) :
+				std::string("Couldn't compile ") + Entry;
+			return false;
+		}
+		return true;
+	}
+
+	InstanceBatcherSettings MakeBatcherSettings()
+	{
+		InstanceBatcherSettings Settings;
+		Settings.InstanceDataStride = sizeof(StaticObject);
+		return Settings;
+	}
+
+	template<typename T>
+	void ReleaseLater(DeferredReleaseQueue* ReleaseQueue, ComPtr<T>& Object)
+	{
+		if (Object)
+		{
+			ReleaseQueue->ReleaseObject(Object.Detach());
+		}
+	}
+}
+
+D3D12StaticScene::D3D12StaticScene(ID3D12Device* Device, IFence* Fence, DeferredReleaseQueue* ReleaseQueue,
+	const D3D12StaticSceneSettings& Settings)
+	: mDevice(Device), mFence(Fence), mReleaseQueue(ReleaseQueue), mSettings(Settings), mObjects(nullptr)
+	, mPipelineStateId(0), mRootSignatureId(0), mFirstMaterial(0), mFirstMesh(0), mMeshCount(0)
+	, mBatcher(MakeBatcherSettings())
+	, mBundle(Device, ReleaseQueue), mBindingVersion(0), mRebindCount(0)
+{
+	Assert(Device);
+	Assert(Fence);
+	Assert(ReleaseQueue);
+	Assert(mSettings.ObjectCount > 0 && mSettings.MaterialCount > 0);
+}
+
+D3D12StaticScene::~D3D12StaticScene()
+{
+	//The rings point in to their buffers, so go first
+	mCache.reset();
+	mCacheRing.reset();
+	mFrameRing.reset();
+
+	mGpuMesh.Destroy(mReleaseQueue);
+	ReleaseLater(mReleaseQueue, mPipelineState);
+	ReleaseLater(mReleaseQueue, mRootSignature);
+	ReleaseLater(mReleaseQueue, mDescriptorHeap);
+	ReleaseLater(mReleaseQueue, mMaterialBuffer);
+	ReleaseLater(mReleaseQueue, mCacheRingBuffer);
+	ReleaseLater(mReleaseQueue, mFrameRingBuffer);
+}
+
+bool D3D12StaticScene::Create(const char* MeshFilename, ID3D12GraphicsCommandList* CommandList, D3D12RenderObjects& Objects,
+	DXGI_FORMAT RenderTargetFormat, DXGI_FORMAT DepthStencilFormat)
+{
+	Assert(!mObjects);
+	if (!mMesh.Load(MeshFilename))
+	{
+		mLastError = std::string("Couldn't load ") + MeshFilename;
+		return false;
+	}
+	mObjects = &Objects;
+
+	if (!CreatePipeline(RenderTargetFormat, DepthStencilFormat))
+	{
+		return false;
+	}
+	if (Objects.PipelineStates.size() >= (1u << DrawSortPipelineStateBits) ||
+		Objects.DescriptorTables.size() + mSettings.MaterialCount > (1u << DrawSortMaterialBits))
+	{
+		mLastError = "Too many pipeline states or materials for the sort key";
+		return false;
+	}
+
+	mPipelineStateId = static_cast<uint32_t>(Objects.PipelineStates.size());
+	Objects.PipelineStates.push_back(mPipelineState.Get());
+	mRootSignatureId = static_cast<uint32_t>(Objects.RootSignatures.size());
+	Objects.RootSignatures.push_back(mRootSignature.Get());
+
+	//A mesh id per first LOD submesh, all in the one buffer
+	mGpuMesh.Create(mDevice.Get(), CommandList, mReleaseQueue, mMesh);
+	const PackedMeshLod& Lod = mMesh.GetLod(0);
+	mFirstMesh = static_cast<uint32_t>(Objects.Meshes.size());
+	mMeshCount = Lod.SubmeshCount;
+	mMeshArgs.resize(mFirstMesh + mMeshCount);
+	for (uint32_t i = 0; i < mMeshCount; ++i)
+	{
+		const PackedMeshSubmesh& Submesh = mMesh.GetSubmesh(Lod.FirstSubmesh + i);
+		MeshDrawArgs& Args = mMeshArgs[mFirstMesh + i];
+		Args.IndexCount = Submesh.IndexCount;
+		Args.StartIndex = Submesh.IndexStart;
+		Args.BaseVertex = static_cast<int32_t>(Submesh.BaseVertex);
+		Objects.Meshes.push_back(&mGpuMesh);
+	}
+
+	CreateMaterials();
+	CreateObjects();
+
+	//The cache holds two versions so re-recording doesn't wait on the frame
+	//still executing the old one; uncached frames need one per frame in flight
+	const uint64_t SetBytes = static_cast<uint64_t>(mDraws.size()) * sizeof(StaticObject) + UploadRing::DefaultAlignment;
+	uint8_t* RingData = nullptr;
+	mCacheRingBuffer = CreateUploadBuffer(SetBytes * 2, &RingData);
+	mCacheRing.reset(new UploadRing(mFence, RingData, mCacheRingBuffer->GetGPUVirtualAddress(), SetBytes * 2));
+	mFrameRingBuffer = CreateUploadBuffer(SetBytes * 3, &RingData);
+	mFrameRing.reset(new UploadRing(mFence, RingData, mFrameRingBuffer->GetGPUVirtualAddress(), SetBytes * 3));
+
+	mCache.reset(new StaticCommandCache(mBatcher.GetSettings(), mCacheRing.get()));
+	mQueue.Reserve(static_cast<uint32_t>(mDraws.size()));
+	mStats.DrawsPerFrame = static_cast<uint32_t>(mDraws.size());
+	return true;
+}
+
+bool D3D12StaticScene::CreatePipeline(DXGI_FORMAT RenderTargetFormat, DXGI_FORMAT DepthStencilFormat)
+{
+	//Objects through a root SRV, the material's colour through a one SRV table
+	CD3DX12_DESCRIPTOR_RANGE MaterialRange;
+	MaterialRange.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 1);
+
+	CD3DX12_ROOT_PARAMETER RootParameters[2];
+	RootParameters[0].InitAsShaderResourceView(0, 0, D3D12_SHADER_VISIBILITY_VERTEX);
+	RootParameters[1].InitAsDescriptorTable(1, &MaterialRange, D3D12_SHADER_VISIBILITY_PIXEL);
+	Assert(mBatcher.GetSettings().InstanceDataRootParameter == 0 && mBatcher.GetSettings().MaterialRootParameter == 1);
+
+	CD3DX12_ROOT_SIGNATURE_DESC RootSignatureDesc(2, RootParameters, 0, nullptr,
+		D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
+	ComPtr<ID3DBlob> SerializedRootSignature;
+	ComPtr<ID3DBlob> Errors;
+	if (FAILED(D3D12SerializeRootSignature(&RootSignatureDesc, D3D_ROOT_SIGNATURE_VERSION_1,
+		SerializedRootSignature.GetAddressOf(), Errors.GetAddressOf())))
+	{
+		mLastError = "Couldn't serialise the root signature";
+		return false;
+	}
+	CheckHResult(mDevice->CreateRootSignature(0, SerializedRootSignature->GetBufferPointer(), SerializedRootSignature->GetBufferSize(),
+		IID_PPV_ARGS(mRootSignature.GetAddressOf())));
+
+	ComPtr<ID3DBlob> VertexShader;
+	ComPtr<ID3DBlob> PixelShader;
+	if (!CompileShader("VSMain", "vs_5_1", VertexShader, mLastError) || !CompileShader("PSMain", "ps_5_1", PixelShader, mLastError))
+	{
+		return false;
+	}
+
+	D3D12_INPUT_ELEMENT_DESC InputElements[PackedMeshStream_Count];
+	D3D12PackedMesh::GetInputElements(mMesh.GetHeader(), InputElements);
+
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC PipelineDesc = {};
+	PipelineDesc.pRootSignature = mRootSignature.Get();
+	PipelineDesc.VS = { VertexShader->GetBufferPointer(), VertexShader->GetBufferSize() };
+	PipelineDesc.PS = { PixelShader->GetBufferPointer(), PixelShader->GetBufferSize() };
+	PipelineDesc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
+	PipelineDesc.SampleMask = UINT_MAX;
+	PipelineDesc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
+	PipelineDesc.RasterizerState.CullMode = D3D12_CULL_MODE_NONE;
+	PipelineDesc.DepthStencilState = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
+	PipelineDesc.InputLayout = { InputElements, PackedMeshStream_Count };
+	PipelineDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+	PipelineDesc.NumRenderTargets = 1;
+	PipelineDesc.RTVFormats[0] = RenderTargetFormat;
+	PipelineDesc.DSVFormat = DepthStencilFormat;
+	PipelineDesc.SampleDesc.Count = 1;
+	CheckHResult(mDevice->CreateGraphicsPipelineState(&PipelineDesc, IID_PPV_ARGS(mPipelineState.GetAddressOf())));
+	return true;
+}
+
+void D3D12StaticScene::CreateMaterials()
+{
+	//One colour per material in a structured buffer, and a descriptor table
+	//of one SRV at each
+	uint8_t* MaterialData = nullptr;
+	mMaterialBuffer = CreateUploadBuffer(static_cast<uint64_t>(mSettings.MaterialCount) * sizeof(float) * 4, &MaterialData);
+	for (uint32_t i = 0; i < mSettings.MaterialCount; ++i)
+	{
+		float Hue = 6.0f * static_cast<float>(i) / static_cast<float>(mSettings.MaterialCount);
+		float Colour[4] =
+		{
+			std::min(std::max(fabsf(Hue - 3.0f) - 1.0f, 0.0f), 1.0f),
+			std::min(std::max(2.0f - fabsf(Hue - 2.0f), 0.0f), 1.0f),
+			std::min(std::max(2.0f - fabsf(Hue - 4.0f), 0.0f), 1.0f),
+			1.0f
+		};
+		memcpy(MaterialData + static_cast<size_t>(i) * sizeof(Colour), Colour, sizeof(Colour));
+	}
+
+	D3D12_DESCRIPTOR_HEAP_DESC HeapDesc = {};
+	HeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+	HeapDesc.NumDescriptors = mSettings.MaterialCount;
+	HeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+	CheckHResult(mDevice->CreateDescriptorHeap(&HeapDesc, IID_PPV_ARGS(mDescriptorHeap.GetAddressOf())));
+
+	UINT DescriptorStride = mDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+	mFirstMaterial = static_cast<uint32_t>(mObjects->DescriptorTables.size());
+	for (uint32_t i = 0; i < mSettings.MaterialCount; ++i)
+	{
+		D3D12_SHADER_RESOURCE_VIEW_DESC ViewDesc = {};
+		ViewDesc.Format = DXGI_FORMAT_UNKNOWN;
+		ViewDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
+		ViewDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+		ViewDesc.Buffer.FirstElement = i;
+		ViewDesc.Buffer.NumElements = 1;
+		ViewDesc.Buffer.StructureByteStride = sizeof(float) * 4;
+		mDevice->CreateShaderResourceView(mMaterialBuffer.Get(), &ViewDesc,
+			CD3DX12_CPU_DESCRIPTOR_HANDLE(mDescriptorHeap->GetCPUDescriptorHandleForHeapStart(), i, DescriptorStride));
+
+		mObjects->DescriptorTables.push_back(
+			CD3DX12_GPU_DESCRIPTOR_HANDLE(mDescriptorHeap->GetGPUDescriptorHandleForHeapStart(), i, DescriptorStride));
+	}
+}
+
+void D3D12StaticScene::CreateObjects()
+{
+	//A grid over the screen, each object filling most of its cell
+	uint32_t Side = static_cast<uint32_t>(ceil(sqrt(static_cast<double>(mSettings.ObjectCount))));
+	float CellSize = 2.0f / static_cast<float>(Side);
+
+	mInstanceData.resize(static_cast<size_t>(mSettings.ObjectCount) * sizeof(StaticObject));
+	mDraws.clear();
+	mDraws.reserve(static_cast<size_t>(mSettings.ObjectCount) * mMeshCount);
+	for (uint32_t i = 0; i < mSettings.ObjectCount; ++i)
+	{
+		StaticObject Object =
+		{
+			{ -1.0f + CellSize * (static_cast<float>(i % Side) + 0.5f), -1.0f + CellSize * (static_cast<float>(i / Side) + 0.5f), 0.5f, 1.0f },
+			{ CellSize * 0.8f, CellSize * 0.8f, 0.4f, 0.0f }
+		};
+		memcpy(&mInstanceData[static_cast<size_t>(i) * sizeof(StaticObject)], &Object, sizeof(Object));
+
+		for (uint32_t Submesh = 0; Submesh < mMeshCount; ++Submesh)
+		{
+			DrawPacket Packet = DrawPacket();
+			Packet.Pass = OpaquePass;
+			Packet.PipelineState = mPipelineStateId;
+			Packet.RootSignature = mRootSignatureId;
+			Packet.Material = mFirstMaterial + (i + Submesh) % mSettings.MaterialCount;
+			Packet.Mesh = mFirstMesh + Submesh;
+			Packet.Instance = i;
+			Packet.Depth = 1.0f;
+			mDraws.push_back(Packet);
+		}
+	}
+}
+
+ComPtr<ID3D12Resource> D3D12StaticScene::CreateUploadBuffer(uint64_t Size, uint8_t** OutData)
+{
+	ComPtr<ID3D12Resource> Buffer;
+	D3D12_HEAP_PROPERTIES UploadHeapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
+	D3D12_RESOURCE_DESC BufferDesc = CD3DX12_RESOURCE_DESC::Buffer(Size);
+	CheckHResult(mDevice->CreateCommittedResource(&UploadHeapProps, D3D12_HEAP_FLAG_NONE,
+		&BufferDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(Buffer.GetAddressOf())));
+
+	//Stays mapped until it's released
+	D3D12_RANGE ReadRange = { 0, 0 };
+	CheckHResult(Buffer->Map(0, &ReadRange, reinterpret_cast<void**>(OutData)));
+	return Buffer;
+}
+
+void D3D12StaticScene::Rebind()
+{
+	//A sixteenth of the objects at a time move to the next material, as a
+	//material swap or a streamed in texture set would
+	uint32_t Slice = mRebindCount++ % 16;
+	for (DrawPacket& Packet : mDraws)
+	{
+		if (Packet.Instance % 16 == Slice)
+		{
+			Packet.Material = mFirstMaterial + (Packet.Material - mFirstMaterial + 1) % mSettings.MaterialCount;
+		}
+	}
+	++mBindingVersion;
+}
+
+void D3D12StaticScene::FillQueue()
+{
+	mQueue.Clear();
+	for (const DrawPacket& Packet : mDraws)
+	{
+		mQueue.Add(Packet, DrawSortMode::Opaque);
+	}
+	mQueue.Sort();
+}
+
+void D3D12StaticScene::Render(ID3D12GraphicsCommandList* CommandList, StateFilteringCommandList& Commands)
+{
+	Assert(mObjects);
+	Clock::time_point Start = Clock::now();
+
+	if (mSettings.RebindInterval > 0 && mStats.Frames > 0 && mStats.Frames % mSettings.RebindInterval == 0)
+	{
+		Rebind();
+	}
+
+	ID3D12DescriptorHeap* Heaps[] = { mDescriptorHeap.Get() };
+	CommandList->SetDescriptorHeaps(1, Heaps);
+
+	if (mSettings.bCached)
+	{
+		//Filled, sorted and batched only when the materials change
+		if (!mCache->IsValid(mBindingVersion))
+		{
+			FillQueue();
+			mCache->Record(mBindingVersion, mQueue.GetDraws(), mQueue.GetCount(), mMeshArgs.data(), mInstanceData.data());
+			++mStats.CacheRecords;
+		}
+		mBundle.Update(*mCache, *mObjects, mDescriptorHeap.Get());
+		mBundle.Execute(CommandList, Commands);
+	}
+	else
+	{
+		FillQueue();
+		mBatcher.Record(mQueue.GetDraws(), mQueue.GetCount(), mMeshArgs.data(), mInstanceData.data(), *mFrameRing, Commands);
+		mFrameRing->EndFrame();
+	}
+
+	double Milliseconds = MillisecondsSince(Start);
+	mStats.RecordMilliseconds += Milliseconds;
+	mStats.WorstRecordMilliseconds = std::max(mStats.WorstRecordMilliseconds, Milliseconds);
+	mStats.RingStalls = mCacheRing->GetStallCount() + mFrameRing->GetStallCount();
+	++mStats.Frames;
+}
+
+bool D3D12StaticScene::WriteReport(const char* Filename) const
+{
+	FILE* File = fopen(Filename, "w");
+	if (!File)
+	{
+		return false;
+	}
+
+	fprintf(File, "Objects:         %u\n", mSettings.ObjectCount);
+	fprintf(File, "Submeshes:       %u\n", mMeshCount);
+	fprintf(File, "Materials:       %u\n", mSettings.MaterialCount);
+	fprintf(File, "Rebind interval: %u\n\n", mSettings.RebindInterval);
+
+	fprintf(File, "Mode,Draws,Frames,RecordMsPerFrame,WorstRecordMs,CacheRecords,RingStalls\n");
+	fprintf(File, "%s,%u,%u,%.3f,%.3f,%u,%llu\n", mSettings.bCached ? "Cached" : "Uncached", mStats.DrawsPerFrame, mStats.Frames,
+		mStats.Frames > 0 ? mStats.RecordMilliseconds / mStats.Frames : 0.0, mStats.WorstRecordMilliseconds, mStats.CacheRecords,
+		static_cast<unsigned long long>(mStats.RingStalls));
+
+	fclose(File);
+	return true;
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <windows.h>
+#include <wrl.h>
+#include <d3d12.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "D3D12PackedMesh.h"
+#include "D3D12RenderCommandList.h"
+#include "D3D12StaticBundle.h"
+#include "DrawQueue.h"
+#include "InstanceBatcher.h"
+#include "PackedMesh.h"
+#include "StaticCommandCache.h"
+#include "UploadRing.h"
+
+class DeferredReleaseQueue;
+class IFence;
+class StateFilteringCommandList;
+
+struct D3D12StaticSceneSettings
+{
+	uint32_t ObjectCount = 10000;
+	uint32_t MaterialCount = 64;
+	uint32_t RebindInterval = 0;	//Frames between giving some objects new materials, 0 for never
+	bool bCached = false;
+};
+
+struct D3D12StaticSceneStats
+{
+	uint32_t Frames = 0;
+	uint32_t DrawsPerFrame = 0;
+	double RecordMilliseconds = 0.0;		//Whole run
+	double WorstRecordMilliseconds = 0.0;
+	uint32_t CacheRecords = 0;
+	uint64_t RingStalls = 0;
+};
+
+//Static geometry for RenderScene: ObjectCount copies of a PackedMesh's first
+//LOD in a grid over the screen, a draw per submesh, each object with one of
+//MaterialCount flat colour materials.
+//
+//Uncached, every frame fills a DrawQueue with the whole set, sorts it and
+//records it through InstanceBatcher, as a renderer without caching would.
+//Cached, the set is recorded in to a StaticCommandCache - and from that a
+//D3D12StaticBundle - only when its key changes, and every frame executes the
+//bundle. The key is the material binding version: every RebindInterval frames
+//a sixteenth of the objects move to the next material, which changes it.
+//Render() is timed on the CPU either way, for WriteReport().
+//
+//Create() adds the scene's pipeline state, root signature, material tables
+//and meshes to the renderer's objects; the filter Render() records through
+//must be over a D3D12RenderCommandList using them.
+class D3D12StaticScene
+{
+public:
+	D3D12StaticScene(ID3D12Device* Device, IFence* Fence, DeferredReleaseQueue* ReleaseQueue,
+		const D3D12StaticSceneSettings& Settings);
+	~D3D12StaticScene();
+
+	//Records the mesh upload on CommandList; the scene can render once that
+	//has executed. Objects must outlive the scene.
+	bool Create(const char* MeshFilename, ID3D12GraphicsCommandList* CommandList, D3D12RenderObjects& Objects,
+		DXGI_FORMAT RenderTargetFormat, DXGI_FORMAT DepthStencilFormat);
+
+	//After the render targets and viewport are set. Commands must be the
+	//filter over CommandList.
+	void Render(ID3D12GraphicsCommandList* CommandList, StateFilteringCommandList& Commands);
+
+	bool WriteReport(const char* Filename) const;
+
+	const D3D12StaticSceneStats& GetStats() const { return mStats; }
+	const std::string& GetLastError() const { return mLastError; }
+
+private:
+	D3D12StaticScene(const D3D12StaticScene&) = delete;
+	D3D12StaticScene& operator=(const D3D12StaticScene&) = delete;
+
+	bool CreatePipeline(DXGI_FORMAT RenderTargetFormat, DXGI_FORMAT DepthStencilFormat);
+	void CreateMaterials();
+	void CreateObjects();
+	Microsoft::WRL::ComPtr<ID3D12Resource> CreateUploadBuffer(uint64_t Size, uint8_t** OutData);
+
+	void Rebind();
+	void FillQueue();
+
+private:
+	Microsoft::WRL::ComPtr<ID3D12Device> mDevice;
+	IFence* mFence;
+	DeferredReleaseQueue* mReleaseQueue;
+	D3D12StaticSceneSettings mSettings;
+	D3D12RenderObjects* mObjects;
+
+	PackedMesh mMesh;
+	D3D12PackedMesh mGpuMesh;
+
+	Microsoft::WRL::ComPtr<ID3D12RootSignature> mRootSignature;
+	Microsoft::WRL::ComPtr<ID3D12PipelineState> mPipelineState;
+	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> mDescriptorHeap;
+	Microsoft::WRL::ComPtr<ID3D12Resource> mMaterialBuffer;
+
+	//Instance data: the cache's versions, and each uncached frame's
+	Microsoft::WRL::ComPtr<ID3D12Resource> mCacheRingBuffer;
+	Microsoft::WRL::ComPtr<ID3D12Resource> mFrameRingBuffer;
+	std::unique_ptr<UploadRing> mCacheRing;
+	std::unique_ptr<UploadRing> mFrameRing;
+
+	//Ids in to mObjects
+	uint32_t mPipelineStateId;
+	uint32_t mRootSignatureId;
+	uint32_t mFirstMaterial;
+	uint32_t mFirstMesh;
+	uint32_t mMeshCount;
+
+	std::vector<DrawPacket> mDraws;			//The whole set, with current materials
+	std::vector<MeshDrawArgs> mMeshArgs;	//Indexed by mesh id
+	std::vector<uint8_t> mInstanceData;
+
+	InstanceBatcher mBatcher;
+	DrawQueue mQueue;
+	std::unique_ptr<StaticCommandCache> mCache;
+	D3D12StaticBundle mBundle;
+
+	uint64_t mBindingVersion;
+	uint32_t mRebindCount;
+
+	D3D12StaticSceneStats mStats;
+	std::string mLastError;
+};
@@ -0,0 +1,386 @@
+#include "D3D12TextureStreamingBackend.h"
+#include "Common.h"
+#include "DeferredReleaseQueue.h"
+
+#include "d3dx12.h"
+
+#include <algorithm>
+
+using namespace Microsoft::WRL;
+
+D3D12TextureStreamingBackend::D3D12TextureStreamingBackend(ID3D12Device* Device, ITextureMipSource* MipSource,
+	DeferredReleaseQueue* ReleaseQueue, uint64_t UploadBufferSize)
+	: mDevice(Device), mMipSource(MipSource), mReleaseQueue(ReleaseQueue),
+	mCopyFenceValue(0), mCopyFenceEvent(0), mUploadBufferData(nullptr),
+	mUploadBufferSize(UploadBufferSize), mUploadBufferOffset(0), mShutdown(false)
+{
+	Assert(Device);
+	Assert(MipSource);
+	Assert(ReleaseQueue);
+
+	//Copy queue
+	D3D12_COMMAND_QUEUE_DESC CommandQueueDesc = {};
+	CommandQueueDesc.Type = D3D12_COMMAND_LIST_TYPE_COPY;
+	CommandQueueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+	CommandQueueDesc.NodeMask = 0;
+	CheckHResult(mDevice->CreateCommandQueue(&CommandQueueDesc, IID_PPV_ARGS(mCopyQueue.GetAddressOf())));
+
+	CheckHResult(mDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY,
+		IID_PPV_ARGS(mCopyAllocator.GetAddressOf())));
+
+	CheckHResult(mDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COPY,
+		mCopyAllocator.Get(), nullptr, IID_PPV_ARGS(mCopyCommandList.GetAddressOf())));
+	CheckHResult(mCopyCommandList->Close());
+
+	CheckHResult(mDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(mCopyFence.GetAddressOf())));
+	mCopyFenceEvent = CreateEventEx(nullptr, false, false, EVENT_ALL_ACCESS);
+
+	//Upload buffer - stays mapped for the lifetime of the backend
+	D3D12_HEAP_PROPERTIES UploadHeapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
+	D3D12_RESOURCE_DESC UploadBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(mUploadBufferSize);
+	CheckHResult(mDevice->CreateCommittedResource(&UploadHeapProps, D3D12_HEAP_FLAG_NONE,
+		&UploadBufferDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr,
+		IID_PPV_ARGS(mUploadBuffer.GetAddressOf())));
+
+	D3D12_RANGE ReadRange = { 0, 0 };
+	CheckHResult(mUploadBuffer->Map(0, &ReadRange, reinterpret_cast<void**>(&mUploadBufferData)));
+
+	mCopyThread = std::thread(&D3D12TextureStreamingBackend::CopyThreadMain, this);
+}
+
+D3D12TextureStreamingBackend::~D3D12TextureStreamingBackend()
+{
+	{
+		std::lock_guard<std::mutex> Lock(mMutex);
+		mShutdown = true;
+	}
+	mWorkAvailable.notify_all();
+	mCopyThread.join();
+
+	mUploadBuffer->Unmap(0, nullptr);
+	CloseHandle(mCopyFenceEvent);
+}
+
+uint32_t D3D12TextureStreamingBackend::OnTextureRegistered(StreamedTextureHandle Texture, const StreamedTextureDesc& Desc)
+{
+	//Every upload is staged whole in one batch, so a job bigger than the upload
+	//buffer could never be recorded. The packed tail goes up as one job and
+	//every other mip on its own; footprints of a mip are the same whichever mip
+	//the texture it's uploaded to starts at.
+	D3D12_RESOURCE_DESC TextureDesc = CD3DX12_RESOURCE_DESC::Tex2D(static_cast<DXGI_FORMAT>(Desc.Format),
+		Desc.Width, Desc.Height, 1, static_cast<UINT16>(Desc.MipCount));
+	uint32_t FirstTailMip = Desc.MipCount - Desc.PackedTailMipCount;
+
+	UINT64 TailBytes = 0;
+	mDevice->GetCopyableFootprints(&TextureDesc, FirstTailMip, Desc.PackedTailMipCount, 0, nullptr, nullptr, nullptr, &TailBytes);
+	if (TailBytes > mUploadBufferSize)
+	{
+		return Desc.MipCount;
+	}
+
+	uint32_t FinestMip = FirstTailMip;
+	while (FinestMip > 0)
+	{
+		UINT64 MipBytes = 0;
+		mDevice->GetCopyableFootprints(&TextureDesc, FinestMip - 1, 1, 0, nullptr, nullptr, nullptr, &MipBytes);
+		if (MipBytes > mUploadBufferSize)
+		{
+			break;
+		}
+		--FinestMip;
+	}
+
+	std::lock_guard<std::mutex> Lock(mMutex);
+
+	if (Texture >= mTextures.size())
+	{
+		mTextures.resize(Texture + 1);
+	}
+
+	TextureRecord& Record = mTextures[Texture];
+	Record.Desc = Desc;
+	Record.bRegistered = true;
+	Record.Resource.Reset();
+	Record.ResidentMip = Desc.MipCount;
+	++Record.Generation;
+	return FinestMip;
+}
+
+void D3D12TextureStreamingBackend::OnTextureUnregistered(StreamedTextureHandle Texture)
+{
+	std::lock_guard<std::mutex> Lock(mMutex);
+
+	//Jobs that haven't started are dropped. One that is currently on the copy
+	//queue is discarded when it finishes thanks to the generation bump.
+	mPendingJobs.erase(std::remove_if(mPendingJobs.begin(), mPendingJobs.end(),
+		[Texture](const CopyJob& Job) { return Job.Texture == Texture; }), mPendingJobs.end());
+
+	mCompletedUploads.erase(std::remove_if(mCompletedUploads.begin(), mCompletedUploads.end(),
+		[Texture](const MipUploadRequest& Request) { return Request.Texture == Texture; }), mCompletedUploads.end());
+
+	TextureRecord& Record = mTextures[Texture];
+	mReleaseQueue->ReleaseObject(Record.Resource.Detach());
+
+	Record.bRegistered = false;
+	++Record.Generation;
+}
+
+void D3D12TextureStreamingBackend::SubmitMipUpload(const MipUploadRequest& Request)
+{
+	{
+		std::lock_guard<std::mutex> Lock(mMutex);
+
+		CopyJob Job = {};
+		Job.Type = CopyJobType::Upload;
+		Job.Texture = Request.Texture;
+		Job.Generation = mTextures[Request.Texture].Generation;
+		Job.Request = Request;
+		mPendingJobs.push_back(Job);
+	}
+	mWorkAvailable.notify_one();
+}
+
+void D3D12TextureStreamingBackend::CollectCompletedUploads(std::vector<MipUploadRequest>& OutCompleted)
+{
+	std::lock_guard<std::mutex> Lock(mMutex);
+
+	OutCompleted.insert(OutCompleted.end(), mCompletedUploads.begin(), mCompletedUploads.end());
+	mCompletedUploads.clear();
+
+	//Textures replaced since last frame may still be referenced by work on the
+	//direct queue. The release queue is main thread only, which is why this
+	//isn't done by the copy thread.
+	for (ComPtr<ID3D12Resource>& Retired : mRetiredResources)
+	{
+		mReleaseQueue->ReleaseObject(Retired.Detach());
+	}
+	mRetiredResources.clear();
+}
+
+void D3D12TextureStreamingBackend::EvictMips(StreamedTextureHandle Texture, uint32_t NewResidentMip)
+{
+	{
+		std::lock_guard<std::mutex> Lock(mMutex);
+
+		//Consecutive evictions of the same texture (the streamer drops one mip at
+		//a time) collapse in to a single resource rebuild.
+		if (!mPendingJobs.empty())
+		{
+			CopyJob& Last = mPendingJobs.back();
+			if (Last.Type == CopyJobType::Evict && Last.Texture == Texture)
+			{
+				Last.NewResidentMip = NewResidentMip;
+				return;
+			}
+		}
+
+		CopyJob Job = {};
+		Job.Type = CopyJobType::Evict;
+		Job.Texture = Texture;
+		Job.Generation = mTextures[Texture].Generation;
+		Job.NewResidentMip = NewResidentMip;
+		mPendingJobs.push_back(Job);
+	}
+	mWorkAvailable.notify_one();
+}
+
+ID3D12Resource* D3D12TextureStreamingBackend::GetResource(StreamedTextureHandle Texture, uint32_t* OutResidentMip) const
+{
+	std::lock_guard<std::mutex> Lock(mMutex);
+
+	const TextureRecord& Record = mTextures[Texture];
+	if (OutResidentMip)
+	{
+		*OutResidentMip = Record.ResidentMip;
+	}
+	return Record.Resource.Get();
+}
+
+void D3D12TextureStreamingBackend::CopyThreadMain()
+{
+	std::vector<CopyJob> Batch;
+	std::vector<FinishedJob> Finished;
+
+	while (true)
+	{
+		//Grab everything queued - at most one job per texture per batch as each
+		//job reads the resource published by the previous one.
+		Batch.clear();
+		{
+			std::unique_lock<std::mutex> Lock(mMutex);
+			mWorkAvailable.wait(Lock, [this]() { return mShutdown || !mPendingJobs.empty(); });
+
+			if (mShutdown)
+			{
+				break;
+			}
+
+			for (auto It = mPendingJobs.begin(); It != mPendingJobs.end();)
+			{
+				bool bTextureInBatch = std::any_of(Batch.begin(), Batch.end(),
+					[&It](const CopyJob& Job) { return Job.Texture == It->Texture; });
+				if (bTextureInBatch)
+				{
+					++It;
+					continue;
+				}
+
+				Batch.push_back(*It);
+				It = mPendingJobs.erase(It);
+			}
+		}
+
+		CheckHResult(mCopyAllocator->Reset());
+		CheckHResult(mCopyCommandList->Reset(mCopyAllocator.Get(), nullptr));
+		mUploadBufferOffset = 0;
+
+		Finished.clear();
+		size_t Recorded = 0;
+		for (; Recorded < Batch.size(); ++Recorded)
+		{
+			FinishedJob Done;
+			if (!RecordJob(Batch[Recorded], Done))
+			{
+				//Out of staging memory - the rest goes in the next batch. Registration
+				//keeps every job small enough for an empty buffer.
+				Check(Recorded > 0);
+				break;
+			}
+			Finished.push_back(Done);
+		}
+
+		if (Recorded < Batch.size())
+		{
+			std::lock_guard<std::mutex> Lock(mMutex);
+			mPendingJobs.insert(mPendingJobs.begin(), Batch.begin() + Recorded, Batch.end());
+		}
+
+		ExecuteAndWait();
+		PublishFinishedJobs(Finished);
+	}
+}
+
+bool D3D12TextureStreamingBackend::RecordJob(const CopyJob& Job, FinishedJob& OutFinished)
+{
+	StreamedTextureDesc Desc;
+	ComPtr<ID3D12Resource> OldResource;
+	uint32_t OldResidentMip;
+	{
+		std::lock_guard<std::mutex> Lock(mMutex);
+
+		const TextureRecord& Record = mTextures[Job.Texture];
+		Desc = Record.Desc;
+		OldResource = Record.Resource;
+		OldResidentMip = Record.ResidentMip;
+	}
+
+	uint32_t NewResidentMip = (Job.Type == CopyJobType::Upload) ? Job.Request.FirstMip : Job.NewResidentMip;
+	uint32_t NewMipLevels = Desc.MipCount - NewResidentMip;
+
+	D3D12_RESOURCE_DESC TextureDesc = CD3DX12_RESOURCE_DESC::Tex2D(static_cast<DXGI_FORMAT>(Desc.Format),
+		std::max(1u, Desc.Width >> NewResidentMip), std::max(1u, Desc.Height >> NewResidentMip),
+		1, static_cast<UINT16>(NewMipLevels));
+
+	//Staging space for the new mips (placed footprints for subresources 0..N of the new texture)
+	uint32_t UploadMipCount = (Job.Type == CopyJobType::Upload) ? (OldResidentMip - NewResidentMip) : 0;
+	D3D12_PLACED_SUBRESOURCE_FOOTPRINT Layouts[D3D12_REQ_MIP_LEVELS];
+	UINT RowCounts[D3D12_REQ_MIP_LEVELS];
+	UINT64 RowSizes[D3D12_REQ_MIP_LEVELS];
+
+	if (UploadMipCount > 0)
+	{
+		uint64_t BaseOffset = (mUploadBufferOffset + D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1) &
+			~static_cast<uint64_t>(D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1);
+
+		UINT64 TotalBytes = 0;
+		mDevice->GetCopyableFootprints(&TextureDesc, 0, UploadMipCount, BaseOffset,
+			Layouts, RowCounts, RowSizes, &TotalBytes);
+
+		if (BaseOffset + TotalBytes > mUploadBufferSize)
+		{
+			return false;
+		}
+		mUploadBufferOffset = BaseOffset + TotalBytes;
+
+		for (uint32_t i = 0; i < UploadMipCount; ++i)
+		{
+			mMipSource->ReadMip(Job.Texture, NewResidentMip + i, mUploadBufferData + Layouts[i].Offset,
+				Layouts[i].Footprint.RowPitch, RowCounts[i], RowSizes[i]);
+		}
+	}
+
+	//Starts in COMMON - implicitly promoted to COPY_DEST on the copy queue and
+	//decays back once the copy queue is done with it.
+	ComPtr<ID3D12Resource> NewResource;
+	D3D12_HEAP_PROPERTIES DefaultHeapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+	CheckHResult(mDevice->CreateCommittedResource(&DefaultHeapProps, D3D12_HEAP_FLAG_NONE,
+		&TextureDesc, D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(NewResource.GetAddressOf())));
+
+	for (uint32_t i = 0; i < UploadMipCount; ++i)
+	{
+		CD3DX12_TEXTURE_COPY_LOCATION Dest(NewResource.Get(), i);
+		CD3DX12_TEXTURE_COPY_LOCATION Source(mUploadBuffer.Get(), Layouts[i]);
+		mCopyCommandList->CopyTextureRegion(&Dest, 0, 0, 0, &Source, nullptr);
+	}
+
+	//Carry across the mips we keep
+	if (OldResource)
+	{
+		for (uint32_t Mip = std::max(OldResidentMip, NewResidentMip); Mip < Desc.MipCount; ++Mip)
+		{
+			CD3DX12_TEXTURE_COPY_LOCATION Dest(NewResource.Get(), Mip - NewResidentMip);
+			CD3DX12_TEXTURE_COPY_LOCATION Source(OldResource.Get(), Mip - OldResidentMip);
+			mCopyCommandList->CopyTextureRegion(&Dest, 0, 0, 0, &Source, nullptr);
+		}
+	}
+
+	OutFinished.Job = Job;
+	OutFinished.NewResource = NewResource;
+	OutFinished.NewResidentMip = NewResidentMip;
+	return true;
+}
+
+void D3D12TextureStreamingBackend::ExecuteAndWait()
+{
+	CheckHResult(mCopyCommandList->Close());
+
+	ID3D12CommandList* CommandListsToSubmit[] = { mCopyCommandList.Get() };
+	mCopyQueue->ExecuteCommandLists(1, CommandListsToSubmit);
+
+	//Waiting here only blocks the copy thread, never the frame.
+	++mCopyFenceValue;
+	CheckHResult(mCopyQueue->Signal(mCopyFence.Get(), mCopyFenceValue));
+	if (mCopyFence->GetCompletedValue() < mCopyFenceValue)
+	{
+		CheckHResult(mCopyFence->SetEventOnCompletion(mCopyFenceValue, mCopyFenceEvent));
+		WaitForSingleObject(mCopyFenceEvent, INFINITE);
+	}
+}
+
+void D3D12TextureStreamingBackend::PublishFinishedJobs(std::vector<FinishedJob>& Finished)
+{
+	std::lock_guard<std::mutex> Lock(mMutex);
+
+	for (FinishedJob& Done : Finished)
+	{
+		TextureRecord& Record = mTextures[Done.Job.Texture];
+		if (!Record.bRegistered || Record.Generation != Done.Job.Generation)
+		{
+			//Texture went away while we were copying.
+			continue;
+		}
+
+		if (Record.Resource)
+		{
+			mRetiredResources.push_back(Record.Resource);
+		}
+
+		Record.Resource = Done.NewResource;
+		Record.ResidentMip = Done.NewResidentMip;
+
+		if (Done.Job.Type == CopyJobType::Upload)
+		{
+			mCompletedUploads.push_back(Done.Job.Request);
+		}
+	}
+}
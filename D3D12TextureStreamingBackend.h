@@ -0,0 +1,123 @@
+#pragma once
+
+#include <windows.h>
+#include <wrl.h>
+#include <d3d12.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "TextureStreamer.h"
+
+class DeferredReleaseQueue;
+
+//Supplies the texel data for a mip. Called from the copy thread.
+class ITextureMipSource
+{
+public:
+	ITextureMipSource() {};
+	virtual ~ITextureMipSource() {};
+
+	//Write RowCount rows of RowSizeInBytes each to Dest, rows DestRowPitch bytes apart.
+	virtual void ReadMip(StreamedTextureHandle Texture, uint32_t Mip,
+		uint8_t* Dest, uint64_t DestRowPitch, uint32_t RowCount, uint64_t RowSizeInBytes) = 0;
+};
+
+//Streams mips in through a dedicated copy queue serviced by a background thread.
+//
+//Committed textures can't grow or shrink their mip chain, so every residency
+//change creates a new texture holding exactly the resident mips (its mip 0 is
+//the texture's ResidentMip) and copies the surviving mips across on the copy
+//queue. The old texture goes to the DeferredReleaseQueue so it is only freed
+//once the direct queue can no longer be referencing it. SRVs must be recreated
+//when GetResource() changes.
+class D3D12TextureStreamingBackend : public ITextureStreamingBackend
+{
+public:
+	D3D12TextureStreamingBackend(ID3D12Device* Device, ITextureMipSource* MipSource,
+		DeferredReleaseQueue* ReleaseQueue, uint64_t UploadBufferSize);
+	~D3D12TextureStreamingBackend();
+
+	//Limits the texture to the mips whose upload fits the upload buffer on its own
+	uint32_t OnTextureRegistered(StreamedTextureHandle Texture, const StreamedTextureDesc& Desc) override;
+	void OnTextureUnregistered(StreamedTextureHandle Texture) override;
+
+	void SubmitMipUpload(const MipUploadRequest& Request) override;
+	void CollectCompletedUploads(std::vector<MipUploadRequest>& OutCompleted) override;
+
+	void EvictMips(StreamedTextureHandle Texture, uint32_t NewResidentMip) override;
+
+	//Current resource for a texture and the global mip its mip 0 corresponds to.
+	ID3D12Resource* GetResource(StreamedTextureHandle Texture, uint32_t* OutResidentMip) const;
+
+private:
+	enum class CopyJobType
+	{
+		Upload,
+		Evict
+	};
+
+	struct CopyJob
+	{
+		CopyJobType Type;
+		StreamedTextureHandle Texture;
+		uint32_t Generation;
+		MipUploadRequest Request;	//Upload only
+		uint32_t NewResidentMip;	//Evict only
+	};
+
+	struct TextureRecord
+	{
+		StreamedTextureDesc Desc;
+		bool bRegistered = false;
+		uint32_t Generation = 0;
+
+		//Published state - what the renderer should be using.
+		Microsoft::WRL::ComPtr<ID3D12Resource> Resource;
+		uint32_t ResidentMip = 0;
+	};
+
+	struct FinishedJob
+	{
+		CopyJob Job;
+		Microsoft::WRL::ComPtr<ID3D12Resource> NewResource;
+		uint32_t NewResidentMip;
+	};
+
+	void CopyThreadMain();
+	bool RecordJob(const CopyJob& Job, FinishedJob& OutFinished);
+	void ExecuteAndWait();
+	void PublishFinishedJobs(std::vector<FinishedJob>& Finished);
+
+private:
+	Microsoft::WRL::ComPtr<ID3D12Device> mDevice;
+	ITextureMipSource* mMipSource;
+	DeferredReleaseQueue* mReleaseQueue;
+
+	//Copy queue + its own fence so uploads never wait on the direct queue
+	Microsoft::WRL::ComPtr<ID3D12CommandQueue> mCopyQueue;
+	Microsoft::WRL::ComPtr<ID3D12CommandAllocator> mCopyAllocator;
+	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> mCopyCommandList;
+	Microsoft::WRL::ComPtr<ID3D12Fence> mCopyFence;
+	uint64_t mCopyFenceValue;
+	HANDLE mCopyFenceEvent;
+
+	//Persistently mapped staging memory, linearly allocated per batch
+	Microsoft::WRL::ComPtr<ID3D12Resource> mUploadBuffer;
+	uint8_t* mUploadBufferData;
+	uint64_t mUploadBufferSize;
+	uint64_t mUploadBufferOffset;
+
+	//Shared between the main and copy thread
+	mutable std::mutex mMutex;
+	std::condition_variable mWorkAvailable;
+	std::deque<CopyJob> mPendingJobs;
+	std::vector<TextureRecord> mTextures;
+	std::vector<MipUploadRequest> mCompletedUploads;
+	std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> mRetiredResources;	//Replaced by the copy thread, released from the main thread
+	bool mShutdown;
+
+	std::thread mCopyThread;
+};
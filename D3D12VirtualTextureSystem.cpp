@@ -0,0 +1,275 @@
+#include "D3D12VirtualTextureSystem.h"
+#include "Common.h"
+#include "DeferredReleaseQueue.h"
+
+#include "d3dx12.h"
+
+#include <algorithm>
+
+using namespace Microsoft::WRL;
+
+D3D12VirtualTextureSystem::D3D12VirtualTextureSystem(ID3D12Device* Device, IVirtualTextureTileSource* TileSource,
+	DeferredReleaseQueue* ReleaseQueue, uint32_t PhysicalTileCount, uint32_t MaxNewPagesPerFrame, uint32_t FramesInFlight)
+	: mDevice(Device), mTileSource(TileSource), mReleaseQueue(ReleaseQueue), mPageManager(PhysicalTileCount), mUploadBufferData(nullptr),
+	mMaxNewPagesPerFrame(MaxNewPagesPerFrame), mFramesInFlight(FramesInFlight), mCurrentSlice(0)
+{
+	Assert(Device);
+	Assert(TileSource);
+	Assert(ReleaseQueue);
+
+	D3D12_FEATURE_DATA_D3D12_OPTIONS Options = {};
+	CheckHResult(mDevice->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &Options, sizeof(Options)));
+	Check(Options.TiledResourcesTier != D3D12_TILED_RESOURCES_TIER_NOT_SUPPORTED);
+
+	//Physical tile pool - one 64KB tile per page
+	D3D12_HEAP_DESC TileHeapDesc = {};
+	TileHeapDesc.SizeInBytes = static_cast<UINT64>(PhysicalTileCount) * D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES;
+	TileHeapDesc.Properties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+	TileHeapDesc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+	TileHeapDesc.Flags = D3D12_HEAP_FLAG_DENY_BUFFERS | D3D12_HEAP_FLAG_DENY_RT_DS_TEXTURES;
+	CheckHResult(mDevice->CreateHeap(&TileHeapDesc, IID_PPV_ARGS(mTileHeap.GetAddressOf())));
+
+	//Upload slices
+	UINT64 UploadBufferSize = static_cast<UINT64>(mMaxNewPagesPerFrame) * mFramesInFlight * D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES;
+	D3D12_HEAP_PROPERTIES UploadHeapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
+	D3D12_RESOURCE_DESC UploadBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(UploadBufferSize);
+	CheckHResult(mDevice->CreateCommittedResource(&UploadHeapProps, D3D12_HEAP_FLAG_NONE,
+		&UploadBufferDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr,
+		IID_PPV_ARGS(mUploadBuffer.GetAddressOf())));
+
+	D3D12_RANGE ReadRange = { 0, 0 };
+	CheckHResult(mUploadBuffer->Map(0, &ReadRange, reinterpret_cast<void**>(&mUploadBufferData)));
+}
+
+D3D12VirtualTextureSystem::~D3D12VirtualTextureSystem()
+{
+	mUploadBuffer->Unmap(0, nullptr);
+}
+
+VirtualTextureHandle D3D12VirtualTextureSystem::CreateTexture(ID3D12CommandQueue* Queue, ID3D12GraphicsCommandList* CommandList,
+	DXGI_FORMAT Format, uint32_t Width, uint32_t Height, uint32_t MipCount)
+{
+	TextureRecord Record = {};
+
+	//Reserved resource - no memory until tiles are mapped
+	D3D12_RESOURCE_DESC TextureDesc = CD3DX12_RESOURCE_DESC::Tex2D(Format, Width, Height, 1,
+		static_cast<UINT16>(MipCount), 1, 0, D3D12_RESOURCE_FLAG_NONE, D3D12_TEXTURE_LAYOUT_64KB_UNDEFINED_SWIZZLE);
+	CheckHResult(mDevice->CreateReservedResource(&TextureDesc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr,
+		IID_PPV_ARGS(Record.Resource.GetAddressOf())));
+
+	UINT NumTiles = 0;
+	UINT NumSubresourceTilings = 1;
+	CD3DX12_SUBRESOURCE_TILING Mip0Tiling;
+	mDevice->GetResourceTiling(Record.Resource.Get(), &NumTiles, &Record.PackedMipInfo,
+		&Record.TileShape, &NumSubresourceTilings, 0, &Mip0Tiling);
+
+	VirtualTextureDesc Desc;
+	Desc.WidthInPages = Mip0Tiling.WidthInTiles;
+	Desc.HeightInPages = Mip0Tiling.HeightInTiles;
+	Desc.StandardMipCount = Record.PackedMipInfo.NumStandardMips;
+	VirtualTextureHandle Handle = mPageManager.CreateVirtualTexture(Desc);
+
+	//Packed mips get their own small heap and stay mapped for the texture's lifetime
+	if (Record.PackedMipInfo.NumPackedMips > 0)
+	{
+		UINT PackedTileCount = Record.PackedMipInfo.NumTilesForPackedMips;
+
+		D3D12_HEAP_DESC PackedHeapDesc = {};
+		PackedHeapDesc.SizeInBytes = static_cast<UINT64>(PackedTileCount) * D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES;
+		PackedHeapDesc.Properties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+		PackedHeapDesc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+		PackedHeapDesc.Flags = D3D12_HEAP_FLAG_DENY_BUFFERS | D3D12_HEAP_FLAG_DENY_RT_DS_TEXTURES;
+		CheckHResult(mDevice->CreateHeap(&PackedHeapDesc, IID_PPV_ARGS(Record.PackedMipHeap.GetAddressOf())));
+
+		CD3DX12_TILED_RESOURCE_COORDINATE PackedCoordinate(0, 0, 0, Record.PackedMipInfo.NumStandardMips);
+		CD3DX12_TILE_REGION_SIZE PackedRegion(PackedTileCount, FALSE, 0, 0, 0);
+		D3D12_TILE_RANGE_FLAGS RangeFlags = D3D12_TILE_RANGE_FLAG_NONE;
+		UINT HeapRangeStart = 0;
+		Queue->UpdateTileMappings(Record.Resource.Get(), 1, &PackedCoordinate, &PackedRegion,
+			Record.PackedMipHeap.Get(), 1, &RangeFlags, &HeapRangeStart, &PackedTileCount, D3D12_TILE_MAPPING_FLAG_NONE);
+
+		//Fill them
+		UINT FirstPacked = Record.PackedMipInfo.NumStandardMips;
+		UINT PackedCount = Record.PackedMipInfo.NumPackedMips;
+
+		std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> Layouts(PackedCount);
+		std::vector<UINT> RowCounts(PackedCount);
+		std::vector<UINT64> RowSizes(PackedCount);
+		UINT64 TotalBytes = 0;
+		mDevice->GetCopyableFootprints(&TextureDesc, FirstPacked, PackedCount, 0,
+			Layouts.data(), RowCounts.data(), RowSizes.data(), &TotalBytes);
+
+		ComPtr<ID3D12Resource> PackedMipUpload;
+		D3D12_HEAP_PROPERTIES UploadHeapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
+		D3D12_RESOURCE_DESC UploadDesc = CD3DX12_RESOURCE_DESC::Buffer(TotalBytes);
+		CheckHResult(mDevice->CreateCommittedResource(&UploadHeapProps, D3D12_HEAP_FLAG_NONE,
+			&UploadDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr,
+			IID_PPV_ARGS(PackedMipUpload.GetAddressOf())));
+
+		uint8_t* UploadData = nullptr;
+		D3D12_RANGE ReadRange = { 0, 0 };
+		CheckHResult(PackedMipUpload->Map(0, &ReadRange, reinterpret_cast<void**>(&UploadData)));
+		for (UINT i = 0; i < PackedCount; ++i)
+		{
+			mTileSource->ReadPackedMip(Handle, FirstPacked + i, UploadData + Layouts[i].Offset,
+				Layouts[i].Footprint.RowPitch, RowCounts[i], RowSizes[i]);
+		}
+		PackedMipUpload->Unmap(0, nullptr);
+
+		for (UINT i = 0; i < PackedCount; ++i)
+		{
+			CD3DX12_TEXTURE_COPY_LOCATION Dest(Record.Resource.Get(), FirstPacked + i);
+			CD3DX12_TEXTURE_COPY_LOCATION Source(PackedMipUpload.Get(), Layouts[i]);
+			CommandList->CopyTextureRegion(&Dest, 0, 0, 0, &Source, nullptr);
+		}
+
+		//Staging is only needed until CommandList has executed
+		mReleaseQueue->ReleaseObject(PackedMipUpload.Detach());
+	}
+
+	D3D12_RESOURCE_BARRIER ToShaderResource = CD3DX12_RESOURCE_BARRIER::Transition(Record.Resource.Get(),
+		D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	CommandList->ResourceBarrier(1, &ToShaderResource);
+
+	if (Handle >= mTextures.size())
+	{
+		mTextures.resize(Handle + 1);
+	}
+	mTextures[Handle] = Record;
+
+	return Handle;
+}
+
+void D3D12VirtualTextureSystem::DestroyTexture(VirtualTextureHandle Texture)
+{
+	mPageManager.DestroyVirtualTexture(Texture);
+
+	TextureRecord& Record = mTextures[Texture];
+	mReleaseQueue->ReleaseObject(Record.Resource.Detach());
+	mReleaseQueue->ReleaseObject(Record.PackedMipHeap.Detach());
+	Record = TextureRecord();
+}
+
+ID3D12Resource* D3D12VirtualTextureSystem::GetResource(VirtualTextureHandle Texture) const
+{
+	return mTextures[Texture].Resource.Get();
+}
+
+void D3D12VirtualTextureSystem::BeginFrame(uint32_t FrameIndex)
+{
+	mCurrentSlice = FrameIndex % mFramesInFlight;
+	mPageManager.BeginFrame();
+}
+
+void D3D12VirtualTextureSystem::ProcessFeedback(VirtualTextureHandle Texture, const uint32_t* PackedPageIds, uint32_t Count)
+{
+	mPageManager.ProcessFeedback(Texture, PackedPageIds, Count);
+}
+
+void D3D12VirtualTextureSystem::Update(ID3D12CommandQueue* Queue, ID3D12GraphicsCommandList* CommandList)
+{
+	mBatch.clear();
+	mPageManager.Update(mMaxNewPagesPerFrame, mBatch);
+
+	if (mBatch.empty())
+	{
+		return;
+	}
+
+	//Group by texture (stable - an unmap and a later map of the same page must stay in order)
+	std::stable_sort(mBatch.begin(), mBatch.end(),
+		[](const VirtualPageMapping& A, const VirtualPageMapping& B) { return A.Texture < B.Texture; });
+
+	for (size_t First = 0; First < mBatch.size();)
+	{
+		size_t Last = First;
+		while (Last < mBatch.size() && mBatch[Last].Texture == mBatch[First].Texture)
+		{
+			++Last;
+		}
+
+		ApplyMappings(Queue, mBatch[First].Texture, mBatch, First, Last - First);
+		First = Last;
+	}
+
+	//Fill the newly mapped tiles. Mappings above were queued on Queue, so they
+	//are in place by the time this command list executes.
+	UINT64 SliceOffset = static_cast<UINT64>(mCurrentSlice) * mMaxNewPagesPerFrame * D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES;
+	uint32_t UploadIdx = 0;
+
+	for (size_t First = 0; First < mBatch.size();)
+	{
+		VirtualTextureHandle Texture = mBatch[First].Texture;
+		ID3D12Resource* Resource = mTextures[Texture].Resource.Get();
+
+		size_t Last = First;
+		while (Last < mBatch.size() && mBatch[Last].Texture == Texture)
+		{
+			++Last;
+		}
+
+		bool bAnyMapped = std::any_of(mBatch.begin() + First, mBatch.begin() + Last,
+			[](const VirtualPageMapping& Mapping) { return Mapping.PhysicalTile != InvalidPhysicalTile; });
+		if (bAnyMapped)
+		{
+			D3D12_RESOURCE_BARRIER ToCopyDest = CD3DX12_RESOURCE_BARRIER::Transition(Resource,
+				D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_DEST);
+			CommandList->ResourceBarrier(1, &ToCopyDest);
+
+			for (size_t i = First; i < Last; ++i)
+			{
+				const VirtualPageMapping& Mapping = mBatch[i];
+				if (Mapping.PhysicalTile == InvalidPhysicalTile)
+				{
+					continue;
+				}
+
+				Assert(UploadIdx < mMaxNewPagesPerFrame);
+				UINT64 Offset = SliceOffset + static_cast<UINT64>(UploadIdx) * D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES;
+				++UploadIdx;
+
+				mTileSource->ReadTile(Texture, Mapping.Mip, Mapping.X, Mapping.Y, mUploadBufferData + Offset);
+
+				CD3DX12_TILED_RESOURCE_COORDINATE Coordinate(Mapping.X, Mapping.Y, 0, Mapping.Mip);
+				CD3DX12_TILE_REGION_SIZE Region(1, FALSE, 0, 0, 0);
+				CommandList->CopyTiles(Resource, &Coordinate, &Region, mUploadBuffer.Get(), Offset,
+					D3D12_TILE_COPY_FLAG_LINEAR_BUFFER_TO_SWIZZLED_TILED_RESOURCE);
+			}
+
+			D3D12_RESOURCE_BARRIER ToShaderResource = CD3DX12_RESOURCE_BARRIER::Transition(Resource,
+				D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+			CommandList->ResourceBarrier(1, &ToShaderResource);
+		}
+
+		First = Last;
+	}
+}
+
+void D3D12VirtualTextureSystem::ApplyMappings(ID3D12CommandQueue* Queue, VirtualTextureHandle Texture,
+	const std::vector<VirtualPageMapping>& Batch, size_t First, size_t Count)
+{
+	mCoordinates.clear();
+	mRegionSizes.clear();
+	mRangeFlags.clear();
+	mHeapRangeStartOffsets.clear();
+	mRangeTileCounts.clear();
+
+	//One single-tile region + range per page. Unmaps use a NULL range so the
+	//heap offset is ignored.
+	for (size_t i = First; i < First + Count; ++i)
+	{
+		const VirtualPageMapping& Mapping = Batch[i];
+
+		mCoordinates.push_back(CD3DX12_TILED_RESOURCE_COORDINATE(Mapping.X, Mapping.Y, 0, Mapping.Mip));
+		mRegionSizes.push_back(CD3DX12_TILE_REGION_SIZE(1, FALSE, 0, 0, 0));
+
+		bool bUnmap = Mapping.PhysicalTile == InvalidPhysicalTile;
+		mRangeFlags.push_back(bUnmap ? D3D12_TILE_RANGE_FLAG_NULL : D3D12_TILE_RANGE_FLAG_NONE);
+		mHeapRangeStartOffsets.push_back(bUnmap ? 0 : Mapping.PhysicalTile);
+		mRangeTileCounts.push_back(1);
+	}
+
+	Queue->UpdateTileMappings(mTextures[Texture].Resource.Get(), static_cast<UINT>(Count),
+		mCoordinates.data(), mRegionSizes.data(), mTileHeap.Get(), static_cast<UINT>(Count),
+		mRangeFlags.data(), mHeapRangeStartOffsets.data(), mRangeTileCounts.data(), D3D12_TILE_MAPPING_FLAG_NONE);
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <windows.h>
+#include <wrl.h>
+#include <d3d12.h>
+
+#include "VirtualTexturePageManager.h"
+
+class DeferredReleaseQueue;
+
+//Supplies the contents of one 64KB tile, laid out linearly (rows of the tile
+//shape). Called on the thread that calls D3D12VirtualTextureSystem::Update().
+class IVirtualTextureTileSource
+{
+public:
+	IVirtualTextureTileSource() {};
+	virtual ~IVirtualTextureTileSource() {};
+
+	virtual void ReadTile(VirtualTextureHandle Texture, uint32_t Mip, uint32_t X, uint32_t Y, uint8_t* Dest) = 0;
+
+	//Packed mip tail, one subresource at a time (tight rows).
+	virtual void ReadPackedMip(VirtualTextureHandle Texture, uint32_t Mip,
+		uint8_t* Dest, uint64_t DestRowPitch, uint32_t RowCount, uint64_t RowSizeInBytes) = 0;
+};
+
+//Reserved (tiled) textures backed by a single heap of physical tiles.
+//
+//Page table and LRU decisions come from VirtualTexturePageManager, this class
+//applies them: one UpdateTileMappings call per texture per frame covering all
+//maps and unmaps, then the new tiles are filled with CopyTiles from a per frame
+//slice of an upload buffer.
+class D3D12VirtualTextureSystem
+{
+public:
+	D3D12VirtualTextureSystem(ID3D12Device* Device, IVirtualTextureTileSource* TileSource,
+		DeferredReleaseQueue* ReleaseQueue, uint32_t PhysicalTileCount, uint32_t MaxNewPagesPerFrame, uint32_t FramesInFlight);
+	~D3D12VirtualTextureSystem();
+
+	//Creates the reserved resource and maps + fills its packed mips. Initial
+	//uploads are recorded in to CommandList - the texture is ready once it has executed.
+	VirtualTextureHandle CreateTexture(ID3D12CommandQueue* Queue, ID3D12GraphicsCommandList* CommandList,
+		DXGI_FORMAT Format, uint32_t Width, uint32_t Height, uint32_t MipCount);
+	//GPU objects are freed through the release queue once the GPU is done with them.
+	void DestroyTexture(VirtualTextureHandle Texture);
+
+	ID3D12Resource* GetResource(VirtualTextureHandle Texture) const;
+
+	//Per frame: BeginFrame(), feedback for each texture, then Update(). Tile
+	//mappings are applied on Queue immediately, tile contents are copied by
+	//CommandList so it must execute on Queue after this call.
+	void BeginFrame(uint32_t FrameIndex);
+	void ProcessFeedback(VirtualTextureHandle Texture, const uint32_t* PackedPageIds, uint32_t Count);
+	void Update(ID3D12CommandQueue* Queue, ID3D12GraphicsCommandList* CommandList);
+
+	const VirtualTexturePageManager& GetPageManager() const { return mPageManager; }
+
+private:
+	struct TextureRecord
+	{
+		Microsoft::WRL::ComPtr<ID3D12Resource> Resource;
+		Microsoft::WRL::ComPtr<ID3D12Heap> PackedMipHeap;
+		D3D12_PACKED_MIP_INFO PackedMipInfo;
+		D3D12_TILE_SHAPE TileShape;
+	};
+
+	void ApplyMappings(ID3D12CommandQueue* Queue, VirtualTextureHandle Texture,
+		const std::vector<VirtualPageMapping>& Batch, size_t First, size_t Count);
+
+private:
+	Microsoft::WRL::ComPtr<ID3D12Device> mDevice;
+	IVirtualTextureTileSource* mTileSource;
+	DeferredReleaseQueue* mReleaseQueue;
+
+	VirtualTexturePageManager mPageManager;
+	Microsoft::WRL::ComPtr<ID3D12Heap> mTileHeap;
+
+	//FramesInFlight slices, each large enough for MaxNewPagesPerFrame tiles
+	Microsoft::WRL::ComPtr<ID3D12Resource> mUploadBuffer;
+	uint8_t* mUploadBufferData;
+	uint32_t mMaxNewPagesPerFrame;
+	uint32_t mFramesInFlight;
+	uint32_t mCurrentSlice;
+
+	std::vector<TextureRecord> mTextures;
+
+	//Reused every frame
+	std::vector<VirtualPageMapping> mBatch;
+	std::vector<D3D12_TILED_RESOURCE_COORDINATE> mCoordinates;
+	std::vector<D3D12_TILE_REGION_SIZE> mRegionSizes;
+	std::vector<D3D12_TILE_RANGE_FLAGS> mRangeFlags;
+	std::vector<UINT> mHeapRangeStartOffsets;
+	std::vector<UINT> mRangeTileCounts;
+};
@@ -0,0 +1,264 @@
+#include "DeferredReleaseChecks.h"
+#include "Common.h"
+#include "DeferredReleaseQueue.h"
+#include "SimulatedFence.h"
+
+#include <algorithm>
+#include <random>
+#include <stdio.h>
+
+namespace
+{
+	//Every item released through the queue, by index (the payload)
+	struct ReleaseLog
+	{
+		const IFence* Fence = nullptr;
+		std::vector<uint64_t> FenceValues;		//Value each item has to wait for
+		std::vector<uint32_t> ReleaseCounts;
+		std::vector<uint32_t> Order;			//Items in the order they were freed
+		uint32_t EarlyReleases = 0;
+	};
+
+	void RecordRelease(void* Context, uint64_t Payload)
+	{
+		ReleaseLog* Log = static_cast<ReleaseLog*>(Context);
+		uint32_t Item = static_cast<uint32_t>(Payload);
+
+		if (!Log->Fence->IsComplete(Log->FenceValues[Item]))
+		{
+			++Log->EarlyReleases;
+		}
+		++Log->ReleaseCounts[Item];
+		Log->Order.push_back(Item);
+	}
+
+	//Releases a new item - it has to wait for the next signal
+	void ReleaseItem(DeferredReleaseQueue& Queue, const IFence& Fence, ReleaseLog& Log)
+	{
+		uint32_t Item = static_cast<uint32_t>(Log.FenceValues.size());
+		Log.FenceValues.push_back(Fence.GetLastSignalledValue() + 1);
+		Log.ReleaseCounts.push_back(0);
+		Queue.Enqueue(&RecordRelease, &Log, Item);
+	}
+
+	//Items whose value has completed - items are released with non decreasing
+	//values so they are a prefix
+	uint32_t CountCompleted(const ReleaseLog& Log)
+	{
+		return static_cast<uint32_t>(std::upper_bound(Log.FenceValues.begin(), Log.FenceValues.end(),
+			Log.Fence->GetCompletedValue()) - Log.FenceValues.begin());
+	}
+
+	//Freed in release order, each at most once
+	bool IsInReleaseOrder(const ReleaseLog& Log)
+	{
+		for (uint32_t i = 0; i < Log.Order.size(); ++i)
+		{
+			if (Log.Order[i] != i || Log.ReleaseCounts[i] != 1)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool AllReleasedOnce(const ReleaseLog& Log)
+	{
+		return std::all_of(Log.ReleaseCounts.begin(), Log.ReleaseCounts.end(), [](uint32_t Count) { return Count == 1; });
+	}
+}
+
+DeferredReleaseChecks::DeferredReleaseChecks(const DeferredReleaseChecksSettings& Settings)
+	: mSettings(Settings)
+{
+	Assert(mSettings.Frames > 0);
+}
+
+DeferredReleaseChecks::~DeferredReleaseChecks()
+{}
+
+bool DeferredReleaseChecks::Run()
+{
+	mChecks.clear();
+	return CheckFrames() && CheckJumps() && CheckFlush();
+}
+
+bool DeferredReleaseChecks::CheckFrames()
+{
+	SimulatedFence Fence;
+	ReleaseLog Log;
+	Log.Fence = &Fence;
+
+	std::mt19937 Random(1234);
+	std::uniform_int_distribution<uint32_t> ReleaseCount(0, mSettings.MaxReleasesPerFrame);
+	std::uniform_int_distribution<uint32_t> FramesBehind(0, mSettings.MaxFramesInFlight);
+
+	bool bNotEarly = true;
+	bool bAllCompletedFreed = true;
+	{
+		DeferredReleaseQueue Queue(&Fence);
+		for (uint32_t Frame = 0; Frame < mSettings.Frames; ++Frame)
+		{
+			uint32_t Count = ReleaseCount(Random);
+			for (uint32_t i = 0; i < Count; ++i)
+			{
+				ReleaseItem(Queue, Fence, Log);
+			}
+			uint64_t Signalled = Fence.Signal();
+
+			uint64_t Behind = FramesBehind(Random);
+			Fence.AdvanceTo(Signalled > Behind ? Signalled - Behind : 0);
+			Queue.Drain();
+
+			bNotEarly = bNotEarly && Log.EarlyReleases == 0;
+			bAllCompletedFreed = bAllCompletedFreed && Log.Order.size() == CountCompleted(Log) &&
+				Queue.GetPendingCount() == Log.FenceValues.size() - Log.Order.size();
+		}
+
+		Queue.Flush();
+	}
+
+	if (!bNotEarly || !bAllCompletedFreed)
+	{
+		mLastError = bNotEarly ? "NotEarly check failed - Drain() didn't free exactly the items whose value completed" :
+			"NotEarly check failed - item freed before its fence value completed";
+		return false;
+	}
+	mChecks.push_back("NotEarly: passed (" + std::to_string(Log.FenceValues.size()) + " items over " +
+		std::to_string(mSettings.Frames) + " frames)");
+
+	if (!IsInReleaseOrder(Log) || !AllReleasedOnce(Log))
+	{
+		mLastError = "Order check failed - items freed out of release order or more than once";
+		return false;
+	}
+	mChecks.push_back("Order: passed");
+	return true;
+}
+
+bool DeferredReleaseChecks::CheckJumps()
+{
+	SimulatedFence Fence;
+	ReleaseLog Log;
+	Log.Fence = &Fence;
+
+	DeferredReleaseQueue Queue(&Fence);
+
+	//Three items a signal for ten signals, with two empty signals after each
+	//third one. The "GPU" completes nothing yet.
+	for (uint32_t Signal = 0; Signal < 10; ++Signal)
+	{
+		for (uint32_t i = 0; i < 3; ++i)
+		{
+			ReleaseItem(Queue, Fence, Log);
+		}
+		Fence.Signal();
+		if (Signal % 3 == 2)
+		{
+			Fence.Signal();
+			Fence.Signal();
+		}
+	}
+
+	bool bNothingEarly = Queue.Drain() == 0 && Log.Order.empty();
+
+	//Past several values, items and empty signals, in one step. Each Drain()
+	//must free everything up to the new value at once.
+	bool bJumpsFreed = true;
+	const uint64_t Jumps[] = { 5, 6, 13, Fence.GetLastSignalledValue() };
+	for (uint64_t Value : Jumps)
+	{
+		Fence.AdvanceTo(Value);
+		uint32_t Expected = CountCompleted(Log) - static_cast<uint32_t>(Log.Order.size());
+		bJumpsFreed = bJumpsFreed && Queue.Drain() == Expected && Log.Order.size() == CountCompleted(Log);
+	}
+
+	if (!bNothingEarly || !bJumpsFreed || Log.EarlyReleases != 0 || Queue.GetPendingCount() != 0 ||
+		!IsInReleaseOrder(Log) || !AllReleasedOnce(Log))
+	{
+		mLastError = "Jumps check failed";
+		return false;
+	}
+
+	//Fence values are 64 bit and only ever go up - there is no wrap to test
+	mChecks.push_back("Jumps: passed (" + std::to_string(Log.FenceValues.size()) + " items over " +
+		std::to_string(Fence.GetLastSignalledValue()) + " signals, freed in " + std::to_string(sizeof(Jumps) / sizeof(Jumps[0])) +
+		" jumps)");
+	return true;
+}
+
+bool DeferredReleaseChecks::CheckFlush()
+{
+	SimulatedFence Fence;
+	ReleaseLog Log;
+	Log.Fence = &Fence;
+
+	bool bFlushed = true;
+	{
+		DeferredReleaseQueue Queue(&Fence);
+
+		//Items behind a signal the GPU hasn't reached, and items released after
+		//it - Flush() has to signal once for those itself
+		for (uint32_t i = 0; i < 4; ++i)
+		{
+			ReleaseItem(Queue, Fence, Log);
+		}
+		uint64_t Signalled = Fence.Signal();
+		for (uint32_t i = 0; i < 4; ++i)
+		{
+			ReleaseItem(Queue, Fence, Log);
+		}
+
+		Queue.Flush();
+		bFlushed = bFlushed && Fence.GetLastSignalledValue() == Signalled + 1 && Queue.GetPendingCount() == 0 &&
+			Log.Order.size() == 8;
+
+		//Nothing pending - no signal, nothing freed again
+		Queue.Flush();
+		bFlushed = bFlushed && Queue.Drain() == 0 && Fence.GetLastSignalledValue() == Signalled + 1 && Log.Order.size() == 8;
+
+		//Everything pending already signalled - Flush() only waits
+		for (uint32_t i = 0; i < 4; ++i)
+		{
+			ReleaseItem(Queue, Fence, Log);
+		}
+		Signalled = Fence.Signal();
+		Queue.Flush();
+		bFlushed = bFlushed && Fence.GetLastSignalledValue() == Signalled && Log.Order.size() == 12;
+
+		//Shutdown as the engine does it - release, flush and destroy
+		for (uint32_t i = 0; i < 4; ++i)
+		{
+			ReleaseItem(Queue, Fence, Log);
+		}
+		Queue.Flush();
+	}
+
+	if (!bFlushed || Log.EarlyReleases != 0 || Log.Order.size() != Log.FenceValues.size() ||
+		!IsInReleaseOrder(Log) || !AllReleasedOnce(Log))
+	{
+		mLastError = "Flush check failed";
+		return false;
+	}
+
+	mChecks.push_back("Flush: passed (" + std::to_string(Log.FenceValues.size()) + " items, " +
+		std::to_string(Fence.GetStallCount()) + " waits)");
+	return true;
+}
+
+bool DeferredReleaseChecks::WriteReport(const char* Filename) const
+{
+	FILE* File = fopen(Filename, "w");
+	if (!File)
+	{
+		return false;
+	}
+
+	for (const std::string& CheckResult : mChecks)
+	{
+		fprintf(File, "%s\n", CheckResult.c_str());
+	}
+
+	fclose(File);
+	return true;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//Checks DeferredReleaseQueue against a SimulatedFence:
+//	NotEarly	- nothing is freed before its fence value completes, and
+//				  everything whose value has completed is freed by Drain()
+//	Order		- items are freed in release (and so fence) order
+//	Jumps		- the fence completing several values in one step frees
+//				  every item up to it in one Drain()
+//	Flush		- Flush() and shutdown free everything exactly once,
+//				  including items released after the last signal
+//
+//NotEarly and Order are checked over Frames simulated frames with a GPU
+//lagging a random 0 to MaxFramesInFlight frames behind. Run() fails if any
+//check does.
+struct DeferredReleaseChecksSettings
+{
+	uint32_t Frames = 1000;
+	uint32_t MaxReleasesPerFrame = 16;
+	uint32_t MaxFramesInFlight = 3;
+};
+
+class DeferredReleaseChecks
+{
+public:
+	DeferredReleaseChecks(const DeferredReleaseChecksSettings& Settings);
+	~DeferredReleaseChecks();
+
+	bool Run();
+	bool WriteReport(const char* Filename) const;
+
+	const std::string& GetLastError() const { return mLastError; }
+
+private:
+	bool CheckFrames();
+	bool CheckJumps();
+	bool CheckFlush();
+
+private:
+	DeferredReleaseChecksSettings mSettings;
+	std::vector<std::string> mChecks;
+	std::string mLastError;
+};
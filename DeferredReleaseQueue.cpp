@@ -0,0 +1,85 @@
+#include "DeferredReleaseQueue.h"
+#include "Common.h"
+
+#if defined(_WIN32)
+namespace
+{
+	void ReleaseUnknown(void* Context, uint64_t Payload)
+	{
+		static_cast<IUnknown*>(Context)->Release();
+	}
+}
+#endif
+
+DeferredReleaseQueue::DeferredReleaseQueue(IFence* Fence)
+	: mFence(Fence), mTotalReleased(0)
+{
+	Assert(mFence);
+}
+
+DeferredReleaseQueue::~DeferredReleaseQueue()
+{
+	//Owner must Flush() before the device goes away.
+	Assert(mEntries.empty());
+}
+
+void DeferredReleaseQueue::Enqueue(ReleaseCallback Callback, void* Context, uint64_t Payload)
+{
+	Entry NewEntry;
+	NewEntry.FenceValue = mFence->GetLastSignalledValue() + 1;
+	NewEntry.Callback = Callback;
+	NewEntry.Context = Context;
+	NewEntry.Payload = Payload;
+	mEntries.push_back(NewEntry);
+}
+
+#if defined(_WIN32)
+void DeferredReleaseQueue::ReleaseObject(IUnknown* Object)
+{
+	if (Object)
+	{
+		Enqueue(&ReleaseUnknown, Object, 0);
+	}
+}
+#endif
+
+uint32_t DeferredReleaseQueue::Drain()
+{
+	if (mEntries.empty())
+	{
+		return 0;
+	}
+
+	uint64_t CompletedValue = mFence->GetCompletedValue();
+
+	uint32_t Released = 0;
+	while (!mEntries.empty() && mEntries.front().FenceValue <= CompletedValue)
+	{
+		Entry Front = mEntries.front();
+		mEntries.pop_front();
+
+		Front.Callback(Front.Context, Front.Payload);
+		++Released;
+	}
+
+	mTotalReleased += Released;
+	return Released;
+}
+
+void DeferredReleaseQueue::Flush()
+{
+	if (mEntries.empty())
+	{
+		return;
+	}
+
+	uint64_t LastValue = mEntries.back().FenceValue;
+	if (LastValue > mFence->GetLastSignalledValue())
+	{
+		mFence->Signal();
+	}
+	mFence->WaitForValue(LastValue);
+
+	Drain();
+	Assert(mEntries.empty());
+}
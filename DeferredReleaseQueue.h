@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+
+#if defined(_WIN32)
+#include <unknwn.h>
+#endif
+
+#include "IFence.h"
+
+//Defers destruction of GPU objects (resources, descriptors, sub allocations)
+//until the GPU has finished with them, without flushing the queue.
+//
+//Anything released is tagged with the fence value of the next signal - the one
+//that follows all work recorded so far - and actually freed by Drain() once
+//that value completes. Entries are kept in release order and fence values only
+//ever increase, so Drain() only looks at the front of the queue.
+//
+//Main thread only.
+class DeferredReleaseQueue
+{
+public:
+	typedef void (*ReleaseCallback)(void* Context, uint64_t Payload);
+
+	DeferredReleaseQueue(IFence* Fence);
+	~DeferredReleaseQueue();
+
+	//Generic release - Callback(Context, Payload) runs once the GPU is done.
+	//Use for descriptor slots, allocator ranges etc.
+	void Enqueue(ReleaseCallback Callback, void* Context, uint64_t Payload);
+
+#if defined(_WIN32)
+	//Takes over one reference (eg: ComPtr::Detach()).
+	void ReleaseObject(IUnknown* Object);
+#endif
+
+	//Free everything the GPU has finished with. Cheap when there's nothing to do.
+	uint32_t Drain();
+
+	//Signal (if needed) and wait for everything pending, then free it all.
+	void Flush();
+
+	uint32_t GetPendingCount() const { return static_cast<uint32_t>(mEntries.size()); }
+	uint64_t GetTotalReleased() const { return mTotalReleased; }
+
+private:
+	struct Entry
+	{
+		uint64_t FenceValue;
+		ReleaseCallback Callback;
+		void* Context;
+		uint64_t Payload;
+	};
+
+	IFence* mFence;
+	std::deque<Entry> mEntries;
+	uint64_t mTotalReleased;
+};
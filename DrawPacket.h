@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <string.h>
+
+#include "Common.h"
+
+enum class DrawSortMode
+{
+	Opaque,			//Fewest state changes, then front to back
+	Transparent		//Back to front, then fewest state changes
+};
+
+//One draw as the renderer frontend sees it. Everything is a renderer id -
+//an index in to its own tables of pipeline states, meshes and so on - rather
+//than an API object, so packets can be built, sorted and batched on any
+//thread and on any platform.
+struct DrawPacket
+{
+	uint64_t SortKey;
+	uint32_t Pass;
+	DrawSortMode SortMode;		//Of the pass
+	uint32_t PipelineState;
+	uint32_t RootSignature;
+	uint32_t Material;			//Also picks the descriptor table
+	uint32_t Mesh;
+	uint32_t Instance;			//Per object data, e.g. the world matrix
+	float Depth;				//View space distance
+};
+
+//Sort key layout, from the top bit down:
+//	Opaque		- pass, pipeline state, material, depth bucket
+//	Transparent	- pass, inverted depth bucket, pipeline state, material
+//Ascending keys keep passes in order and, within one, group draws that share
+//state. Pipeline state ids should be handed out grouped by root signature so
+//grouping pipeline states groups root signatures too.
+const uint32_t DrawSortPassBits = 6;
+const uint32_t DrawSortPipelineStateBits = 14;
+const uint32_t DrawSortMaterialBits = 20;
+const uint32_t DrawSortDepthBits = 24;
+
+//Non-negative floats order the same as their bit patterns, so the top bits
+//make buckets with the same relative precision at every distance
+inline uint32_t MakeDepthBucket(float Depth)
+{
+	if (!(Depth > 0.0f))
+	{
+		return 0;
+	}
+
+	uint32_t Bits;
+	memcpy(&Bits, &Depth, sizeof(Bits));
+	return Bits >> (31 - DrawSortDepthBits);
+}
+
+inline uint64_t MakeDrawSortKey(DrawSortMode Mode, uint32_t Pass, uint32_t PipelineState, uint32_t Material, float Depth)
+{
+	Assert(Pass < (1u << DrawSortPassBits) && PipelineState < (1u << DrawSortPipelineStateBits) &&
+		Material < (1u << DrawSortMaterialBits));
+
+	uint64_t State = (static_cast<uint64_t>(PipelineState) << DrawSortMaterialBits) | Material;
+	uint64_t DepthBucket = MakeDepthBucket(Depth);
+	if (Mode == DrawSortMode::Transparent)
+	{
+		DepthBucket = ((1u << DrawSortDepthBits) - 1) - DepthBucket;
+		return (static_cast<uint64_t>(Pass) << (64 - DrawSortPassBits)) |
+			(DepthBucket << (DrawSortPipelineStateBits + DrawSortMaterialBits)) | State;
+	}
+	return (static_cast<uint64_t>(Pass) << (64 - DrawSortPassBits)) | (State << DrawSortDepthBits) | DepthBucket;
+}
@@ -0,0 +1,77 @@
+#include "DrawQueue.h"
+#include "JobSystem.h"
+
+DrawStateChanges CountDrawStateChanges(const DrawPacket* Draws, uint32_t Count)
+{
+	DrawStateChanges Changes;
+	for (uint32_t i = 0; i < Count; ++i)
+	{
+		const DrawPacket& Draw = Draws[i];
+		const DrawPacket* Previous = i > 0 ? &Draws[i - 1] : nullptr;
+
+		bool bNewRootSignature = !Previous || Draw.RootSignature != Previous->RootSignature;
+		Changes.RootSignatures += bNewRootSignature ? 1 : 0;
+		Changes.PipelineStates += !Previous || Draw.PipelineState != Previous->PipelineState ? 1 : 0;
+		Changes.DescriptorTables += bNewRootSignature || Draw.Material != Previous->Material ? 1 : 0;
+	}
+	return Changes;
+}
+
+DrawQueue::DrawQueue()
+{}
+
+DrawQueue::~DrawQueue()
+{}
+
+void DrawQueue::Reserve(uint32_t Count)
+{
+	mDraws.reserve(Count);
+	mSorted.reserve(Count);
+	mKeys.reserve(Count);
+	mOrder.reserve(Count);
+}
+
+void DrawQueue::Clear()
+{
+	mDraws.clear();
+}
+
+void DrawQueue::Add(const DrawPacket& Packet, DrawSortMode Mode)
+{
+	mDraws.push_back(Packet);
+	mDraws.back().SortMode = Mode;
+	mDraws.back().SortKey = MakeDrawSortKey(Mode, Packet.Pass, Packet.PipelineState, Packet.Material, Packet.Depth);
+}
+
+void DrawQueue::Sort(JobSystem* Jobs)
+{
+	uint32_t Count = GetCount();
+	mKeys.resize(Count);
+	mOrder.resize(Count);
+	for (uint32_t i = 0; i < Count; ++i)
+	{
+		mKeys[i] = mDraws[i].SortKey;
+		mOrder[i] = i;
+	}
+
+	mSorter.Sort(mKeys, mOrder, 64, Jobs);
+
+	mSorted.resize(Count);
+	auto Gather = [this](uint32_t Begin, uint32_t End)
+	{
+		for (uint32_t i = Begin; i < End; ++i)
+		{
+			mSorted[i] = mDraws[mOrder[i]];
+		}
+	};
+
+	if (Jobs && Count > RadixSorter::JobBatchSize)
+	{
+		Jobs->ParallelFor(Count, RadixSorter::JobBatchSize, Gather);
+	}
+	else
+	{
+		Gather(0, Count);
+	}
+	mDraws.swap(mSorted);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "DrawPacket.h"
+#include "RadixSort.h"
+
+class JobSystem;
+
+//State a command list would have to set recording draws in order, counting
+//each change from the draw before. A new root signature unbinds every
+//descriptor table, so the table is set again after one even if the material
+//is the same.
+struct DrawStateChanges
+{
+	uint32_t PipelineStates = 0;
+	uint32_t RootSignatures = 0;
+	uint32_t DescriptorTables = 0;
+};
+
+DrawStateChanges CountDrawStateChanges(const DrawPacket* Draws, uint32_t Count);
+
+//A frame's draws, collected in any order and sorted by key before recording.
+//Add() builds each packet's key for its pass's sort mode; Sort() is a radix
+//sort of the keys across the job system, then one pass moving the packets in
+//to key order. Draws with equal keys keep the order they were added in.
+class DrawQueue
+{
+public:
+	DrawQueue();
+	~DrawQueue();
+
+	void Reserve(uint32_t Count);
+	void Clear();
+
+	//Fills in the packet's SortKey and SortMode
+	void Add(const DrawPacket& Packet, DrawSortMode Mode);
+
+	void Sort(JobSystem* Jobs = nullptr);
+
+	//In the order added, or key order after Sort()
+	const DrawPacket* GetDraws() const { return mDraws.data(); }
+	uint32_t GetCount() const { return static_cast<uint32_t>(mDraws.size()); }
+
+	const RadixSorter& GetSorter() const { return mSorter; }
+
+private:
+	std::vector<DrawPacket> mDraws;
+	std::vector<DrawPacket> mSorted;
+	std::vector<uint64_t> mKeys;
+	std::vector<uint32_t> mOrder;
+	RadixSorter mSorter;
+};
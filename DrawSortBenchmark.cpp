@@ -0,0 +1,333 @@
+#include "DrawSortBenchmark.h"
+#include "Common.h"
+#include "JobSystem.h"
+#include "VectorMath.h"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <stdio.h>
+#include <utility>
+
+namespace
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	double MillisecondsSince(Clock::time_point Start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - Start).count();
+	}
+
+	const uint32_t OpaquePass = 0;
+	const uint32_t TransparentPass = 1;
+
+	const float WorldSize = 1000.0f;
+	const uint32_t MeshCount = 256;
+
+	struct SceneDraw
+	{
+		DrawPacket Packet;
+		Float3 Position;
+	};
+
+	//Materials use pipeline states round robin, and pipeline state ids are
+	//grouped by root signature
+	std::vector<SceneDraw> MakeScene(const DrawSortBenchmarkSettings& Settings, uint32_t DrawCount)
+	{
+		std::mt19937 Random(1234);
+		std::uniform_real_distribution<float> Position(-WorldSize, WorldSize);
+		std::uniform_real_distribution<float> Unit(0.0f, 1.0f);
+		std::uniform_int_distribution<uint32_t> Material(0, Settings.MaterialCount - 1);
+		std::uniform_int_distribution<uint32_t> Mesh(0, MeshCount - 1);
+
+		uint32_t StatesPerRootSignature = (Settings.PipelineStateCount + Settings.RootSignatureCount - 1) / Settings.RootSignatureCount;
+
+		std::vector<SceneDraw> Scene(DrawCount);
+		for (uint32_t i = 0; i < DrawCount; ++i)
+		{
+			DrawPacket& Packet = Scene[i].Packet;
+			Packet = DrawPacket();
+			Packet.Pass = Unit(Random) < Settings.TransparentFraction ? TransparentPass : OpaquePass;
+			Packet.Material = Material(Random);
+			Packet.PipelineState = Packet.Material % Settings.PipelineStateCount;
+			Packet.RootSignature = Packet.PipelineState / StatesPerRootSignature;
+			Packet.Mesh = Mesh(Random);
+			Packet.Instance = i;
+			Scene[i].Position = MakeFloat3(Position(Random), Position(Random), Position(Random));
+		}
+		return Scene;
+	}
+
+	//A camera circling the scene, a full turn over the run
+	void FillQueue(const std::vector<SceneDraw>& Scene, uint32_t Frame, uint32_t FrameCount, DrawQueue& Queue)
+	{
+		float Angle = 6.2831853f * static_cast<float>(Frame) / static_cast<float>(FrameCount);
+		Float3 Eye = MakeFloat3(sinf(Angle) * WorldSize, 0.0f, cosf(Angle) * WorldSize);
+
+		Queue.Clear();
+		for (const SceneDraw& Draw : Scene)
+		{
+			DrawPacket Packet = Draw.Packet;
+			Packet.Depth = Length(Draw.Position - Eye);
+			Queue.Add(Packet, Packet.Pass == TransparentPass ? DrawSortMode::Transparent : DrawSortMode::Opaque);
+		}
+	}
+
+	void AddChanges(DrawStateChanges& Total, const DrawStateChanges& Frame)
+	{
+		Total.PipelineStates += Frame.PipelineStates;
+		Total.RootSignatures += Frame.RootSignatures;
+		Total.DescriptorTables += Frame.DescriptorTables;
+	}
+
+	//Changes recording only Pass's draws, in the order they're in
+	DrawStateChanges CountPassStateChanges(const DrawQueue& Queue, uint32_t Pass, std::vector<DrawPacket>& Scratch)
+	{
+		Scratch.clear();
+		for (uint32_t i = 0; i < Queue.GetCount(); ++i)
+		{
+			if (Queue.GetDraws()[i].Pass == Pass)
+			{
+				Scratch.push_back(Queue.GetDraws()[i]);
+			}
+		}
+		return CountDrawStateChanges(Scratch.data(), static_cast<uint32_t>(Scratch.size()));
+	}
+
+	const uint32_t OrderCount = 6;
+	const char* const OrderNames[OrderCount] =
+	{
+		"Scene", "Sorted", "Opaque scene", "Opaque sorted", "Transparent scene", "Transparent sorted"
+	};
+}
+
+DrawSortBenchmark::DrawSortBenchmark(const DrawSortBenchmarkSettings& Settings)
+	: mSettings(Settings)
+{
+	Assert(mSettings.Frames > 0);
+}
+
+DrawSortBenchmark::~DrawSortBenchmark()
+{}
+
+bool DrawSortBenchmark::Run()
+{
+	mResults.clear();
+	mStateChanges.clear();
+	for (uint32_t ThreadCount : mSettings.ThreadCounts)
+	{
+		if (ThreadCount < 2)
+		{
+			mLastError = "Thread counts must be at least 2 - one thread is always run";
+			return false;
+		}
+	}
+	if (mSettings.PipelineStateCount == 0 || mSettings.PipelineStateCount > (1u << DrawSortPipelineStateBits) ||
+		mSettings.MaterialCount == 0 || mSettings.MaterialCount > (1u << DrawSortMaterialBits) ||
+		mSettings.RootSignatureCount == 0 || mSettings.RootSignatureCount > mSettings.PipelineStateCount)
+	{
+		mLastError = "Pipeline state, root signature and material counts must be above 0 and fit the sort key";
+		return false;
+	}
+
+	for (uint32_t DrawCount : mSettings.DrawCounts)
+	{
+		if (DrawCount == 0 || !RunDrawCount(DrawCount))
+		{
+			if (mLastError.empty())
+			{
+				mLastError = "Draw counts must be above 0";
+			}
+			return false;
+		}
+	}
+	return true;
+}
+
+bool DrawSortBenchmark::RunDrawCount(uint32_t DrawCount)
+{
+	std::vector<SceneDraw> Scene = MakeScene(mSettings, DrawCount);
+
+	DrawQueue Queue;
+	Queue.Reserve(DrawCount);
+
+	//Building the keys, and the state changes either side of sorting - all
+	//draws, then each pass on its own. Indexed as OrderNames.
+	DrawStateChanges Changes[OrderCount];
+	std::vector<DrawPacket> PassDraws;
+	double Milliseconds = 0.0;
+	for (uint32_t Frame = 0; Frame < mSettings.Frames; ++Frame)
+	{
+		auto Start = Clock::now();
+		FillQueue(Scene, Frame, mSettings.Frames, Queue);
+		Milliseconds += MillisecondsSince(Start);
+
+		for (uint32_t bSorted = 0; bSorted < 2; ++bSorted)
+		{
+			if (bSorted)
+			{
+				Queue.Sort();
+			}
+			AddChanges(Changes[bSorted], CountDrawStateChanges(Queue.GetDraws(), Queue.GetCount()));
+			AddChanges(Changes[2 + bSorted], CountPassStateChanges(Queue, OpaquePass, PassDraws));
+			AddChanges(Changes[4 + bSorted], CountPassStateChanges(Queue, TransparentPass, PassDraws));
+		}
+	}
+	AddResult(DrawCount, "Add", Milliseconds, static_cast<uint64_t>(DrawCount) * mSettings.Frames);
+	for (uint32_t Order = 0; Order < OrderCount; ++Order)
+	{
+		AddStateChanges(DrawCount, OrderNames[Order], Changes[Order]);
+	}
+
+	std::vector<uint32_t> ThreadCounts = mSettings.ThreadCounts;
+	ThreadCounts.insert(ThreadCounts.begin(), 1);
+	for (uint32_t ThreadCount : ThreadCounts)
+	{
+		std::unique_ptr<JobSystem> Jobs;
+		if (ThreadCount > 1)
+		{
+			Jobs.reset(new JobSystem(ThreadCount - 1));
+		}
+
+		Milliseconds = 0.0;
+		for (uint32_t Frame = 0; Frame < mSettings.Frames; ++Frame)
+		{
+			FillQueue(Scene, Frame, mSettings.Frames, Queue);
+
+			auto Start = Clock::now();
+			Queue.Sort(Jobs.get());
+			Milliseconds += MillisecondsSince(Start);
+
+			if (Frame == 0 && !Verify(Queue, ThreadCount))
+			{
+				return false;
+			}
+		}
+		AddResult(DrawCount, ThreadCount > 1 ? "Radix x" + std::to_string(ThreadCount) : "Radix", Milliseconds,
+			static_cast<uint64_t>(DrawCount) * mSettings.Frames);
+	}
+
+	//The same keys through std::sort, ties broken by the order added
+	std::vector<std::pair<uint64_t, uint32_t>> Pairs(DrawCount);
+	std::vector<DrawPacket> Sorted(DrawCount);
+	Milliseconds = 0.0;
+	for (uint32_t Frame = 0; Frame < mSettings.Frames; ++Frame)
+	{
+		FillQueue(Scene, Frame, mSettings.Frames, Queue);
+		const DrawPacket* Draws = Queue.GetDraws();
+
+		auto Start = Clock::now();
+		for (uint32_t i = 0; i < DrawCount; ++i)
+		{
+			Pairs[i] = std::make_pair(Draws[i].SortKey, i);
+		}
+		std::sort(Pairs.begin(), Pairs.end());
+		for (uint32_t i = 0; i < DrawCount; ++i)
+		{
+			Sorted[i] = Draws[Pairs[i].second];
+		}
+		Milliseconds += MillisecondsSince(Start);
+
+		if (Frame == 0)
+		{
+			Queue.Sort();
+			for (uint32_t i = 0; i < DrawCount; ++i)
+			{
+				if (Sorted[i].Instance != Queue.GetDraws()[i].Instance)
+				{
+					mLastError = "Radix sorted draws differ from std::sort with " + std::to_string(DrawCount) + " draws";
+					return false;
+				}
+			}
+		}
+	}
+	AddResult(DrawCount, "std::sort", Milliseconds, static_cast<uint64_t>(DrawCount) * mSettings.Frames);
+	return true;
+}
+
+bool DrawSortBenchmark::Verify(const DrawQueue& Queue, uint32_t ThreadCount)
+{
+	const DrawPacket* Draws = Queue.GetDraws();
+	for (uint32_t i = 1; i < Queue.GetCount(); ++i)
+	{
+		const DrawPacket& Draw = Draws[i];
+		const DrawPacket& Previous = Draws[i - 1];
+
+		bool bInOrder = Previous.SortKey < Draw.SortKey || (Previous.SortKey == Draw.SortKey && Previous.Instance < Draw.Instance);
+		bool bPassesInOrder = Previous.Pass <= Draw.Pass;
+
+		//Transparent draws all the way back to front, opaque ones front to
+		//back wherever the state is the same
+		bool bDepthInOrder = true;
+		if (Draw.Pass == Previous.Pass && Draw.Pass == TransparentPass)
+		{
+			bDepthInOrder = MakeDepthBucket(Previous.Depth) >= MakeDepthBucket(Draw.Depth);
+		}
+		else if (Draw.Pass == Previous.Pass && Draw.PipelineState == Previous.PipelineState && Draw.Material == Previous.Material)
+		{
+			bDepthInOrder = MakeDepthBucket(Previous.Depth) <= MakeDepthBucket(Draw.Depth);
+		}
+
+		if (!bInOrder || !bPassesInOrder || !bDepthInOrder)
+		{
+			char Error[128];
+			snprintf(Error, sizeof(Error), "Draw %u out of order with %u draws, %u threads", i, Queue.GetCount(), ThreadCount);
+			mLastError = Error;
+			return false;
+		}
+	}
+	return true;
+}
+
+void DrawSortBenchmark::AddResult(uint32_t DrawCount, const std::string& Mode, double Milliseconds, uint64_t Keys)
+{
+	DrawSortBenchmarkResult Result;
+	Result.DrawCount = DrawCount;
+	Result.Mode = Mode;
+	Result.MillisecondsPerFrame = Milliseconds / mSettings.Frames;
+	Result.KeysPerMillisecond = Milliseconds > 0.0 ? Keys / Milliseconds : 0.0;
+	mResults.push_back(Result);
+}
+
+void DrawSortBenchmark::AddStateChanges(uint32_t DrawCount, const std::string& Order, const DrawStateChanges& Total)
+{
+	DrawSortBenchmarkStateChanges Entry;
+	Entry.DrawCount = DrawCount;
+	Entry.Order = Order;
+	Entry.Changes.PipelineStates = Total.PipelineStates / mSettings.Frames;
+	Entry.Changes.RootSignatures = Total.RootSignatures / mSettings.Frames;
+	Entry.Changes.DescriptorTables = Total.DescriptorTables / mSettings.Frames;
+	mStateChanges.push_back(Entry);
+}
+
+bool DrawSortBenchmark::WriteReport(const char* Filename) const
+{
+	FILE* File = fopen(Filename, "w");
+	if (!File)
+	{
+		return false;
+	}
+
+	fprintf(File, "Frames:          %u\n", mSettings.Frames);
+	fprintf(File, "Pipeline states: %u\n", mSettings.PipelineStateCount);
+	fprintf(File, "Root signatures: %u\n", mSettings.RootSignatureCount);
+	fprintf(File, "Materials:       %u\n", mSettings.MaterialCount);
+	fprintf(File, "Transparent:     %.0f%%\n\n", mSettings.TransparentFraction * 100.0f);
+
+	fprintf(File, "Draws,Mode,MsPerFrame,KeysPerMs\n");
+	for (const DrawSortBenchmarkResult& Result : mResults)
+	{
+		fprintf(File, "%u,%s,%.3f,%.1f\n", Result.DrawCount, Result.Mode.c_str(), Result.MillisecondsPerFrame, Result.KeysPerMillisecond);
+	}
+
+	fprintf(File, "\nDraws,Order,PipelineStates,RootSignatures,DescriptorTables\n");
+	for (const DrawSortBenchmarkStateChanges& Entry : mStateChanges)
+	{
+		fprintf(File, "%u,%s,%u,%u,%u\n", Entry.DrawCount, Entry.Order.c_str(), Entry.Changes.PipelineStates,
+			Entry.Changes.RootSignatures, Entry.Changes.DescriptorTables);
+	}
+
+	fclose(File);
+	return true;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "DrawQueue.h"
+
+//Draw sorting for each of DrawCounts draws of a random scene: an opaque pass
+//and a TransparentFraction transparent pass, with a camera circling it so
+//the depths change every frame.
+//
+//State changes per frame are counted recording the draws in scene order and
+//in key order, for the whole frame and for each pass on its own. Sort times
+//cover DrawQueue::Sort() on one thread and split across each of ThreadCounts
+//threads, against std::sort of the same keys.
+//Run() fails if a sorted queue isn't in key order, or equal keys lost the
+//order they were added in.
+struct DrawSortBenchmarkSettings
+{
+	std::vector<uint32_t> DrawCounts = { 10000, 100000, 1000000 };
+	std::vector<uint32_t> ThreadCounts = { 2, 4, 8 };
+	uint32_t Frames = 20;
+	uint32_t PipelineStateCount = 64;
+	uint32_t RootSignatureCount = 8;
+	uint32_t MaterialCount = 1024;
+	float TransparentFraction = 0.1f;
+};
+
+struct DrawSortBenchmarkResult
+{
+	uint32_t DrawCount = 0;
+	std::string Mode;
+	double MillisecondsPerFrame = 0.0;
+	double KeysPerMillisecond = 0.0;
+};
+
+struct DrawSortBenchmarkStateChanges
+{
+	uint32_t DrawCount = 0;
+	std::string Order;
+	DrawStateChanges Changes;	//Per frame
+};
+
+class DrawSortBenchmark
+{
+public:
+	DrawSortBenchmark(const DrawSortBenchmarkSettings& Settings);
+	~DrawSortBenchmark();
+
+	bool Run();
+	bool WriteReport(const char* Filename) const;
+
+	const std::string& GetLastError() const { return mLastError; }
+
+private:
+	bool RunDrawCount(uint32_t DrawCount);
+
+	//Key order, stability, and depth order within each pass
+	bool Verify(const DrawQueue& Queue, uint32_t ThreadCount);
+
+	void AddResult(uint32_t DrawCount, const std::string& Mode, double Milliseconds, uint64_t Keys);
+	void AddStateChanges(uint32_t DrawCount, const std::string& Order, const DrawStateChanges& Total);
+
+private:
+	DrawSortBenchmarkSettings mSettings;
+	std::vector<DrawSortBenchmarkResult> mResults;
+	std::vector<DrawSortBenchmarkStateChanges> mStateChanges;
+
+	std::string mLastError;
+};
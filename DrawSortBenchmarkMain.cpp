@@ -0,0 +1,75 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "DrawSortBenchmark.h"
+
+//Draw sort benchmark:
+//	DrawSortBenchmark [-frames N] [-draws N ...] [-threads N ...] [-states N] [-rootsignatures N] [-materials N] [-transparent F]
+//Writes DrawSortBenchmark.txt to the current directory.
+int main(int argc, char** argv)
+{
+	DrawSortBenchmarkSettings Settings;
+	bool bCustomDraws = false;
+	bool bCustomThreads = false;
+	bool bValid = true;
+	for (int i = 1; i < argc && bValid; ++i)
+	{
+		if (strcmp(argv[i], "-frames") == 0 && i + 1 < argc)
+		{
+			Settings.Frames = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-draws") == 0 && i + 1 < argc)
+		{
+			if (!bCustomDraws)
+			{
+				Settings.DrawCounts.clear();
+				bCustomDraws = true;
+			}
+			Settings.DrawCounts.push_back(static_cast<uint32_t>(atoi(argv[++i])));
+		}
+		else if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc)
+		{
+			if (!bCustomThreads)
+			{
+				Settings.ThreadCounts.clear();
+				bCustomThreads = true;
+			}
+			Settings.ThreadCounts.push_back(static_cast<uint32_t>(atoi(argv[++i])));
+		}
+		else if (strcmp(argv[i], "-states") == 0 && i + 1 < argc)
+		{
+			Settings.PipelineStateCount = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-rootsignatures") == 0 && i + 1 < argc)
+		{
+			Settings.RootSignatureCount = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-materials") == 0 && i + 1 < argc)
+		{
+			Settings.MaterialCount = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-transparent") == 0 && i + 1 < argc)
+		{
+			Settings.TransparentFraction = static_cast<float>(atof(argv[++i]));
+		}
+		else
+		{
+			bValid = false;
+		}
+	}
+
+	if (!bValid || Settings.Frames == 0)
+	{
+		fprintf(stderr, "Usage: DrawSortBenchmark [-frames N] [-draws N ...] [-threads N ...] [-states N] [-rootsignatures N] [-materials N] [-transparent F]\n");
+		return 1;
+	}
+
+	DrawSortBenchmark Benchmark(Settings);
+	if (!Benchmark.Run())
+	{
+		fprintf(stderr, "%s\n", Benchmark.GetLastError().c_str());
+		return 1;
+	}
+	return Benchmark.WriteReport("DrawSortBenchmark.txt") ? 0 : 1;
+}
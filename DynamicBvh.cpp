@@ -0,0 +1,1029 @@
+#include "DynamicBvh.h"
+#include "Common.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+
+namespace
+{
+	const uint32_t ObjectFlag = 0x80000000;
+
+	//Empty slots hold an inside out box, so nothing ever overlaps them
+	const float EmptyMin = 1e30f;
+	const float EmptyMax = -1e30f;
+
+	const uint32_t SahBinCount = 16;
+
+	bool IsObject(uint32_t Child)
+	{
+		return (Child & ObjectFlag) != 0;
+	}
+
+	float GetAxis(const Float3& Value, int Axis)
+	{
+		return Axis == 0 ? Value.X : (Axis == 1 ? Value.Y : Value.Z);
+	}
+
+	Aabb EmptyAabb()
+	{
+		Aabb Result = { MakeFloat3(EmptyMin, EmptyMin, EmptyMin), MakeFloat3(EmptyMax, EmptyMax, EmptyMax) };
+		return Result;
+	}
+
+	bool AabbEquals(const Aabb& A, const Aabb& B)
+	{
+		return A.Min.X == B.Min.X && A.Min.Y == B.Min.Y && A.Min.Z == B.Min.Z &&
+			A.Max.X == B.Max.X && A.Max.Y == B.Max.Y && A.Max.Z == B.Max.Z;
+	}
+
+	//Only as deep as the tree; spills to the heap for unusually deep ones
+	template<typename T>
+	class TraversalStack
+	{
+	public:
+		TraversalStack() : mCount(0) {}
+
+		bool IsEmpty() const { return mCount == 0; }
+
+		void Push(const T& Value)
+		{
+			if (mCount < LocalSize)
+			{
+				mLocal[mCount] = Value;
+			}
+			else
+			{
+				mOverflow.push_back(Value);
+			}
+			++mCount;
+		}
+
+		T Pop()
+		{
+			--mCount;
+			if (mCount < LocalSize)
+			{
+				return mLocal[mCount];
+			}
+			T Value = mOverflow.back();
+			mOverflow.pop_back();
+			return Value;
+		}
+
+	private:
+		static const uint32_t LocalSize = 64;
+		T mLocal[LocalSize];
+		std::vector<T> mOverflow;
+		uint32_t mCount;
+	};
+
+	SimdFloat4 SurfaceAreas(const SimdFloat4& MinX, const SimdFloat4& MinY, const SimdFloat4& MinZ,
+		const SimdFloat4& MaxX, const SimdFloat4& MaxY, const SimdFloat4& MaxZ)
+	{
+		SimdFloat4 SizeX = MaxX - MinX;
+		SimdFloat4 SizeY = MaxY - MinY;
+		SimdFloat4 SizeZ = MaxZ - MinZ;
+		return (SizeX * SizeY + SizeY * SizeZ + SizeZ * SizeX) * SimdFloat4::Splat(2.0f);
+	}
+
+	struct RayStackEntry
+	{
+		uint32_t Node;
+		float Distance;
+	};
+
+	struct DepthStackEntry
+	{
+		uint32_t Node;
+		uint32_t Depth;
+	};
+}
+
+struct DynamicBvh::RebuildState
+{
+	JobSystem* Jobs = nullptr;
+	JobCounter Counter;
+	std::vector<BuildItem> Items;
+	uint32_t ObjectCapacity = 0;
+	BuiltTree Tree;
+	std::vector<uint8_t> Touched;	//Objects changed since the copy was taken
+};
+
+DynamicBvh::DynamicBvh(float Margin)
+	: mMargin(Margin), mRoot(NullIndex), mObjectCount(0)
+{
+	Assert(Margin >= 0.0f);
+}
+
+DynamicBvh::~DynamicBvh()
+{
+	//The job reads the rebuild state, so it has to finish first
+	if (mRebuild)
+	{
+		mRebuild->Jobs->Wait(mRebuild->Counter);
+	}
+}
+
+uint32_t DynamicBvh::Insert(const Aabb& Bounds)
+{
+	uint32_t Object;
+	if (!mFreeObjects.empty())
+	{
+		Object = mFreeObjects.back();
+		mFreeObjects.pop_back();
+	}
+	else
+	{
+		Object = static_cast<uint32_t>(mObjects.size());
+		Check(Object < ObjectFlag);
+		mObjects.emplace_back();
+	}
+
+	ObjectRecord& Record = mObjects[Object];
+	Record.Bounds = Bounds;
+	Record.Grown = Expand(Bounds, mMargin);
+	Record.Node = NullIndex;
+	Record.Slot = NullIndex;
+	Record.bAlive = true;
+
+	InsertLeaf(Object);
+	MarkTouched(Object);
+	++mObjectCount;
+	return Object;
+}
+
+void DynamicBvh::Remove(uint32_t Object)
+{
+	Assert(Object < mObjects.size() && mObjects[Object].bAlive);
+
+	RemoveLeaf(Object);
+	mObjects[Object].bAlive = false;
+	mFreeObjects.push_back(Object);
+	MarkTouched(Object);
+	--mObjectCount;
+}
+
+bool DynamicBvh::Move(uint32_t Object, const Aabb& Bounds)
+{
+	Assert(Object < mObjects.size() && mObjects[Object].bAlive);
+
+	ObjectRecord& Record = mObjects[Object];
+	Record.Bounds = Bounds;
+	if (Contains(Record.Grown, Bounds))
+	{
+		return false;
+	}
+
+	//Refitting stretches every box up to the root over both places, so a
+	//jump somewhere else entirely is better off reinserted
+	Aabb Grown = Expand(Bounds, mMargin);
+	bool bNearby = Intersects(Record.Grown, Grown);
+	MarkTouched(Object);
+
+	if (bNearby)
+	{
+		Record.Grown = Grown;
+		SetChild(Record.Node, Record.Slot, Object | ObjectFlag, Grown);
+		RefitUpwards(Record.Node);
+	}
+	else
+	{
+		RemoveLeaf(Object);
+		mObjects[Object].Grown = Grown;
+		InsertLeaf(Object);
+	}
+	return true;
+}
+
+void DynamicBvh::Rebuild()
+{
+	Check(!IsRebuilding());
+
+	std::vector<BuildItem> Items;
+	GatherBuildItems(Items);
+	BuiltTree Tree;
+	BuildTree(Items, static_cast<uint32_t>(mObjects.size()), Tree);
+	AdoptTree(Tree);
+}
+
+void DynamicBvh::BeginRebuild(JobSystem& Jobs)
+{
+	Check(!IsRebuilding());
+
+	mRebuild.reset(new RebuildState());
+	RebuildState* State = mRebuild.get();
+	State->Jobs = &Jobs;
+	State->ObjectCapacity = static_cast<uint32_t>(mObjects.size());
+	State->Touched.assign(mObjects.size(), 0);
+	GatherBuildItems(State->Items);
+
+	Jobs.Submit([State]()
+	{
+		BuildTree(State->Items, State->ObjectCapacity, State->Tree);
+	}, &State->Counter);
+}
+
+void DynamicBvh::FinishRebuild()
+{
+	Check(IsRebuilding());
+
+	mRebuild->Jobs->Wait(mRebuild->Counter);
+	std::unique_ptr<RebuildState> State(std::move(mRebuild));
+	AdoptTree(State->Tree);
+
+	//Objects added since the copy aren't in the new tree, removed ones still
+	//are, and moved or reused ones are where they were. As in Move(), those
+	//now somewhere else entirely are reinserted rather than refit.
+	for (uint32_t Object = 0; Object < mObjects.size(); ++Object)
+	{
+		if (Object < State->Touched.size() && !State->Touched[Object])
+		{
+			continue;
+		}
+
+		ObjectRecord& Record = mObjects[Object];
+		bool bInTree = Record.Node != NullIndex;
+		if (bInTree && (!Record.bAlive || !Intersects(GetChildBounds(Record.Node, Record.Slot), Record.Grown)))
+		{
+			RemoveLeaf(Object);
+			bInTree = false;
+		}
+
+		if (bInTree)
+		{
+			SetChild(Record.Node, Record.Slot, Object | ObjectFlag, Record.Grown);
+			RefitUpwards(Record.Node);
+		}
+		else if (Record.bAlive)
+		{
+			InsertLeaf(Object);
+		}
+	}
+}
+
+void DynamicBvh::QueryFrustum(const Frustum& View, std::vector<uint32_t>& Out) const
+{
+	if (mRoot == NullIndex)
+	{
+		return;
+	}
+
+	SimdFloat4 NormalX[6], NormalY[6], NormalZ[6], Distance[6];
+	bool bPositiveX[6], bPositiveY[6], bPositiveZ[6];
+	for (int i = 0; i < 6; ++i)
+	{
+		const Plane& Side = View.Planes[i];
+		NormalX[i] = SimdFloat4::Splat(Side.Normal.X);
+		NormalY[i] = SimdFloat4::Splat(Side.Normal.Y);
+		NormalZ[i] = SimdFloat4::Splat(Side.Normal.Z);
+		Distance[i] = SimdFloat4::Splat(Side.Distance);
+		bPositiveX[i] = Side.Normal.X >= 0.0f;
+		bPositiveY[i] = Side.Normal.Y >= 0.0f;
+		bPositiveZ[i] = Side.Normal.Z >= 0.0f;
+	}
+	const SimdFloat4 Zero = SimdFloat4::Splat(0.0f);
+
+	//Nodes whose whole subtree is inside skip the tests below them
+	TraversalStack<uint32_t> Stack;
+	TraversalStack<uint32_t> Inside;
+	Stack.Push(mRoot);
+	while (!Stack.IsEmpty())
+	{
+		const Node& Current = mNodes[Stack.Pop()];
+		SimdFloat4 MinX = SimdFloat4::Load(Current.MinX);
+		SimdFloat4 MinY = SimdFloat4::Load(Current.MinY);
+		SimdFloat4 MinZ = SimdFloat4::Load(Current.MinZ);
+		SimdFloat4 MaxX = SimdFloat4::Load(Current.MaxX);
+		SimdFloat4 MaxY = SimdFloat4::Load(Current.MaxY);
+		SimdFloat4 MaxZ = SimdFloat4::Load(Current.MaxZ);
+
+		//Each plane's farthest corner in front decides outside, its nearest
+		//decides all inside
+		SimdFloat4 Outside = Zero;
+		SimdFloat4 Crossing = Zero;
+		for (int i = 0; i < 6; ++i)
+		{
+			SimdFloat4 Far = NormalX[i] * (bPositiveX[i] ? MaxX : MinX) + NormalY[i] * (bPositiveY[i] ? MaxY : MinY) +
+				NormalZ[i] * (bPositiveZ[i] ? MaxZ : MinZ) + Distance[i];
+			SimdFloat4 Near = NormalX[i] * (bPositiveX[i] ? MinX : MaxX) + NormalY[i] * (bPositiveY[i] ? MinY : MaxY) +
+				NormalZ[i] * (bPositiveZ[i] ? MinZ : MaxZ) + Distance[i];
+			Outside = Or(Outside, CompareLess(Far, Zero));
+			Crossing = Or(Crossing, CompareLess(Near, Zero));
+		}
+
+		uint32_t Used = (1u << Current.ChildCount) - 1;
+		uint32_t Visible = ~GetMaskBits(Outside) & Used;
+		uint32_t Partial = GetMaskBits(Crossing);
+		for (uint32_t Slot = 0; Slot < Current.ChildCount; ++Slot)
+		{
+			if (!((Visible >> Slot) & 1))
+			{
+				continue;
+			}
+
+			uint32_t Child = Current.Children[Slot];
+			if (IsObject(Child))
+			{
+				Out.push_back(Child & ~ObjectFlag);
+			}
+			else if ((Partial >> Slot) & 1)
+			{
+				Stack.Push(Child);
+			}
+			else
+			{
+				Inside.Push(Child);
+			}
+		}
+	}
+
+	while (!Inside.IsEmpty())
+	{
+		const Node& Current = mNodes[Inside.Pop()];
+		for (uint32_t Slot = 0; Slot < Current.ChildCount; ++Slot)
+		{
+			uint32_t Child = Current.Children[Slot];
+			if (IsObject(Child))
+			{
+				Out.push_back(Child & ~ObjectFlag);
+			}
+			else
+			{
+				Inside.Push(Child);
+			}
+		}
+	}
+}
+
+void DynamicBvh::QuerySphere(const Float3& Centre, float Radius, std::vector<uint32_t>& Out) const
+{
+	if (mRoot == NullIndex)
+	{
+		return;
+	}
+
+	const SimdFloat4 CentreX = SimdFloat4::Splat(Centre.X);
+	const SimdFloat4 CentreY = SimdFloat4::Splat(Centre.Y);
+	const SimdFloat4 CentreZ = SimdFloat4::Splat(Centre.Z);
+	const SimdFloat4 RadiusSquared = SimdFloat4::Splat(Radius * Radius);
+	const SimdFloat4 Zero = SimdFloat4::Splat(0.0f);
+
+	TraversalStack<uint32_t> Stack;
+	Stack.Push(mRoot);
+	while (!Stack.IsEmpty())
+	{
+		const Node& Current = mNodes[Stack.Pop()];
+
+		//Distance from the centre to the nearest point of each box
+		SimdFloat4 DeltaX = Max(Max(SimdFloat4::Load(Current.MinX) - CentreX, CentreX - SimdFloat4::Load(Current.MaxX)), Zero);
+		SimdFloat4 DeltaY = Max(Max(SimdFloat4::Load(Current.MinY) - CentreY, CentreY - SimdFloat4::Load(Current.MaxY)), Zero);
+		SimdFloat4 DeltaZ = Max(Max(SimdFloat4::Load(Current.MinZ) - CentreZ, CentreZ - SimdFloat4::Load(Current.MaxZ)), Zero);
+		SimdFloat4 DistanceSquared = DeltaX * DeltaX + DeltaY * DeltaY + DeltaZ * DeltaZ;
+
+		uint32_t Hits = GetMaskBits(CompareLessEqual(DistanceSquared, RadiusSquared)) & ((1u << Current.ChildCount) - 1);
+		for (uint32_t Slot = 0; Slot < Current.ChildCount; ++Slot)
+		{
+			if ((Hits >> Slot) & 1)
+			{
+				uint32_t Child = Current.Children[Slot];
+				if (IsObject(Child))
+				{
+					Out.push_back(Child & ~ObjectFlag);
+				}
+				else
+				{
+					Stack.Push(Child);
+				}
+			}
+		}
+	}
+}
+
+uint32_t DynamicBvh::RayCast(const Float3& Origin, const Float3& Direction, float MaxDistance, float& OutDistance) const
+{
+	if (mRoot == NullIndex)
+	{
+		return NullIndex;
+	}
+
+	//Axis parallel rays get a huge finite inverse rather than infinity, which
+	//would make 0 * inf on the slab boundaries
+	float Inverse[3];
+	for (int Axis = 0; Axis < 3; ++Axis)
+	{
+		float Component = GetAxis(Direction, Axis);
+		Inverse[Axis] = fabsf(Component) > 1e-20f ? 1.0f / Component : copysignf(1e30f, Component);
+	}
+
+	const SimdFloat4 OriginX = SimdFloat4::Splat(Origin.X);
+	const SimdFloat4 OriginY = SimdFloat4::Splat(Origin.Y);
+	const SimdFloat4 OriginZ = SimdFloat4::Splat(Origin.Z);
+	const SimdFloat4 InverseX = SimdFloat4::Splat(Inverse[0]);
+	const SimdFloat4 InverseY = SimdFloat4::Splat(Inverse[1]);
+	const SimdFloat4 InverseZ = SimdFloat4::Splat(Inverse[2]);
+	const SimdFloat4 Zero = SimdFloat4::Splat(0.0f);
+
+	uint32_t Nearest = NullIndex;
+	float NearestDistance = MaxDistance;
+
+	TraversalStack<RayStackEntry> Stack;
+	Stack.Push({ mRoot, 0.0f });
+	while (!Stack.IsEmpty())
+	{
+		RayStackEntry Entry = Stack.Pop();
+		if (Entry.Distance > NearestDistance)
+		{
+			continue;
+		}
+		const Node& Current = mNodes[Entry.Node];
+
+		SimdFloat4 NearX = (SimdFloat4::Load(Current.MinX) - OriginX) * InverseX;
+		SimdFloat4 FarX = (SimdFloat4::Load(Current.MaxX) - OriginX) * InverseX;
+		SimdFloat4 NearY = (SimdFloat4::Load(Current.MinY) - OriginY) * InverseY;
+		SimdFloat4 FarY = (SimdFloat4::Load(Current.MaxY) - OriginY) * InverseY;
+		SimdFloat4 NearZ = (SimdFloat4::Load(Current.MinZ) - OriginZ) * InverseZ;
+		SimdFloat4 FarZ = (SimdFloat4::Load(Current.MaxZ) - OriginZ) * InverseZ;
+
+		SimdFloat4 Enter = Max(Max(Min(NearX, FarX), Min(NearY, FarY)), Max(Min(NearZ, FarZ), Zero));
+		SimdFloat4 Exit = Min(Min(Max(NearX, FarX), Max(NearY, FarY)), Min(Max(NearZ, FarZ), SimdFloat4::Splat(NearestDistance)));
+		uint32_t Hits = GetMaskBits(CompareLessEqual(Enter, Exit)) & ((1u << Current.ChildCount) - 1);
+		if (Hits == 0)
+		{
+			continue;
+		}
+
+		//Farthest pushed first, so the nearest is tried first and can cut off the rest
+		RayStackEntry Children[4];
+		uint32_t ChildCount = 0;
+		for (uint32_t Slot = 0; Slot < Current.ChildCount; ++Slot)
+		{
+			if (!((Hits >> Slot) & 1))
+			{
+				continue;
+			}
+
+			uint32_t Child = Current.Children[Slot];
+			if (!IsObject(Child))
+			{
+				RayStackEntry New = { Child, Enter.GetLane(Slot) };
+				uint32_t Position = ChildCount++;
+				for (; Position > 0 && Children[Position - 1].Distance < New.Distance; --Position)
+				{
+					Children[Position] = Children[Position - 1];
+				}
+				Children[Position] = New;
+				continue;
+			}
+
+			//Grown bounds were hit, now the exact ones
+			uint32_t Object = Child & ~ObjectFlag;
+			const Aabb& Bounds = mObjects[Object].Bounds;
+			float ObjectEnter = 0.0f;
+			float ObjectExit = NearestDistance;
+			for (int Axis = 0; Axis < 3; ++Axis)
+			{
+				float Start = GetAxis(Origin, Axis);
+				float T0 = (GetAxis(Bounds.Min, Axis) - Start) * Inverse[Axis];
+				float T1 = (GetAxis(Bounds.Max, Axis) - Start) * Inverse[Axis];
+				ObjectEnter = std::max(ObjectEnter, std::min(T0, T1));
+				ObjectExit = std::min(ObjectExit, std::max(T0, T1));
+			}
+			if (ObjectEnter <= ObjectExit && ObjectEnter < NearestDistance)
+			{
+				Nearest = Object;
+				NearestDistance = ObjectEnter;
+			}
+		}
+
+		for (uint32_t i = 0; i < ChildCount; ++i)
+		{
+			Stack.Push(Children[i]);
+		}
+	}
+
+	OutDistance = NearestDistance;
+	return Nearest;
+}
+
+DynamicBvhStats DynamicBvh::ComputeStats() const
+{
+	DynamicBvhStats Stats;
+	Stats.ObjectCount = mObjectCount;
+	if (mRoot == NullIndex)
+	{
+		return Stats;
+	}
+
+	float RootArea = std::max(SurfaceArea(GetNodeBounds(mRoot)), 1e-20f);
+	float AreaSum = 0.0f;
+
+	TraversalStack<DepthStackEntry> Stack;
+	Stack.Push({ mRoot, 1 });
+	while (!Stack.IsEmpty())
+	{
+		DepthStackEntry Entry = Stack.Pop();
+		++Stats.NodeCount;
+		Stats.Depth = std::max(Stats.Depth, Entry.Depth);
+		AreaSum += SurfaceArea(GetNodeBounds(Entry.Node));
+
+		const Node& Current = mNodes[Entry.Node];
+		for (uint32_t Slot = 0; Slot < Current.ChildCount; ++Slot)
+		{
+			if (!IsObject(Current.Children[Slot]))
+			{
+				Stack.Push({ Current.Children[Slot], Entry.Depth + 1 });
+			}
+		}
+	}
+
+	Stats.Cost = AreaSum / RootArea;
+	return Stats;
+}
+
+DynamicBvh::Node DynamicBvh::MakeNode(uint32_t Parent, uint32_t ParentSlot)
+{
+	Node Result;
+	for (uint32_t Slot = 0; Slot < 4; ++Slot)
+	{
+		WriteChild(Result, Slot, NullIndex, EmptyAabb());
+	}
+	Result.ChildCount = 0;
+	Result.Parent = Parent;
+	Result.ParentSlot = ParentSlot;
+	return Result;
+}
+
+void DynamicBvh::WriteChild(Node& Target, uint32_t Slot, uint32_t Child, const Aabb& Bounds)
+{
+	Target.MinX[Slot] = Bounds.Min.X;
+	Target.MinY[Slot] = Bounds.Min.Y;
+	Target.MinZ[Slot] = Bounds.Min.Z;
+	Target.MaxX[Slot] = Bounds.Max.X;
+	Target.MaxY[Slot] = Bounds.Max.Y;
+	Target.MaxZ[Slot] = Bounds.Max.Z;
+	Target.Children[Slot] = Child;
+}
+
+void DynamicBvh::BuildTree(std::vector<BuildItem>& Items, uint32_t ObjectCapacity, BuiltTree& Out)
+{
+	Out.Nodes.clear();
+	Out.Nodes.reserve(Items.size() / 2 + 1);
+	Out.ObjectNodes.assign(ObjectCapacity, static_cast<uint32_t>(NullIndex));
+	Out.ObjectSlots.assign(ObjectCapacity, static_cast<uint32_t>(NullIndex));
+	Out.Root = Items.empty() ? NullIndex : BuildNode(Items, 0, static_cast<uint32_t>(Items.size()), NullIndex, NullIndex, Out);
+}
+
+uint32_t DynamicBvh::BuildNode(std::vector<BuildItem>& Items, uint32_t Begin, uint32_t End, uint32_t Parent, uint32_t ParentSlot,
+	BuiltTree& Out)
+{
+	uint32_t Index = static_cast<uint32_t>(Out.Nodes.size());
+	Out.Nodes.push_back(MakeNode(Parent, ParentSlot));
+
+	//Up to four objects go straight in. Otherwise split in two, and each half
+	//in two again, for up to four children.
+	uint32_t Bounds[5] = { Begin, End };
+	uint32_t PartCount = 1;
+	if (End - Begin <= 4)
+	{
+		PartCount = End - Begin;
+		for (uint32_t Part = 0; Part <= PartCount; ++Part)
+		{
+			Bounds[Part] = Begin + Part;
+		}
+	}
+	else
+	{
+		uint32_t Middle = PartitionSah(Items, Begin, End);
+		uint32_t Splits[5];
+		uint32_t SplitCount = 0;
+		Splits[SplitCount++] = Begin;
+		if (Middle - Begin > 1)
+		{
+			Splits[SplitCount++] = PartitionSah(Items, Begin, Middle);
+		}
+		Splits[SplitCount++] = Middle;
+		if (End - Middle > 1)
+		{
+			Splits[SplitCount++] = PartitionSah(Items, Middle, End);
+		}
+		Splits[SplitCount] = End;
+
+		PartCount = SplitCount;
+		std::copy(Splits, Splits + SplitCount + 1, Bounds);
+	}
+
+	for (uint32_t Part = 0; Part < PartCount; ++Part)
+	{
+		uint32_t PartBegin = Bounds[Part];
+		uint32_t PartEnd = Bounds[Part + 1];
+
+		Aabb PartBounds = Items[PartBegin].Bounds;
+		for (uint32_t i = PartBegin + 1; i < PartEnd; ++i)
+		{
+			PartBounds = Union(PartBounds, Items[i].Bounds);
+		}
+
+		uint32_t Child;
+		if (PartEnd - PartBegin == 1)
+		{
+			uint32_t Object = Items[PartBegin].Object;
+			Out.ObjectNodes[Object] = Index;
+			Out.ObjectSlots[Object] = Part;
+			Child = Object | ObjectFlag;
+		}
+		else
+		{
+			Child = BuildNode(Items, PartBegin, PartEnd, Index, Part, Out);
+		}
+
+		//Out.Nodes may have grown, so no reference is held across the build
+		WriteChild(Out.Nodes[Index], Part, Child, PartBounds);
+		Out.Nodes[Index].ChildCount = Part + 1;
+	}
+	return Index;
+}
+
+uint32_t DynamicBvh::PartitionSah(std::vector<BuildItem>& Items, uint32_t Begin, uint32_t End)
+{
+	Assert(End - Begin >= 2);
+
+	Float3 CentreMin = Items[Begin].Centre;
+	Float3 CentreMax = Items[Begin].Centre;
+	for (uint32_t i = Begin + 1; i < End; ++i)
+	{
+		CentreMin = Min(CentreMin, Items[i].Centre);
+		CentreMax = Max(CentreMax, Items[i].Centre);
+	}
+
+	Float3 Extent = CentreMax - CentreMin;
+	int Axis = Extent.X >= Extent.Y && Extent.X >= Extent.Z ? 0 : (Extent.Y >= Extent.Z ? 1 : 2);
+	float AxisMin = GetAxis(CentreMin, Axis);
+	float AxisExtent = GetAxis(Extent, Axis);
+
+	uint32_t Middle = (Begin + End) / 2;
+	if (AxisExtent > 1e-12f)
+	{
+		uint32_t Counts[SahBinCount] = {};
+		Aabb BinBounds[SahBinCount];
+		std::fill(BinBounds, BinBounds + SahBinCount, EmptyAabb());
+
+		float Scale = SahBinCount / AxisExtent;
+		auto BinOf = [&](const BuildItem& Item)
+		{
+			uint32_t Bin = static_cast<uint32_t>((GetAxis(Item.Centre, Axis) - AxisMin) * Scale);
+			return std::min(Bin, SahBinCount - 1);
+		};
+		for (uint32_t i = Begin; i < End; ++i)
+		{
+			uint32_t Bin = BinOf(Items[i]);
+			++Counts[Bin];
+			BinBounds[Bin] = Union(BinBounds[Bin], Items[i].Bounds);
+		}
+
+		//Cost of splitting after each bin: area times count on both sides
+		float RightCost[SahBinCount];
+		Aabb Right = EmptyAabb();
+		uint32_t RightCount = 0;
+		for (uint32_t Bin = SahBinCount - 1; Bin > 0; --Bin)
+		{
+			Right = Union(Right, BinBounds[Bin]);
+			RightCount += Counts[Bin];
+			RightCost[Bin - 1] = RightCount > 0 ? SurfaceArea(Right) * RightCount : 0.0f;
+		}
+
+		float BestCost = 0.0f;
+		uint32_t BestBin = SahBinCount;
+		Aabb Left = EmptyAabb();
+		uint32_t LeftCount = 0;
+		for (uint32_t Bin = 0; Bin + 1 < SahBinCount; ++Bin)
+		{
+			Left = Union(Left, BinBounds[Bin]);
+			LeftCount += Counts[Bin];
+			if (LeftCount == 0 || LeftCount == End - Begin)
+			{
+				continue;
+			}
+
+			float Cost = SurfaceArea(Left) * LeftCount + RightCost[Bin];
+			if (BestBin == SahBinCount || Cost < BestCost)
+			{
+				BestCost = Cost;
+				BestBin = Bin;
+			}
+		}
+
+		if (BestBin != SahBinCount)
+		{
+			auto Split = std::partition(Items.begin() + Begin, Items.begin() + End,
+				[&](const BuildItem& Item) { return BinOf(Item) <= BestBin; });
+			return static_cast<uint32_t>(Split - Items.begin());
+		}
+	}
+
+	//Everything in one bin - split by count
+	std::nth_element(Items.begin() + Begin, Items.begin() + Middle, Items.begin() + End,
+		[Axis](const BuildItem& A, const BuildItem& B) { return GetAxis(A.Centre, Axis) < GetAxis(B.Centre, Axis); });
+	return Middle;
+}
+
+void DynamicBvh::GatherBuildItems(std::vector<BuildItem>& Out) const
+{
+	Out.clear();
+	Out.reserve(mObjectCount);
+	for (uint32_t Object = 0; Object < mObjects.size(); ++Object)
+	{
+		const ObjectRecord& Record = mObjects[Object];
+		if (Record.bAlive)
+		{
+			BuildItem Item = { Record.Grown, (Record.Grown.Min + Record.Grown.Max) * 0.5f, Object };
+			Out.push_back(Item);
+		}
+	}
+}
+
+void DynamicBvh::AdoptTree(BuiltTree& Tree)
+{
+	mNodes.swap(Tree.Nodes);
+	mFreeNodes.clear();
+	mRoot = Tree.Root;
+	for (uint32_t Object = 0; Object < mObjects.size(); ++Object)
+	{
+		bool bBuilt = Object < Tree.ObjectNodes.size();
+		mObjects[Object].Node = bBuilt ? Tree.ObjectNodes[Object] : NullIndex;
+		mObjects[Object].Slot = bBuilt ? Tree.ObjectSlots[Object] : NullIndex;
+	}
+}
+
+void DynamicBvh::MarkTouched(uint32_t Object)
+{
+	//Objects past the copy are all treated as touched anyway
+	if (mRebuild && Object < mRebuild->Touched.size())
+	{
+		mRebuild->Touched[Object] = 1;
+	}
+}
+
+uint32_t DynamicBvh::AllocateNode(uint32_t Parent, uint32_t ParentSlot)
+{
+	if (!mFreeNodes.empty())
+	{
+		uint32_t Index = mFreeNodes.back();
+		mFreeNodes.pop_back();
+		mNodes[Index] = MakeNode(Parent, ParentSlot);
+		return Index;
+	}
+
+	mNodes.push_back(MakeNode(Parent, ParentSlot));
+	return static_cast<uint32_t>(mNodes.size() - 1);
+}
+
+void DynamicBvh::FreeNode(uint32_t Index)
+{
+	mNodes[Index].ChildCount = 0;
+	mFreeNodes.push_back(Index);
+}
+
+void DynamicBvh::InsertLeaf(uint32_t Object)
+{
+	const Aabb Grown = mObjects[Object].Grown;
+	if (mRoot == NullIndex)
+	{
+		mRoot = AllocateNode(NullIndex, NullIndex);
+		InsertChild(mRoot, Object | ObjectFlag, Grown);
+		return;
+	}
+
+	const SimdFloat4 GrownMinX = SimdFloat4::Splat(Grown.Min.X);
+	const SimdFloat4 GrownMinY = SimdFloat4::Splat(Grown.Min.Y);
+	const SimdFloat4 GrownMinZ = SimdFloat4::Splat(Grown.Min.Z);
+	const SimdFloat4 GrownMaxX = SimdFloat4::Splat(Grown.Max.X);
+	const SimdFloat4 GrownMaxY = SimdFloat4::Splat(Grown.Max.Y);
+	const SimdFloat4 GrownMaxZ = SimdFloat4::Splat(Grown.Max.Z);
+
+	//Down whichever child grows least, until that would be an object
+	uint32_t NodeIndex = mRoot;
+	for (;;)
+	{
+		const Node& Current = mNodes[NodeIndex];
+		SimdFloat4 MinX = SimdFloat4::Load(Current.MinX);
+		SimdFloat4 MinY = SimdFloat4::Load(Current.MinY);
+		SimdFloat4 MinZ = SimdFloat4::Load(Current.MinZ);
+		SimdFloat4 MaxX = SimdFloat4::Load(Current.MaxX);
+		SimdFloat4 MaxY = SimdFloat4::Load(Current.MaxY);
+		SimdFloat4 MaxZ = SimdFloat4::Load(Current.MaxZ);
+
+		alignas(16) float Areas[4];
+		alignas(16) float Growths[4];
+		SimdFloat4 Area = SurfaceAreas(MinX, MinY, MinZ, MaxX, MaxY, MaxZ);
+		Area.Store(Areas);
+		(SurfaceAreas(Min(MinX, GrownMinX), Min(MinY, GrownMinY), Min(MinZ, GrownMinZ),
+			Max(MaxX, GrownMaxX), Max(MaxY, GrownMaxY), Max(MaxZ, GrownMaxZ)) - Area).Store(Growths);
+
+		uint32_t Best = 0;
+		for (uint32_t Slot = 1; Slot < Current.ChildCount; ++Slot)
+		{
+			if (Growths[Slot] < Growths[Best] || (Growths[Slot] == Growths[Best] && Areas[Slot] < Areas[Best]))
+			{
+				Best = Slot;
+			}
+		}
+
+		if (Current.ChildCount == 0 || IsObject(Current.Children[Best]))
+		{
+			break;
+		}
+		NodeIndex = Current.Children[Best];
+	}
+
+	InsertChild(NodeIndex, Object | ObjectFlag, Grown);
+}
+
+void DynamicBvh::RemoveLeaf(uint32_t Object)
+{
+	uint32_t NodeIndex = mObjects[Object].Node;
+	uint32_t Slot = mObjects[Object].Slot;
+	Assert(NodeIndex != NullIndex && mNodes[NodeIndex].Children[Slot] == (Object | ObjectFlag));
+
+	//Last child fills the gap
+	uint32_t Last = mNodes[NodeIndex].ChildCount - 1;
+	if (Slot != Last)
+	{
+		SetChild(NodeIndex, Slot, mNodes[NodeIndex].Children[Last], GetChildBounds(NodeIndex, Last));
+	}
+	ClearChild(NodeIndex, Last);
+	--mNodes[NodeIndex].ChildCount;
+	mObjects[Object].Node = NullIndex;
+	mObjects[Object].Slot = NullIndex;
+
+	uint32_t Remaining = mNodes[NodeIndex].ChildCount;
+	if (NodeIndex == mRoot)
+	{
+		if (Remaining == 0)
+		{
+			FreeNode(NodeIndex);
+			mRoot = NullIndex;
+		}
+		else if (Remaining == 1 && !IsObject(mNodes[NodeIndex].Children[0]))
+		{
+			uint32_t NewRoot = mNodes[NodeIndex].Children[0];
+			mNodes[NewRoot].Parent = NullIndex;
+			mNodes[NewRoot].ParentSlot = NullIndex;
+			FreeNode(NodeIndex);
+			mRoot = NewRoot;
+		}
+		return;
+	}
+
+	//A node left with one child is replaced by it
+	Assert(Remaining > 0);
+	if (Remaining == 1)
+	{
+		uint32_t Parent = mNodes[NodeIndex].Parent;
+		uint32_t ParentSlot = mNodes[NodeIndex].ParentSlot;
+		SetChild(Parent, ParentSlot, mNodes[NodeIndex].Children[0], GetChildBounds(NodeIndex, 0));
+		FreeNode(NodeIndex);
+		NodeIndex = Parent;
+	}
+	RefitUpwards(NodeIndex);
+}
+
+void DynamicBvh::InsertChild(uint32_t NodeIndex, uint32_t Child, const Aabb& Bounds)
+{
+	if (mNodes[NodeIndex].ChildCount < 4)
+	{
+		uint32_t Slot = mNodes[NodeIndex].ChildCount++;
+		SetChild(NodeIndex, Slot, Child, Bounds);
+		RefitUpwards(NodeIndex);
+		return;
+	}
+
+	//Full: sort all five along the axis their centres spread most, then keep
+	//whichever of a 2|3 or 3|2 split has less surface area
+	uint32_t Entries[5];
+	Aabb EntryBounds[5];
+	for (uint32_t Slot = 0; Slot < 4; ++Slot)
+	{
+		Entries[Slot] = mNodes[NodeIndex].Children[Slot];
+		EntryBounds[Slot] = GetChildBounds(NodeIndex, Slot);
+	}
+	Entries[4] = Child;
+	EntryBounds[4] = Bounds;
+
+	Float3 CentreMin = (EntryBounds[0].Min + EntryBounds[0].Max) * 0.5f;
+	Float3 CentreMax = CentreMin;
+	for (uint32_t i = 1; i < 5; ++i)
+	{
+		Float3 Centre = (EntryBounds[i].Min + EntryBounds[i].Max) * 0.5f;
+		CentreMin = Min(CentreMin, Centre);
+		CentreMax = Max(CentreMax, Centre);
+	}
+	Float3 Extent = CentreMax - CentreMin;
+	int Axis = Extent.X >= Extent.Y && Extent.X >= Extent.Z ? 0 : (Extent.Y >= Extent.Z ? 1 : 2);
+
+	uint32_t Order[5] = { 0, 1, 2, 3, 4 };
+	std::sort(Order, Order + 5, [&](uint32_t A, uint32_t B)
+	{
+		return GetAxis(EntryBounds[A].Min + EntryBounds[A].Max, Axis) < GetAxis(EntryBounds[B].Min + EntryBounds[B].Max, Axis);
+	});
+
+	auto SplitArea = [&](uint32_t LeftCount)
+	{
+		Aabb Left = EntryBounds[Order[0]];
+		Aabb Right = EntryBounds[Order[4]];
+		for (uint32_t i = 1; i < LeftCount; ++i)
+		{
+			Left = Union(Left, EntryBounds[Order[i]]);
+		}
+		for (uint32_t i = LeftCount; i < 4; ++i)
+		{
+			Right = Union(Right, EntryBounds[Order[i]]);
+		}
+		return SurfaceArea(Left) + SurfaceArea(Right);
+	};
+	uint32_t LeftCount = SplitArea(2) <= SplitArea(3) ? 2 : 3;
+
+	//Left half stays, right half goes to a new sibling
+	uint32_t Sibling = AllocateNode(NullIndex, NullIndex);
+	for (uint32_t Slot = 0; Slot < 4; ++Slot)
+	{
+		ClearChild(NodeIndex, Slot);
+	}
+	mNodes[NodeIndex].ChildCount = LeftCount;
+	mNodes[Sibling].ChildCount = 5 - LeftCount;
+	for (uint32_t i = 0; i < 5; ++i)
+	{
+		bool bLeft = i < LeftCount;
+		SetChild(bLeft ? NodeIndex : Sibling, bLeft ? i : i - LeftCount, Entries[Order[i]], EntryBounds[Order[i]]);
+	}
+
+	if (NodeIndex == mRoot)
+	{
+		mRoot = AllocateNode(NullIndex, NullIndex);
+		mNodes[mRoot].ChildCount = 2;
+		SetChild(mRoot, 0, NodeIndex, GetNodeBounds(NodeIndex));
+		SetChild(mRoot, 1, Sibling, GetNodeBounds(Sibling));
+		return;
+	}
+
+	uint32_t Parent = mNodes[NodeIndex].Parent;
+	SetChild(Parent, mNodes[NodeIndex].ParentSlot, NodeIndex, GetNodeBounds(NodeIndex));
+	InsertChild(Parent, Sibling, GetNodeBounds(Sibling));
+}
+
+void DynamicBvh::SetChild(uint32_t NodeIndex, uint32_t Slot, uint32_t Child, const Aabb& Bounds)
+{
+	WriteChild(mNodes[NodeIndex], Slot, Child, Bounds);
+	if (IsObject(Child))
+	{
+		mObjects[Child & ~ObjectFlag].Node = NodeIndex;
+		mObjects[Child & ~ObjectFlag].Slot = Slot;
+	}
+	else
+	{
+		mNodes[Child].Parent = NodeIndex;
+		mNodes[Child].ParentSlot = Slot;
+	}
+}
+
+void DynamicBvh::ClearChild(uint32_t NodeIndex, uint32_t Slot)
+{
+	WriteChild(mNodes[NodeIndex], Slot, NullIndex, EmptyAabb());
+}
+
+Aabb DynamicBvh::GetChildBounds(uint32_t NodeIndex, uint32_t Slot) const
+{
+	const Node& Current = mNodes[NodeIndex];
+	Aabb Result =
+	{
+		MakeFloat3(Current.MinX[Slot], Current.MinY[Slot], Current.MinZ[Slot]),
+		MakeFloat3(Current.MaxX[Slot], Current.MaxY[Slot], Current.MaxZ[Slot])
+	};
+	return Result;
+}
+
+Aabb DynamicBvh::GetNodeBounds(uint32_t NodeIndex) const
+{
+	Aabb Result = EmptyAabb();
+	for (uint32_t Slot = 0; Slot < mNodes[NodeIndex].ChildCount; ++Slot)
+	{
+		Result = Union(Result, GetChildBounds(NodeIndex, Slot));
+	}
+	return Result;
+}
+
+void DynamicBvh::RefitUpwards(uint32_t NodeIndex)
+{
+	while (NodeIndex != mRoot)
+	{
+		uint32_t Parent = mNodes[NodeIndex].Parent;
+		uint32_t ParentSlot = mNodes[NodeIndex].ParentSlot;
+		Aabb Bounds = GetNodeBounds(NodeIndex);
+		if (AabbEquals(Bounds, GetChildBounds(Parent, ParentSlot)))
+		{
+			return;
+		}
+
+		WriteChild(mNodes[Parent], ParentSlot, NodeIndex, Bounds);
+		NodeIndex = Parent;
+	}
+}
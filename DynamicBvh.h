@@ -0,0 +1,152 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "VectorMath.h"
+
+class JobSystem;
+
+struct DynamicBvhStats
+{
+	uint32_t ObjectCount = 0;
+	uint32_t NodeCount = 0;
+	uint32_t Depth = 0;
+	float Cost = 0.0f;	//Sum of node surface areas over the root's - lower is better
+};
+
+//Bounding volume hierarchy over moving objects, for culling, ray casts and
+//picking.
+//
+//Every node has up to four children, stored as structure of arrays so a query
+//tests all of them with one SimdFloat4 operation. A child is either another
+//node or an object.
+//
+//Objects are kept in the tree with their bounds grown by Margin, so small
+//moves don't touch the tree at all. Bigger ones refit the boxes up the path
+//to the root, and jumps to somewhere new reinsert. Inserts go down the path
+//that grows least and split full nodes in two, R-tree style, so the depth
+//stays logarithmic whatever order objects arrive in. All of that is cheap
+//but wears the tree down over time, so Rebuild() makes a fresh one with the
+//surface area heuristic. BeginRebuild() does that on the job system from a
+//copy of the bounds while the tree stays usable, and FinishRebuild() swaps
+//it in, replaying whatever changed in the meantime.
+//
+//Frustum and sphere queries test the grown bounds, so they can return
+//objects up to Margin outside. Ray casts test each object's exact bounds.
+class DynamicBvh
+{
+public:
+	static const uint32_t NullIndex = 0xFFFFFFFF;
+
+	DynamicBvh(float Margin = 0.1f);
+	~DynamicBvh();
+
+	//Returns the object's index, which stays the same until it's removed
+	uint32_t Insert(const Aabb& Bounds);
+	void Remove(uint32_t Object);
+
+	//True if the object moved outside its grown bounds and the tree changed
+	bool Move(uint32_t Object, const Aabb& Bounds);
+
+	void Rebuild();
+	void BeginRebuild(JobSystem& Jobs);
+	void FinishRebuild();
+	bool IsRebuilding() const { return mRebuild != nullptr; }
+
+	//Objects whose bounds reach in to the volume, in no particular order.
+	//Appended to Out.
+	void QueryFrustum(const Frustum& View, std::vector<uint32_t>& Out) const;
+	void QuerySphere(const Float3& Centre, float Radius, std::vector<uint32_t>& Out) const;
+
+	//Nearest object whose bounds the ray enters within MaxDistance, or
+	//NullIndex. Direction needn't be normalized; distances are in its units.
+	uint32_t RayCast(const Float3& Origin, const Float3& Direction, float MaxDistance, float& OutDistance) const;
+
+	const Aabb& GetBounds(uint32_t Object) const { return mObjects[Object].Bounds; }
+	uint32_t GetObjectCount() const { return mObjectCount; }
+
+	DynamicBvhStats ComputeStats() const;
+
+private:
+	struct alignas(16) Node
+	{
+		float MinX[4], MinY[4], MinZ[4];
+		float MaxX[4], MaxY[4], MaxZ[4];
+		uint32_t Children[4];	//Node index, or object index with ObjectFlag
+		uint32_t ChildCount;
+		uint32_t Parent;
+		uint32_t ParentSlot;
+	};
+
+	struct ObjectRecord
+	{
+		Aabb Bounds;
+		Aabb Grown;
+		uint32_t Node;	//Where it is in the tree
+		uint32_t Slot;
+		bool bAlive;
+	};
+
+	struct BuildItem
+	{
+		Aabb Bounds;
+		Float3 Centre;
+		uint32_t Object;
+	};
+
+	//A tree built away from the live one
+	struct BuiltTree
+	{
+		std::vector<Node> Nodes;
+		uint32_t Root = NullIndex;
+		std::vector<uint32_t> ObjectNodes;	//By object index, NullIndex if not in it
+		std::vector<uint32_t> ObjectSlots;
+	};
+
+	struct RebuildState;
+
+	static Node MakeNode(uint32_t Parent, uint32_t ParentSlot);
+	static void WriteChild(Node& Target, uint32_t Slot, uint32_t Child, const Aabb& Bounds);
+
+	static void BuildTree(std::vector<BuildItem>& Items, uint32_t ObjectCapacity, BuiltTree& Out);
+	static uint32_t BuildNode(std::vector<BuildItem>& Items, uint32_t Begin, uint32_t End, uint32_t Parent, uint32_t ParentSlot,
+		BuiltTree& Out);
+	static uint32_t PartitionSah(std::vector<BuildItem>& Items, uint32_t Begin, uint32_t End);
+
+	void GatherBuildItems(std::vector<BuildItem>& Out) const;
+	void AdoptTree(BuiltTree& Tree);
+	void MarkTouched(uint32_t Object);
+
+	uint32_t AllocateNode(uint32_t Parent, uint32_t ParentSlot);
+	void FreeNode(uint32_t Index);
+
+	void InsertLeaf(uint32_t Object);
+	void RemoveLeaf(uint32_t Object);
+
+	//Adds a child to a node, splitting it and its parents as they fill
+	void InsertChild(uint32_t NodeIndex, uint32_t Child, const Aabb& Bounds);
+
+	//Also points the child back at where it now is
+	void SetChild(uint32_t NodeIndex, uint32_t Slot, uint32_t Child, const Aabb& Bounds);
+	void ClearChild(uint32_t NodeIndex, uint32_t Slot);
+	Aabb GetChildBounds(uint32_t NodeIndex, uint32_t Slot) const;
+	Aabb GetNodeBounds(uint32_t NodeIndex) const;
+
+	//Recomputes bounds from NodeIndex up until one doesn't change
+	void RefitUpwards(uint32_t NodeIndex);
+
+private:
+	float mMargin;
+
+	std::vector<Node> mNodes;
+	std::vector<uint32_t> mFreeNodes;
+	uint32_t mRoot;
+
+	std::vector<ObjectRecord> mObjects;
+	std::vector<uint32_t> mFreeObjects;
+	uint32_t mObjectCount;
+
+	std::unique_ptr<RebuildState> mRebuild;
+};
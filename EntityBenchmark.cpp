@@ -0,0 +1,376 @@
+#include "EntityBenchmark.h"
+#include "Common.h"
+#include "EntityStore.h"
+#include "JobSystem.h"
+
+#include <chrono>
+#include <memory>
+#include <stdio.h>
+
+namespace
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	double MillisecondsSince(Clock::time_point Start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - Start).count();
+	}
+
+	const uint32_t MaxBenchComponents = 8;
+
+	template<uint32_t N>
+	struct BenchComponent
+	{
+		float Value[4];
+	};
+
+	void GetBenchComponentIds(uint32_t OutIds[MaxBenchComponents])
+	{
+		OutIds[0] = GetComponentTypeId<BenchComponent<0>>();
+		OutIds[1] = GetComponentTypeId<BenchComponent<1>>();
+		OutIds[2] = GetComponentTypeId<BenchComponent<2>>();
+		OutIds[3] = GetComponentTypeId<BenchComponent<3>>();
+		OutIds[4] = GetComponentTypeId<BenchComponent<4>>();
+		OutIds[5] = GetComponentTypeId<BenchComponent<5>>();
+		OutIds[6] = GetComponentTypeId<BenchComponent<6>>();
+		OutIds[7] = GetComponentTypeId<BenchComponent<7>>();
+	}
+
+	float InitialValue(uint32_t Entity, uint32_t Component, uint32_t Lane)
+	{
+		return static_cast<float>((Entity * 7 + Component * 3 + Lane) % 13);
+	}
+
+	//First = First * 0.5 + Others * 0.125, in component order. Every mode does
+	//the same operations in the same order, so results match exactly.
+	void UpdateChunk(const EntityChunkView& View, const uint32_t* TypeIds, uint32_t ComponentCount)
+	{
+		float* First = static_cast<float*>(View.GetColumn(TypeIds[0]));
+		uint32_t Floats = View.GetCount() * 4;
+
+		for (uint32_t i = 0; i < Floats; ++i)
+		{
+			First[i] *= 0.5f;
+		}
+		for (uint32_t Component = 1; Component < ComponentCount; ++Component)
+		{
+			const float* Other = static_cast<const float*>(View.GetColumn(TypeIds[Component]));
+			for (uint32_t i = 0; i < Floats; ++i)
+			{
+				First[i] += Other[i] * 0.125f;
+			}
+		}
+	}
+
+	void ResetValues(EntityStore& Store, ComponentMask Mask, const uint32_t* TypeIds, uint32_t ComponentCount)
+	{
+		Store.ForEachChunk(Mask, 0, [TypeIds, ComponentCount](const EntityChunkView& View)
+		{
+			for (uint32_t Component = 0; Component < ComponentCount; ++Component)
+			{
+				float* Values = static_cast<float*>(View.GetColumn(TypeIds[Component]));
+				for (uint32_t Row = 0; Row < View.GetCount(); ++Row)
+				{
+					for (uint32_t Lane = 0; Lane < 4; ++Lane)
+					{
+						Values[Row * 4 + Lane] = InitialValue(View.GetEntities()[Row].Index, Component, Lane);
+					}
+				}
+			}
+		});
+	}
+
+	double Checksum(EntityStore& Store, ComponentMask Mask, uint32_t FirstTypeId)
+	{
+		double Sum = 0.0;
+		Store.ForEachChunk(Mask, 0, [&Sum, FirstTypeId](const EntityChunkView& View)
+		{
+			const float* Values = static_cast<const float*>(View.GetColumn(FirstTypeId));
+			for (uint32_t i = 0; i < View.GetCount() * 4; ++i)
+			{
+				Sum += Values[i];
+			}
+		});
+		return Sum;
+	}
+
+	//The layout OnUpdate(dt) pushes implementations towards without a store
+	class BenchObject
+	{
+	public:
+		virtual ~BenchObject() {}
+		virtual void Update() = 0;
+		virtual float* GetFirst() = 0;
+	};
+
+	template<uint32_t ComponentCount>
+	class BenchObjectN : public BenchObject
+	{
+	public:
+		BenchObjectN(uint32_t Entity)
+		{
+			for (uint32_t Component = 0; Component < ComponentCount; ++Component)
+			{
+				for (uint32_t Lane = 0; Lane < 4; ++Lane)
+				{
+					mComponents[Component][Lane] = InitialValue(Entity, Component, Lane);
+				}
+			}
+		}
+
+		void Update() override
+		{
+			for (uint32_t Lane = 0; Lane < 4; ++Lane)
+			{
+				mComponents[0][Lane] *= 0.5f;
+			}
+			for (uint32_t Component = 1; Component < ComponentCount; ++Component)
+			{
+				for (uint32_t Lane = 0; Lane < 4; ++Lane)
+				{
+					mComponents[0][Lane] += mComponents[Component][Lane] * 0.125f;
+				}
+			}
+		}
+
+		float* GetFirst() override { return mComponents[0]; }
+
+	private:
+		float mComponents[ComponentCount][4];
+	};
+
+	BenchObject* CreateBenchObject(uint32_t ComponentCount, uint32_t Entity)
+	{
+		switch (ComponentCount)
+		{
+		case 1: return new BenchObjectN<1>(Entity);
+		case 2: return new BenchObjectN<2>(Entity);
+		case 3: return new BenchObjectN<3>(Entity);
+		case 4: return new BenchObjectN<4>(Entity);
+		case 5: return new BenchObjectN<5>(Entity);
+		case 6: return new BenchObjectN<6>(Entity);
+		case 7: return new BenchObjectN<7>(Entity);
+		default: return new BenchObjectN<8>(Entity);
+		}
+	}
+}
+
+EntityBenchmark::EntityBenchmark(const EntityBenchmarkSettings& Settings)
+	: mSettings(Settings)
+{
+	Assert(mSettings.EntityCount > 0 && mSettings.Iterations > 0);
+}
+
+EntityBenchmark::~EntityBenchmark()
+{}
+
+bool EntityBenchmark::Run()
+{
+	mResults.clear();
+	if (!CheckHandles())
+	{
+		return false;
+	}
+
+	for (uint32_t ComponentCount : mSettings.ComponentCounts)
+	{
+		if (ComponentCount == 0 || ComponentCount > MaxBenchComponents)
+		{
+			mLastError = "Component counts must be 1 to 8";
+			return false;
+		}
+		if (!RunComponentCount(ComponentCount))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool EntityBenchmark::CheckHandles()
+{
+	typedef BenchComponent<0> Value;
+	typedef BenchComponent<1> Extra;
+
+	EntityStore Store;
+	std::vector<EntityHandle> Entities;
+	for (uint32_t i = 0; i < 1000; ++i)
+	{
+		Value Initial = { { static_cast<float>(i), 0.0f, 0.0f, 0.0f } };
+		Entities.push_back(Store.CreateEntity(Initial));
+	}
+
+	//Move some to another archetype and back out again
+	for (uint32_t i = 0; i < Entities.size(); i += 2)
+	{
+		Extra Added = { { static_cast<float>(i) * 2.0f, 0.0f, 0.0f, 0.0f } };
+		Store.AddComponent(Entities[i], Added);
+	}
+	for (uint32_t i = 0; i < Entities.size(); i += 4)
+	{
+		Store.RemoveComponent<Extra>(Entities[i]);
+	}
+
+	for (uint32_t i = 0; i < Entities.size(); i += 3)
+	{
+		Store.DestroyEntity(Entities[i]);
+	}
+
+	std::vector<EntityHandle> Reused;
+	for (uint32_t i = 0; i < 334; ++i)
+	{
+		Reused.push_back(Store.CreateEntity(MakeComponentMask<Value>()));
+	}
+
+	for (uint32_t i = 0; i < Entities.size(); ++i)
+	{
+		bool bDestroyed = i % 3 == 0;
+		Value* Data = Store.GetComponent<Value>(Entities[i]);
+		Extra* ExtraData = Store.GetComponent<Extra>(Entities[i]);
+		bool bHasExtra = i % 2 == 0 && i % 4 != 0;
+
+		if (Store.IsAlive(Entities[i]) == bDestroyed || (Data == nullptr) != bDestroyed ||
+			(!bDestroyed && Data->Value[0] != static_cast<float>(i)) ||
+			(!bDestroyed && (ExtraData != nullptr) != bHasExtra) ||
+			(ExtraData && ExtraData->Value[0] != static_cast<float>(i) * 2.0f))
+		{
+			mLastError = "Entity handle check failed";
+			return false;
+		}
+	}
+
+	uint32_t Matched = 0;
+	Store.ForEach<Value>([&Matched](Value&) { ++Matched; });
+	if (Matched != Store.GetEntityCount() || Store.GetEntityCount() != 1000 - 334 + 334)
+	{
+		mLastError = "Entity count check failed";
+		return false;
+	}
+
+	for (const EntityHandle& Entity : Reused)
+	{
+		if (!Store.IsAlive(Entity) || Store.GetComponent<Extra>(Entity) != nullptr)
+		{
+			mLastError = "Reused entity check failed";
+			return false;
+		}
+	}
+	return true;
+}
+
+bool EntityBenchmark::RunComponentCount(uint32_t ComponentCount)
+{
+	uint32_t TypeIds[MaxBenchComponents];
+	GetBenchComponentIds(TypeIds);
+
+	ComponentMask Mask = 0;
+	for (uint32_t Component = 0; Component < ComponentCount; ++Component)
+	{
+		Mask |= 1ull << TypeIds[Component];
+	}
+
+	JobSystem Jobs(mSettings.ThreadCount);
+	EntityStore Store;
+
+	auto Start = Clock::now();
+	for (uint32_t i = 0; i < mSettings.EntityCount; ++i)
+	{
+		Store.CreateEntity(Mask);
+	}
+	AddResult(ComponentCount, "Create", MillisecondsSince(Start), 1);
+
+	//Serial
+	ResetValues(Store, Mask, TypeIds, ComponentCount);
+	Start = Clock::now();
+	for (uint32_t Pass = 0; Pass < mSettings.Iterations; ++Pass)
+	{
+		Store.ForEachChunk(Mask, 0, [&TypeIds, ComponentCount](const EntityChunkView& View)
+		{
+			UpdateChunk(View, TypeIds, ComponentCount);
+		});
+	}
+	AddResult(ComponentCount, "Serial", MillisecondsSince(Start), mSettings.Iterations);
+	double SerialChecksum = Checksum(Store, Mask, TypeIds[0]);
+
+	//Parallel
+	ResetValues(Store, Mask, TypeIds, ComponentCount);
+	Start = Clock::now();
+	for (uint32_t Pass = 0; Pass < mSettings.Iterations; ++Pass)
+	{
+		Store.ParallelForEachChunk(Jobs, Mask, 0, [&TypeIds, ComponentCount](const EntityChunkView& View)
+		{
+			UpdateChunk(View, TypeIds, ComponentCount);
+		});
+	}
+	AddResult(ComponentCount, "Parallel", MillisecondsSince(Start), mSettings.Iterations);
+	double ParallelChecksum = Checksum(Store, Mask, TypeIds[0]);
+
+	//Polymorphic
+	std::vector<std::unique_ptr<BenchObject>> Objects;
+	Objects.reserve(mSettings.EntityCount);
+	for (uint32_t i = 0; i < mSettings.EntityCount; ++i)
+	{
+		Objects.emplace_back(CreateBenchObject(ComponentCount, i));
+	}
+
+	Start = Clock::now();
+	for (uint32_t Pass = 0; Pass < mSettings.Iterations; ++Pass)
+	{
+		for (const std::unique_ptr<BenchObject>& Object : Objects)
+		{
+			Object->Update();
+		}
+	}
+	AddResult(ComponentCount, "Polymorphic", MillisecondsSince(Start), mSettings.Iterations);
+
+	double PolymorphicChecksum = 0.0;
+	for (const std::unique_ptr<BenchObject>& Object : Objects)
+	{
+		for (uint32_t Lane = 0; Lane < 4; ++Lane)
+		{
+			PolymorphicChecksum += Object->GetFirst()[Lane];
+		}
+	}
+
+	if (SerialChecksum != ParallelChecksum || SerialChecksum != PolymorphicChecksum)
+	{
+		char Error[128];
+		snprintf(Error, sizeof(Error), "Results differ with %u components: %f %f %f", ComponentCount,
+			SerialChecksum, ParallelChecksum, PolymorphicChecksum);
+		mLastError = Error;
+		return false;
+	}
+	return true;
+}
+
+void EntityBenchmark::AddResult(uint32_t ComponentCount, const char* Mode, double Milliseconds, uint32_t Passes)
+{
+	EntityBenchmarkResult Result;
+	Result.ComponentCount = ComponentCount;
+	Result.Mode = Mode;
+	Result.MillisecondsPerPass = Milliseconds / Passes;
+	Result.EntitiesPerMillisecond = Result.MillisecondsPerPass > 0.0 ? mSettings.EntityCount / Result.MillisecondsPerPass : 0.0;
+	mResults.push_back(Result);
+}
+
+bool EntityBenchmark::WriteReport(const char* Filename) const
+{
+	FILE* File = fopen(Filename, "w");
+	if (!File)
+	{
+		return false;
+	}
+
+	fprintf(File, "Entities:    %u\n", mSettings.EntityCount);
+	fprintf(File, "Iterations:  %u\n", mSettings.Iterations);
+	fprintf(File, "Chunk size:  %u\n\n", EntityStore::ChunkSize);
+	fprintf(File, "Components,Mode,MsPerPass,EntitiesPerMs\n");
+	for (const EntityBenchmarkResult& Result : mResults)
+	{
+		fprintf(File, "%u,%s,%.3f,%.0f\n", Result.ComponentCount, Result.Mode.c_str(),
+			Result.MillisecondsPerPass, Result.EntitiesPerMillisecond);
+	}
+
+	fclose(File);
+	return true;
+}
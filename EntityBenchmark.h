@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//Iteration speed of EntityStore queries, as entities per millisecond, for
+//EntityCount entities with each of ComponentCounts 16 byte components. The
+//update reads every component and writes the first. Modes:
+//	Serial		- ForEachChunk on this thread
+//	Parallel	- ParallelForEachChunk over the job system
+//	Polymorphic	- the same update as a virtual call on individually allocated
+//				  objects, for comparison
+//	Create		- creating the entities in the first place
+//
+//Also checks that all three modes produce the same results and that entity
+//handles go stale when destroyed and aren't confused with reused indices.
+//Run() fails if any check does.
+struct EntityBenchmarkSettings
+{
+	uint32_t EntityCount = 1000000;
+	std::vector<uint32_t> ComponentCounts = { 1, 2, 4, 8 };
+	uint32_t Iterations = 20;
+	uint32_t ThreadCount = 0;
+};
+
+struct EntityBenchmarkResult
+{
+	uint32_t ComponentCount = 0;
+	std::string Mode;
+	double MillisecondsPerPass = 0.0;
+	double EntitiesPerMillisecond = 0.0;
+};
+
+class EntityBenchmark
+{
+public:
+	EntityBenchmark(const EntityBenchmarkSettings& Settings);
+	~EntityBenchmark();
+
+	bool Run();
+	bool WriteReport(const char* Filename) const;
+
+	const std::string& GetLastError() const { return mLastError; }
+
+private:
+	bool CheckHandles();
+	bool RunComponentCount(uint32_t ComponentCount);
+
+	void AddResult(uint32_t ComponentCount, const char* Mode, double Milliseconds, uint32_t Passes);
+
+private:
+	EntityBenchmarkSettings mSettings;
+	std::vector<EntityBenchmarkResult> mResults;
+	std::string mLastError;
+};
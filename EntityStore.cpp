@@ -0,0 +1,293 @@
+#include "EntityStore.h"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+namespace
+{
+	const uint32_t NoArchetype = 0xFFFFFFFF;
+	const size_t ChunkAlignment = 64;
+
+	struct ComponentTypeInfo
+	{
+		uint32_t Size;
+		uint32_t Alignment;
+	};
+
+	//Ids are handed out on first use of each type, possibly from several threads
+	std::mutex gComponentTypeMutex;
+	ComponentTypeInfo gComponentTypes[MaxComponentTypes];
+	uint32_t gComponentTypeCount = 0;
+
+	uint32_t AlignUp(uint32_t Value, uint32_t Alignment)
+	{
+		return (Value + Alignment - 1) & ~(Alignment - 1);
+	}
+
+	//Column offsets for Capacity rows. Returns the bytes used.
+	uint32_t LayoutChunk(const std::vector<uint32_t>& ComponentIds, uint32_t Capacity, int32_t* OutOffsets)
+	{
+		uint32_t Offset = Capacity * sizeof(EntityHandle);
+		for (uint32_t TypeId : ComponentIds)
+		{
+			Offset = AlignUp(Offset, std::max<uint32_t>(GetComponentTypeAlignment(TypeId), 16));
+			if (OutOffsets)
+			{
+				OutOffsets[TypeId] = static_cast<int32_t>(Offset);
+			}
+			Offset += Capacity * GetComponentTypeSize(TypeId);
+		}
+		return Offset;
+	}
+}
+
+uint32_t RegisterComponentType(uint32_t Size, uint32_t Alignment)
+{
+	std::lock_guard<std::mutex> Lock(gComponentTypeMutex);
+	Check(gComponentTypeCount < MaxComponentTypes);
+	Assert(Alignment <= ChunkAlignment);
+
+	gComponentTypes[gComponentTypeCount].Size = Size;
+	gComponentTypes[gComponentTypeCount].Alignment = Alignment;
+	return gComponentTypeCount++;
+}
+
+uint32_t GetComponentTypeSize(uint32_t TypeId)
+{
+	return gComponentTypes[TypeId].Size;
+}
+
+uint32_t GetComponentTypeAlignment(uint32_t TypeId)
+{
+	return gComponentTypes[TypeId].Alignment;
+}
+
+EntityStore::EntityStore()
+	: mEntityCount(0), mQueryDepth(0)
+{}
+
+EntityStore::~EntityStore()
+{
+	for (const std::unique_ptr<Archetype>& Type : mArchetypes)
+	{
+		for (Chunk& Block : Type->Chunks)
+		{
+			operator delete(Block.Data, std::align_val_t(ChunkAlignment));
+		}
+	}
+}
+
+EntityHandle EntityStore::CreateEntity(ComponentMask Components)
+{
+	Assert(mQueryDepth == 0);
+
+	EntityHandle Entity;
+	if (!mFreeIndices.empty())
+	{
+		Entity.Index = mFreeIndices.back();
+		mFreeIndices.pop_back();
+	}
+	else
+	{
+		Entity.Index = static_cast<uint32_t>(mRecords.size());
+		mRecords.push_back({ 0, NoArchetype, 0, 0 });
+	}
+
+	EntityRecord& Record = mRecords[Entity.Index];
+	Entity.Generation = Record.Generation;
+
+	Record.ArchetypeIndex = FindOrCreateArchetype(Components);
+	AllocateRow(Record.ArchetypeIndex, Entity, Record.ChunkIndex, Record.Row);
+
+	++mEntityCount;
+	return Entity;
+}
+
+void EntityStore::DestroyEntity(EntityHandle Entity)
+{
+	Assert(mQueryDepth == 0);
+	if (!IsAlive(Entity))
+	{
+		return;
+	}
+
+	EntityRecord& Record = mRecords[Entity.Index];
+	FreeRow(Record.ArchetypeIndex, Record.ChunkIndex, Record.Row);
+
+	Record.ArchetypeIndex = NoArchetype;
+	++Record.Generation;
+	mFreeIndices.push_back(Entity.Index);
+	--mEntityCount;
+}
+
+bool EntityStore::IsAlive(EntityHandle Entity) const
+{
+	return Entity.Index < mRecords.size() && mRecords[Entity.Index].Generation == Entity.Generation &&
+		mRecords[Entity.Index].ArchetypeIndex != NoArchetype;
+}
+
+ComponentMask EntityStore::GetComponentMask(EntityHandle Entity) const
+{
+	return IsAlive(Entity) ? mArchetypes[mRecords[Entity.Index].ArchetypeIndex]->Mask : 0;
+}
+
+uint32_t EntityStore::GetChunkCount() const
+{
+	uint32_t Count = 0;
+	for (const std::unique_ptr<Archetype>& Type : mArchetypes)
+	{
+		Count += static_cast<uint32_t>(Type->Chunks.size());
+	}
+	return Count;
+}
+
+uint32_t EntityStore::FindOrCreateArchetype(ComponentMask Mask)
+{
+	auto Existing = mArchetypeLookup.find(Mask);
+	if (Existing != mArchetypeLookup.end())
+	{
+		return Existing->second;
+	}
+
+	std::unique_ptr<Archetype> Type(new Archetype());
+	Type->Mask = Mask;
+	for (uint32_t TypeId = 0; TypeId < MaxComponentTypes; ++TypeId)
+	{
+		Type->ColumnOffsets[TypeId] = -1;
+		if (Mask & (1ull << TypeId))
+		{
+			Type->ComponentIds.push_back(TypeId);
+		}
+	}
+
+	//As many rows as fit once every column is aligned
+	uint32_t RowSize = sizeof(EntityHandle);
+	for (uint32_t TypeId : Type->ComponentIds)
+	{
+		RowSize += GetComponentTypeSize(TypeId);
+	}
+	uint32_t Capacity = ChunkSize / RowSize;
+	while (Capacity > 1 && LayoutChunk(Type->ComponentIds, Capacity, nullptr) > ChunkSize)
+	{
+		--Capacity;
+	}
+	Check(LayoutChunk(Type->ComponentIds, Capacity, Type->ColumnOffsets) <= ChunkSize);
+	Type->Capacity = Capacity;
+
+	uint32_t Index = static_cast<uint32_t>(mArchetypes.size());
+	mArchetypes.push_back(std::move(Type));
+	mArchetypeLookup[Mask] = Index;
+	return Index;
+}
+
+void EntityStore::AllocateRow(uint32_t ArchetypeIndex, EntityHandle Entity, uint32_t& OutChunk, uint32_t& OutRow)
+{
+	Archetype& Type = *mArchetypes[ArchetypeIndex];
+	if (Type.Chunks.empty() || Type.Chunks.back().Count == Type.Capacity)
+	{
+		Chunk Block;
+		Block.Data = static_cast<uint8_t*>(operator new(ChunkSize, std::align_val_t(ChunkAlignment)));
+		Block.Count = 0;
+		Type.Chunks.push_back(Block);
+	}
+
+	Chunk& Block = Type.Chunks.back();
+	OutChunk = static_cast<uint32_t>(Type.Chunks.size() - 1);
+	OutRow = Block.Count++;
+
+	memcpy(Block.Data + OutRow * sizeof(EntityHandle), &Entity, sizeof(Entity));
+	for (uint32_t TypeId : Type.ComponentIds)
+	{
+		uint32_t Size = GetComponentTypeSize(TypeId);
+		memset(Block.Data + Type.ColumnOffsets[TypeId] + OutRow * Size, 0, Size);
+	}
+}
+
+void EntityStore::FreeRow(uint32_t ArchetypeIndex, uint32_t ChunkIndex, uint32_t Row)
+{
+	Archetype& Type = *mArchetypes[ArchetypeIndex];
+	Chunk& Last = Type.Chunks.back();
+	uint32_t LastChunkIndex = static_cast<uint32_t>(Type.Chunks.size() - 1);
+	uint32_t LastRow = Last.Count - 1;
+
+	if (ChunkIndex != LastChunkIndex || Row != LastRow)
+	{
+		Chunk& Block = Type.Chunks[ChunkIndex];
+
+		EntityHandle Moved;
+		memcpy(&Moved, Last.Data + LastRow * sizeof(EntityHandle), sizeof(Moved));
+		memcpy(Block.Data + Row * sizeof(EntityHandle), &Moved, sizeof(Moved));
+		for (uint32_t TypeId : Type.ComponentIds)
+		{
+			uint32_t Size = GetComponentTypeSize(TypeId);
+			uint32_t Offset = Type.ColumnOffsets[TypeId];
+			memcpy(Block.Data + Offset + Row * Size, Last.Data + Offset + LastRow * Size, Size);
+		}
+
+		mRecords[Moved.Index].ChunkIndex = ChunkIndex;
+		mRecords[Moved.Index].Row = Row;
+	}
+
+	if (--Last.Count == 0)
+	{
+		operator delete(Last.Data, std::align_val_t(ChunkAlignment));
+		Type.Chunks.pop_back();
+	}
+}
+
+void EntityStore::ChangeComponents(EntityHandle Entity, ComponentMask NewMask)
+{
+	Assert(mQueryDepth == 0);
+	Assert(IsAlive(Entity));
+
+	EntityRecord& Record = mRecords[Entity.Index];
+	uint32_t OldArchetypeIndex = Record.ArchetypeIndex;
+	if (mArchetypes[OldArchetypeIndex]->Mask == NewMask)
+	{
+		return;
+	}
+
+	uint32_t NewArchetypeIndex = FindOrCreateArchetype(NewMask);
+	uint32_t NewChunk, NewRow;
+	AllocateRow(NewArchetypeIndex, Entity, NewChunk, NewRow);
+
+	//Carry over the components both archetypes have
+	const Archetype& OldType = *mArchetypes[OldArchetypeIndex];
+	const Archetype& NewType = *mArchetypes[NewArchetypeIndex];
+	const uint8_t* OldData = OldType.Chunks[Record.ChunkIndex].Data;
+	uint8_t* NewData = NewType.Chunks[NewChunk].Data;
+	for (uint32_t TypeId : OldType.ComponentIds)
+	{
+		if (NewType.ColumnOffsets[TypeId] >= 0)
+		{
+			uint32_t Size = GetComponentTypeSize(TypeId);
+			memcpy(NewData + NewType.ColumnOffsets[TypeId] + NewRow * Size,
+				OldData + OldType.ColumnOffsets[TypeId] + Record.Row * Size, Size);
+		}
+	}
+
+	FreeRow(OldArchetypeIndex, Record.ChunkIndex, Record.Row);
+
+	Record.ArchetypeIndex = NewArchetypeIndex;
+	Record.ChunkIndex = NewChunk;
+	Record.Row = NewRow;
+}
+
+void* EntityStore::GetComponentData(EntityHandle Entity, uint32_t TypeId) const
+{
+	if (!IsAlive(Entity))
+	{
+		return nullptr;
+	}
+
+	const EntityRecord& Record = mRecords[Entity.Index];
+	const Archetype& Type = *mArchetypes[Record.ArchetypeIndex];
+	int32_t Offset = Type.ColumnOffsets[TypeId];
+	if (Offset < 0)
+	{
+		return nullptr;
+	}
+	return Type.Chunks[Record.ChunkIndex].Data + Offset + Record.Row * GetComponentTypeSize(TypeId);
+}
@@ -0,0 +1,283 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "Common.h"
+#include "JobSystem.h"
+
+//Component types are plain data, identified by a small id so a set of them is
+//a 64 bit mask.
+const uint32_t MaxComponentTypes = 64;
+typedef uint64_t ComponentMask;
+
+uint32_t RegisterComponentType(uint32_t Size, uint32_t Alignment);
+uint32_t GetComponentTypeSize(uint32_t TypeId);
+uint32_t GetComponentTypeAlignment(uint32_t TypeId);
+
+template<typename T>
+uint32_t GetComponentTypeId()
+{
+	static_assert(std::is_trivially_copyable<T>::value, "Components are moved with memcpy");
+	static const uint32_t Id = RegisterComponentType(sizeof(T), alignof(T));
+	return Id;
+}
+
+template<typename... Components>
+ComponentMask MakeComponentMask()
+{
+	ComponentMask Mask = 0;
+	using Expand = int[];
+	(void)Expand{ 0, (Mask |= 1ull << GetComponentTypeId<Components>(), 0)... };
+	return Mask;
+}
+
+//Stable reference to an entity. The generation changes whenever the index is
+//reused, so handles to destroyed entities stay detectably stale.
+struct EntityHandle
+{
+	uint32_t Index;
+	uint32_t Generation;
+
+	bool operator==(const EntityHandle& Other) const { return Index == Other.Index && Generation == Other.Generation; }
+	bool operator!=(const EntityHandle& Other) const { return !(*this == Other); }
+};
+
+const EntityHandle InvalidEntityHandle = { 0xFFFFFFFF, 0 };
+
+class EntityStore;
+
+//One chunk of a query's results: Count entities, each component in its own
+//contiguous array.
+class EntityChunkView
+{
+public:
+	uint32_t GetCount() const { return mCount; }
+	const EntityHandle* GetEntities() const { return reinterpret_cast<const EntityHandle*>(mData); }
+
+	//nullptr if the chunk's archetype doesn't have T.
+	template<typename T>
+	T* Get() const
+	{
+		int32_t Offset = mColumnOffsets[GetComponentTypeId<T>()];
+		return Offset >= 0 ? reinterpret_cast<T*>(mData + Offset) : nullptr;
+	}
+
+	//Untyped, for code that picks components at runtime.
+	void* GetColumn(uint32_t TypeId) const
+	{
+		return mColumnOffsets[TypeId] >= 0 ? mData + mColumnOffsets[TypeId] : nullptr;
+	}
+
+private:
+	friend class EntityStore;
+
+	uint8_t* mData;
+	uint32_t mCount;
+	const int32_t* mColumnOffsets;
+};
+
+//Archetype based entity component storage.
+//
+//Entities with the same set of components share an archetype, which keeps
+//them in fixed size chunks. Inside a chunk every component is its own array
+//(structure of arrays) and rows are kept dense - destroying an entity moves
+//the archetype's last entity in to its place - so a query walks contiguous
+//memory and touches only the components it asks for. Adding or removing a
+//component moves the entity to another archetype.
+//
+//Structural changes (create, destroy, add/remove component) are not allowed
+//while a query is running. Main thread only, apart from the bodies of
+//ParallelForEach/ParallelForEachChunk, which may write to the components of
+//the chunk they're given.
+class EntityStore
+{
+public:
+	static const uint32_t ChunkSize = 16 * 1024;
+
+	EntityStore();
+	~EntityStore();
+
+	//Components start zeroed.
+	EntityHandle CreateEntity(ComponentMask Components);
+
+	template<typename... Components>
+	EntityHandle CreateEntity(const Components&... Values)
+	{
+		EntityHandle Entity = CreateEntity(MakeComponentMask<Components...>());
+		using Expand = int[];
+		(void)Expand{ 0, (*GetComponent<Components>(Entity) = Values, 0)... };
+		return Entity;
+	}
+
+	void DestroyEntity(EntityHandle Entity);
+	bool IsAlive(EntityHandle Entity) const;
+
+	ComponentMask GetComponentMask(EntityHandle Entity) const;
+
+	//nullptr if the entity is dead or doesn't have T. Valid until the next
+	//structural change.
+	template<typename T>
+	T* GetComponent(EntityHandle Entity) const
+	{
+		return static_cast<T*>(GetComponentData(Entity, GetComponentTypeId<T>()));
+	}
+
+	template<typename T>
+	T* AddComponent(EntityHandle Entity, const T& Value = T())
+	{
+		ChangeComponents(Entity, GetComponentMask(Entity) | (1ull << GetComponentTypeId<T>()));
+		T* Component = GetComponent<T>(Entity);
+		*Component = Value;
+		return Component;
+	}
+
+	template<typename T>
+	void RemoveComponent(EntityHandle Entity)
+	{
+		ChangeComponents(Entity, GetComponentMask(Entity) & ~(1ull << GetComponentTypeId<T>()));
+	}
+
+	//Every chunk with all of Required and none of Excluded.
+	template<typename Function>
+	void ForEachChunk(ComponentMask Required, ComponentMask Excluded, Function&& Body) const
+	{
+		++mQueryDepth;
+		for (const std::unique_ptr<Archetype>& Type : mArchetypes)
+		{
+			if (!Matches(*Type, Required, Excluded))
+			{
+				continue;
+			}
+			for (Chunk& Block : Type->Chunks)
+			{
+				Body(MakeChunkView(*Type, Block));
+			}
+		}
+		--mQueryDepth;
+	}
+
+	//Chunks are split across the job system's workers (and this thread).
+	template<typename Function>
+	void ParallelForEachChunk(JobSystem& Jobs, ComponentMask Required, ComponentMask Excluded, Function&& Body)
+	{
+		++mQueryDepth;
+		std::vector<EntityChunkView> Views;
+		for (const std::unique_ptr<Archetype>& Type : mArchetypes)
+		{
+			if (Matches(*Type, Required, Excluded))
+			{
+				for (Chunk& Block : Type->Chunks)
+				{
+					Views.push_back(MakeChunkView(*Type, Block));
+				}
+			}
+		}
+
+		Jobs.ParallelFor(static_cast<uint32_t>(Views.size()), 1, [&Views, &Body](uint32_t Begin, uint32_t End)
+		{
+			for (uint32_t i = Begin; i < End; ++i)
+			{
+				Body(Views[i]);
+			}
+		});
+		--mQueryDepth;
+	}
+
+	//Body(Components&...) for every entity with all of Components.
+	template<typename... Components, typename Function>
+	void ForEach(Function&& Body) const
+	{
+		ForEachChunk(MakeComponentMask<Components...>(), 0, [&Body](const EntityChunkView& View)
+		{
+			RunRows(View.GetCount(), Body, View.Get<Components>()...);
+		});
+	}
+
+	template<typename... Components, typename Function>
+	void ParallelForEach(JobSystem& Jobs, Function&& Body)
+	{
+		ParallelForEachChunk(Jobs, MakeComponentMask<Components...>(), 0, [&Body](const EntityChunkView& View)
+		{
+			RunRows(View.GetCount(), Body, View.Get<Components>()...);
+		});
+	}
+
+	uint32_t GetEntityCount() const { return mEntityCount; }
+	uint32_t GetArchetypeCount() const { return static_cast<uint32_t>(mArchetypes.size()); }
+	uint32_t GetChunkCount() const;
+
+private:
+	struct Chunk
+	{
+		uint8_t* Data;
+		uint32_t Count;
+	};
+
+	struct Archetype
+	{
+		ComponentMask Mask;
+		uint32_t Capacity;					//Rows per chunk
+		int32_t ColumnOffsets[MaxComponentTypes];	//Within a chunk, -1 if absent
+		std::vector<uint32_t> ComponentIds;
+		std::vector<Chunk> Chunks;			//All full apart from the last
+	};
+
+	struct EntityRecord
+	{
+		uint32_t Generation;
+		uint32_t ArchetypeIndex;
+		uint32_t ChunkIndex;
+		uint32_t Row;
+	};
+
+	EntityStore(const EntityStore&) = delete;
+	EntityStore& operator=(const EntityStore&) = delete;
+
+	static bool Matches(const Archetype& Type, ComponentMask Required, ComponentMask Excluded)
+	{
+		return (Type.Mask & Required) == Required && (Type.Mask & Excluded) == 0;
+	}
+
+	static EntityChunkView MakeChunkView(const Archetype& Type, const Chunk& Block)
+	{
+		EntityChunkView View;
+		View.mData = Block.Data;
+		View.mCount = Block.Count;
+		View.mColumnOffsets = Type.ColumnOffsets;
+		return View;
+	}
+
+	template<typename Function, typename... Columns>
+	static void RunRows(uint32_t Count, Function& Body, Columns*... Arrays)
+	{
+		for (uint32_t Row = 0; Row < Count; ++Row)
+		{
+			Body(Arrays[Row]...);
+		}
+	}
+
+	uint32_t FindOrCreateArchetype(ComponentMask Mask);
+
+	//Appends a zeroed row to the archetype, returns its chunk and row.
+	void AllocateRow(uint32_t ArchetypeIndex, EntityHandle Entity, uint32_t& OutChunk, uint32_t& OutRow);
+
+	//Fills the hole at (ChunkIndex, Row) with the archetype's last row.
+	void FreeRow(uint32_t ArchetypeIndex, uint32_t ChunkIndex, uint32_t Row);
+
+	void ChangeComponents(EntityHandle Entity, ComponentMask NewMask);
+	void* GetComponentData(EntityHandle Entity, uint32_t TypeId) const;
+
+private:
+	std::vector<std::unique_ptr<Archetype>> mArchetypes;
+	std::unordered_map<ComponentMask, uint32_t> mArchetypeLookup;
+
+	std::vector<EntityRecord> mRecords;
+	std::vector<uint32_t> mFreeIndices;
+	uint32_t mEntityCount;
+
+	mutable uint32_t mQueryDepth;
+};
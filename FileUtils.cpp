@@ -0,0 +1,211 @@
+#include "FileUtils.h"
+
+#include <algorithm>
+#include <cctype>
+#include <stdio.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <errno.h>
+#include <sys/stat.h>
+#endif
+
+bool ReadWholeFile(const std::string& Path, std::vector<uint8_t>& OutData)
+{
+	FILE* File = fopen(Path.c_str(), "rb");
+	if (!File)
+	{
+		return false;
+	}
+
+	fseek(File, 0, SEEK_END);
+	long Size = ftell(File);
+	fseek(File, 0, SEEK_SET);
+
+	OutData.resize(Size > 0 ? static_cast<size_t>(Size) : 0);
+	bool bRead = OutData.empty() || fread(OutData.data(), 1, OutData.size(), File) == OutData.size();
+	fclose(File);
+	return bRead;
+}
+
+bool WriteWholeFile(const std::string& Path, const void* Data, size_t Size)
+{
+	FILE* File = fopen(Path.c_str(), "wb");
+	if (!File)
+	{
+		return false;
+	}
+
+	bool bWritten = Size == 0 || fwrite(Data, 1, Size, File) == Size;
+	bWritten &= fclose(File) == 0;
+	return bWritten;
+}
+
+bool FileExists(const std::string& Path)
+{
+#if defined(_WIN32)
+	DWORD Attributes = GetFileAttributesA(Path.c_str());
+	return Attributes != INVALID_FILE_ATTRIBUTES && !(Attributes & FILE_ATTRIBUTE_DIRECTORY);
+#else
+	struct stat FileStat;
+	return stat(Path.c_str(), &FileStat) == 0 && S_ISREG(FileStat.st_mode);
+#endif
+}
+
+bool CreateDirectories(const std::string& Path)
+{
+	if (Path.empty())
+	{
+		return true;
+	}
+
+	size_t Separator = 0;
+	do
+	{
+		Separator = Path.find_first_of("/\\", Separator + 1);
+		std::string Partial = Path.substr(0, Separator);
+		if (Partial.empty() || Partial.back() == ':')
+		{
+			continue;
+		}
+
+#if defined(_WIN32)
+		if (!CreateDirectoryA(Partial.c_str(), nullptr) && GetLastError() != ERROR_ALREADY_EXISTS)
+		{
+			return false;
+		}
+#else
+		if (mkdir(Partial.c_str(), 0755) != 0 && errno != EEXIST)
+		{
+			return false;
+		}
+#endif
+	} while (Separator != std::string::npos);
+
+	return true;
+}
+
+namespace
+{
+	void ListFilesRecursiveImpl(const std::string& Root, const std::string& Relative, std::vector<std::string>& Out)
+	{
+		std::string Directory = Relative.empty() ? Root : JoinPath(Root, Relative);
+
+#if defined(_WIN32)
+		WIN32_FIND_DATAA FindData;
+		HANDLE Find = FindFirstFileA(JoinPath(Directory, "*").c_str(), &FindData);
+		if (Find == INVALID_HANDLE_VALUE)
+		{
+			return;
+		}
+
+		do
+		{
+			std::string Name = FindData.cFileName;
+			if (Name == "." || Name == "..")
+			{
+				continue;
+			}
+
+			std::string Child = Relative.empty() ? Name : JoinPath(Relative, Name);
+			if (FindData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+			{
+				ListFilesRecursiveImpl(Root, Child, Out);
+			}
+			else
+			{
+				Out.push_back(Child);
+			}
+		} while (FindNextFileA(Find, &FindData));
+
+		FindClose(Find);
+#else
+		DIR* Dir = opendir(Directory.c_str());
+		if (!Dir)
+		{
+			return;
+		}
+
+		while (dirent* Entry = readdir(Dir))
+		{
+			std::string Name = Entry->d_name;
+			if (Name == "." || Name == "..")
+			{
+				continue;
+			}
+
+			std::string Child = Relative.empty() ? Name : JoinPath(Relative, Name);
+			struct stat FileStat;
+			if (stat(JoinPath(Root, Child).c_str(), &FileStat) != 0)
+			{
+				continue;
+			}
+
+			if (S_ISDIR(FileStat.st_mode))
+			{
+				ListFilesRecursiveImpl(Root, Child, Out);
+			}
+			else if (S_ISREG(FileStat.st_mode))
+			{
+				Out.push_back(Child);
+			}
+		}
+
+		closedir(Dir);
+#endif
+	}
+}
+
+void ListFilesRecursive(const std::string& Root, std::vector<std::string>& OutRelativePaths)
+{
+	OutRelativePaths.clear();
+	ListFilesRecursiveImpl(Root, "", OutRelativePaths);
+	std::sort(OutRelativePaths.begin(), OutRelativePaths.end());
+}
+
+std::string GetDirectory(const std::string& Path)
+{
+	size_t Separator = Path.find_last_of("/\\");
+	return Separator == std::string::npos ? std::string() : Path.substr(0, Separator);
+}
+
+std::string GetExtension(const std::string& Path)
+{
+	size_t Dot = Path.find_last_of('.');
+	size_t Separator = Path.find_last_of("/\\");
+	if (Dot == std::string::npos || (Separator != std::string::npos && Dot < Separator))
+	{
+		return std::string();
+	}
+
+	std::string Extension = Path.substr(Dot);
+	std::transform(Extension.begin(), Extension.end(), Extension.begin(),
+		[](char C) { return static_cast<char>(tolower(static_cast<unsigned char>(C))); });
+	return Extension;
+}
+
+std::string ReplaceExtension(const std::string& Path, const std::string& Extension)
+{
+	size_t Dot = Path.find_last_of('.');
+	size_t Separator = Path.find_last_of("/\\");
+	if (Dot == std::string::npos || (Separator != std::string::npos && Dot < Separator))
+	{
+		return Path + Extension;
+	}
+	return Path.substr(0, Dot) + Extension;
+}
+
+std::string JoinPath(const std::string& A, const std::string& B)
+{
+	if (A.empty())
+	{
+		return B;
+	}
+	if (A.back() == '/' || A.back() == '\\')
+	{
+		return A + B;
+	}
+	return A + "/" + B;
+}
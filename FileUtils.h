@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//Small portable file system helpers for the offline tools. Paths use '/'
+//separators (Windows accepts them too).
+
+bool ReadWholeFile(const std::string& Path, std::vector<uint8_t>& OutData);
+bool WriteWholeFile(const std::string& Path, const void* Data, size_t Size);
+bool FileExists(const std::string& Path);
+
+//Creates every missing directory along Path.
+bool CreateDirectories(const std::string& Path);
+
+//Every file below Root, relative to it, sorted.
+void ListFilesRecursive(const std::string& Root, std::vector<std::string>& OutRelativePaths);
+
+std::string GetDirectory(const std::string& Path);	//"a/b/c.txt" -> "a/b"
+std::string GetExtension(const std::string& Path);	//"a/b/c.txt" -> ".txt", lower case
+std::string ReplaceExtension(const std::string& Path, const std::string& Extension);
+std::string JoinPath(const std::string& A, const std::string& B);
@@ -0,0 +1,335 @@
+#include "FrameCapture.h"
+#include "Common.h"
+#include "FileUtils.h"
+#include "JobSystem.h"
+#include "RenderCommandStream.h"
+
+#include <stdio.h>
+#include <string.h>
+
+namespace
+{
+	uint64_t AlignSection(uint64_t Offset)
+	{
+		return (Offset + FrameCaptureSectionAlignment - 1) & ~static_cast<uint64_t>(FrameCaptureSectionAlignment - 1);
+	}
+
+	//Offset + Size <= Limit without overflowing
+	bool RangeInside(uint64_t Offset, uint64_t Size, uint64_t Limit)
+	{
+		return Offset <= Limit && Size <= Limit - Offset;
+	}
+
+	//Data then zeros up to Offset
+	bool WriteSection(FILE* File, uint64_t& Written, uint64_t Offset, const void* Data, uint64_t Size)
+	{
+		static const uint8_t Zeros[FrameCaptureSectionAlignment] = {};
+		Assert(Offset >= Written && Offset - Written < FrameCaptureSectionAlignment);
+		if (Offset > Written && fwrite(Zeros, 1, static_cast<size_t>(Offset - Written), File) != Offset - Written)
+		{
+			return false;
+		}
+		Written = Offset + Size;
+		return Size == 0 || fwrite(Data, 1, static_cast<size_t>(Size), File) == Size;
+	}
+}
+
+FrameCaptureWriter::FrameCaptureWriter()
+	: mUploadDataSize(0)
+{
+	Clear();
+}
+
+FrameCaptureWriter::~FrameCaptureWriter()
+{}
+
+void FrameCaptureWriter::Clear()
+{
+	mResources.clear();
+	mPasses.clear();
+	mUploads.clear();
+	mCommands.clear();
+	mStrings.assign(1, '\0');
+	mUploadDataSize = 0;
+	mUploadSources.clear();
+}
+
+uint32_t FrameCaptureWriter::AddString(const char* String)
+{
+	if (!String || !String[0])
+	{
+		return 0;
+	}
+	uint32_t Offset = static_cast<uint32_t>(mStrings.size());
+	mStrings.insert(mStrings.end(), String, String + strlen(String) + 1);
+	return Offset;
+}
+
+uint32_t FrameCaptureWriter::AddResource(const FrameCaptureResource& Resource, const char* Name)
+{
+	mResources.push_back(Resource);
+	mResources.back().NameOffset = AddString(Name);
+	return static_cast<uint32_t>(mResources.size() - 1);
+}
+
+void FrameCaptureWriter::AddPass(const char* Name, const RenderCommandStream& Stream)
+{
+	FrameCapturePass Pass = {};
+	Pass.CommandOffset = mCommands.size();
+	Pass.CommandSize = Stream.GetByteSize();
+	Pass.CommandCount = Stream.GetCommandCount();
+	Pass.NameOffset = AddString(Name);
+	mPasses.push_back(Pass);
+
+	mCommands.resize(static_cast<size_t>(Pass.CommandOffset + Pass.CommandSize));
+	Stream.CopyBytes(mCommands.data() + Pass.CommandOffset);
+}
+
+void FrameCaptureWriter::AddUpload(uint32_t Resource, uint64_t ResourceOffset, const void* Data, uint64_t Size)
+{
+	Assert(Resource < mResources.size() && mResources[Resource].Dimension == FrameCaptureDimension::Buffer);
+
+	FrameCaptureUpload Upload = {};
+	Upload.Resource = Resource;
+	Upload.ResourceOffset = ResourceOffset;
+	Upload.DataOffset = mUploadDataSize;
+	Upload.Size = Size;
+	mUploads.push_back(Upload);
+	mUploadDataSize += Size;
+
+	mUploadSources.push_back(static_cast<const uint8_t*>(Data));
+}
+
+void FrameCaptureWriter::CopyUploads(JobSystem* Jobs)
+{
+	if (mUploadData.size() < mUploadDataSize)
+	{
+		mUploadData.resize(static_cast<size_t>(mUploadDataSize));
+	}
+
+	//Uploads added since the last copy are the last ones
+	const uint32_t First = static_cast<uint32_t>(mUploads.size() - mUploadSources.size());
+	auto Copy = [this, First](uint32_t Begin, uint32_t End)
+	{
+		for (uint32_t i = Begin; i < End; ++i)
+		{
+			const FrameCaptureUpload& Upload = mUploads[First + i];
+			memcpy(mUploadData.data() + Upload.DataOffset, mUploadSources[i], static_cast<size_t>(Upload.Size));
+		}
+	};
+
+	const uint32_t Count = static_cast<uint32_t>(mUploadSources.size());
+	if (Jobs)
+	{
+		Jobs->ParallelFor(Count, 4, Copy);
+	}
+	else
+	{
+		Copy(0, Count);
+	}
+	mUploadSources.clear();
+}
+
+bool FrameCaptureWriter::Write(const char* Filename) const
+{
+	Assert(mUploadSources.empty());
+
+	FrameCaptureHeader Header = {};
+	Header.Magic = FrameCaptureMagic;
+	Header.Version = FrameCaptureVersion;
+	Header.ResourceCount = static_cast<uint32_t>(mResources.size());
+	Header.PassCount = static_cast<uint32_t>(mPasses.size());
+	Header.UploadCount = static_cast<uint32_t>(mUploads.size());
+
+	Header.ResourceTableOffset = AlignSection(sizeof(Header));
+	Header.PassTableOffset = AlignSection(Header.ResourceTableOffset + mResources.size() * sizeof(FrameCaptureResource));
+	Header.UploadTableOffset = AlignSection(Header.PassTableOffset + mPasses.size() * sizeof(FrameCapturePass));
+	uint64_t CommandOffset = AlignSection(Header.UploadTableOffset + mUploads.size() * sizeof(FrameCaptureUpload));
+	uint64_t UploadDataOffset = AlignSection(CommandOffset + mCommands.size());
+	Header.StringTableOffset = AlignSection(UploadDataOffset + mUploadDataSize);
+	Header.StringTableSize = mStrings.size();
+	Header.FileSize = Header.StringTableOffset + Header.StringTableSize;
+
+	//Offsets from the start of the file
+	std::vector<FrameCapturePass> Passes = mPasses;
+	for (FrameCapturePass& Pass : Passes)
+	{
+		Pass.CommandOffset += CommandOffset;
+	}
+	std::vector<FrameCaptureUpload> Uploads = mUploads;
+	for (FrameCaptureUpload& Upload : Uploads)
+	{
+		Upload.DataOffset += UploadDataOffset;
+	}
+
+	FILE* File = fopen(Filename, "wb");
+	if (!File)
+	{
+		return false;
+	}
+
+	uint64_t Written = 0;
+	bool bWritten = WriteSection(File, Written, 0, &Header, sizeof(Header)) &&
+		WriteSection(File, Written, Header.ResourceTableOffset, mResources.data(), mResources.size() * sizeof(FrameCaptureResource)) &&
+		WriteSection(File, Written, Header.PassTableOffset, Passes.data(), Passes.size() * sizeof(FrameCapturePass)) &&
+		WriteSection(File, Written, Header.UploadTableOffset, Uploads.data(), Uploads.size() * sizeof(FrameCaptureUpload)) &&
+		WriteSection(File, Written, CommandOffset, mCommands.data(), mCommands.size()) &&
+		WriteSection(File, Written, UploadDataOffset, mUploadData.data(), mUploadDataSize) &&
+		WriteSection(File, Written, Header.StringTableOffset, mStrings.data(), mStrings.size());
+
+	bWritten = fclose(File) == 0 && bWritten;
+	return bWritten;
+}
+
+FrameCapture::FrameCapture()
+	: mHeader(nullptr), mResources(nullptr), mPasses(nullptr), mUploads(nullptr), mStrings(nullptr)
+{}
+
+FrameCapture::~FrameCapture()
+{}
+
+bool FrameCapture::Load(const char* Filename)
+{
+	Unload();
+	if (!ReadWholeFile(Filename, mData))
+	{
+		mLastError = std::string("Can't read ") + Filename;
+		return false;
+	}
+
+	uint64_t Size = mData.size();
+	mData.resize(mData.size() + RenderCommandStream::MaxCommandSize, 0);
+	if (!Validate(Size))
+	{
+		Unload();
+		mLastError = std::string(Filename) + " isn't a valid frame capture";
+		return false;
+	}
+	return true;
+}
+
+bool FrameCapture::LoadFromMemory(const void* Data, uint64_t Size)
+{
+	Unload();
+	const uint8_t* Bytes = static_cast<const uint8_t*>(Data);
+	mData.assign(Bytes, Bytes + Size);
+	mData.resize(mData.size() + RenderCommandStream::MaxCommandSize, 0);
+	if (!Validate(Size))
+	{
+		Unload();
+		mLastError = "Not a valid frame capture";
+		return false;
+	}
+	return true;
+}
+
+void FrameCapture::Unload()
+{
+	mHeader = nullptr;
+	mResources = nullptr;
+	mPasses = nullptr;
+	mUploads = nullptr;
+	mStrings = nullptr;
+	mData = std::vector<uint8_t>();
+	mLastError.clear();
+}
+
+bool FrameCapture::Validate(uint64_t Size)
+{
+	const uint8_t* Data = mData.data();
+	if (Size < sizeof(FrameCaptureHeader) || reinterpret_cast<uintptr_t>(Data) % alignof(uint64_t) != 0)
+	{
+		return false;
+	}
+
+	const FrameCaptureHeader* Header = reinterpret_cast<const FrameCaptureHeader*>(Data);
+	if (Header->Magic != FrameCaptureMagic || Header->Version != FrameCaptureVersion || Header->FileSize > Size)
+	{
+		return false;
+	}
+
+	uint64_t FileSize = Header->FileSize;
+	const uint64_t Offsets[] = { Header->ResourceTableOffset, Header->PassTableOffset, Header->UploadTableOffset, Header->StringTableOffset };
+	for (uint64_t Offset : Offsets)
+	{
+		if (Offset % FrameCaptureSectionAlignment != 0)
+		{
+			return false;
+		}
+	}
+
+	if (!RangeInside(Header->ResourceTableOffset, static_cast<uint64_t>(Header->ResourceCount) * sizeof(FrameCaptureResource), FileSize) ||
+		!RangeInside(Header->PassTableOffset, static_cast<uint64_t>(Header->PassCount) * sizeof(FrameCapturePass), FileSize) ||
+		!RangeInside(Header->UploadTableOffset, static_cast<uint64_t>(Header->UploadCount) * sizeof(FrameCaptureUpload), FileSize) ||
+		!RangeInside(Header->StringTableOffset, Header->StringTableSize, FileSize))
+	{
+		return false;
+	}
+
+	const char* Strings = reinterpret_cast<const char*>(Data + Header->StringTableOffset);
+	if (Header->StringTableSize == 0 || Strings[Header->StringTableSize - 1] != '\0')
+	{
+		return false;
+	}
+
+	const FrameCaptureResource* Resources = reinterpret_cast<const FrameCaptureResource*>(Data + Header->ResourceTableOffset);
+	for (uint32_t i = 0; i < Header->ResourceCount; ++i)
+	{
+		const FrameCaptureResource& Resource = Resources[i];
+		if ((Resource.Dimension != FrameCaptureDimension::Buffer && Resource.Dimension != FrameCaptureDimension::Texture2D) ||
+			Resource.InitialState >= RenderResourceState::Count || Resource.NameOffset >= Header->StringTableSize)
+		{
+			return false;
+		}
+	}
+
+	const FrameCapturePass* Passes = reinterpret_cast<const FrameCapturePass*>(Data + Header->PassTableOffset);
+	for (uint32_t i = 0; i < Header->PassCount; ++i)
+	{
+		if (!RangeInside(Passes[i].CommandOffset, Passes[i].CommandSize, FileSize) || Passes[i].NameOffset >= Header->StringTableSize)
+		{
+			return false;
+		}
+	}
+
+	const FrameCaptureUpload* Uploads = reinterpret_cast<const FrameCaptureUpload*>(Data + Header->UploadTableOffset);
+	for (uint32_t i = 0; i < Header->UploadCount; ++i)
+	{
+		const FrameCaptureUpload& Upload = Uploads[i];
+		if (Upload.Resource >= Header->ResourceCount || Resources[Upload.Resource].Dimension != FrameCaptureDimension::Buffer ||
+			!RangeInside(Upload.ResourceOffset, Upload.Size, Resources[Upload.Resource].Width) ||
+			!RangeInside(Upload.DataOffset, Upload.Size, FileSize))
+		{
+			return false;
+		}
+	}
+
+	mHeader = Header;
+	mResources = Resources;
+	mPasses = Passes;
+	mUploads = Uploads;
+	mStrings = Strings;
+	return true;
+}
+
+void FrameCapture::ReplayPass(uint32_t Pass, IRenderCommandList& Target) const
+{
+	Assert(Pass < mHeader->PassCount);
+	RenderCommandStream::Replay(mData.data() + mPasses[Pass].CommandOffset, mPasses[Pass].CommandSize, Target);
+}
+
+bool FrameCapture::FindBuffer(uint64_t GpuAddress, uint32_t& OutResource, uint64_t& OutOffset) const
+{
+	for (uint32_t i = 0; i < mHeader->ResourceCount; ++i)
+	{
+		const FrameCaptureResource& Resource = mResources[i];
+		if (Resource.Dimension == FrameCaptureDimension::Buffer && Resource.GpuAddress != 0 &&
+			GpuAddress >= Resource.GpuAddress && GpuAddress - Resource.GpuAddress < Resource.Width)
+		{
+			OutResource = i;
+			OutOffset = GpuAddress - Resource.GpuAddress;
+			return true;
+		}
+	}
+	return false;
+}
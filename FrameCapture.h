@@ -0,0 +1,199 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "RenderCommandList.h"
+
+class JobSystem;
+class RenderCommandStream;
+
+//One frame's commands, with what's needed to replay them: descriptions of
+//the resources they use and the contents uploaded to those at the start of
+//the frame. Replaying on a null backend times the CPU side alone; replaying
+//on a device (D3D12FrameReplay) times both, frame after frame, on the same
+//input.
+//
+//File layout (every section 16 byte aligned):
+//	FrameCaptureHeader
+//	FrameCaptureResource[ResourceCount]
+//	FrameCapturePass[PassCount]
+//	FrameCaptureUpload[UploadCount]
+//	Command data		- each pass's RenderCommandStream bytes
+//	Upload data
+//	String table		- null terminated names, starts with "" at offset 0
+//
+//Commands use the renderer's resource ids, which index the resource table.
+//GPU addresses and render target handles are the ones the frame was
+//recorded with; each resource keeps its own so a replay can remap them.
+
+const uint32_t FrameCaptureMagic = 0x50414346;		//"FCAP"
+const uint32_t FrameCaptureVersion = 1;
+const uint32_t FrameCaptureSectionAlignment = 16;
+
+enum class FrameCaptureDimension : uint32_t
+{
+	Buffer,
+	Texture2D
+};
+
+enum FrameCaptureResourceFlags
+{
+	FrameCaptureResource_RenderTarget = 1 << 0,
+	FrameCaptureResource_DepthStencil = 1 << 1
+};
+
+struct FrameCaptureResource
+{
+	FrameCaptureDimension Dimension;
+	uint32_t Format;				//DXGI_FORMAT of textures
+	uint64_t Width;					//In bytes for buffers
+	uint32_t Height;
+	uint16_t ArraySize;
+	uint16_t MipLevels;
+	uint32_t Flags;					//FrameCaptureResourceFlags
+	RenderResourceState InitialState;
+	uint8_t Padding[3];
+	uint64_t GpuAddress;			//Of buffers when captured
+	uint64_t Descriptor;			//Render target or depth stencil view when captured
+	uint32_t NameOffset;
+	uint32_t Padding2;
+};
+
+struct FrameCapturePass
+{
+	uint64_t CommandOffset;			//From the start of the file
+	uint64_t CommandSize;
+	uint32_t CommandCount;
+	uint32_t NameOffset;
+};
+
+//Bytes written in to a buffer before the first pass
+struct FrameCaptureUpload
+{
+	uint32_t Resource;
+	uint32_t Padding;
+	uint64_t ResourceOffset;
+	uint64_t DataOffset;			//From the start of the file
+	uint64_t Size;
+};
+
+struct FrameCaptureHeader
+{
+	uint32_t Magic;
+	uint32_t Version;
+	uint32_t ResourceCount;
+	uint32_t PassCount;
+
+	uint32_t UploadCount;
+	uint32_t Padding[3];
+
+	uint64_t ResourceTableOffset;
+	uint64_t PassTableOffset;
+	uint64_t UploadTableOffset;
+	uint64_t StringTableOffset;
+	uint64_t StringTableSize;
+	uint64_t FileSize;
+};
+
+//Collects a frame while it's recorded. Streams are copied as they're added,
+//so the renderer can reuse them straight away. Upload contents - most of a
+//frame's bytes - are only copied by CopyUploads(), which can be split across
+//worker threads off the render thread, but must finish before the upload
+//memory is reused (before UploadRing retires the frame). The copies keep
+//their memory from frame to frame, so a warm writer allocates nothing.
+//Write() does all the file IO and can run on any thread once the frame is
+//complete.
+class FrameCaptureWriter
+{
+public:
+	FrameCaptureWriter();
+	~FrameCaptureWriter();
+
+	//Forgets the last frame
+	void Clear();
+
+	//Returns the resource's id; commands must use the same ids
+	uint32_t AddResource(const FrameCaptureResource& Resource, const char* Name);
+
+	void AddPass(const char* Name, const RenderCommandStream& Stream);
+
+	//Data must stay unchanged until CopyUploads()
+	void AddUpload(uint32_t Resource, uint64_t ResourceOffset, const void* Data, uint64_t Size);
+	void CopyUploads(JobSystem* Jobs = nullptr);
+
+	//Uploads must have been copied
+	bool Write(const char* Filename) const;
+
+	//Commands and upload contents held
+	uint64_t GetCapturedBytes() const { return mCommands.size() + mUploadDataSize; }
+
+private:
+	uint32_t AddString(const char* String);
+
+private:
+	//Offsets here are in to mCommands and mUploadData until written
+	std::vector<FrameCaptureResource> mResources;
+	std::vector<FrameCapturePass> mPasses;
+	std::vector<FrameCaptureUpload> mUploads;
+	std::vector<uint8_t> mCommands;
+	std::vector<char> mStrings;
+
+	//Only grows, so copying in to it never has to clear it first
+	std::vector<uint8_t> mUploadData;
+	uint64_t mUploadDataSize;
+
+	//Where each upload not yet copied is read from
+	std::vector<const uint8_t*> mUploadSources;
+};
+
+//A loaded capture. The file is read in to memory whole.
+class FrameCapture
+{
+public:
+	FrameCapture();
+	~FrameCapture();
+
+	bool Load(const char* Filename);
+	bool LoadFromMemory(const void* Data, uint64_t Size);
+	void Unload();
+
+	bool IsLoaded() const { return mHeader != nullptr; }
+	const std::string& GetLastError() const { return mLastError; }
+
+	uint32_t GetResourceCount() const { return mHeader->ResourceCount; }
+	uint32_t GetPassCount() const { return mHeader->PassCount; }
+	uint32_t GetUploadCount() const { return mHeader->UploadCount; }
+
+	const FrameCaptureResource& GetResource(uint32_t Idx) const { return mResources[Idx]; }
+	const FrameCapturePass& GetPass(uint32_t Idx) const { return mPasses[Idx]; }
+	const FrameCaptureUpload& GetUpload(uint32_t Idx) const { return mUploads[Idx]; }
+
+	const char* GetString(uint32_t Offset) const { return mStrings + Offset; }
+	const uint8_t* GetUploadData(uint32_t Idx) const { return mData.data() + mUploads[Idx].DataOffset; }
+
+	void ReplayPass(uint32_t Pass, IRenderCommandList& Target) const;
+
+	//The buffer whose captured GPU address range holds GpuAddress, and the
+	//offset in to it. False if there's none.
+	bool FindBuffer(uint64_t GpuAddress, uint32_t& OutResource, uint64_t& OutOffset) const;
+
+private:
+	FrameCapture(const FrameCapture&) = delete;
+	FrameCapture& operator=(const FrameCapture&) = delete;
+
+	bool Validate(uint64_t Size);
+
+private:
+	//Padded past the file's end so malformed commands can't read outside it
+	std::vector<uint8_t> mData;
+
+	const FrameCaptureHeader* mHeader;
+	const FrameCaptureResource* mResources;
+	const FrameCapturePass* mPasses;
+	const FrameCaptureUpload* mUploads;
+	const char* mStrings;
+
+	std::string mLastError;
+};
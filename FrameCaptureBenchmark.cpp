@@ -0,0 +1,579 @@
+#include "FrameCaptureBenchmark.h"
+#include "Common.h"
+#include "FrameCapture.h"
+#include "JobSystem.h"
+#include "NullRenderCommandList.h"
+#include "RenderCommandStream.h"
+#include "StandInCommandList.h"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+
+namespace
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	double MillisecondsSince(Clock::time_point Start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - Start).count();
+	}
+
+	const uint32_t InstanceDataRootParameter = 0;
+	const uint32_t MaterialRootParameter = 1;
+	const uint32_t RootSignatureCount = 8;
+
+	const uint64_t UploadRingAddress = 0x100000000ull;
+	const uint64_t FirstBufferAddress = 0x200000000ull;
+	const uint64_t FirstRenderTargetHandle = 0x10000;
+	const uint64_t DepthStencilHandle = 0x80000;
+	const uint32_t RenderTargetFormat = 28;		//DXGI_FORMAT_R8G8B8A8_UNORM
+	const uint32_t DepthStencilFormat = 40;		//DXGI_FORMAT_D32_FLOAT
+
+	struct CapturedUpload
+	{
+		uint32_t Resource;
+		uint64_t ResourceOffset;
+		uint64_t RingOffset;
+		uint64_t Size;
+	};
+
+	//What the renderer has at the end of a frame: its resources, the upload
+	//ring's contents and a stream for the uploads and each pass
+	struct Frame
+	{
+		std::vector<FrameCaptureResource> Resources;
+		std::vector<std::string> ResourceNames;
+		std::vector<uint8_t> UploadRing;
+		std::vector<CapturedUpload> Uploads;
+		std::vector<std::unique_ptr<RenderCommandStream>> Streams;
+		std::vector<std::string> StreamNames;
+	};
+
+	uint32_t AddResource(Frame& Target, FrameCaptureDimension Dimension, uint64_t Width, RenderResourceState State, const char* Name)
+	{
+		FrameCaptureResource Resource = {};
+		Resource.Dimension = Dimension;
+		Resource.Width = Width;
+		Resource.Height = 1;
+		Resource.ArraySize = 1;
+		Resource.MipLevels = 1;
+		Resource.InitialState = State;
+		Target.Resources.push_back(Resource);
+		Target.ResourceNames.push_back(Name);
+		return static_cast<uint32_t>(Target.Resources.size() - 1);
+	}
+
+	struct DrawState
+	{
+		uint32_t PipelineState;
+		uint32_t Material;
+		uint32_t Mesh;
+
+		bool operator<(const DrawState& Other) const
+		{
+			if (PipelineState != Other.PipelineState)
+			{
+				return PipelineState < Other.PipelineState;
+			}
+			return Material != Other.Material ? Material < Other.Material : Mesh < Other.Mesh;
+		}
+	};
+
+	void MakeFrame(const FrameCaptureBenchmarkSettings& Settings, uint32_t DrawCount, RenderCommandArena& Arena, Frame& Out)
+	{
+		std::mt19937 Random(1234);
+		std::uniform_int_distribution<uint32_t> CopySize(1, 256);
+		std::uniform_int_distribution<uint32_t> Material(0, Settings.MaterialCount - 1);
+		std::uniform_int_distribution<uint32_t> Mesh(0, Settings.MeshCount - 1);
+
+		//Resources: the upload ring, each pass's target, depth, then copy destinations
+		const uint32_t UploadRing = AddResource(Out, FrameCaptureDimension::Buffer, 0, RenderResourceState::CopySource, "Upload ring");
+		Out.Resources[UploadRing].GpuAddress = UploadRingAddress;
+		for (uint32_t Pass = 0; Pass < Settings.PassCount; ++Pass)
+		{
+			uint32_t Target = AddResource(Out, FrameCaptureDimension::Texture2D, 1920, RenderResourceState::ShaderResource,
+				("Pass target " + std::to_string(Pass)).c_str());
+			Out.Resources[Target].Height = 1080;
+			Out.Resources[Target].Format = RenderTargetFormat;
+			Out.Resources[Target].Flags = FrameCaptureResource_RenderTarget;
+			Out.Resources[Target].Descriptor = FirstRenderTargetHandle + Pass * 64ull;
+		}
+		const uint32_t Depth = AddResource(Out, FrameCaptureDimension::Texture2D, 1920, RenderResourceState::DepthWrite, "Depth");
+		Out.Resources[Depth].Height = 1080;
+		Out.Resources[Depth].Format = DepthStencilFormat;
+		Out.Resources[Depth].Flags = FrameCaptureResource_DepthStencil;
+		Out.Resources[Depth].Descriptor = DepthStencilHandle;
+
+		//Uploads, one ring allocation each
+		Out.Streams.emplace_back(new RenderCommandStream(&Arena));
+		Out.StreamNames.push_back("Uploads");
+		RenderCommandStream& Uploads = *Out.Streams.back();
+		uint64_t RingOffset = 0;
+		uint64_t BufferAddress = FirstBufferAddress;
+		for (uint32_t Copy = 0; Copy < Settings.CopyCount; ++Copy)
+		{
+			uint64_t Size = CopySize(Random) * 256ull;
+			uint32_t Buffer = AddResource(Out, FrameCaptureDimension::Buffer, Size, RenderResourceState::VertexAndConstantBuffer, "");
+			Out.Resources[Buffer].GpuAddress = BufferAddress;
+			BufferAddress += Size;
+
+			Uploads.ResourceBarrier(Buffer, RenderResourceState::VertexAndConstantBuffer, RenderResourceState::CopyDest);
+			Uploads.CopyBufferRegion(Buffer, 0, UploadRing, RingOffset, Size);
+			Uploads.ResourceBarrier(Buffer, RenderResourceState::CopyDest, RenderResourceState::VertexAndConstantBuffer);
+
+			CapturedUpload Upload = { UploadRing, RingOffset, RingOffset, Size };
+			Out.Uploads.push_back(Upload);
+			RingOffset += Size;
+		}
+
+		const RenderViewport Viewport = { 0.0f, 0.0f, 1920.0f, 1080.0f, 0.0f, 1.0f };
+		const uint32_t StatesPerRootSignature = (Settings.PipelineStateCount + RootSignatureCount - 1) / RootSignatureCount;
+
+		std::vector<DrawState> Draws;
+		for (uint32_t Pass = 0; Pass < Settings.PassCount; ++Pass)
+		{
+			Out.Streams.emplace_back(new RenderCommandStream(&Arena));
+			Out.StreamNames.push_back("Pass " + std::to_string(Pass));
+			RenderCommandStream& Stream = *Out.Streams.back();
+
+			uint32_t Target = UploadRing + 1 + Pass;
+			uint64_t TargetHandle = Out.Resources[Target].Descriptor;
+			Stream.ResourceBarrier(Target, RenderResourceState::ShaderResource, RenderResourceState::RenderTarget);
+			Stream.SetRenderTargets(1, &TargetHandle, DepthStencilHandle);
+			Stream.SetViewport(Viewport);
+
+			uint32_t PassDraws = DrawCount / Settings.PassCount + (Pass < DrawCount % Settings.PassCount ? 1 : 0);
+			Draws.resize(PassDraws);
+			for (DrawState& Draw : Draws)
+			{
+				Draw.Material = Material(Random);
+				Draw.PipelineState = Draw.Material % Settings.PipelineStateCount;
+				Draw.Mesh = Mesh(Random);
+			}
+			std::sort(Draws.begin(), Draws.end());
+
+			//The pass's instance data is one ring allocation
+			uint64_t InstanceData = RingOffset;
+			uint64_t InstanceDataSize = static_cast<uint64_t>(PassDraws) * Settings.InstanceDataStride;
+			CapturedUpload Upload = { UploadRing, RingOffset, RingOffset, InstanceDataSize };
+			Out.Uploads.push_back(Upload);
+			RingOffset += InstanceDataSize;
+
+			const DrawState* Previous = nullptr;
+			for (const DrawState& Draw : Draws)
+			{
+				uint32_t RootSignature = Draw.PipelineState / StatesPerRootSignature;
+				bool bNewRootSignature = !Previous || RootSignature != Previous->PipelineState / StatesPerRootSignature;
+				if (bNewRootSignature)
+				{
+					Stream.SetGraphicsRootSignature(RootSignature);
+				}
+				if (!Previous || Draw.PipelineState != Previous->PipelineState)
+				{
+					Stream.SetPipelineState(Draw.PipelineState);
+				}
+				if (bNewRootSignature || Draw.Material != Previous->Material)
+				{
+					Stream.SetGraphicsRootDescriptorTable(MaterialRootParameter, Draw.Material);
+				}
+				if (!Previous || Draw.Mesh != Previous->Mesh)
+				{
+					Stream.SetMesh(Draw.Mesh);
+				}
+				Stream.SetGraphicsRootShaderResourceView(InstanceDataRootParameter, UploadRingAddress + InstanceData);
+				Stream.DrawIndexedInstanced(36 + 6 * (Draw.Mesh % 64), 1, Draw.Mesh * 420, static_cast<int32_t>(Draw.Mesh * 1024), 0);
+				InstanceData += Settings.InstanceDataStride;
+				Previous = &Draw;
+			}
+
+			Stream.ResourceBarrier(Target, RenderResourceState::RenderTarget, RenderResourceState::ShaderResource);
+		}
+
+		//Contents don't matter, only that they come back
+		Out.Resources[UploadRing].Width = RingOffset;
+		Out.UploadRing.resize(static_cast<size_t>(RingOffset));
+		for (uint8_t& Byte : Out.UploadRing)
+		{
+			Byte = static_cast<uint8_t>(Random());
+		}
+	}
+
+	//The render thread's part; upload contents are copied later
+	void Capture(const Frame& Source, FrameCaptureWriter& Writer)
+	{
+		Writer.Clear();
+		for (size_t i = 0; i < Source.Resources.size(); ++i)
+		{
+			Writer.AddResource(Source.Resources[i], Source.ResourceNames[i].c_str());
+		}
+		for (const CapturedUpload& Upload : Source.Uploads)
+		{
+			Writer.AddUpload(Upload.Resource, Upload.ResourceOffset, Source.UploadRing.data() + Upload.RingOffset, Upload.Size);
+		}
+		for (size_t i = 0; i < Source.Streams.size(); ++i)
+		{
+			Writer.AddPass(Source.StreamNames[i].c_str(), *Source.Streams[i]);
+		}
+	}
+
+	struct PipelinedCapture
+	{
+		double RenderThreadMilliseconds = 0.0;
+		double WorstRenderThreadMilliseconds = 0.0;
+		double CopyMilliseconds = 0.0;
+		double WriteMilliseconds = 0.0;
+		bool bWritten = true;
+	};
+
+	//Captures every frame as production would, see FrameCaptureBenchmark.h.
+	//Totals are over Settings.Frames frames, after one untimed frame per writer.
+	PipelinedCapture CapturePipelined(const Frame& Source, const FrameCaptureBenchmarkSettings& Settings, JobSystem& Jobs)
+	{
+		const uint32_t WriterCount = 2;
+		FrameCaptureWriter Writers[WriterCount];
+		JobCounter Written[WriterCount];
+		std::string Filenames[WriterCount];
+		double CopyMilliseconds[WriterCount] = {};
+		double WriteMilliseconds[WriterCount] = {};
+		bool bWritten[WriterCount] = {};
+		for (uint32_t i = 0; i < WriterCount; ++i)
+		{
+			Filenames[i] = Settings.CaptureFilename + "." + std::to_string(i);
+			bWritten[i] = true;
+		}
+
+		const auto FrameTime = std::chrono::duration_cast<Clock::duration>(
+			std::chrono::duration<double, std::milli>(Settings.FrameMilliseconds));
+
+		PipelinedCapture Result;
+		auto FrameStart = Clock::now();
+		for (uint32_t FrameIndex = 0; FrameIndex < Settings.Frames + WriterCount; ++FrameIndex)
+		{
+			const uint32_t Idx = FrameIndex % WriterCount;
+			const bool bTimed = FrameIndex >= WriterCount;
+
+			//End of the frame's recording
+			auto Start = Clock::now();
+			Jobs.Wait(Written[Idx]);
+			Capture(Source, Writers[Idx]);
+			Jobs.Submit([&, Idx, bTimed]()
+			{
+				auto JobStart = Clock::now();
+				Writers[Idx].CopyUploads(&Jobs);
+				double CopyMs = MillisecondsSince(JobStart);
+
+				JobStart = Clock::now();
+				bWritten[Idx] = Writers[Idx].Write(Filenames[Idx].c_str()) && bWritten[Idx];
+				if (bTimed)
+				{
+					CopyMilliseconds[Idx] += CopyMs;
+					WriteMilliseconds[Idx] += MillisecondsSince(JobStart);
+				}
+			}, &Written[Idx]);
+
+			double Milliseconds = MillisecondsSince(Start);
+			if (bTimed)
+			{
+				Result.RenderThreadMilliseconds += Milliseconds;
+				Result.WorstRenderThreadMilliseconds = std::max(Result.WorstRenderThreadMilliseconds, Milliseconds);
+			}
+
+			//The rest of the frame
+			FrameStart += FrameTime;
+			std::this_thread::sleep_until(FrameStart);
+		}
+
+		for (uint32_t i = 0; i < WriterCount; ++i)
+		{
+			Jobs.Wait(Written[i]);
+			Result.CopyMilliseconds += CopyMilliseconds[i];
+			Result.WriteMilliseconds += WriteMilliseconds[i];
+			Result.bWritten = Result.bWritten && bWritten[i];
+			remove(Filenames[i].c_str());
+		}
+		return Result;
+	}
+}
+
+FrameCaptureBenchmark::FrameCaptureBenchmark(const FrameCaptureBenchmarkSettings& Settings)
+	: mSettings(Settings)
+{
+	Assert(mSettings.Frames > 0);
+}
+
+FrameCaptureBenchmark::~FrameCaptureBenchmark()
+{}
+
+bool FrameCaptureBenchmark::Run()
+{
+	mResults.clear();
+	mSizes.clear();
+	for (uint32_t ThreadCount : mSettings.ThreadCounts)
+	{
+		if (ThreadCount < 2)
+		{
+			mLastError = "Thread counts must be at least 2 - one thread is always run";
+			return false;
+		}
+	}
+	if (mSettings.CaptureThreadCount < 2)
+	{
+		mLastError = "The capture thread count must be at least 2 - the render thread and a worker";
+		return false;
+	}
+	if (mSettings.PassCount == 0 || mSettings.PipelineStateCount < RootSignatureCount || mSettings.MaterialCount == 0 ||
+		mSettings.MeshCount == 0 || mSettings.InstanceDataStride == 0)
+	{
+		mLastError = "Pass, material, mesh counts and the instance stride must be above 0, and pipeline states at least 8";
+		return false;
+	}
+
+	for (uint32_t DrawCount : mSettings.DrawCounts)
+	{
+		if (DrawCount == 0 || !RunDrawCount(DrawCount))
+		{
+			if (mLastError.empty())
+			{
+				mLastError = "Draw counts must be above 0";
+			}
+			return false;
+		}
+	}
+	return true;
+}
+
+bool FrameCaptureBenchmark::RunDrawCount(uint32_t DrawCount)
+{
+	RenderCommandArena Arena;
+	Frame Source;
+	MakeFrame(mSettings, DrawCount, Arena, Source);
+
+	FrameCaptureBenchmarkSize Size;
+	Size.DrawCount = DrawCount;
+	for (const std::unique_ptr<RenderCommandStream>& Stream : Source.Streams)
+	{
+		Size.Commands += Stream->GetCommandCount();
+		Size.CommandBytes += Stream->GetByteSize();
+	}
+	Size.UploadBytes = Source.UploadRing.size();
+	const uint64_t CapturedBytes = Size.CommandBytes + Size.UploadBytes;
+
+	//Capture, once to warm the writer then each frame as production would
+	FrameCaptureWriter Writer;
+	Capture(Source, Writer);
+	Writer.CopyUploads();
+	double Milliseconds = 0.0;
+	for (uint32_t FrameIndex = 0; FrameIndex < mSettings.Frames; ++FrameIndex)
+	{
+		auto Start = Clock::now();
+		Capture(Source, Writer);
+		Milliseconds += MillisecondsSince(Start);
+		Writer.CopyUploads();
+	}
+	Check(Writer.GetCapturedBytes() == CapturedBytes);
+	AddResult(DrawCount, "Capture", Milliseconds, mSettings.Frames, Size.CommandBytes);
+
+	std::vector<uint32_t> ThreadCounts = mSettings.ThreadCounts;
+	ThreadCounts.insert(ThreadCounts.begin(), 1);
+	for (uint32_t ThreadCount : ThreadCounts)
+	{
+		std::unique_ptr<JobSystem> Jobs;
+		if (ThreadCount > 1)
+		{
+			Jobs.reset(new JobSystem(ThreadCount - 1));
+		}
+
+		Milliseconds = 0.0;
+		for (uint32_t FrameIndex = 0; FrameIndex < mSettings.Frames; ++FrameIndex)
+		{
+			Capture(Source, Writer);
+			auto Start = Clock::now();
+			Writer.CopyUploads(Jobs.get());
+			Milliseconds += MillisecondsSince(Start);
+		}
+		AddResult(DrawCount, ThreadCount > 1 ? "Copy uploads x" + std::to_string(ThreadCount) : "Copy uploads", Milliseconds,
+			mSettings.Frames, Size.UploadBytes);
+	}
+
+	{
+		JobSystem Jobs(mSettings.CaptureThreadCount - 1);
+		PipelinedCapture Pipelined = CapturePipelined(Source, mSettings, Jobs);
+		if (!Pipelined.bWritten)
+		{
+			mLastError = "Couldn't write " + mSettings.CaptureFilename + ".0/.1";
+			return false;
+		}
+		AddResult(DrawCount, "Pipelined capture", Pipelined.RenderThreadMilliseconds, mSettings.Frames, Size.CommandBytes);
+		AddResult(DrawCount, "Pipelined copy uploads x" + std::to_string(mSettings.CaptureThreadCount - 1),
+			Pipelined.CopyMilliseconds, mSettings.Frames, Size.UploadBytes);
+		AddResult(DrawCount, "Pipelined write", Pipelined.WriteMilliseconds, mSettings.Frames, CapturedBytes);
+
+		Size.CaptureMilliseconds = Pipelined.RenderThreadMilliseconds / mSettings.Frames;
+		Size.WorstCaptureMilliseconds = Pipelined.WorstRenderThreadMilliseconds;
+		Size.CaptureWorkMilliseconds = (Pipelined.RenderThreadMilliseconds + Pipelined.CopyMilliseconds +
+			Pipelined.WriteMilliseconds) / mSettings.Frames;
+		Size.bWithinBudget = Size.CaptureMilliseconds <= mSettings.BudgetMilliseconds;
+	}
+
+	const char* Filename = mSettings.CaptureFilename.c_str();
+	auto Start = Clock::now();
+	if (!Writer.Write(Filename))
+	{
+		mLastError = "Couldn't write " + mSettings.CaptureFilename;
+		return false;
+	}
+	AddResult(DrawCount, "Write", MillisecondsSince(Start), 1, CapturedBytes);
+
+	FrameCapture Loaded;
+	Start = Clock::now();
+	if (!Loaded.Load(Filename))
+	{
+		mLastError = Loaded.GetLastError();
+		return false;
+	}
+	AddResult(DrawCount, "Load", MillisecondsSince(Start), 1, CapturedBytes);
+
+	FILE* File = fopen(Filename, "rb");
+	if (File)
+	{
+		fseek(File, 0, SEEK_END);
+		Size.FileBytes = static_cast<uint64_t>(ftell(File));
+		fclose(File);
+	}
+
+	//Every pass must decode to the same stream, and every upload hold the same bytes
+	const std::string Mismatch = "The loaded capture differs from what was captured with " + std::to_string(DrawCount) + " draws";
+	if (Loaded.GetPassCount() != Source.Streams.size() || Loaded.GetUploadCount() != Source.Uploads.size() ||
+		Loaded.GetResourceCount() != Source.Resources.size())
+	{
+		mLastError = Mismatch;
+		return false;
+	}
+
+	RenderCommandStream Decoded(&Arena);
+	std::vector<uint8_t> Expected;
+	std::vector<uint8_t> Actual;
+	for (uint32_t Pass = 0; Pass < Loaded.GetPassCount(); ++Pass)
+	{
+		const RenderCommandStream& Stream = *Source.Streams[Pass];
+		Decoded.Reset();
+		Loaded.ReplayPass(Pass, Decoded);
+
+		Expected.resize(static_cast<size_t>(Stream.GetByteSize()));
+		Stream.CopyBytes(Expected.data());
+		Actual.resize(static_cast<size_t>(Decoded.GetByteSize()));
+		Decoded.CopyBytes(Actual.data());
+		if (Expected != Actual || Loaded.GetPass(Pass).CommandCount != Stream.GetCommandCount() ||
+			Source.StreamNames[Pass] != Loaded.GetString(Loaded.GetPass(Pass).NameOffset))
+		{
+			mLastError = Mismatch;
+			return false;
+		}
+	}
+	for (uint32_t i = 0; i < Loaded.GetUploadCount(); ++i)
+	{
+		const CapturedUpload& Upload = Source.Uploads[i];
+		const FrameCaptureUpload& LoadedUpload = Loaded.GetUpload(i);
+		if (LoadedUpload.Resource != Upload.Resource || LoadedUpload.ResourceOffset != Upload.ResourceOffset ||
+			LoadedUpload.Size != Upload.Size ||
+			memcmp(Loaded.GetUploadData(i), Source.UploadRing.data() + Upload.RingOffset, static_cast<size_t>(Upload.Size)) != 0)
+		{
+			mLastError = Mismatch;
+			return false;
+		}
+	}
+
+	//Instance data addresses must map back to the ring
+	uint32_t Resource = 0;
+	uint64_t Offset = 0;
+	if (!Loaded.FindBuffer(UploadRingAddress + 64, Resource, Offset) || Resource != 0 || Offset != 64)
+	{
+		mLastError = Mismatch;
+		return false;
+	}
+
+	NullRenderCommandList Null;
+	Milliseconds = 0.0;
+	for (uint32_t FrameIndex = 0; FrameIndex < mSettings.Frames; ++FrameIndex)
+	{
+		Null.Reset();
+		Start = Clock::now();
+		for (uint32_t Pass = 0; Pass < Loaded.GetPassCount(); ++Pass)
+		{
+			Loaded.ReplayPass(Pass, Null);
+		}
+		Milliseconds += MillisecondsSince(Start);
+	}
+	Check(Null.GetTotalCallCount() == Size.Commands);
+	AddResult(DrawCount, "Replay null", Milliseconds, mSettings.Frames, Size.CommandBytes);
+
+	StandInCommandList StandIn;
+	Milliseconds = 0.0;
+	for (uint32_t FrameIndex = 0; FrameIndex < mSettings.Frames; ++FrameIndex)
+	{
+		StandIn.Reset();
+		Start = Clock::now();
+		for (uint32_t Pass = 0; Pass < Loaded.GetPassCount(); ++Pass)
+		{
+			Loaded.ReplayPass(Pass, StandIn);
+		}
+		Milliseconds += MillisecondsSince(Start);
+	}
+	Check(StandIn.GetTotalCallCount() == Size.Commands);
+	AddResult(DrawCount, "Replay stand-in", Milliseconds, mSettings.Frames, Size.CommandBytes);
+
+	mSizes.push_back(Size);
+	return true;
+}
+
+void FrameCaptureBenchmark::AddResult(uint32_t DrawCount, const std::string& Mode, double Milliseconds, uint32_t Frames,
+	uint64_t BytesPerFrame)
+{
+	FrameCaptureBenchmarkResult Result;
+	Result.DrawCount = DrawCount;
+	Result.Mode = Mode;
+	Result.MillisecondsPerFrame = Milliseconds / Frames;
+	Result.MegabytesPerSecond = Milliseconds > 0.0 ? (static_cast<double>(BytesPerFrame) * Frames / (1024.0 * 1024.0)) / (Milliseconds / 1000.0) : 0.0;
+	mResults.push_back(Result);
+}
+
+bool FrameCaptureBenchmark::WriteReport(const char* Filename) const
+{
+	FILE* File = fopen(Filename, "w");
+	if (!File)
+	{
+		return false;
+	}
+
+	fprintf(File, "Frames:          %u\n", mSettings.Frames);
+	fprintf(File, "Passes:          %u\n", mSettings.PassCount);
+	fprintf(File, "Copies:          %u\n", mSettings.CopyCount);
+	fprintf(File, "Instance stride: %u\n", mSettings.InstanceDataStride);
+	fprintf(File, "Frame time:      %.3f ms\n", mSettings.FrameMilliseconds);
+	fprintf(File, "Capture threads: %u\n", mSettings.CaptureThreadCount);
+	fprintf(File, "Budget:          %.3f ms\n", mSettings.BudgetMilliseconds);
+	fprintf(File, "Capture file:    %s\n\n", mSettings.CaptureFilename.c_str());
+
+	fprintf(File, "Draws,Mode,MsPerFrame,MBPerSecond\n");
+	for (const FrameCaptureBenchmarkResult& Result : mResults)
+	{
+		fprintf(File, "%u,%s,%.3f,%.1f\n", Result.DrawCount, Result.Mode.c_str(), Result.MillisecondsPerFrame, Result.MegabytesPerSecond);
+	}
+
+	fprintf(File, "\nDraws,Commands,CommandBytes,UploadBytes,FileBytes,CaptureMs,WorstCaptureMs,CaptureWorkMs,CaptureWithinBudget\n");
+	for (const FrameCaptureBenchmarkSize& Size : mSizes)
+	{
+		fprintf(File, "%u,%u,%llu,%llu,%llu,%.3f,%.3f,%.3f,%s\n", Size.DrawCount, Size.Commands,
+			static_cast<unsigned long long>(Size.CommandBytes), static_cast<unsigned long long>(Size.UploadBytes),
+			static_cast<unsigned long long>(Size.FileBytes), Size.CaptureMilliseconds, Size.WorstCaptureMilliseconds,
+			Size.CaptureWorkMilliseconds, Size.bWithinBudget ? "Yes" : "No");
+	}
+
+	fclose(File);
+	return true;
+}
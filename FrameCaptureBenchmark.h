@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//Cost of capturing a frame with FrameCaptureWriter, for each of DrawCounts
+//draws a frame, against the BudgetMilliseconds a capture may add to a frame
+//in production.
+//
+//A frame is CopyCount buffer uploads then PassCount passes of sorted draws,
+//each reading its instance data from the upload ring, recorded once in to
+//RenderCommandStreams. Capturing copies the streams and the resource table
+//and notes every upload, as the render thread would at the end of each
+//frame. Copying the upload contents is timed on its own, on one thread and
+//split across each of ThreadCounts threads, as it would run on workers.
+//Writing the file, loading it and replaying it on the null backend and the
+//recording stand-in are timed too; the last capture is left in
+//CaptureFilename for FrameReplayTool.
+//
+//The budget is checked against the whole capture running as it would in
+//production, every frame for Frames frames of FrameMilliseconds: the render
+//thread captures in to one of two writers, then a job copies the uploads
+//(split across the other CaptureThreadCount - 1 threads) and writes the file
+//while the next frame runs. A writer is only reused once its last capture is
+//written, so a copy or write that can't keep up shows up as render thread
+//time. That render thread time per frame is what must fit the budget; the
+//total work including the copy and write is reported next to it.
+//
+//Run() fails if the loaded capture doesn't hold exactly the commands and
+//upload contents captured.
+struct FrameCaptureBenchmarkSettings
+{
+	std::vector<uint32_t> DrawCounts = { 10000, 100000 };
+	std::vector<uint32_t> ThreadCounts = { 2, 4, 8 };
+	uint32_t Frames = 20;
+	double FrameMilliseconds = 16.7;
+	uint32_t CaptureThreadCount = 4;
+	uint32_t PassCount = 8;
+	uint32_t CopyCount = 256;
+	uint32_t InstanceDataStride = 64;
+	uint32_t PipelineStateCount = 64;
+	uint32_t MaterialCount = 1024;
+	uint32_t MeshCount = 256;
+	double BudgetMilliseconds = 1.0;
+	std::string CaptureFilename = "FrameCaptureBenchmark.fcap";
+};
+
+struct FrameCaptureBenchmarkResult
+{
+	uint32_t DrawCount = 0;
+	std::string Mode;
+	double MillisecondsPerFrame = 0.0;
+	double MegabytesPerSecond = 0.0;
+};
+
+struct FrameCaptureBenchmarkSize
+{
+	uint32_t DrawCount = 0;
+	uint32_t Commands = 0;
+	uint64_t CommandBytes = 0;
+	uint64_t UploadBytes = 0;
+	uint64_t FileBytes = 0;
+	double CaptureMilliseconds = 0.0;		//Render thread, per frame, including waits for earlier captures
+	double WorstCaptureMilliseconds = 0.0;
+	double CaptureWorkMilliseconds = 0.0;	//Per frame, render thread plus the copy and write
+	bool bWithinBudget = false;				//CaptureMilliseconds
+};
+
+class FrameCaptureBenchmark
+{
+public:
+	FrameCaptureBenchmark(const FrameCaptureBenchmarkSettings& Settings);
+	~FrameCaptureBenchmark();
+
+	bool Run();
+	bool WriteReport(const char* Filename) const;
+
+	const std::string& GetLastError() const { return mLastError; }
+
+private:
+	bool RunDrawCount(uint32_t DrawCount);
+
+	void AddResult(uint32_t DrawCount, const std::string& Mode, double Milliseconds, uint32_t Frames, uint64_t BytesPerFrame);
+
+private:
+	FrameCaptureBenchmarkSettings mSettings;
+	std::vector<FrameCaptureBenchmarkResult> mResults;
+	std::vector<FrameCaptureBenchmarkSize> mSizes;
+
+	std::string mLastError;
+};
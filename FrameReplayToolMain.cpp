@@ -0,0 +1,210 @@
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "FrameCapture.h"
+#include "FrameCaptureBenchmark.h"
+#include "NullRenderCommandList.h"
+#include "StandInCommandList.h"
+
+//Frame capture tool:
+//	FrameReplayTool info <capture>
+//	FrameReplayTool replay <capture> [-frames N] [-backend null|standin]
+//	FrameReplayTool bench [-frames N] [-draws N ...]	- writes FrameCaptureBenchmark.txt
+//Replays time the CPU side of each pass; D3D12FrameReplay times them on a device.
+namespace
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	double MillisecondsSince(Clock::time_point Start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - Start).count();
+	}
+
+	bool LoadCapture(const char* Filename, FrameCapture& Capture)
+	{
+		if (!Capture.Load(Filename))
+		{
+			fprintf(stderr, "%s\n", Capture.GetLastError().c_str());
+			return false;
+		}
+		return true;
+	}
+
+	int Info(int argc, char** argv)
+	{
+		if (argc != 3)
+		{
+			return -1;
+		}
+
+		FrameCapture Capture;
+		if (!LoadCapture(argv[2], Capture))
+		{
+			return 1;
+		}
+
+		uint64_t UploadBytes = 0;
+		for (uint32_t i = 0; i < Capture.GetUploadCount(); ++i)
+		{
+			UploadBytes += Capture.GetUpload(i).Size;
+		}
+		printf("%u resources, %u uploads (%.2f MB)\n", Capture.GetResourceCount(), Capture.GetUploadCount(),
+			UploadBytes / (1024.0 * 1024.0));
+
+		for (uint32_t i = 0; i < Capture.GetPassCount(); ++i)
+		{
+			const FrameCapturePass& Pass = Capture.GetPass(i);
+			printf("%10u commands %12llu bytes  %s\n", Pass.CommandCount, static_cast<unsigned long long>(Pass.CommandSize),
+				Capture.GetString(Pass.NameOffset));
+		}
+		return 0;
+	}
+
+	int Replay(int argc, char** argv)
+	{
+		if (argc < 3)
+		{
+			return -1;
+		}
+
+		uint32_t Frames = 100;
+		bool bStandIn = false;
+		for (int i = 3; i < argc; ++i)
+		{
+			if (strcmp(argv[i], "-frames") == 0 && i + 1 < argc)
+			{
+				Frames = static_cast<uint32_t>(atoi(argv[++i]));
+			}
+			else if (strcmp(argv[i], "-backend") == 0 && i + 1 < argc)
+			{
+				++i;
+				if (strcmp(argv[i], "standin") == 0)
+				{
+					bStandIn = true;
+				}
+				else if (strcmp(argv[i], "null") != 0)
+				{
+					return -1;
+				}
+			}
+			else
+			{
+				return -1;
+			}
+		}
+		if (Frames == 0)
+		{
+			return -1;
+		}
+
+		FrameCapture Capture;
+		if (!LoadCapture(argv[2], Capture))
+		{
+			return 1;
+		}
+
+		NullRenderCommandList Null;
+		StandInCommandList StandIn;
+		IRenderCommandList& Backend = bStandIn ? static_cast<IRenderCommandList&>(StandIn) : Null;
+
+		//Per pass totals and best frames
+		const uint32_t PassCount = Capture.GetPassCount();
+		std::vector<double> Total(PassCount, 0.0);
+		std::vector<double> Best(PassCount, 1e30);
+		for (uint32_t Frame = 0; Frame < Frames; ++Frame)
+		{
+			StandIn.Reset();
+			for (uint32_t Pass = 0; Pass < PassCount; ++Pass)
+			{
+				auto Start = Clock::now();
+				Capture.ReplayPass(Pass, Backend);
+				double Milliseconds = MillisecondsSince(Start);
+				Total[Pass] += Milliseconds;
+				Best[Pass] = Milliseconds < Best[Pass] ? Milliseconds : Best[Pass];
+			}
+		}
+
+		printf("%u frames on the %s backend\n", Frames, bStandIn ? "stand-in" : "null");
+		printf("%10s %10s %10s  %s\n", "Commands", "Mean ms", "Best ms", "Pass");
+		double FrameTotal = 0.0;
+		for (uint32_t Pass = 0; Pass < PassCount; ++Pass)
+		{
+			printf("%10u %10.4f %10.4f  %s\n", Capture.GetPass(Pass).CommandCount, Total[Pass] / Frames, Best[Pass],
+				Capture.GetString(Capture.GetPass(Pass).NameOffset));
+			FrameTotal += Total[Pass];
+		}
+		printf("%10s %10.4f %10s  Frame\n", "", FrameTotal / Frames, "");
+		return 0;
+	}
+
+	int Bench(int argc, char** argv)
+	{
+		FrameCaptureBenchmarkSettings Settings;
+		bool bCustomDraws = false;
+		for (int i = 2; i < argc; ++i)
+		{
+			if (strcmp(argv[i], "-frames") == 0 && i + 1 < argc)
+			{
+				Settings.Frames = static_cast<uint32_t>(atoi(argv[++i]));
+			}
+			else if (strcmp(argv[i], "-draws") == 0 && i + 1 < argc)
+			{
+				if (!bCustomDraws)
+				{
+					Settings.DrawCounts.clear();
+					bCustomDraws = true;
+				}
+				Settings.DrawCounts.push_back(static_cast<uint32_t>(atoi(argv[++i])));
+			}
+			else
+			{
+				return -1;
+			}
+		}
+		if (Settings.Frames == 0)
+		{
+			return -1;
+		}
+
+		FrameCaptureBenchmark Benchmark(Settings);
+		if (!Benchmark.Run())
+		{
+			fprintf(stderr, "%s\n", Benchmark.GetLastError().c_str());
+			return 1;
+		}
+		return Benchmark.WriteReport("FrameCaptureBenchmark.txt") ? 0 : 1;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int Result = -1;
+	if (argc >= 2)
+	{
+		if (strcmp(argv[1], "info") == 0)
+		{
+			Result = Info(argc, argv);
+		}
+		else if (strcmp(argv[1], "replay") == 0)
+		{
+			Result = Replay(argc, argv);
+		}
+		else if (strcmp(argv[1], "bench") == 0)
+		{
+			Result = Bench(argc, argv);
+		}
+	}
+
+	if (Result < 0)
+	{
+		fprintf(stderr, "Usage:\n"
+			"  FrameReplayTool info <capture>\n"
+			"  FrameReplayTool replay <capture> [-frames N] [-backend null|standin]\n"
+			"  FrameReplayTool bench [-frames N] [-draws N ...]\n");
+		return 1;
+	}
+	return Result;
+}
@@ -0,0 +1,190 @@
+#include "FrustumCuller.h"
+#include "Common.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	typedef SimdFloat8 CullFloat;
+
+	uint32_t PaddedCount(uint32_t Count)
+	{
+		return (Count + CullFloat::Width - 1) / CullFloat::Width * CullFloat::Width;
+	}
+}
+
+//The frustum splatted across lanes, built once per Cull()
+struct FrustumCuller::PlaneSet
+{
+	CullFloat NormalX[6], NormalY[6], NormalZ[6], Distance[6];
+	CullFloat AbsNormalX[6], AbsNormalY[6], AbsNormalZ[6];
+};
+
+FrustumCuller::FrustumCuller()
+	: mCount(0)
+{}
+
+FrustumCuller::~FrustumCuller()
+{}
+
+void FrustumCuller::Reserve(uint32_t Count)
+{
+	std::vector<float>* Arrays[] = { &mCentreX, &mCentreY, &mCentreZ, &mExtentX, &mExtentY, &mExtentZ, &mRadius };
+	for (std::vector<float>* Array : Arrays)
+	{
+		Array->reserve(PaddedCount(Count));
+	}
+}
+
+void FrustumCuller::Clear()
+{
+	std::vector<float>* Arrays[] = { &mCentreX, &mCentreY, &mCentreZ, &mExtentX, &mExtentY, &mExtentZ, &mRadius };
+	for (std::vector<float>* Array : Arrays)
+	{
+		Array->clear();
+	}
+	mCount = 0;
+}
+
+uint32_t FrustumCuller::AddObject(const Aabb& Bounds)
+{
+	uint32_t Object = mCount++;
+	std::vector<float>* Arrays[] = { &mCentreX, &mCentreY, &mCentreZ, &mExtentX, &mExtentY, &mExtentZ, &mRadius };
+	for (std::vector<float>* Array : Arrays)
+	{
+		Array->resize(PaddedCount(mCount), 0.0f);
+	}
+
+	SetBounds(Object, Bounds);
+	return Object;
+}
+
+void FrustumCuller::SetBounds(uint32_t Object, const Aabb& Bounds)
+{
+	Assert(Object < mCount);
+
+	Float3 Centre = (Bounds.Min + Bounds.Max) * 0.5f;
+	Float3 Extents = (Bounds.Max - Bounds.Min) * 0.5f;
+	mCentreX[Object] = Centre.X;
+	mCentreY[Object] = Centre.Y;
+	mCentreZ[Object] = Centre.Z;
+	mExtentX[Object] = Extents.X;
+	mExtentY[Object] = Extents.Y;
+	mExtentZ[Object] = Extents.Z;
+	mRadius[Object] = Length(Extents);
+}
+
+uint32_t FrustumCuller::Cull(const Frustum& View, std::vector<uint32_t>& OutVisible, JobSystem* Jobs)
+{
+	PlaneSet Planes;
+	for (int i = 0; i < 6; ++i)
+	{
+		const Plane& Side = View.Planes[i];
+		Planes.NormalX[i] = CullFloat::Splat(Side.Normal.X);
+		Planes.NormalY[i] = CullFloat::Splat(Side.Normal.Y);
+		Planes.NormalZ[i] = CullFloat::Splat(Side.Normal.Z);
+		Planes.Distance[i] = CullFloat::Splat(Side.Distance);
+		Planes.AbsNormalX[i] = CullFloat::Splat(fabsf(Side.Normal.X));
+		Planes.AbsNormalY[i] = CullFloat::Splat(fabsf(Side.Normal.Y));
+		Planes.AbsNormalZ[i] = CullFloat::Splat(fabsf(Side.Normal.Z));
+	}
+
+	//Every block writes from its own start, so the worst case needs room for everything
+	OutVisible.resize(mCount);
+	uint32_t BlockCount = (mCount + JobBatchSize - 1) / JobBatchSize;
+	mBlockVisible.assign(BlockCount, 0);
+	mBlockSphereRejected.assign(BlockCount, 0);
+
+	auto CullBlocks = [this, &Planes, &OutVisible](uint32_t BlockBegin, uint32_t BlockEnd)
+	{
+		for (uint32_t Block = BlockBegin; Block < BlockEnd; ++Block)
+		{
+			uint32_t Begin = Block * JobBatchSize;
+			uint32_t End = std::min(mCount, Begin + JobBatchSize);
+			mBlockVisible[Block] = CullRange(Planes, Begin, End, OutVisible.data() + Begin, mBlockSphereRejected[Block]);
+		}
+	};
+
+	mStats = FrustumCullStats();
+	if (Jobs && BlockCount > 1)
+	{
+		Jobs->ParallelFor(BlockCount, 1, CullBlocks);
+		mStats.JobCount = BlockCount;
+	}
+	else
+	{
+		CullBlocks(0, BlockCount);
+	}
+
+	//Pack the blocks' results together
+	uint32_t VisibleCount = 0;
+	for (uint32_t Block = 0; Block < BlockCount; ++Block)
+	{
+		if (VisibleCount != Block * JobBatchSize && mBlockVisible[Block] > 0)
+		{
+			memmove(OutVisible.data() + VisibleCount, OutVisible.data() + Block * JobBatchSize, mBlockVisible[Block] * sizeof(uint32_t));
+		}
+		VisibleCount += mBlockVisible[Block];
+		mStats.GroupsRejectedBySphere += mBlockSphereRejected[Block];
+	}
+	OutVisible.resize(VisibleCount);
+
+	mStats.ObjectsTested = mCount;
+	mStats.ObjectsVisible = VisibleCount;
+	return VisibleCount;
+}
+
+uint32_t FrustumCuller::CullRange(const PlaneSet& Planes, uint32_t Begin, uint32_t End, uint32_t* Out, uint32_t& OutSphereRejected) const
+{
+	//Begin is always a multiple of the width, so groups never straddle blocks
+	Assert(Begin % CullFloat::Width == 0);
+
+	uint32_t VisibleCount = 0;
+	uint32_t SphereRejected = 0;
+	for (uint32_t Group = Begin; Group < End; Group += CullFloat::Width)
+	{
+		CullFloat CentreX = CullFloat::LoadUnaligned(&mCentreX[Group]);
+		CullFloat CentreY = CullFloat::LoadUnaligned(&mCentreY[Group]);
+		CullFloat CentreZ = CullFloat::LoadUnaligned(&mCentreZ[Group]);
+		CullFloat NegativeRadius = -CullFloat::LoadUnaligned(&mRadius[Group]);
+
+		CullFloat Distances[6];
+		CullFloat Outside = CullFloat::Splat(0.0f);
+		for (int i = 0; i < 6; ++i)
+		{
+			Distances[i] = Planes.NormalX[i] * CentreX + Planes.NormalY[i] * CentreY + Planes.NormalZ[i] * CentreZ + Planes.Distance[i];
+			Outside = Or(Outside, CompareLess(Distances[i], NegativeRadius));
+		}
+
+		uint32_t LaneCount = End - Group < CullFloat::Width ? End - Group : CullFloat::Width;
+		uint32_t LaneMask = (1u << LaneCount) - 1;
+		if ((GetMaskBits(Outside) & LaneMask) == LaneMask)
+		{
+			++SphereRejected;
+			continue;
+		}
+
+		//Box radius along each plane normal
+		CullFloat ExtentX = CullFloat::LoadUnaligned(&mExtentX[Group]);
+		CullFloat ExtentY = CullFloat::LoadUnaligned(&mExtentY[Group]);
+		CullFloat ExtentZ = CullFloat::LoadUnaligned(&mExtentZ[Group]);
+		for (int i = 0; i < 6; ++i)
+		{
+			CullFloat Radius = Planes.AbsNormalX[i] * ExtentX + Planes.AbsNormalY[i] * ExtentY + Planes.AbsNormalZ[i] * ExtentZ;
+			Outside = Or(Outside, CompareLess(Distances[i], -Radius));
+		}
+
+		//Branch free compaction - every lane is written, only visible ones advance
+		uint32_t VisibleBits = ~GetMaskBits(Outside) & LaneMask;
+		for (uint32_t Lane = 0; Lane < LaneCount; ++Lane)
+		{
+			Out[VisibleCount] = Group + Lane;
+			VisibleCount += (VisibleBits >> Lane) & 1;
+		}
+	}
+
+	OutSphereRejected = SphereRejected;
+	return VisibleCount;
+}
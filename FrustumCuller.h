@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "VectorMath.h"
+
+class JobSystem;
+
+struct FrustumCullStats
+{
+	uint32_t ObjectsTested = 0;
+	uint32_t ObjectsVisible = 0;
+	uint32_t GroupsRejectedBySphere = 0;	//Whole groups out before the box test
+	uint32_t JobCount = 0;
+};
+
+//Frustum culling for large numbers of objects.
+//
+//Bounds are kept as structure of arrays - box centre, extents and bounding
+//sphere radius - so Cull() tests SimdFloat8::Width objects per instruction
+//against all six planes. Each group is tested as spheres first, which reuses
+//the plane distances the box test needs and skips the box test when the whole
+//group is out. Large object counts are split across the job system; each job
+//writes its visible indices to its own part of the output, and the parts are
+//then packed together, so the result is the same ascending list however many
+//threads ran.
+class FrustumCuller
+{
+public:
+	static const uint32_t JobBatchSize = 16384;
+
+	FrustumCuller();
+	~FrustumCuller();
+
+	void Reserve(uint32_t Count);
+	void Clear();
+
+	uint32_t AddObject(const Aabb& Bounds);
+	void SetBounds(uint32_t Object, const Aabb& Bounds);
+	uint32_t GetObjectCount() const { return mCount; }
+
+	//Indices of objects not entirely outside a plane of View (see
+	//IsAabbInFrustum), ascending. OutVisible keeps its capacity between calls.
+	uint32_t Cull(const Frustum& View, std::vector<uint32_t>& OutVisible, JobSystem* Jobs = nullptr);
+
+	const FrustumCullStats& GetLastCullStats() const { return mStats; }
+
+private:
+	struct PlaneSet;
+
+	//Writes visible indices from [Begin, End) to Out, returns how many
+	uint32_t CullRange(const PlaneSet& Planes, uint32_t Begin, uint32_t End, uint32_t* Out, uint32_t& OutSphereRejected) const;
+
+private:
+	//Padded to a whole number of SIMD groups
+	std::vector<float> mCentreX, mCentreY, mCentreZ;
+	std::vector<float> mExtentX, mExtentY, mExtentZ;
+	std::vector<float> mRadius;
+	uint32_t mCount;
+
+	std::vector<uint32_t> mBlockVisible;
+	std::vector<uint32_t> mBlockSphereRejected;
+	FrustumCullStats mStats;
+};
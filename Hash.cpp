@@ -0,0 +1,148 @@
+#include "Hash.h"
+
+#include <cstring>
+#include <stdio.h>
+
+namespace
+{
+	const uint64_t Prime1 = 0x9E3779B185EBCA87ull;
+	const uint64_t Prime2 = 0xC2B2AE3D27D4EB4Full;
+	const uint64_t Prime3 = 0x165667B19E3779F9ull;
+	const uint64_t Prime4 = 0x85EBCA77C2B2AE63ull;
+	const uint64_t Prime5 = 0x27D4EB2F165667C5ull;
+
+	inline uint64_t RotateLeft(uint64_t Value, int Bits)
+	{
+		return (Value << Bits) | (Value >> (64 - Bits));
+	}
+
+	//Little endian reads - every platform we target
+	inline uint64_t Read64(const uint8_t* Data)
+	{
+		uint64_t Value;
+		memcpy(&Value, Data, sizeof(Value));
+		return Value;
+	}
+
+	inline uint32_t Read32(const uint8_t* Data)
+	{
+		uint32_t Value;
+		memcpy(&Value, Data, sizeof(Value));
+		return Value;
+	}
+
+	inline uint64_t Round(uint64_t Accumulator, uint64_t Input)
+	{
+		Accumulator += Input * Prime2;
+		Accumulator = RotateLeft(Accumulator, 31);
+		return Accumulator * Prime1;
+	}
+
+	inline uint64_t MergeRound(uint64_t Accumulator, uint64_t Value)
+	{
+		Accumulator ^= Round(0, Value);
+		return Accumulator * Prime1 + Prime4;
+	}
+}
+
+uint64_t HashBytes(const void* Data, size_t Size, uint64_t Seed)
+{
+	const uint8_t* Cursor = static_cast<const uint8_t*>(Data);
+	const uint8_t* End = Cursor + Size;
+	uint64_t Hash;
+
+	if (Size >= 32)
+	{
+		uint64_t V1 = Seed + Prime1 + Prime2;
+		uint64_t V2 = Seed + Prime2;
+		uint64_t V3 = Seed;
+		uint64_t V4 = Seed - Prime1;
+
+		const uint8_t* Limit = End - 32;
+		do
+		{
+			V1 = Round(V1, Read64(Cursor));
+			V2 = Round(V2, Read64(Cursor + 8));
+			V3 = Round(V3, Read64(Cursor + 16));
+			V4 = Round(V4, Read64(Cursor + 24));
+			Cursor += 32;
+		} while (Cursor <= Limit);
+
+		Hash = RotateLeft(V1, 1) + RotateLeft(V2, 7) + RotateLeft(V3, 12) + RotateLeft(V4, 18);
+		Hash = MergeRound(Hash, V1);
+		Hash = MergeRound(Hash, V2);
+		Hash = MergeRound(Hash, V3);
+		Hash = MergeRound(Hash, V4);
+	}
+	else
+	{
+		Hash = Seed + Prime5;
+	}
+
+	Hash += static_cast<uint64_t>(Size);
+
+	while (Cursor + 8 <= End)
+	{
+		Hash ^= Round(0, Read64(Cursor));
+		Hash = RotateLeft(Hash, 27) * Prime1 + Prime4;
+		Cursor += 8;
+	}
+
+	if (Cursor + 4 <= End)
+	{
+		Hash ^= static_cast<uint64_t>(Read32(Cursor)) * Prime1;
+		Hash = RotateLeft(Hash, 23) * Prime2 + Prime3;
+		Cursor += 4;
+	}
+
+	while (Cursor < End)
+	{
+		Hash ^= static_cast<uint64_t>(*Cursor) * Prime5;
+		Hash = RotateLeft(Hash, 11) * Prime1;
+		++Cursor;
+	}
+
+	Hash ^= Hash >> 33;
+	Hash *= Prime2;
+	Hash ^= Hash >> 29;
+	Hash *= Prime3;
+	Hash ^= Hash >> 32;
+	return Hash;
+}
+
+std::string HashToString(uint64_t Hash)
+{
+	char Buffer[17];
+	snprintf(Buffer, sizeof(Buffer), "%016llx", static_cast<unsigned long long>(Hash));
+	return Buffer;
+}
+
+bool ParseHash(const char* String, uint64_t& OutHash)
+{
+	uint64_t Value = 0;
+	for (int i = 0; i < 16; ++i)
+	{
+		char C = String[i];
+		uint64_t Digit;
+		if (C >= '0' && C <= '9')
+		{
+			Digit = C - '0';
+		}
+		else if (C >= 'a' && C <= 'f')
+		{
+			Digit = C - 'a' + 10;
+		}
+		else if (C >= 'A' && C <= 'F')
+		{
+			Digit = C - 'A' + 10;
+		}
+		else
+		{
+			return false;
+		}
+		Value = (Value << 4) | Digit;
+	}
+
+	OutHash = Value;
+	return true;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+//64 bit content hash (XXH64). Stable across platforms and runs - safe to
+//persist in asset databases and archive indices.
+uint64_t HashBytes(const void* Data, size_t Size, uint64_t Seed = 0);
+
+inline uint64_t HashString(const std::string& String, uint64_t Seed = 0)
+{
+	return HashBytes(String.data(), String.size(), Seed);
+}
+
+//16 hex digits and back. ParseHash returns false on malformed input.
+std::string HashToString(uint64_t Hash);
+bool ParseHash(const char* String, uint64_t& OutHash);
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+
+//A monotonically increasing GPU timeline - either a real ID3D12Fence signalled
+//on a queue (D3D12QueueFence) or a simulated one for headless runs (SimulatedFence).
+class IFence
+{
+public:
+	IFence() {};
+	virtual ~IFence() {};
+
+	//Queue a signal after all work submitted so far. Returns the value signalled.
+	virtual uint64_t Signal() = 0;
+
+	virtual uint64_t GetLastSignalledValue() const = 0;
+	virtual uint64_t GetCompletedValue() const = 0;
+
+	//Block the calling thread until Value has completed.
+	virtual void WaitForValue(uint64_t Value) = 0;
+
+	bool IsComplete(uint64_t Value) const { return GetCompletedValue() >= Value; }
+};
@@ -1,14 +1,28 @@
 #pragma once
 
+#include "AsyncTask.h"
+
+class PackedSceneBuilder;
+
 class IScene
 {
 public:
 	IScene() {};
 	virtual ~IScene() = 0 {};
 
-	virtual bool OnInitScene() = 0;
+	//A coroutine, so loading can co_await file reads, jobs and fences (see
+	//AsyncAwaitables.h) without blocking the main thread.
+	virtual AsyncTask<bool> OnInitScene() = 0;
 	virtual int OnCloseScene() = 0;
 
+	//Called on the main thread in the frame a loaded scene replaces the active
+	//one (see SceneManager). Keep it cheap - anything slow belongs in OnInitScene.
+	virtual void OnActivateScene() {};
+
 	virtual void OnUpdate(float dt) = 0;
 	virtual void OnRender() = 0;
+
+	//Adds the scene's entities to Builder, for PackedSceneBuilder::Write().
+	//Scenes that can't be saved return false.
+	virtual bool OnSaveScene(PackedSceneBuilder& Builder) const { return false; };
 };
\ No newline at end of file
@@ -0,0 +1,118 @@
+#include "InstanceBatcher.h"
+#include "Common.h"
+#include "RenderCommandList.h"
+#include "UploadRing.h"
+
+#include <algorithm>
+#include <string.h>
+
+namespace
+{
+	bool SameState(const DrawPacket& A, const DrawPacket& B)
+	{
+		return A.Pass == B.Pass && A.SortMode == B.SortMode && A.PipelineState == B.PipelineState &&
+			A.RootSignature == B.RootSignature && A.Material == B.Material;
+	}
+}
+
+InstanceBatcher::InstanceBatcher(const InstanceBatcherSettings& Settings)
+	: mSettings(Settings)
+{
+	Assert(mSettings.MaxBatchSize > 0 && mSettings.InstanceDataStride > 0 && (mSettings.InstanceDataStride & 3) == 0);
+}
+
+InstanceBatcher::~InstanceBatcher()
+{}
+
+void InstanceBatcher::Record(const DrawPacket* Draws, uint32_t Count, const MeshDrawArgs* Meshes, const uint8_t* InstanceData,
+	UploadRing& Ring, IRenderCommandList& CommandList)
+{
+	mStats = InstanceBatcherStats();
+	mStats.DrawsRequested = Count;
+	if (Count == 0)
+	{
+		return;
+	}
+
+	const uint32_t Stride = mSettings.InstanceDataStride;
+	mStats.InstanceDataBytes = static_cast<uint64_t>(Count) * Stride;
+	UploadAllocation Upload = Ring.Allocate(mStats.InstanceDataBytes);
+	uint32_t Written = 0;
+
+	const DrawPacket* Bound = nullptr;
+	uint32_t BoundMesh = 0;
+
+	uint32_t RunBegin = 0;
+	while (RunBegin < Count)
+	{
+		uint32_t RunEnd = RunBegin + 1;
+		while (RunEnd < Count && SameState(Draws[RunBegin], Draws[RunEnd]))
+		{
+			++RunEnd;
+		}
+
+		mRun.clear();
+		for (uint32_t i = RunBegin; i < RunEnd; ++i)
+		{
+			mRun.push_back((static_cast<uint64_t>(Draws[i].Mesh) << 32) | i);
+		}
+		if (Draws[RunBegin].SortMode == DrawSortMode::Opaque)
+		{
+			std::sort(mRun.begin(), mRun.end());
+		}
+
+		const DrawPacket& State = Draws[RunBegin];
+		bool bNewRootSignature = !Bound || State.RootSignature != Bound->RootSignature;
+		if (bNewRootSignature)
+		{
+			CommandList.SetGraphicsRootSignature(State.RootSignature);
+		}
+		if (!Bound || State.PipelineState != Bound->PipelineState)
+		{
+			CommandList.SetPipelineState(State.PipelineState);
+		}
+		if (bNewRootSignature || State.Material != Bound->Material)
+		{
+			CommandList.SetGraphicsRootDescriptorTable(mSettings.MaterialRootParameter, State.Material);
+		}
+		Bound = &State;
+
+		uint32_t RunCount = RunEnd - RunBegin;
+		uint32_t BatchBegin = 0;
+		while (BatchBegin < RunCount)
+		{
+			uint32_t Mesh = static_cast<uint32_t>(mRun[BatchBegin] >> 32);
+			uint32_t BatchEnd = BatchBegin + 1;
+			while (BatchEnd < RunCount && BatchEnd - BatchBegin < mSettings.MaxBatchSize &&
+				static_cast<uint32_t>(mRun[BatchEnd] >> 32) == Mesh)
+			{
+				++BatchEnd;
+			}
+
+			uint32_t FirstInstance = Written;
+			for (uint32_t i = BatchBegin; i < BatchEnd; ++i)
+			{
+				const DrawPacket& Draw = Draws[static_cast<uint32_t>(mRun[i])];
+				memcpy(Upload.Cpu + static_cast<size_t>(Written) * Stride, InstanceData + static_cast<size_t>(Draw.Instance) * Stride, Stride);
+				++Written;
+			}
+
+			if (mStats.DrawsIssued == 0 || Mesh != BoundMesh)
+			{
+				CommandList.SetMesh(Mesh);
+				BoundMesh = Mesh;
+			}
+			CommandList.SetGraphicsRootShaderResourceView(mSettings.InstanceDataRootParameter,
+				Upload.GpuAddress + static_cast<uint64_t>(FirstInstance) * Stride);
+
+			const MeshDrawArgs& Args = Meshes[Mesh];
+			CommandList.DrawIndexedInstanced(Args.IndexCount, BatchEnd - BatchBegin, Args.StartIndex, Args.BaseVertex, 0);
+			++mStats.DrawsIssued;
+
+			BatchBegin = BatchEnd;
+		}
+
+		RunBegin = RunEnd;
+	}
+	Check(Written == Count);
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "DrawPacket.h"
+
+class IRenderCommandList;
+class UploadRing;
+
+struct InstanceBatcherSettings
+{
+	uint32_t MaxBatchSize = 256;				//Instances per draw
+	uint32_t InstanceDataStride = 64;			//Bytes of per object data each instance uploads
+	uint32_t InstanceDataRootParameter = 0;		//Root SRV the shaders read instances from
+	uint32_t MaterialRootParameter = 1;			//Descriptor table
+};
+
+//Index range of a mesh in its buffers, indexed by DrawPacket::Mesh
+struct MeshDrawArgs
+{
+	uint32_t IndexCount;
+	uint32_t StartIndex;
+	int32_t BaseVertex;
+};
+
+struct InstanceBatcherStats
+{
+	uint32_t DrawsRequested = 0;
+	uint32_t DrawsIssued = 0;
+	uint64_t InstanceDataBytes = 0;
+};
+
+//Records sorted draws as instanced draws, merging draws with the same mesh,
+//material and pipeline state in to one of up to MaxBatchSize instances.
+//
+//Each draw's per object data - InstanceDataStride bytes at its Instance - is
+//copied to the upload ring in the order the instances are drawn, and each
+//batch points a root SRV at its first instance so shaders index it with
+//SV_InstanceID (which doesn't include StartInstanceLocation).
+//
+//Opaque draws with the same state are regrouped by mesh, giving up depth
+//order between meshes for fewer draws. Transparent draws only merge with
+//the draws next to them, so they stay back to front.
+//Pipeline state, root signature, material table and mesh are set only when
+//they change from the batch before.
+class InstanceBatcher
+{
+public:
+	InstanceBatcher(const InstanceBatcherSettings& Settings);
+	~InstanceBatcher();
+
+	//Draws in key order, e.g. from a sorted DrawQueue. InstanceData holds
+	//InstanceDataStride bytes for every instance id the draws use.
+	void Record(const DrawPacket* Draws, uint32_t Count, const MeshDrawArgs* Meshes, const uint8_t* InstanceData,
+		UploadRing& Ring, IRenderCommandList& CommandList);
+
+	//Of the last Record()
+	const InstanceBatcherStats& GetLastStats() const { return mStats; }
+
+	const InstanceBatcherSettings& GetSettings() const { return mSettings; }
+
+private:
+	InstanceBatcherSettings mSettings;
+	InstanceBatcherStats mStats;
+
+	//Mesh in the top half, draw index below, for one run of draws with the same state
+	std::vector<uint64_t> mRun;
+};
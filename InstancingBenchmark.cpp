@@ -0,0 +1,362 @@
+#include "InstancingBenchmark.h"
+#include "Common.h"
+#include "DrawQueue.h"
+#include "InstanceBatcher.h"
+#include "RenderCommandList.h"
+#include "SimulatedFence.h"
+#include "StandInCommandList.h"
+#include "UploadRing.h"
+#include "VectorMath.h"
+
+#include <chrono>
+#include <random>
+#include <stdio.h>
+#include <string.h>
+
+namespace
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	double MillisecondsSince(Clock::time_point Start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - Start).count();
+	}
+
+	const uint32_t OpaquePass = 0;
+	const uint32_t TransparentPass = 1;
+
+	const float WorldSize = 1000.0f;
+	const uint64_t RingGpuAddress = 0x100000000ull;
+
+	struct SceneDraw
+	{
+		DrawPacket Packet;
+		Float3 Position;
+	};
+
+	//Every draw is a copy of a prototype, so draws share meshes and materials
+	//the way placed props and foliage do
+	std::vector<SceneDraw> MakeScene(const InstancingBenchmarkSettings& Settings, uint32_t DrawCount)
+	{
+		std::mt19937 Random(1234);
+		std::uniform_real_distribution<float> Position(-WorldSize, WorldSize);
+		std::uniform_real_distribution<float> Unit(0.0f, 1.0f);
+		std::uniform_int_distribution<uint32_t> Material(0, Settings.MaterialCount - 1);
+		std::uniform_int_distribution<uint32_t> Mesh(0, Settings.MeshCount - 1);
+		std::uniform_int_distribution<uint32_t> Prototype(0, Settings.PrototypeCount - 1);
+
+		uint32_t StatesPerRootSignature = (Settings.PipelineStateCount + Settings.RootSignatureCount - 1) / Settings.RootSignatureCount;
+
+		std::vector<DrawPacket> Prototypes(Settings.PrototypeCount);
+		for (DrawPacket& Packet : Prototypes)
+		{
+			Packet = DrawPacket();
+			Packet.Pass = Unit(Random) < Settings.TransparentFraction ? TransparentPass : OpaquePass;
+			Packet.Material = Material(Random);
+			Packet.PipelineState = Packet.Material % Settings.PipelineStateCount;
+			Packet.RootSignature = Packet.PipelineState / StatesPerRootSignature;
+			Packet.Mesh = Mesh(Random);
+		}
+
+		std::vector<SceneDraw> Scene(DrawCount);
+		for (uint32_t i = 0; i < DrawCount; ++i)
+		{
+			Scene[i].Packet = Prototypes[Prototype(Random)];
+			Scene[i].Packet.Instance = i;
+			Scene[i].Position = MakeFloat3(Position(Random), Position(Random), Position(Random));
+		}
+		return Scene;
+	}
+
+	void FillQueue(const std::vector<SceneDraw>& Scene, uint32_t Frame, uint32_t FrameCount, DrawQueue& Queue)
+	{
+		float Angle = 6.2831853f * static_cast<float>(Frame) / static_cast<float>(FrameCount);
+		Float3 Eye = MakeFloat3(sinf(Angle) * WorldSize, 0.0f, cosf(Angle) * WorldSize);
+
+		Queue.Clear();
+		for (const SceneDraw& Draw : Scene)
+		{
+			DrawPacket Packet = Draw.Packet;
+			Packet.Depth = Length(Draw.Position - Eye);
+			Queue.Add(Packet, Packet.Pass == TransparentPass ? DrawSortMode::Transparent : DrawSortMode::Opaque);
+		}
+	}
+
+	//Plays the part of the GPU: reads back each instance a draw uploaded and
+	//checks it against the state bound when it's drawn
+	class VerifyingCommandList : public IRenderCommandList
+	{
+	public:
+		VerifyingCommandList(const std::vector<SceneDraw>& Scene, const MeshDrawArgs* Meshes, const uint8_t* RingMemory,
+			const InstanceBatcherSettings& Settings)
+			: mScene(Scene), mMeshes(Meshes), mRingMemory(RingMemory), mSettings(Settings)
+			, mPipelineState(~0u), mRootSignature(~0u), mTable(~0u), mMesh(~0u), mInstanceData(0), mDrawCalls(0), mErrors(0)
+			, mDrawn(Scene.size(), 0)
+		{}
+
+		void SetPipelineState(uint32_t PipelineState) override { mPipelineState = PipelineState; }
+		void SetGraphicsRootSignature(uint32_t RootSignature) override
+		{
+			mRootSignature = RootSignature;
+			mTable = ~0u;
+			mInstanceData = 0;
+		}
+		void SetGraphicsRootDescriptorTable(uint32_t RootParameter, uint32_t Table) override
+		{
+			Check(RootParameter == mSettings.MaterialRootParameter);
+			mTable = Table;
+		}
+		void SetGraphicsRootShaderResourceView(uint32_t RootParameter, uint64_t GpuAddress) override
+		{
+			Check(RootParameter == mSettings.InstanceDataRootParameter);
+			mInstanceData = GpuAddress;
+		}
+		void SetMesh(uint32_t Mesh) override { mMesh = Mesh; }
+		void SetViewport(const RenderViewport&) override {}
+		void SetRenderTargets(uint32_t, const uint64_t*, uint64_t) override {}
+		void ResourceBarrier(uint32_t, RenderResourceState, RenderResourceState) override {}
+		void CopyBufferRegion(uint32_t, uint64_t, uint32_t, uint64_t, uint64_t) override {}
+
+		void DrawIndexedInstanced(uint32_t IndexCountPerInstance, uint32_t InstanceCount, uint32_t StartIndexLocation,
+			int32_t BaseVertexLocation, uint32_t StartInstanceLocation) override
+		{
+			++mDrawCalls;
+			const MeshDrawArgs& Args = mMeshes[mMesh];
+			bool bValid = mInstanceData >= RingGpuAddress && InstanceCount > 0 && InstanceCount <= mSettings.MaxBatchSize &&
+				IndexCountPerInstance == Args.IndexCount && StartIndexLocation == Args.StartIndex &&
+				BaseVertexLocation == Args.BaseVertex && StartInstanceLocation == 0;
+
+			const uint8_t* Instances = mRingMemory + (mInstanceData - RingGpuAddress);
+			for (uint32_t i = 0; i < InstanceCount && bValid; ++i)
+			{
+				uint32_t Id;
+				memcpy(&Id, Instances + static_cast<size_t>(i) * mSettings.InstanceDataStride, sizeof(Id));
+				bValid = Id < mScene.size() && mDrawn[Id] == 0;
+				if (bValid)
+				{
+					const DrawPacket& Packet = mScene[Id].Packet;
+					bValid = Packet.Mesh == mMesh && Packet.Material == mTable && Packet.PipelineState == mPipelineState &&
+						Packet.RootSignature == mRootSignature;
+					mDrawn[Id] = 1;
+					if (Packet.Pass == TransparentPass)
+					{
+						mTransparentOrder.push_back(Id);
+					}
+				}
+			}
+			mErrors += bValid ? 0 : 1;
+		}
+
+		bool Finish(const DrawQueue& Queue, uint32_t DrawsIssued)
+		{
+			std::vector<uint32_t> Expected;
+			for (uint32_t i = 0; i < Queue.GetCount(); ++i)
+			{
+				if (Queue.GetDraws()[i].Pass == TransparentPass)
+				{
+					Expected.push_back(Queue.GetDraws()[i].Instance);
+				}
+			}
+			for (uint8_t bDrawn : mDrawn)
+			{
+				mErrors += bDrawn ? 0 : 1;
+			}
+			return mErrors == 0 && mDrawCalls == DrawsIssued && Expected == mTransparentOrder;
+		}
+
+	private:
+		const std::vector<SceneDraw>& mScene;
+		const MeshDrawArgs* mMeshes;
+		const uint8_t* mRingMemory;
+		InstanceBatcherSettings mSettings;
+
+		uint32_t mPipelineState;
+		uint32_t mRootSignature;
+		uint32_t mTable;
+		uint32_t mMesh;
+		uint64_t mInstanceData;
+		uint32_t mDrawCalls;
+		uint32_t mErrors;
+
+		std::vector<uint8_t> mDrawn;
+		std::vector<uint32_t> mTransparentOrder;
+	};
+}
+
+InstancingBenchmark::InstancingBenchmark(const InstancingBenchmarkSettings& Settings)
+	: mSettings(Settings)
+{
+	Assert(mSettings.Frames > 0);
+}
+
+InstancingBenchmark::~InstancingBenchmark()
+{}
+
+bool InstancingBenchmark::Run()
+{
+	mResults.clear();
+	if (mSettings.PipelineStateCount == 0 || mSettings.PipelineStateCount > (1u << DrawSortPipelineStateBits) ||
+		mSettings.MaterialCount == 0 || mSettings.MaterialCount > (1u << DrawSortMaterialBits) ||
+		mSettings.RootSignatureCount == 0 || mSettings.RootSignatureCount > mSettings.PipelineStateCount ||
+		mSettings.MeshCount == 0 || mSettings.PrototypeCount == 0)
+	{
+		mLastError = "Pipeline state, root signature, material, mesh and prototype counts must be above 0 and fit the sort key";
+		return false;
+	}
+	if (mSettings.InstanceDataStride < sizeof(uint32_t) || (mSettings.InstanceDataStride & 3) != 0)
+	{
+		mLastError = "Instance data stride must be a multiple of 4 bytes";
+		return false;
+	}
+	for (uint32_t BatchSize : mSettings.BatchSizes)
+	{
+		if (BatchSize == 0)
+		{
+			mLastError = "Batch sizes must be above 0";
+			return false;
+		}
+	}
+
+	for (uint32_t DrawCount : mSettings.DrawCounts)
+	{
+		if (DrawCount == 0 || !RunDrawCount(DrawCount))
+		{
+			if (mLastError.empty())
+			{
+				mLastError = "Draw counts must be above 0";
+			}
+			return false;
+		}
+	}
+	return true;
+}
+
+bool InstancingBenchmark::RunDrawCount(uint32_t DrawCount)
+{
+	std::vector<SceneDraw> Scene = MakeScene(mSettings, DrawCount);
+
+	std::vector<MeshDrawArgs> Meshes(mSettings.MeshCount);
+	uint32_t StartIndex = 0;
+	for (uint32_t Mesh = 0; Mesh < mSettings.MeshCount; ++Mesh)
+	{
+		Meshes[Mesh].IndexCount = 36 + 6 * (Mesh % 64);
+		Meshes[Mesh].StartIndex = StartIndex;
+		Meshes[Mesh].BaseVertex = static_cast<int32_t>(Mesh * 1024);
+		StartIndex += Meshes[Mesh].IndexCount;
+	}
+
+	//Each object's data starts with its id, for verification
+	const uint32_t Stride = mSettings.InstanceDataStride;
+	std::vector<uint8_t> InstanceData(static_cast<size_t>(DrawCount) * Stride);
+	for (uint32_t i = 0; i < DrawCount; ++i)
+	{
+		uint8_t* Data = &InstanceData[static_cast<size_t>(i) * Stride];
+		memset(Data, static_cast<int>(i & 0xFF), Stride);
+		memcpy(Data, &i, sizeof(i));
+	}
+
+	DrawQueue Queue;
+	Queue.Reserve(DrawCount);
+
+	StandInCommandListLimits Limits;
+	Limits.MeshCount = mSettings.MeshCount;
+	StandInCommandList CommandList(Limits);
+
+	//Room for three frames in flight
+	const uint64_t FrameBytes = static_cast<uint64_t>(DrawCount) * Stride + UploadRing::DefaultAlignment;
+	std::vector<uint8_t> RingMemory(static_cast<size_t>(FrameBytes * 3));
+
+	for (uint32_t BatchSize : mSettings.BatchSizes)
+	{
+		InstanceBatcherSettings BatcherSettings;
+		BatcherSettings.MaxBatchSize = BatchSize;
+		BatcherSettings.InstanceDataStride = Stride;
+		InstanceBatcher Batcher(BatcherSettings);
+
+		SimulatedFence Fence;
+		UploadRing Ring(&Fence, RingMemory.data(), RingGpuAddress, RingMemory.size());
+
+		InstancingBenchmarkResult Result;
+		Result.DrawCount = DrawCount;
+		Result.BatchSize = BatchSize;
+
+		double Milliseconds = 0.0;
+		uint64_t DrawsIssued = 0;
+		uint64_t Calls = 0;
+		uint64_t CommandBytes = 0;
+		for (uint32_t Frame = 0; Frame < mSettings.Frames; ++Frame)
+		{
+			FillQueue(Scene, Frame, mSettings.Frames, Queue);
+			Queue.Sort();
+
+			CommandList.Reset();
+			auto Start = Clock::now();
+			Batcher.Record(Queue.GetDraws(), Queue.GetCount(), Meshes.data(), InstanceData.data(), Ring, CommandList);
+			Milliseconds += MillisecondsSince(Start);
+
+			const InstanceBatcherStats& Stats = Batcher.GetLastStats();
+			DrawsIssued += Stats.DrawsIssued;
+			Calls += CommandList.GetTotalCallCount();
+			CommandBytes += CommandList.GetRecordedBytes();
+
+			if (Frame == 0)
+			{
+				SimulatedFence CheckFence;
+				UploadRing CheckRing(&CheckFence, RingMemory.data(), RingGpuAddress, RingMemory.size());
+				VerifyingCommandList Verifier(Scene, Meshes.data(), RingMemory.data(), BatcherSettings);
+				Batcher.Record(Queue.GetDraws(), Queue.GetCount(), Meshes.data(), InstanceData.data(), CheckRing, Verifier);
+				if (!Verifier.Finish(Queue, Batcher.GetLastStats().DrawsIssued) ||
+					CommandList.GetCallCount(RenderCommandType::DrawIndexedInstanced) != Stats.DrawsIssued)
+				{
+					char Error[128];
+					snprintf(Error, sizeof(Error), "Instanced draws don't match the draws requested with %u draws, batches of %u",
+						DrawCount, BatchSize);
+					mLastError = Error;
+					return false;
+				}
+			}
+
+			//The GPU finishes each frame as the next is recorded
+			Ring.EndFrame();
+			Fence.Signal();
+			Fence.AdvanceTo(Fence.GetLastSignalledValue() - 1);
+		}
+
+		Result.MillisecondsPerFrame = Milliseconds / mSettings.Frames;
+		Result.DrawsRequested = DrawCount;
+		Result.DrawsIssued = static_cast<uint32_t>(DrawsIssued / mSettings.Frames);
+		Result.Calls = static_cast<uint32_t>(Calls / mSettings.Frames);
+		Result.CommandBytes = CommandBytes / mSettings.Frames;
+		Result.RingStalls = Ring.GetStallCount();
+		mResults.push_back(Result);
+	}
+	return true;
+}
+
+bool InstancingBenchmark::WriteReport(const char* Filename) const
+{
+	FILE* File = fopen(Filename, "w");
+	if (!File)
+	{
+		return false;
+	}
+
+	fprintf(File, "Frames:          %u\n", mSettings.Frames);
+	fprintf(File, "Prototypes:      %u\n", mSettings.PrototypeCount);
+	fprintf(File, "Pipeline states: %u\n", mSettings.PipelineStateCount);
+	fprintf(File, "Materials:       %u\n", mSettings.MaterialCount);
+	fprintf(File, "Meshes:          %u\n", mSettings.MeshCount);
+	fprintf(File, "Instance stride: %u\n", mSettings.InstanceDataStride);
+	fprintf(File, "Transparent:     %.0f%%\n\n", mSettings.TransparentFraction * 100.0f);
+
+	fprintf(File, "Draws,BatchSize,MsPerFrame,DrawsRequested,DrawsIssued,Calls,CommandBytes,RingStalls\n");
+	for (const InstancingBenchmarkResult& Result : mResults)
+	{
+		fprintf(File, "%u,%u,%.3f,%u,%u,%u,%llu,%llu\n", Result.DrawCount, Result.BatchSize, Result.MillisecondsPerFrame,
+			Result.DrawsRequested, Result.DrawsIssued, Result.Calls, static_cast<unsigned long long>(Result.CommandBytes),
+			static_cast<unsigned long long>(Result.RingStalls));
+	}
+
+	fclose(File);
+	return true;
+}
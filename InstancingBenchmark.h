@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//Recording cost of each of DrawCounts draws through InstanceBatcher at each
+//of BatchSizes, against a recording stand-in command list. A batch size of 1
+//records one draw per object - the cost without instancing.
+//
+//The draws are copies of PrototypeCount objects (a mesh and a material) in a
+//random scene with a TransparentFraction of transparent materials. Each frame
+//is sorted by DrawQueue before recording; only recording is timed. Instance
+//data goes through an UploadRing on a simulated fence one frame behind.
+//Run() fails if any draw isn't drawn exactly once, with its own state and
+//instance data, or transparent draws lose their order.
+struct InstancingBenchmarkSettings
+{
+	std::vector<uint32_t> DrawCounts = { 10000, 100000 };
+	std::vector<uint32_t> BatchSizes = { 1, 16, 64, 256 };
+	uint32_t Frames = 20;
+	uint32_t PrototypeCount = 2000;
+	uint32_t PipelineStateCount = 64;
+	uint32_t RootSignatureCount = 8;
+	uint32_t MaterialCount = 1024;
+	uint32_t MeshCount = 256;
+	uint32_t InstanceDataStride = 64;
+	float TransparentFraction = 0.1f;
+};
+
+struct InstancingBenchmarkResult
+{
+	uint32_t DrawCount = 0;
+	uint32_t BatchSize = 0;
+	double MillisecondsPerFrame = 0.0;
+	uint32_t DrawsRequested = 0;		//Per frame
+	uint32_t DrawsIssued = 0;
+	uint32_t Calls = 0;
+	uint64_t CommandBytes = 0;
+	uint64_t RingStalls = 0;			//Whole run
+};
+
+class InstancingBenchmark
+{
+public:
+	InstancingBenchmark(const InstancingBenchmarkSettings& Settings);
+	~InstancingBenchmark();
+
+	bool Run();
+	bool WriteReport(const char* Filename) const;
+
+	const std::string& GetLastError() const { return mLastError; }
+
+private:
+	bool RunDrawCount(uint32_t DrawCount);
+
+private:
+	InstancingBenchmarkSettings mSettings;
+	std::vector<InstancingBenchmarkResult> mResults;
+
+	std::string mLastError;
+};
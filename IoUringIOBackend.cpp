@@ -0,0 +1,317 @@
+#include "IoUringIOBackend.h"
+
+#if defined(__linux__)
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstring>
+
+namespace
+{
+	int IoUringSetup(unsigned Entries, io_uring_params* Params)
+	{
+		return static_cast<int>(syscall(__NR_io_uring_setup, Entries, Params));
+	}
+
+	int IoUringEnter(int Fd, unsigned ToSubmit, unsigned MinComplete, unsigned Flags)
+	{
+		return static_cast<int>(syscall(__NR_io_uring_enter, Fd, ToSubmit, MinComplete, Flags, nullptr, 0));
+	}
+
+	int IoUringRegister(int Fd, unsigned Opcode, void* Arg, unsigned ArgCount)
+	{
+		return static_cast<int>(syscall(__NR_io_uring_register, Fd, Opcode, Arg, ArgCount));
+	}
+
+	//Ring indices are shared with the kernel - acquire what it wrote, release what we write
+	inline unsigned LoadAcquire(const unsigned* Value)
+	{
+		return __atomic_load_n(Value, __ATOMIC_ACQUIRE);
+	}
+
+	inline void StoreRelease(unsigned* Value, unsigned NewValue)
+	{
+		__atomic_store_n(Value, NewValue, __ATOMIC_RELEASE);
+	}
+
+	template<typename T>
+	T* RingPtr(void* Ring, uint32_t Offset)
+	{
+		return reinterpret_cast<T*>(static_cast<uint8_t*>(Ring) + Offset);
+	}
+}
+
+IoUringIOBackend::IoUringIOBackend()
+	: mRingFd(-1), mSqRing(nullptr), mSqRingSize(0), mCqRing(nullptr), mCqRingSize(0),
+	mSqes(nullptr), mSqesSize(0), mSqHead(nullptr), mSqTail(nullptr), mSqMask(nullptr),
+	mSqArray(nullptr), mCqHead(nullptr), mCqTail(nullptr), mCqMask(nullptr), mCqes(nullptr),
+	mPendingSubmit(0), mFailed(false)
+{}
+
+IoUringIOBackend::~IoUringIOBackend()
+{
+	if (mSqes)
+	{
+		munmap(mSqes, mSqesSize);
+	}
+	if (mCqRing && mCqRing != mSqRing)
+	{
+		munmap(mCqRing, mCqRingSize);
+	}
+	if (mSqRing)
+	{
+		munmap(mSqRing, mSqRingSize);
+	}
+	if (mRingFd >= 0)
+	{
+		close(mRingFd);
+	}
+}
+
+IoUringIOBackend* IoUringIOBackend::Create(uint32_t MaxInFlight)
+{
+	IoUringIOBackend* Backend = new IoUringIOBackend();
+
+	//+1 so a Wake() NOP always has room next to a full set of reads
+	if (!Backend->Init(MaxInFlight + 1))
+	{
+		delete Backend;
+		return nullptr;
+	}
+	return Backend;
+}
+
+bool IoUringIOBackend::Init(uint32_t Entries)
+{
+	io_uring_params Params;
+	memset(&Params, 0, sizeof(Params));
+
+	mRingFd = IoUringSetup(Entries, &Params);
+	if (mRingFd < 0)
+	{
+		return false;
+	}
+
+	//IORING_OP_READ arrived in 5.6 - ask rather than guess from the version
+	const unsigned ProbeOps = 256;
+	size_t ProbeSize = sizeof(io_uring_probe) + ProbeOps * sizeof(io_uring_probe_op);
+	uint8_t ProbeStorage[sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op)];
+	memset(ProbeStorage, 0, ProbeSize);
+	io_uring_probe* Probe = reinterpret_cast<io_uring_probe*>(ProbeStorage);
+	if (IoUringRegister(mRingFd, IORING_REGISTER_PROBE, Probe, ProbeOps) < 0 ||
+		Probe->last_op < IORING_OP_READ || !(Probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED))
+	{
+		return false;
+	}
+
+	mSqRingSize = Params.sq_off.array + Params.sq_entries * sizeof(unsigned);
+	mCqRingSize = Params.cq_off.cqes + Params.cq_entries * sizeof(io_uring_cqe);
+
+	bool bSingleMmap = (Params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+	if (bSingleMmap)
+	{
+		mSqRingSize = mCqRingSize = (mSqRingSize > mCqRingSize) ? mSqRingSize : mCqRingSize;
+	}
+
+	mSqRing = mmap(nullptr, mSqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRingFd, IORING_OFF_SQ_RING);
+	if (mSqRing == MAP_FAILED)
+	{
+		mSqRing = nullptr;
+		return false;
+	}
+
+	if (bSingleMmap)
+	{
+		mCqRing = mSqRing;
+	}
+	else
+	{
+		mCqRing = mmap(nullptr, mCqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRingFd, IORING_OFF_CQ_RING);
+		if (mCqRing == MAP_FAILED)
+		{
+			mCqRing = nullptr;
+			return false;
+		}
+	}
+
+	mSqesSize = Params.sq_entries * sizeof(io_uring_sqe);
+	void* Sqes = mmap(nullptr, mSqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRingFd, IORING_OFF_SQES);
+	if (Sqes == MAP_FAILED)
+	{
+		return false;
+	}
+	mSqes = static_cast<io_uring_sqe*>(Sqes);
+
+	mSqHead = RingPtr<unsigned>(mSqRing, Params.sq_off.head);
+	mSqTail = RingPtr<unsigned>(mSqRing, Params.sq_off.tail);
+	mSqMask = RingPtr<unsigned>(mSqRing, Params.sq_off.ring_mask);
+	mSqArray = RingPtr<unsigned>(mSqRing, Params.sq_off.array);
+	mCqHead = RingPtr<unsigned>(mCqRing, Params.cq_off.head);
+	mCqTail = RingPtr<unsigned>(mCqRing, Params.cq_off.tail);
+	mCqMask = RingPtr<unsigned>(mCqRing, Params.cq_off.ring_mask);
+	mCqes = RingPtr<io_uring_cqe>(mCqRing, Params.cq_off.cqes);
+
+	return true;
+}
+
+uint32_t IoUringIOBackend::GetFreeSqes() const
+{
+	//Only this thread moves the tail, the kernel moves the head
+	unsigned Head = LoadAcquire(mSqHead);
+	return *mSqMask + 1 - (*mSqTail - Head);
+}
+
+io_uring_sqe* IoUringIOBackend::PrepareSqe(uint32_t Offset)
+{
+	unsigned Index = (*mSqTail + Offset) & *mSqMask;
+	io_uring_sqe* Sqe = &mSqes[Index];
+	memset(Sqe, 0, sizeof(*Sqe));
+	mSqArray[Index] = Index;
+	return Sqe;
+}
+
+void IoUringIOBackend::PublishSqes(uint32_t Count)
+{
+	//One release store makes the whole batch visible at once
+	StoreRelease(mSqTail, *mSqTail + Count);
+	mPendingSubmit += Count;
+}
+
+void IoUringIOBackend::Fail()
+{
+	//With no SQ poll thread the kernel only takes entries when this thread
+	//asks io_uring_enter to submit, so what it hasn't taken can be rewritten. Reads left there would land
+	//in buffers the queue is about to fail and reuse - make them wake NOPs.
+	unsigned Tail = *mSqTail;
+	for (unsigned Head = LoadAcquire(mSqHead); Head != Tail; ++Head)
+	{
+		io_uring_sqe* Sqe = &mSqes[mSqArray[Head & *mSqMask]];
+		memset(Sqe, 0, sizeof(*Sqe));
+		Sqe->opcode = IORING_OP_NOP;
+		Sqe->user_data = AsyncIOWakeTag;
+	}
+	mFailed.store(true, std::memory_order_release);
+}
+
+bool IoUringIOBackend::Flush(uint32_t WaitCount)
+{
+	while (mPendingSubmit > 0 || WaitCount > 0)
+	{
+		int Result = IoUringEnter(mRingFd, mPendingSubmit, WaitCount, WaitCount > 0 ? IORING_ENTER_GETEVENTS : 0);
+		if (Result < 0)
+		{
+			if (errno == EINTR || errno == EAGAIN || errno == EBUSY)
+			{
+				continue;
+			}
+
+			//Entries are already published, so there's no handing them back
+			Fail();
+			return false;
+		}
+
+		mPendingSubmit -= static_cast<uint32_t>(Result) < mPendingSubmit ? static_cast<uint32_t>(Result) : mPendingSubmit;
+		if (WaitCount > 0)
+		{
+			break;
+		}
+	}
+	return true;
+}
+
+bool IoUringIOBackend::Submit(const AsyncIOBackendRead* Reads, uint32_t Count)
+{
+	if (mFailed.load(std::memory_order_acquire))
+	{
+		return false;
+	}
+
+	//The queue never has more than MaxInFlight reads out, so this only
+	//happens if the kernel hasn't consumed earlier entries yet. Nothing of
+	//this batch is published, so it can still be rejected cleanly.
+	if (GetFreeSqes() < Count && (!Flush(0) || GetFreeSqes() < Count))
+	{
+		return false;
+	}
+
+	//Fill every entry before the kernel can see any of them
+	for (uint32_t i = 0; i < Count; ++i)
+	{
+		io_uring_sqe* Sqe = PrepareSqe(i);
+		const AsyncIOBackendRead& Read = Reads[i];
+		Sqe->opcode = IORING_OP_READ;
+		Sqe->fd = static_cast<int>(Read.File);
+		Sqe->off = Read.Offset;
+		Sqe->addr = reinterpret_cast<uint64_t>(Read.Dest);
+		Sqe->len = Read.Size;
+		Sqe->user_data = Read.Tag;
+	}
+	PublishSqes(Count);
+
+	return Flush(0);
+}
+
+uint32_t IoUringIOBackend::WaitForCompletions(AsyncIOBackendCompletion* OutCompletions, uint32_t MaxCount)
+{
+	for (;;)
+	{
+		unsigned Head = *mCqHead;
+		unsigned Tail = LoadAcquire(mCqTail);
+
+		uint32_t Count = 0;
+		while (Head != Tail && Count < MaxCount)
+		{
+			const io_uring_cqe& Cqe = mCqes[Head & *mCqMask];
+			OutCompletions[Count].Tag = Cqe.user_data;
+			OutCompletions[Count].Result = Cqe.res;
+			++Count;
+			++Head;
+		}
+
+		if (Count > 0)
+		{
+			StoreRelease(mCqHead, Head);
+			return Count;
+		}
+
+		//A failed submission left the ring unusable - don't wait on it
+		if (mFailed.load(std::memory_order_acquire))
+		{
+			return 0;
+		}
+
+		//Nothing ready - block in the kernel for one. Submission happens on
+		//the other thread so nothing is passed here.
+		int Result = IoUringEnter(mRingFd, 0, 1, IORING_ENTER_GETEVENTS);
+		if (Result < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY)
+		{
+			//Ring is unusable - retrying would spin, so report the failure and
+			//let the queue fail what is in flight
+			return 0;
+		}
+	}
+}
+
+void IoUringIOBackend::Wake()
+{
+	//Still tried once failed - everything left in the ring is a NOP by then
+	if (GetFreeSqes() == 0)
+	{
+		Flush(0);
+	}
+	if (GetFreeSqes() > 0)
+	{
+		io_uring_sqe* Sqe = PrepareSqe(0);
+		Sqe->opcode = IORING_OP_NOP;
+		Sqe->user_data = AsyncIOWakeTag;
+		PublishSqes(1);
+		Flush(0);
+	}
+}
+
+#endif
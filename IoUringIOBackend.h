@@ -0,0 +1,66 @@
+#pragma once
+
+#include "AsyncIOBackend.h"
+
+#if defined(__linux__)
+
+#include <atomic>
+#include <cstddef>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+//Linux io_uring backend. Talks to the kernel through the raw syscalls and
+//the mmapped submission/completion rings, so no liburing dependency. Reads
+//are IORING_OP_READ, Wake() is a NOP tagged AsyncIOWakeTag.
+class IoUringIOBackend : public IAsyncIOBackend
+{
+public:
+	//Returns nullptr if the kernel lacks io_uring or IORING_OP_READ (or it
+	//is blocked by seccomp), in which case use the thread pool backend.
+	static IoUringIOBackend* Create(uint32_t MaxInFlight);
+	~IoUringIOBackend();
+
+	const char* GetName() const override { return "io_uring"; }
+
+	bool Submit(const AsyncIOBackendRead* Reads, uint32_t Count) override;
+	uint32_t WaitForCompletions(AsyncIOBackendCompletion* OutCompletions, uint32_t MaxCount) override;
+	void Wake() override;
+
+private:
+	IoUringIOBackend();
+	bool Init(uint32_t Entries);
+
+	//Sqes are filled past the tail and only then published together
+	uint32_t GetFreeSqes() const;
+	io_uring_sqe* PrepareSqe(uint32_t Offset);
+	void PublishSqes(uint32_t Count);
+	bool Flush(uint32_t WaitCount);
+
+	//Submitting published entries failed - nothing more is submitted or waited on
+	void Fail();
+
+private:
+	int mRingFd;
+
+	void* mSqRing;
+	size_t mSqRingSize;
+	void* mCqRing;
+	size_t mCqRingSize;
+	io_uring_sqe* mSqes;
+	size_t mSqesSize;
+
+	unsigned* mSqHead;
+	unsigned* mSqTail;
+	unsigned* mSqMask;
+	unsigned* mSqArray;
+	unsigned* mCqHead;
+	unsigned* mCqTail;
+	unsigned* mCqMask;
+	io_uring_cqe* mCqes;
+
+	uint32_t mPendingSubmit;	//Sqes published but not yet passed to io_uring_enter
+	std::atomic<bool> mFailed;	//Set on the submission thread, read on the completion thread
+};
+
+#endif
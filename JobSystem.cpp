@@ -0,0 +1,130 @@
+#include "JobSystem.h"
+#include "Common.h"
+
+#include <algorithm>
+
+JobSystem::JobSystem(uint32_t WorkerCount)
+	: mShutdown(false)
+{
+	if (WorkerCount == 0)
+	{
+		uint32_t HardwareThreads = std::thread::hardware_concurrency();
+		WorkerCount = HardwareThreads > 1 ? HardwareThreads - 1 : 1;
+	}
+
+	mWorkers.reserve(WorkerCount);
+	for (uint32_t i = 0; i < WorkerCount; ++i)
+	{
+		mWorkers.emplace_back(&JobSystem::WorkerMain, this);
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> Lock(mMutex);
+		mShutdown = true;
+	}
+	mWorkAvailable.notify_all();
+
+	for (std::thread& Worker : mWorkers)
+	{
+		Worker.join();
+	}
+
+	Assert(mQueue.empty());
+}
+
+void JobSystem::Submit(JobFunction Job, JobCounter* Counter)
+{
+	if (Counter)
+	{
+		Counter->mPending.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	{
+		std::lock_guard<std::mutex> Lock(mMutex);
+		mQueue.push_back({ std::move(Job), Counter });
+	}
+	mWorkAvailable.notify_one();
+}
+
+void JobSystem::Wait(JobCounter& Counter)
+{
+	while (!Counter.IsDone())
+	{
+		if (!TryRunOne())
+		{
+			//Nothing left to help with - the remaining jobs are running elsewhere
+			std::unique_lock<std::mutex> Lock(mMutex);
+			mJobFinished.wait(Lock, [&]() { return Counter.IsDone() || !mQueue.empty(); });
+		}
+	}
+}
+
+void JobSystem::ParallelFor(uint32_t Count, uint32_t BatchSize, const RangeFunction& Body)
+{
+	BatchSize = std::max(BatchSize, 1u);
+
+	JobCounter Counter;
+	for (uint32_t Begin = 0; Begin < Count; Begin += BatchSize)
+	{
+		uint32_t End = std::min(Count, Begin + BatchSize);
+		Submit([&Body, Begin, End]() { Body(Begin, End); }, &Counter);
+	}
+	Wait(Counter);
+}
+
+void JobSystem::WorkerMain()
+{
+	for (;;)
+	{
+		Job ToRun;
+		{
+			std::unique_lock<std::mutex> Lock(mMutex);
+			mWorkAvailable.wait(Lock, [this]() { return mShutdown || !mQueue.empty(); });
+
+			if (mQueue.empty())
+			{
+				return;
+			}
+
+			ToRun = std::move(mQueue.front());
+			mQueue.pop_front();
+		}
+
+		Run(ToRun);
+	}
+}
+
+bool JobSystem::TryRunOne()
+{
+	Job ToRun;
+	{
+		std::lock_guard<std::mutex> Lock(mMutex);
+		if (mQueue.empty())
+		{
+			return false;
+		}
+
+		ToRun = std::move(mQueue.front());
+		mQueue.pop_front();
+	}
+
+	Run(ToRun);
+	return true;
+}
+
+void JobSystem::Run(Job& ToRun)
+{
+	ToRun.Function();
+
+	if (ToRun.Counter)
+	{
+		//Decrement under the lock so a waiter can't check the counter and then
+		//sleep through the notify.
+		std::lock_guard<std::mutex> Lock(mMutex);
+		ToRun.Counter->mPending.fetch_sub(1, std::memory_order_release);
+	}
+	mJobFinished.notify_all();
+}
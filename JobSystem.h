@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//Counts outstanding jobs so a group of them can be waited on.
+class JobCounter
+{
+public:
+	JobCounter() : mPending(0) {}
+
+	bool IsDone() const { return mPending.load(std::memory_order_acquire) == 0; }
+
+private:
+	friend class JobSystem;
+	std::atomic<uint32_t> mPending;
+};
+
+//Fixed pool of worker threads pulling from one shared queue. Threads that wait
+//on a counter run queued jobs while they wait rather than blocking, so waiting
+//from inside a job can't deadlock the pool.
+class JobSystem
+{
+public:
+	typedef std::function<void()> JobFunction;
+	typedef std::function<void(uint32_t Begin, uint32_t End)> RangeFunction;
+
+	//WorkerCount 0 = one per hardware thread, less the calling thread.
+	JobSystem(uint32_t WorkerCount = 0);
+	~JobSystem();
+
+	void Submit(JobFunction Job, JobCounter* Counter = nullptr);
+	void Wait(JobCounter& Counter);
+
+	//Splits [0, Count) in to BatchSize chunks and blocks until all have run.
+	void ParallelFor(uint32_t Count, uint32_t BatchSize, const RangeFunction& Body);
+
+	uint32_t GetWorkerCount() const { return static_cast<uint32_t>(mWorkers.size()); }
+
+private:
+	struct Job
+	{
+		JobFunction Function;
+		JobCounter* Counter;
+	};
+
+	void WorkerMain();
+	bool TryRunOne();
+	void Run(Job& ToRun);
+
+private:
+	std::vector<std::thread> mWorkers;
+
+	std::mutex mMutex;
+	std::condition_variable mWorkAvailable;
+	std::condition_variable mJobFinished;
+	std::deque<Job> mQueue;
+	bool mShutdown;
+};
@@ -0,0 +1,137 @@
+#include "MappedFile.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(_WIN32)
+
+MappedFile::MappedFile()
+	: mFile(INVALID_HANDLE_VALUE), mMapping(nullptr), mData(nullptr), mSize(0)
+{}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+bool MappedFile::Open(const char* Filename)
+{
+	Close();
+
+	mFile = CreateFileA(Filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (mFile == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER FileSize;
+	if (!GetFileSizeEx(mFile, &FileSize) || FileSize.QuadPart == 0)
+	{
+		Close();
+		return false;
+	}
+
+	mMapping = CreateFileMappingA(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mMapping)
+	{
+		Close();
+		return false;
+	}
+
+	mData = static_cast<const uint8_t*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+	if (!mData)
+	{
+		Close();
+		return false;
+	}
+
+	mSize = static_cast<uint64_t>(FileSize.QuadPart);
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (mData)
+	{
+		UnmapViewOfFile(mData);
+		mData = nullptr;
+	}
+	if (mMapping)
+	{
+		CloseHandle(mMapping);
+		mMapping = nullptr;
+	}
+	if (mFile != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(mFile);
+		mFile = INVALID_HANDLE_VALUE;
+	}
+	mSize = 0;
+}
+
+#else
+
+MappedFile::MappedFile()
+	: mFile(-1), mData(nullptr), mSize(0)
+{}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+bool MappedFile::Open(const char* Filename)
+{
+	Close();
+
+	mFile = open(Filename, O_RDONLY);
+	if (mFile < 0)
+	{
+		return false;
+	}
+
+	struct stat FileStat;
+	if (fstat(mFile, &FileStat) != 0 || FileStat.st_size == 0)
+	{
+		Close();
+		return false;
+	}
+
+	void* Data = mmap(nullptr, static_cast<size_t>(FileStat.st_size), PROT_READ, MAP_PRIVATE, mFile, 0);
+	if (Data == MAP_FAILED)
+	{
+		Close();
+		return false;
+	}
+
+	//Whole file is about to be read front to back
+	madvise(Data, static_cast<size_t>(FileStat.st_size), MADV_SEQUENTIAL);
+
+	mData = static_cast<const uint8_t*>(Data);
+	mSize = static_cast<uint64_t>(FileStat.st_size);
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (mData)
+	{
+		munmap(const_cast<uint8_t*>(mData), static_cast<size_t>(mSize));
+		mData = nullptr;
+	}
+	if (mFile >= 0)
+	{
+		close(mFile);
+		mFile = -1;
+	}
+	mSize = 0;
+}
+
+#endif
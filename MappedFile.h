@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+
+//Read only memory mapped file. The OS pages data in on first touch, so opening
+//is cheap and nothing is copied in to our own heap - data can go straight from
+//the page cache in to an upload buffer.
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	bool Open(const char* Filename);
+	void Close();
+
+	bool IsOpen() const { return mData != nullptr; }
+	const uint8_t* GetData() const { return mData; }
+	uint64_t GetSize() const { return mSize; }
+
+private:
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+private:
+#if defined(_WIN32)
+	void* mFile;		//HANDLE
+	void* mMapping;		//HANDLE
+#else
+	int mFile;
+#endif
+
+	const uint8_t* mData;
+	uint64_t mSize;
+};
@@ -0,0 +1,338 @@
+#include "MathBenchmark.h"
+#include "Common.h"
+#include "VectorMath.h"
+
+#include <chrono>
+#include <random>
+#include <stdio.h>
+
+namespace
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	double MillisecondsSince(Clock::time_point Start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - Start).count();
+	}
+
+	//Arrays of Count floats in one allocation. Streams a power of two apart
+	//all map to the same cache sets, so each is padded by a cache line.
+	struct SoaStreams
+	{
+		std::vector<float> Data;
+		uint32_t Count;
+		uint32_t Stride;
+
+		SoaStreams(uint32_t StreamCount, uint32_t InCount)
+			: Count(InCount), Stride(((InCount + 15) & ~15u) + 16)
+		{
+			Data.resize(static_cast<size_t>(StreamCount) * Stride);
+		}
+
+		float* Get(uint32_t Stream) { return &Data[static_cast<size_t>(Stream) * Stride]; }
+		const float* Get(uint32_t Stream) const { return &Data[static_cast<size_t>(Stream) * Stride]; }
+	};
+
+	Matrix3x4 RandomMatrix(std::mt19937& Random)
+	{
+		std::uniform_real_distribution<float> Unit(-1.0f, 1.0f);
+		Float3 Axis = Normalize(MakeFloat3(Unit(Random), Unit(Random), Unit(Random) + 2.0f));
+		return MatrixFromTrs(MakeFloat3(Unit(Random) * 10.0f, Unit(Random) * 10.0f, Unit(Random) * 10.0f),
+			QuaternionFromAxisAngle(Axis, Unit(Random) * 3.0f), 1.0f + Unit(Random) * 0.5f);
+	}
+
+	void StoreMatrix(const Matrix3x4& M, SoaStreams& Streams, uint32_t Index)
+	{
+		for (uint32_t Element = 0; Element < 12; ++Element)
+		{
+			Streams.Get(Element)[Index] = M.Rows[Element / 4][Element % 4];
+		}
+	}
+
+	void GetStreamPointers(SoaStreams& Streams, float* Pointers[12])
+	{
+		for (uint32_t Element = 0; Element < 12; ++Element)
+		{
+			Pointers[Element] = Streams.Get(Element);
+		}
+	}
+
+	void GetStreamPointers(const SoaStreams& Streams, const float* Pointers[12])
+	{
+		for (uint32_t Element = 0; Element < 12; ++Element)
+		{
+			Pointers[Element] = Streams.Get(Element);
+		}
+	}
+
+	//[Begin, End) must be a multiple of V::Width
+	template<typename V>
+	void MultiplyStreams(const SoaStreams& A, const SoaStreams& B, SoaStreams& Out, uint32_t Begin, uint32_t End)
+	{
+		const float* InA[12];
+		const float* InB[12];
+		float* Result[12];
+		GetStreamPointers(A, InA);
+		GetStreamPointers(B, InB);
+		GetStreamPointers(Out, Result);
+
+		for (uint32_t i = Begin; i < End; i += V::Width)
+		{
+			Multiply(Matrix3x4Batch<V>::LoadUnaligned(InA, i), Matrix3x4Batch<V>::LoadUnaligned(InB, i)).StoreUnaligned(Result, i);
+		}
+	}
+
+	template<typename V>
+	void TransformAabbStreams(const SoaStreams& Matrices, const SoaStreams& Boxes, SoaStreams& Out, uint32_t Begin, uint32_t End)
+	{
+		const float* InMatrices[12];
+		GetStreamPointers(Matrices, InMatrices);
+
+		for (uint32_t i = Begin; i < End; i += V::Width)
+		{
+			AabbBatch<V> Box;
+			Box.Min = Float3Batch<V>::LoadUnaligned(Boxes.Get(0), Boxes.Get(1), Boxes.Get(2), i);
+			Box.Max = Float3Batch<V>::LoadUnaligned(Boxes.Get(3), Boxes.Get(4), Boxes.Get(5), i);
+
+			AabbBatch<V> Result = TransformAabb(Matrix3x4Batch<V>::LoadUnaligned(InMatrices, i), Box);
+			Result.Min.StoreUnaligned(Out.Get(0), Out.Get(1), Out.Get(2), i);
+			Result.Max.StoreUnaligned(Out.Get(3), Out.Get(4), Out.Get(5), i);
+		}
+	}
+
+	//Wide over as much as fits, scalar for the rest
+	template<typename V, typename Function>
+	void RunWide(uint32_t Count, Function&& Body)
+	{
+		uint32_t WideEnd = Count - Count % V::Width;
+		Body(V(), 0, WideEnd);
+		Body(SimdFloat1(), WideEnd, Count);
+	}
+}
+
+MathBenchmark::MathBenchmark(const MathBenchmarkSettings& Settings)
+	: mSettings(Settings)
+{
+	Assert(mSettings.Count > 0 && mSettings.Iterations > 0);
+}
+
+MathBenchmark::~MathBenchmark()
+{}
+
+bool MathBenchmark::Run()
+{
+	mResults.clear();
+	return RunTransformPoints() && RunMultiplyMatrices() && RunTransformAabbs();
+}
+
+bool MathBenchmark::RunTransformPoints()
+{
+	const uint32_t Count = mSettings.Count;
+	std::mt19937 Random(1234);
+	std::uniform_real_distribution<float> Unit(-100.0f, 100.0f);
+	Matrix3x4 M = RandomMatrix(Random);
+
+	std::vector<Float3> Points(Count);
+	SoaStreams Streams(3, Count);
+	for (uint32_t i = 0; i < Count; ++i)
+	{
+		Points[i] = MakeFloat3(Unit(Random), Unit(Random), Unit(Random));
+		Streams.Get(0)[i] = Points[i].X;
+		Streams.Get(1)[i] = Points[i].Y;
+		Streams.Get(2)[i] = Points[i].Z;
+	}
+
+	//AoS
+	std::vector<Float3> AosOut(Count);
+	auto Start = Clock::now();
+	for (uint32_t Pass = 0; Pass < mSettings.Iterations; ++Pass)
+	{
+		for (uint32_t i = 0; i < Count; ++i)
+		{
+			AosOut[i] = TransformPoint(M, Points[i]);
+		}
+	}
+	AddResult("TransformPoints", "AoS", MillisecondsSince(Start));
+
+	SoaStreams Expected(3, Count);
+	for (uint32_t i = 0; i < Count; ++i)
+	{
+		Expected.Get(0)[i] = AosOut[i].X;
+		Expected.Get(1)[i] = AosOut[i].Y;
+		Expected.Get(2)[i] = AosOut[i].Z;
+	}
+
+	SoaStreams Out(3, Count);
+	auto RunWidth = [&](auto Lanes, const char* Mode)
+	{
+		typedef decltype(Lanes) V;
+		auto WidthStart = Clock::now();
+		for (uint32_t Pass = 0; Pass < mSettings.Iterations; ++Pass)
+		{
+			TransformPoints<V>(M, Streams.Get(0), Streams.Get(1), Streams.Get(2), Out.Get(0), Out.Get(1), Out.Get(2), Count);
+		}
+		AddResult("TransformPoints", Mode, MillisecondsSince(WidthStart));
+		return CheckMatches("TransformPoints", Mode, Expected.Data, Out.Data);
+	};
+	return RunWidth(SimdFloat1(), "SoA x1") && RunWidth(SimdFloat4(), "SoA x4") && RunWidth(SimdFloat8(), "SoA x8");
+}
+
+bool MathBenchmark::RunMultiplyMatrices()
+{
+	const uint32_t Count = mSettings.Count;
+	std::mt19937 Random(5678);
+
+	std::vector<Matrix3x4> A(Count), B(Count);
+	SoaStreams StreamsA(12, Count), StreamsB(12, Count);
+	for (uint32_t i = 0; i < Count; ++i)
+	{
+		A[i] = RandomMatrix(Random);
+		B[i] = RandomMatrix(Random);
+		StoreMatrix(A[i], StreamsA, i);
+		StoreMatrix(B[i], StreamsB, i);
+	}
+
+	std::vector<Matrix3x4> AosOut(Count);
+	auto Start = Clock::now();
+	for (uint32_t Pass = 0; Pass < mSettings.Iterations; ++Pass)
+	{
+		for (uint32_t i = 0; i < Count; ++i)
+		{
+			AosOut[i] = Multiply(A[i], B[i]);
+		}
+	}
+	AddResult("MultiplyMatrices", "AoS", MillisecondsSince(Start));
+
+	SoaStreams Expected(12, Count);
+	for (uint32_t i = 0; i < Count; ++i)
+	{
+		StoreMatrix(AosOut[i], Expected, i);
+	}
+
+	SoaStreams Out(12, Count);
+	auto RunWidth = [&](auto Lanes, const char* Mode)
+	{
+		typedef decltype(Lanes) V;
+		auto WidthStart = Clock::now();
+		for (uint32_t Pass = 0; Pass < mSettings.Iterations; ++Pass)
+		{
+			RunWide<V>(Count, [&](auto Width, uint32_t Begin, uint32_t End)
+			{
+				MultiplyStreams<decltype(Width)>(StreamsA, StreamsB, Out, Begin, End);
+			});
+		}
+		AddResult("MultiplyMatrices", Mode, MillisecondsSince(WidthStart));
+		return CheckMatches("MultiplyMatrices", Mode, Expected.Data, Out.Data);
+	};
+	return RunWidth(SimdFloat1(), "SoA x1") && RunWidth(SimdFloat4(), "SoA x4") && RunWidth(SimdFloat8(), "SoA x8");
+}
+
+bool MathBenchmark::RunTransformAabbs()
+{
+	const uint32_t Count = mSettings.Count;
+	std::mt19937 Random(9012);
+	std::uniform_real_distribution<float> Unit(-100.0f, 100.0f);
+	std::uniform_real_distribution<float> Size(0.1f, 5.0f);
+
+	std::vector<Matrix3x4> Matrices(Count);
+	std::vector<Aabb> Boxes(Count);
+	SoaStreams MatrixStreams(12, Count), BoxStreams(6, Count);
+	for (uint32_t i = 0; i < Count; ++i)
+	{
+		Matrices[i] = RandomMatrix(Random);
+		StoreMatrix(Matrices[i], MatrixStreams, i);
+
+		Boxes[i].Min = MakeFloat3(Unit(Random), Unit(Random), Unit(Random));
+		Boxes[i].Max = Boxes[i].Min + MakeFloat3(Size(Random), Size(Random), Size(Random));
+		const float Values[6] = { Boxes[i].Min.X, Boxes[i].Min.Y, Boxes[i].Min.Z, Boxes[i].Max.X, Boxes[i].Max.Y, Boxes[i].Max.Z };
+		for (uint32_t Stream = 0; Stream < 6; ++Stream)
+		{
+			BoxStreams.Get(Stream)[i] = Values[Stream];
+		}
+	}
+
+	std::vector<Aabb> AosOut(Count);
+	auto Start = Clock::now();
+	for (uint32_t Pass = 0; Pass < mSettings.Iterations; ++Pass)
+	{
+		for (uint32_t i = 0; i < Count; ++i)
+		{
+			AosOut[i] = TransformAabb(Matrices[i], Boxes[i]);
+		}
+	}
+	AddResult("TransformAabbs", "AoS", MillisecondsSince(Start));
+
+	SoaStreams Expected(6, Count);
+	for (uint32_t i = 0; i < Count; ++i)
+	{
+		const float Values[6] = { AosOut[i].Min.X, AosOut[i].Min.Y, AosOut[i].Min.Z, AosOut[i].Max.X, AosOut[i].Max.Y, AosOut[i].Max.Z };
+		for (uint32_t Stream = 0; Stream < 6; ++Stream)
+		{
+			Expected.Get(Stream)[i] = Values[Stream];
+		}
+	}
+
+	SoaStreams Out(6, Count);
+	auto RunWidth = [&](auto Lanes, const char* Mode)
+	{
+		typedef decltype(Lanes) V;
+		auto WidthStart = Clock::now();
+		for (uint32_t Pass = 0; Pass < mSettings.Iterations; ++Pass)
+		{
+			RunWide<V>(Count, [&](auto Width, uint32_t Begin, uint32_t End)
+			{
+				TransformAabbStreams<decltype(Width)>(MatrixStreams, BoxStreams, Out, Begin, End);
+			});
+		}
+		AddResult("TransformAabbs", Mode, MillisecondsSince(WidthStart));
+		return CheckMatches("TransformAabbs", Mode, Expected.Data, Out.Data);
+	};
+	return RunWidth(SimdFloat1(), "SoA x1") && RunWidth(SimdFloat4(), "SoA x4") && RunWidth(SimdFloat8(), "SoA x8");
+}
+
+bool MathBenchmark::CheckMatches(const char* Case, const char* Mode, const std::vector<float>& Expected, const std::vector<float>& Actual)
+{
+	//Fused multiply-adds round differently, so close rather than identical
+	for (size_t i = 0; i < Expected.size(); ++i)
+	{
+		if (!(fabsf(Actual[i] - Expected[i]) <= 1e-4f * (1.0f + fabsf(Expected[i]))))
+		{
+			char Error[128];
+			snprintf(Error, sizeof(Error), "%s %s differs from AoS at %zu: %f, expected %f", Case, Mode, i, Actual[i], Expected[i]);
+			mLastError = Error;
+			return false;
+		}
+	}
+	return true;
+}
+
+void MathBenchmark::AddResult(const char* Case, const char* Mode, double Milliseconds)
+{
+	MathBenchmarkResult Result;
+	Result.Case = Case;
+	Result.Mode = Mode;
+	Result.MillisecondsPerPass = Milliseconds / mSettings.Iterations;
+	Result.ItemsPerMicrosecond = Result.MillisecondsPerPass > 0.0 ? mSettings.Count / (Result.MillisecondsPerPass * 1000.0) : 0.0;
+	mResults.push_back(Result);
+}
+
+bool MathBenchmark::WriteReport(const char* Filename) const
+{
+	FILE* File = fopen(Filename, "w");
+	if (!File)
+	{
+		return false;
+	}
+
+	fprintf(File, "Backend:     %s\n", GetSimdBackendName());
+	fprintf(File, "Count:       %u\n", mSettings.Count);
+	fprintf(File, "Iterations:  %u\n\n", mSettings.Iterations);
+	fprintf(File, "Case,Mode,MsPerPass,ItemsPerUs\n");
+	for (const MathBenchmarkResult& Result : mResults)
+	{
+		fprintf(File, "%s,%s,%.3f,%.1f\n", Result.Case.c_str(), Result.Mode.c_str(), Result.MillisecondsPerPass, Result.ItemsPerMicrosecond);
+	}
+
+	fclose(File);
+	return true;
+}
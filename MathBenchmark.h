@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//Throughput of the VectorMath hot loops over Count items:
+//	TransformPoints		- Count points through one matrix
+//	MultiplyMatrices	- Count pairs of 3x4 matrices
+//	TransformAabbs		- Count boxes, each through its own matrix
+//
+//Each runs as AoS (one value at a time on AoS types) and as SoA streams with
+//1, 4 and 8 lanes. Run() fails if the SoA results don't match AoS.
+struct MathBenchmarkSettings
+{
+	uint32_t Count = 1000000;
+	uint32_t Iterations = 20;
+};
+
+struct MathBenchmarkResult
+{
+	std::string Case;
+	std::string Mode;
+	double MillisecondsPerPass = 0.0;
+	double ItemsPerMicrosecond = 0.0;
+};
+
+class MathBenchmark
+{
+public:
+	MathBenchmark(const MathBenchmarkSettings& Settings);
+	~MathBenchmark();
+
+	bool Run();
+	bool WriteReport(const char* Filename) const;
+
+	const std::string& GetLastError() const { return mLastError; }
+
+private:
+	bool RunTransformPoints();
+	bool RunMultiplyMatrices();
+	bool RunTransformAabbs();
+
+	void AddResult(const char* Case, const char* Mode, double Milliseconds);
+
+	//Within tolerance of the AoS result, sets the error if not
+	bool CheckMatches(const char* Case, const char* Mode, const std::vector<float>& Expected, const std::vector<float>& Actual);
+
+private:
+	MathBenchmarkSettings mSettings;
+	std::vector<MathBenchmarkResult> mResults;
+	std::string mLastError;
+};
@@ -0,0 +1,43 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "MathBenchmark.h"
+
+//Vector math benchmark:
+//	MathBenchmark [-count N] [-iterations N]
+//Writes MathBenchmark.txt to the current directory.
+int main(int argc, char** argv)
+{
+	MathBenchmarkSettings Settings;
+	bool bValid = true;
+	for (int i = 1; i < argc && bValid; ++i)
+	{
+		if (strcmp(argv[i], "-count") == 0 && i + 1 < argc)
+		{
+			Settings.Count = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-iterations") == 0 && i + 1 < argc)
+		{
+			Settings.Iterations = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else
+		{
+			bValid = false;
+		}
+	}
+
+	if (!bValid || Settings.Count == 0 || Settings.Iterations == 0)
+	{
+		fprintf(stderr, "Usage: MathBenchmark [-count N] [-iterations N]\n");
+		return 1;
+	}
+
+	MathBenchmark Benchmark(Settings);
+	if (!Benchmark.Run())
+	{
+		fprintf(stderr, "%s\n", Benchmark.GetLastError().c_str());
+		return 1;
+	}
+	return Benchmark.WriteReport("MathBenchmark.txt") ? 0 : 1;
+}
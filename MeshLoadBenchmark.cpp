@@ -0,0 +1,92 @@
+#include "MeshLoadBenchmark.h"
+#include "AllocationCounter.h"
+#include "Common.h"
+
+#include <chrono>
+#include <cstring>
+#include <stdio.h>
+#include <vector>
+
+MeshLoadBenchmark::MeshLoadBenchmark(const char* Filename, uint32_t Iterations)
+	: mMeshFilename(Filename), mIterations(Iterations)
+{
+	Assert(mIterations > 0);
+}
+
+MeshLoadBenchmark::~MeshLoadBenchmark()
+{}
+
+bool MeshLoadBenchmark::Run()
+{
+	return RunMode(PackedMeshLoadMode::Mapped, mMappedResult) &&
+		RunMode(PackedMeshLoadMode::Copied, mCopiedResult);
+}
+
+bool MeshLoadBenchmark::RunMode(PackedMeshLoadMode Mode, MeshLoadBenchmarkResult& Result)
+{
+	Result = MeshLoadBenchmarkResult();
+
+	PackedMesh Mesh;
+	if (!Mesh.Load(mMeshFilename.c_str(), Mode))
+	{
+		mLastError = "Couldn't load " + mMeshFilename;
+		return false;
+	}
+	std::vector<uint8_t> UploadBuffer(static_cast<size_t>(Mesh.GetGpuDataSize()));
+	Mesh.Unload();
+
+	uint64_t Allocations = 0;
+	uint64_t AllocatedBytes = 0;
+	auto Start = std::chrono::high_resolution_clock::now();
+
+	for (uint32_t i = 0; i < mIterations; ++i)
+	{
+		AllocationCounts Before = GetAllocationCounts();
+		if (!Mesh.Load(mMeshFilename.c_str(), Mode))
+		{
+			mLastError = "Couldn't load " + mMeshFilename;
+			return false;
+		}
+		AllocationCounts After = GetAllocationCounts();
+		Allocations += After.Allocations - Before.Allocations;
+		AllocatedBytes += After.Bytes - Before.Bytes;
+
+		memcpy(UploadBuffer.data(), Mesh.GetGpuData(), UploadBuffer.size());
+
+		Result.FileBytes = Mesh.GetLoadStats().BytesLoaded;
+		Mesh.Unload();
+	}
+
+	Result.Iterations = mIterations;
+	Result.TotalMilliseconds = std::chrono::duration<double, std::milli>(
+		std::chrono::high_resolution_clock::now() - Start).count();
+	Result.MegabytesPerSecond = Result.TotalMilliseconds > 0.0 ?
+		(static_cast<double>(Result.FileBytes) * mIterations / (1024.0 * 1024.0)) / (Result.TotalMilliseconds / 1000.0) : 0.0;
+	Result.AllocationsPerLoad = static_cast<double>(Allocations) / mIterations;
+	Result.AllocatedBytesPerLoad = static_cast<double>(AllocatedBytes) / mIterations;
+	return true;
+}
+
+bool MeshLoadBenchmark::WriteReport(const char* Filename) const
+{
+	FILE* File = fopen(Filename, "w");
+	if (!File)
+	{
+		return false;
+	}
+
+	fprintf(File, "Mesh:        %s (%.2f MB)\n", mMeshFilename.c_str(), mMappedResult.FileBytes / (1024.0 * 1024.0));
+	fprintf(File, "Iterations:  %u\n\n", mIterations);
+	fprintf(File, "Mode,TotalMs,MBPerSecond,AllocationsPerLoad,AllocatedBytesPerLoad\n");
+
+	const char* ModeNames[] = { "Mapped", "Copied" };
+	const MeshLoadBenchmarkResult* Results[] = { &mMappedResult, &mCopiedResult };
+	for (int i = 0; i < 2; ++i)
+	{
+		fprintf(File, "%s,%.3f,%.1f,%.2f,%.0f\n", ModeNames[i], Results[i]->TotalMilliseconds,
+			Results[i]->MegabytesPerSecond, Results[i]->AllocationsPerLoad, Results[i]->AllocatedBytesPerLoad);
+	}
+
+	fclose(File);
+	return true;
+}
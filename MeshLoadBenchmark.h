@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "PackedMesh.h"
+
+//Loads a packed mesh repeatedly in each PackedMeshLoadMode and copies its GPU
+//data in to a preallocated buffer standing in for the upload heap, so both
+//modes pay for actually reading the data. Runs without a device.
+//
+//Repeated loads hit the OS file cache - numbers are warm cache throughput.
+//Allocations are every operator new made during Load(), counted by
+//AllocationCounter, so the benchmark has to link AllocationCounter.cpp.
+struct MeshLoadBenchmarkResult
+{
+	uint64_t FileBytes = 0;
+	uint32_t Iterations = 0;
+	double TotalMilliseconds = 0.0;
+	double MegabytesPerSecond = 0.0;
+	double AllocationsPerLoad = 0.0;
+	double AllocatedBytesPerLoad = 0.0;
+};
+
+class MeshLoadBenchmark
+{
+public:
+	MeshLoadBenchmark(const char* Filename, uint32_t Iterations);
+	~MeshLoadBenchmark();
+
+	bool Run();
+	bool WriteReport(const char* Filename) const;
+
+	const std::string& GetLastError() const { return mLastError; }
+
+private:
+	bool RunMode(PackedMeshLoadMode Mode, MeshLoadBenchmarkResult& Result);
+
+private:
+	std::string mMeshFilename;
+	uint32_t mIterations;
+
+	MeshLoadBenchmarkResult mMappedResult;
+	MeshLoadBenchmarkResult mCopiedResult;
+
+	std::string mLastError;
+};
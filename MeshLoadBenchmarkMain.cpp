@@ -0,0 +1,45 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "MeshLoadBenchmark.h"
+
+//Packed mesh load benchmark:
+//	MeshLoadBenchmark file.mesh [-iterations N]
+//Writes mapped vs copied throughput and allocations per load to
+//MeshLoadBenchmark.txt in the current directory.
+int main(int argc, char** argv)
+{
+	const char* MeshFilename = nullptr;
+	uint32_t Iterations = 100;
+	bool bValid = true;
+	for (int i = 1; i < argc && bValid; ++i)
+	{
+		if (strcmp(argv[i], "-iterations") == 0 && i + 1 < argc)
+		{
+			Iterations = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (argv[i][0] != '-' && !MeshFilename)
+		{
+			MeshFilename = argv[i];
+		}
+		else
+		{
+			bValid = false;
+		}
+	}
+
+	if (!bValid || !MeshFilename || Iterations == 0)
+	{
+		fprintf(stderr, "Usage: MeshLoadBenchmark file.mesh [-iterations N]\n");
+		return 1;
+	}
+
+	MeshLoadBenchmark Benchmark(MeshFilename, Iterations);
+	if (!Benchmark.Run())
+	{
+		fprintf(stderr, "%s\n", Benchmark.GetLastError().c_str());
+		return 1;
+	}
+	return Benchmark.WriteReport("MeshLoadBenchmark.txt") ? 0 : 1;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <string.h>
+
+#include "RenderCommandList.h"
+
+//Takes every call and does nothing but count it, so replaying on to it times
+//the caller - decoding a capture, say - with no backend cost at all.
+class NullRenderCommandList : public IRenderCommandList
+{
+public:
+	NullRenderCommandList() { Reset(); }
+
+	void Reset() { memset(mCallCounts, 0, sizeof(mCallCounts)); }
+
+	void SetPipelineState(uint32_t) override { Count(RenderCommandType::SetPipelineState); }
+	void SetGraphicsRootSignature(uint32_t) override { Count(RenderCommandType::SetRootSignature); }
+	void SetGraphicsRootDescriptorTable(uint32_t, uint32_t) override { Count(RenderCommandType::SetDescriptorTable); }
+	void SetGraphicsRootShaderResourceView(uint32_t, uint64_t) override { Count(RenderCommandType::SetRootShaderResourceView); }
+	void SetMesh(uint32_t) override { Count(RenderCommandType::SetMesh); }
+	void SetViewport(const RenderViewport&) override { Count(RenderCommandType::SetViewport); }
+	void SetRenderTargets(uint32_t, const uint64_t*, uint64_t) override { Count(RenderCommandType::SetRenderTargets); }
+	void DrawIndexedInstanced(uint32_t, uint32_t, uint32_t, int32_t, uint32_t) override { Count(RenderCommandType::DrawIndexedInstanced); }
+	void ResourceBarrier(uint32_t, RenderResourceState, RenderResourceState) override { Count(RenderCommandType::ResourceBarrier); }
+	void CopyBufferRegion(uint32_t, uint64_t, uint32_t, uint64_t, uint64_t) override { Count(RenderCommandType::CopyBufferRegion); }
+
+	//Since the last Reset()
+	uint64_t GetCallCount(RenderCommandType Type) const { return mCallCounts[static_cast<uint32_t>(Type)]; }
+	uint64_t GetTotalCallCount() const
+	{
+		uint64_t Total = 0;
+		for (uint64_t Calls : mCallCounts)
+		{
+			Total += Calls;
+		}
+		return Total;
+	}
+
+private:
+	void Count(RenderCommandType Type) { ++mCallCounts[static_cast<uint32_t>(Type)]; }
+
+private:
+	uint64_t mCallCounts[static_cast<uint32_t>(RenderCommandType::Count)];
+};
@@ -0,0 +1,45 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "ObjMeshConverter.h"
+
+//OBJ to packed mesh conversion:
+//	ObjConverter out.mesh [-interleaved] lod0.obj [lod1.obj ...]
+//Each further LOD is used at half the screen size of the previous one.
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		fprintf(stderr, "Usage: ObjConverter out.mesh [-interleaved] lod0.obj [lod1.obj ...]\n");
+		return 1;
+	}
+
+	ObjMeshConverter Converter;
+	bool bInterleaved = false;
+	float ScreenSize = 1.0f;
+	for (int i = 2; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "-interleaved") == 0)
+		{
+			bInterleaved = true;
+			continue;
+		}
+
+		if (!Converter.AddLod(argv[i], ScreenSize))
+		{
+			fprintf(stderr, "%s\n", Converter.GetLastError().c_str());
+			return 1;
+		}
+		ScreenSize *= 0.5f;
+	}
+
+	if (!Converter.Write(argv[1], bInterleaved))
+	{
+		fprintf(stderr, "Couldn't write %s\n", argv[1]);
+		return 1;
+	}
+
+	printf("%s: %u vertices, %u indices, %u submeshes\n", argv[1], Converter.GetVertexCount(),
+		Converter.GetIndexCount(), Converter.GetSubmeshCount());
+	return 0;
+}
@@ -0,0 +1,476 @@
+#include "ObjMeshConverter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <stdio.h>
+#include <unordered_map>
+
+namespace
+{
+	struct ObjCorner
+	{
+		int32_t Position;
+		int32_t TexCoord;	//-1 if missing
+		int32_t Normal;
+	};
+
+	struct ObjCornerHash
+	{
+		size_t operator()(const ObjCorner& Corner) const
+		{
+			uint64_t Key = (static_cast<uint64_t>(static_cast<uint32_t>(Corner.Position)) * 0x9E3779B97F4A7C15ull) ^
+				(static_cast<uint64_t>(static_cast<uint32_t>(Corner.TexCoord)) * 0xC2B2AE3D27D4EB4Full) ^
+				static_cast<uint64_t>(static_cast<uint32_t>(Corner.Normal));
+			return static_cast<size_t>(Key ^ (Key >> 29));
+		}
+	};
+
+	bool operator==(const ObjCorner& A, const ObjCorner& B)
+	{
+		return A.Position == B.Position && A.TexCoord == B.TexCoord && A.Normal == B.Normal;
+	}
+
+	uint64_t AlignUp(uint64_t Value, uint64_t Alignment)
+	{
+		return (Value + Alignment - 1) & ~(Alignment - 1);
+	}
+
+	//OBJ indices are 1 based, negative ones count back from the end
+	bool ResolveIndex(long Index, size_t Count, int32_t& Out)
+	{
+		long Resolved = Index > 0 ? Index - 1 : static_cast<long>(Count) + Index;
+		if (Index == 0 || Resolved < 0 || Resolved >= static_cast<long>(Count))
+		{
+			return false;
+		}
+		Out = static_cast<int32_t>(Resolved);
+		return true;
+	}
+
+	bool ReadFile(const char* Filename, std::string& Out)
+	{
+		FILE* File = fopen(Filename, "rb");
+		if (!File)
+		{
+			return false;
+		}
+
+		fseek(File, 0, SEEK_END);
+		long Size = ftell(File);
+		fseek(File, 0, SEEK_SET);
+
+		Out.resize(Size > 0 ? static_cast<size_t>(Size) : 0);
+		bool bRead = Out.empty() || fread(&Out[0], 1, Out.size(), File) == Out.size();
+		fclose(File);
+		return bRead;
+	}
+}
+
+ObjMeshConverter::ObjMeshConverter()
+{}
+
+ObjMeshConverter::~ObjMeshConverter()
+{}
+
+bool ObjMeshConverter::AddLod(const char* ObjFilename, float ScreenSize)
+{
+	std::string Text;
+	if (!ReadFile(ObjFilename, Text))
+	{
+		mLastError = std::string("Couldn't read ") + ObjFilename;
+		return false;
+	}
+
+	return AddLodFromMemory(ObjFilename, Text, ScreenSize);
+}
+
+bool ObjMeshConverter::AddLodFromMemory(const char* SourceName, const std::string& Text, float ScreenSize)
+{
+	std::vector<float> Positions;
+	std::vector<float> TexCoords;
+	std::vector<float> Normals;
+
+	//Triangles grouped by material, in first use order
+	std::vector<uint32_t> GroupMaterials;
+	std::vector<std::vector<ObjCorner>> GroupCorners;
+	size_t CurrentGroup = SIZE_MAX;
+
+	std::vector<ObjCorner> Face;
+	unsigned LineNumber = 0;
+
+	size_t LineStart = 0;
+	while (LineStart < Text.size())
+	{
+		size_t LineEnd = Text.find('\n', LineStart);
+		if (LineEnd == std::string::npos)
+		{
+			LineEnd = Text.size();
+		}
+		std::string Line = Text.substr(LineStart, LineEnd - LineStart);
+		LineStart = LineEnd + 1;
+		++LineNumber;
+
+		if (!Line.empty() && Line.back() == '\r')
+		{
+			Line.pop_back();
+		}
+
+		const char* Cursor = Line.c_str();
+		while (*Cursor == ' ' || *Cursor == '\t')
+		{
+			++Cursor;
+		}
+
+		if (strncmp(Cursor, "v ", 2) == 0)
+		{
+			float X = 0.0f, Y = 0.0f, Z = 0.0f;
+			sscanf(Cursor + 2, "%f %f %f", &X, &Y, &Z);
+			Positions.push_back(X);
+			Positions.push_back(Y);
+			Positions.push_back(Z);
+		}
+		else if (strncmp(Cursor, "vt ", 3) == 0)
+		{
+			float U = 0.0f, V = 0.0f;
+			sscanf(Cursor + 3, "%f %f", &U, &V);
+			TexCoords.push_back(U);
+			TexCoords.push_back(V);
+		}
+		else if (strncmp(Cursor, "vn ", 3) == 0)
+		{
+			float X = 0.0f, Y = 0.0f, Z = 1.0f;
+			sscanf(Cursor + 3, "%f %f %f", &X, &Y, &Z);
+			Normals.push_back(X);
+			Normals.push_back(Y);
+			Normals.push_back(Z);
+		}
+		else if (strncmp(Cursor, "usemtl", 6) == 0 || strncmp(Cursor, "f ", 2) == 0)
+		{
+			bool bFace = Cursor[0] == 'f';
+			uint32_t Material = 0;
+
+			if (!bFace)
+			{
+				char Name[256] = {};
+				sscanf(Cursor + 6, " %255s", Name);
+				Material = FindOrAddMaterial(Name);
+			}
+			else if (CurrentGroup == SIZE_MAX)
+			{
+				Material = FindOrAddMaterial("");
+			}
+
+			if (!bFace || CurrentGroup == SIZE_MAX)
+			{
+				auto Existing = std::find(GroupMaterials.begin(), GroupMaterials.end(), Material);
+				CurrentGroup = static_cast<size_t>(Existing - GroupMaterials.begin());
+				if (Existing == GroupMaterials.end())
+				{
+					GroupMaterials.push_back(Material);
+					GroupCorners.emplace_back();
+				}
+			}
+
+			if (!bFace)
+			{
+				continue;
+			}
+
+			//v, v/t, v//n or v/t/n
+			Face.clear();
+			bool bHasNormals = true;
+			Cursor += 2;
+			while (*Cursor)
+			{
+				char* End = nullptr;
+				long P = strtol(Cursor, &End, 10);
+				if (End == Cursor)
+				{
+					++Cursor;
+					continue;
+				}
+				Cursor = End;
+
+				long T = 0, N = 0;
+				if (*Cursor == '/')
+				{
+					++Cursor;
+					if (*Cursor != '/')
+					{
+						T = strtol(Cursor, &End, 10);
+						Cursor = End;
+					}
+					if (*Cursor == '/')
+					{
+						++Cursor;
+						N = strtol(Cursor, &End, 10);
+						Cursor = End;
+					}
+				}
+
+				ObjCorner Corner = { 0, -1, -1 };
+				if (!ResolveIndex(P, Positions.size() / 3, Corner.Position) ||
+					(T != 0 && !ResolveIndex(T, TexCoords.size() / 2, Corner.TexCoord)) ||
+					(N != 0 && !ResolveIndex(N, Normals.size() / 3, Corner.Normal)))
+				{
+					mLastError = std::string(SourceName) + ": bad index on line " + std::to_string(LineNumber);
+					return false;
+				}
+				bHasNormals &= Corner.Normal >= 0;
+				Face.push_back(Corner);
+			}
+
+			if (Face.size() < 3)
+			{
+				continue;
+			}
+
+			//Flat normal from the first three corners
+			if (!bHasNormals)
+			{
+				const float* A = &Positions[Face[0].Position * 3];
+				const float* B = &Positions[Face[1].Position * 3];
+				const float* C = &Positions[Face[2].Position * 3];
+				float E0[3] = { B[0] - A[0], B[1] - A[1], B[2] - A[2] };
+				float E1[3] = { C[0] - A[0], C[1] - A[1], C[2] - A[2] };
+				float Nx = E0[1] * E1[2] - E0[2] * E1[1];
+				float Ny = E0[2] * E1[0] - E0[0] * E1[2];
+				float Nz = E0[0] * E1[1] - E0[1] * E1[0];
+				float Length = std::sqrt(Nx * Nx + Ny * Ny + Nz * Nz);
+				if (Length > 0.0f)
+				{
+					Nx /= Length;
+					Ny /= Length;
+					Nz /= Length;
+				}
+
+				int32_t FaceNormal = static_cast<int32_t>(Normals.size() / 3);
+				Normals.push_back(Nx);
+				Normals.push_back(Ny);
+				Normals.push_back(Nz);
+				for (ObjCorner& Corner : Face)
+				{
+					Corner.Normal = FaceNormal;
+				}
+			}
+
+			std::vector<ObjCorner>& Corners = GroupCorners[CurrentGroup];
+			for (size_t i = 1; i + 1 < Face.size(); ++i)
+			{
+				Corners.push_back(Face[0]);
+				Corners.push_back(Face[i]);
+				Corners.push_back(Face[i + 1]);
+			}
+		}
+	}
+
+	//Each material group becomes a submesh with its own de-duplicated vertices
+	PackedMeshLod Lod = {};
+	Lod.FirstSubmesh = static_cast<uint32_t>(mSubmeshes.size());
+	Lod.ScreenSize = ScreenSize;
+
+	std::unordered_map<ObjCorner, uint32_t, ObjCornerHash> VertexLookup;
+	for (size_t Group = 0; Group < GroupCorners.size(); ++Group)
+	{
+		const std::vector<ObjCorner>& Corners = GroupCorners[Group];
+		if (Corners.empty())
+		{
+			continue;
+		}
+
+		PackedMeshSubmesh Submesh = {};
+		Submesh.IndexStart = static_cast<uint32_t>(mIndices.size());
+		Submesh.IndexCount = static_cast<uint32_t>(Corners.size());
+		Submesh.BaseVertex = static_cast<uint32_t>(mVertices.size());
+		Submesh.MaterialIndex = GroupMaterials[Group];
+		for (int Axis = 0; Axis < 3; ++Axis)
+		{
+			Submesh.BoundsMin[Axis] = HUGE_VALF;
+			Submesh.BoundsMax[Axis] = -HUGE_VALF;
+		}
+
+		VertexLookup.clear();
+		for (const ObjCorner& Corner : Corners)
+		{
+			auto Inserted = VertexLookup.insert(std::make_pair(Corner, Submesh.VertexCount));
+			if (Inserted.second)
+			{
+				Vertex NewVertex = {};
+				memcpy(NewVertex.Position, &Positions[Corner.Position * 3], sizeof(NewVertex.Position));
+				memcpy(NewVertex.Normal, &Normals[Corner.Normal * 3], sizeof(NewVertex.Normal));
+				if (Corner.TexCoord >= 0)
+				{
+					memcpy(NewVertex.TexCoord, &TexCoords[Corner.TexCoord * 2], sizeof(NewVertex.TexCoord));
+				}
+				mVertices.push_back(NewVertex);
+				++Submesh.VertexCount;
+
+				for (int Axis = 0; Axis < 3; ++Axis)
+				{
+					Submesh.BoundsMin[Axis] = std::min(Submesh.BoundsMin[Axis], NewVertex.Position[Axis]);
+					Submesh.BoundsMax[Axis] = std::max(Submesh.BoundsMax[Axis], NewVertex.Position[Axis]);
+				}
+			}
+			mIndices.push_back(Inserted.first->second);
+		}
+
+		mSubmeshes.push_back(Submesh);
+		++Lod.SubmeshCount;
+	}
+
+	if (Lod.SubmeshCount == 0)
+	{
+		mLastError = std::string(SourceName) + ": no faces";
+		return false;
+	}
+
+	mLods.push_back(Lod);
+	return true;
+}
+
+bool ObjMeshConverter::Write(const char* Filename, bool bInterleaved) const
+{
+	if (mLods.empty())
+	{
+		return false;
+	}
+
+	PackedMeshHeader Header = {};
+	Header.Magic = PackedMeshMagic;
+	Header.Version = PackedMeshVersion;
+	Header.Flags = bInterleaved ? PackedMeshFlag_Interleaved : 0;
+	Header.VertexCount = static_cast<uint32_t>(mVertices.size());
+	Header.IndexCount = static_cast<uint32_t>(mIndices.size());
+	Header.SubmeshCount = static_cast<uint32_t>(mSubmeshes.size());
+	Header.LodCount = static_cast<uint32_t>(mLods.size());
+
+	//16 bit indices if every submesh can address its vertices with them
+	Header.IndexSize = 2;
+	for (const PackedMeshSubmesh& Submesh : mSubmeshes)
+	{
+		if (Submesh.VertexCount > 0x10000)
+		{
+			Header.IndexSize = 4;
+		}
+	}
+
+	float BoundsMin[3] = { HUGE_VALF, HUGE_VALF, HUGE_VALF };
+	float BoundsMax[3] = { -HUGE_VALF, -HUGE_VALF, -HUGE_VALF };
+	for (const PackedMeshSubmesh& Submesh : mSubmeshes)
+	{
+		for (int Axis = 0; Axis < 3; ++Axis)
+		{
+			BoundsMin[Axis] = std::min(BoundsMin[Axis], Submesh.BoundsMin[Axis]);
+			BoundsMax[Axis] = std::max(BoundsMax[Axis], Submesh.BoundsMax[Axis]);
+		}
+	}
+	for (int Axis = 0; Axis < 3; ++Axis)
+	{
+		Header.PositionMin[Axis] = BoundsMin[Axis];
+		Header.PositionExtent[Axis] = BoundsMax[Axis] - BoundsMin[Axis];
+	}
+
+	//GPU data layout
+	uint64_t VertexCount = mVertices.size();
+	if (bInterleaved)
+	{
+		for (uint32_t StreamIdx = 0; StreamIdx < PackedMeshStream_Count; ++StreamIdx)
+		{
+			Header.Streams[StreamIdx].Offset = 0;
+			Header.Streams[StreamIdx].Stride = 16;
+		}
+		Header.Streams[PackedMeshStream_Position].AttributeOffset = 0;
+		Header.Streams[PackedMeshStream_Normal].AttributeOffset = 8;
+		Header.Streams[PackedMeshStream_TexCoord].AttributeOffset = 12;
+		Header.IndexDataOffset = AlignUp(VertexCount * 16, PackedMeshSectionAlignment);
+	}
+	else
+	{
+		const uint32_t Strides[PackedMeshStream_Count] = { 8, 4, 4 };
+		uint64_t Offset = 0;
+		for (uint32_t StreamIdx = 0; StreamIdx < PackedMeshStream_Count; ++StreamIdx)
+		{
+			Header.Streams[StreamIdx].Offset = Offset;
+			Header.Streams[StreamIdx].Stride = Strides[StreamIdx];
+			Header.Streams[StreamIdx].AttributeOffset = 0;
+			Offset = AlignUp(Offset + VertexCount * Strides[StreamIdx], PackedMeshSectionAlignment);
+		}
+		Header.IndexDataOffset = Offset;
+	}
+
+	Header.GpuDataSize = Header.IndexDataOffset + static_cast<uint64_t>(Header.IndexCount) * Header.IndexSize;
+
+	Header.LodTableOffset = AlignUp(sizeof(PackedMeshHeader), PackedMeshSectionAlignment);
+	Header.SubmeshTableOffset = AlignUp(Header.LodTableOffset + mLods.size() * sizeof(PackedMeshLod), PackedMeshSectionAlignment);
+	Header.GpuDataOffset = AlignUp(Header.SubmeshTableOffset + mSubmeshes.size() * sizeof(PackedMeshSubmesh), PackedMeshSectionAlignment);
+	Header.FileSize = Header.GpuDataOffset + Header.GpuDataSize;
+
+	std::vector<uint8_t> Image(static_cast<size_t>(Header.FileSize), 0);
+	memcpy(&Image[0], &Header, sizeof(Header));
+	memcpy(&Image[static_cast<size_t>(Header.LodTableOffset)], mLods.data(), mLods.size() * sizeof(PackedMeshLod));
+	memcpy(&Image[static_cast<size_t>(Header.SubmeshTableOffset)], mSubmeshes.data(), mSubmeshes.size() * sizeof(PackedMeshSubmesh));
+
+	uint8_t* GpuData = &Image[static_cast<size_t>(Header.GpuDataOffset)];
+	for (size_t i = 0; i < mVertices.size(); ++i)
+	{
+		const Vertex& Source = mVertices[i];
+
+		uint16_t Position[4] = {};
+		for (int Axis = 0; Axis < 3; ++Axis)
+		{
+			float Extent = Header.PositionExtent[Axis];
+			float Normalised = Extent > 0.0f ? (Source.Position[Axis] - Header.PositionMin[Axis]) / Extent : 0.0f;
+			Position[Axis] = static_cast<uint16_t>(std::lround(std::min(std::max(Normalised, 0.0f), 1.0f) * 65535.0f));
+		}
+
+		int16_t Normal[2];
+		PackedMeshEncodeOctahedral(Source.Normal, Normal);
+
+		uint16_t TexCoord[2] = { PackedMeshFloatToHalf(Source.TexCoord[0]), PackedMeshFloatToHalf(Source.TexCoord[1]) };
+
+		const PackedMeshStreamDesc* Streams = Header.Streams;
+		memcpy(GpuData + Streams[PackedMeshStream_Position].Offset + i * Streams[PackedMeshStream_Position].Stride +
+			Streams[PackedMeshStream_Position].AttributeOffset, Position, sizeof(Position));
+		memcpy(GpuData + Streams[PackedMeshStream_Normal].Offset + i * Streams[PackedMeshStream_Normal].Stride +
+			Streams[PackedMeshStream_Normal].AttributeOffset, Normal, sizeof(Normal));
+		memcpy(GpuData + Streams[PackedMeshStream_TexCoord].Offset + i * Streams[PackedMeshStream_TexCoord].Stride +
+			Streams[PackedMeshStream_TexCoord].AttributeOffset, TexCoord, sizeof(TexCoord));
+	}
+
+	uint8_t* IndexData = GpuData + Header.IndexDataOffset;
+	for (size_t i = 0; i < mIndices.size(); ++i)
+	{
+		if (Header.IndexSize == 2)
+		{
+			uint16_t Index = static_cast<uint16_t>(mIndices[i]);
+			memcpy(IndexData + i * 2, &Index, 2);
+		}
+		else
+		{
+			memcpy(IndexData + i * 4, &mIndices[i], 4);
+		}
+	}
+
+	FILE* File = fopen(Filename, "wb");
+	if (!File)
+	{
+		return false;
+	}
+	bool bWritten = fwrite(Image.data(), 1, Image.size(), File) == Image.size();
+	fclose(File);
+	return bWritten;
+}
+
+uint32_t ObjMeshConverter::FindOrAddMaterial(const std::string& Name)
+{
+	auto Existing = std::find(mMaterials.begin(), mMaterials.end(), Name);
+	if (Existing != mMaterials.end())
+	{
+		return static_cast<uint32_t>(Existing - mMaterials.begin());
+	}
+
+	mMaterials.push_back(Name);
+	return static_cast<uint32_t>(mMaterials.size() - 1);
+}
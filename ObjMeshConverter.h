@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "PackedMesh.h"
+
+//Builds a PackedMesh file from Wavefront OBJ files, one OBJ per LOD.
+//
+//Supports v/vt/vn/f (polygons are fan triangulated, negative indices are
+//relative) and usemtl - every material used by a LOD becomes a submesh.
+//Material indices are shared across LODs by name. Faces without normals get
+//a flat face normal, missing texture coordinates are zero.
+class ObjMeshConverter
+{
+public:
+	ObjMeshConverter();
+	~ObjMeshConverter();
+
+	//LODs are added finest first.
+	bool AddLod(const char* ObjFilename, float ScreenSize);
+
+	//As AddLod, for OBJ text already in memory. SourceName is only used in errors.
+	bool AddLodFromMemory(const char* SourceName, const std::string& Text, float ScreenSize);
+
+	bool Write(const char* Filename, bool bInterleaved) const;
+
+	const std::string& GetLastError() const { return mLastError; }
+
+	uint32_t GetVertexCount() const { return static_cast<uint32_t>(mVertices.size()); }
+	uint32_t GetIndexCount() const { return static_cast<uint32_t>(mIndices.size()); }
+	uint32_t GetSubmeshCount() const { return static_cast<uint32_t>(mSubmeshes.size()); }
+
+private:
+	struct Vertex
+	{
+		float Position[3];
+		float Normal[3];
+		float TexCoord[2];
+	};
+
+	uint32_t FindOrAddMaterial(const std::string& Name);
+
+private:
+	std::vector<Vertex> mVertices;
+	std::vector<uint32_t> mIndices;		//Relative to the submesh's BaseVertex
+	std::vector<PackedMeshSubmesh> mSubmeshes;
+	std::vector<PackedMeshLod> mLods;
+	std::vector<std::string> mMaterials;
+
+	std::string mLastError;
+};
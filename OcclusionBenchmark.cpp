@@ -0,0 +1,428 @@
+#include "OcclusionBenchmark.h"
+#include "Common.h"
+#include "FrustumCuller.h"
+#include "JobSystem.h"
+#include "OcclusionCuller.h"
+#include "VectorMath.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <stdio.h>
+
+namespace
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	double MillisecondsSince(Clock::time_point Start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - Start).count();
+	}
+
+	const float CitySize = 1000.0f;
+	const float CameraDistance = 750.0f;
+	const float CameraHeight = 30.0f;
+
+	//Points per face edge when looking for a visible part of an occludee
+	const uint32_t SamplesPerSide = 5;
+
+	struct View
+	{
+		Float3 Eye;
+		Matrix4x4 ViewProjection;
+	};
+
+	//Circling just outside the city, looking at the middle
+	View MakeView(uint32_t Pass, uint32_t PassCount, uint32_t Width, uint32_t Height)
+	{
+		float Angle = 6.2831853f * static_cast<float>(Pass) / static_cast<float>(PassCount);
+		View Result;
+		Result.Eye = MakeFloat3(sinf(Angle) * CameraDistance, CameraHeight, cosf(Angle) * CameraDistance);
+		Matrix4x4 ViewMatrix = MatrixLookAtLH(Result.Eye, MakeFloat3(0.0f, CameraHeight, 0.0f), MakeFloat3(0.0f, 1.0f, 0.0f));
+		Matrix4x4 Projection = MatrixPerspectiveFovLH(1.0472f, static_cast<float>(Width) / Height, 0.5f, 2.0f * CitySize);
+		Result.ViewProjection = Multiply(Projection, ViewMatrix);
+		return Result;
+	}
+
+	//Unit cube from 0 to 1, each face a Subdivisions square grid of quads
+	void MakeCubeMesh(uint32_t Subdivisions, std::vector<Float3>& OutPositions, std::vector<uint32_t>& OutIndices)
+	{
+		OutPositions.clear();
+		OutIndices.clear();
+		for (int Axis = 0; Axis < 3; ++Axis)
+		{
+			for (int Side = 0; Side < 2; ++Side)
+			{
+				uint32_t First = static_cast<uint32_t>(OutPositions.size());
+				for (uint32_t V = 0; V <= Subdivisions; ++V)
+				{
+					for (uint32_t U = 0; U <= Subdivisions; ++U)
+					{
+						float Coordinates[3];
+						Coordinates[Axis] = static_cast<float>(Side);
+						Coordinates[(Axis + 1) % 3] = static_cast<float>(U) / Subdivisions;
+						Coordinates[(Axis + 2) % 3] = static_cast<float>(V) / Subdivisions;
+						OutPositions.push_back(MakeFloat3(Coordinates[0], Coordinates[1], Coordinates[2]));
+					}
+				}
+
+				for (uint32_t V = 0; V < Subdivisions; ++V)
+				{
+					for (uint32_t U = 0; U < Subdivisions; ++U)
+					{
+						uint32_t Corner = First + V * (Subdivisions + 1) + U;
+						uint32_t Quad[6] = { Corner, Corner + 1, Corner + Subdivisions + 2, Corner, Corner + Subdivisions + 2,
+							Corner + Subdivisions + 1 };
+						OutIndices.insert(OutIndices.end(), Quad, Quad + 6);
+					}
+				}
+			}
+		}
+	}
+
+	Matrix3x4 MatrixFromBox(const Aabb& Box)
+	{
+		Float3 Size = Box.Max - Box.Min;
+		Matrix3x4 Result =
+		{ {
+			{ Size.X, 0.0f, 0.0f, Box.Min.X },
+			{ 0.0f, Size.Y, 0.0f, Box.Min.Y },
+			{ 0.0f, 0.0f, Size.Z, Box.Min.Z }
+		} };
+		return Result;
+	}
+
+	//Does the segment from Start to just short of End pass through Box
+	bool SegmentHitsBox(const Float3& Start, const Float3& End, const Aabb& Box)
+	{
+		const float Begin[3] = { Start.X, Start.Y, Start.Z };
+		const float Delta[3] = { End.X - Start.X, End.Y - Start.Y, End.Z - Start.Z };
+		const float Low[3] = { Box.Min.X, Box.Min.Y, Box.Min.Z };
+		const float High[3] = { Box.Max.X, Box.Max.Y, Box.Max.Z };
+
+		//Points resting on a face count as not hidden by it
+		float Near = 0.0f;
+		float Far = 1.0f - 1e-4f;
+		for (int Axis = 0; Axis < 3; ++Axis)
+		{
+			if (fabsf(Delta[Axis]) < 1e-12f)
+			{
+				if (Begin[Axis] < Low[Axis] || Begin[Axis] > High[Axis])
+				{
+					return false;
+				}
+				continue;
+			}
+
+			float T0 = (Low[Axis] - Begin[Axis]) / Delta[Axis];
+			float T1 = (High[Axis] - Begin[Axis]) / Delta[Axis];
+			Near = std::max(Near, std::min(T0, T1));
+			Far = std::min(Far, std::max(T0, T1));
+			if (Near > Far)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool IsInView(const Matrix4x4& ViewProjection, const Float3& Position)
+	{
+		Float4 Clip = TransformPoint(ViewProjection, Position);
+		return Clip.W > 0.0f && fabsf(Clip.X) <= Clip.W && fabsf(Clip.Y) <= Clip.W && Clip.Z >= 0.0f && Clip.Z <= Clip.W;
+	}
+
+	//Ground truth for a culled box: can any point over its surface be seen
+	bool IsAnyPointVisible(const View& Camera, const Aabb& Box, const std::vector<Aabb>& Buildings)
+	{
+		Float3 Size = Box.Max - Box.Min;
+		const float Step = 1.0f / (SamplesPerSide - 1);
+		for (int Axis = 0; Axis < 3; ++Axis)
+		{
+			for (int Side = 0; Side < 2; ++Side)
+			{
+				for (uint32_t V = 0; V < SamplesPerSide; ++V)
+				{
+					for (uint32_t U = 0; U < SamplesPerSide; ++U)
+					{
+						float Fractions[3];
+						Fractions[Axis] = static_cast<float>(Side);
+						Fractions[(Axis + 1) % 3] = U * Step;
+						Fractions[(Axis + 2) % 3] = V * Step;
+						Float3 Point = MakeFloat3(Box.Min.X + Size.X * Fractions[0], Box.Min.Y + Size.Y * Fractions[1],
+							Box.Min.Z + Size.Z * Fractions[2]);
+						if (!IsInView(Camera.ViewProjection, Point))
+						{
+							continue;
+						}
+
+						bool bBlocked = false;
+						for (const Aabb& Building : Buildings)
+						{
+							if (SegmentHitsBox(Camera.Eye, Point, Building))
+							{
+								bBlocked = true;
+								break;
+							}
+						}
+						if (!bBlocked)
+						{
+							return true;
+						}
+					}
+				}
+			}
+		}
+		return false;
+	}
+}
+
+OcclusionBenchmark::OcclusionBenchmark(const OcclusionBenchmarkSettings& Settings)
+	: mSettings(Settings), mOccluderTriangles(0), mFrustumVisible(0), mOccluded(0), mSampled(0), mFalseNegatives(0)
+{
+	Assert(mSettings.Iterations > 0);
+}
+
+OcclusionBenchmark::~OcclusionBenchmark()
+{}
+
+bool OcclusionBenchmark::Run()
+{
+	mResults.clear();
+	mOccluderTriangles = mFrustumVisible = mOccluded = mSampled = mFalseNegatives = 0;
+
+	if (mSettings.Width == 0 || mSettings.Height == 0 || mSettings.Width % OcclusionCuller::TileSize != 0 ||
+		mSettings.Height % OcclusionCuller::TileSize != 0)
+	{
+		mLastError = "Resolution must be a non-zero multiple of the tile size";
+		return false;
+	}
+	if (mSettings.BuildingsPerSide == 0 || mSettings.FaceSubdivisions == 0)
+	{
+		mLastError = "Buildings and face subdivisions must be above 0";
+		return false;
+	}
+	for (uint32_t ThreadCount : mSettings.ThreadCounts)
+	{
+		if (ThreadCount < 2)
+		{
+			mLastError = "Thread counts must be at least 2 - one thread is always run";
+			return false;
+		}
+	}
+
+	if (!CheckBasics())
+	{
+		return false;
+	}
+
+	//A grid of buildings with streets between them, and small things scattered
+	//over the ground
+	std::mt19937 Random(1234);
+	float Spacing = CitySize / mSettings.BuildingsPerSide;
+	std::uniform_real_distribution<float> Footprint(0.4f * Spacing, 0.8f * Spacing);
+	std::uniform_real_distribution<float> Storeys(15.0f, 60.0f);
+
+	std::vector<Aabb> Buildings;
+	std::vector<Matrix3x4> BuildingWorlds;
+	for (uint32_t Row = 0; Row < mSettings.BuildingsPerSide; ++Row)
+	{
+		for (uint32_t Column = 0; Column < mSettings.BuildingsPerSide; ++Column)
+		{
+			float CentreX = -0.5f * CitySize + (Column + 0.5f) * Spacing;
+			float CentreZ = -0.5f * CitySize + (Row + 0.5f) * Spacing;
+			float Width = Footprint(Random);
+			float Depth = Footprint(Random);
+
+			Aabb Building;
+			Building.Min = MakeFloat3(CentreX - 0.5f * Width, 0.0f, CentreZ - 0.5f * Depth);
+			Building.Max = MakeFloat3(CentreX + 0.5f * Width, Storeys(Random), CentreZ + 0.5f * Depth);
+			Buildings.push_back(Building);
+			BuildingWorlds.push_back(MatrixFromBox(Building));
+		}
+	}
+
+	std::vector<Float3> CubePositions;
+	std::vector<uint32_t> CubeIndices;
+	MakeCubeMesh(mSettings.FaceSubdivisions, CubePositions, CubeIndices);
+
+	std::uniform_real_distribution<float> Ground(-0.5f * CitySize, 0.5f * CitySize);
+	std::uniform_real_distribution<float> Size(1.0f, 4.0f);
+	std::vector<Aabb> Occludees(mSettings.OccludeeCount);
+	FrustumCuller Frustums;
+	Frustums.Reserve(mSettings.OccludeeCount);
+	for (Aabb& Box : Occludees)
+	{
+		Box.Min = MakeFloat3(Ground(Random), 0.0f, Ground(Random));
+		Box.Max = Box.Min + MakeFloat3(Size(Random), Size(Random), Size(Random));
+		Frustums.AddObject(Box);
+	}
+
+	//Frustum culled lists are the occlusion culler's input
+	std::vector<View> Views;
+	std::vector<std::vector<uint32_t>> InView(mSettings.Iterations);
+	for (uint32_t Pass = 0; Pass < mSettings.Iterations; ++Pass)
+	{
+		Views.push_back(MakeView(Pass, mSettings.Iterations, mSettings.Width, mSettings.Height));
+		Frustums.Cull(FrustumFromViewProjection(Views[Pass].ViewProjection), InView[Pass]);
+		mFrustumVisible += static_cast<uint32_t>(InView[Pass].size());
+	}
+
+	std::vector<uint32_t> ThreadCounts = mSettings.ThreadCounts;
+	ThreadCounts.insert(ThreadCounts.begin(), 1);
+
+	OcclusionCuller Culler(mSettings.Width, mSettings.Height);
+	std::vector<uint32_t> SerialKept(mSettings.Iterations);
+	std::vector<uint32_t> Visible;
+	uint32_t SamplesPerPass = (mSettings.SampledOccludees + mSettings.Iterations - 1) / mSettings.Iterations;
+
+	for (uint32_t ThreadCount : ThreadCounts)
+	{
+		std::unique_ptr<JobSystem> Jobs;
+		if (ThreadCount > 1)
+		{
+			Jobs.reset(new JobSystem(ThreadCount - 1));
+		}
+
+		double RasterizeMilliseconds = 0.0;
+		double TestMilliseconds = 0.0;
+		uint64_t Triangles = 0;
+		uint64_t Tests = 0;
+		for (uint32_t Pass = 0; Pass < mSettings.Iterations; ++Pass)
+		{
+			auto Start = Clock::now();
+			Culler.BeginFrame(Views[Pass].ViewProjection);
+			for (const Matrix3x4& World : BuildingWorlds)
+			{
+				Culler.AddOccluder(CubePositions.data(), static_cast<uint32_t>(CubePositions.size()), CubeIndices.data(),
+					static_cast<uint32_t>(CubeIndices.size()), World);
+			}
+			Culler.RasterizeOccluders(Jobs.get());
+			RasterizeMilliseconds += MillisecondsSince(Start);
+			Triangles += Culler.GetLastFrameStats().OccluderTriangles;
+
+			Visible = InView[Pass];
+			Start = Clock::now();
+			uint32_t Kept = Culler.CullOccluded(Occludees.data(), Visible, Jobs.get());
+			TestMilliseconds += MillisecondsSince(Start);
+			Tests += InView[Pass].size();
+
+			if (ThreadCount > 1)
+			{
+				if (Kept != SerialKept[Pass])
+				{
+					char Error[128];
+					snprintf(Error, sizeof(Error), "Occluded count differs from one thread with %u threads, pass %u",
+						ThreadCount, Pass);
+					mLastError = Error;
+					return false;
+				}
+				continue;
+			}
+
+			SerialKept[Pass] = Kept;
+			mOccluded += static_cast<uint32_t>(InView[Pass].size()) - Kept;
+
+			//Spread the samples evenly over what was culled
+			std::vector<uint32_t> Culled;
+			std::set_difference(InView[Pass].begin(), InView[Pass].end(), Visible.begin(), Visible.end(),
+				std::back_inserter(Culled));
+			uint32_t Samples = std::min(SamplesPerPass, static_cast<uint32_t>(Culled.size()));
+			for (uint32_t Sample = 0; Sample < Samples; ++Sample)
+			{
+				const Aabb& Box = Occludees[Culled[static_cast<size_t>(Sample) * Culled.size() / Samples]];
+				mFalseNegatives += IsAnyPointVisible(Views[Pass], Box, Buildings) ? 1 : 0;
+			}
+			mSampled += Samples;
+		}
+		mOccluderTriangles = static_cast<uint32_t>(Triangles / mSettings.Iterations);
+
+		char Mode[32];
+		snprintf(Mode, sizeof(Mode), ThreadCount > 1 ? "Rasterize x%u" : "Rasterize", ThreadCount);
+		AddResult(Mode, RasterizeMilliseconds, Triangles);
+		snprintf(Mode, sizeof(Mode), ThreadCount > 1 ? "Test x%u" : "Test", ThreadCount);
+		AddResult(Mode, TestMilliseconds, Tests);
+	}
+	return true;
+}
+
+bool OcclusionBenchmark::CheckBasics()
+{
+	//Camera at the origin looking down +Z at a wall filling the view at Z = 10
+	Matrix4x4 ViewProjection = Multiply(
+		MatrixPerspectiveFovLH(1.0472f, static_cast<float>(mSettings.Width) / mSettings.Height, 0.5f, 100.0f),
+		MatrixLookAtLH(MakeFloat3(0.0f, 0.0f, 0.0f), MakeFloat3(0.0f, 0.0f, 1.0f), MakeFloat3(0.0f, 1.0f, 0.0f)));
+	const Float3 Wall[4] =
+	{
+		MakeFloat3(-100.0f, -100.0f, 10.0f), MakeFloat3(100.0f, -100.0f, 10.0f),
+		MakeFloat3(100.0f, 100.0f, 10.0f), MakeFloat3(-100.0f, 100.0f, 10.0f)
+	};
+	const uint32_t WallIndices[6] = { 0, 1, 2, 0, 2, 3 };
+
+	Aabb Behind = { MakeFloat3(-1.0f, -1.0f, 20.0f), MakeFloat3(1.0f, 1.0f, 22.0f) };
+	Aabb InFront = { MakeFloat3(-1.0f, -1.0f, 5.0f), MakeFloat3(1.0f, 1.0f, 7.0f) };
+	Aabb Through = { MakeFloat3(-1.0f, -1.0f, 9.0f), MakeFloat3(1.0f, 1.0f, 11.0f) };
+	Aabb AcrossNear = { MakeFloat3(-1.0f, -1.0f, -1.0f), MakeFloat3(1.0f, 1.0f, 22.0f) };
+
+	OcclusionCuller Culler(mSettings.Width, mSettings.Height);
+	Culler.BeginFrame(ViewProjection);
+	Culler.RasterizeOccluders();
+	if (Culler.IsOccluded(Behind))
+	{
+		mLastError = "A box was occluded with no occluders";
+		return false;
+	}
+
+	Culler.AddOccluder(Wall, 4, WallIndices, 6, Matrix3x4Identity());
+	Culler.RasterizeOccluders();
+	if (!Culler.IsOccluded(Behind))
+	{
+		mLastError = "A box behind a wall wasn't occluded";
+		return false;
+	}
+	if (Culler.IsOccluded(InFront) || Culler.IsOccluded(Through) || Culler.IsOccluded(AcrossNear))
+	{
+		mLastError = "A box in front of or through a wall was occluded";
+		return false;
+	}
+	return true;
+}
+
+void OcclusionBenchmark::AddResult(const std::string& Mode, double Milliseconds, uint64_t Items)
+{
+	OcclusionBenchmarkResult Result;
+	Result.Mode = Mode;
+	Result.MillisecondsPerPass = Milliseconds / mSettings.Iterations;
+	Result.ItemsPerMillisecond = Milliseconds > 0.0 ? Items / Milliseconds : 0.0;
+	mResults.push_back(Result);
+}
+
+bool OcclusionBenchmark::WriteReport(const char* Filename) const
+{
+	FILE* File = fopen(Filename, "w");
+	if (!File)
+	{
+		return false;
+	}
+
+	fprintf(File, "Backend:            %s\n", GetSimdBackendName());
+	fprintf(File, "Depth buffer:       %ux%u\n", mSettings.Width, mSettings.Height);
+	fprintf(File, "Iterations:         %u\n", mSettings.Iterations);
+	fprintf(File, "Occluder triangles: %u per pass\n", mOccluderTriangles);
+	fprintf(File, "Occludees:          %u, %u per pass in the frustum\n", mSettings.OccludeeCount,
+		mFrustumVisible / mSettings.Iterations);
+	fprintf(File, "Occluded:           %.1f%% of those in the frustum\n",
+		mFrustumVisible > 0 ? 100.0 * mOccluded / mFrustumVisible : 0.0);
+	fprintf(File, "False negatives:    %u of %u sampled (%.2f%%)\n\n", mFalseNegatives, mSampled,
+		mSampled > 0 ? 100.0 * mFalseNegatives / mSampled : 0.0);
+	fprintf(File, "Mode,MsPerPass,ItemsPerMs\n");
+	for (const OcclusionBenchmarkResult& Result : mResults)
+	{
+		fprintf(File, "%s,%.3f,%.1f\n", Result.Mode.c_str(), Result.MillisecondsPerPass, Result.ItemsPerMillisecond);
+	}
+
+	fclose(File);
+	return true;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//Occlusion culling on a generated city: a grid of tessellated box buildings
+//as occluders, and OccludeeCount small boxes scattered between them, seen
+//from the edge of the city. Measures:
+//	Rasterize	- occluder setup and rasterization, in triangles per ms
+//	Test		- CullOccluded() on the frustum culled occludees, in tests per ms
+//each on one thread and split across ThreadCounts threads.
+//
+//Also estimates the false negative rate - occludees culled that are actually
+//visible - by casting rays from the eye to points over SampledOccludees of
+//the culled boxes, against the buildings' exact shapes. Run() fails if a
+//basic visibility check does.
+struct OcclusionBenchmarkSettings
+{
+	uint32_t Width = 256;
+	uint32_t Height = 144;
+	uint32_t BuildingsPerSide = 20;
+	uint32_t FaceSubdivisions = 4;
+	uint32_t OccludeeCount = 100000;
+	std::vector<uint32_t> ThreadCounts = { 2, 4, 8 };
+	uint32_t Iterations = 20;
+	uint32_t SampledOccludees = 2000;
+};
+
+struct OcclusionBenchmarkResult
+{
+	std::string Mode;
+	double MillisecondsPerPass = 0.0;
+	double ItemsPerMillisecond = 0.0;
+};
+
+class OcclusionBenchmark
+{
+public:
+	OcclusionBenchmark(const OcclusionBenchmarkSettings& Settings);
+	~OcclusionBenchmark();
+
+	bool Run();
+	bool WriteReport(const char* Filename) const;
+
+	const std::string& GetLastError() const { return mLastError; }
+
+private:
+	bool CheckBasics();
+
+	void AddResult(const std::string& Mode, double Milliseconds, uint64_t Items);
+
+private:
+	OcclusionBenchmarkSettings mSettings;
+	std::vector<OcclusionBenchmarkResult> mResults;
+
+	uint32_t mOccluderTriangles;
+	uint32_t mFrustumVisible;
+	uint32_t mOccluded;
+	uint32_t mSampled;
+	uint32_t mFalseNegatives;
+
+	std::string mLastError;
+};
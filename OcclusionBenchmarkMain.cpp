@@ -0,0 +1,72 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "OcclusionBenchmark.h"
+
+//Occlusion culling benchmark:
+//	OcclusionBenchmark [-iterations N] [-resolution W H] [-buildings N] [-subdivisions N] [-occludees N]
+//		[-samples N] [-threads N ...]
+//Writes OcclusionBenchmark.txt to the current directory.
+int main(int argc, char** argv)
+{
+	OcclusionBenchmarkSettings Settings;
+	bool bCustomThreads = false;
+	bool bValid = true;
+	for (int i = 1; i < argc && bValid; ++i)
+	{
+		if (strcmp(argv[i], "-iterations") == 0 && i + 1 < argc)
+		{
+			Settings.Iterations = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-resolution") == 0 && i + 2 < argc)
+		{
+			Settings.Width = static_cast<uint32_t>(atoi(argv[++i]));
+			Settings.Height = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-buildings") == 0 && i + 1 < argc)
+		{
+			Settings.BuildingsPerSide = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-subdivisions") == 0 && i + 1 < argc)
+		{
+			Settings.FaceSubdivisions = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-occludees") == 0 && i + 1 < argc)
+		{
+			Settings.OccludeeCount = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-samples") == 0 && i + 1 < argc)
+		{
+			Settings.SampledOccludees = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc)
+		{
+			if (!bCustomThreads)
+			{
+				Settings.ThreadCounts.clear();
+				bCustomThreads = true;
+			}
+			Settings.ThreadCounts.push_back(static_cast<uint32_t>(atoi(argv[++i])));
+		}
+		else
+		{
+			bValid = false;
+		}
+	}
+
+	if (!bValid || Settings.Iterations == 0)
+	{
+		fprintf(stderr, "Usage: OcclusionBenchmark [-iterations N] [-resolution W H] [-buildings N] [-subdivisions N] "
+			"[-occludees N] [-samples N] [-threads N ...]\n");
+		return 1;
+	}
+
+	OcclusionBenchmark Benchmark(Settings);
+	if (!Benchmark.Run())
+	{
+		fprintf(stderr, "%s\n", Benchmark.GetLastError().c_str());
+		return 1;
+	}
+	return Benchmark.WriteReport("OcclusionBenchmark.txt") ? 0 : 1;
+}
@@ -0,0 +1,406 @@
+#include "OcclusionCuller.h"
+#include "Common.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+
+namespace
+{
+	typedef SimdFloat8 DepthFloat;
+
+	static_assert(OcclusionCuller::TileSize % DepthFloat::Width == 0, "Tile rows are whole SIMD groups");
+	static_assert(OcclusionCuller::BinWidth % OcclusionCuller::TileSize == 0, "Bins are whole tiles");
+	static_assert(OcclusionCuller::BinHeight % OcclusionCuller::TileSize == 0, "Bins are whole tiles");
+
+	//Anything nearer the eye than this in clip w can't be projected safely
+	const float MinimumW = 1e-5f;
+
+	//Smaller than this in pixels squared can't cover a whole pixel anyway
+	const float MinimumArea = 1e-4f;
+
+	//Occludees per job in CullOccluded()
+	const uint32_t OccludeeBatchSize = 1024;
+
+	float Clamp(float Value, float Low, float High)
+	{
+		return std::min(std::max(Value, Low), High);
+	}
+
+	DepthFloat PixelCentreOffsets()
+	{
+		alignas(32) float Offsets[DepthFloat::Width];
+		for (uint32_t Lane = 0; Lane < DepthFloat::Width; ++Lane)
+		{
+			Offsets[Lane] = static_cast<float>(Lane) + 0.5f;
+		}
+		return DepthFloat::Load(Offsets);
+	}
+}
+
+OcclusionCuller::OcclusionCuller(uint32_t Width, uint32_t Height)
+	: mWidth(Width), mHeight(Height)
+{
+	Check(Width > 0 && Height > 0 && Width % TileSize == 0 && Height % TileSize == 0);
+
+	mTilesX = Width / TileSize;
+	mBinsX = (Width + BinWidth - 1) / BinWidth;
+	mBinsY = (Height + BinHeight - 1) / BinHeight;
+
+	mDepth.assign(static_cast<size_t>(Width) * Height, 1.0f);
+	mTileMaxDepth.assign(mTilesX * (Height / TileSize), 1.0f);
+	mBinTriangles.resize(mBinsX * mBinsY);
+	mViewProjection = MakeMatrix4x4(Matrix3x4Identity());
+}
+
+OcclusionCuller::~OcclusionCuller()
+{}
+
+void OcclusionCuller::BeginFrame(const Matrix4x4& ViewProjection)
+{
+	mViewProjection = ViewProjection;
+	std::fill(mDepth.begin(), mDepth.end(), 1.0f);
+	std::fill(mTileMaxDepth.begin(), mTileMaxDepth.end(), 1.0f);
+	mTriangles.clear();
+	mStats = OcclusionCullStats();
+}
+
+void OcclusionCuller::AddOccluder(const Float3* Positions, uint32_t VertexCount, const uint32_t* Indices, uint32_t IndexCount,
+	const Matrix3x4& World)
+{
+	Matrix4x4 ToClip = Multiply(mViewProjection, MakeMatrix4x4(World));
+	for (uint32_t i = 0; i + 2 < IndexCount; i += 3)
+	{
+		Assert(Indices[i] < VertexCount && Indices[i + 1] < VertexCount && Indices[i + 2] < VertexCount);
+		SetupTriangle(TransformPoint(ToClip, Positions[Indices[i]]), TransformPoint(ToClip, Positions[Indices[i + 1]]),
+			TransformPoint(ToClip, Positions[Indices[i + 2]]));
+	}
+	mStats.OccluderTriangles += IndexCount / 3;
+}
+
+void OcclusionCuller::SetupTriangle(const Float4& V0, const Float4& V1, const Float4& V2)
+{
+	//Crossing the near plane would need clipping - dropping it is the safe side
+	if (V0.W < MinimumW || V1.W < MinimumW || V2.W < MinimumW || V0.Z < 0.0f || V1.Z < 0.0f || V2.Z < 0.0f)
+	{
+		return;
+	}
+
+	const Float4* Clip[3] = { &V0, &V1, &V2 };
+	float X[3], Y[3], Z[3];
+	for (int i = 0; i < 3; ++i)
+	{
+		float InverseW = 1.0f / Clip[i]->W;
+		X[i] = (Clip[i]->X * InverseW * 0.5f + 0.5f) * mWidth;
+		Y[i] = (0.5f - Clip[i]->Y * InverseW * 0.5f) * mHeight;
+		Z[i] = Clip[i]->Z * InverseW;
+	}
+
+	//Clamped before converting, vertices near w = 0 can be far outside int range
+	float Width = static_cast<float>(mWidth);
+	float Height = static_cast<float>(mHeight);
+	Triangle Tri;
+	Tri.MinX = static_cast<int32_t>(floorf(Clamp(std::min({ X[0], X[1], X[2] }), 0.0f, Width)));
+	Tri.MinY = static_cast<int32_t>(floorf(Clamp(std::min({ Y[0], Y[1], Y[2] }), 0.0f, Height)));
+	Tri.MaxX = static_cast<int32_t>(ceilf(Clamp(std::max({ X[0], X[1], X[2] }), 0.0f, Width))) - 1;
+	Tri.MaxY = static_cast<int32_t>(ceilf(Clamp(std::max({ Y[0], Y[1], Y[2] }), 0.0f, Height))) - 1;
+	if (Tri.MinX > Tri.MaxX || Tri.MinY > Tri.MaxY)
+	{
+		return;
+	}
+
+	float Area = (X[1] - X[0]) * (Y[2] - Y[0]) - (X[2] - X[0]) * (Y[1] - Y[0]);
+	if (fabsf(Area) < MinimumArea)
+	{
+		return;
+	}
+	if (Area < 0.0f)
+	{
+		std::swap(X[1], X[2]);
+		std::swap(Y[1], Y[2]);
+		std::swap(Z[1], Z[2]);
+		Area = -Area;
+	}
+
+	//Edge i runs from vertex i to the next, tested at pixel centres. Shrinking
+	//edges to whole pixels would leave gaps along every edge two triangles
+	//share, so meshes wouldn't occlude anything behind their seams.
+	for (int i = 0; i < 3; ++i)
+	{
+		int Next = (i + 1) % 3;
+		float A = Y[i] - Y[Next];
+		float B = X[Next] - X[i];
+		Tri.EdgeA[i] = A;
+		Tri.EdgeB[i] = B;
+		Tri.EdgeC[i] = -A * X[i] - B * Y[i];
+	}
+
+	//Depth is linear in screen space after the divide. The farthest point of
+	//a pixel is half a pixel's slope past its centre.
+	float InverseArea = 1.0f / Area;
+	Tri.DepthA = ((Z[1] - Z[0]) * (Y[2] - Y[0]) - (Z[2] - Z[0]) * (Y[1] - Y[0])) * InverseArea;
+	Tri.DepthB = ((X[1] - X[0]) * (Z[2] - Z[0]) - (X[2] - X[0]) * (Z[1] - Z[0])) * InverseArea;
+	Tri.DepthC = Z[0] - Tri.DepthA * X[0] - Tri.DepthB * Y[0] + 0.5f * (fabsf(Tri.DepthA) + fabsf(Tri.DepthB));
+	Tri.MaxDepth = std::max({ Z[0], Z[1], Z[2] });
+
+	mTriangles.push_back(Tri);
+}
+
+void OcclusionCuller::RasterizeOccluders(JobSystem* Jobs)
+{
+	for (std::vector<uint32_t>& Bin : mBinTriangles)
+	{
+		Bin.clear();
+	}
+
+	for (uint32_t Index = 0; Index < mTriangles.size(); ++Index)
+	{
+		const Triangle& Tri = mTriangles[Index];
+		for (uint32_t BinY = Tri.MinY / BinHeight; BinY <= Tri.MaxY / BinHeight; ++BinY)
+		{
+			for (uint32_t BinX = Tri.MinX / BinWidth; BinX <= Tri.MaxX / BinWidth; ++BinX)
+			{
+				mBinTriangles[BinY * mBinsX + BinX].push_back(Index);
+			}
+		}
+	}
+
+	//Bins don't share pixels or tiles, so they can run in any order
+	uint32_t BinCount = mBinsX * mBinsY;
+	if (Jobs)
+	{
+		Jobs->ParallelFor(BinCount, 1, [this](uint32_t Begin, uint32_t End)
+		{
+			for (uint32_t Bin = Begin; Bin < End; ++Bin)
+			{
+				RasterizeBin(Bin);
+			}
+		});
+	}
+	else
+	{
+		for (uint32_t Bin = 0; Bin < BinCount; ++Bin)
+		{
+			RasterizeBin(Bin);
+		}
+	}
+
+	mStats.TrianglesRasterized = static_cast<uint32_t>(mTriangles.size());
+}
+
+void OcclusionCuller::RasterizeBin(uint32_t Bin)
+{
+	uint32_t BinX = Bin % mBinsX;
+	uint32_t BinY = Bin / mBinsX;
+	int32_t MinX = BinX * BinWidth;
+	int32_t MinY = BinY * BinHeight;
+	int32_t MaxX = std::min<int32_t>(MinX + BinWidth, mWidth) - 1;
+	int32_t MaxY = std::min<int32_t>(MinY + BinHeight, mHeight) - 1;
+
+	for (uint32_t Index : mBinTriangles[Bin])
+	{
+		RasterizeTriangle(mTriangles[Index], MinX, MinY, MaxX, MaxY);
+	}
+	UpdateTiles(BinX, BinY);
+}
+
+void OcclusionCuller::RasterizeTriangle(const Triangle& Tri, int32_t BinMinX, int32_t BinMinY, int32_t BinMaxX, int32_t BinMaxY)
+{
+	//Groups start on a multiple of the width. Bins are whole tiles, so a
+	//group never leaves the bin; lanes past the triangle fail the edge test.
+	int32_t StartX = std::max(Tri.MinX, BinMinX) / static_cast<int32_t>(DepthFloat::Width) * DepthFloat::Width;
+	int32_t EndX = std::min(Tri.MaxX, BinMaxX);
+	int32_t StartY = std::max(Tri.MinY, BinMinY);
+	int32_t EndY = std::min(Tri.MaxY, BinMaxY);
+
+	const DepthFloat Zero = DepthFloat::Splat(0.0f);
+	const DepthFloat CentreOffsets = PixelCentreOffsets();
+	const DepthFloat MaxDepth = DepthFloat::Splat(Tri.MaxDepth);
+	DepthFloat EdgeA[3], EdgeB[3], EdgeC[3];
+	for (int i = 0; i < 3; ++i)
+	{
+		EdgeA[i] = DepthFloat::Splat(Tri.EdgeA[i]);
+		EdgeB[i] = DepthFloat::Splat(Tri.EdgeB[i]);
+		EdgeC[i] = DepthFloat::Splat(Tri.EdgeC[i]);
+	}
+	const DepthFloat DepthA = DepthFloat::Splat(Tri.DepthA);
+	const DepthFloat DepthB = DepthFloat::Splat(Tri.DepthB);
+	const DepthFloat DepthC = DepthFloat::Splat(Tri.DepthC);
+
+	for (int32_t Y = StartY; Y <= EndY; ++Y)
+	{
+		float* Row = &mDepth[static_cast<size_t>(Y) * mWidth];
+		DepthFloat CentreY = DepthFloat::Splat(static_cast<float>(Y) + 0.5f);
+
+		for (int32_t X = StartX; X <= EndX; X += DepthFloat::Width)
+		{
+			DepthFloat CentreX = DepthFloat::Splat(static_cast<float>(X)) + CentreOffsets;
+
+			DepthFloat Inside = And(
+				And(CompareGreaterEqual(EdgeA[0] * CentreX + EdgeB[0] * CentreY + EdgeC[0], Zero),
+					CompareGreaterEqual(EdgeA[1] * CentreX + EdgeB[1] * CentreY + EdgeC[1], Zero)),
+				CompareGreaterEqual(EdgeA[2] * CentreX + EdgeB[2] * CentreY + EdgeC[2], Zero));
+			if (GetMaskBits(Inside) == 0)
+			{
+				continue;
+			}
+
+			DepthFloat Depth = Min(DepthA * CentreX + DepthB * CentreY + DepthC, MaxDepth);
+			DepthFloat Existing = DepthFloat::LoadUnaligned(Row + X);
+			Select(Inside, Min(Existing, Depth), Existing).StoreUnaligned(Row + X);
+		}
+	}
+}
+
+void OcclusionCuller::UpdateTiles(uint32_t BinX, uint32_t BinY)
+{
+	uint32_t TileBeginX = BinX * BinWidth / TileSize;
+	uint32_t TileBeginY = BinY * BinHeight / TileSize;
+	uint32_t TileEndX = std::min((BinX + 1) * BinWidth, mWidth) / TileSize;
+	uint32_t TileEndY = std::min((BinY + 1) * BinHeight, mHeight) / TileSize;
+
+	for (uint32_t TileY = TileBeginY; TileY < TileEndY; ++TileY)
+	{
+		for (uint32_t TileX = TileBeginX; TileX < TileEndX; ++TileX)
+		{
+			DepthFloat Farthest = DepthFloat::Splat(0.0f);
+			for (uint32_t Y = TileY * TileSize; Y < (TileY + 1) * TileSize; ++Y)
+			{
+				const float* Row = &mDepth[static_cast<size_t>(Y) * mWidth];
+				for (uint32_t X = TileX * TileSize; X < (TileX + 1) * TileSize; X += DepthFloat::Width)
+				{
+					Farthest = Max(Farthest, DepthFloat::LoadUnaligned(Row + X));
+				}
+			}
+
+			float TileMax = 0.0f;
+			for (uint32_t Lane = 0; Lane < DepthFloat::Width; ++Lane)
+			{
+				TileMax = std::max(TileMax, Farthest.GetLane(Lane));
+			}
+			mTileMaxDepth[TileY * mTilesX + TileX] = TileMax;
+		}
+	}
+}
+
+bool OcclusionCuller::ProjectBox(const Aabb& Box, float& OutNearestDepth, int32_t& OutMinX, int32_t& OutMinY,
+	int32_t& OutMaxX, int32_t& OutMaxY) const
+{
+	float MinX = 1e30f, MinY = 1e30f, MaxX = -1e30f, MaxY = -1e30f;
+	float Nearest = 1.0f;
+	for (int Corner = 0; Corner < 8; ++Corner)
+	{
+		Float3 Position = MakeFloat3((Corner & 1) ? Box.Max.X : Box.Min.X, (Corner & 2) ? Box.Max.Y : Box.Min.Y,
+			(Corner & 4) ? Box.Max.Z : Box.Min.Z);
+		Float4 Clip = TransformPoint(mViewProjection, Position);
+		if (Clip.W < MinimumW || Clip.Z < 0.0f)
+		{
+			return false;
+		}
+
+		float InverseW = 1.0f / Clip.W;
+		float X = (Clip.X * InverseW * 0.5f + 0.5f) * mWidth;
+		float Y = (0.5f - Clip.Y * InverseW * 0.5f) * mHeight;
+		MinX = std::min(MinX, X);
+		MinY = std::min(MinY, Y);
+		MaxX = std::max(MaxX, X);
+		MaxY = std::max(MaxY, Y);
+		Nearest = std::min(Nearest, Clip.Z * InverseW);
+	}
+
+	float Width = static_cast<float>(mWidth);
+	float Height = static_cast<float>(mHeight);
+	if (MaxX < 0.0f || MaxY < 0.0f || MinX >= Width || MinY >= Height)
+	{
+		return false;
+	}
+
+	//Every pixel the box touches at all
+	OutMinX = static_cast<int32_t>(floorf(std::max(MinX, 0.0f)));
+	OutMinY = static_cast<int32_t>(floorf(std::max(MinY, 0.0f)));
+	OutMaxX = std::min(static_cast<int32_t>(floorf(std::min(MaxX, Width))), static_cast<int32_t>(mWidth) - 1);
+	OutMaxY = std::min(static_cast<int32_t>(floorf(std::min(MaxY, Height))), static_cast<int32_t>(mHeight) - 1);
+	OutNearestDepth = Nearest;
+	return true;
+}
+
+bool OcclusionCuller::IsOccluded(const Aabb& Box) const
+{
+	float Nearest;
+	int32_t MinX, MinY, MaxX, MaxY;
+	if (!ProjectBox(Box, Nearest, MinX, MinY, MaxX, MaxY))
+	{
+		//Off screen is for frustum culling to decide
+		return false;
+	}
+
+	const DepthFloat BoxNearest = DepthFloat::Splat(Nearest);
+	const DepthFloat CentreOffsets = PixelCentreOffsets() - DepthFloat::Splat(0.5f);
+	const DepthFloat First = DepthFloat::Splat(static_cast<float>(MinX) - 0.5f);
+	const DepthFloat Last = DepthFloat::Splat(static_cast<float>(MaxX) + 0.5f);
+
+	for (int32_t TileY = MinY / TileSize; TileY <= MaxY / static_cast<int32_t>(TileSize); ++TileY)
+	{
+		for (int32_t TileX = MinX / TileSize; TileX <= MaxX / static_cast<int32_t>(TileSize); ++TileX)
+		{
+			//The whole tile is nearer than the box
+			if (mTileMaxDepth[TileY * mTilesX + TileX] < Nearest)
+			{
+				continue;
+			}
+
+			int32_t BeginY = std::max<int32_t>(TileY * TileSize, MinY);
+			int32_t EndY = std::min<int32_t>((TileY + 1) * TileSize - 1, MaxY);
+			for (int32_t Y = BeginY; Y <= EndY; ++Y)
+			{
+				const float* Row = &mDepth[static_cast<size_t>(Y) * mWidth];
+				for (int32_t X = TileX * TileSize; X < (TileX + 1) * static_cast<int32_t>(TileSize); X += DepthFloat::Width)
+				{
+					//Only the box's columns count
+					DepthFloat Column = DepthFloat::Splat(static_cast<float>(X)) + CentreOffsets;
+					DepthFloat InBox = And(CompareGreater(Column, First), CompareLess(Column, Last));
+					DepthFloat NotHidden = CompareGreaterEqual(DepthFloat::LoadUnaligned(Row + X), BoxNearest);
+					if (GetMaskBits(And(InBox, NotHidden)) != 0)
+					{
+						return false;
+					}
+				}
+			}
+		}
+	}
+	return true;
+}
+
+uint32_t OcclusionCuller::CullOccluded(const Aabb* Boxes, std::vector<uint32_t>& Visible, JobSystem* Jobs)
+{
+	uint32_t Count = static_cast<uint32_t>(Visible.size());
+	mOccludedScratch.resize(Count);
+
+	auto TestRange = [this, Boxes, &Visible](uint32_t Begin, uint32_t End)
+	{
+		for (uint32_t i = Begin; i < End; ++i)
+		{
+			mOccludedScratch[i] = IsOccluded(Boxes[Visible[i]]) ? 1 : 0;
+		}
+	};
+
+	if (Jobs && Count > OccludeeBatchSize)
+	{
+		Jobs->ParallelFor(Count, OccludeeBatchSize, TestRange);
+	}
+	else
+	{
+		TestRange(0, Count);
+	}
+
+	uint32_t Kept = 0;
+	for (uint32_t i = 0; i < Count; ++i)
+	{
+		Visible[Kept] = Visible[i];
+		Kept += 1 - mOccludedScratch[i];
+	}
+	Visible.resize(Kept);
+
+	mStats.OccludeesTested += Count;
+	mStats.OccludeesOccluded += Count - Kept;
+	return Kept;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "VectorMath.h"
+
+class JobSystem;
+
+struct OcclusionCullStats
+{
+	uint32_t OccluderTriangles = 0;		//Submitted this frame
+	uint32_t TrianglesRasterized = 0;	//After near plane, size and screen rejection
+	uint32_t OccludeesTested = 0;
+	uint32_t OccludeesOccluded = 0;
+};
+
+//CPU occlusion culling against a small depth buffer.
+//
+//Each frame: BeginFrame() with the camera, AddOccluder() for a few big
+//meshes likely to hide things, RasterizeOccluders(), then IsOccluded() or
+//CullOccluded() for the bounding boxes of everything else.
+//
+//Depths err towards visible. Occluders write the farthest depth they reach
+//within each pixel they cover, and triangles crossing the near plane are
+//dropped. Occludees are tested with their nearest depth over every pixel
+//their projected box touches, and anything crossing the near plane is
+//visible. Coverage is at pixel centres, so meshes are watertight, but an
+//occluder's silhouette can claim up to half a pixel it doesn't cover - an
+//occludee peeking out by less than that may be culled.
+//
+//Rasterization is binned: triangles are set up once, sorted in to screen
+//bins, and bins are rasterized independently across the job system. Each
+//TileSize square of pixels also keeps its farthest depth, so most occludee
+//tests only read a few tiles. Both the rasterizer and the pixel level test
+//work on SimdFloat8::Width pixels of a row at once.
+class OcclusionCuller
+{
+public:
+	static const uint32_t TileSize = 8;
+	static const uint32_t BinWidth = 64;
+	static const uint32_t BinHeight = 32;
+
+	//Width and Height must be multiples of TileSize.
+	OcclusionCuller(uint32_t Width = 256, uint32_t Height = 144);
+	~OcclusionCuller();
+
+	//Clears the depth buffer and occluders for a new view.
+	void BeginFrame(const Matrix4x4& ViewProjection);
+
+	//Positions are in object space, three indices per triangle. Both sides
+	//occlude.
+	void AddOccluder(const Float3* Positions, uint32_t VertexCount, const uint32_t* Indices, uint32_t IndexCount,
+		const Matrix3x4& World);
+
+	void RasterizeOccluders(JobSystem* Jobs = nullptr);
+
+	//World space box. True only if it's certainly hidden by the occluders.
+	bool IsOccluded(const Aabb& Box) const;
+
+	//Removes occluded entries from Visible (indices in to Boxes), keeping
+	//the order. Returns how many are left.
+	uint32_t CullOccluded(const Aabb* Boxes, std::vector<uint32_t>& Visible, JobSystem* Jobs = nullptr);
+
+	uint32_t GetWidth() const { return mWidth; }
+	uint32_t GetHeight() const { return mHeight; }
+
+	//0 at the near plane to 1 at the far, row major from the top left.
+	const float* GetDepthBuffer() const { return mDepth.data(); }
+
+	const OcclusionCullStats& GetLastFrameStats() const { return mStats; }
+
+private:
+	//Screen space, oriented so E(x, y) >= 0 inside
+	struct Triangle
+	{
+		float EdgeA[3], EdgeB[3], EdgeC[3];
+		float DepthA, DepthB, DepthC;	//Depth plane z = A x + B y + C
+		float MaxDepth;
+		int32_t MinX, MinY, MaxX, MaxY;	//Pixel bounds, inclusive
+	};
+
+	void SetupTriangle(const Float4& V0, const Float4& V1, const Float4& V2);
+	void RasterizeBin(uint32_t Bin);
+	void RasterizeTriangle(const Triangle& Tri, int32_t BinMinX, int32_t BinMinY, int32_t BinMaxX, int32_t BinMaxY);
+	void UpdateTiles(uint32_t BinX, uint32_t BinY);
+
+	//Nearest depth and pixel bounds of the projected box. False if it
+	//crosses the near plane or misses the screen.
+	bool ProjectBox(const Aabb& Box, float& OutNearestDepth, int32_t& OutMinX, int32_t& OutMinY,
+		int32_t& OutMaxX, int32_t& OutMaxY) const;
+
+private:
+	uint32_t mWidth;
+	uint32_t mHeight;
+	uint32_t mTilesX;
+	uint32_t mBinsX;
+	uint32_t mBinsY;
+
+	Matrix4x4 mViewProjection;
+
+	std::vector<float> mDepth;
+	std::vector<float> mTileMaxDepth;	//Farthest depth in each tile
+
+	std::vector<Triangle> mTriangles;
+	std::vector<std::vector<uint32_t>> mBinTriangles;
+
+	std::vector<uint8_t> mOccludedScratch;
+
+	OcclusionCullStats mStats;
+};
@@ -0,0 +1,250 @@
+#include "PackArchive.h"
+#include "BlockCompression.h"
+#include "Hash.h"
+#include "JobSystem.h"
+
+#include <atomic>
+#include <cctype>
+#include <cstring>
+
+namespace
+{
+	bool RangeInside(uint64_t Offset, uint64_t Size, uint64_t Limit)
+	{
+		return Offset <= Limit && Size <= Limit - Offset;
+	}
+
+	inline uint32_t GetFanoutBucket(uint64_t NameHash, uint32_t FanoutBits)
+	{
+		return FanoutBits ? static_cast<uint32_t>(NameHash >> (64 - FanoutBits)) : 0;
+	}
+}
+
+PackArchive::PackArchive()
+	: mHeader(nullptr), mEntries(nullptr), mFanout(nullptr), mBlocks(nullptr), mNames(nullptr)
+{}
+
+PackArchive::~PackArchive()
+{
+	Close();
+}
+
+bool PackArchive::Open(const char* Filename)
+{
+	Close();
+
+	if (!mFile.Open(Filename))
+	{
+		return false;
+	}
+
+	if (!Validate())
+	{
+		Close();
+		return false;
+	}
+
+	const uint8_t* Data = mFile.GetData();
+	mHeader = reinterpret_cast<const PackArchiveHeader*>(Data);
+	mEntries = reinterpret_cast<const PackArchiveEntry*>(Data + mHeader->EntryTableOffset);
+	mFanout = reinterpret_cast<const uint32_t*>(Data + mHeader->FanoutTableOffset);
+	mBlocks = reinterpret_cast<const PackArchiveBlock*>(Data + mHeader->BlockTableOffset);
+	mNames = reinterpret_cast<const char*>(Data + mHeader->NameTableOffset);
+	return true;
+}
+
+void PackArchive::Close()
+{
+	mHeader = nullptr;
+	mEntries = nullptr;
+	mFanout = nullptr;
+	mBlocks = nullptr;
+	mNames = nullptr;
+	mFile.Close();
+}
+
+std::string PackArchive::NormaliseName(const std::string& Name)
+{
+	std::string Normalised = Name;
+	for (char& C : Normalised)
+	{
+		C = C == '\\' ? '/' : static_cast<char>(tolower(static_cast<unsigned char>(C)));
+	}
+	return Normalised;
+}
+
+uint64_t PackArchive::HashName(const std::string& Name)
+{
+	return HashString(NormaliseName(Name));
+}
+
+uint32_t PackArchive::FindEntry(uint64_t NameHash) const
+{
+	uint32_t Bucket = GetFanoutBucket(NameHash, mHeader->FanoutBits);
+	uint32_t Low = mFanout[Bucket];
+	uint32_t High = mFanout[Bucket + 1];
+
+	while (Low < High)
+	{
+		uint32_t Middle = Low + (High - Low) / 2;
+		uint64_t MiddleHash = mEntries[Middle].NameHash;
+		if (MiddleHash == NameHash)
+		{
+			return Middle;
+		}
+		if (MiddleHash < NameHash)
+		{
+			Low = Middle + 1;
+		}
+		else
+		{
+			High = Middle;
+		}
+	}
+
+	return InvalidEntry;
+}
+
+const uint8_t* PackArchive::GetEntryData(uint32_t Entry) const
+{
+	if (!IsStored())
+	{
+		return nullptr;
+	}
+
+	const PackArchiveEntry& Record = mEntries[Entry];
+	if (Record.BlockCount == 0)
+	{
+		return mFile.GetData();		//Empty entry - any valid pointer will do
+	}
+	return mFile.GetData() + mBlocks[Record.FirstBlock].Offset;
+}
+
+bool PackArchive::ReadEntry(uint32_t Entry, void* Dest, JobSystem* Jobs) const
+{
+	const PackArchiveEntry& Record = mEntries[Entry];
+	uint8_t* Out = static_cast<uint8_t*>(Dest);
+
+	if (!Jobs || Record.BlockCount <= 1)
+	{
+		for (uint32_t i = 0; i < Record.BlockCount; ++i)
+		{
+			if (!ReadBlock(Record.FirstBlock + i, Out + static_cast<uint64_t>(i) * mHeader->BlockSize))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	std::atomic<bool> bSucceeded(true);
+	Jobs->ParallelFor(Record.BlockCount, 1, [&](uint32_t Begin, uint32_t End)
+	{
+		for (uint32_t i = Begin; i < End; ++i)
+		{
+			if (!ReadBlock(Record.FirstBlock + i, Out + static_cast<uint64_t>(i) * mHeader->BlockSize))
+			{
+				bSucceeded = false;
+			}
+		}
+	});
+	return bSucceeded;
+}
+
+bool PackArchive::ReadBlock(uint32_t Block, uint8_t* Dest) const
+{
+	const PackArchiveBlock& Record = mBlocks[Block];
+	const uint8_t* Source = mFile.GetData() + Record.Offset;
+
+	if (Record.CompressedSize == Record.UncompressedSize)
+	{
+		memcpy(Dest, Source, Record.UncompressedSize);
+		return true;
+	}
+	return BlockDecompress(Source, Record.CompressedSize, Dest, Record.UncompressedSize);
+}
+
+bool PackArchive::Validate() const
+{
+	const uint8_t* Data = mFile.GetData();
+	uint64_t Size = mFile.GetSize();
+	if (Size < sizeof(PackArchiveHeader))
+	{
+		return false;
+	}
+
+	const PackArchiveHeader* Header = reinterpret_cast<const PackArchiveHeader*>(Data);
+	if (Header->Magic != PackArchiveMagic || Header->Version != PackArchiveVersion || Header->FileSize > Size ||
+		Header->BlockSize == 0 || Header->FanoutBits > 24)
+	{
+		return false;
+	}
+
+	uint64_t FileSize = Header->FileSize;
+	uint64_t FanoutCount = (1ull << Header->FanoutBits) + 1;
+	if (Header->EntryTableOffset % 8 != 0 || Header->FanoutTableOffset % 4 != 0 || Header->BlockTableOffset % 8 != 0 ||
+		!RangeInside(Header->EntryTableOffset, static_cast<uint64_t>(Header->EntryCount) * sizeof(PackArchiveEntry), FileSize) ||
+		!RangeInside(Header->FanoutTableOffset, FanoutCount * sizeof(uint32_t), FileSize) ||
+		!RangeInside(Header->BlockTableOffset, static_cast<uint64_t>(Header->BlockCount) * sizeof(PackArchiveBlock), FileSize) ||
+		!RangeInside(Header->NameTableOffset, Header->NameTableSize, FileSize) ||
+		Header->NameTableSize == 0 || Data[Header->NameTableOffset + Header->NameTableSize - 1] != 0)
+	{
+		return false;
+	}
+
+	//Fanout must be monotonic and cover every entry
+	const uint32_t* Fanout = reinterpret_cast<const uint32_t*>(Data + Header->FanoutTableOffset);
+	if (Fanout[0] != 0 || Fanout[FanoutCount - 1] != Header->EntryCount)
+	{
+		return false;
+	}
+	for (uint64_t i = 1; i < FanoutCount; ++i)
+	{
+		if (Fanout[i] < Fanout[i - 1])
+		{
+			return false;
+		}
+	}
+
+	const PackArchiveBlock* Blocks = reinterpret_cast<const PackArchiveBlock*>(Data + Header->BlockTableOffset);
+	for (uint32_t i = 0; i < Header->BlockCount; ++i)
+	{
+		if (Blocks[i].UncompressedSize > Header->BlockSize || Blocks[i].CompressedSize > BlockCompressBound(Header->BlockSize) ||
+			!RangeInside(Blocks[i].Offset, Blocks[i].CompressedSize, FileSize) ||
+			((Header->Flags & PackArchiveFlag_Stored) && Blocks[i].CompressedSize != Blocks[i].UncompressedSize))
+		{
+			return false;
+		}
+	}
+
+	//Entries must be sorted and their blocks must exactly cover their size, so
+	//ReadEntry can't write past the caller's buffer
+	const PackArchiveEntry* Entries = reinterpret_cast<const PackArchiveEntry*>(Data + Header->EntryTableOffset);
+	for (uint32_t i = 0; i < Header->EntryCount; ++i)
+	{
+		const PackArchiveEntry& Entry = Entries[i];
+		if ((i > 0 && Entries[i - 1].NameHash >= Entry.NameHash) ||
+			!RangeInside(Entry.FirstBlock, Entry.BlockCount, Header->BlockCount) ||
+			Entry.NameOffset >= Header->NameTableSize ||
+			Entry.BlockCount != (Entry.Size + Header->BlockSize - 1) / Header->BlockSize)
+		{
+			return false;
+		}
+
+		uint64_t Remaining = Entry.Size;
+		for (uint32_t Block = 0; Block < Entry.BlockCount; ++Block)
+		{
+			const PackArchiveBlock& Record = Blocks[Entry.FirstBlock + Block];
+			uint64_t Expected = Remaining < Header->BlockSize ? Remaining : Header->BlockSize;
+			if (Record.UncompressedSize != Expected ||
+				((Header->Flags & PackArchiveFlag_Stored) && Block > 0 &&
+					Record.Offset != Blocks[Entry.FirstBlock + Block - 1].Offset + Header->BlockSize))
+			{
+				return false;
+			}
+			Remaining -= Expected;
+		}
+	}
+
+	return true;
+}
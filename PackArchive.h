@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "MappedFile.h"
+
+class JobSystem;
+
+//Read only archive of many files.
+//
+//File layout:
+//	PackArchiveHeader
+//	PackArchiveEntry[EntryCount]	- sorted by NameHash
+//	uint32_t Fanout[(1 << FanoutBits) + 1]
+//	PackArchiveBlock[BlockCount]
+//	Name table						- NUL terminated, for listing/debugging
+//	Block data
+//
+//Lookup hashes the (normalised) name, uses the top FanoutBits of the hash to
+//find the handful of entries sharing them and binary searches those - O(1)
+//expected, O(log n) worst case.
+//
+//Every entry is split in to fixed size blocks, compressed independently so an
+//entry's blocks can be decompressed in parallel. Stored (uncompressed)
+//archives keep each entry's blocks contiguous so entries can be used straight
+//from the memory mapping with no copy at all.
+
+const uint32_t PackArchiveMagic = 0x4B434150;	//"PACK"
+const uint32_t PackArchiveVersion = 1;
+
+enum PackArchiveFlags
+{
+	PackArchiveFlag_Stored = 1 << 0,	//No compression - see PackArchive::GetEntryData
+};
+
+struct PackArchiveHeader
+{
+	uint32_t Magic;
+	uint32_t Version;
+	uint32_t Flags;
+	uint32_t BlockSize;
+
+	uint32_t EntryCount;
+	uint32_t BlockCount;
+	uint32_t FanoutBits;
+	uint32_t NameTableSize;
+
+	uint64_t EntryTableOffset;
+	uint64_t FanoutTableOffset;
+	uint64_t BlockTableOffset;
+	uint64_t NameTableOffset;
+	uint64_t FileSize;
+};
+
+struct PackArchiveEntry
+{
+	uint64_t NameHash;
+	uint64_t Size;
+	uint32_t FirstBlock;
+	uint32_t BlockCount;
+	uint32_t NameOffset;
+	uint32_t Padding;
+};
+
+struct PackArchiveBlock
+{
+	uint64_t Offset;
+	uint32_t CompressedSize;		//== UncompressedSize when stored raw
+	uint32_t UncompressedSize;
+};
+
+class PackArchive
+{
+public:
+	static const uint32_t InvalidEntry = 0xFFFFFFFF;
+
+	PackArchive();
+	~PackArchive();
+
+	bool Open(const char* Filename);
+	void Close();
+
+	//Names are case insensitive, '\' and '/' are equivalent.
+	static uint64_t HashName(const std::string& Name);
+	static std::string NormaliseName(const std::string& Name);
+
+	uint32_t FindEntry(const std::string& Name) const { return FindEntry(HashName(Name)); }
+	uint32_t FindEntry(uint64_t NameHash) const;
+
+	uint32_t GetEntryCount() const { return mHeader->EntryCount; }
+	uint64_t GetEntrySize(uint32_t Entry) const { return mEntries[Entry].Size; }
+	const char* GetEntryName(uint32_t Entry) const { return mNames + mEntries[Entry].NameOffset; }
+
+	bool IsStored() const { return (mHeader->Flags & PackArchiveFlag_Stored) != 0; }
+
+	//Zero copy view of an entry in a stored archive, null if compressed.
+	const uint8_t* GetEntryData(uint32_t Entry) const;
+
+	//Decompress (or copy) an entry in to Dest, which must hold GetEntrySize()
+	//bytes. Blocks are spread across Jobs when given.
+	bool ReadEntry(uint32_t Entry, void* Dest, JobSystem* Jobs = nullptr) const;
+
+	uint64_t GetArchiveSize() const { return mFile.GetSize(); }
+
+private:
+	PackArchive(const PackArchive&) = delete;
+	PackArchive& operator=(const PackArchive&) = delete;
+
+	bool Validate() const;
+	bool ReadBlock(uint32_t Block, uint8_t* Dest) const;
+
+private:
+	MappedFile mFile;
+
+	const PackArchiveHeader* mHeader;
+	const PackArchiveEntry* mEntries;
+	const uint32_t* mFanout;
+	const PackArchiveBlock* mBlocks;
+	const char* mNames;
+};
@@ -0,0 +1,236 @@
+#include "PackArchiveBuilder.h"
+#include "BlockCompression.h"
+#include "FileUtils.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdio.h>
+
+namespace
+{
+	uint64_t AlignUp(uint64_t Value, uint64_t Alignment)
+	{
+		return (Value + Alignment - 1) & ~(Alignment - 1);
+	}
+
+	struct PendingBlock
+	{
+		uint32_t File;
+		uint64_t SourceOffset;
+		uint32_t Size;
+		std::vector<uint8_t> Compressed;	//Empty when stored raw
+	};
+}
+
+PackArchiveBuilder::PackArchiveBuilder(const PackArchiveBuilderSettings& Settings)
+	: mSettings(Settings)
+{}
+
+PackArchiveBuilder::~PackArchiveBuilder()
+{}
+
+void PackArchiveBuilder::AddFile(const std::string& Name, const std::string& Path)
+{
+	PendingFile File;
+	File.Name = PackArchive::NormaliseName(Name);
+	File.Path = Path;
+	File.NameHash = PackArchive::HashName(Name);
+	mFiles.push_back(File);
+}
+
+void PackArchiveBuilder::AddDirectory(const std::string& Root)
+{
+	std::vector<std::string> Files;
+	ListFilesRecursive(Root, Files);
+	for (const std::string& File : Files)
+	{
+		AddFile(File, JoinPath(Root, File));
+	}
+}
+
+bool PackArchiveBuilder::Write(const char* Filename)
+{
+	mStats = PackArchiveBuildStats();
+
+	if (mSettings.BlockSize == 0 || mSettings.BlockSize > 0x7FFFFFFF)
+	{
+		mLastError = "Bad block size";
+		return false;
+	}
+
+	//Sorted by hash - the runtime index. Names hashing the same would be
+	//indistinguishable at runtime.
+	std::sort(mFiles.begin(), mFiles.end(), [](const PendingFile& A, const PendingFile& B)
+	{
+		return A.NameHash < B.NameHash;
+	});
+	for (size_t i = 1; i < mFiles.size(); ++i)
+	{
+		if (mFiles[i].NameHash == mFiles[i - 1].NameHash)
+		{
+			mLastError = mFiles[i].Name == mFiles[i - 1].Name ?
+				"Duplicate entry " + mFiles[i].Name :
+				"Hash collision between " + mFiles[i - 1].Name + " and " + mFiles[i].Name;
+			return false;
+		}
+	}
+
+	std::vector<std::vector<uint8_t>> Contents(mFiles.size());
+	for (size_t i = 0; i < mFiles.size(); ++i)
+	{
+		if (!ReadWholeFile(mFiles[i].Path, Contents[i]))
+		{
+			mLastError = "Couldn't read " + mFiles[i].Path;
+			return false;
+		}
+	}
+
+	//Split in to blocks and compress them all in parallel
+	std::vector<PackArchiveEntry> Entries(mFiles.size());
+	std::vector<PendingBlock> Blocks;
+	std::string NameTable;
+
+	for (size_t i = 0; i < mFiles.size(); ++i)
+	{
+		PackArchiveEntry& Entry = Entries[i];
+		memset(&Entry, 0, sizeof(Entry));
+		Entry.NameHash = mFiles[i].NameHash;
+		Entry.Size = Contents[i].size();
+		Entry.FirstBlock = static_cast<uint32_t>(Blocks.size());
+		Entry.NameOffset = static_cast<uint32_t>(NameTable.size());
+
+		NameTable += mFiles[i].Name;
+		NameTable += '\0';
+
+		for (uint64_t Offset = 0; Offset < Entry.Size; Offset += mSettings.BlockSize)
+		{
+			PendingBlock Block;
+			Block.File = static_cast<uint32_t>(i);
+			Block.SourceOffset = Offset;
+			Block.Size = static_cast<uint32_t>(std::min<uint64_t>(mSettings.BlockSize, Entry.Size - Offset));
+			Blocks.push_back(std::move(Block));
+			++Entry.BlockCount;
+		}
+
+		mStats.UncompressedBytes += Entry.Size;
+	}
+	if (NameTable.empty())
+	{
+		NameTable += '\0';
+	}
+
+	if (mSettings.bCompress)
+	{
+		JobSystem Jobs(mSettings.ThreadCount);
+		Jobs.ParallelFor(static_cast<uint32_t>(Blocks.size()), 16, [&](uint32_t Begin, uint32_t End)
+		{
+			for (uint32_t i = Begin; i < End; ++i)
+			{
+				PendingBlock& Block = Blocks[i];
+				const uint8_t* Source = Contents[Block.File].data() + Block.SourceOffset;
+
+				Block.Compressed.resize(BlockCompressBound(Block.Size));
+				size_t CompressedSize = BlockCompress(Source, Block.Size, Block.Compressed.data(), Block.Compressed.size());
+
+				//Not worth decompressing if it didn't shrink
+				if (CompressedSize == 0 || CompressedSize >= Block.Size)
+				{
+					Block.Compressed = std::vector<uint8_t>();
+				}
+				else
+				{
+					Block.Compressed.resize(CompressedSize);
+				}
+			}
+		});
+	}
+
+	//Layout
+	uint32_t FanoutBits = 0;
+	while (FanoutBits < 16 && (1ull << FanoutBits) < mFiles.size())
+	{
+		++FanoutBits;
+	}
+
+	PackArchiveHeader Header = {};
+	Header.Magic = PackArchiveMagic;
+	Header.Version = PackArchiveVersion;
+	Header.Flags = mSettings.bCompress ? 0 : PackArchiveFlag_Stored;
+	Header.BlockSize = mSettings.BlockSize;
+	Header.EntryCount = static_cast<uint32_t>(Entries.size());
+	Header.BlockCount = static_cast<uint32_t>(Blocks.size());
+	Header.FanoutBits = FanoutBits;
+	Header.NameTableSize = static_cast<uint32_t>(NameTable.size());
+
+	Header.EntryTableOffset = AlignUp(sizeof(PackArchiveHeader), 16);
+	Header.FanoutTableOffset = AlignUp(Header.EntryTableOffset + Entries.size() * sizeof(PackArchiveEntry), 16);
+	Header.BlockTableOffset = AlignUp(Header.FanoutTableOffset + ((1ull << FanoutBits) + 1) * sizeof(uint32_t), 16);
+	Header.NameTableOffset = Header.BlockTableOffset + Blocks.size() * sizeof(PackArchiveBlock);
+
+	std::vector<uint32_t> Fanout((1ull << FanoutBits) + 1, 0);
+	for (const PackArchiveEntry& Entry : Entries)
+	{
+		uint32_t Bucket = FanoutBits ? static_cast<uint32_t>(Entry.NameHash >> (64 - FanoutBits)) : 0;
+		++Fanout[Bucket + 1];
+	}
+	for (size_t i = 1; i < Fanout.size(); ++i)
+	{
+		Fanout[i] += Fanout[i - 1];
+	}
+
+	//Block data starts page aligned so stored entries map nicely
+	std::vector<PackArchiveBlock> BlockTable(Blocks.size());
+	uint64_t DataOffset = AlignUp(Header.NameTableOffset + NameTable.size(), 4096);
+	for (size_t i = 0; i < Blocks.size(); ++i)
+	{
+		BlockTable[i].Offset = DataOffset;
+		BlockTable[i].UncompressedSize = Blocks[i].Size;
+		BlockTable[i].CompressedSize = Blocks[i].Compressed.empty() ? Blocks[i].Size : static_cast<uint32_t>(Blocks[i].Compressed.size());
+		DataOffset += BlockTable[i].CompressedSize;
+
+		mStats.StoredBlockCount += Blocks[i].Compressed.empty() ? 1 : 0;
+	}
+	Header.FileSize = DataOffset;
+
+	//Write
+	FILE* File = fopen(Filename, "wb");
+	if (!File)
+	{
+		mLastError = std::string("Couldn't open ") + Filename;
+		return false;
+	}
+
+	std::vector<uint8_t> Tables(static_cast<size_t>(AlignUp(Header.NameTableOffset + NameTable.size(), 4096)), 0);
+	memcpy(&Tables[0], &Header, sizeof(Header));
+	if (!Entries.empty())
+	{
+		memcpy(&Tables[static_cast<size_t>(Header.EntryTableOffset)], Entries.data(), Entries.size() * sizeof(PackArchiveEntry));
+	}
+	memcpy(&Tables[static_cast<size_t>(Header.FanoutTableOffset)], Fanout.data(), Fanout.size() * sizeof(uint32_t));
+	if (!BlockTable.empty())
+	{
+		memcpy(&Tables[static_cast<size_t>(Header.BlockTableOffset)], BlockTable.data(), BlockTable.size() * sizeof(PackArchiveBlock));
+	}
+	memcpy(&Tables[static_cast<size_t>(Header.NameTableOffset)], NameTable.data(), NameTable.size());
+
+	bool bWritten = fwrite(Tables.data(), 1, Tables.size(), File) == Tables.size();
+	for (size_t i = 0; i < Blocks.size() && bWritten; ++i)
+	{
+		const PendingBlock& Block = Blocks[i];
+		const uint8_t* Data = Block.Compressed.empty() ? Contents[Block.File].data() + Block.SourceOffset : Block.Compressed.data();
+		bWritten = fwrite(Data, 1, BlockTable[i].CompressedSize, File) == BlockTable[i].CompressedSize;
+	}
+	bWritten &= fclose(File) == 0;
+
+	if (!bWritten)
+	{
+		mLastError = std::string("Couldn't write ") + Filename;
+		return false;
+	}
+
+	mStats.EntryCount = Header.EntryCount;
+	mStats.BlockCount = Header.BlockCount;
+	mStats.ArchiveBytes = Header.FileSize;
+	return true;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "PackArchive.h"
+
+struct PackArchiveBuilderSettings
+{
+	uint32_t BlockSize = 64 * 1024;
+	bool bCompress = true;
+	uint32_t ThreadCount = 0;		//Compression threads, 0 = all cores
+};
+
+struct PackArchiveBuildStats
+{
+	uint32_t EntryCount = 0;
+	uint32_t BlockCount = 0;
+	uint32_t StoredBlockCount = 0;	//Didn't compress - kept raw
+	uint64_t UncompressedBytes = 0;
+	uint64_t ArchiveBytes = 0;
+};
+
+//Writes a PackArchive. Files are read when Write() is called.
+class PackArchiveBuilder
+{
+public:
+	PackArchiveBuilder(const PackArchiveBuilderSettings& Settings);
+	~PackArchiveBuilder();
+
+	void AddFile(const std::string& Name, const std::string& Path);
+
+	//Every file below Root, named by its path relative to Root.
+	void AddDirectory(const std::string& Root);
+
+	bool Write(const char* Filename);
+
+	const PackArchiveBuildStats& GetStats() const { return mStats; }
+	const std::string& GetLastError() const { return mLastError; }
+
+private:
+	struct PendingFile
+	{
+		std::string Name;
+		std::string Path;
+		uint64_t NameHash;
+	};
+
+private:
+	PackArchiveBuilderSettings mSettings;
+	std::vector<PendingFile> mFiles;
+
+	PackArchiveBuildStats mStats;
+	std::string mLastError;
+};
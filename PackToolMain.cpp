@@ -0,0 +1,134 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ArchiveBenchmark.h"
+#include "PackArchive.h"
+#include "PackArchiveBuilder.h"
+
+//Archive tool:
+//	PackTool pack <source dir> <archive> [-store] [-blocksize KB] [-j threads]
+//	PackTool list <archive>
+//	PackTool bench <source dir> [iterations]	- writes ArchiveBenchmark.txt
+namespace
+{
+	int Pack(int argc, char** argv)
+	{
+		if (argc < 4)
+		{
+			return -1;
+		}
+
+		PackArchiveBuilderSettings Settings;
+		for (int i = 4; i < argc; ++i)
+		{
+			if (strcmp(argv[i], "-store") == 0)
+			{
+				Settings.bCompress = false;
+			}
+			else if (strcmp(argv[i], "-blocksize") == 0 && i + 1 < argc)
+			{
+				Settings.BlockSize = static_cast<uint32_t>(atoi(argv[++i])) * 1024;
+			}
+			else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+			{
+				Settings.ThreadCount = static_cast<uint32_t>(atoi(argv[++i]));
+			}
+			else
+			{
+				return -1;
+			}
+		}
+
+		PackArchiveBuilder Builder(Settings);
+		Builder.AddDirectory(argv[2]);
+		if (!Builder.Write(argv[3]))
+		{
+			fprintf(stderr, "%s\n", Builder.GetLastError().c_str());
+			return 1;
+		}
+
+		const PackArchiveBuildStats& Stats = Builder.GetStats();
+		printf("%u entries, %u blocks (%u stored raw), %.2f MB -> %.2f MB\n", Stats.EntryCount, Stats.BlockCount,
+			Stats.StoredBlockCount, Stats.UncompressedBytes / (1024.0 * 1024.0), Stats.ArchiveBytes / (1024.0 * 1024.0));
+		return 0;
+	}
+
+	int List(int argc, char** argv)
+	{
+		if (argc != 3)
+		{
+			return -1;
+		}
+
+		PackArchive Archive;
+		if (!Archive.Open(argv[2]))
+		{
+			fprintf(stderr, "Couldn't open %s\n", argv[2]);
+			return 1;
+		}
+
+		for (uint32_t i = 0; i < Archive.GetEntryCount(); ++i)
+		{
+			printf("%12llu  %s\n", (unsigned long long)Archive.GetEntrySize(i), Archive.GetEntryName(i));
+		}
+		return 0;
+	}
+
+	int Bench(int argc, char** argv)
+	{
+		if (argc < 3 || argc > 4)
+		{
+			return -1;
+		}
+
+		ArchiveBenchmarkSettings Settings;
+		Settings.SourceDirectory = argv[2];
+		if (argc == 4)
+		{
+			Settings.Iterations = static_cast<uint32_t>(atoi(argv[3]));
+		}
+		if (Settings.Iterations == 0)
+		{
+			return -1;
+		}
+
+		ArchiveBenchmark Benchmark(Settings);
+		if (!Benchmark.Run())
+		{
+			fprintf(stderr, "%s\n", Benchmark.GetLastError().c_str());
+			return 1;
+		}
+		return Benchmark.WriteReport("ArchiveBenchmark.txt") ? 0 : 1;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int Result = -1;
+	if (argc >= 2)
+	{
+		if (strcmp(argv[1], "pack") == 0)
+		{
+			Result = Pack(argc, argv);
+		}
+		else if (strcmp(argv[1], "list") == 0)
+		{
+			Result = List(argc, argv);
+		}
+		else if (strcmp(argv[1], "bench") == 0)
+		{
+			Result = Bench(argc, argv);
+		}
+	}
+
+	if (Result < 0)
+	{
+		fprintf(stderr, "Usage:\n"
+			"  PackTool pack <source dir> <archive> [-store] [-blocksize KB] [-j threads]\n"
+			"  PackTool list <archive>\n"
+			"  PackTool bench <source dir> [iterations]\n");
+		return 1;
+	}
+	return Result;
+}
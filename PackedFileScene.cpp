@@ -0,0 +1,63 @@
+#include "PackedFileScene.h"
+#include "AsyncAwaitables.h"
+#include "PackedSceneBuilder.h"
+
+PackedFileScene::PackedFileScene(const std::string& Filename, JobSystem* Jobs, CoroutineScheduler* Scheduler)
+	: mFilename(Filename), mJobs(Jobs), mScheduler(Scheduler)
+{}
+
+PackedFileScene::~PackedFileScene()
+{}
+
+AsyncTask<bool> PackedFileScene::OnInitScene()
+{
+	//Open and validation touch the file, so keep them off the main thread
+	bool bLoaded = co_await RunJobAsync(*mJobs, *mScheduler, [this]()
+	{
+		return mScene.Load(mFilename.c_str());
+	});
+	co_return bLoaded;
+}
+
+int PackedFileScene::OnCloseScene()
+{
+	return 0;
+}
+
+void PackedFileScene::OnUpdate(float dt)
+{
+
+}
+
+void PackedFileScene::OnRender()
+{
+
+}
+
+bool PackedFileScene::OnSaveScene(PackedSceneBuilder& Builder) const
+{
+	if (!mScene.IsLoaded())
+	{
+		return false;
+	}
+
+	//Entities keep their order, so parents just move up by whatever's already there
+	uint32_t BaseEntity = Builder.GetEntityCount();
+	const PackedSceneEntity* Entities = mScene.GetEntities();
+	const PackedSceneTransform* Transforms = mScene.GetTransforms();
+
+	Builder.Reserve(BaseEntity + mScene.GetEntityCount());
+	for (uint32_t i = 0; i < mScene.GetEntityCount(); ++i)
+	{
+		const PackedSceneEntity& Entity = Entities[i];
+
+		uint32_t MeshIndex = Entity.MeshIndex != PackedSceneNoAsset ?
+			Builder.AddMesh(mScene.GetString(mScene.GetMesh(Entity.MeshIndex).NameOffset)) : PackedSceneNoAsset;
+		uint32_t MaterialIndex = Entity.MaterialIndex != PackedSceneNoAsset ?
+			Builder.AddMaterial(mScene.GetString(mScene.GetMaterial(Entity.MaterialIndex).NameOffset)) : PackedSceneNoAsset;
+		uint32_t Parent = Entity.Parent != PackedSceneNoParent ? BaseEntity + Entity.Parent : PackedSceneNoParent;
+
+		Builder.AddEntity(mScene.GetEntityName(i), Parent, Transforms[i], MeshIndex, MaterialIndex);
+	}
+	return true;
+}
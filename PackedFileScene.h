@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+
+#include "IScene.h"
+#include "PackedScene.h"
+
+class CoroutineScheduler;
+class JobSystem;
+
+//A scene loaded from a PackedScene file. The file is mapped and validated on
+//a job, then used in place - nothing is parsed or copied per entity.
+class PackedFileScene : public IScene
+{
+public:
+	PackedFileScene(const std::string& Filename, JobSystem* Jobs, CoroutineScheduler* Scheduler);
+	~PackedFileScene();
+
+	AsyncTask<bool> OnInitScene() override;
+	int OnCloseScene() override;
+
+	void OnUpdate(float dt) override;
+	void OnRender() override;
+
+	bool OnSaveScene(PackedSceneBuilder& Builder) const override;
+
+	const PackedScene& GetPackedScene() const { return mScene; }
+
+private:
+	std::string mFilename;
+	JobSystem* mJobs;
+	CoroutineScheduler* mScheduler;
+
+	PackedScene mScene;
+};
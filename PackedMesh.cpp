@@ -0,0 +1,259 @@
+#include "PackedMesh.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <stdio.h>
+
+namespace
+{
+	const uint32_t AttributeSizes[PackedMeshStream_Count] = { 8, 4, 4 };
+
+	//Offset + Size <= Limit without overflowing
+	bool RangeInside(uint64_t Offset, uint64_t Size, uint64_t Limit)
+	{
+		return Offset <= Limit && Size <= Limit - Offset;
+	}
+}
+
+uint16_t PackedMeshFloatToHalf(float Value)
+{
+	uint32_t Bits;
+	memcpy(&Bits, &Value, sizeof(Bits));
+
+	uint32_t Sign = (Bits >> 16) & 0x8000;
+	uint32_t Abs = Bits & 0x7FFFFFFF;
+
+	//Inf/NaN
+	if (Abs >= 0x7F800000)
+	{
+		return static_cast<uint16_t>(Sign | 0x7C00 | (Abs > 0x7F800000 ? 0x200 : 0));
+	}
+
+	//Rounds up past 65504
+	if (Abs >= 0x477FF000)
+	{
+		return static_cast<uint16_t>(Sign | 0x7C00);
+	}
+
+	//Half denormals (and zero)
+	if (Abs < 0x38800000)
+	{
+		if (Abs < 0x33000000)
+		{
+			return static_cast<uint16_t>(Sign);
+		}
+
+		uint32_t Exponent = Abs >> 23;
+		uint32_t Mantissa = (Abs & 0x7FFFFF) | 0x800000;
+		uint32_t Shift = 126 - Exponent;
+
+		uint32_t Half = Mantissa >> Shift;
+		uint32_t Remainder = Mantissa & ((1u << Shift) - 1);
+		uint32_t Halfway = 1u << (Shift - 1);
+		if (Remainder > Halfway || (Remainder == Halfway && (Half & 1)))
+		{
+			++Half;
+		}
+		return static_cast<uint16_t>(Sign | Half);
+	}
+
+	//Normal - rebias the exponent, round to nearest even
+	uint32_t Half = (Abs - 0x38000000) >> 13;
+	uint32_t Remainder = Abs & 0x1FFF;
+	if (Remainder > 0x1000 || (Remainder == 0x1000 && (Half & 1)))
+	{
+		++Half;
+	}
+	return static_cast<uint16_t>(Sign | Half);
+}
+
+void PackedMeshEncodeOctahedral(const float Normal[3], int16_t Out[2])
+{
+	float L1 = std::fabs(Normal[0]) + std::fabs(Normal[1]) + std::fabs(Normal[2]);
+	if (L1 <= 0.0f)
+	{
+		Out[0] = 0;
+		Out[1] = 0;
+		return;
+	}
+
+	float X = Normal[0] / L1;
+	float Y = Normal[1] / L1;
+
+	//Fold the lower hemisphere over the diagonals
+	if (Normal[2] < 0.0f)
+	{
+		float FoldedX = (1.0f - std::fabs(Y)) * (X >= 0.0f ? 1.0f : -1.0f);
+		float FoldedY = (1.0f - std::fabs(X)) * (Y >= 0.0f ? 1.0f : -1.0f);
+		X = FoldedX;
+		Y = FoldedY;
+	}
+
+	Out[0] = static_cast<int16_t>(std::lround(std::min(std::max(X, -1.0f), 1.0f) * 32767.0f));
+	Out[1] = static_cast<int16_t>(std::lround(std::min(std::max(Y, -1.0f), 1.0f) * 32767.0f));
+}
+
+PackedMesh::PackedMesh()
+	: mHeader(nullptr), mLods(nullptr), mSubmeshes(nullptr), mGpuData(nullptr)
+{}
+
+PackedMesh::~PackedMesh()
+{
+	Unload();
+}
+
+bool PackedMesh::Load(const char* Filename, PackedMeshLoadMode Mode)
+{
+	Unload();
+
+	auto Start = std::chrono::high_resolution_clock::now();
+
+	const uint8_t* Data = nullptr;
+	uint64_t Size = 0;
+
+	if (Mode == PackedMeshLoadMode::Mapped)
+	{
+		if (!mFile.Open(Filename))
+		{
+			return false;
+		}
+		Data = mFile.GetData();
+		Size = mFile.GetSize();
+	}
+	else
+	{
+		FILE* File = fopen(Filename, "rb");
+		if (!File)
+		{
+			return false;
+		}
+
+		fseek(File, 0, SEEK_END);
+		long FileSize = ftell(File);
+		fseek(File, 0, SEEK_SET);
+
+		if (FileSize > 0)
+		{
+			mCopiedData.resize(static_cast<size_t>(FileSize));
+			if (fread(mCopiedData.data(), 1, mCopiedData.size(), File) != mCopiedData.size())
+			{
+				mCopiedData.clear();
+			}
+		}
+		fclose(File);
+
+		Data = mCopiedData.data();
+		Size = mCopiedData.size();
+	}
+
+	if (!LoadFromMemory(Data, Size))
+	{
+		Unload();
+		return false;
+	}
+
+	mLoadStats.BytesLoaded = Size;
+	mLoadStats.LoadMilliseconds = std::chrono::duration<double, std::milli>(
+		std::chrono::high_resolution_clock::now() - Start).count();
+	return true;
+}
+
+bool PackedMesh::LoadFromMemory(const void* Data, uint64_t Size)
+{
+	const uint8_t* Bytes = static_cast<const uint8_t*>(Data);
+	if (!Bytes || !Validate(Bytes, Size))
+	{
+		return false;
+	}
+
+	mHeader = reinterpret_cast<const PackedMeshHeader*>(Bytes);
+	mLods = reinterpret_cast<const PackedMeshLod*>(Bytes + mHeader->LodTableOffset);
+	mSubmeshes = reinterpret_cast<const PackedMeshSubmesh*>(Bytes + mHeader->SubmeshTableOffset);
+	mGpuData = Bytes + mHeader->GpuDataOffset;
+
+	mLoadStats = PackedMeshLoadStats();
+	mLoadStats.BytesLoaded = Size;
+	return true;
+}
+
+void PackedMesh::Unload()
+{
+	mHeader = nullptr;
+	mLods = nullptr;
+	mSubmeshes = nullptr;
+	mGpuData = nullptr;
+
+	mFile.Close();
+	mCopiedData = std::vector<uint8_t>();
+}
+
+bool PackedMesh::Validate(const uint8_t* Data, uint64_t Size) const
+{
+	//Header and tables are read in place, so only the table contents are
+	//checked - index values are left to the GPU (out of range vertex fetches
+	//return zero).
+	if (Size < sizeof(PackedMeshHeader) || reinterpret_cast<uintptr_t>(Data) % PackedMeshSectionAlignment != 0)
+	{
+		return false;
+	}
+
+	const PackedMeshHeader* Header = reinterpret_cast<const PackedMeshHeader*>(Data);
+	if (Header->Magic != PackedMeshMagic || Header->Version != PackedMeshVersion ||
+		Header->FileSize > Size || (Header->IndexSize != 2 && Header->IndexSize != 4))
+	{
+		return false;
+	}
+
+	uint64_t FileSize = Header->FileSize;
+	if (Header->LodTableOffset % PackedMeshSectionAlignment != 0 ||
+		Header->SubmeshTableOffset % PackedMeshSectionAlignment != 0 ||
+		Header->GpuDataOffset % PackedMeshSectionAlignment != 0 ||
+		!RangeInside(Header->LodTableOffset, static_cast<uint64_t>(Header->LodCount) * sizeof(PackedMeshLod), FileSize) ||
+		!RangeInside(Header->SubmeshTableOffset, static_cast<uint64_t>(Header->SubmeshCount) * sizeof(PackedMeshSubmesh), FileSize) ||
+		!RangeInside(Header->GpuDataOffset, Header->GpuDataSize, FileSize))
+	{
+		return false;
+	}
+
+	//Vertex streams must end before the indices start
+	if (Header->VertexCount > 0)
+	{
+		for (uint32_t StreamIdx = 0; StreamIdx < PackedMeshStream_Count; ++StreamIdx)
+		{
+			const PackedMeshStreamDesc& Stream = Header->Streams[StreamIdx];
+			if (Stream.Stride == 0 || Stream.AttributeOffset + AttributeSizes[StreamIdx] > Stream.Stride ||
+				!RangeInside(Stream.Offset, static_cast<uint64_t>(Header->VertexCount) * Stream.Stride, Header->IndexDataOffset))
+			{
+				return false;
+			}
+		}
+	}
+
+	if (!RangeInside(Header->IndexDataOffset, static_cast<uint64_t>(Header->IndexCount) * Header->IndexSize, Header->GpuDataSize))
+	{
+		return false;
+	}
+
+	const PackedMeshSubmesh* Submeshes = reinterpret_cast<const PackedMeshSubmesh*>(Data + Header->SubmeshTableOffset);
+	for (uint32_t i = 0; i < Header->SubmeshCount; ++i)
+	{
+		if (!RangeInside(Submeshes[i].IndexStart, Submeshes[i].IndexCount, Header->IndexCount) ||
+			!RangeInside(Submeshes[i].BaseVertex, Submeshes[i].VertexCount, Header->VertexCount))
+		{
+			return false;
+		}
+	}
+
+	const PackedMeshLod* Lods = reinterpret_cast<const PackedMeshLod*>(Data + Header->LodTableOffset);
+	for (uint32_t i = 0; i < Header->LodCount; ++i)
+	{
+		if (!RangeInside(Lods[i].FirstSubmesh, Lods[i].SubmeshCount, Header->SubmeshCount))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "MappedFile.h"
+
+//Binary mesh format with vertex/index data already in GPU layout, so loading
+//is a map + validate and uploading is a single memcpy in to an upload buffer.
+//
+//File layout (every section 16 byte aligned):
+//	PackedMeshHeader
+//	PackedMeshLod[LodCount]
+//	PackedMeshSubmesh[SubmeshCount]
+//	GPU data - vertex streams followed by the index buffer
+//
+//Vertex attributes:
+//	Position	4 x 16 bit UNORM (DXGI_FORMAT_R16G16B16A16_UNORM / XMUSHORTN4),
+//				quantised over the mesh bounds: Pos = PositionMin + PositionExtent * Value.xyz
+//	Normal		2 x 16 bit SNORM octahedral (DXGI_FORMAT_R16G16_SNORM / XMSHORTN2)
+//	TexCoord	2 x half (DXGI_FORMAT_R16G16_FLOAT / XMHALF2)
+//
+//Streams are either split (one buffer per attribute - a depth only pass binds
+//positions alone) or interleaved (one 16 byte vertex). Indices are 16 bit when
+//every submesh's vertex range fits, 32 bit otherwise, and are relative to the
+//submesh's BaseVertex.
+
+const uint32_t PackedMeshMagic = 0x48534D50;	//"PMSH"
+const uint32_t PackedMeshVersion = 1;
+const uint32_t PackedMeshSectionAlignment = 16;
+
+enum PackedMeshStream
+{
+	PackedMeshStream_Position = 0,
+	PackedMeshStream_Normal,
+	PackedMeshStream_TexCoord,
+	PackedMeshStream_Count
+};
+
+enum PackedMeshFlags
+{
+	PackedMeshFlag_Interleaved = 1 << 0,
+};
+
+struct PackedMeshStreamDesc
+{
+	uint64_t Offset;			//From the start of the GPU data
+	uint32_t Stride;
+	uint32_t AttributeOffset;	//Within a vertex (non zero when interleaved)
+};
+
+struct PackedMeshSubmesh
+{
+	uint32_t IndexStart;
+	uint32_t IndexCount;
+	uint32_t BaseVertex;
+	uint32_t VertexCount;
+	uint32_t MaterialIndex;
+	float BoundsMin[3];
+	float BoundsMax[3];
+	uint32_t Padding;
+};
+
+struct PackedMeshLod
+{
+	uint32_t FirstSubmesh;
+	uint32_t SubmeshCount;
+	float ScreenSize;			//Use this LOD while the mesh covers at least this fraction of the screen
+	uint32_t Padding;
+};
+
+struct PackedMeshHeader
+{
+	uint32_t Magic;
+	uint32_t Version;
+	uint32_t Flags;
+	uint32_t IndexSize;			//2 or 4
+
+	uint32_t VertexCount;
+	uint32_t IndexCount;
+	uint32_t SubmeshCount;
+	uint32_t LodCount;
+
+	float PositionMin[3];
+	float PositionExtent[3];
+
+	PackedMeshStreamDesc Streams[PackedMeshStream_Count];
+
+	uint64_t LodTableOffset;
+	uint64_t SubmeshTableOffset;
+	uint64_t GpuDataOffset;
+	uint64_t GpuDataSize;
+	uint64_t IndexDataOffset;	//From the start of the GPU data
+	uint64_t FileSize;
+};
+
+//Attribute encoders shared by the converter and anything else writing the format.
+uint16_t PackedMeshFloatToHalf(float Value);
+void PackedMeshEncodeOctahedral(const float Normal[3], int16_t Out[2]);
+
+enum class PackedMeshLoadMode
+{
+	Mapped,		//Memory map - zero copies, zero allocations
+	Copied,		//Read the whole file in to a heap buffer
+};
+
+struct PackedMeshLoadStats
+{
+	uint64_t BytesLoaded = 0;
+	double LoadMilliseconds = 0.0;
+};
+
+//A loaded mesh. All pointers reference the file data directly and stay valid
+//until Unload().
+class PackedMesh
+{
+public:
+	PackedMesh();
+	~PackedMesh();
+
+	bool Load(const char* Filename, PackedMeshLoadMode Mode = PackedMeshLoadMode::Mapped);
+
+	//Data must outlive the mesh.
+	bool LoadFromMemory(const void* Data, uint64_t Size);
+
+	void Unload();
+
+	bool IsLoaded() const { return mHeader != nullptr; }
+	const PackedMeshHeader& GetHeader() const { return *mHeader; }
+	bool IsInterleaved() const { return (mHeader->Flags & PackedMeshFlag_Interleaved) != 0; }
+
+	const PackedMeshLod& GetLod(uint32_t Idx) const { return mLods[Idx]; }
+	const PackedMeshSubmesh& GetSubmesh(uint32_t Idx) const { return mSubmeshes[Idx]; }
+
+	//Everything the GPU needs, in one contiguous block.
+	const uint8_t* GetGpuData() const { return mGpuData; }
+	uint64_t GetGpuDataSize() const { return mHeader->GpuDataSize; }
+
+	const PackedMeshLoadStats& GetLoadStats() const { return mLoadStats; }
+
+private:
+	PackedMesh(const PackedMesh&) = delete;
+	PackedMesh& operator=(const PackedMesh&) = delete;
+
+	bool Validate(const uint8_t* Data, uint64_t Size) const;
+
+private:
+	MappedFile mFile;
+	std::vector<uint8_t> mCopiedData;
+
+	const PackedMeshHeader* mHeader;
+	const PackedMeshLod* mLods;
+	const PackedMeshSubmesh* mSubmeshes;
+	const uint8_t* mGpuData;
+
+	PackedMeshLoadStats mLoadStats;
+};
@@ -0,0 +1,197 @@
+#include "PackedScene.h"
+
+#include <chrono>
+#include <stdio.h>
+
+namespace
+{
+	//Offset + Size <= Limit without overflowing
+	bool RangeInside(uint64_t Offset, uint64_t Size, uint64_t Limit)
+	{
+		return Offset <= Limit && Size <= Limit - Offset;
+	}
+
+	bool IsValidReference(uint32_t Index, uint32_t Count)
+	{
+		return Index == PackedSceneNoAsset || Index < Count;
+	}
+}
+
+PackedScene::PackedScene()
+	: mHeader(nullptr), mEntities(nullptr), mTransforms(nullptr), mMeshes(nullptr), mMaterials(nullptr),
+	mStrings(nullptr)
+{}
+
+PackedScene::~PackedScene()
+{
+	Unload();
+}
+
+bool PackedScene::Load(const char* Filename, PackedSceneLoadMode Mode, PackedSceneValidation Validation)
+{
+	Unload();
+
+	auto Start = std::chrono::high_resolution_clock::now();
+
+	const uint8_t* Data = nullptr;
+	uint64_t Size = 0;
+
+	if (Mode == PackedSceneLoadMode::Mapped)
+	{
+		if (!mFile.Open(Filename))
+		{
+			return false;
+		}
+		Data = mFile.GetData();
+		Size = mFile.GetSize();
+	}
+	else
+	{
+		FILE* File = fopen(Filename, "rb");
+		if (!File)
+		{
+			return false;
+		}
+
+		fseek(File, 0, SEEK_END);
+		long FileSize = ftell(File);
+		fseek(File, 0, SEEK_SET);
+
+		if (FileSize > 0)
+		{
+			mCopiedData.resize(static_cast<size_t>(FileSize));
+			if (fread(mCopiedData.data(), 1, mCopiedData.size(), File) != mCopiedData.size())
+			{
+				mCopiedData.clear();
+			}
+		}
+		fclose(File);
+
+		Data = mCopiedData.data();
+		Size = mCopiedData.size();
+	}
+
+	if (!LoadFromMemory(Data, Size, Validation))
+	{
+		Unload();
+		return false;
+	}
+
+	mLoadStats.BytesLoaded = Size;
+	mLoadStats.LoadMilliseconds = std::chrono::duration<double, std::milli>(
+		std::chrono::high_resolution_clock::now() - Start).count();
+	return true;
+}
+
+bool PackedScene::LoadFromMemory(const void* Data, uint64_t Size, PackedSceneValidation Validation)
+{
+	const uint8_t* Bytes = static_cast<const uint8_t*>(Data);
+	if (!Bytes || !Validate(Bytes, Size, Validation))
+	{
+		return false;
+	}
+
+	//The only fixups - everything inside the tables stays an index or offset
+	mHeader = reinterpret_cast<const PackedSceneHeader*>(Bytes);
+	mEntities = reinterpret_cast<const PackedSceneEntity*>(Bytes + mHeader->EntityTableOffset);
+	mTransforms = reinterpret_cast<const PackedSceneTransform*>(Bytes + mHeader->TransformTableOffset);
+	mMeshes = reinterpret_cast<const PackedSceneAssetRef*>(Bytes + mHeader->MeshTableOffset);
+	mMaterials = reinterpret_cast<const PackedSceneAssetRef*>(Bytes + mHeader->MaterialTableOffset);
+	mStrings = reinterpret_cast<const char*>(Bytes + mHeader->StringTableOffset);
+
+	mLoadStats = PackedSceneLoadStats();
+	mLoadStats.BytesLoaded = Size;
+	return true;
+}
+
+void PackedScene::Unload()
+{
+	mHeader = nullptr;
+	mEntities = nullptr;
+	mTransforms = nullptr;
+	mMeshes = nullptr;
+	mMaterials = nullptr;
+	mStrings = nullptr;
+
+	mFile.Close();
+	mCopiedData = std::vector<uint8_t>();
+}
+
+bool PackedScene::Validate(const uint8_t* Data, uint64_t Size, PackedSceneValidation Validation) const
+{
+	if (Size < sizeof(PackedSceneHeader) || reinterpret_cast<uintptr_t>(Data) % PackedSceneSectionAlignment != 0)
+	{
+		return false;
+	}
+
+	const PackedSceneHeader* Header = reinterpret_cast<const PackedSceneHeader*>(Data);
+	if (Header->Magic != PackedSceneMagic || Header->Version != PackedSceneVersion || Header->FileSize > Size)
+	{
+		return false;
+	}
+
+	uint64_t FileSize = Header->FileSize;
+	const uint64_t Offsets[] = { Header->EntityTableOffset, Header->TransformTableOffset, Header->MeshTableOffset,
+		Header->MaterialTableOffset, Header->StringTableOffset };
+	for (uint64_t Offset : Offsets)
+	{
+		if (Offset % PackedSceneSectionAlignment != 0)
+		{
+			return false;
+		}
+	}
+
+	if (!RangeInside(Header->EntityTableOffset, static_cast<uint64_t>(Header->EntityCount) * sizeof(PackedSceneEntity), FileSize) ||
+		!RangeInside(Header->TransformTableOffset, static_cast<uint64_t>(Header->EntityCount) * sizeof(PackedSceneTransform), FileSize) ||
+		!RangeInside(Header->MeshTableOffset, static_cast<uint64_t>(Header->MeshCount) * sizeof(PackedSceneAssetRef), FileSize) ||
+		!RangeInside(Header->MaterialTableOffset, static_cast<uint64_t>(Header->MaterialCount) * sizeof(PackedSceneAssetRef), FileSize) ||
+		!RangeInside(Header->StringTableOffset, Header->StringTableSize, FileSize))
+	{
+		return false;
+	}
+
+	//Terminated, so any offset inside the table reads a bounded string
+	const char* Strings = reinterpret_cast<const char*>(Data + Header->StringTableOffset);
+	if (Header->StringTableSize == 0 || Strings[Header->StringTableSize - 1] != '\0')
+	{
+		return false;
+	}
+
+	if (Validation == PackedSceneValidation::Sections)
+	{
+		return true;
+	}
+
+	const PackedSceneEntity* Entities = reinterpret_cast<const PackedSceneEntity*>(Data + Header->EntityTableOffset);
+	for (uint32_t i = 0; i < Header->EntityCount; ++i)
+	{
+		const PackedSceneEntity& Entity = Entities[i];
+		if ((Entity.Parent != PackedSceneNoParent && Entity.Parent >= i) ||
+			!IsValidReference(Entity.MeshIndex, Header->MeshCount) ||
+			!IsValidReference(Entity.MaterialIndex, Header->MaterialCount) ||
+			Entity.NameOffset >= Header->StringTableSize)
+		{
+			return false;
+		}
+	}
+
+	const PackedSceneAssetRef* Meshes = reinterpret_cast<const PackedSceneAssetRef*>(Data + Header->MeshTableOffset);
+	for (uint32_t i = 0; i < Header->MeshCount; ++i)
+	{
+		if (Meshes[i].NameOffset >= Header->StringTableSize)
+		{
+			return false;
+		}
+	}
+
+	const PackedSceneAssetRef* Materials = reinterpret_cast<const PackedSceneAssetRef*>(Data + Header->MaterialTableOffset);
+	for (uint32_t i = 0; i < Header->MaterialCount; ++i)
+	{
+		if (Materials[i].NameOffset >= Header->StringTableSize)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
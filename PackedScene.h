@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "MappedFile.h"
+
+//Binary scene format designed to be used in place: every reference is an
+//index or an offset, never a pointer, and every table is a flat array of POD
+//records. Loading is a map, a validate and a handful of section pointer
+//fixups - no parsing and no per object allocation.
+//
+//File layout (every section 16 byte aligned):
+//	PackedSceneHeader
+//	PackedSceneEntity[EntityCount]
+//	PackedSceneTransform[EntityCount]	- split from the entities, as most passes only want these
+//	PackedSceneAssetRef[MeshCount]
+//	PackedSceneAssetRef[MaterialCount]
+//	String table						- null terminated names, starts with "" at offset 0
+//
+//Parents always come before their children, so world transforms can be built
+//in a single forward pass over the tables.
+
+const uint32_t PackedSceneMagic = 0x4E435350;	//"PSCN"
+const uint32_t PackedSceneVersion = 1;
+const uint32_t PackedSceneSectionAlignment = 16;
+
+const uint32_t PackedSceneNoParent = 0xFFFFFFFF;
+const uint32_t PackedSceneNoAsset = 0xFFFFFFFF;
+
+struct PackedSceneEntity
+{
+	uint32_t Parent;			//Entity index (always lower than this one) or PackedSceneNoParent
+	uint32_t MeshIndex;			//Or PackedSceneNoAsset
+	uint32_t MaterialIndex;		//Or PackedSceneNoAsset
+	uint32_t NameOffset;		//In to the string table
+};
+
+//Relative to the parent.
+struct PackedSceneTransform
+{
+	float Rotation[4];			//Quaternion x, y, z, w
+	float Position[3];
+	float Scale;				//Uniform
+};
+
+//A mesh or material the scene references by name. The hash is of the name
+//(HashString), so lookups at runtime don't need to touch the string table.
+struct PackedSceneAssetRef
+{
+	uint32_t NameOffset;
+	uint32_t Padding;
+	uint64_t NameHash;
+};
+
+struct PackedSceneHeader
+{
+	uint32_t Magic;
+	uint32_t Version;
+	uint32_t EntityCount;
+	uint32_t MeshCount;
+
+	uint32_t MaterialCount;
+	uint32_t Padding[3];
+
+	uint64_t EntityTableOffset;
+	uint64_t TransformTableOffset;
+	uint64_t MeshTableOffset;
+	uint64_t MaterialTableOffset;
+	uint64_t StringTableOffset;
+	uint64_t StringTableSize;
+	uint64_t FileSize;
+};
+
+enum class PackedSceneLoadMode
+{
+	Mapped,		//Memory map - zero copies, zero allocations
+	Copied,		//Read the whole file in to a heap buffer
+};
+
+enum class PackedSceneValidation
+{
+	Full,		//Header, section ranges and every index/offset in the tables
+	Sections,	//Header and section ranges only - for data that's already trusted
+				//(eg: from a checked archive). Touches no table pages at load.
+};
+
+struct PackedSceneLoadStats
+{
+	uint64_t BytesLoaded = 0;
+	double LoadMilliseconds = 0.0;
+};
+
+//A loaded scene. All pointers reference the file data directly and stay valid
+//until Unload().
+class PackedScene
+{
+public:
+	PackedScene();
+	~PackedScene();
+
+	bool Load(const char* Filename, PackedSceneLoadMode Mode = PackedSceneLoadMode::Mapped,
+		PackedSceneValidation Validation = PackedSceneValidation::Full);
+
+	//Data must outlive the scene.
+	bool LoadFromMemory(const void* Data, uint64_t Size, PackedSceneValidation Validation = PackedSceneValidation::Full);
+
+	void Unload();
+
+	bool IsLoaded() const { return mHeader != nullptr; }
+	const PackedSceneHeader& GetHeader() const { return *mHeader; }
+
+	uint32_t GetEntityCount() const { return mHeader->EntityCount; }
+	uint32_t GetMeshCount() const { return mHeader->MeshCount; }
+	uint32_t GetMaterialCount() const { return mHeader->MaterialCount; }
+
+	const PackedSceneEntity* GetEntities() const { return mEntities; }
+	const PackedSceneTransform* GetTransforms() const { return mTransforms; }
+	const PackedSceneAssetRef& GetMesh(uint32_t Idx) const { return mMeshes[Idx]; }
+	const PackedSceneAssetRef& GetMaterial(uint32_t Idx) const { return mMaterials[Idx]; }
+
+	const char* GetString(uint32_t Offset) const { return mStrings + Offset; }
+	const char* GetEntityName(uint32_t Idx) const { return GetString(mEntities[Idx].NameOffset); }
+
+	const PackedSceneLoadStats& GetLoadStats() const { return mLoadStats; }
+
+private:
+	PackedScene(const PackedScene&) = delete;
+	PackedScene& operator=(const PackedScene&) = delete;
+
+	bool Validate(const uint8_t* Data, uint64_t Size, PackedSceneValidation Validation) const;
+
+private:
+	MappedFile mFile;
+	std::vector<uint8_t> mCopiedData;
+
+	const PackedSceneHeader* mHeader;
+	const PackedSceneEntity* mEntities;
+	const PackedSceneTransform* mTransforms;
+	const PackedSceneAssetRef* mMeshes;
+	const PackedSceneAssetRef* mMaterials;
+	const char* mStrings;
+
+	PackedSceneLoadStats mLoadStats;
+};
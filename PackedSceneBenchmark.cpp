@@ -0,0 +1,304 @@
+#include "PackedSceneBenchmark.h"
+#include "AllocationCounter.h"
+#include "Common.h"
+#include "FileUtils.h"
+#include "PackedScene.h"
+#include "PackedSceneBuilder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <stdio.h>
+
+namespace
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	double MillisecondsSince(Clock::time_point Start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - Start).count();
+	}
+
+	//What loading in to a conventional object graph looks like
+	struct SceneNode
+	{
+		std::string Name;
+		std::string MeshName;
+		std::string MaterialName;
+		SceneNode* Parent;
+		std::vector<SceneNode*> Children;
+		PackedSceneTransform Transform;
+	};
+
+	struct DeserializedScene
+	{
+		std::vector<std::unique_ptr<SceneNode>> Nodes;
+	};
+
+	bool Deserialize(const char* Filename, DeserializedScene& Out)
+	{
+		PackedScene Scene;
+		if (!Scene.Load(Filename, PackedSceneLoadMode::Copied))
+		{
+			return false;
+		}
+
+		Out.Nodes.clear();
+		Out.Nodes.reserve(Scene.GetEntityCount());
+
+		const PackedSceneEntity* Entities = Scene.GetEntities();
+		for (uint32_t i = 0; i < Scene.GetEntityCount(); ++i)
+		{
+			const PackedSceneEntity& Entity = Entities[i];
+
+			std::unique_ptr<SceneNode> Node(new SceneNode());
+			Node->Name = Scene.GetEntityName(i);
+			if (Entity.MeshIndex != PackedSceneNoAsset)
+			{
+				Node->MeshName = Scene.GetString(Scene.GetMesh(Entity.MeshIndex).NameOffset);
+			}
+			if (Entity.MaterialIndex != PackedSceneNoAsset)
+			{
+				Node->MaterialName = Scene.GetString(Scene.GetMaterial(Entity.MaterialIndex).NameOffset);
+			}
+			Node->Parent = Entity.Parent != PackedSceneNoParent ? Out.Nodes[Entity.Parent].get() : nullptr;
+			Node->Transform = Scene.GetTransforms()[i];
+
+			if (Node->Parent)
+			{
+				Node->Parent->Children.push_back(Node.get());
+			}
+
+			Out.Nodes.push_back(std::move(Node));
+		}
+		return true;
+	}
+
+	double Traverse(const PackedScene& Scene)
+	{
+		double Sum = 0.0;
+		const PackedSceneTransform* Transforms = Scene.GetTransforms();
+		for (uint32_t i = 0; i < Scene.GetEntityCount(); ++i)
+		{
+			Sum += Transforms[i].Position[0] + Transforms[i].Scale + Scene.GetEntityName(i)[0];
+		}
+		return Sum;
+	}
+
+	double Traverse(const DeserializedScene& Scene)
+	{
+		double Sum = 0.0;
+		for (const std::unique_ptr<SceneNode>& Node : Scene.Nodes)
+		{
+			Sum += Node->Transform.Position[0] + Node->Transform.Scale + Node->Name[0];
+		}
+		return Sum;
+	}
+
+	void BuildScene(uint32_t EntityCount, const PackedSceneBenchmarkSettings& Settings, PackedSceneBuilder& Builder)
+	{
+		Builder.Clear();
+		Builder.Reserve(EntityCount);
+
+		char Name[64];
+		for (uint32_t i = 0; i < Settings.MeshCount; ++i)
+		{
+			snprintf(Name, sizeof(Name), "Meshes/Mesh%04u.mesh", i);
+			Builder.AddMesh(Name);
+		}
+		for (uint32_t i = 0; i < Settings.MaterialCount; ++i)
+		{
+			snprintf(Name, sizeof(Name), "Materials/Material%04u", i);
+			Builder.AddMaterial(Name);
+		}
+
+		//Shallow hierarchies - a root every 8 entities, children parented to
+		//something recent
+		uint32_t State = 0x9E3779B9u;
+		for (uint32_t i = 0; i < EntityCount; ++i)
+		{
+			State ^= State << 13;
+			State ^= State >> 17;
+			State ^= State << 5;
+
+			PackedSceneTransform Transform = {};
+			Transform.Rotation[3] = 1.0f;
+			Transform.Position[0] = static_cast<float>(State & 0x3FF);
+			Transform.Position[1] = static_cast<float>((State >> 10) & 0x3F);
+			Transform.Position[2] = static_cast<float>((State >> 16) & 0x3FF);
+			Transform.Scale = 1.0f;
+
+			uint32_t Parent = (i % 8 == 0) ? PackedSceneNoParent : i - 1 - (State >> 26) % std::min<uint32_t>(i, 8);
+			uint32_t MeshIndex = (State % 4 == 0) ? PackedSceneNoAsset : State % Settings.MeshCount;
+			uint32_t MaterialIndex = MeshIndex == PackedSceneNoAsset ? PackedSceneNoAsset : (State >> 8) % Settings.MaterialCount;
+
+			snprintf(Name, sizeof(Name), "Entity%u", i);
+			Builder.AddEntity(Name, Parent, Transform, MeshIndex, MaterialIndex);
+		}
+	}
+}
+
+PackedSceneBenchmark::PackedSceneBenchmark(const PackedSceneBenchmarkSettings& Settings)
+	: mSettings(Settings), mChecksum(0.0)
+{
+	Assert(mSettings.Iterations > 0 && mSettings.MeshCount > 0 && mSettings.MaterialCount > 0);
+}
+
+PackedSceneBenchmark::~PackedSceneBenchmark()
+{}
+
+bool PackedSceneBenchmark::Run()
+{
+	mResults.clear();
+	for (uint32_t EntityCount : mSettings.EntityCounts)
+	{
+		if (!RunScene(EntityCount))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool PackedSceneBenchmark::RunScene(uint32_t EntityCount)
+{
+	char Filename[64];
+	snprintf(Filename, sizeof(Filename), "PackedSceneBenchmark%u.pscene", EntityCount);
+	std::string Path = JoinPath(mSettings.WorkingDirectory, Filename);
+
+	{
+		PackedSceneBuilder Builder;
+		BuildScene(EntityCount, mSettings, Builder);
+		if (!Builder.Write(Path.c_str()))
+		{
+			mLastError = "Couldn't write " + Path;
+			return false;
+		}
+	}
+
+	struct PackedMode
+	{
+		const char* Name;
+		PackedSceneLoadMode LoadMode;
+		PackedSceneValidation Validation;
+	};
+	const PackedMode Modes[] =
+	{
+		{ "Mapped", PackedSceneLoadMode::Mapped, PackedSceneValidation::Full },
+		{ "MappedSections", PackedSceneLoadMode::Mapped, PackedSceneValidation::Sections },
+		{ "Copied", PackedSceneLoadMode::Copied, PackedSceneValidation::Full },
+	};
+
+	//One warm up load per mode so every mode sees the file in the OS cache
+	bool bSucceeded = true;
+	for (const PackedMode& Mode : Modes)
+	{
+		PackedSceneBenchmarkResult Result;
+		Result.EntityCount = EntityCount;
+		Result.Mode = Mode.Name;
+
+		uint64_t Allocations = 0;
+		uint64_t AllocatedBytes = 0;
+		PackedScene Scene;
+		for (uint32_t Pass = 0; Pass <= mSettings.Iterations && bSucceeded; ++Pass)
+		{
+			AllocationCounts Before = GetAllocationCounts();
+			auto Start = Clock::now();
+			bSucceeded = Scene.Load(Path.c_str(), Mode.LoadMode, Mode.Validation);
+			double LoadMs = MillisecondsSince(Start);
+			AllocationCounts After = GetAllocationCounts();
+			if (!bSucceeded)
+			{
+				break;
+			}
+			mChecksum += Traverse(Scene);
+			double FirstPassMs = MillisecondsSince(Start);
+
+			if (Pass > 0)
+			{
+				Result.LoadMilliseconds += LoadMs;
+				Result.FirstPassMilliseconds += FirstPassMs;
+				Allocations += After.Allocations - Before.Allocations;
+				AllocatedBytes += After.Bytes - Before.Bytes;
+			}
+			Result.FileBytes = Scene.GetLoadStats().BytesLoaded;
+			Scene.Unload();
+		}
+
+		Result.LoadMilliseconds /= mSettings.Iterations;
+		Result.FirstPassMilliseconds /= mSettings.Iterations;
+		Result.AllocationsPerLoad = static_cast<double>(Allocations) / mSettings.Iterations;
+		Result.AllocatedBytesPerLoad = static_cast<double>(AllocatedBytes) / mSettings.Iterations;
+		mResults.push_back(Result);
+	}
+
+	if (bSucceeded)
+	{
+		PackedSceneBenchmarkResult Result;
+		Result.EntityCount = EntityCount;
+		Result.Mode = "Deserialized";
+		Result.FileBytes = mResults.back().FileBytes;
+
+		uint64_t Allocations = 0;
+		uint64_t AllocatedBytes = 0;
+		for (uint32_t Pass = 0; Pass <= mSettings.Iterations && bSucceeded; ++Pass)
+		{
+			DeserializedScene Scene;
+			AllocationCounts Before = GetAllocationCounts();
+			auto Start = Clock::now();
+			bSucceeded = Deserialize(Path.c_str(), Scene);
+			double LoadMs = MillisecondsSince(Start);
+			AllocationCounts After = GetAllocationCounts();
+			if (!bSucceeded)
+			{
+				break;
+			}
+			mChecksum += Traverse(Scene);
+			double FirstPassMs = MillisecondsSince(Start);
+
+			if (Pass > 0)
+			{
+				Result.LoadMilliseconds += LoadMs;
+				Result.FirstPassMilliseconds += FirstPassMs;
+				Allocations += After.Allocations - Before.Allocations;
+				AllocatedBytes += After.Bytes - Before.Bytes;
+			}
+		}
+
+		Result.LoadMilliseconds /= mSettings.Iterations;
+		Result.FirstPassMilliseconds /= mSettings.Iterations;
+		Result.AllocationsPerLoad = static_cast<double>(Allocations) / mSettings.Iterations;
+		Result.AllocatedBytesPerLoad = static_cast<double>(AllocatedBytes) / mSettings.Iterations;
+		mResults.push_back(Result);
+	}
+
+	remove(Path.c_str());
+	if (!bSucceeded)
+	{
+		mLastError = "Couldn't load " + Path;
+	}
+	return bSucceeded;
+}
+
+bool PackedSceneBenchmark::WriteReport(const char* Filename) const
+{
+	FILE* File = fopen(Filename, "w");
+	if (!File)
+	{
+		return false;
+	}
+
+	fprintf(File, "Iterations:  %u\n", mSettings.Iterations);
+	fprintf(File, "Assets:      %u meshes, %u materials\n", mSettings.MeshCount, mSettings.MaterialCount);
+	fprintf(File, "Checksum:    %.0f\n\n", mChecksum);
+	fprintf(File, "Entities,Mode,FileMB,LoadMs,FirstPassMs,AllocationsPerLoad,AllocatedBytesPerLoad\n");
+	for (const PackedSceneBenchmarkResult& Result : mResults)
+	{
+		fprintf(File, "%u,%s,%.2f,%.3f,%.3f,%.0f,%.0f\n", Result.EntityCount, Result.Mode.c_str(),
+			Result.FileBytes / (1024.0 * 1024.0), Result.LoadMilliseconds, Result.FirstPassMilliseconds,
+			Result.AllocationsPerLoad, Result.AllocatedBytesPerLoad);
+	}
+
+	fclose(File);
+	return true;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//Load time of generated packed scenes at each EntityCount, written in to
+//WorkingDirectory and removed afterwards. Modes:
+//	Mapped			- map, full validation, section fixups
+//	MappedSections	- map, section validation only (trusted data)
+//	Copied			- read in to one heap buffer, full validation
+//	Deserialized	- conventional load for comparison: a node object per
+//					  entity with owned name strings, parent/child pointers
+//
+//Load is the call alone; FirstPass adds one walk over every transform and
+//name, which is where a mapped file pays for its page faults. Repeated loads
+//hit the OS file cache - numbers are warm cache. Allocations are counted by
+//AllocationCounter's operator new, so only C++ heap allocations show up.
+struct PackedSceneBenchmarkSettings
+{
+	std::string WorkingDirectory = ".";
+	std::vector<uint32_t> EntityCounts = { 10000, 100000, 1000000 };
+	uint32_t Iterations = 5;
+	uint32_t MeshCount = 512;
+	uint32_t MaterialCount = 128;
+};
+
+struct PackedSceneBenchmarkResult
+{
+	uint32_t EntityCount = 0;
+	std::string Mode;
+	uint64_t FileBytes = 0;
+	double LoadMilliseconds = 0.0;			//Per load
+	double FirstPassMilliseconds = 0.0;		//Per load, including the load
+	double AllocationsPerLoad = 0.0;
+	double AllocatedBytesPerLoad = 0.0;
+};
+
+class PackedSceneBenchmark
+{
+public:
+	PackedSceneBenchmark(const PackedSceneBenchmarkSettings& Settings);
+	~PackedSceneBenchmark();
+
+	bool Run();
+	bool WriteReport(const char* Filename) const;
+
+	const std::string& GetLastError() const { return mLastError; }
+
+private:
+	bool RunScene(uint32_t EntityCount);
+
+private:
+	PackedSceneBenchmarkSettings mSettings;
+	std::vector<PackedSceneBenchmarkResult> mResults;
+	std::string mLastError;
+
+	//Keeps traversals from being optimised away
+	double mChecksum;
+};
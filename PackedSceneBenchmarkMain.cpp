@@ -0,0 +1,53 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "PackedSceneBenchmark.h"
+
+//Packed scene load benchmark:
+//	PackedSceneBenchmark [working dir] [-iterations N] [-entities N ...]
+//Writes PackedSceneBenchmark.txt to the current directory.
+int main(int argc, char** argv)
+{
+	PackedSceneBenchmarkSettings Settings;
+	bool bCustomCounts = false;
+	bool bValid = true;
+	for (int i = 1; i < argc && bValid; ++i)
+	{
+		if (strcmp(argv[i], "-iterations") == 0 && i + 1 < argc)
+		{
+			Settings.Iterations = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-entities") == 0 && i + 1 < argc)
+		{
+			if (!bCustomCounts)
+			{
+				Settings.EntityCounts.clear();
+				bCustomCounts = true;
+			}
+			Settings.EntityCounts.push_back(static_cast<uint32_t>(atoi(argv[++i])));
+		}
+		else if (argv[i][0] != '-')
+		{
+			Settings.WorkingDirectory = argv[i];
+		}
+		else
+		{
+			bValid = false;
+		}
+	}
+
+	if (!bValid || Settings.Iterations == 0)
+	{
+		fprintf(stderr, "Usage: PackedSceneBenchmark [working dir] [-iterations N] [-entities N ...]\n");
+		return 1;
+	}
+
+	PackedSceneBenchmark Benchmark(Settings);
+	if (!Benchmark.Run())
+	{
+		fprintf(stderr, "%s\n", Benchmark.GetLastError().c_str());
+		return 1;
+	}
+	return Benchmark.WriteReport("PackedSceneBenchmark.txt") ? 0 : 1;
+}
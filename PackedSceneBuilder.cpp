@@ -0,0 +1,157 @@
+#include "PackedSceneBuilder.h"
+#include "Common.h"
+#include "Hash.h"
+
+#include <cstring>
+#include <stdio.h>
+
+namespace
+{
+	uint64_t AlignUp(uint64_t Value, uint64_t Alignment)
+	{
+		return (Value + Alignment - 1) & ~(Alignment - 1);
+	}
+}
+
+PackedSceneBuilder::PackedSceneBuilder()
+{
+	Clear();
+}
+
+PackedSceneBuilder::~PackedSceneBuilder()
+{}
+
+void PackedSceneBuilder::Reserve(uint32_t EntityCount)
+{
+	mEntities.reserve(EntityCount);
+	mTransforms.reserve(EntityCount);
+}
+
+void PackedSceneBuilder::Clear()
+{
+	mEntities.clear();
+	mTransforms.clear();
+	mMeshes.clear();
+	mMaterials.clear();
+	mStringOffsets.clear();
+	mMeshIndices.clear();
+	mMaterialIndices.clear();
+
+	//Offset 0 is the empty string
+	mStrings.assign(1, '\0');
+	mStringOffsets[std::string()] = 0;
+}
+
+uint32_t PackedSceneBuilder::AddMesh(const std::string& Name)
+{
+	return FindOrAddAsset(mMeshes, mMeshIndices, Name);
+}
+
+uint32_t PackedSceneBuilder::AddMaterial(const std::string& Name)
+{
+	return FindOrAddAsset(mMaterials, mMaterialIndices, Name);
+}
+
+uint32_t PackedSceneBuilder::AddEntity(const std::string& Name, uint32_t Parent, const PackedSceneTransform& Transform,
+	uint32_t MeshIndex, uint32_t MaterialIndex)
+{
+	Assert(Parent == PackedSceneNoParent || Parent < mEntities.size());
+	Assert(MeshIndex == PackedSceneNoAsset || MeshIndex < mMeshes.size());
+	Assert(MaterialIndex == PackedSceneNoAsset || MaterialIndex < mMaterials.size());
+
+	PackedSceneEntity Entity;
+	Entity.Parent = Parent;
+	Entity.MeshIndex = MeshIndex;
+	Entity.MaterialIndex = MaterialIndex;
+	Entity.NameOffset = AddString(Name);
+
+	mEntities.push_back(Entity);
+	mTransforms.push_back(Transform);
+	return static_cast<uint32_t>(mEntities.size() - 1);
+}
+
+uint32_t PackedSceneBuilder::AddString(const std::string& String)
+{
+	auto Existing = mStringOffsets.find(String);
+	if (Existing != mStringOffsets.end())
+	{
+		return Existing->second;
+	}
+
+	uint32_t Offset = static_cast<uint32_t>(mStrings.size());
+	mStrings.insert(mStrings.end(), String.begin(), String.end());
+	mStrings.push_back('\0');
+	mStringOffsets[String] = Offset;
+	return Offset;
+}
+
+uint32_t PackedSceneBuilder::FindOrAddAsset(std::vector<PackedSceneAssetRef>& Assets,
+	std::unordered_map<std::string, uint32_t>& Indices, const std::string& Name)
+{
+	auto Existing = Indices.find(Name);
+	if (Existing != Indices.end())
+	{
+		return Existing->second;
+	}
+
+	PackedSceneAssetRef Asset = {};
+	Asset.NameOffset = AddString(Name);
+	Asset.NameHash = HashString(Name);
+	Assets.push_back(Asset);
+
+	uint32_t Index = static_cast<uint32_t>(Assets.size() - 1);
+	Indices[Name] = Index;
+	return Index;
+}
+
+void PackedSceneBuilder::BuildImage(std::vector<uint8_t>& OutImage) const
+{
+	PackedSceneHeader Header = {};
+	Header.Magic = PackedSceneMagic;
+	Header.Version = PackedSceneVersion;
+	Header.EntityCount = static_cast<uint32_t>(mEntities.size());
+	Header.MeshCount = static_cast<uint32_t>(mMeshes.size());
+	Header.MaterialCount = static_cast<uint32_t>(mMaterials.size());
+
+	Header.EntityTableOffset = AlignUp(sizeof(PackedSceneHeader), PackedSceneSectionAlignment);
+	Header.TransformTableOffset = AlignUp(Header.EntityTableOffset + mEntities.size() * sizeof(PackedSceneEntity), PackedSceneSectionAlignment);
+	Header.MeshTableOffset = AlignUp(Header.TransformTableOffset + mTransforms.size() * sizeof(PackedSceneTransform), PackedSceneSectionAlignment);
+	Header.MaterialTableOffset = AlignUp(Header.MeshTableOffset + mMeshes.size() * sizeof(PackedSceneAssetRef), PackedSceneSectionAlignment);
+	Header.StringTableOffset = AlignUp(Header.MaterialTableOffset + mMaterials.size() * sizeof(PackedSceneAssetRef), PackedSceneSectionAlignment);
+	Header.StringTableSize = mStrings.size();
+	Header.FileSize = Header.StringTableOffset + Header.StringTableSize;
+
+	OutImage.assign(static_cast<size_t>(Header.FileSize), 0);
+	memcpy(&OutImage[0], &Header, sizeof(Header));
+
+	//Empty tables still get a (zero length) offset, so skip the copy rather than index past the end
+	if (!mEntities.empty())
+	{
+		memcpy(&OutImage[static_cast<size_t>(Header.EntityTableOffset)], mEntities.data(), mEntities.size() * sizeof(PackedSceneEntity));
+		memcpy(&OutImage[static_cast<size_t>(Header.TransformTableOffset)], mTransforms.data(), mTransforms.size() * sizeof(PackedSceneTransform));
+	}
+	if (!mMeshes.empty())
+	{
+		memcpy(&OutImage[static_cast<size_t>(Header.MeshTableOffset)], mMeshes.data(), mMeshes.size() * sizeof(PackedSceneAssetRef));
+	}
+	if (!mMaterials.empty())
+	{
+		memcpy(&OutImage[static_cast<size_t>(Header.MaterialTableOffset)], mMaterials.data(), mMaterials.size() * sizeof(PackedSceneAssetRef));
+	}
+	memcpy(&OutImage[static_cast<size_t>(Header.StringTableOffset)], mStrings.data(), mStrings.size());
+}
+
+bool PackedSceneBuilder::Write(const char* Filename) const
+{
+	std::vector<uint8_t> Image;
+	BuildImage(Image);
+
+	FILE* File = fopen(Filename, "wb");
+	if (!File)
+	{
+		return false;
+	}
+	bool bWritten = fwrite(Image.data(), 1, Image.size(), File) == Image.size();
+	fclose(File);
+	return bWritten;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "PackedScene.h"
+
+//Builds a PackedScene image. Scenes save themselves through this (see
+//IScene::OnSaveScene). Names - of entities, meshes and materials - are
+//deduplicated in the string table, and meshes/materials by name.
+class PackedSceneBuilder
+{
+public:
+	PackedSceneBuilder();
+	~PackedSceneBuilder();
+
+	void Reserve(uint32_t EntityCount);
+	void Clear();
+
+	//Index of the mesh/material with this name, added if it's new.
+	uint32_t AddMesh(const std::string& Name);
+	uint32_t AddMaterial(const std::string& Name);
+
+	//Parent must already have been added (or be PackedSceneNoParent). Returns
+	//the new entity's index.
+	uint32_t AddEntity(const std::string& Name, uint32_t Parent, const PackedSceneTransform& Transform,
+		uint32_t MeshIndex = PackedSceneNoAsset, uint32_t MaterialIndex = PackedSceneNoAsset);
+
+	uint32_t GetEntityCount() const { return static_cast<uint32_t>(mEntities.size()); }
+
+	void BuildImage(std::vector<uint8_t>& OutImage) const;
+	bool Write(const char* Filename) const;
+
+private:
+	uint32_t AddString(const std::string& String);
+	uint32_t FindOrAddAsset(std::vector<PackedSceneAssetRef>& Assets, std::unordered_map<std::string, uint32_t>& Indices,
+		const std::string& Name);
+
+private:
+	std::vector<PackedSceneEntity> mEntities;
+	std::vector<PackedSceneTransform> mTransforms;
+	std::vector<PackedSceneAssetRef> mMeshes;
+	std::vector<PackedSceneAssetRef> mMaterials;
+
+	std::vector<char> mStrings;
+	std::unordered_map<std::string, uint32_t> mStringOffsets;
+	std::unordered_map<std::string, uint32_t> mMeshIndices;
+	std::unordered_map<std::string, uint32_t> mMaterialIndices;
+};
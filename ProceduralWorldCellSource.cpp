@@ -0,0 +1,108 @@
+#include "ProceduralWorldCellSource.h"
+#include "AsyncAwaitables.h"
+#include "Common.h"
+
+#include <cstring>
+
+ProceduralWorldCellSource::ProceduralWorldCellSource(const ProceduralWorldSettings& Settings, JobSystem* Jobs,
+	CoroutineScheduler* Scheduler)
+	: mSettings(Settings), mJobs(Jobs), mScheduler(Scheduler)
+{
+	Assert(mJobs && mScheduler);
+	Assert(mSettings.MinObjectsPerCell <= mSettings.MaxObjectsPerCell && mSettings.MinPayloadBytes <= mSettings.MaxPayloadBytes);
+}
+
+ProceduralWorldCellSource::~ProceduralWorldCellSource()
+{}
+
+bool ProceduralWorldCellSource::HasCell(const WorldCellCoord& Coord) const
+{
+	return Coord.X >= -mSettings.HalfExtentInCells && Coord.X < mSettings.HalfExtentInCells &&
+		Coord.Z >= -mSettings.HalfExtentInCells && Coord.Z < mSettings.HalfExtentInCells;
+}
+
+uint64_t ProceduralWorldCellSource::GetCellMemorySize(const WorldCellCoord& Coord) const
+{
+	uint32_t ObjectCount, PayloadBytes;
+	GetCellSize(Coord, ObjectCount, PayloadBytes);
+	return static_cast<uint64_t>(ObjectCount) * sizeof(WorldObject) + PayloadBytes;
+}
+
+AsyncTask<bool> ProceduralWorldCellSource::LoadCell(WorldCellCoord Coord, WorldCellData& OutData)
+{
+	co_await RunJobAsync(*mJobs, *mScheduler, [this, Coord, &OutData]()
+	{
+		GenerateCell(Coord, OutData);
+	});
+	co_return true;
+}
+
+uint32_t ProceduralWorldCellSource::HashCell(const WorldCellCoord& Coord, uint32_t Salt) const
+{
+	//Wang style integer mix of the coordinate, seed and salt
+	uint32_t Hash = static_cast<uint32_t>(Coord.X) * 73856093u ^ static_cast<uint32_t>(Coord.Z) * 19349663u ^
+		(mSettings.Seed + Salt) * 83492791u;
+	Hash = (Hash ^ 61u) ^ (Hash >> 16);
+	Hash *= 9u;
+	Hash ^= Hash >> 4;
+	Hash *= 0x27D4EB2Du;
+	Hash ^= Hash >> 15;
+	return Hash;
+}
+
+void ProceduralWorldCellSource::GetCellSize(const WorldCellCoord& Coord, uint32_t& OutObjectCount, uint32_t& OutPayloadBytes) const
+{
+	uint32_t ObjectRange = mSettings.MaxObjectsPerCell - mSettings.MinObjectsPerCell + 1;
+	uint32_t PayloadRange = mSettings.MaxPayloadBytes - mSettings.MinPayloadBytes + 1;
+	OutObjectCount = mSettings.MinObjectsPerCell + HashCell(Coord, 0) % ObjectRange;
+	OutPayloadBytes = mSettings.MinPayloadBytes + HashCell(Coord, 1) % PayloadRange;
+}
+
+void ProceduralWorldCellSource::GenerateCell(const WorldCellCoord& Coord, WorldCellData& OutData) const
+{
+	uint32_t ObjectCount, PayloadBytes;
+	GetCellSize(Coord, ObjectCount, PayloadBytes);
+
+	//xorshift32 seeded per cell
+	uint32_t State = HashCell(Coord, 2) | 1u;
+	auto Next = [&State]()
+	{
+		State ^= State << 13;
+		State ^= State >> 17;
+		State ^= State << 5;
+		return State;
+	};
+	auto NextFloat = [&Next](float Min, float Max)
+	{
+		return Min + (Next() & 0xFFFFFF) * (1.0f / 16777215.0f) * (Max - Min);
+	};
+
+	float OriginX = Coord.X * mSettings.CellSize;
+	float OriginZ = Coord.Z * mSettings.CellSize;
+
+	OutData.Objects.resize(ObjectCount);
+	for (WorldObject& Object : OutData.Objects)
+	{
+		Object.Position[0] = OriginX + NextFloat(0.0f, mSettings.CellSize);
+		Object.Position[1] = NextFloat(0.0f, 10.0f);
+		Object.Position[2] = OriginZ + NextFloat(0.0f, mSettings.CellSize);
+		Object.Yaw = NextFloat(0.0f, 6.2831853f);
+		Object.Scale = NextFloat(0.5f, 4.0f);
+		Object.MeshId = Next() % 256;
+		Object.MaterialId = Next() % 64;
+	}
+
+	//Touch every byte, as decompressing real data would
+	OutData.Payload.resize(PayloadBytes);
+	uint8_t* Payload = OutData.Payload.data();
+	size_t Offset = 0;
+	for (; Offset + sizeof(uint32_t) <= PayloadBytes; Offset += sizeof(uint32_t))
+	{
+		uint32_t Value = Next();
+		memcpy(Payload + Offset, &Value, sizeof(Value));
+	}
+	for (; Offset < PayloadBytes; ++Offset)
+	{
+		Payload[Offset] = static_cast<uint8_t>(Next());
+	}
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "WorldStreamer.h"
+
+class CoroutineScheduler;
+class JobSystem;
+
+//Deterministic generated world for headless streaming runs. Every cell's
+//contents come from a hash of its coordinate, so sizes are known before
+//loading and the same cell always loads the same. Generation (objects plus a
+//payload of pseudo random bytes standing in for decompressed geometry) runs
+//on a JobSystem worker.
+struct ProceduralWorldSettings
+{
+	int32_t HalfExtentInCells = 32;		//Cells [-Half, Half) on X and Z exist
+	float CellSize = 100.0f;			//Must match the streamer's
+	uint32_t MinObjectsPerCell = 500;
+	uint32_t MaxObjectsPerCell = 8000;
+	uint32_t MinPayloadBytes = 512 * 1024;
+	uint32_t MaxPayloadBytes = 6 * 1024 * 1024;
+	uint32_t Seed = 1;
+};
+
+class ProceduralWorldCellSource : public IWorldCellSource
+{
+public:
+	ProceduralWorldCellSource(const ProceduralWorldSettings& Settings, JobSystem* Jobs, CoroutineScheduler* Scheduler);
+	~ProceduralWorldCellSource();
+
+	bool HasCell(const WorldCellCoord& Coord) const override;
+	uint64_t GetCellMemorySize(const WorldCellCoord& Coord) const override;
+	AsyncTask<bool> LoadCell(WorldCellCoord Coord, WorldCellData& OutData) override;
+
+private:
+	uint32_t HashCell(const WorldCellCoord& Coord, uint32_t Salt) const;
+	void GetCellSize(const WorldCellCoord& Coord, uint32_t& OutObjectCount, uint32_t& OutPayloadBytes) const;
+	void GenerateCell(const WorldCellCoord& Coord, WorldCellData& OutData) const;
+
+private:
+	ProceduralWorldSettings mSettings;
+	JobSystem* mJobs;
+	CoroutineScheduler* mScheduler;
+};
@@ -0,0 +1,164 @@
+#include "RadixSort.h"
+#include "Common.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <string.h>
+
+namespace
+{
+	const uint32_t DigitCount = 1u << RadixSorter::DigitBits;
+
+	//Body(Block) for each block, across the job system if there's more than one
+	template <typename Function>
+	void ForEachBlock(JobSystem* Jobs, uint32_t BlockCount, const Function& Body)
+	{
+		if (Jobs && BlockCount > 1)
+		{
+			Jobs->ParallelFor(BlockCount, 1, [&Body](uint32_t Begin, uint32_t End)
+			{
+				for (uint32_t Block = Begin; Block < End; ++Block)
+				{
+					Body(Block);
+				}
+			});
+		}
+		else
+		{
+			for (uint32_t Block = 0; Block < BlockCount; ++Block)
+			{
+				Body(Block);
+			}
+		}
+	}
+}
+
+RadixSorter::RadixSorter()
+	: mPassCount(0)
+	, mSkippedPassCount(0)
+{}
+
+RadixSorter::~RadixSorter()
+{}
+
+void RadixSorter::Sort(std::vector<uint32_t>& Keys, std::vector<uint32_t>& Values, uint32_t KeyBits, JobSystem* Jobs)
+{
+	Assert(KeyBits <= 32);
+	SortKeys(Keys, mScratchKeys32, Values, KeyBits, Jobs);
+}
+
+void RadixSorter::Sort(std::vector<uint64_t>& Keys, std::vector<uint32_t>& Values, uint32_t KeyBits, JobSystem* Jobs)
+{
+	Assert(KeyBits <= 64);
+	SortKeys(Keys, mScratchKeys64, Values, KeyBits, Jobs);
+}
+
+template <typename KeyType>
+void RadixSorter::SortKeys(std::vector<KeyType>& Keys, std::vector<KeyType>& ScratchKeys, std::vector<uint32_t>& Values,
+	uint32_t KeyBits, JobSystem* Jobs)
+{
+	Assert(Keys.size() == Values.size() && Keys.size() <= 0xFFFFFFFF);
+
+	mPassCount = 0;
+	mSkippedPassCount = 0;
+
+	uint32_t Count = static_cast<uint32_t>(Keys.size());
+	if (Count < 2)
+	{
+		return;
+	}
+
+	ScratchKeys.resize(Count);
+	mScratchValues.resize(Count);
+
+	uint32_t BlockCount = (Count + JobBatchSize - 1) / JobBatchSize;
+	mHistograms.resize(static_cast<size_t>(BlockCount) * DigitCount);
+
+	//The first pass also finds which bits differ from the first key, so
+	//later passes with the same digit everywhere are skipped unread
+	const KeyType FirstKey = Keys[0];
+	mBlockVaryingBits.resize(BlockCount);
+	KeyType VaryingBits = 0;
+	for (uint32_t Shift = 0; Shift < KeyBits; Shift += DigitBits)
+	{
+		//The last digit stops at KeyBits
+		const KeyType Mask = KeyBits - Shift < DigitBits ? (static_cast<KeyType>(1) << (KeyBits - Shift)) - 1 : DigitCount - 1;
+		if (Shift > 0 && ((VaryingBits >> Shift) & Mask) == 0)
+		{
+			++mSkippedPassCount;
+			continue;
+		}
+
+		ForEachBlock(Jobs, BlockCount, [this, &Keys, Count, Shift, Mask, FirstKey](uint32_t Block)
+		{
+			uint32_t* Histogram = &mHistograms[static_cast<size_t>(Block) * DigitCount];
+			memset(Histogram, 0, DigitCount * sizeof(uint32_t));
+
+			uint32_t Begin = Block * JobBatchSize;
+			uint32_t End = std::min(Count, Begin + JobBatchSize);
+			if (Shift == 0)
+			{
+				KeyType Varying = 0;
+				for (uint32_t i = Begin; i < End; ++i)
+				{
+					++Histogram[static_cast<uint32_t>(Keys[i] & Mask)];
+					Varying |= Keys[i] ^ FirstKey;
+				}
+				mBlockVaryingBits[Block] = Varying;
+			}
+			else
+			{
+				for (uint32_t i = Begin; i < End; ++i)
+				{
+					++Histogram[static_cast<uint32_t>((Keys[i] >> Shift) & Mask)];
+				}
+			}
+		});
+
+		if (Shift == 0)
+		{
+			for (uint32_t Block = 0; Block < BlockCount; ++Block)
+			{
+				VaryingBits |= static_cast<KeyType>(mBlockVaryingBits[Block]);
+			}
+			if ((VaryingBits & Mask) == 0)
+			{
+				++mSkippedPassCount;
+				continue;
+			}
+		}
+
+		//Counts to where each block writes each digit: every smaller digit
+		//first, then the same digit from earlier blocks
+		uint32_t Offset = 0;
+		for (uint32_t Digit = 0; Digit < DigitCount; ++Digit)
+		{
+			for (uint32_t Block = 0; Block < BlockCount; ++Block)
+			{
+				uint32_t& Entry = mHistograms[static_cast<size_t>(Block) * DigitCount + Digit];
+				uint32_t BlockTotal = Entry;
+				Entry = Offset;
+				Offset += BlockTotal;
+			}
+		}
+		Check(Offset == Count);
+
+		ForEachBlock(Jobs, BlockCount, [this, &Keys, &ScratchKeys, &Values, Count, Shift, Mask](uint32_t Block)
+		{
+			uint32_t* Next = &mHistograms[static_cast<size_t>(Block) * DigitCount];
+
+			uint32_t Begin = Block * JobBatchSize;
+			uint32_t End = std::min(Count, Begin + JobBatchSize);
+			for (uint32_t i = Begin; i < End; ++i)
+			{
+				uint32_t Slot = Next[static_cast<uint32_t>((Keys[i] >> Shift) & Mask)]++;
+				ScratchKeys[Slot] = Keys[i];
+				mScratchValues[Slot] = Values[i];
+			}
+		});
+
+		Keys.swap(ScratchKeys);
+		Values.swap(mScratchValues);
+		++mPassCount;
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+class JobSystem;
+
+//Stable least significant digit radix sort of integer keys, each carrying a
+//32 bit value (usually the index of what the key was made from).
+//
+//Each pass sorts on DigitBits of the key. The keys are split in to blocks of
+//JobBatchSize, each counting its digits in to its own histogram; those give
+//every block its own output ranges, so blocks scatter in parallel with no
+//locks or atomics and the result is the same however many threads ran.
+//Passes over digits that are the same in every key - common in the high bits
+//of packed sort keys - are skipped without reading the keys again.
+class RadixSorter
+{
+public:
+	static const uint32_t JobBatchSize = 65536;
+	static const uint32_t DigitBits = 8;
+
+	RadixSorter();
+	~RadixSorter();
+
+	//Sorts Keys ascending on their low KeyBits bits, moving Values with them.
+	//The vectors are swapped with the sorter's scratch buffers, so their
+	//storage may change but their sizes don't.
+	void Sort(std::vector<uint32_t>& Keys, std::vector<uint32_t>& Values, uint32_t KeyBits = 32, JobSystem* Jobs = nullptr);
+	void Sort(std::vector<uint64_t>& Keys, std::vector<uint32_t>& Values, uint32_t KeyBits = 64, JobSystem* Jobs = nullptr);
+
+	//Passes the last Sort() ran and skipped
+	uint32_t GetLastPassCount() const { return mPassCount; }
+	uint32_t GetLastSkippedPassCount() const { return mSkippedPassCount; }
+
+private:
+	template <typename KeyType>
+	void SortKeys(std::vector<KeyType>& Keys, std::vector<KeyType>& ScratchKeys, std::vector<uint32_t>& Values,
+		uint32_t KeyBits, JobSystem* Jobs);
+
+private:
+	std::vector<uint32_t> mScratchKeys32;
+	std::vector<uint64_t> mScratchKeys64;
+	std::vector<uint32_t> mScratchValues;
+
+	//A digit histogram per block, and the bits that differ from the first key
+	std::vector<uint32_t> mHistograms;
+	std::vector<uint64_t> mBlockVaryingBits;
+
+	uint32_t mPassCount;
+	uint32_t mSkippedPassCount;
+};
@@ -0,0 +1,22 @@
+#include "RenderCommandList.h"
+#include "Common.h"
+
+const char* GetRenderCommandName(RenderCommandType Type)
+{
+	switch (Type)
+	{
+	case RenderCommandType::SetPipelineState:			return "SetPipelineState";
+	case RenderCommandType::SetRootSignature:			return "SetGraphicsRootSignature";
+	case RenderCommandType::SetDescriptorTable:			return "SetGraphicsRootDescriptorTable";
+	case RenderCommandType::SetRootShaderResourceView:	return "SetGraphicsRootShaderResourceView";
+	case RenderCommandType::SetMesh:					return "SetMesh";
+	case RenderCommandType::SetViewport:				return "RSSetViewports";
+	case RenderCommandType::SetRenderTargets:			return "OMSetRenderTargets";
+	case RenderCommandType::DrawIndexedInstanced:		return "DrawIndexedInstanced";
+	case RenderCommandType::ResourceBarrier:			return "ResourceBarrier";
+	case RenderCommandType::CopyBufferRegion:			return "CopyBufferRegion";
+	default:
+		Assert(false);
+		return "";
+	}
+}
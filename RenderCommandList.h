@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+
+//The calls the renderer records, one for each IRenderCommandList method.
+enum class RenderCommandType : uint8_t
+{
+	SetPipelineState,
+	SetRootSignature,
+	SetDescriptorTable,
+	SetRootShaderResourceView,
+	SetMesh,
+	SetViewport,
+	SetRenderTargets,
+	DrawIndexedInstanced,
+	ResourceBarrier,
+	CopyBufferRegion,
+	Count
+};
+
+const char* GetRenderCommandName(RenderCommandType Type);
+
+struct RenderViewport
+{
+	float X;
+	float Y;
+	float Width;
+	float Height;
+	float MinDepth;
+	float MaxDepth;
+};
+
+const uint32_t MaxRenderTargets = 8;
+
+//The resource states transition barriers move between
+enum class RenderResourceState : uint8_t
+{
+	Common,
+	VertexAndConstantBuffer,
+	IndexBuffer,
+	RenderTarget,
+	DepthWrite,
+	DepthRead,
+	ShaderResource,
+	CopyDest,
+	CopySource,
+	Present,
+	Count
+};
+
+//A graphics command list in renderer ids - the same indices DrawPacket uses -
+//so draw recording code is the same whether it ends up in a D3D12 command
+//list or a stand-in that only measures it.
+class IRenderCommandList
+{
+public:
+	IRenderCommandList() {};
+	virtual ~IRenderCommandList() {};
+
+	virtual void SetPipelineState(uint32_t PipelineState) = 0;
+	virtual void SetGraphicsRootSignature(uint32_t RootSignature) = 0;
+	virtual void SetGraphicsRootDescriptorTable(uint32_t RootParameter, uint32_t Table) = 0;
+	virtual void SetGraphicsRootShaderResourceView(uint32_t RootParameter, uint64_t GpuAddress) = 0;
+
+	//Vertex and index buffers of one mesh
+	virtual void SetMesh(uint32_t Mesh) = 0;
+
+	virtual void SetViewport(const RenderViewport& Viewport) = 0;
+
+	//CPU descriptor handles (D3D12_CPU_DESCRIPTOR_HANDLE::ptr); a DepthStencil
+	//of 0 binds none
+	virtual void SetRenderTargets(uint32_t Count, const uint64_t* RenderTargets, uint64_t DepthStencil) = 0;
+
+	virtual void DrawIndexedInstanced(uint32_t IndexCountPerInstance, uint32_t InstanceCount, uint32_t StartIndexLocation,
+		int32_t BaseVertexLocation, uint32_t StartInstanceLocation) = 0;
+
+	//Resources are renderer ids too
+	virtual void ResourceBarrier(uint32_t Resource, RenderResourceState Before, RenderResourceState After) = 0;
+	virtual void CopyBufferRegion(uint32_t Destination, uint64_t DestinationOffset, uint32_t Source, uint64_t SourceOffset,
+		uint64_t Size) = 0;
+};
@@ -0,0 +1,373 @@
+#include "RenderCommandStream.h"
+#include "Common.h"
+
+#include <string.h>
+
+namespace
+{
+	//Seven bits a byte, low first, top bit set on all but the last
+	inline uint8_t* WriteVarint(uint8_t* Out, uint64_t Value)
+	{
+		while (Value >= 0x80)
+		{
+			*Out++ = static_cast<uint8_t>(Value) | 0x80;
+			Value >>= 7;
+		}
+		*Out++ = static_cast<uint8_t>(Value);
+		return Out;
+	}
+
+	inline uint64_t ReadVarint(const uint8_t*& In)
+	{
+		uint64_t Value = 0;
+		uint32_t Shift = 0;
+		uint8_t Byte;
+		do
+		{
+			Byte = *In++;
+			Value |= static_cast<uint64_t>(Byte & 0x7F) << Shift;
+			Shift += 7;
+		} while ((Byte & 0x80) && Shift < 64);
+		return Value;
+	}
+
+	//Small differences either way make small varints
+	inline uint8_t* WriteDelta(uint8_t* Out, uint64_t Value, uint64_t Previous)
+	{
+		int64_t Delta = static_cast<int64_t>(Value - Previous);
+		return WriteVarint(Out, (static_cast<uint64_t>(Delta) << 1) ^ static_cast<uint64_t>(Delta >> 63));
+	}
+
+	inline uint64_t ReadDelta(const uint8_t*& In, uint64_t Previous)
+	{
+		uint64_t ZigZag = ReadVarint(In);
+		return Previous + ((ZigZag >> 1) ^ (0 - (ZigZag & 1)));
+	}
+
+	//Deltas of 32 bit fields wrap in 32 bits, so they stay small across 0
+	inline uint8_t* WriteDelta32(uint8_t* Out, uint32_t Value, uint32_t Previous)
+	{
+		int32_t Delta = static_cast<int32_t>(Value - Previous);
+		return WriteVarint(Out, (static_cast<uint32_t>(Delta) << 1) ^ static_cast<uint32_t>(Delta >> 31));
+	}
+
+	inline uint32_t ReadDelta32(const uint8_t*& In, uint32_t Previous)
+	{
+		uint32_t ZigZag = static_cast<uint32_t>(ReadVarint(In));
+		return Previous + ((ZigZag >> 1) ^ (0u - (ZigZag & 1)));
+	}
+}
+
+RenderCommandArena::RenderCommandArena()
+	: mUsedPages(0)
+{}
+
+RenderCommandArena::~RenderCommandArena()
+{}
+
+uint8_t* RenderCommandArena::AcquirePage()
+{
+	std::lock_guard<std::mutex> Lock(mMutex);
+	if (mUsedPages == mPages.size())
+	{
+		mPages.emplace_back(new uint8_t[PageSize]);
+	}
+	return mPages[mUsedPages++].get();
+}
+
+void RenderCommandArena::Reset()
+{
+	std::lock_guard<std::mutex> Lock(mMutex);
+	mUsedPages = 0;
+}
+
+uint32_t RenderCommandArena::GetPageCount() const
+{
+	std::lock_guard<std::mutex> Lock(mMutex);
+	return static_cast<uint32_t>(mPages.size());
+}
+
+uint32_t RenderCommandArena::GetUsedPageCount() const
+{
+	std::lock_guard<std::mutex> Lock(mMutex);
+	return mUsedPages;
+}
+
+RenderCommandStream::RenderCommandStream(RenderCommandArena* Arena)
+	: mArena(Arena)
+{
+	Assert(mArena);
+	Reset();
+}
+
+RenderCommandStream::~RenderCommandStream()
+{}
+
+void RenderCommandStream::Reset()
+{
+	mPages.clear();
+	mWrite = nullptr;
+	mWriteEnd = nullptr;
+	mCommandCount = 0;
+	memset(&mState, 0, sizeof(mState));
+}
+
+uint64_t RenderCommandStream::GetByteSize() const
+{
+	uint64_t Size = 0;
+	for (const Page& Written : mPages)
+	{
+		Size += Written.Size;
+	}
+	return Size;
+}
+
+uint8_t* RenderCommandStream::BeginCommand(RenderCommandType Type)
+{
+	if (static_cast<size_t>(mWriteEnd - mWrite) < MaxCommandSize)
+	{
+		Page NewPage;
+		NewPage.Data = mArena->AcquirePage();
+		NewPage.Size = 0;
+		mPages.push_back(NewPage);
+		mWrite = NewPage.Data;
+		mWriteEnd = NewPage.Data + RenderCommandArena::PageSize;
+	}
+
+	++mCommandCount;
+	*mWrite = static_cast<uint8_t>(Type);
+	return mWrite + 1;
+}
+
+void RenderCommandStream::EndCommand(uint8_t* End)
+{
+	Assert(End - mWrite <= static_cast<ptrdiff_t>(MaxCommandSize));
+	mPages.back().Size += static_cast<uint32_t>(End - mWrite);
+	mWrite = End;
+}
+
+void RenderCommandStream::SetPipelineState(uint32_t PipelineState)
+{
+	uint8_t* Out = BeginCommand(RenderCommandType::SetPipelineState);
+	Out = WriteDelta32(Out, PipelineState, mState.PipelineState);
+	mState.PipelineState = PipelineState;
+	EndCommand(Out);
+}
+
+void RenderCommandStream::SetGraphicsRootSignature(uint32_t RootSignature)
+{
+	uint8_t* Out = BeginCommand(RenderCommandType::SetRootSignature);
+	Out = WriteDelta32(Out, RootSignature, mState.RootSignature);
+	mState.RootSignature = RootSignature;
+	EndCommand(Out);
+}
+
+void RenderCommandStream::SetGraphicsRootDescriptorTable(uint32_t RootParameter, uint32_t Table)
+{
+	uint8_t* Out = BeginCommand(RenderCommandType::SetDescriptorTable);
+	Out = WriteVarint(Out, RootParameter);
+	Out = WriteDelta32(Out, Table, mState.Table);
+	mState.Table = Table;
+	EndCommand(Out);
+}
+
+void RenderCommandStream::SetGraphicsRootShaderResourceView(uint32_t RootParameter, uint64_t GpuAddress)
+{
+	uint8_t* Out = BeginCommand(RenderCommandType::SetRootShaderResourceView);
+	Out = WriteVarint(Out, RootParameter);
+	Out = WriteDelta(Out, GpuAddress, mState.ShaderResourceView);
+	mState.ShaderResourceView = GpuAddress;
+	EndCommand(Out);
+}
+
+void RenderCommandStream::SetMesh(uint32_t Mesh)
+{
+	uint8_t* Out = BeginCommand(RenderCommandType::SetMesh);
+	Out = WriteDelta32(Out, Mesh, mState.Mesh);
+	mState.Mesh = Mesh;
+	EndCommand(Out);
+}
+
+void RenderCommandStream::SetViewport(const RenderViewport& Viewport)
+{
+	uint8_t* Out = BeginCommand(RenderCommandType::SetViewport);
+	memcpy(Out, &Viewport, sizeof(Viewport));
+	EndCommand(Out + sizeof(Viewport));
+}
+
+void RenderCommandStream::SetRenderTargets(uint32_t Count, const uint64_t* RenderTargets, uint64_t DepthStencil)
+{
+	Assert(Count <= MaxRenderTargets);
+	uint8_t* Out = BeginCommand(RenderCommandType::SetRenderTargets);
+	*Out++ = static_cast<uint8_t>(Count);
+	Out = WriteVarint(Out, DepthStencil);
+
+	//Handles of a pass's targets are usually neighbours in one heap
+	uint64_t Previous = DepthStencil;
+	for (uint32_t i = 0; i < Count; ++i)
+	{
+		Out = WriteDelta(Out, RenderTargets[i], Previous);
+		Previous = RenderTargets[i];
+	}
+	EndCommand(Out);
+}
+
+void RenderCommandStream::DrawIndexedInstanced(uint32_t IndexCountPerInstance, uint32_t InstanceCount, uint32_t StartIndexLocation,
+	int32_t BaseVertexLocation, uint32_t StartInstanceLocation)
+{
+	uint8_t* Out = BeginCommand(RenderCommandType::DrawIndexedInstanced);
+	Out = WriteDelta32(Out, IndexCountPerInstance, mState.IndexCount);
+	Out = WriteVarint(Out, InstanceCount);
+	Out = WriteDelta32(Out, StartIndexLocation, mState.StartIndex);
+	Out = WriteDelta32(Out, static_cast<uint32_t>(BaseVertexLocation), static_cast<uint32_t>(mState.BaseVertex));
+	Out = WriteVarint(Out, StartInstanceLocation);
+	mState.IndexCount = IndexCountPerInstance;
+	mState.StartIndex = StartIndexLocation;
+	mState.BaseVertex = BaseVertexLocation;
+	EndCommand(Out);
+}
+
+void RenderCommandStream::ResourceBarrier(uint32_t Resource, RenderResourceState Before, RenderResourceState After)
+{
+	uint8_t* Out = BeginCommand(RenderCommandType::ResourceBarrier);
+	Out = WriteDelta32(Out, Resource, mState.Resource);
+	*Out++ = static_cast<uint8_t>((static_cast<uint32_t>(Before) << 4) | static_cast<uint32_t>(After));
+	mState.Resource = Resource;
+	EndCommand(Out);
+}
+
+void RenderCommandStream::CopyBufferRegion(uint32_t Destination, uint64_t DestinationOffset, uint32_t Source, uint64_t SourceOffset,
+	uint64_t Size)
+{
+	uint8_t* Out = BeginCommand(RenderCommandType::CopyBufferRegion);
+	Out = WriteDelta32(Out, Destination, mState.Resource);
+	Out = WriteVarint(Out, DestinationOffset);
+	Out = WriteDelta32(Out, Source, Destination);
+	Out = WriteVarint(Out, SourceOffset);
+	Out = WriteVarint(Out, Size);
+	mState.Resource = Source;
+	EndCommand(Out);
+}
+
+void RenderCommandStream::CopyBytes(uint8_t* Out) const
+{
+	for (const Page& Written : mPages)
+	{
+		memcpy(Out, Written.Data, Written.Size);
+		Out += Written.Size;
+	}
+}
+
+void RenderCommandStream::Replay(IRenderCommandList& Target) const
+{
+	DeltaState State;
+	memset(&State, 0, sizeof(State));
+	for (const Page& Written : mPages)
+	{
+		Decode(Written.Data, Written.Data + Written.Size, State, Target);
+	}
+}
+
+void RenderCommandStream::Replay(const uint8_t* Data, uint64_t Size, IRenderCommandList& Target)
+{
+	DeltaState State;
+	memset(&State, 0, sizeof(State));
+	Decode(Data, Data + Size, State, Target);
+}
+
+void RenderCommandStream::Decode(const uint8_t* In, const uint8_t* End, DeltaState& State, IRenderCommandList& Target)
+{
+	static_assert(static_cast<uint32_t>(RenderResourceState::Count) <= 16, "Barrier states are packed in 4 bits");
+
+	while (In < End)
+	{
+		RenderCommandType Type = static_cast<RenderCommandType>(*In++);
+		switch (Type)
+		{
+		case RenderCommandType::SetPipelineState:
+			State.PipelineState = ReadDelta32(In, State.PipelineState);
+			Target.SetPipelineState(State.PipelineState);
+			break;
+		case RenderCommandType::SetRootSignature:
+			State.RootSignature = ReadDelta32(In, State.RootSignature);
+			Target.SetGraphicsRootSignature(State.RootSignature);
+			break;
+		case RenderCommandType::SetDescriptorTable:
+		{
+			uint32_t RootParameter = static_cast<uint32_t>(ReadVarint(In));
+			State.Table = ReadDelta32(In, State.Table);
+			Target.SetGraphicsRootDescriptorTable(RootParameter, State.Table);
+			break;
+		}
+		case RenderCommandType::SetRootShaderResourceView:
+		{
+			uint32_t RootParameter = static_cast<uint32_t>(ReadVarint(In));
+			State.ShaderResourceView = ReadDelta(In, State.ShaderResourceView);
+			Target.SetGraphicsRootShaderResourceView(RootParameter, State.ShaderResourceView);
+			break;
+		}
+		case RenderCommandType::SetMesh:
+			State.Mesh = ReadDelta32(In, State.Mesh);
+			Target.SetMesh(State.Mesh);
+			break;
+		case RenderCommandType::SetViewport:
+		{
+			RenderViewport Viewport;
+			memcpy(&Viewport, In, sizeof(Viewport));
+			In += sizeof(Viewport);
+			Target.SetViewport(Viewport);
+			break;
+		}
+		case RenderCommandType::SetRenderTargets:
+		{
+			uint32_t Count = *In++;
+			Check(Count <= MaxRenderTargets);
+			uint64_t DepthStencil = ReadVarint(In);
+			uint64_t RenderTargets[MaxRenderTargets];
+			uint64_t Previous = DepthStencil;
+			for (uint32_t i = 0; i < Count; ++i)
+			{
+				RenderTargets[i] = ReadDelta(In, Previous);
+				Previous = RenderTargets[i];
+			}
+			Target.SetRenderTargets(Count, RenderTargets, DepthStencil);
+			break;
+		}
+		case RenderCommandType::DrawIndexedInstanced:
+		{
+			State.IndexCount = ReadDelta32(In, State.IndexCount);
+			uint32_t InstanceCount = static_cast<uint32_t>(ReadVarint(In));
+			State.StartIndex = ReadDelta32(In, State.StartIndex);
+			State.BaseVertex = static_cast<int32_t>(ReadDelta32(In, static_cast<uint32_t>(State.BaseVertex)));
+			uint32_t StartInstance = static_cast<uint32_t>(ReadVarint(In));
+			Target.DrawIndexedInstanced(State.IndexCount, InstanceCount, State.StartIndex, State.BaseVertex, StartInstance);
+			break;
+		}
+		case RenderCommandType::ResourceBarrier:
+		{
+			State.Resource = ReadDelta32(In, State.Resource);
+			uint8_t States = *In++;
+			Check((States >> 4) < static_cast<uint32_t>(RenderResourceState::Count) &&
+				(States & 0xF) < static_cast<uint32_t>(RenderResourceState::Count));
+			Target.ResourceBarrier(State.Resource, static_cast<RenderResourceState>(States >> 4),
+				static_cast<RenderResourceState>(States & 0xF));
+			break;
+		}
+		case RenderCommandType::CopyBufferRegion:
+		{
+			uint32_t Destination = ReadDelta32(In, State.Resource);
+			uint64_t DestinationOffset = ReadVarint(In);
+			uint32_t Source = ReadDelta32(In, Destination);
+			uint64_t SourceOffset = ReadVarint(In);
+			uint64_t Size = ReadVarint(In);
+			State.Resource = Source;
+			Target.CopyBufferRegion(Destination, DestinationOffset, Source, SourceOffset, Size);
+			break;
+		}
+		default:
+			Check(false);
+			return;
+		}
+	}
+	Check(In == End);
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "RenderCommandList.h"
+
+//Fixed size pages that a frame's command streams are written in to. Pages
+//are kept when the arena is reset, so once it has grown to hold a frame,
+//recording allocates nothing. Streams on any thread can share one arena.
+class RenderCommandArena
+{
+public:
+	static const uint32_t PageSize = 64 * 1024;
+
+	RenderCommandArena();
+	~RenderCommandArena();
+
+	uint8_t* AcquirePage();
+
+	//Every stream written in to the arena must be Reset() or finished with first
+	void Reset();
+
+	uint32_t GetPageCount() const;
+	uint32_t GetUsedPageCount() const;
+
+private:
+	mutable std::mutex mMutex;
+	std::vector<std::unique_ptr<uint8_t[]>> mPages;
+	uint32_t mUsedPages;
+};
+
+//Commands recorded as a compact binary stream of plain data, to be replayed
+//later on any IRenderCommandList - D3D12RenderCommandList to translate them
+//in to API calls. Recording touches no API, so a frontend can fill streams on
+//any thread and on any platform.
+//
+//Each command is an opcode byte and variable length integers. Ids, addresses
+//and draw arguments are written as the difference from the last of the same
+//kind, so sorted draws cost a few bytes each. Commands never straddle pages.
+class RenderCommandStream : public IRenderCommandList
+{
+public:
+	static const uint32_t MaxCommandSize = 128;
+
+	RenderCommandStream(RenderCommandArena* Arena);
+	~RenderCommandStream();
+
+	//Empties the stream. Its pages go back when the arena is reset.
+	void Reset();
+
+	void SetPipelineState(uint32_t PipelineState) override;
+	void SetGraphicsRootSignature(uint32_t RootSignature) override;
+	void SetGraphicsRootDescriptorTable(uint32_t RootParameter, uint32_t Table) override;
+	void SetGraphicsRootShaderResourceView(uint32_t RootParameter, uint64_t GpuAddress) override;
+	void SetMesh(uint32_t Mesh) override;
+	void SetViewport(const RenderViewport& Viewport) override;
+	void SetRenderTargets(uint32_t Count, const uint64_t* RenderTargets, uint64_t DepthStencil) override;
+	void DrawIndexedInstanced(uint32_t IndexCountPerInstance, uint32_t InstanceCount, uint32_t StartIndexLocation,
+		int32_t BaseVertexLocation, uint32_t StartInstanceLocation) override;
+	void ResourceBarrier(uint32_t Resource, RenderResourceState Before, RenderResourceState After) override;
+	void CopyBufferRegion(uint32_t Destination, uint64_t DestinationOffset, uint32_t Source, uint64_t SourceOffset,
+		uint64_t Size) override;
+
+	//Makes every call recorded, in order
+	void Replay(IRenderCommandList& Target) const;
+
+	//The stream as one run of bytes, GetByteSize() long, for saving
+	void CopyBytes(uint8_t* Out) const;
+
+	//Replays bytes from CopyBytes(). Reads up to MaxCommandSize bytes past
+	//the end if the data is malformed, so loaded streams need that padding.
+	static void Replay(const uint8_t* Data, uint64_t Size, IRenderCommandList& Target);
+
+	uint32_t GetCommandCount() const { return mCommandCount; }
+	uint64_t GetByteSize() const;
+
+private:
+	//The last value of each delta coded field
+	struct DeltaState
+	{
+		uint32_t PipelineState;
+		uint32_t RootSignature;
+		uint32_t Table;
+		uint32_t Mesh;
+		uint32_t Resource;
+		uint64_t ShaderResourceView;
+		uint32_t IndexCount;
+		uint32_t StartIndex;
+		int32_t BaseVertex;
+	};
+
+	//Room for one command, starting a new page if needed
+	uint8_t* BeginCommand(RenderCommandType Type);
+	void EndCommand(uint8_t* End);
+
+	//Decodes commands up to End, carrying State on across calls
+	static void Decode(const uint8_t* In, const uint8_t* End, DeltaState& State, IRenderCommandList& Target);
+
+private:
+	struct Page
+	{
+		uint8_t* Data;
+		uint32_t Size;
+	};
+
+	RenderCommandArena* mArena;
+	std::vector<Page> mPages;
+	uint8_t* mWrite;
+	uint8_t* mWriteEnd;
+	uint32_t mCommandCount;
+	DeltaState mState;
+};
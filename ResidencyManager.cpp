@@ -0,0 +1,213 @@
+#include "ResidencyManager.h"
+#include "Common.h"
+
+#include <chrono>
+
+ResidencyManager::ResidencyManager(IResidencyDevice* Device, IFence* Fence, uint64_t BudgetInBytes)
+	: mDevice(Device), mFence(Fence), mBudgetInBytes(BudgetInBytes), mResidentBytes(0),
+	mSubmissionStamp(0), mLruHead(InvalidResidencyHandle), mLruTail(InvalidResidencyHandle)
+{
+	Assert(mDevice);
+	Assert(mFence);
+}
+
+ResidencyManager::~ResidencyManager()
+{}
+
+ResidencyHandle ResidencyManager::Track(void* Object, uint64_t SizeInBytes)
+{
+	ResidencyHandle Handle;
+	if (!mFreeHandles.empty())
+	{
+		Handle = mFreeHandles.back();
+		mFreeHandles.pop_back();
+	}
+	else
+	{
+		Handle = static_cast<ResidencyHandle>(mObjects.size());
+		mObjects.emplace_back();
+	}
+
+	ManagedObject& Managed = mObjects[Handle];
+	Managed = ManagedObject();
+	Managed.Object = Object;
+	Managed.SizeInBytes = SizeInBytes;
+	Managed.LastUsedFence = mFence->GetCompletedValue();
+	Managed.bTracked = true;
+	Managed.bResident = true;
+
+	LruPushBack(Handle);
+	mResidentBytes += SizeInBytes;
+
+	return Handle;
+}
+
+void ResidencyManager::Untrack(ResidencyHandle Handle)
+{
+	Assert(Handle < mObjects.size() && mObjects[Handle].bTracked);
+	ManagedObject& Managed = mObjects[Handle];
+
+	if (Managed.bResident)
+	{
+		LruUnlink(Handle);
+		mResidentBytes -= Managed.SizeInBytes;
+	}
+
+	Managed.bTracked = false;
+	Managed.bResident = false;
+	mFreeHandles.push_back(Handle);
+}
+
+uint64_t ResidencyManager::PrepareSubmission(const ResidencySet* const* Sets, uint32_t SetCount)
+{
+	uint64_t SubmissionFence = mFence->GetLastSignalledValue() + 1;
+	++mSubmissionStamp;
+	++mStats.Submissions;
+
+	//Stamp everything referenced - resident objects move to the most recently
+	//used end, the rest are gathered for a single MakeResident.
+	mToMakeResident.clear();
+	uint64_t BytesNeeded = 0;
+
+	for (uint32_t SetIdx = 0; SetIdx < SetCount; ++SetIdx)
+	{
+		for (ResidencyHandle Handle : Sets[SetIdx]->GetHandles())
+		{
+			Assert(Handle < mObjects.size() && mObjects[Handle].bTracked);
+			ManagedObject& Managed = mObjects[Handle];
+
+			if (Managed.SubmissionStamp == mSubmissionStamp)
+			{
+				continue;
+			}
+			Managed.SubmissionStamp = mSubmissionStamp;
+			Managed.LastUsedFence = SubmissionFence;
+
+			if (Managed.bResident)
+			{
+				LruUnlink(Handle);
+				LruPushBack(Handle);
+			}
+			else
+			{
+				mToMakeResident.push_back(Handle);
+				BytesNeeded += Managed.SizeInBytes;
+			}
+		}
+	}
+
+	if (mResidentBytes + BytesNeeded > mBudgetInBytes)
+	{
+		EvictFor(BytesNeeded, SubmissionFence);
+	}
+
+	if (!mToMakeResident.empty())
+	{
+		mPagingBatch.clear();
+		for (ResidencyHandle Handle : mToMakeResident)
+		{
+			ManagedObject& Managed = mObjects[Handle];
+			Managed.bResident = true;
+			LruPushBack(Handle);
+			mResidentBytes += Managed.SizeInBytes;
+
+			mPagingBatch.push_back(Managed.Object);
+		}
+
+		mDevice->MakeResident(mPagingBatch.data(), static_cast<uint32_t>(mPagingBatch.size()), BytesNeeded);
+
+		++mStats.MakeResidentCalls;
+		mStats.ObjectsMadeResident += mPagingBatch.size();
+		mStats.BytesMadeResident += BytesNeeded;
+	}
+
+	return SubmissionFence;
+}
+
+void ResidencyManager::EvictFor(uint64_t BytesNeeded, uint64_t SubmissionFence)
+{
+	mPagingBatch.clear();
+	uint64_t BytesEvicted = 0;
+
+	while (mResidentBytes + BytesNeeded > mBudgetInBytes && mLruHead != InvalidResidencyHandle)
+	{
+		ResidencyHandle Victim = mLruHead;
+		ManagedObject& Managed = mObjects[Victim];
+
+		//Everything left is needed by this submission - nothing more we can do.
+		if (Managed.LastUsedFence >= SubmissionFence)
+		{
+			++mStats.OverBudgetSubmissions;
+			break;
+		}
+
+		//Still in use by the GPU - have to wait before it can go.
+		if (!mFence->IsComplete(Managed.LastUsedFence))
+		{
+			auto Start = std::chrono::high_resolution_clock::now();
+			mFence->WaitForValue(Managed.LastUsedFence);
+			mStats.StallMilliseconds += std::chrono::duration<double, std::milli>(
+				std::chrono::high_resolution_clock::now() - Start).count();
+			++mStats.FenceStalls;
+		}
+
+		LruUnlink(Victim);
+		Managed.bResident = false;
+		mResidentBytes -= Managed.SizeInBytes;
+		BytesEvicted += Managed.SizeInBytes;
+
+		mPagingBatch.push_back(Managed.Object);
+	}
+
+	if (!mPagingBatch.empty())
+	{
+		mDevice->Evict(mPagingBatch.data(), static_cast<uint32_t>(mPagingBatch.size()), BytesEvicted);
+
+		++mStats.EvictCalls;
+		mStats.ObjectsEvicted += mPagingBatch.size();
+		mStats.BytesEvicted += BytesEvicted;
+	}
+}
+
+void ResidencyManager::LruUnlink(ResidencyHandle Handle)
+{
+	ManagedObject& Managed = mObjects[Handle];
+
+	if (Managed.Prev != InvalidResidencyHandle)
+	{
+		mObjects[Managed.Prev].Next = Managed.Next;
+	}
+	else
+	{
+		mLruHead = Managed.Next;
+	}
+
+	if (Managed.Next != InvalidResidencyHandle)
+	{
+		mObjects[Managed.Next].Prev = Managed.Prev;
+	}
+	else
+	{
+		mLruTail = Managed.Prev;
+	}
+
+	Managed.Prev = InvalidResidencyHandle;
+	Managed.Next = InvalidResidencyHandle;
+}
+
+void ResidencyManager::LruPushBack(ResidencyHandle Handle)
+{
+	ManagedObject& Managed = mObjects[Handle];
+	Managed.Prev = mLruTail;
+	Managed.Next = InvalidResidencyHandle;
+
+	if (mLruTail != InvalidResidencyHandle)
+	{
+		mObjects[mLruTail].Next = Handle;
+	}
+	else
+	{
+		mLruHead = Handle;
+	}
+	mLruTail = Handle;
+}
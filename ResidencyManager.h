@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "IFence.h"
+
+//Heap/resource residency with LRU eviction.
+//
+//Every tracked object (an ID3D12Heap or committed ID3D12Resource in practice)
+//remembers the fence value of the last submission that referenced it. Before a
+//submission executes, everything in its residency sets is made resident; if that
+//takes us over budget the least recently used objects are evicted first. Objects
+//the GPU may still be using (last used fence not yet complete) can only be
+//evicted after waiting on the fence - that wait is the stall we try to avoid
+//and is recorded in the stats.
+//
+//MakeResident/Evict calls are batched - at most one of each per submission.
+
+typedef uint32_t ResidencyHandle;
+const ResidencyHandle InvalidResidencyHandle = 0xFFFFFFFF;
+
+//Performs the actual paging. Objects are whatever was passed to Track().
+class IResidencyDevice
+{
+public:
+	IResidencyDevice() {};
+	virtual ~IResidencyDevice() {};
+
+	virtual void MakeResident(void* const* Objects, uint32_t Count, uint64_t TotalSize) = 0;
+	virtual void Evict(void* const* Objects, uint32_t Count, uint64_t TotalSize) = 0;
+};
+
+//Objects referenced by one command list. Duplicates are fine.
+class ResidencySet
+{
+public:
+	ResidencySet() {};
+
+	void Insert(ResidencyHandle Handle) { mHandles.push_back(Handle); }
+	void Reset() { mHandles.clear(); }
+
+	const std::vector<ResidencyHandle>& GetHandles() const { return mHandles; }
+
+private:
+	std::vector<ResidencyHandle> mHandles;
+};
+
+struct ResidencyStats
+{
+	uint64_t Submissions = 0;
+	uint64_t MakeResidentCalls = 0;
+	uint64_t ObjectsMadeResident = 0;
+	uint64_t BytesMadeResident = 0;
+	uint64_t EvictCalls = 0;
+	uint64_t ObjectsEvicted = 0;
+	uint64_t BytesEvicted = 0;
+
+	uint64_t FenceStalls = 0;				//Waits needed to free memory still in use
+	double StallMilliseconds = 0.0;			//Wall time spent in those waits
+	uint64_t OverBudgetSubmissions = 0;		//Working set alone exceeded the budget
+};
+
+class ResidencyManager
+{
+public:
+	ResidencyManager(IResidencyDevice* Device, IFence* Fence, uint64_t BudgetInBytes);
+	~ResidencyManager();
+
+	//Objects start resident (as freshly created D3D12 objects are).
+	ResidencyHandle Track(void* Object, uint64_t SizeInBytes);
+	void Untrack(ResidencyHandle Handle);
+
+	void SetBudget(uint64_t BudgetInBytes) { mBudgetInBytes = BudgetInBytes; }
+	uint64_t GetBudget() const { return mBudgetInBytes; }
+	uint64_t GetResidentBytes() const { return mResidentBytes; }
+
+	//Call immediately before executing the command lists that the sets belong
+	//to, then signal the fence straight after. Returns the fence value that
+	//signal must produce (the objects' new last used value).
+	uint64_t PrepareSubmission(const ResidencySet* const* Sets, uint32_t SetCount);
+
+	bool IsResident(ResidencyHandle Handle) const { return mObjects[Handle].bResident; }
+
+	const ResidencyStats& GetStats() const { return mStats; }
+	void ResetStats() { mStats = ResidencyStats(); }
+
+private:
+	struct ManagedObject
+	{
+		void* Object = nullptr;
+		uint64_t SizeInBytes = 0;
+		uint64_t LastUsedFence = 0;
+		uint64_t SubmissionStamp = 0;
+		bool bTracked = false;
+		bool bResident = false;
+
+		//Intrusive LRU over resident objects - head is least recently used
+		ResidencyHandle Prev = InvalidResidencyHandle;
+		ResidencyHandle Next = InvalidResidencyHandle;
+	};
+
+	void LruUnlink(ResidencyHandle Handle);
+	void LruPushBack(ResidencyHandle Handle);
+
+	void EvictFor(uint64_t BytesNeeded, uint64_t SubmissionFence);
+
+private:
+	IResidencyDevice* mDevice;
+	IFence* mFence;
+
+	uint64_t mBudgetInBytes;
+	uint64_t mResidentBytes;
+	uint64_t mSubmissionStamp;
+
+	std::vector<ManagedObject> mObjects;
+	std::vector<ResidencyHandle> mFreeHandles;
+	ResidencyHandle mLruHead;
+	ResidencyHandle mLruTail;
+
+	//Batches - reused every submission
+	std::vector<ResidencyHandle> mToMakeResident;
+	std::vector<void*> mPagingBatch;
+
+	ResidencyStats mStats;
+};
@@ -0,0 +1,117 @@
+#include "ResidencySimulation.h"
+#include "Common.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdio.h>
+
+ResidencySimulation::ResidencySimulation(const ResidencySimulationSettings& Settings)
+	: mSettings(Settings), mRandomState(Settings.Seed ? Settings.Seed : 1)
+{
+	Assert(mSettings.ObjectCount > mSettings.HotSetSize);
+	Assert(mSettings.FramesInFlight > 0);
+}
+
+ResidencySimulation::~ResidencySimulation()
+{}
+
+const ResidencySimulationResults& ResidencySimulation::Run()
+{
+	mResults = ResidencySimulationResults();
+
+	SimulatedResidencyDevice Device;
+	SimulatedFence Fence;
+	ResidencyManager Manager(&Device, &Fence, mSettings.BudgetInBytes);
+
+	//Log-uniform sizes between min and max, 64KB aligned like real heaps.
+	std::vector<ResidencyHandle> Handles(mSettings.ObjectCount);
+	double LogMin = std::log(static_cast<double>(mSettings.MinObjectSize));
+	double LogMax = std::log(static_cast<double>(mSettings.MaxObjectSize));
+	for (unsigned i = 0; i < mSettings.ObjectCount; ++i)
+	{
+		double T = static_cast<double>(NextRandom() & 0xFFFFFF) / static_cast<double>(0xFFFFFF);
+		uint64_t Size = static_cast<uint64_t>(std::exp(LogMin + (LogMax - LogMin) * T));
+		Size = (Size + 0xFFFF) & ~0xFFFFull;
+
+		//The simulated device never dereferences objects - the index will do.
+		Handles[i] = Manager.Track(reinterpret_cast<void*>(static_cast<uintptr_t>(i + 1)), Size);
+	}
+
+	//Created objects start resident - let the manager trim to budget on the
+	//first submission like it would at load time.
+	Manager.ResetStats();
+
+	ResidencySet FrameSet;
+	unsigned StreamedCount = mSettings.ObjectCount - mSettings.HotSetSize;
+	unsigned WindowSize = std::min(mSettings.WindowSize, StreamedCount);
+
+	for (unsigned Frame = 0; Frame < mSettings.FrameCount; ++Frame)
+	{
+		//GPU runs FramesInFlight behind the CPU
+		if (Frame >= mSettings.FramesInFlight)
+		{
+			Fence.AdvanceTo(Frame - mSettings.FramesInFlight + 1);
+		}
+
+		FrameSet.Reset();
+		for (unsigned i = 0; i < mSettings.HotSetSize; ++i)
+		{
+			FrameSet.Insert(Handles[i]);
+		}
+
+		unsigned WindowStart = static_cast<unsigned>(Frame * mSettings.WindowObjectsPerFrame) % StreamedCount;
+		for (unsigned i = 0; i < WindowSize; ++i)
+		{
+			FrameSet.Insert(Handles[mSettings.HotSetSize + (WindowStart + i) % StreamedCount]);
+		}
+
+		const ResidencySet* Sets[] = { &FrameSet };
+		uint64_t Expected = Manager.PrepareSubmission(Sets, 1);
+		uint64_t Signalled = Fence.Signal();
+		Assert(Expected == Signalled);
+
+		mResults.PeakResidentBytes = std::max(mResults.PeakResidentBytes, Manager.GetResidentBytes());
+	}
+
+	mResults.Stats = Manager.GetStats();
+	mResults.FenceStalledSignals = Fence.GetStalledSignals();
+	mResults.ModeledStallMilliseconds = static_cast<double>(Fence.GetStalledSignals()) * mSettings.GpuFrameMilliseconds;
+	mResults.ModeledPagingMilliseconds = static_cast<double>(mResults.Stats.BytesMadeResident) / mSettings.PagingBytesPerMillisecond;
+
+	return mResults;
+}
+
+bool ResidencySimulation::WriteReport(const char* Filename) const
+{
+	FILE* File = fopen(Filename, "w");
+	if (!File)
+	{
+		return false;
+	}
+
+	const ResidencyStats& Stats = mResults.Stats;
+	fprintf(File, "Budget (MB):               %.1f\n", mSettings.BudgetInBytes / (1024.0 * 1024.0));
+	fprintf(File, "Peak resident (MB):        %.1f\n", mResults.PeakResidentBytes / (1024.0 * 1024.0));
+	fprintf(File, "Submissions:               %llu\n", (unsigned long long)Stats.Submissions);
+	fprintf(File, "MakeResident calls:        %llu (%llu objects, %.1f MB)\n", (unsigned long long)Stats.MakeResidentCalls,
+		(unsigned long long)Stats.ObjectsMadeResident, Stats.BytesMadeResident / (1024.0 * 1024.0));
+	fprintf(File, "Evict calls:               %llu (%llu objects, %.1f MB)\n", (unsigned long long)Stats.EvictCalls,
+		(unsigned long long)Stats.ObjectsEvicted, Stats.BytesEvicted / (1024.0 * 1024.0));
+	fprintf(File, "Fence stalls:              %llu (%llu signals)\n", (unsigned long long)Stats.FenceStalls,
+		(unsigned long long)mResults.FenceStalledSignals);
+	fprintf(File, "Modeled stall time (ms):   %.2f\n", mResults.ModeledStallMilliseconds);
+	fprintf(File, "Modeled paging time (ms):  %.2f\n", mResults.ModeledPagingMilliseconds);
+	fprintf(File, "Over budget submissions:   %llu\n", (unsigned long long)Stats.OverBudgetSubmissions);
+
+	fclose(File);
+	return true;
+}
+
+unsigned ResidencySimulation::NextRandom()
+{
+	//xorshift32 - identical runs on every platform/CRT.
+	mRandomState ^= mRandomState << 13;
+	mRandomState ^= mRandomState >> 17;
+	mRandomState ^= mRandomState << 5;
+	return mRandomState;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "ResidencyManager.h"
+#include "SimulatedFence.h"
+
+//Replays a synthetic working set through a ResidencyManager against a budget,
+//with a simulated device and fence. The working set is a window sliding
+//through the object list (like a camera moving through a level) plus a hot set
+//used every frame.
+struct ResidencySimulationSettings
+{
+	unsigned ObjectCount = 4000;
+	unsigned Seed = 1;
+	uint64_t MinObjectSize = 64ull * 1024ull;
+	uint64_t MaxObjectSize = 16ull * 1024ull * 1024ull;
+
+	uint64_t BudgetInBytes = 3072ull * 1024ull * 1024ull;
+
+	unsigned FrameCount = 3600;
+	unsigned FramesInFlight = 2;
+
+	unsigned HotSetSize = 100;			//Objects [0, HotSetSize) used every frame
+	unsigned WindowSize = 600;			//Objects used per frame from the sliding window
+	float WindowObjectsPerFrame = 1.0f;	//How far the window slides each frame
+
+	//Models for turning counts in to time
+	float GpuFrameMilliseconds = 16.0f;		//A stalled signal costs one GPU frame
+	float PagingBytesPerMillisecond = 8.0f * 1024.0f * 1024.0f;
+};
+
+struct ResidencySimulationResults
+{
+	ResidencyStats Stats;
+	uint64_t PeakResidentBytes = 0;
+	uint64_t FenceStalledSignals = 0;
+	double ModeledStallMilliseconds = 0.0;
+	double ModeledPagingMilliseconds = 0.0;
+};
+
+class ResidencySimulation
+{
+public:
+	ResidencySimulation(const ResidencySimulationSettings& Settings);
+	~ResidencySimulation();
+
+	const ResidencySimulationResults& Run();
+	bool WriteReport(const char* Filename) const;
+
+private:
+	//Pages nothing - traffic is already counted in the ResidencyManager stats.
+	class SimulatedResidencyDevice : public IResidencyDevice
+	{
+	public:
+		void MakeResident(void* const* Objects, uint32_t Count, uint64_t TotalSize) override {}
+		void Evict(void* const* Objects, uint32_t Count, uint64_t TotalSize) override {}
+	};
+
+	unsigned NextRandom();
+
+private:
+	ResidencySimulationSettings mSettings;
+	ResidencySimulationResults mResults;
+	unsigned mRandomState;
+};
@@ -0,0 +1,161 @@
+#include "SceneManager.h"
+#include "Common.h"
+#include "CoroutineScheduler.h"
+#include "DeferredReleaseQueue.h"
+#include "IScene.h"
+
+#include <chrono>
+
+namespace
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	double ToMilliseconds(Clock::duration Duration)
+	{
+		return std::chrono::duration<double, std::milli>(Duration).count();
+	}
+}
+
+SceneManager::SceneManager(CoroutineScheduler* Scheduler, DeferredReleaseQueue* ReleaseQueue, JobSystem* Jobs)
+	: mScheduler(Scheduler), mReleaseQueue(ReleaseQueue), mJobs(Jobs), mPendingLoaded(false), mPendingSucceeded(false),
+	mFrameIndex(0)
+{
+	Assert(mScheduler && mReleaseQueue);
+}
+
+SceneManager::~SceneManager()
+{
+	//Shutdown() first - scenes have to go through the release queue
+	Assert(!mActiveScene && !mPendingScene);
+
+	if (mJobs)
+	{
+		mJobs->Wait(mDestroyCounter);
+	}
+}
+
+bool SceneManager::RequestScene(std::unique_ptr<IScene> Scene)
+{
+	Assert(Scene);
+	if (mPendingScene)
+	{
+		return false;
+	}
+
+	mPendingScene = std::move(Scene);
+	mPendingLoaded = false;
+	mPendingSucceeded = false;
+
+	mCurrentTransition = SceneTransitionStats();
+	mCurrentTransition.RequestFrame = mFrameIndex;
+
+	mScheduler->Spawn(LoadScene(mPendingScene.get()));
+	return true;
+}
+
+AsyncTask<void> SceneManager::LoadScene(IScene* Scene)
+{
+	Clock::time_point Start = Clock::now();
+	bool bSucceeded = co_await Scene->OnInitScene();
+
+	mCurrentTransition.LoadMilliseconds = ToMilliseconds(Clock::now() - Start);
+	mPendingLoaded = true;
+	mPendingSucceeded = bSucceeded;
+}
+
+void SceneManager::Update(float dt)
+{
+	if (mPendingScene && mPendingLoaded)
+	{
+		SwapInPendingScene();
+	}
+
+	if (mActiveScene)
+	{
+		mActiveScene->OnUpdate(dt);
+	}
+
+	++mFrameIndex;
+}
+
+void SceneManager::Render()
+{
+	if (mActiveScene)
+	{
+		mActiveScene->OnRender();
+	}
+}
+
+int SceneManager::Shutdown()
+{
+	while (mPendingScene && !mPendingLoaded)
+	{
+		mScheduler->Pump();
+	}
+
+	int Result = 0;
+	if (mPendingScene)
+	{
+		Result = mPendingScene->OnCloseScene();
+		RetireScene(std::move(mPendingScene));
+	}
+	if (mActiveScene)
+	{
+		int ActiveResult = mActiveScene->OnCloseScene();
+		Result = Result ? Result : ActiveResult;
+		RetireScene(std::move(mActiveScene));
+	}
+
+	//Let the scheduler free the finished load task
+	mScheduler->Pump();
+	return Result;
+}
+
+void SceneManager::SwapInPendingScene()
+{
+	Clock::time_point Start = Clock::now();
+
+	if (mPendingSucceeded)
+	{
+		mPendingScene->OnActivateScene();
+
+		if (mActiveScene)
+		{
+			mActiveScene->OnCloseScene();
+			RetireScene(std::move(mActiveScene));
+		}
+		mActiveScene = std::move(mPendingScene);
+	}
+	else
+	{
+		//Failed - keep running the current scene
+		mPendingScene->OnCloseScene();
+		RetireScene(std::move(mPendingScene));
+	}
+
+	mCurrentTransition.bSucceeded = mPendingSucceeded;
+	mCurrentTransition.SwapFrame = mFrameIndex;
+	mCurrentTransition.SwapMilliseconds = ToMilliseconds(Clock::now() - Start);
+	mLastTransition = mCurrentTransition;
+}
+
+void SceneManager::RetireScene(std::unique_ptr<IScene> Scene)
+{
+	//Frames in flight may still reference the scene's resources
+	mReleaseQueue->Enqueue(&SceneManager::DestroyScene, this, reinterpret_cast<uintptr_t>(Scene.release()));
+}
+
+void SceneManager::DestroyScene(void* Context, uint64_t Payload)
+{
+	SceneManager* Manager = static_cast<SceneManager*>(Context);
+	IScene* Scene = reinterpret_cast<IScene*>(static_cast<uintptr_t>(Payload));
+
+	if (Manager->mJobs)
+	{
+		Manager->mJobs->Submit([Scene]() { delete Scene; }, &Manager->mDestroyCounter);
+	}
+	else
+	{
+		delete Scene;
+	}
+}
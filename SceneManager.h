@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "AsyncTask.h"
+
+#include "JobSystem.h"
+
+class CoroutineScheduler;
+class DeferredReleaseQueue;
+class IScene;
+
+struct SceneTransitionStats
+{
+	bool bSucceeded = false;
+	uint64_t RequestFrame = 0;
+	uint64_t SwapFrame = 0;
+	double LoadMilliseconds = 0.0;		//Request to loaded, while the old scene kept running
+	double SwapMilliseconds = 0.0;		//Main thread cost of the swap frame's activate/close
+};
+
+//Owns the active IScene and moves to the next without a loading stall.
+//
+//RequestScene() starts the new scene's OnInitScene coroutine while the
+//active scene carries on updating and rendering. Once it has finished the
+//swap happens at the start of the next Update(): the new scene's
+//OnActivateScene() and the old scene's OnCloseScene() are the only work done
+//for it in that frame. The old scene object is then handed to the deferred
+//release queue, so it is only destroyed once the GPU has finished the frames
+//that used it. Given a JobSystem the destructor itself runs on a worker, as
+//freeing a whole level can take milliseconds - scene destructors must then
+//not touch main thread state.
+//
+//Main thread only.
+class SceneManager
+{
+public:
+	SceneManager(CoroutineScheduler* Scheduler, DeferredReleaseQueue* ReleaseQueue, JobSystem* Jobs = nullptr);
+	~SceneManager();
+
+	//Starts loading Scene in the background. Returns false (and keeps the
+	//current scene) if another scene is still loading.
+	bool RequestScene(std::unique_ptr<IScene> Scene);
+
+	//Once a frame after the scheduler has been pumped - swaps in a loaded
+	//scene, then updates the active one.
+	void Update(float dt);
+	void Render();
+
+	//Waits for any load in flight (pumping the scheduler) and retires every
+	//scene through the release queue. The queue must be flushed afterwards,
+	//before the SceneManager is destroyed.
+	int Shutdown();
+
+	IScene* GetActiveScene() const { return mActiveScene.get(); }
+	bool IsLoading() const { return mPendingScene != nullptr; }
+	bool IsPendingSceneReady() const { return mPendingScene && mPendingLoaded; }
+	uint64_t GetFrameIndex() const { return mFrameIndex; }
+
+	//Of the last completed (or failed) transition.
+	const SceneTransitionStats& GetLastTransitionStats() const { return mLastTransition; }
+
+private:
+	AsyncTask<void> LoadScene(IScene* Scene);
+	void RetireScene(std::unique_ptr<IScene> Scene);
+	void SwapInPendingScene();
+
+	static void DestroyScene(void* Context, uint64_t Payload);
+
+private:
+	CoroutineScheduler* mScheduler;
+	DeferredReleaseQueue* mReleaseQueue;
+	JobSystem* mJobs;
+	JobCounter mDestroyCounter;
+
+	std::unique_ptr<IScene> mActiveScene;
+	std::unique_ptr<IScene> mPendingScene;
+	bool mPendingLoaded;
+	bool mPendingSucceeded;
+
+	uint64_t mFrameIndex;
+	SceneTransitionStats mCurrentTransition;
+	SceneTransitionStats mLastTransition;
+};
@@ -0,0 +1,319 @@
+#include "SceneTransitionSimulation.h"
+#include "AsyncAwaitables.h"
+#include "Common.h"
+#include "CoroutineScheduler.h"
+#include "DeferredReleaseQueue.h"
+#include "IScene.h"
+#include "JobSystem.h"
+#include "SimulatedFence.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <stdio.h>
+#include <thread>
+
+namespace
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	double MillisecondsSince(Clock::time_point Start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - Start).count();
+	}
+
+	struct SimulatedSceneObject
+	{
+		float Position[3];
+		float Yaw;
+		float Scale;
+	};
+
+	//Stands in for a real level: bulk data and objects generated on jobs, a
+	//GPU upload, then main thread registration (world matrices) in slices.
+	class SimulatedScene : public IScene
+	{
+	public:
+		SimulatedScene(uint32_t Seed, const SceneTransitionSimulationSettings& Settings, CoroutineScheduler* Scheduler,
+			JobSystem* Jobs, IFence* Fence)
+			: mSeed(Seed), mSettings(Settings), mScheduler(Scheduler), mJobs(Jobs), mFence(Fence),
+			mAnimationCursor(0)
+		{}
+
+		~SimulatedScene()
+		{}
+
+		AsyncTask<bool> OnInitScene() override
+		{
+			co_await RunJobAsync(*mJobs, *mScheduler, [this]() { Generate(); });
+
+			//Upload - pretend the copy was recorded and wait for the GPU to get to it
+			uint64_t UploadValue = mFence->Signal();
+			co_await WaitForFenceAsync(*mScheduler, *mFence, UploadValue);
+
+			const uint32_t BatchSize = 256;
+			Clock::time_point SliceStart = Clock::now();
+			for (uint32_t Begin = 0; Begin < mObjects.size(); Begin += BatchSize)
+			{
+				UpdateWorld(Begin, std::min(Begin + BatchSize, static_cast<uint32_t>(mObjects.size())));
+
+				if (MillisecondsSince(SliceStart) >= mSettings.RegistrationBudgetMs)
+				{
+					co_await YieldFrame(*mScheduler);
+					SliceStart = Clock::now();
+				}
+			}
+
+			co_return true;
+		}
+
+		int OnCloseScene() override
+		{
+			return 0;
+		}
+
+		void OnUpdate(float dt) override
+		{
+			//Steady per frame work so transitions have a baseline to stand out from
+			uint32_t Count = std::min(mSettings.AnimatedObjectsPerFrame, static_cast<uint32_t>(mObjects.size()));
+			for (uint32_t i = 0; i < Count; ++i)
+			{
+				uint32_t ObjectIdx = (mAnimationCursor + i) % mObjects.size();
+				mObjects[ObjectIdx].Yaw += dt;
+				UpdateWorld(ObjectIdx, ObjectIdx + 1);
+			}
+			mAnimationCursor = (mAnimationCursor + Count) % static_cast<uint32_t>(mObjects.size());
+		}
+
+		void OnRender() override
+		{}
+
+	private:
+		void Generate()
+		{
+			const uint32_t ChunkSize = 1024 * 1024;
+			uint32_t ChunkCount = static_cast<uint32_t>((mSettings.PayloadBytesPerScene + ChunkSize - 1) / ChunkSize);
+			mPayload.resize(mSettings.PayloadBytesPerScene);
+
+			mJobs->ParallelFor(ChunkCount, 1, [this, ChunkSize](uint32_t Begin, uint32_t End)
+			{
+				for (uint32_t Chunk = Begin; Chunk < End; ++Chunk)
+				{
+					uint64_t Offset = static_cast<uint64_t>(Chunk) * ChunkSize;
+					uint64_t Count = std::min<uint64_t>(ChunkSize, mPayload.size() - Offset);
+					uint32_t State = mSeed * 2654435761u + Chunk + 1;
+					for (uint64_t i = 0; i < Count; ++i)
+					{
+						State ^= State << 13;
+						State ^= State >> 17;
+						State ^= State << 5;
+						mPayload[Offset + i] = static_cast<uint8_t>(State);
+					}
+				}
+			});
+
+			mObjects.resize(mSettings.ObjectsPerScene);
+			uint32_t State = mSeed * 40503u + 7;
+			for (SimulatedSceneObject& Object : mObjects)
+			{
+				for (int Axis = 0; Axis < 3; ++Axis)
+				{
+					State ^= State << 13;
+					State ^= State >> 17;
+					State ^= State << 5;
+					Object.Position[Axis] = (State & 0xFFFF) * (1000.0f / 65535.0f);
+				}
+				Object.Yaw = (State >> 16) * (6.2831853f / 65535.0f);
+				Object.Scale = 1.0f;
+			}
+
+			mWorld.resize(mObjects.size() * 12);
+		}
+
+		void UpdateWorld(uint32_t Begin, uint32_t End)
+		{
+			for (uint32_t ObjectIdx = Begin; ObjectIdx < End; ++ObjectIdx)
+			{
+				const SimulatedSceneObject& Object = mObjects[ObjectIdx];
+				float Sin = std::sin(Object.Yaw) * Object.Scale;
+				float Cos = std::cos(Object.Yaw) * Object.Scale;
+				float* World = &mWorld[ObjectIdx * 12];
+				World[0] = Cos;   World[1] = 0.0f;         World[2] = Sin;   World[3] = Object.Position[0];
+				World[4] = 0.0f;  World[5] = Object.Scale; World[6] = 0.0f;  World[7] = Object.Position[1];
+				World[8] = -Sin;  World[9] = 0.0f;         World[10] = Cos;  World[11] = Object.Position[2];
+			}
+		}
+
+	private:
+		uint32_t mSeed;
+		const SceneTransitionSimulationSettings& mSettings;
+		CoroutineScheduler* mScheduler;
+		JobSystem* mJobs;
+		IFence* mFence;
+
+		std::vector<uint8_t> mPayload;
+		std::vector<SimulatedSceneObject> mObjects;
+		std::vector<float> mWorld;		//3x4 row major per object
+		uint32_t mAnimationCursor;
+	};
+}
+
+SceneTransitionSimulation::SceneTransitionSimulation(const SceneTransitionSimulationSettings& Settings)
+	: mSettings(Settings)
+{
+	Assert(mSettings.ObjectsPerScene > 0 && mSettings.FramesPerScene > 0);
+}
+
+SceneTransitionSimulation::~SceneTransitionSimulation()
+{}
+
+void SceneTransitionSimulation::Run()
+{
+	mSummaries.clear();
+	mSummaries.push_back(RunMode("Async", false));
+	mSummaries.push_back(RunMode("Blocking", true));
+}
+
+SceneTransitionRunSummary SceneTransitionSimulation::RunMode(const char* Mode, bool bBlockingLoads)
+{
+	JobSystem Jobs(mSettings.ThreadCount);
+	CoroutineScheduler Scheduler;
+	SimulatedFence Fence;
+	DeferredReleaseQueue ReleaseQueue(&Fence);
+	SceneManager Scenes(&Scheduler, &ReleaseQueue, &Jobs);
+
+	SceneTransitionRunSummary Summary;
+	Summary.Mode = Mode;
+
+	//First scene isn't part of the measurement
+	Scenes.RequestScene(std::unique_ptr<IScene>(new SimulatedScene(0, mSettings, &Scheduler, &Jobs, &Fence)));
+	while (!Scenes.IsPendingSceneReady())
+	{
+		Fence.AdvanceTo(Fence.GetLastSignalledValue());
+		if (Scheduler.Pump() == 0)
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	uint32_t FrameCount = mSettings.FramesPerScene * (mSettings.TransitionCount + 1);
+	std::vector<double> FrameMs;
+	FrameMs.reserve(FrameCount);
+
+	float Delta = static_cast<float>(mSettings.FrameMilliseconds / 1000.0);
+	std::chrono::duration<double, std::milli> FrameDuration(mSettings.FrameMilliseconds);
+	Clock::time_point NextFrame = Clock::now();
+	bool bTransitionPending = false;
+
+	for (uint32_t Frame = 0; Frame < FrameCount; ++Frame)
+	{
+		Clock::time_point FrameStart = Clock::now();
+
+		if (Frame > 0 && Frame % mSettings.FramesPerScene == 0)
+		{
+			uint32_t Seed = Frame / mSettings.FramesPerScene;
+			Assert(Scenes.RequestScene(std::unique_ptr<IScene>(new SimulatedScene(Seed, mSettings, &Scheduler, &Jobs, &Fence))));
+			bTransitionPending = true;
+
+			//Level load screen behaviour - nothing else happens until it's in,
+			//and the GPU goes idle
+			while (bBlockingLoads && !Scenes.IsPendingSceneReady())
+			{
+				Fence.AdvanceTo(Fence.GetLastSignalledValue());
+				if (Scheduler.Pump() == 0)
+				{
+					std::this_thread::yield();
+				}
+			}
+		}
+
+		Scheduler.Pump();
+		Scenes.Update(Delta);
+		Scenes.Render();
+
+		//Simulated GPU FramesInFlight behind
+		uint64_t Signalled = Fence.Signal();
+		Fence.AdvanceTo(Signalled > mSettings.FramesInFlight ? Signalled - mSettings.FramesInFlight : 0);
+		ReleaseQueue.Drain();
+
+		FrameMs.push_back(MillisecondsSince(FrameStart));
+
+		if (bTransitionPending && !Scenes.IsLoading())
+		{
+			SceneTransitionRecord Record;
+			Record.Stats = Scenes.GetLastTransitionStats();
+			Summary.Transitions.push_back(Record);
+			bTransitionPending = false;
+		}
+
+		NextFrame += std::chrono::duration_cast<Clock::duration>(FrameDuration);
+		std::this_thread::sleep_until(NextFrame);
+	}
+
+	Scenes.Shutdown();
+	ReleaseQueue.Flush();
+	Summary.ScenesReleased = ReleaseQueue.GetTotalReleased();
+
+	//Old scene is destroyed once the GPU is past its last frame
+	for (SceneTransitionRecord& Record : Summary.Transitions)
+	{
+		uint64_t End = std::min<uint64_t>(Record.Stats.SwapFrame + mSettings.FramesInFlight + 2, FrameMs.size());
+		for (uint64_t Frame = Record.Stats.RequestFrame; Frame < End; ++Frame)
+		{
+			Record.MaxFrameMs = std::max(Record.MaxFrameMs, FrameMs[Frame]);
+		}
+	}
+
+	Summary.FrameCount = static_cast<uint32_t>(FrameMs.size());
+	double Total = 0.0;
+	for (double Ms : FrameMs)
+	{
+		Total += Ms;
+		Summary.HitchFrameCount += Ms > mSettings.HitchThresholdMs ? 1 : 0;
+	}
+	Summary.AverageFrameMs = Total / FrameMs.size();
+
+	std::sort(FrameMs.begin(), FrameMs.end());
+	Summary.MaxFrameMs = FrameMs.back();
+	Summary.P99FrameMs = FrameMs[std::min(FrameMs.size() - 1, static_cast<size_t>(FrameMs.size() * 0.99))];
+
+	return Summary;
+}
+
+bool SceneTransitionSimulation::WriteReport(const char* Filename) const
+{
+	FILE* File = fopen(Filename, "w");
+	if (!File)
+	{
+		return false;
+	}
+
+	fprintf(File, "%u transitions, %u frames per scene, %u objects and %.1f MB per scene\n",
+		mSettings.TransitionCount, mSettings.FramesPerScene, mSettings.ObjectsPerScene,
+		mSettings.PayloadBytesPerScene / (1024.0 * 1024.0));
+	fprintf(File, "Frame %.2f ms, hitch threshold %.2f ms, registration budget %.2f ms, %u frames in flight\n\n",
+		mSettings.FrameMilliseconds, mSettings.HitchThresholdMs, mSettings.RegistrationBudgetMs, mSettings.FramesInFlight);
+
+	for (const SceneTransitionRunSummary& Summary : mSummaries)
+	{
+		fprintf(File, "%s\n", Summary.Mode.c_str());
+		fprintf(File, "  Frames:          %u\n", Summary.FrameCount);
+		fprintf(File, "  Hitch frames:    %u\n", Summary.HitchFrameCount);
+		fprintf(File, "  Frame ms:        avg %.3f, p99 %.3f, max %.3f\n",
+			Summary.AverageFrameMs, Summary.P99FrameMs, Summary.MaxFrameMs);
+		fprintf(File, "  Scenes released: %llu\n", (unsigned long long)Summary.ScenesReleased);
+
+		for (const SceneTransitionRecord& Record : Summary.Transitions)
+		{
+			const SceneTransitionStats& Stats = Record.Stats;
+			fprintf(File, "  Frame %5llu -> %5llu (%3llu frames): load %8.2f ms, swap %.3f ms, worst frame %.3f ms%s\n",
+				(unsigned long long)Stats.RequestFrame, (unsigned long long)Stats.SwapFrame,
+				(unsigned long long)(Stats.SwapFrame - Stats.RequestFrame), Stats.LoadMilliseconds,
+				Stats.SwapMilliseconds, Record.MaxFrameMs, Stats.bSucceeded ? "" : " FAILED");
+		}
+		fprintf(File, "\n");
+	}
+
+	fclose(File);
+	return true;
+}
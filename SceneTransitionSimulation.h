@@ -0,0 +1,69 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "SceneManager.h"
+
+//Headless scene transition run: a chain of generated scenes is loaded through
+//a SceneManager while the previous one keeps running, with frames paced in
+//real time and a simulated GPU running FramesInFlight behind. The main thread
+//cost of every frame is recorded, and for each transition the worst frame
+//between the request and the old scene being destroyed is the transition
+//hitch.
+//
+//Each scene generates PayloadBytesPerScene and its objects on jobs, waits for
+//a simulated upload, then registers objects on the main thread in
+//RegistrationBudgetMs slices; old scenes are destroyed on a worker. The run
+//is repeated with the main thread blocking on each load to show what the
+//background load buys.
+struct SceneTransitionSimulationSettings
+{
+	uint32_t TransitionCount = 4;
+	uint32_t FramesPerScene = 180;
+	uint32_t ObjectsPerScene = 100000;
+	uint64_t PayloadBytesPerScene = 48ull * 1024ull * 1024ull;
+	uint32_t AnimatedObjectsPerFrame = 4096;
+	double RegistrationBudgetMs = 1.0;
+	uint32_t FramesInFlight = 2;
+
+	double FrameMilliseconds = 1000.0 / 60.0;
+	double HitchThresholdMs = 4.0;
+	uint32_t ThreadCount = 0;
+};
+
+struct SceneTransitionRecord
+{
+	SceneTransitionStats Stats;
+	double MaxFrameMs = 0.0;	//Request frame to old scene destroyed
+};
+
+struct SceneTransitionRunSummary
+{
+	std::string Mode;
+	uint32_t FrameCount = 0;
+	uint32_t HitchFrameCount = 0;
+	double AverageFrameMs = 0.0;
+	double P99FrameMs = 0.0;
+	double MaxFrameMs = 0.0;
+	uint64_t ScenesReleased = 0;
+	std::vector<SceneTransitionRecord> Transitions;
+};
+
+class SceneTransitionSimulation
+{
+public:
+	SceneTransitionSimulation(const SceneTransitionSimulationSettings& Settings);
+	~SceneTransitionSimulation();
+
+	void Run();
+
+	bool WriteReport(const char* Filename) const;
+
+private:
+	SceneTransitionRunSummary RunMode(const char* Mode, bool bBlockingLoads);
+
+private:
+	SceneTransitionSimulationSettings mSettings;
+	std::vector<SceneTransitionRunSummary> mSummaries;
+};
@@ -0,0 +1,388 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+//Lane types for structure of arrays math. SimdFloat1, SimdFloat4 and
+//SimdFloat8 hold 1, 4 and 8 floats and have the same interface, so batch code
+//is written once as a template over the lane type:
+//	SimdFloat4	- SSE2 on x86/x64, NEON on ARM64, otherwise scalar
+//	SimdFloat8	- AVX2 when the compiler targets it (/arch:AVX2, -mavx2),
+//				  otherwise a pair of SimdFloat4
+//
+//Comparisons return masks (all bits set in true lanes) for And/Or/Select and
+//GetMaskBits, which packs lane N in to bit N. Load/Store need Width * 4 byte
+//alignment, the Unaligned versions don't.
+//
+//Define SIMD_FLOAT_SCALAR to force the scalar backend.
+
+#if !defined(SIMD_FLOAT_SCALAR) && (defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__))
+#define SIMD_FLOAT_SSE 1
+#include <emmintrin.h>
+#if defined(__AVX2__)
+#define SIMD_FLOAT_AVX2 1
+#include <immintrin.h>
+#endif
+#elif !defined(SIMD_FLOAT_SCALAR) && (defined(__aarch64__) || defined(_M_ARM64))
+#define SIMD_FLOAT_NEON 1
+#include <arm_neon.h>
+#endif
+
+inline const char* GetSimdBackendName()
+{
+#if defined(SIMD_FLOAT_AVX2)
+	return "AVX2";
+#elif defined(SIMD_FLOAT_SSE)
+	return "SSE2";
+#elif defined(SIMD_FLOAT_NEON)
+	return "NEON";
+#else
+	return "Scalar";
+#endif
+}
+
+class SimdFloat1
+{
+public:
+	static const uint32_t Width = 1;
+
+	SimdFloat1() {}
+	explicit SimdFloat1(float Value) : mValue(Value) {}
+
+	static SimdFloat1 Splat(float Value) { return SimdFloat1(Value); }
+	static SimdFloat1 Load(const float* Values) { return SimdFloat1(*Values); }
+	static SimdFloat1 LoadUnaligned(const float* Values) { return SimdFloat1(*Values); }
+	void Store(float* Values) const { *Values = mValue; }
+	void StoreUnaligned(float* Values) const { *Values = mValue; }
+
+	float GetLane(uint32_t) const { return mValue; }
+
+	friend SimdFloat1 operator+(SimdFloat1 A, SimdFloat1 B) { return SimdFloat1(A.mValue + B.mValue); }
+	friend SimdFloat1 operator-(SimdFloat1 A, SimdFloat1 B) { return SimdFloat1(A.mValue - B.mValue); }
+	friend SimdFloat1 operator*(SimdFloat1 A, SimdFloat1 B) { return SimdFloat1(A.mValue * B.mValue); }
+	friend SimdFloat1 operator/(SimdFloat1 A, SimdFloat1 B) { return SimdFloat1(A.mValue / B.mValue); }
+	friend SimdFloat1 operator-(SimdFloat1 A) { return SimdFloat1(-A.mValue); }
+
+	friend SimdFloat1 Min(SimdFloat1 A, SimdFloat1 B) { return SimdFloat1(B.mValue < A.mValue ? B.mValue : A.mValue); }
+	friend SimdFloat1 Max(SimdFloat1 A, SimdFloat1 B) { return SimdFloat1(A.mValue < B.mValue ? B.mValue : A.mValue); }
+	friend SimdFloat1 Abs(SimdFloat1 A) { return SimdFloat1(fabsf(A.mValue)); }
+	friend SimdFloat1 Sqrt(SimdFloat1 A) { return SimdFloat1(sqrtf(A.mValue)); }
+	friend SimdFloat1 MultiplyAdd(SimdFloat1 A, SimdFloat1 B, SimdFloat1 C) { return SimdFloat1(A.mValue * B.mValue + C.mValue); }
+
+	friend SimdFloat1 CompareLess(SimdFloat1 A, SimdFloat1 B) { return FromBits(A.mValue < B.mValue ? 0xFFFFFFFF : 0); }
+	friend SimdFloat1 CompareLessEqual(SimdFloat1 A, SimdFloat1 B) { return FromBits(A.mValue <= B.mValue ? 0xFFFFFFFF : 0); }
+	friend SimdFloat1 CompareGreater(SimdFloat1 A, SimdFloat1 B) { return FromBits(A.mValue > B.mValue ? 0xFFFFFFFF : 0); }
+	friend SimdFloat1 CompareGreaterEqual(SimdFloat1 A, SimdFloat1 B) { return FromBits(A.mValue >= B.mValue ? 0xFFFFFFFF : 0); }
+
+	friend SimdFloat1 And(SimdFloat1 A, SimdFloat1 B) { return FromBits(A.GetBits() & B.GetBits()); }
+	friend SimdFloat1 Or(SimdFloat1 A, SimdFloat1 B) { return FromBits(A.GetBits() | B.GetBits()); }
+	friend SimdFloat1 AndNot(SimdFloat1 A, SimdFloat1 B) { return FromBits(A.GetBits() & ~B.GetBits()); }
+	friend SimdFloat1 Select(SimdFloat1 Mask, SimdFloat1 IfTrue, SimdFloat1 IfFalse)
+	{
+		return FromBits((Mask.GetBits() & IfTrue.GetBits()) | (~Mask.GetBits() & IfFalse.GetBits()));
+	}
+	friend uint32_t GetMaskBits(SimdFloat1 Mask) { return Mask.GetBits() >> 31; }
+
+private:
+	static SimdFloat1 FromBits(uint32_t Bits)
+	{
+		SimdFloat1 Result;
+		memcpy(&Result.mValue, &Bits, sizeof(Bits));
+		return Result;
+	}
+
+	uint32_t GetBits() const
+	{
+		uint32_t Bits;
+		memcpy(&Bits, &mValue, sizeof(Bits));
+		return Bits;
+	}
+
+private:
+	float mValue;
+};
+
+//Twice the width of Half, one operation on each half. The fallback wherever
+//there's no native type.
+template<typename Half>
+class SimdFloatPair
+{
+public:
+	static const uint32_t Width = Half::Width * 2;
+
+	SimdFloatPair() {}
+	SimdFloatPair(Half Low, Half High) : mLow(Low), mHigh(High) {}
+
+	static SimdFloatPair Splat(float Value) { return SimdFloatPair(Half::Splat(Value), Half::Splat(Value)); }
+	static SimdFloatPair Load(const float* Values) { return SimdFloatPair(Half::Load(Values), Half::Load(Values + Half::Width)); }
+	static SimdFloatPair LoadUnaligned(const float* Values)
+	{
+		return SimdFloatPair(Half::LoadUnaligned(Values), Half::LoadUnaligned(Values + Half::Width));
+	}
+	void Store(float* Values) const { mLow.Store(Values); mHigh.Store(Values + Half::Width); }
+	void StoreUnaligned(float* Values) const { mLow.StoreUnaligned(Values); mHigh.StoreUnaligned(Values + Half::Width); }
+
+	float GetLane(uint32_t Lane) const { return Lane < Half::Width ? mLow.GetLane(Lane) : mHigh.GetLane(Lane - Half::Width); }
+
+	friend SimdFloatPair operator+(SimdFloatPair A, SimdFloatPair B) { return SimdFloatPair(A.mLow + B.mLow, A.mHigh + B.mHigh); }
+	friend SimdFloatPair operator-(SimdFloatPair A, SimdFloatPair B) { return SimdFloatPair(A.mLow - B.mLow, A.mHigh - B.mHigh); }
+	friend SimdFloatPair operator*(SimdFloatPair A, SimdFloatPair B) { return SimdFloatPair(A.mLow * B.mLow, A.mHigh * B.mHigh); }
+	friend SimdFloatPair operator/(SimdFloatPair A, SimdFloatPair B) { return SimdFloatPair(A.mLow / B.mLow, A.mHigh / B.mHigh); }
+	friend SimdFloatPair operator-(SimdFloatPair A) { return SimdFloatPair(-A.mLow, -A.mHigh); }
+
+	friend SimdFloatPair Min(SimdFloatPair A, SimdFloatPair B) { return SimdFloatPair(Min(A.mLow, B.mLow), Min(A.mHigh, B.mHigh)); }
+	friend SimdFloatPair Max(SimdFloatPair A, SimdFloatPair B) { return SimdFloatPair(Max(A.mLow, B.mLow), Max(A.mHigh, B.mHigh)); }
+	friend SimdFloatPair Abs(SimdFloatPair A) { return SimdFloatPair(Abs(A.mLow), Abs(A.mHigh)); }
+	friend SimdFloatPair Sqrt(SimdFloatPair A) { return SimdFloatPair(Sqrt(A.mLow), Sqrt(A.mHigh)); }
+	friend SimdFloatPair MultiplyAdd(SimdFloatPair A, SimdFloatPair B, SimdFloatPair C)
+	{
+		return SimdFloatPair(MultiplyAdd(A.mLow, B.mLow, C.mLow), MultiplyAdd(A.mHigh, B.mHigh, C.mHigh));
+	}
+
+	friend SimdFloatPair CompareLess(SimdFloatPair A, SimdFloatPair B)
+	{
+		return SimdFloatPair(CompareLess(A.mLow, B.mLow), CompareLess(A.mHigh, B.mHigh));
+	}
+	friend SimdFloatPair CompareLessEqual(SimdFloatPair A, SimdFloatPair B)
+	{
+		return SimdFloatPair(CompareLessEqual(A.mLow, B.mLow), CompareLessEqual(A.mHigh, B.mHigh));
+	}
+	friend SimdFloatPair CompareGreater(SimdFloatPair A, SimdFloatPair B)
+	{
+		return SimdFloatPair(CompareGreater(A.mLow, B.mLow), CompareGreater(A.mHigh, B.mHigh));
+	}
+	friend SimdFloatPair CompareGreaterEqual(SimdFloatPair A, SimdFloatPair B)
+	{
+		return SimdFloatPair(CompareGreaterEqual(A.mLow, B.mLow), CompareGreaterEqual(A.mHigh, B.mHigh));
+	}
+
+	friend SimdFloatPair And(SimdFloatPair A, SimdFloatPair B) { return SimdFloatPair(And(A.mLow, B.mLow), And(A.mHigh, B.mHigh)); }
+	friend SimdFloatPair Or(SimdFloatPair A, SimdFloatPair B) { return SimdFloatPair(Or(A.mLow, B.mLow), Or(A.mHigh, B.mHigh)); }
+	friend SimdFloatPair AndNot(SimdFloatPair A, SimdFloatPair B) { return SimdFloatPair(AndNot(A.mLow, B.mLow), AndNot(A.mHigh, B.mHigh)); }
+	friend SimdFloatPair Select(SimdFloatPair Mask, SimdFloatPair IfTrue, SimdFloatPair IfFalse)
+	{
+		return SimdFloatPair(Select(Mask.mLow, IfTrue.mLow, IfFalse.mLow), Select(Mask.mHigh, IfTrue.mHigh, IfFalse.mHigh));
+	}
+	friend uint32_t GetMaskBits(SimdFloatPair Mask) { return GetMaskBits(Mask.mLow) | (GetMaskBits(Mask.mHigh) << Half::Width); }
+
+private:
+	Half mLow;
+	Half mHigh;
+};
+
+#if defined(SIMD_FLOAT_SSE)
+
+class SimdFloat4
+{
+public:
+	static const uint32_t Width = 4;
+
+	SimdFloat4() {}
+	explicit SimdFloat4(__m128 Value) : mValue(Value) {}
+
+	static SimdFloat4 Splat(float Value) { return SimdFloat4(_mm_set1_ps(Value)); }
+	static SimdFloat4 Load(const float* Values) { return SimdFloat4(_mm_load_ps(Values)); }
+	static SimdFloat4 LoadUnaligned(const float* Values) { return SimdFloat4(_mm_loadu_ps(Values)); }
+	void Store(float* Values) const { _mm_store_ps(Values, mValue); }
+	void StoreUnaligned(float* Values) const { _mm_storeu_ps(Values, mValue); }
+
+	float GetLane(uint32_t Lane) const
+	{
+		alignas(16) float Values[4];
+		Store(Values);
+		return Values[Lane];
+	}
+
+	__m128 GetNative() const { return mValue; }
+
+	friend SimdFloat4 operator+(SimdFloat4 A, SimdFloat4 B) { return SimdFloat4(_mm_add_ps(A.mValue, B.mValue)); }
+	friend SimdFloat4 operator-(SimdFloat4 A, SimdFloat4 B) { return SimdFloat4(_mm_sub_ps(A.mValue, B.mValue)); }
+	friend SimdFloat4 operator*(SimdFloat4 A, SimdFloat4 B) { return SimdFloat4(_mm_mul_ps(A.mValue, B.mValue)); }
+	friend SimdFloat4 operator/(SimdFloat4 A, SimdFloat4 B) { return SimdFloat4(_mm_div_ps(A.mValue, B.mValue)); }
+	friend SimdFloat4 operator-(SimdFloat4 A) { return SimdFloat4(_mm_xor_ps(A.mValue, _mm_set1_ps(-0.0f))); }
+
+	friend SimdFloat4 Min(SimdFloat4 A, SimdFloat4 B) { return SimdFloat4(_mm_min_ps(A.mValue, B.mValue)); }
+	friend SimdFloat4 Max(SimdFloat4 A, SimdFloat4 B) { return SimdFloat4(_mm_max_ps(A.mValue, B.mValue)); }
+	friend SimdFloat4 Abs(SimdFloat4 A) { return SimdFloat4(_mm_andnot_ps(_mm_set1_ps(-0.0f), A.mValue)); }
+	friend SimdFloat4 Sqrt(SimdFloat4 A) { return SimdFloat4(_mm_sqrt_ps(A.mValue)); }
+	friend SimdFloat4 MultiplyAdd(SimdFloat4 A, SimdFloat4 B, SimdFloat4 C)
+	{
+#if defined(__FMA__)
+		return SimdFloat4(_mm_fmadd_ps(A.mValue, B.mValue, C.mValue));
+#else
+		return SimdFloat4(_mm_add_ps(_mm_mul_ps(A.mValue, B.mValue), C.mValue));
+#endif
+	}
+
+	friend SimdFloat4 CompareLess(SimdFloat4 A, SimdFloat4 B) { return SimdFloat4(_mm_cmplt_ps(A.mValue, B.mValue)); }
+	friend SimdFloat4 CompareLessEqual(SimdFloat4 A, SimdFloat4 B) { return SimdFloat4(_mm_cmple_ps(A.mValue, B.mValue)); }
+	friend SimdFloat4 CompareGreater(SimdFloat4 A, SimdFloat4 B) { return SimdFloat4(_mm_cmpgt_ps(A.mValue, B.mValue)); }
+	friend SimdFloat4 CompareGreaterEqual(SimdFloat4 A, SimdFloat4 B) { return SimdFloat4(_mm_cmpge_ps(A.mValue, B.mValue)); }
+
+	friend SimdFloat4 And(SimdFloat4 A, SimdFloat4 B) { return SimdFloat4(_mm_and_ps(A.mValue, B.mValue)); }
+	friend SimdFloat4 Or(SimdFloat4 A, SimdFloat4 B) { return SimdFloat4(_mm_or_ps(A.mValue, B.mValue)); }
+	friend SimdFloat4 AndNot(SimdFloat4 A, SimdFloat4 B) { return SimdFloat4(_mm_andnot_ps(B.mValue, A.mValue)); }
+	friend SimdFloat4 Select(SimdFloat4 Mask, SimdFloat4 IfTrue, SimdFloat4 IfFalse)
+	{
+		return SimdFloat4(_mm_or_ps(_mm_and_ps(Mask.mValue, IfTrue.mValue), _mm_andnot_ps(Mask.mValue, IfFalse.mValue)));
+	}
+	friend uint32_t GetMaskBits(SimdFloat4 Mask) { return static_cast<uint32_t>(_mm_movemask_ps(Mask.mValue)); }
+
+	//Row N of the four 4x4 matrices in A, B, C, D becomes lane N of each
+	friend void Transpose(SimdFloat4& A, SimdFloat4& B, SimdFloat4& C, SimdFloat4& D)
+	{
+		_MM_TRANSPOSE4_PS(A.mValue, B.mValue, C.mValue, D.mValue);
+	}
+
+private:
+	__m128 mValue;
+};
+
+#elif defined(SIMD_FLOAT_NEON)
+
+class SimdFloat4
+{
+public:
+	static const uint32_t Width = 4;
+
+	SimdFloat4() {}
+	explicit SimdFloat4(float32x4_t Value) : mValue(Value) {}
+
+	static SimdFloat4 Splat(float Value) { return SimdFloat4(vdupq_n_f32(Value)); }
+	static SimdFloat4 Load(const float* Values) { return SimdFloat4(vld1q_f32(Values)); }
+	static SimdFloat4 LoadUnaligned(const float* Values) { return SimdFloat4(vld1q_f32(Values)); }
+	void Store(float* Values) const { vst1q_f32(Values, mValue); }
+	void StoreUnaligned(float* Values) const { vst1q_f32(Values, mValue); }
+
+	float GetLane(uint32_t Lane) const
+	{
+		alignas(16) float Values[4];
+		Store(Values);
+		return Values[Lane];
+	}
+
+	float32x4_t GetNative() const { return mValue; }
+
+	friend SimdFloat4 operator+(SimdFloat4 A, SimdFloat4 B) { return SimdFloat4(vaddq_f32(A.mValue, B.mValue)); }
+	friend SimdFloat4 operator-(SimdFloat4 A, SimdFloat4 B) { return SimdFloat4(vsubq_f32(A.mValue, B.mValue)); }
+	friend SimdFloat4 operator*(SimdFloat4 A, SimdFloat4 B) { return SimdFloat4(vmulq_f32(A.mValue, B.mValue)); }
+	friend SimdFloat4 operator/(SimdFloat4 A, SimdFloat4 B) { return SimdFloat4(vdivq_f32(A.mValue, B.mValue)); }
+	friend SimdFloat4 operator-(SimdFloat4 A) { return SimdFloat4(vnegq_f32(A.mValue)); }
+
+	friend SimdFloat4 Min(SimdFloat4 A, SimdFloat4 B) { return SimdFloat4(vminq_f32(A.mValue, B.mValue)); }
+	friend SimdFloat4 Max(SimdFloat4 A, SimdFloat4 B) { return SimdFloat4(vmaxq_f32(A.mValue, B.mValue)); }
+	friend SimdFloat4 Abs(SimdFloat4 A) { return SimdFloat4(vabsq_f32(A.mValue)); }
+	friend SimdFloat4 Sqrt(SimdFloat4 A) { return SimdFloat4(vsqrtq_f32(A.mValue)); }
+	friend SimdFloat4 MultiplyAdd(SimdFloat4 A, SimdFloat4 B, SimdFloat4 C) { return SimdFloat4(vfmaq_f32(C.mValue, A.mValue, B.mValue)); }
+
+	friend SimdFloat4 CompareLess(SimdFloat4 A, SimdFloat4 B) { return FromMask(vcltq_f32(A.mValue, B.mValue)); }
+	friend SimdFloat4 CompareLessEqual(SimdFloat4 A, SimdFloat4 B) { return FromMask(vcleq_f32(A.mValue, B.mValue)); }
+	friend SimdFloat4 CompareGreater(SimdFloat4 A, SimdFloat4 B) { return FromMask(vcgtq_f32(A.mValue, B.mValue)); }
+	friend SimdFloat4 CompareGreaterEqual(SimdFloat4 A, SimdFloat4 B) { return FromMask(vcgeq_f32(A.mValue, B.mValue)); }
+
+	friend SimdFloat4 And(SimdFloat4 A, SimdFloat4 B) { return FromMask(vandq_u32(A.GetMask(), B.GetMask())); }
+	friend SimdFloat4 Or(SimdFloat4 A, SimdFloat4 B) { return FromMask(vorrq_u32(A.GetMask(), B.GetMask())); }
+	friend SimdFloat4 AndNot(SimdFloat4 A, SimdFloat4 B) { return FromMask(vbicq_u32(A.GetMask(), B.GetMask())); }
+	friend SimdFloat4 Select(SimdFloat4 Mask, SimdFloat4 IfTrue, SimdFloat4 IfFalse)
+	{
+		return SimdFloat4(vbslq_f32(Mask.GetMask(), IfTrue.mValue, IfFalse.mValue));
+	}
+	friend uint32_t GetMaskBits(SimdFloat4 Mask)
+	{
+		static const int32_t Shifts[4] = { 0, 1, 2, 3 };
+		uint32x4_t Bits = vshlq_u32(vshrq_n_u32(Mask.GetMask(), 31), vld1q_s32(Shifts));
+		return vaddvq_u32(Bits);
+	}
+
+	friend void Transpose(SimdFloat4& A, SimdFloat4& B, SimdFloat4& C, SimdFloat4& D)
+	{
+		float32x4x2_t AB = vtrnq_f32(A.mValue, B.mValue);
+		float32x4x2_t CD = vtrnq_f32(C.mValue, D.mValue);
+		A.mValue = vcombine_f32(vget_low_f32(AB.val[0]), vget_low_f32(CD.val[0]));
+		B.mValue = vcombine_f32(vget_low_f32(AB.val[1]), vget_low_f32(CD.val[1]));
+		C.mValue = vcombine_f32(vget_high_f32(AB.val[0]), vget_high_f32(CD.val[0]));
+		D.mValue = vcombine_f32(vget_high_f32(AB.val[1]), vget_high_f32(CD.val[1]));
+	}
+
+private:
+	static SimdFloat4 FromMask(uint32x4_t Mask) { return SimdFloat4(vreinterpretq_f32_u32(Mask)); }
+	uint32x4_t GetMask() const { return vreinterpretq_u32_f32(mValue); }
+
+private:
+	float32x4_t mValue;
+};
+
+#else
+
+typedef SimdFloatPair<SimdFloatPair<SimdFloat1>> SimdFloat4;
+
+#endif
+
+#if defined(SIMD_FLOAT_AVX2)
+
+class SimdFloat8
+{
+public:
+	static const uint32_t Width = 8;
+
+	SimdFloat8() {}
+	explicit SimdFloat8(__m256 Value) : mValue(Value) {}
+
+	static SimdFloat8 Splat(float Value) { return SimdFloat8(_mm256_set1_ps(Value)); }
+	static SimdFloat8 Load(const float* Values) { return SimdFloat8(_mm256_load_ps(Values)); }
+	static SimdFloat8 LoadUnaligned(const float* Values) { return SimdFloat8(_mm256_loadu_ps(Values)); }
+	void Store(float* Values) const { _mm256_store_ps(Values, mValue); }
+	void StoreUnaligned(float* Values) const { _mm256_storeu_ps(Values, mValue); }
+
+	float GetLane(uint32_t Lane) const
+	{
+		alignas(32) float Values[8];
+		Store(Values);
+		return Values[Lane];
+	}
+
+	__m256 GetNative() const { return mValue; }
+
+	friend SimdFloat8 operator+(SimdFloat8 A, SimdFloat8 B) { return SimdFloat8(_mm256_add_ps(A.mValue, B.mValue)); }
+	friend SimdFloat8 operator-(SimdFloat8 A, SimdFloat8 B) { return SimdFloat8(_mm256_sub_ps(A.mValue, B.mValue)); }
+	friend SimdFloat8 operator*(SimdFloat8 A, SimdFloat8 B) { return SimdFloat8(_mm256_mul_ps(A.mValue, B.mValue)); }
+	friend SimdFloat8 operator/(SimdFloat8 A, SimdFloat8 B) { return SimdFloat8(_mm256_div_ps(A.mValue, B.mValue)); }
+	friend SimdFloat8 operator-(SimdFloat8 A) { return SimdFloat8(_mm256_xor_ps(A.mValue, _mm256_set1_ps(-0.0f))); }
+
+	friend SimdFloat8 Min(SimdFloat8 A, SimdFloat8 B) { return SimdFloat8(_mm256_min_ps(A.mValue, B.mValue)); }
+	friend SimdFloat8 Max(SimdFloat8 A, SimdFloat8 B) { return SimdFloat8(_mm256_max_ps(A.mValue, B.mValue)); }
+	friend SimdFloat8 Abs(SimdFloat8 A) { return SimdFloat8(_mm256_andnot_ps(_mm256_set1_ps(-0.0f), A.mValue)); }
+	friend SimdFloat8 Sqrt(SimdFloat8 A) { return SimdFloat8(_mm256_sqrt_ps(A.mValue)); }
+	friend SimdFloat8 MultiplyAdd(SimdFloat8 A, SimdFloat8 B, SimdFloat8 C)
+	{
+#if defined(__FMA__)
+		return SimdFloat8(_mm256_fmadd_ps(A.mValue, B.mValue, C.mValue));
+#else
+		return SimdFloat8(_mm256_add_ps(_mm256_mul_ps(A.mValue, B.mValue), C.mValue));
+#endif
+	}
+
+	friend SimdFloat8 CompareLess(SimdFloat8 A, SimdFloat8 B) { return SimdFloat8(_mm256_cmp_ps(A.mValue, B.mValue, _CMP_LT_OQ)); }
+	friend SimdFloat8 CompareLessEqual(SimdFloat8 A, SimdFloat8 B) { return SimdFloat8(_mm256_cmp_ps(A.mValue, B.mValue, _CMP_LE_OQ)); }
+	friend SimdFloat8 CompareGreater(SimdFloat8 A, SimdFloat8 B) { return SimdFloat8(_mm256_cmp_ps(A.mValue, B.mValue, _CMP_GT_OQ)); }
+	friend SimdFloat8 CompareGreaterEqual(SimdFloat8 A, SimdFloat8 B) { return SimdFloat8(_mm256_cmp_ps(A.mValue, B.mValue, _CMP_GE_OQ)); }
+
+	friend SimdFloat8 And(SimdFloat8 A, SimdFloat8 B) { return SimdFloat8(_mm256_and_ps(A.mValue, B.mValue)); }
+	friend SimdFloat8 Or(SimdFloat8 A, SimdFloat8 B) { return SimdFloat8(_mm256_or_ps(A.mValue, B.mValue)); }
+	friend SimdFloat8 AndNot(SimdFloat8 A, SimdFloat8 B) { return SimdFloat8(_mm256_andnot_ps(B.mValue, A.mValue)); }
+	friend SimdFloat8 Select(SimdFloat8 Mask, SimdFloat8 IfTrue, SimdFloat8 IfFalse)
+	{
+		return SimdFloat8(_mm256_blendv_ps(IfFalse.mValue, IfTrue.mValue, Mask.mValue));
+	}
+	friend uint32_t GetMaskBits(SimdFloat8 Mask) { return static_cast<uint32_t>(_mm256_movemask_ps(Mask.mValue)); }
+
+private:
+	__m256 mValue;
+};
+
+#else
+
+typedef SimdFloatPair<SimdFloat4> SimdFloat8;
+
+#endif
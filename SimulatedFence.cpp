@@ -0,0 +1,39 @@
+#include "SimulatedFence.h"
+#include "Common.h"
+
+SimulatedFence::SimulatedFence()
+	: mLastSignalledValue(0), mCompletedValue(0), mStallCount(0), mStalledSignals(0)
+{}
+
+SimulatedFence::~SimulatedFence()
+{}
+
+uint64_t SimulatedFence::Signal()
+{
+	return ++mLastSignalledValue;
+}
+
+void SimulatedFence::WaitForValue(uint64_t Value)
+{
+	//Waiting for something never signalled would hang a real fence.
+	Assert(Value <= mLastSignalledValue);
+
+	if (mCompletedValue < Value)
+	{
+		++mStallCount;
+		mStalledSignals += Value - mCompletedValue;
+		mCompletedValue = Value;
+	}
+}
+
+void SimulatedFence::AdvanceTo(uint64_t Value)
+{
+	if (Value > mLastSignalledValue)
+	{
+		Value = mLastSignalledValue;
+	}
+	if (Value > mCompletedValue)
+	{
+		mCompletedValue = Value;
+	}
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "IFence.h"
+
+//CPU only fence for headless simulation. Nothing completes on its own - the
+//simulation decides when the "GPU" catches up with AdvanceTo(). Waiting on an
+//incomplete value completes it immediately and counts as a stall.
+class SimulatedFence : public IFence
+{
+public:
+	SimulatedFence();
+	~SimulatedFence();
+
+	uint64_t Signal() override;
+
+	uint64_t GetLastSignalledValue() const override { return mLastSignalledValue; }
+	uint64_t GetCompletedValue() const override { return mCompletedValue; }
+
+	void WaitForValue(uint64_t Value) override;
+
+	//Simulated GPU progress. Clamped to the last signalled value.
+	void AdvanceTo(uint64_t Value);
+
+	uint64_t GetStallCount() const { return mStallCount; }
+
+	//Sum of (Value - Completed) over every stalling wait - how many signals the
+	//CPU had to wait for.
+	uint64_t GetStalledSignals() const { return mStalledSignals; }
+
+private:
+	uint64_t mLastSignalledValue;
+	uint64_t mCompletedValue;
+	uint64_t mStallCount;
+	uint64_t mStalledSignals;
+};
@@ -0,0 +1,76 @@
+#include "SimulatedTextureStreamingBackend.h"
+
+#include <algorithm>
+
+SimulatedTextureStreamingBackend::SimulatedTextureStreamingBackend(const SimulatedTextureStreamingSettings& Settings)
+	: mSettings(Settings), mFrameIndex(0), mTotalBytesUploaded(0), mTotalEvictions(0)
+{}
+
+SimulatedTextureStreamingBackend::~SimulatedTextureStreamingBackend()
+{}
+
+uint32_t SimulatedTextureStreamingBackend::OnTextureRegistered(StreamedTextureHandle Texture, const StreamedTextureDesc& Desc)
+{
+	return 0;
+}
+
+void SimulatedTextureStreamingBackend::OnTextureUnregistered(StreamedTextureHandle Texture)
+{
+	//Cancel anything still in flight - the handle may be reused straight away.
+	mQueue.erase(std::remove_if(mQueue.begin(), mQueue.end(),
+		[Texture](const QueuedUpload& Upload) { return Upload.Request.Texture == Texture; }), mQueue.end());
+
+	mCompleted.erase(std::remove_if(mCompleted.begin(), mCompleted.end(),
+		[Texture](const MipUploadRequest& Request) { return Request.Texture == Texture; }), mCompleted.end());
+}
+
+void SimulatedTextureStreamingBackend::SubmitMipUpload(const MipUploadRequest& Request)
+{
+	QueuedUpload Upload;
+	Upload.Request = Request;
+	Upload.SubmitFrame = mFrameIndex;
+	Upload.BytesRemaining = Request.SizeInBytes;
+	mQueue.push_back(Upload);
+}
+
+void SimulatedTextureStreamingBackend::CollectCompletedUploads(std::vector<MipUploadRequest>& OutCompleted)
+{
+	OutCompleted.insert(OutCompleted.end(), mCompleted.begin(), mCompleted.end());
+	mCompleted.clear();
+}
+
+void SimulatedTextureStreamingBackend::EvictMips(StreamedTextureHandle Texture, uint32_t NewResidentMip)
+{
+	++mTotalEvictions;
+}
+
+void SimulatedTextureStreamingBackend::Tick()
+{
+	uint64_t Bandwidth = mSettings.BandwidthBytesPerFrame;
+
+	while (!mQueue.empty())
+	{
+		QueuedUpload& Upload = mQueue.front();
+
+		//In order, like a real copy queue - a young request blocks those behind it.
+		if (mFrameIndex - Upload.SubmitFrame < mSettings.LatencyFrames)
+		{
+			break;
+		}
+
+		uint64_t Moved = std::min(Bandwidth, Upload.BytesRemaining);
+		Upload.BytesRemaining -= Moved;
+		Bandwidth -= Moved;
+		mTotalBytesUploaded += Moved;
+
+		if (Upload.BytesRemaining > 0)
+		{
+			break;
+		}
+
+		mCompleted.push_back(Upload.Request);
+		mQueue.pop_front();
+	}
+
+	++mFrameIndex;
+}
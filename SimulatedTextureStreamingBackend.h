@@ -0,0 +1,55 @@
+#pragma once
+
+#include "TextureStreamer.h"
+
+#include <deque>
+
+//GPU-less streaming backend. Uploads are modelled as a FIFO copy queue with a
+//fixed latency and a per frame bandwidth limit, so a streaming run is fully
+//deterministic for a given camera path.
+struct SimulatedTextureStreamingSettings
+{
+	//Bytes the simulated copy queue moves per frame (IO + decompression + copy).
+	uint64_t BandwidthBytesPerFrame = 8ull * 1024ull * 1024ull;
+
+	//Minimum number of frames between submit and completion.
+	uint32_t LatencyFrames = 2;
+};
+
+class SimulatedTextureStreamingBackend : public ITextureStreamingBackend
+{
+public:
+	SimulatedTextureStreamingBackend(const SimulatedTextureStreamingSettings& Settings);
+	~SimulatedTextureStreamingBackend();
+
+	uint32_t OnTextureRegistered(StreamedTextureHandle Texture, const StreamedTextureDesc& Desc) override;
+	void OnTextureUnregistered(StreamedTextureHandle Texture) override;
+
+	void SubmitMipUpload(const MipUploadRequest& Request) override;
+	void CollectCompletedUploads(std::vector<MipUploadRequest>& OutCompleted) override;
+
+	void EvictMips(StreamedTextureHandle Texture, uint32_t NewResidentMip) override;
+
+	//Advance the simulated copy queue by one frame.
+	void Tick();
+
+	uint64_t GetTotalBytesUploaded() const { return mTotalBytesUploaded; }
+	uint64_t GetTotalEvictions() const { return mTotalEvictions; }
+
+private:
+	struct QueuedUpload
+	{
+		MipUploadRequest Request;
+		uint64_t SubmitFrame;
+		uint64_t BytesRemaining;
+	};
+
+	SimulatedTextureStreamingSettings mSettings;
+
+	std::deque<QueuedUpload> mQueue;
+	std::vector<MipUploadRequest> mCompleted;
+
+	uint64_t mFrameIndex;
+	uint64_t mTotalBytesUploaded;
+	uint64_t mTotalEvictions;
+};
@@ -0,0 +1,407 @@
+#include "SpatialHashBenchmark.h"
+#include "Common.h"
+#include "DynamicBvh.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <stdio.h>
+
+namespace
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	double MillisecondsSince(Clock::time_point Start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - Start).count();
+	}
+
+	//Furthest a point moves in a frame along each axis
+	const float Speed = 0.5f;
+
+	//Queries checked against brute force per check
+	const uint32_t VerifiedQueries = 20;
+
+	//Neighbour queries per job
+	const uint32_t QueryBatchSize = 1024;
+
+	//Points bouncing around inside a cube of HalfSize either side of the origin
+	struct PointCloud
+	{
+		std::vector<Float3> Positions;
+		std::vector<Float3> Velocities;
+		float HalfSize = 0.0f;
+
+		PointCloud(uint32_t Count, float Density)
+			: Positions(Count)
+			, Velocities(Count)
+		{
+			HalfSize = 0.5f * cbrtf(static_cast<float>(Count) / Density);
+
+			std::mt19937 Random(1234);
+			std::uniform_real_distribution<float> Position(-HalfSize, HalfSize);
+			std::uniform_real_distribution<float> Velocity(-Speed, Speed);
+			for (uint32_t i = 0; i < Count; ++i)
+			{
+				Positions[i] = MakeFloat3(Position(Random), Position(Random), Position(Random));
+				Velocities[i] = MakeFloat3(Velocity(Random), Velocity(Random), Velocity(Random));
+			}
+		}
+
+		void Step()
+		{
+			for (size_t i = 0; i < Positions.size(); ++i)
+			{
+				Float3& Position = Positions[i];
+				Float3& Velocity = Velocities[i];
+				Position = Position + Velocity;
+				if (fabsf(Position.X) > HalfSize) { Velocity.X = -Velocity.X; }
+				if (fabsf(Position.Y) > HalfSize) { Velocity.Y = -Velocity.Y; }
+				if (fabsf(Position.Z) > HalfSize) { Velocity.Z = -Velocity.Z; }
+			}
+		}
+	};
+
+	//Which points each frame's neighbour queries are centred on
+	std::vector<uint32_t> MakeQueryPoints(uint32_t PointCount, uint32_t QueryCount, uint32_t Frame)
+	{
+		std::mt19937 Random(77 + Frame);
+		std::uniform_int_distribution<uint32_t> Point(0, PointCount - 1);
+		std::vector<uint32_t> Points(QueryCount);
+		for (uint32_t& Query : Points)
+		{
+			Query = Point(Random);
+		}
+		return Points;
+	}
+
+	Aabb MakeQueryBox(const Float3& Centre, float Radius)
+	{
+		Aabb Box;
+		Box.Min = Centre - MakeFloat3(Radius, Radius, Radius);
+		Box.Max = Centre + MakeFloat3(Radius, Radius, Radius);
+		return Box;
+	}
+}
+
+SpatialHashBenchmark::SpatialHashBenchmark(const SpatialHashBenchmarkSettings& Settings)
+	: mSettings(Settings)
+{
+	Assert(mSettings.Frames > 0);
+}
+
+SpatialHashBenchmark::~SpatialHashBenchmark()
+{}
+
+bool SpatialHashBenchmark::Run()
+{
+	mResults.clear();
+	mGrids.clear();
+	for (uint32_t ThreadCount : mSettings.ThreadCounts)
+	{
+		if (ThreadCount < 2)
+		{
+			mLastError = "Thread counts must be at least 2 - one thread is always run";
+			return false;
+		}
+	}
+	if (mSettings.Density <= 0.0f || mSettings.CellSize <= 0.0f || mSettings.QueryRadius < 0.0f)
+	{
+		mLastError = "Density and cell size must be above 0 and the query radius at least 0";
+		return false;
+	}
+
+	for (uint32_t PointCount : mSettings.PointCounts)
+	{
+		if (PointCount == 0 || !RunPointCount(PointCount))
+		{
+			if (mLastError.empty())
+			{
+				mLastError = "Point counts must be above 0";
+			}
+			return false;
+		}
+	}
+	return true;
+}
+
+bool SpatialHashBenchmark::RunPointCount(uint32_t PointCount)
+{
+	SpatialHashGrid Grid(mSettings.CellSize);
+
+	std::vector<uint32_t> ThreadCounts = mSettings.ThreadCounts;
+	ThreadCounts.insert(ThreadCounts.begin(), 1);
+
+	//Every thread count runs the same frames from the same start
+	uint32_t BatchCount = (mSettings.QueryCount + QueryBatchSize - 1) / QueryBatchSize;
+	std::vector<uint64_t> BatchFound(BatchCount);
+	uint64_t RadiusFound = 0;
+	for (uint32_t ThreadCount : ThreadCounts)
+	{
+		std::unique_ptr<JobSystem> Jobs;
+		if (ThreadCount > 1)
+		{
+			Jobs.reset(new JobSystem(ThreadCount - 1));
+		}
+
+		PointCloud Cloud(PointCount, mSettings.Density);
+		double BuildMilliseconds = 0.0;
+		double QueryMilliseconds = 0.0;
+		uint64_t FoundCount = 0;
+		for (uint32_t Frame = 0; Frame < mSettings.Frames; ++Frame)
+		{
+			Cloud.Step();
+
+			auto Start = Clock::now();
+			Grid.Build(Cloud.Positions.data(), PointCount, Jobs.get());
+			BuildMilliseconds += MillisecondsSince(Start);
+
+			if (Frame == 0 && ThreadCount == 1)
+			{
+				mGrids.push_back(Grid.ComputeStats());
+			}
+			if ((Frame == 0 || Frame + 1 == mSettings.Frames) && !Verify(Grid, Cloud.Positions, Frame, ThreadCount))
+			{
+				return false;
+			}
+
+			std::vector<uint32_t> QueryPoints = MakeQueryPoints(PointCount, mSettings.QueryCount, Frame);
+			auto RunQueries = [this, &Grid, &Cloud, &QueryPoints, &BatchFound](uint32_t BatchBegin, uint32_t BatchEnd)
+			{
+				std::vector<uint32_t> Found;
+				for (uint32_t Batch = BatchBegin; Batch < BatchEnd; ++Batch)
+				{
+					uint32_t End = std::min(mSettings.QueryCount, (Batch + 1) * QueryBatchSize);
+					BatchFound[Batch] = 0;
+					for (uint32_t Query = Batch * QueryBatchSize; Query < End; ++Query)
+					{
+						Found.clear();
+						Grid.QueryRadius(Cloud.Positions[QueryPoints[Query]], mSettings.QueryRadius, Found);
+						BatchFound[Batch] += Found.size();
+					}
+				}
+			};
+
+			Start = Clock::now();
+			if (Jobs)
+			{
+				Jobs->ParallelFor(BatchCount, 1, RunQueries);
+			}
+			else
+			{
+				RunQueries(0, BatchCount);
+			}
+			QueryMilliseconds += MillisecondsSince(Start);
+			for (uint64_t Found : BatchFound)
+			{
+				FoundCount += Found;
+			}
+		}
+
+		if (ThreadCount == 1)
+		{
+			RadiusFound = FoundCount;
+		}
+
+		std::string Suffix = ThreadCount > 1 ? " x" + std::to_string(ThreadCount) : "";
+		uint64_t QueryTotal = static_cast<uint64_t>(mSettings.QueryCount) * mSettings.Frames;
+		AddResult(PointCount, "Grid build" + Suffix, BuildMilliseconds, static_cast<uint64_t>(PointCount) * mSettings.Frames);
+		AddResult(PointCount, "Grid radius" + Suffix, QueryMilliseconds, QueryTotal,
+			QueryTotal > 0 ? static_cast<double>(FoundCount) / QueryTotal : 0.0);
+	}
+
+	//Boxes, and the tree to compare with, on one thread
+	PointCloud Cloud(PointCount, mSettings.Density);
+	std::unique_ptr<DynamicBvh> Bvh;
+	std::vector<uint32_t> Objects;
+	if (mSettings.bCompareBvh)
+	{
+		//Points move less than the margin each frame, so most moves only refit
+		Bvh.reset(new DynamicBvh(Speed));
+		Objects.resize(PointCount);
+		for (uint32_t i = 0; i < PointCount; ++i)
+		{
+			Objects[i] = Bvh->Insert(MakeQueryBox(Cloud.Positions[i], 0.0f));
+		}
+		Bvh->Rebuild();
+	}
+
+	std::vector<uint32_t> Found;
+	float RadiusSquared = mSettings.QueryRadius * mSettings.QueryRadius;
+	double BoxMilliseconds = 0.0;
+	double BvhMoveMilliseconds = 0.0;
+	double BvhQueryMilliseconds = 0.0;
+	uint64_t BoxFound = 0;
+	uint64_t BvhFound = 0;
+	for (uint32_t Frame = 0; Frame < mSettings.Frames; ++Frame)
+	{
+		Cloud.Step();
+		Grid.Build(Cloud.Positions.data(), PointCount);
+		std::vector<uint32_t> QueryPoints = MakeQueryPoints(PointCount, mSettings.QueryCount, Frame);
+
+		auto Start = Clock::now();
+		for (uint32_t Point : QueryPoints)
+		{
+			Found.clear();
+			Grid.QueryBox(MakeQueryBox(Cloud.Positions[Point], mSettings.QueryRadius), Found);
+			BoxFound += Found.size();
+		}
+		BoxMilliseconds += MillisecondsSince(Start);
+
+		if (Bvh)
+		{
+			Start = Clock::now();
+			for (uint32_t i = 0; i < PointCount; ++i)
+			{
+				Bvh->Move(Objects[i], MakeQueryBox(Cloud.Positions[i], 0.0f));
+			}
+			BvhMoveMilliseconds += MillisecondsSince(Start);
+
+			//Leaves are grown by the margin, so what the tree returns still needs
+			//the exact distance test the grid does
+			Start = Clock::now();
+			for (uint32_t Point : QueryPoints)
+			{
+				const Float3& Centre = Cloud.Positions[Point];
+				Found.clear();
+				Bvh->QuerySphere(Centre, mSettings.QueryRadius, Found);
+				for (uint32_t Object : Found)
+				{
+					Float3 Delta = Bvh->GetBounds(Object).Min - Centre;
+					if (Dot(Delta, Delta) <= RadiusSquared)
+					{
+						++BvhFound;
+					}
+				}
+			}
+			BvhQueryMilliseconds += MillisecondsSince(Start);
+		}
+	}
+
+	uint64_t QueryTotal = static_cast<uint64_t>(mSettings.QueryCount) * mSettings.Frames;
+	AddResult(PointCount, "Grid box", BoxMilliseconds, QueryTotal, QueryTotal > 0 ? static_cast<double>(BoxFound) / QueryTotal : 0.0);
+	if (Bvh)
+	{
+		if (BvhFound != RadiusFound)
+		{
+			char Error[160];
+			snprintf(Error, sizeof(Error), "Bvh radius queries found %llu points and grid radius queries %llu with %u points",
+				static_cast<unsigned long long>(BvhFound), static_cast<unsigned long long>(RadiusFound), PointCount);
+			mLastError = Error;
+			return false;
+		}
+		AddResult(PointCount, "Bvh move", BvhMoveMilliseconds, static_cast<uint64_t>(PointCount) * mSettings.Frames);
+		AddResult(PointCount, "Bvh radius", BvhQueryMilliseconds, QueryTotal,
+			QueryTotal > 0 ? static_cast<double>(BvhFound) / QueryTotal : 0.0);
+	}
+	return true;
+}
+
+bool SpatialHashBenchmark::Verify(const SpatialHashGrid& Grid, const std::vector<Float3>& Positions, uint32_t Frame, uint32_t ThreadCount)
+{
+	uint32_t PointCount = static_cast<uint32_t>(Positions.size());
+	float RadiusSquared = mSettings.QueryRadius * mSettings.QueryRadius;
+	std::vector<uint32_t> QueryPoints = MakeQueryPoints(PointCount, VerifiedQueries, 1000 + Frame);
+	std::vector<uint32_t> Found;
+	std::vector<uint32_t> Expected;
+
+	auto Matches = [&Found, &Expected]()
+	{
+		std::sort(Found.begin(), Found.end());
+		return Found == Expected;
+	};
+
+	auto Fail = [this, PointCount, Frame, ThreadCount](const char* Query, uint32_t Index)
+	{
+		char Error[160];
+		snprintf(Error, sizeof(Error), "%s query %u disagrees with brute force with %u points, %u threads, frame %u",
+			Query, Index, PointCount, ThreadCount, Frame);
+		mLastError = Error;
+		return false;
+	};
+
+	for (uint32_t Query = 0; Query < VerifiedQueries; ++Query)
+	{
+		const Float3& Centre = Positions[QueryPoints[Query]];
+
+		Expected.clear();
+		for (uint32_t Point = 0; Point < PointCount; ++Point)
+		{
+			Float3 Delta = Positions[Point] - Centre;
+			if (Dot(Delta, Delta) <= RadiusSquared)
+			{
+				Expected.push_back(Point);
+			}
+		}
+		Found.clear();
+		Grid.QueryRadius(Centre, mSettings.QueryRadius, Found);
+		if (!Matches())
+		{
+			return Fail("Radius", Query);
+		}
+
+		Aabb Box = MakeQueryBox(Centre, mSettings.QueryRadius);
+		Expected.clear();
+		for (uint32_t Point = 0; Point < PointCount; ++Point)
+		{
+			const Float3& Position = Positions[Point];
+			if (Position.X >= Box.Min.X && Position.X <= Box.Max.X &&
+				Position.Y >= Box.Min.Y && Position.Y <= Box.Max.Y &&
+				Position.Z >= Box.Min.Z && Position.Z <= Box.Max.Z)
+			{
+				Expected.push_back(Point);
+			}
+		}
+		Found.clear();
+		Grid.QueryBox(Box, Found);
+		if (!Matches())
+		{
+			return Fail("Box", Query);
+		}
+	}
+	return true;
+}
+
+void SpatialHashBenchmark::AddResult(uint32_t PointCount, const std::string& Mode, double Milliseconds, uint64_t Items, double ResultsPerQuery)
+{
+	SpatialHashBenchmarkResult Result;
+	Result.PointCount = PointCount;
+	Result.Mode = Mode;
+	Result.MillisecondsPerFrame = Milliseconds / mSettings.Frames;
+	Result.ItemsPerMillisecond = Milliseconds > 0.0 ? Items / Milliseconds : 0.0;
+	Result.ResultsPerQuery = ResultsPerQuery;
+	mResults.push_back(Result);
+}
+
+bool SpatialHashBenchmark::WriteReport(const char* Filename) const
+{
+	FILE* File = fopen(Filename, "w");
+	if (!File)
+	{
+		return false;
+	}
+
+	fprintf(File, "Frames:      %u\n", mSettings.Frames);
+	fprintf(File, "Queries:     %u per frame\n", mSettings.QueryCount);
+	fprintf(File, "Density:     %.2f points per unit volume\n", mSettings.Density);
+	fprintf(File, "Cell size:   %.2f\n", mSettings.CellSize);
+	fprintf(File, "Radius:      %.2f\n\n", mSettings.QueryRadius);
+
+	fprintf(File, "Points,Mode,MsPerFrame,ItemsPerMs,ResultsPerQuery\n");
+	for (const SpatialHashBenchmarkResult& Result : mResults)
+	{
+		fprintf(File, "%u,%s,%.3f,%.1f,%.2f\n", Result.PointCount, Result.Mode.c_str(), Result.MillisecondsPerFrame,
+			Result.ItemsPerMillisecond, Result.ResultsPerQuery);
+	}
+
+	fprintf(File, "\nPoints,Buckets,Occupied,LargestBucket\n");
+	for (const SpatialHashGridStats& Stats : mGrids)
+	{
+		fprintf(File, "%u,%u,%u,%u\n", Stats.PointCount, Stats.BucketCount, Stats.OccupiedBuckets, Stats.LargestBucket);
+	}
+
+	fclose(File);
+	return true;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "SpatialHashGrid.h"
+
+//SpatialHashGrid against DynamicBvh for each of PointCounts points, all of
+//them moving every frame through a cube sized to keep Density points per unit
+//volume. Modes:
+//	Grid build (xN)		- Build() from every position, on one thread then split
+//						  across each of ThreadCounts threads, in points per ms
+//	Grid radius (xN)	- QueryCount neighbour queries of QueryRadius around
+//						  random points, in queries per ms
+//	Grid box			- QueryCount boxes 2 * QueryRadius across, in queries per ms
+//	Bvh move			- every point moved in a DynamicBvh, in points per ms
+//	Bvh radius			- the same neighbour queries as sphere queries, with the
+//						  grid's exact distance test on what the tree returns
+//
+//Ms is per frame. Bvh modes are skipped with bCompareBvh off.
+//Run() fails if a grid query disagrees with a brute force pass over the points,
+//or if the Bvh radius queries don't find as many points as the grid's.
+struct SpatialHashBenchmarkSettings
+{
+	std::vector<uint32_t> PointCounts = { 100000, 1000000 };
+	std::vector<uint32_t> ThreadCounts = { 2, 4, 8 };
+	uint32_t Frames = 10;
+	uint32_t QueryCount = 100000;
+	float Density = 0.5f;
+	float CellSize = 4.0f;
+	float QueryRadius = 2.0f;
+	bool bCompareBvh = true;
+};
+
+struct SpatialHashBenchmarkResult
+{
+	uint32_t PointCount = 0;
+	std::string Mode;
+	double MillisecondsPerFrame = 0.0;
+	double ItemsPerMillisecond = 0.0;
+	double ResultsPerQuery = 0.0;
+};
+
+class SpatialHashBenchmark
+{
+public:
+	SpatialHashBenchmark(const SpatialHashBenchmarkSettings& Settings);
+	~SpatialHashBenchmark();
+
+	bool Run();
+	bool WriteReport(const char* Filename) const;
+
+	const std::string& GetLastError() const { return mLastError; }
+
+private:
+	bool RunPointCount(uint32_t PointCount);
+
+	//Spot checks both query types against the positions
+	bool Verify(const SpatialHashGrid& Grid, const std::vector<Float3>& Positions, uint32_t Frame, uint32_t ThreadCount);
+
+	void AddResult(uint32_t PointCount, const std::string& Mode, double Milliseconds, uint64_t Items, double ResultsPerQuery = 0.0);
+
+private:
+	SpatialHashBenchmarkSettings mSettings;
+	std::vector<SpatialHashBenchmarkResult> mResults;
+	std::vector<SpatialHashGridStats> mGrids;
+
+	std::string mLastError;
+};
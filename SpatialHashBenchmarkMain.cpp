@@ -0,0 +1,79 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "SpatialHashBenchmark.h"
+
+//Spatial hash grid benchmark:
+//	SpatialHashBenchmark [-frames N] [-points N ...] [-threads N ...] [-queries N] [-density F] [-cell F] [-radius F] [-nobvh]
+//Writes SpatialHashBenchmark.txt to the current directory.
+int main(int argc, char** argv)
+{
+	SpatialHashBenchmarkSettings Settings;
+	bool bCustomPoints = false;
+	bool bCustomThreads = false;
+	bool bValid = true;
+	for (int i = 1; i < argc && bValid; ++i)
+	{
+		if (strcmp(argv[i], "-frames") == 0 && i + 1 < argc)
+		{
+			Settings.Frames = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-points") == 0 && i + 1 < argc)
+		{
+			if (!bCustomPoints)
+			{
+				Settings.PointCounts.clear();
+				bCustomPoints = true;
+			}
+			Settings.PointCounts.push_back(static_cast<uint32_t>(atoi(argv[++i])));
+		}
+		else if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc)
+		{
+			if (!bCustomThreads)
+			{
+				Settings.ThreadCounts.clear();
+				bCustomThreads = true;
+			}
+			Settings.ThreadCounts.push_back(static_cast<uint32_t>(atoi(argv[++i])));
+		}
+		else if (strcmp(argv[i], "-queries") == 0 && i + 1 < argc)
+		{
+			Settings.QueryCount = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-density") == 0 && i + 1 < argc)
+		{
+			Settings.Density = static_cast<float>(atof(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-cell") == 0 && i + 1 < argc)
+		{
+			Settings.CellSize = static_cast<float>(atof(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-radius") == 0 && i + 1 < argc)
+		{
+			Settings.QueryRadius = static_cast<float>(atof(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-nobvh") == 0)
+		{
+			Settings.bCompareBvh = false;
+		}
+		else
+		{
+			bValid = false;
+		}
+	}
+
+	if (!bValid || Settings.Frames == 0)
+	{
+		fprintf(stderr, "Usage: SpatialHashBenchmark [-frames N] [-points N ...] [-threads N ...] [-queries N] [-density F] [-cell F] [-radius F] [-nobvh]\n");
+		return 1;
+	}
+
+	SpatialHashBenchmark Benchmark(Settings);
+	if (!Benchmark.Run())
+	{
+		fprintf(stderr, "%s\n", Benchmark.GetLastError().c_str());
+		return 1;
+	}
+	return Benchmark.WriteReport("SpatialHashBenchmark.txt") ? 0 : 1;
+}
@@ -0,0 +1,290 @@
+#include "SpatialHashGrid.h"
+#include "Common.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+
+namespace
+{
+	const uint32_t MinBucketBits = 8;
+	const uint32_t MaxBucketBits = 24;
+
+	//Queries touching up to this many cells drop repeated buckets with a search of a list on the stack
+	const uint32_t InlineCellCount = 64;
+
+	int32_t CellCoordinate(float Value)
+	{
+		//Also catches NaNs, which fail every compare
+		const float Limit = 1073741824.0f;
+		if (!(Value >= -Limit))
+		{
+			Value = -Limit;
+		}
+		else if (Value > Limit)
+		{
+			Value = Limit;
+		}
+		return static_cast<int32_t>(floorf(Value));
+	}
+
+	//Body(Block) for each block, across the job system if there's more than one
+	template <typename Function>
+	void ForEachBlock(JobSystem* Jobs, uint32_t BlockCount, const Function& Body)
+	{
+		if (Jobs && BlockCount > 1)
+		{
+			Jobs->ParallelFor(BlockCount, 1, [&Body](uint32_t Begin, uint32_t End)
+			{
+				for (uint32_t Block = Begin; Block < End; ++Block)
+				{
+					Body(Block);
+				}
+			});
+		}
+		else
+		{
+			for (uint32_t Block = 0; Block < BlockCount; ++Block)
+			{
+				Body(Block);
+			}
+		}
+	}
+}
+
+SpatialHashGrid::SpatialHashGrid(float CellSize)
+	: mCellSize(CellSize)
+	, mInverseCellSize(1.0f / CellSize)
+	, mCount(0)
+	, mBucketBits(MinBucketBits)
+{
+	Assert(CellSize > 0.0f);
+}
+
+SpatialHashGrid::~SpatialHashGrid()
+{}
+
+void SpatialHashGrid::Build(const Float3* Positions, uint32_t Count, JobSystem* Jobs)
+{
+	//About two buckets per point
+	mCount = Count;
+	mBucketBits = MinBucketBits;
+	while (mBucketBits < MaxBucketBits && (1u << (mBucketBits - 1)) < Count)
+	{
+		++mBucketBits;
+	}
+	uint32_t BucketCount = 1u << mBucketBits;
+
+	mKeys.resize(Count);
+	mPoints.resize(Count);
+	mX.resize(Count);
+	mY.resize(Count);
+	mZ.resize(Count);
+	mBucketStarts.resize(BucketCount + 1);
+
+	if (Count == 0)
+	{
+		std::fill(mBucketStarts.begin(), mBucketStarts.end(), 0);
+		return;
+	}
+
+	uint32_t BlockCount = (Count + JobBatchSize - 1) / JobBatchSize;
+
+	ForEachBlock(Jobs, BlockCount, [this, Positions](uint32_t Block)
+	{
+		uint32_t Begin = Block * JobBatchSize;
+		uint32_t End = std::min(mCount, Begin + JobBatchSize);
+		for (uint32_t i = Begin; i < End; ++i)
+		{
+			mKeys[i] = HashPosition(Positions[i].X, Positions[i].Y, Positions[i].Z);
+			mPoints[i] = i;
+		}
+	});
+
+	mSorter.Sort(mKeys, mPoints, mBucketBits, Jobs);
+
+	//Positions in sorted order, and the bucket starts. A point whose bucket
+	//differs from the one before it starts that bucket and ends every empty
+	//one in between, so each block fills its own part of the table.
+	ForEachBlock(Jobs, BlockCount, [this, Positions, BucketCount](uint32_t Block)
+	{
+		uint32_t Begin = Block * JobBatchSize;
+		uint32_t End = std::min(mCount, Begin + JobBatchSize);
+		for (uint32_t i = Begin; i < End; ++i)
+		{
+			const Float3& Position = Positions[mPoints[i]];
+			mX[i] = Position.X;
+			mY[i] = Position.Y;
+			mZ[i] = Position.Z;
+
+			uint32_t First = i > 0 ? mKeys[i - 1] + 1 : 0;
+			for (uint32_t Bucket = First; Bucket <= mKeys[i]; ++Bucket)
+			{
+				mBucketStarts[Bucket] = i;
+			}
+		}
+
+		if (End == mCount)
+		{
+			for (uint32_t Bucket = mKeys[mCount - 1] + 1; Bucket <= BucketCount; ++Bucket)
+			{
+				mBucketStarts[Bucket] = mCount;
+			}
+		}
+	});
+}
+
+uint32_t SpatialHashGrid::HashPosition(float X, float Y, float Z) const
+{
+	return HashCell(CellCoordinate(X * mInverseCellSize), CellCoordinate(Y * mInverseCellSize), CellCoordinate(Z * mInverseCellSize));
+}
+
+uint32_t SpatialHashGrid::HashCell(int32_t X, int32_t Y, int32_t Z) const
+{
+	//The usual xor of three multiplies collides a lot between nearby cells, so
+	//sum them and mix the high bits back down before masking
+	uint32_t Hash = static_cast<uint32_t>(X) * 0x8DA6B343u + static_cast<uint32_t>(Y) * 0xD8163841u + static_cast<uint32_t>(Z) * 0xCB1AB31Fu;
+	Hash ^= Hash >> 16;
+	Hash *= 0x7FEB352Du;
+	Hash ^= Hash >> 15;
+	Hash *= 0x846CA68Bu;
+	Hash ^= Hash >> 16;
+	return Hash & ((1u << mBucketBits) - 1);
+}
+
+template <typename Function>
+void SpatialHashGrid::ForEachBucket(const Float3& Min, const Float3& Max, Function&& Visit) const
+{
+	int32_t LowX = CellCoordinate(Min.X * mInverseCellSize);
+	int32_t LowY = CellCoordinate(Min.Y * mInverseCellSize);
+	int32_t LowZ = CellCoordinate(Min.Z * mInverseCellSize);
+	int32_t HighX = CellCoordinate(Max.X * mInverseCellSize);
+	int32_t HighY = CellCoordinate(Max.Y * mInverseCellSize);
+	int32_t HighZ = CellCoordinate(Max.Z * mInverseCellSize);
+	if (HighX < LowX || HighY < LowY || HighZ < LowZ)
+	{
+		return;
+	}
+
+	uint32_t BucketCount = 1u << mBucketBits;
+	int64_t CellCount = (static_cast<int64_t>(HighX) - LowX + 1) * (static_cast<int64_t>(HighY) - LowY + 1) *
+		(static_cast<int64_t>(HighZ) - LowZ + 1);
+	if (CellCount >= BucketCount)
+	{
+		//Likely to hit every bucket anyway
+		for (uint32_t Bucket = 0; Bucket < BucketCount; ++Bucket)
+		{
+			Visit(Bucket);
+		}
+		return;
+	}
+
+	if (CellCount <= InlineCellCount)
+	{
+		uint32_t Buckets[InlineCellCount];
+		uint32_t Found = 0;
+		for (int32_t Z = LowZ; Z <= HighZ; ++Z)
+		{
+			for (int32_t Y = LowY; Y <= HighY; ++Y)
+			{
+				for (int32_t X = LowX; X <= HighX; ++X)
+				{
+					uint32_t Bucket = HashCell(X, Y, Z);
+					if (std::find(Buckets, Buckets + Found, Bucket) == Buckets + Found)
+					{
+						Buckets[Found++] = Bucket;
+					}
+				}
+			}
+		}
+		for (uint32_t i = 0; i < Found; ++i)
+		{
+			Visit(Buckets[i]);
+		}
+		return;
+	}
+
+	std::vector<uint32_t> Buckets;
+	Buckets.reserve(static_cast<size_t>(CellCount));
+	for (int32_t Z = LowZ; Z <= HighZ; ++Z)
+	{
+		for (int32_t Y = LowY; Y <= HighY; ++Y)
+		{
+			for (int32_t X = LowX; X <= HighX; ++X)
+			{
+				Buckets.push_back(HashCell(X, Y, Z));
+			}
+		}
+	}
+	std::sort(Buckets.begin(), Buckets.end());
+	Buckets.erase(std::unique(Buckets.begin(), Buckets.end()), Buckets.end());
+	for (uint32_t Bucket : Buckets)
+	{
+		Visit(Bucket);
+	}
+}
+
+void SpatialHashGrid::QueryRadius(const Float3& Centre, float Radius, std::vector<uint32_t>& Out) const
+{
+	if (mCount == 0)
+	{
+		return;
+	}
+
+	float RadiusSquared = Radius * Radius;
+	Float3 Extent = MakeFloat3(Radius, Radius, Radius);
+	ForEachBucket(Centre - Extent, Centre + Extent, [this, &Centre, RadiusSquared, &Out](uint32_t Bucket)
+	{
+		uint32_t End = mBucketStarts[Bucket + 1];
+		for (uint32_t i = mBucketStarts[Bucket]; i < End; ++i)
+		{
+			float DeltaX = mX[i] - Centre.X;
+			float DeltaY = mY[i] - Centre.Y;
+			float DeltaZ = mZ[i] - Centre.Z;
+			if (DeltaX * DeltaX + DeltaY * DeltaY + DeltaZ * DeltaZ <= RadiusSquared)
+			{
+				Out.push_back(mPoints[i]);
+			}
+		}
+	});
+}
+
+void SpatialHashGrid::QueryBox(const Aabb& Box, std::vector<uint32_t>& Out) const
+{
+	if (mCount == 0)
+	{
+		return;
+	}
+
+	ForEachBucket(Box.Min, Box.Max, [this, &Box, &Out](uint32_t Bucket)
+	{
+		uint32_t End = mBucketStarts[Bucket + 1];
+		for (uint32_t i = mBucketStarts[Bucket]; i < End; ++i)
+		{
+			if (mX[i] >= Box.Min.X && mX[i] <= Box.Max.X &&
+				mY[i] >= Box.Min.Y && mY[i] <= Box.Max.Y &&
+				mZ[i] >= Box.Min.Z && mZ[i] <= Box.Max.Z)
+			{
+				Out.push_back(mPoints[i]);
+			}
+		}
+	});
+}
+
+SpatialHashGridStats SpatialHashGrid::ComputeStats() const
+{
+	SpatialHashGridStats Stats;
+	Stats.PointCount = mCount;
+	Stats.BucketCount = 1u << mBucketBits;
+	if (mCount == 0)
+	{
+		return Stats;
+	}
+
+	for (uint32_t Bucket = 0; Bucket < Stats.BucketCount; ++Bucket)
+	{
+		uint32_t Size = mBucketStarts[Bucket + 1] - mBucketStarts[Bucket];
+		Stats.OccupiedBuckets += Size > 0 ? 1 : 0;
+		Stats.LargestBucket = std::max(Stats.LargestBucket, Size);
+	}
+	return Stats;
+}
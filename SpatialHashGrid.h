@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "RadixSort.h"
+#include "VectorMath.h"
+
+class JobSystem;
+
+struct SpatialHashGridStats
+{
+	uint32_t PointCount = 0;
+	uint32_t BucketCount = 0;
+	uint32_t OccupiedBuckets = 0;
+	uint32_t LargestBucket = 0;		//Points in the fullest bucket
+};
+
+//Points in a uniform grid of CellSize cubes, for neighbour and box queries
+//over things that all move every frame.
+//
+//There's no incremental update: Build() starts again from the positions each
+//time, which for points that all move is cheaper than any tree refit. Cells
+//are hashed in to a power of two table of buckets sized to the point count,
+//so the grid has no bounds and empty space costs nothing. The points are then
+//radix sorted by bucket (see RadixSorter), leaving each bucket's points
+//packed together as structure of arrays with a table of where each bucket
+//starts.
+//
+//Every step of the build is split in to blocks of JobBatchSize points that
+//only write to their own part of the output, so jobs need no locks or
+//atomics, and the result is the same however many threads ran.
+//
+//Cells that hash to the same bucket share it, so queries test every point in
+//the buckets they touch. Neighbour queries are quickest with cells about
+//twice the radius across, so each touches at most eight. Objects with size
+//can be kept as their centres and queried with the query grown by the
+//largest object's radius - a loose grid - then tested exactly by the caller.
+class SpatialHashGrid
+{
+public:
+	static const uint32_t JobBatchSize = 65536;
+
+	SpatialHashGrid(float CellSize);
+	~SpatialHashGrid();
+
+	//Replaces the contents with Positions[0, Count). Point i is reported as i.
+	void Build(const Float3* Positions, uint32_t Count, JobSystem* Jobs = nullptr);
+
+	//Points within Radius of Centre, or inside Box, in no particular order.
+	//Appended to Out. Safe to call from several threads at once.
+	void QueryRadius(const Float3& Centre, float Radius, std::vector<uint32_t>& Out) const;
+	void QueryBox(const Aabb& Box, std::vector<uint32_t>& Out) const;
+
+	uint32_t GetPointCount() const { return mCount; }
+	float GetCellSize() const { return mCellSize; }
+
+	SpatialHashGridStats ComputeStats() const;
+
+private:
+	//Buckets the cells overlapping [Min, Max] fall in, each once
+	template <typename Function>
+	void ForEachBucket(const Float3& Min, const Float3& Max, Function&& Visit) const;
+
+	uint32_t HashPosition(float X, float Y, float Z) const;
+	uint32_t HashCell(int32_t X, int32_t Y, int32_t Z) const;
+
+private:
+	float mCellSize;
+	float mInverseCellSize;
+
+	uint32_t mCount;
+	uint32_t mBucketBits;
+
+	//Sorted by bucket
+	std::vector<uint32_t> mKeys;
+	std::vector<uint32_t> mPoints;
+	std::vector<float> mX, mY, mZ;
+
+	//Bucket b's points are [mBucketStarts[b], mBucketStarts[b + 1])
+	std::vector<uint32_t> mBucketStarts;
+
+	RadixSorter mSorter;
+};
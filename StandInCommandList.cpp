@@ -0,0 +1,115 @@
+#include "StandInCommandList.h"
+#include "Common.h"
+
+#include <string.h>
+
+StandInCommandList::StandInCommandList(const StandInCommandListLimits& Limits)
+	: mLimits(Limits)
+{
+	Reset();
+}
+
+StandInCommandList::~StandInCommandList()
+{}
+
+void StandInCommandList::Reset()
+{
+	mBuffer.clear();
+	memset(mCallCounts, 0, sizeof(mCallCounts));
+}
+
+uint32_t StandInCommandList::GetTotalCallCount() const
+{
+	uint32_t Total = 0;
+	for (uint32_t Count : mCallCounts)
+	{
+		Total += Count;
+	}
+	return Total;
+}
+
+void StandInCommandList::Write(RenderCommandType Type, const void* Payload, uint32_t PayloadSize)
+{
+	//Records are a type byte then the payload, padded to 4 bytes like GPU
+	//command packets
+	size_t Offset = mBuffer.size();
+	mBuffer.resize(Offset + ((1 + PayloadSize + 3) & ~3u));
+	mBuffer[Offset] = static_cast<uint8_t>(Type);
+	memcpy(&mBuffer[Offset + 1], Payload, PayloadSize);
+	++mCallCounts[static_cast<uint32_t>(Type)];
+}
+
+void StandInCommandList::SetPipelineState(uint32_t PipelineState)
+{
+	Check(PipelineState < mLimits.PipelineStateCount);
+	Write(RenderCommandType::SetPipelineState, &PipelineState, sizeof(PipelineState));
+}
+
+void StandInCommandList::SetGraphicsRootSignature(uint32_t RootSignature)
+{
+	Check(RootSignature < mLimits.RootSignatureCount);
+	Write(RenderCommandType::SetRootSignature, &RootSignature, sizeof(RootSignature));
+}
+
+void StandInCommandList::SetGraphicsRootDescriptorTable(uint32_t RootParameter, uint32_t Table)
+{
+	Check(RootParameter < mLimits.RootParameterCount && Table < mLimits.DescriptorTableCount);
+	uint32_t Payload[2] = { RootParameter, Table };
+	Write(RenderCommandType::SetDescriptorTable, Payload, sizeof(Payload));
+}
+
+void StandInCommandList::SetGraphicsRootShaderResourceView(uint32_t RootParameter, uint64_t GpuAddress)
+{
+	Check(RootParameter < mLimits.RootParameterCount && GpuAddress != 0);
+	uint8_t Payload[12];
+	memcpy(Payload, &RootParameter, 4);
+	memcpy(Payload + 4, &GpuAddress, 8);
+	Write(RenderCommandType::SetRootShaderResourceView, Payload, sizeof(Payload));
+}
+
+void StandInCommandList::SetMesh(uint32_t Mesh)
+{
+	Check(Mesh < mLimits.MeshCount);
+	Write(RenderCommandType::SetMesh, &Mesh, sizeof(Mesh));
+}
+
+void StandInCommandList::SetViewport(const RenderViewport& Viewport)
+{
+	Check(Viewport.Width > 0.0f && Viewport.Height > 0.0f);
+	Write(RenderCommandType::SetViewport, &Viewport, sizeof(Viewport));
+}
+
+void StandInCommandList::SetRenderTargets(uint32_t Count, const uint64_t* RenderTargets, uint64_t DepthStencil)
+{
+	Check(Count <= MaxRenderTargets && (Count == 0 || RenderTargets));
+	uint64_t Payload[1 + MaxRenderTargets];
+	Payload[0] = DepthStencil;
+	memcpy(&Payload[1], RenderTargets, Count * sizeof(uint64_t));
+	Write(RenderCommandType::SetRenderTargets, Payload, (1 + Count) * sizeof(uint64_t));
+}
+
+void StandInCommandList::DrawIndexedInstanced(uint32_t IndexCountPerInstance, uint32_t InstanceCount, uint32_t StartIndexLocation,
+	int32_t BaseVertexLocation, uint32_t StartInstanceLocation)
+{
+	Check(IndexCountPerInstance > 0 && InstanceCount > 0);
+	uint32_t Payload[5] = { IndexCountPerInstance, InstanceCount, StartIndexLocation, static_cast<uint32_t>(BaseVertexLocation), StartInstanceLocation };
+	Write(RenderCommandType::DrawIndexedInstanced, Payload, sizeof(Payload));
+}
+
+void StandInCommandList::ResourceBarrier(uint32_t Resource, RenderResourceState Before, RenderResourceState After)
+{
+	Check(Resource < mLimits.ResourceCount && Before != After && After < RenderResourceState::Count);
+	uint8_t Payload[6];
+	memcpy(Payload, &Resource, 4);
+	Payload[4] = static_cast<uint8_t>(Before);
+	Payload[5] = static_cast<uint8_t>(After);
+	Write(RenderCommandType::ResourceBarrier, Payload, sizeof(Payload));
+}
+
+void StandInCommandList::CopyBufferRegion(uint32_t Destination, uint64_t DestinationOffset, uint32_t Source, uint64_t SourceOffset,
+	uint64_t Size)
+{
+	Check(Destination < mLimits.ResourceCount && Source < mLimits.ResourceCount && Size > 0);
+	uint64_t Payload[4] = { (static_cast<uint64_t>(Destination) << 32) | Source, DestinationOffset, SourceOffset, Size };
+	Write(RenderCommandType::CopyBufferRegion, Payload, sizeof(Payload));
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "RenderCommandList.h"
+
+//Table sizes the stand-in checks ids against, as a driver validates handles
+struct StandInCommandListLimits
+{
+	uint32_t PipelineStateCount = 1u << 14;
+	uint32_t RootSignatureCount = 256;
+	uint32_t DescriptorTableCount = 1u << 20;
+	uint32_t MeshCount = 1u << 16;
+	uint32_t ResourceCount = 1u << 16;
+	uint32_t RootParameterCount = 16;
+};
+
+//Recording stand-in for a device's command list, for measuring recording
+//cost without a GPU. Every call is checked against the limits and written as
+//a packed record in to a command buffer that keeps its memory between
+//Reset()s, much as a driver fills its command allocator; calls and bytes are
+//counted per type.
+class StandInCommandList : public IRenderCommandList
+{
+public:
+	StandInCommandList(const StandInCommandListLimits& Limits = StandInCommandListLimits());
+	~StandInCommandList();
+
+	void Reset();
+
+	void SetPipelineState(uint32_t PipelineState) override;
+	void SetGraphicsRootSignature(uint32_t RootSignature) override;
+	void SetGraphicsRootDescriptorTable(uint32_t RootParameter, uint32_t Table) override;
+	void SetGraphicsRootShaderResourceView(uint32_t RootParameter, uint64_t GpuAddress) override;
+	void SetMesh(uint32_t Mesh) override;
+	void SetViewport(const RenderViewport& Viewport) override;
+	void SetRenderTargets(uint32_t Count, const uint64_t* RenderTargets, uint64_t DepthStencil) override;
+	void DrawIndexedInstanced(uint32_t IndexCountPerInstance, uint32_t InstanceCount, uint32_t StartIndexLocation,
+		int32_t BaseVertexLocation, uint32_t StartInstanceLocation) override;
+	void ResourceBarrier(uint32_t Resource, RenderResourceState Before, RenderResourceState After) override;
+	void CopyBufferRegion(uint32_t Destination, uint64_t DestinationOffset, uint32_t Source, uint64_t SourceOffset,
+		uint64_t Size) override;
+
+	//Since the last Reset()
+	uint32_t GetCallCount(RenderCommandType Type) const { return mCallCounts[static_cast<uint32_t>(Type)]; }
+	uint32_t GetTotalCallCount() const;
+	uint64_t GetRecordedBytes() const { return mBuffer.size(); }
+
+	const uint8_t* GetBuffer() const { return mBuffer.data(); }
+
+private:
+	void Write(RenderCommandType Type, const void* Payload, uint32_t PayloadSize);
+
+private:
+	StandInCommandListLimits mLimits;
+	std::vector<uint8_t> mBuffer;
+	uint32_t mCallCounts[static_cast<uint32_t>(RenderCommandType::Count)];
+};
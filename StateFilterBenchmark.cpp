@@ -0,0 +1,315 @@
+#include "StateFilterBenchmark.h"
+#include "Common.h"
+#include "StandInCommandList.h"
+#include "StateFilteringCommandList.h"
+
+#include <chrono>
+#include <random>
+#include <stdio.h>
+#include <string.h>
+
+namespace
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	double MillisecondsSince(Clock::time_point Start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - Start).count();
+	}
+
+	const uint32_t InstanceDataRootParameter = 0;
+	const uint32_t MaterialRootParameter = 1;
+	const uint32_t MeshIndexCount = 36;
+
+	//A pass's targets and viewport, picked from two of each
+	const uint64_t RenderTargets[2][2] = { { 0x1000, 0x1040 }, { 0x2000, 0x2040 } };
+	const uint64_t DepthStencils[2] = { 0x3000, 0x3040 };
+	const RenderViewport Viewports[2] =
+	{
+		{ 0.0f, 0.0f, 1920.0f, 1080.0f, 0.0f, 1.0f },
+		{ 0.0f, 0.0f, 2048.0f, 2048.0f, 0.0f, 1.0f }
+	};
+
+	struct Call
+	{
+		RenderCommandType Type;
+		uint32_t Value;
+		uint64_t Address;
+	};
+
+	std::vector<Call> MakeCalls(const StateFilterBenchmarkSettings& Settings, uint32_t DrawCount, float RedundantFraction)
+	{
+		std::mt19937 Random(1234);
+		std::uniform_real_distribution<float> Unit(0.0f, 1.0f);
+
+		//Each draw's value for each call type, kept from the draw before if redundant
+		uint32_t Values[static_cast<uint32_t>(RenderCommandType::Count)] = {};
+		auto Next = [&](RenderCommandType Type, uint32_t Count, bool bFirst)
+		{
+			uint32_t& Value = Values[static_cast<uint32_t>(Type)];
+			if (bFirst || Unit(Random) >= RedundantFraction)
+			{
+				Value = std::uniform_int_distribution<uint32_t>(0, Count - 1)(Random);
+			}
+			return Value;
+		};
+
+		std::vector<Call> Calls;
+		Calls.reserve(static_cast<size_t>(DrawCount) * 6 + (DrawCount / Settings.PassLength + 1) * 2);
+		for (uint32_t Draw = 0; Draw < DrawCount; ++Draw)
+		{
+			bool bFirst = Draw == 0;
+			if (Draw % Settings.PassLength == 0)
+			{
+				Calls.push_back({ RenderCommandType::SetRenderTargets, Next(RenderCommandType::SetRenderTargets, 2, bFirst), 0 });
+				Calls.push_back({ RenderCommandType::SetViewport, Next(RenderCommandType::SetViewport, 2, bFirst), 0 });
+			}
+			Calls.push_back({ RenderCommandType::SetRootSignature, Next(RenderCommandType::SetRootSignature, Settings.RootSignatureCount, bFirst), 0 });
+			Calls.push_back({ RenderCommandType::SetPipelineState, Next(RenderCommandType::SetPipelineState, Settings.PipelineStateCount, bFirst), 0 });
+			Calls.push_back({ RenderCommandType::SetDescriptorTable, Next(RenderCommandType::SetDescriptorTable, Settings.MaterialCount, bFirst), 0 });
+			Calls.push_back({ RenderCommandType::SetRootShaderResourceView, 0,
+				0x100000000ull + Next(RenderCommandType::SetRootShaderResourceView, DrawCount, bFirst) * 256ull });
+			Calls.push_back({ RenderCommandType::SetMesh, Next(RenderCommandType::SetMesh, Settings.MeshCount, bFirst), 0 });
+			Calls.push_back({ RenderCommandType::DrawIndexedInstanced, 1, 0 });
+		}
+		return Calls;
+	}
+
+	void Replay(const std::vector<Call>& Calls, IRenderCommandList& CommandList)
+	{
+		for (const Call& Entry : Calls)
+		{
+			switch (Entry.Type)
+			{
+			case RenderCommandType::SetPipelineState:
+				CommandList.SetPipelineState(Entry.Value);
+				break;
+			case RenderCommandType::SetRootSignature:
+				CommandList.SetGraphicsRootSignature(Entry.Value);
+				break;
+			case RenderCommandType::SetDescriptorTable:
+				CommandList.SetGraphicsRootDescriptorTable(MaterialRootParameter, Entry.Value);
+				break;
+			case RenderCommandType::SetRootShaderResourceView:
+				CommandList.SetGraphicsRootShaderResourceView(InstanceDataRootParameter, Entry.Address);
+				break;
+			case RenderCommandType::SetMesh:
+				CommandList.SetMesh(Entry.Value);
+				break;
+			case RenderCommandType::SetViewport:
+				CommandList.SetViewport(Viewports[Entry.Value]);
+				break;
+			case RenderCommandType::SetRenderTargets:
+				CommandList.SetRenderTargets(2, RenderTargets[Entry.Value], DepthStencils[Entry.Value]);
+				break;
+			case RenderCommandType::DrawIndexedInstanced:
+				CommandList.DrawIndexedInstanced(MeshIndexCount, Entry.Value, 0, 0, 0);
+				break;
+			default:
+				Assert(false);
+				break;
+			}
+		}
+	}
+
+	//What each draw would see on the GPU. Changing the root signature
+	//leaves the root arguments unset.
+	class StateTrackingCommandList : public IRenderCommandList
+	{
+	public:
+		struct DrawState
+		{
+			uint32_t PipelineState;
+			uint32_t RootSignature;
+			uint32_t Table;
+			uint32_t Mesh;
+			uint64_t InstanceData;
+			uint64_t RenderTarget;
+			float ViewportWidth;
+
+			bool operator==(const DrawState& Other) const
+			{
+				return PipelineState == Other.PipelineState && RootSignature == Other.RootSignature && Table == Other.Table &&
+					Mesh == Other.Mesh && InstanceData == Other.InstanceData && RenderTarget == Other.RenderTarget &&
+					ViewportWidth == Other.ViewportWidth;
+			}
+		};
+
+		StateTrackingCommandList()
+		{
+			memset(&mState, 0xFF, sizeof(mState));
+		}
+
+		void SetPipelineState(uint32_t PipelineState) override { mState.PipelineState = PipelineState; }
+		void SetGraphicsRootSignature(uint32_t RootSignature) override
+		{
+			if (RootSignature != mState.RootSignature)
+			{
+				mState.RootSignature = RootSignature;
+				mState.Table = ~0u;
+				mState.InstanceData = ~0ull;
+			}
+		}
+		void SetGraphicsRootDescriptorTable(uint32_t, uint32_t Table) override { mState.Table = Table; }
+		void SetGraphicsRootShaderResourceView(uint32_t, uint64_t GpuAddress) override { mState.InstanceData = GpuAddress; }
+		void SetMesh(uint32_t Mesh) override { mState.Mesh = Mesh; }
+		void SetViewport(const RenderViewport& Viewport) override { mState.ViewportWidth = Viewport.Width; }
+		void SetRenderTargets(uint32_t, const uint64_t* Targets, uint64_t DepthStencil) override
+		{
+			mState.RenderTarget = Targets[0] ^ (DepthStencil << 32);
+		}
+		void DrawIndexedInstanced(uint32_t, uint32_t, uint32_t, int32_t, uint32_t) override { mDraws.push_back(mState); }
+		void ResourceBarrier(uint32_t, RenderResourceState, RenderResourceState) override {}
+		void CopyBufferRegion(uint32_t, uint64_t, uint32_t, uint64_t, uint64_t) override {}
+
+		const std::vector<DrawState>& GetDraws() const { return mDraws; }
+
+	private:
+		DrawState mState;
+		std::vector<DrawState> mDraws;
+	};
+}
+
+StateFilterBenchmark::StateFilterBenchmark(const StateFilterBenchmarkSettings& Settings)
+	: mSettings(Settings)
+{
+	Assert(mSettings.Frames > 0);
+}
+
+StateFilterBenchmark::~StateFilterBenchmark()
+{}
+
+bool StateFilterBenchmark::Run()
+{
+	mResults.clear();
+	mFiltered.clear();
+	if (mSettings.PipelineStateCount == 0 || mSettings.RootSignatureCount == 0 || mSettings.MaterialCount == 0 ||
+		mSettings.MeshCount == 0 || mSettings.PassLength == 0)
+	{
+		mLastError = "Pipeline state, root signature, material, mesh counts and pass length must be above 0";
+		return false;
+	}
+
+	for (uint32_t DrawCount : mSettings.DrawCounts)
+	{
+		if (DrawCount == 0)
+		{
+			mLastError = "Draw counts must be above 0";
+			return false;
+		}
+		for (float RedundantFraction : mSettings.RedundantFractions)
+		{
+			if (!(RedundantFraction >= 0.0f && RedundantFraction <= 1.0f))
+			{
+				mLastError = "Redundant fractions must be from 0 to 1";
+				return false;
+			}
+			if (!RunDrawCount(DrawCount, RedundantFraction))
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+bool StateFilterBenchmark::RunDrawCount(uint32_t DrawCount, float RedundantFraction)
+{
+	std::vector<Call> Calls = MakeCalls(mSettings, DrawCount, RedundantFraction);
+
+	StateTrackingCommandList RawState;
+	Replay(Calls, RawState);
+	StateTrackingCommandList FilteredState;
+	StateFilteringCommandList FilteredTracking(&FilteredState);
+	Replay(Calls, FilteredTracking);
+	if (!(RawState.GetDraws() == FilteredState.GetDraws()))
+	{
+		char Error[128];
+		snprintf(Error, sizeof(Error), "Filtering changed draw state with %u draws, %.2f redundant", DrawCount, RedundantFraction);
+		mLastError = Error;
+		return false;
+	}
+
+	StandInCommandListLimits Limits;
+	Limits.PipelineStateCount = mSettings.PipelineStateCount;
+	Limits.RootSignatureCount = mSettings.RootSignatureCount;
+	Limits.DescriptorTableCount = mSettings.MaterialCount;
+	Limits.MeshCount = mSettings.MeshCount;
+	StandInCommandList StandIn(Limits);
+	StateFilteringCommandList Filter(&StandIn);
+
+	for (uint32_t bFiltered = 0; bFiltered < 2; ++bFiltered)
+	{
+		IRenderCommandList& CommandList = bFiltered ? static_cast<IRenderCommandList&>(Filter) : StandIn;
+		Filter.ResetStats();
+
+		double Milliseconds = 0.0;
+		uint64_t RecordedCalls = 0;
+		for (uint32_t Frame = 0; Frame < mSettings.Frames; ++Frame)
+		{
+			StandIn.Reset();
+			Filter.Invalidate();
+
+			auto Start = Clock::now();
+			Replay(Calls, CommandList);
+			Milliseconds += MillisecondsSince(Start);
+
+			RecordedCalls += StandIn.GetTotalCallCount();
+		}
+
+		StateFilterBenchmarkResult Result;
+		Result.DrawCount = DrawCount;
+		Result.RedundantFraction = RedundantFraction;
+		Result.Mode = bFiltered ? "Filtered" : "Raw";
+		Result.MillisecondsPerFrame = Milliseconds / mSettings.Frames;
+		Result.NanosecondsPerCall = Milliseconds * 1000000.0 / (static_cast<double>(Calls.size()) * mSettings.Frames);
+		Result.Calls = static_cast<uint32_t>(Calls.size());
+		Result.RecordedCalls = static_cast<uint32_t>(RecordedCalls / mSettings.Frames);
+		mResults.push_back(Result);
+	}
+
+	for (uint32_t Type = 0; Type < static_cast<uint32_t>(RenderCommandType::Count); ++Type)
+	{
+		StateFilterBenchmarkFiltered Entry;
+		Entry.DrawCount = DrawCount;
+		Entry.RedundantFraction = RedundantFraction;
+		Entry.Type = static_cast<RenderCommandType>(Type);
+		Entry.Calls = static_cast<uint32_t>(Filter.GetCallCount(Entry.Type) / mSettings.Frames);
+		Entry.Filtered = static_cast<uint32_t>(Filter.GetFilteredCount(Entry.Type) / mSettings.Frames);
+		mFiltered.push_back(Entry);
+	}
+	return true;
+}
+
+bool StateFilterBenchmark::WriteReport(const char* Filename) const
+{
+	FILE* File = fopen(Filename, "w");
+	if (!File)
+	{
+		return false;
+	}
+
+	fprintf(File, "Frames:          %u\n", mSettings.Frames);
+	fprintf(File, "Pass length:     %u\n", mSettings.PassLength);
+	fprintf(File, "Pipeline states: %u\n", mSettings.PipelineStateCount);
+	fprintf(File, "Root signatures: %u\n", mSettings.RootSignatureCount);
+	fprintf(File, "Materials:       %u\n", mSettings.MaterialCount);
+	fprintf(File, "Meshes:          %u\n\n", mSettings.MeshCount);
+
+	fprintf(File, "Draws,Redundant,Mode,MsPerFrame,NsPerCall,Calls,RecordedCalls\n");
+	for (const StateFilterBenchmarkResult& Result : mResults)
+	{
+		fprintf(File, "%u,%.2f,%s,%.3f,%.2f,%u,%u\n", Result.DrawCount, Result.RedundantFraction, Result.Mode.c_str(),
+			Result.MillisecondsPerFrame, Result.NanosecondsPerCall, Result.Calls, Result.RecordedCalls);
+	}
+
+	fprintf(File, "\nDraws,Redundant,Call,Calls,Filtered\n");
+	for (const StateFilterBenchmarkFiltered& Entry : mFiltered)
+	{
+		fprintf(File, "%u,%.2f,%s,%u,%u\n", Entry.DrawCount, Entry.RedundantFraction, GetRenderCommandName(Entry.Type),
+			Entry.Calls, Entry.Filtered);
+	}
+
+	fclose(File);
+	return true;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "RenderCommandList.h"
+
+//Cost of StateFilteringCommandList against calling a stand-in command list
+//directly, for each of DrawCounts draws with each of RedundantFractions.
+//
+//Every draw sets its root signature, pipeline state, material table,
+//instance data and mesh, each repeating the draw before's with the redundant
+//fraction's probability; every PassLength draws set render targets and a
+//viewport the same way. The calls are generated up front and replayed each
+//frame, so both modes time only the recording.
+//Run() fails if any draw sees different state through the filter.
+struct StateFilterBenchmarkSettings
+{
+	std::vector<uint32_t> DrawCounts = { 10000, 100000 };
+	std::vector<float> RedundantFractions = { 0.0f, 0.5f, 0.9f };
+	uint32_t Frames = 20;
+	uint32_t PassLength = 1000;
+	uint32_t PipelineStateCount = 64;
+	uint32_t RootSignatureCount = 8;
+	uint32_t MaterialCount = 1024;
+	uint32_t MeshCount = 256;
+};
+
+struct StateFilterBenchmarkResult
+{
+	uint32_t DrawCount = 0;
+	float RedundantFraction = 0.0f;
+	std::string Mode;
+	double MillisecondsPerFrame = 0.0;
+	double NanosecondsPerCall = 0.0;
+	uint32_t Calls = 0;				//Per frame, made by the renderer
+	uint32_t RecordedCalls = 0;		//Reaching the stand-in
+};
+
+//Per call type, per frame
+struct StateFilterBenchmarkFiltered
+{
+	uint32_t DrawCount = 0;
+	float RedundantFraction = 0.0f;
+	RenderCommandType Type = RenderCommandType::Count;
+	uint32_t Calls = 0;
+	uint32_t Filtered = 0;
+};
+
+class StateFilterBenchmark
+{
+public:
+	StateFilterBenchmark(const StateFilterBenchmarkSettings& Settings);
+	~StateFilterBenchmark();
+
+	bool Run();
+	bool WriteReport(const char* Filename) const;
+
+	const std::string& GetLastError() const { return mLastError; }
+
+private:
+	bool RunDrawCount(uint32_t DrawCount, float RedundantFraction);
+
+private:
+	StateFilterBenchmarkSettings mSettings;
+	std::vector<StateFilterBenchmarkResult> mResults;
+	std::vector<StateFilterBenchmarkFiltered> mFiltered;
+
+	std::string mLastError;
+};
@@ -0,0 +1,79 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "StateFilterBenchmark.h"
+
+//Redundant state filtering benchmark:
+//	StateFilterBenchmark [-frames N] [-draws N ...] [-redundant F ...] [-passlength N] [-states N] [-rootsignatures N] [-materials N] [-meshes N]
+//Writes StateFilterBenchmark.txt to the current directory.
+int main(int argc, char** argv)
+{
+	StateFilterBenchmarkSettings Settings;
+	bool bCustomDraws = false;
+	bool bCustomRedundant = false;
+	bool bValid = true;
+	for (int i = 1; i < argc && bValid; ++i)
+	{
+		if (strcmp(argv[i], "-frames") == 0 && i + 1 < argc)
+		{
+			Settings.Frames = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-draws") == 0 && i + 1 < argc)
+		{
+			if (!bCustomDraws)
+			{
+				Settings.DrawCounts.clear();
+				bCustomDraws = true;
+			}
+			Settings.DrawCounts.push_back(static_cast<uint32_t>(atoi(argv[++i])));
+		}
+		else if (strcmp(argv[i], "-redundant") == 0 && i + 1 < argc)
+		{
+			if (!bCustomRedundant)
+			{
+				Settings.RedundantFractions.clear();
+				bCustomRedundant = true;
+			}
+			Settings.RedundantFractions.push_back(static_cast<float>(atof(argv[++i])));
+		}
+		else if (strcmp(argv[i], "-passlength") == 0 && i + 1 < argc)
+		{
+			Settings.PassLength = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-states") == 0 && i + 1 < argc)
+		{
+			Settings.PipelineStateCount = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-rootsignatures") == 0 && i + 1 < argc)
+		{
+			Settings.RootSignatureCount = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-materials") == 0 && i + 1 < argc)
+		{
+			Settings.MaterialCount = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-meshes") == 0 && i + 1 < argc)
+		{
+			Settings.MeshCount = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else
+		{
+			bValid = false;
+		}
+	}
+
+	if (!bValid || Settings.Frames == 0)
+	{
+		fprintf(stderr, "Usage: StateFilterBenchmark [-frames N] [-draws N ...] [-redundant F ...] [-passlength N] [-states N] [-rootsignatures N] [-materials N] [-meshes N]\n");
+		return 1;
+	}
+
+	StateFilterBenchmark Benchmark(Settings);
+	if (!Benchmark.Run())
+	{
+		fprintf(stderr, "%s\n", Benchmark.GetLastError().c_str());
+		return 1;
+	}
+	return Benchmark.WriteReport("StateFilterBenchmark.txt") ? 0 : 1;
+}
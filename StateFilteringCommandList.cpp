@@ -0,0 +1,144 @@
+#include "StateFilteringCommandList.h"
+#include "Common.h"
+
+#include <string.h>
+
+StateFilteringCommandList::StateFilteringCommandList(IRenderCommandList* Target)
+	: mTarget(Target)
+{
+	Assert(mTarget);
+	Invalidate();
+	ResetStats();
+}
+
+StateFilteringCommandList::~StateFilteringCommandList()
+{}
+
+void StateFilteringCommandList::Invalidate()
+{
+	mPipelineState = 0;
+	mRootSignature = 0;
+	mMesh = 0;
+	mPipelineStateBound = false;
+	mRootSignatureBound = false;
+	mMeshBound = false;
+	mViewportBound = false;
+	mRenderTargetsBound = false;
+	memset(mRootArgumentTypes, RootArgument_Unset, sizeof(mRootArgumentTypes));
+}
+
+void StateFilteringCommandList::ResetStats()
+{
+	memset(mCallCounts, 0, sizeof(mCallCounts));
+	memset(mFilteredCounts, 0, sizeof(mFilteredCounts));
+}
+
+void StateFilteringCommandList::SetPipelineState(uint32_t PipelineState)
+{
+	if (!Filter(RenderCommandType::SetPipelineState, mPipelineStateBound && PipelineState == mPipelineState))
+	{
+		mPipelineState = PipelineState;
+		mPipelineStateBound = true;
+		mTarget->SetPipelineState(PipelineState);
+	}
+}
+
+void StateFilteringCommandList::SetGraphicsRootSignature(uint32_t RootSignature)
+{
+	if (!Filter(RenderCommandType::SetRootSignature, mRootSignatureBound && RootSignature == mRootSignature))
+	{
+		mRootSignature = RootSignature;
+		mRootSignatureBound = true;
+		memset(mRootArgumentTypes, RootArgument_Unset, sizeof(mRootArgumentTypes));
+		mTarget->SetGraphicsRootSignature(RootSignature);
+	}
+}
+
+void StateFilteringCommandList::SetRootArgument(RenderCommandType Type, uint32_t RootParameter, uint64_t Value)
+{
+	Assert(RootParameter < MaxRootParameters);
+	uint8_t ArgumentType = Type == RenderCommandType::SetDescriptorTable ? RootArgument_Table : RootArgument_ShaderResourceView;
+
+	bool bRedundant = mRootArgumentTypes[RootParameter] == ArgumentType && mRootArguments[RootParameter] == Value;
+	if (!Filter(Type, bRedundant))
+	{
+		mRootArgumentTypes[RootParameter] = ArgumentType;
+		mRootArguments[RootParameter] = Value;
+		if (Type == RenderCommandType::SetDescriptorTable)
+		{
+			mTarget->SetGraphicsRootDescriptorTable(RootParameter, static_cast<uint32_t>(Value));
+		}
+		else
+		{
+			mTarget->SetGraphicsRootShaderResourceView(RootParameter, Value);
+		}
+	}
+}
+
+void StateFilteringCommandList::SetGraphicsRootDescriptorTable(uint32_t RootParameter, uint32_t Table)
+{
+	SetRootArgument(RenderCommandType::SetDescriptorTable, RootParameter, Table);
+}
+
+void StateFilteringCommandList::SetGraphicsRootShaderResourceView(uint32_t RootParameter, uint64_t GpuAddress)
+{
+	SetRootArgument(RenderCommandType::SetRootShaderResourceView, RootParameter, GpuAddress);
+}
+
+void StateFilteringCommandList::SetMesh(uint32_t Mesh)
+{
+	if (!Filter(RenderCommandType::SetMesh, mMeshBound && Mesh == mMesh))
+	{
+		mMesh = Mesh;
+		mMeshBound = true;
+		mTarget->SetMesh(Mesh);
+	}
+}
+
+void StateFilteringCommandList::SetViewport(const RenderViewport& Viewport)
+{
+	if (!Filter(RenderCommandType::SetViewport, mViewportBound && memcmp(&Viewport, &mViewport, sizeof(Viewport)) == 0))
+	{
+		mViewport = Viewport;
+		mViewportBound = true;
+		mTarget->SetViewport(Viewport);
+	}
+}
+
+void StateFilteringCommandList::SetRenderTargets(uint32_t Count, const uint64_t* RenderTargets, uint64_t DepthStencil)
+{
+	Assert(Count <= MaxRenderTargets);
+	bool bRedundant = mRenderTargetsBound && Count == mRenderTargetCount && DepthStencil == mDepthStencil &&
+		(Count == 0 || memcmp(RenderTargets, mRenderTargets, Count * sizeof(uint64_t)) == 0);
+	if (!Filter(RenderCommandType::SetRenderTargets, bRedundant))
+	{
+		mRenderTargetCount = Count;
+		if (Count > 0)
+		{
+			memcpy(mRenderTargets, RenderTargets, Count * sizeof(uint64_t));
+		}
+		mDepthStencil = DepthStencil;
+		mRenderTargetsBound = true;
+		mTarget->SetRenderTargets(Count, RenderTargets, DepthStencil);
+	}
+}
+
+void StateFilteringCommandList::DrawIndexedInstanced(uint32_t IndexCountPerInstance, uint32_t InstanceCount, uint32_t StartIndexLocation,
+	int32_t BaseVertexLocation, uint32_t StartInstanceLocation)
+{
+	Filter(RenderCommandType::DrawIndexedInstanced, false);
+	mTarget->DrawIndexedInstanced(IndexCountPerInstance, InstanceCount, StartIndexLocation, BaseVertexLocation, StartInstanceLocation);
+}
+
+void StateFilteringCommandList::ResourceBarrier(uint32_t Resource, RenderResourceState Before, RenderResourceState After)
+{
+	Filter(RenderCommandType::ResourceBarrier, false);
+	mTarget->ResourceBarrier(Resource, Before, After);
+}
+
+void StateFilteringCommandList::CopyBufferRegion(uint32_t Destination, uint64_t DestinationOffset, uint32_t Source, uint64_t SourceOffset,
+	uint64_t Size)
+{
+	Filter(RenderCommandType::CopyBufferRegion, false);
+	mTarget->CopyBufferRegion(Destination, DestinationOffset, Source, SourceOffset, Size);
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+
+#include "RenderCommandList.h"
+
+//Passes calls on to another IRenderCommandList, dropping any that would set
+//state to what's already bound. Draws, barriers and copies always go through.
+//
+//Changing the root signature leaves every root argument unset, as it does on
+//the GPU; setting the same one again keeps them. Nothing is known to be bound
+//after Invalidate(), which must follow every reset of the target list since
+//that resets its state.
+class StateFilteringCommandList : public IRenderCommandList
+{
+public:
+	static const uint32_t MaxRootParameters = 32;
+
+	StateFilteringCommandList(IRenderCommandList* Target);
+	~StateFilteringCommandList();
+
+	void Invalidate();
+
+	void SetPipelineState(uint32_t PipelineState) override;
+	void SetGraphicsRootSignature(uint32_t RootSignature) override;
+	void SetGraphicsRootDescriptorTable(uint32_t RootParameter, uint32_t Table) override;
+	void SetGraphicsRootShaderResourceView(uint32_t RootParameter, uint64_t GpuAddress) override;
+	void SetMesh(uint32_t Mesh) override;
+	void SetViewport(const RenderViewport& Viewport) override;
+	void SetRenderTargets(uint32_t Count, const uint64_t* RenderTargets, uint64_t DepthStencil) override;
+	void DrawIndexedInstanced(uint32_t IndexCountPerInstance, uint32_t InstanceCount, uint32_t StartIndexLocation,
+		int32_t BaseVertexLocation, uint32_t StartInstanceLocation) override;
+	void ResourceBarrier(uint32_t Resource, RenderResourceState Before, RenderResourceState After) override;
+	void CopyBufferRegion(uint32_t Destination, uint64_t DestinationOffset, uint32_t Source, uint64_t SourceOffset,
+		uint64_t Size) override;
+
+	//Calls made on the wrapper, and how many of them were dropped
+	uint64_t GetCallCount(RenderCommandType Type) const { return mCallCounts[static_cast<uint32_t>(Type)]; }
+	uint64_t GetFilteredCount(RenderCommandType Type) const { return mFilteredCounts[static_cast<uint32_t>(Type)]; }
+	void ResetStats();
+
+	IRenderCommandList* GetTarget() const { return mTarget; }
+
+private:
+	//Counts the call, and whether it's dropped
+	bool Filter(RenderCommandType Type, bool bRedundant)
+	{
+		++mCallCounts[static_cast<uint32_t>(Type)];
+		mFilteredCounts[static_cast<uint32_t>(Type)] += bRedundant ? 1 : 0;
+		return bRedundant;
+	}
+
+	void SetRootArgument(RenderCommandType Type, uint32_t RootParameter, uint64_t Value);
+
+private:
+	enum RootArgument
+	{
+		RootArgument_Unset,
+		RootArgument_Table,
+		RootArgument_ShaderResourceView
+	};
+
+	IRenderCommandList* mTarget;
+
+	//Bound state, each with a flag for whether it's known
+	uint32_t mPipelineState;
+	uint32_t mRootSignature;
+	uint32_t mMesh;
+	bool mPipelineStateBound;
+	bool mRootSignatureBound;
+	bool mMeshBound;
+	bool mViewportBound;
+	bool mRenderTargetsBound;
+
+	uint8_t mRootArgumentTypes[MaxRootParameters];
+	uint64_t mRootArguments[MaxRootParameters];
+
+	RenderViewport mViewport;
+	uint32_t mRenderTargetCount;
+	uint64_t mRenderTargets[MaxRenderTargets];
+	uint64_t mDepthStencil;
+
+	uint64_t mCallCounts[static_cast<uint32_t>(RenderCommandType::Count)];
+	uint64_t mFilteredCounts[static_cast<uint32_t>(RenderCommandType::Count)];
+};
@@ -0,0 +1,419 @@
+#include "StaticCacheBenchmark.h"
+#include "Common.h"
+#include "DrawQueue.h"
+#include "InstanceBatcher.h"
+#include "RenderCommandStream.h"
+#include "SimulatedFence.h"
+#include "StandInCommandList.h"
+#include "StaticCommandCache.h"
+#include "UploadRing.h"
+#include "VectorMath.h"
+
+#include <chrono>
+#include <random>
+#include <stdio.h>
+#include <string.h>
+
+namespace
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	double MillisecondsSince(Clock::time_point Start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - Start).count();
+	}
+
+	const uint32_t OpaquePass = 0;
+	const uint32_t TransparentPass = 1;
+
+	const float WorldSize = 1000.0f;
+	const uint64_t FrameRingGpuAddress = 0x100000000ull;
+	const uint64_t StaticRingGpuAddress = 0x200000000ull;
+
+	struct SceneDraw
+	{
+		DrawPacket Packet;
+		Float3 Position;
+		bool bStatic;
+	};
+
+	enum class SceneSubset
+	{
+		All,
+		Static,
+		Dynamic
+	};
+
+	std::vector<SceneDraw> MakeScene(const StaticCacheBenchmarkSettings& Settings, uint32_t DrawCount)
+	{
+		std::mt19937 Random(1234);
+		std::uniform_real_distribution<float> Position(-WorldSize, WorldSize);
+		std::uniform_real_distribution<float> Unit(0.0f, 1.0f);
+		std::uniform_int_distribution<uint32_t> Material(0, Settings.MaterialCount - 1);
+		std::uniform_int_distribution<uint32_t> Mesh(0, Settings.MeshCount - 1);
+		std::uniform_int_distribution<uint32_t> Prototype(0, Settings.PrototypeCount - 1);
+
+		uint32_t StatesPerRootSignature = (Settings.PipelineStateCount + Settings.RootSignatureCount - 1) / Settings.RootSignatureCount;
+
+		std::vector<DrawPacket> Prototypes(Settings.PrototypeCount);
+		for (DrawPacket& Packet : Prototypes)
+		{
+			Packet = DrawPacket();
+			Packet.Pass = Unit(Random) < Settings.TransparentFraction ? TransparentPass : OpaquePass;
+			Packet.Material = Material(Random);
+			Packet.PipelineState = Packet.Material % Settings.PipelineStateCount;
+			Packet.RootSignature = Packet.PipelineState / StatesPerRootSignature;
+			Packet.Mesh = Mesh(Random);
+		}
+
+		std::vector<SceneDraw> Scene(DrawCount);
+		for (uint32_t i = 0; i < DrawCount; ++i)
+		{
+			Scene[i].Packet = Prototypes[Prototype(Random)];
+			Scene[i].Packet.Instance = i;
+			Scene[i].Position = MakeFloat3(Position(Random), Position(Random), Position(Random));
+			Scene[i].bStatic = Scene[i].Packet.Pass == OpaquePass && Unit(Random) < Settings.StaticFraction;
+		}
+		return Scene;
+	}
+
+	//Moves a slice of the static draws to the next material, as a material
+	//swap or a streamed in texture set would
+	void Rebind(const StaticCacheBenchmarkSettings& Settings, uint32_t Slice, std::vector<SceneDraw>& Scene)
+	{
+		uint32_t StatesPerRootSignature = (Settings.PipelineStateCount + Settings.RootSignatureCount - 1) / Settings.RootSignatureCount;
+		for (SceneDraw& Draw : Scene)
+		{
+			if (Draw.bStatic && Draw.Packet.Mesh % 8 == Slice % 8)
+			{
+				Draw.Packet.Material = (Draw.Packet.Material + 1) % Settings.MaterialCount;
+				Draw.Packet.PipelineState = Draw.Packet.Material % Settings.PipelineStateCount;
+				Draw.Packet.RootSignature = Draw.Packet.PipelineState / StatesPerRootSignature;
+			}
+		}
+	}
+
+	void FillQueue(const std::vector<SceneDraw>& Scene, SceneSubset Subset, uint32_t Frame, uint32_t FrameCount, DrawQueue& Queue)
+	{
+		float Angle = 6.2831853f * static_cast<float>(Frame) / static_cast<float>(FrameCount);
+		Float3 Eye = MakeFloat3(sinf(Angle) * WorldSize, 0.0f, cosf(Angle) * WorldSize);
+
+		Queue.Clear();
+		for (const SceneDraw& Draw : Scene)
+		{
+			if ((Subset == SceneSubset::Static && !Draw.bStatic) || (Subset == SceneSubset::Dynamic && Draw.bStatic))
+			{
+				continue;
+			}
+			DrawPacket Packet = Draw.Packet;
+			Packet.Depth = Length(Draw.Position - Eye);
+			Queue.Add(Packet, Packet.Pass == TransparentPass ? DrawSortMode::Transparent : DrawSortMode::Opaque);
+		}
+	}
+
+	struct RingView
+	{
+		uint64_t GpuAddress;
+		const uint8_t* Memory;
+		uint64_t Size;
+	};
+
+	//Plays the part of the GPU: reads back each instance a draw uses, from
+	//whichever ring it's in, and checks it against the state bound
+	class VerifyingCommandList : public IRenderCommandList
+	{
+	public:
+		VerifyingCommandList(const std::vector<SceneDraw>& Scene, const MeshDrawArgs* Meshes, const RingView* Rings, uint32_t RingCount,
+			uint32_t Stride)
+			: mScene(Scene), mMeshes(Meshes), mRings(Rings), mRingCount(RingCount), mStride(Stride)
+			, mPipelineState(~0u), mRootSignature(~0u), mTable(~0u), mMesh(~0u), mInstanceData(0), mErrors(0)
+			, mDrawn(Scene.size(), 0)
+		{}
+
+		void SetPipelineState(uint32_t PipelineState) override { mPipelineState = PipelineState; }
+		void SetGraphicsRootSignature(uint32_t RootSignature) override
+		{
+			mRootSignature = RootSignature;
+			mTable = ~0u;
+			mInstanceData = 0;
+		}
+		void SetGraphicsRootDescriptorTable(uint32_t, uint32_t Table) override { mTable = Table; }
+		void SetGraphicsRootShaderResourceView(uint32_t, uint64_t GpuAddress) override { mInstanceData = GpuAddress; }
+		void SetMesh(uint32_t Mesh) override { mMesh = Mesh; }
+		void SetViewport(const RenderViewport&) override {}
+		void SetRenderTargets(uint32_t, const uint64_t*, uint64_t) override {}
+		void ResourceBarrier(uint32_t, RenderResourceState, RenderResourceState) override {}
+		void CopyBufferRegion(uint32_t, uint64_t, uint32_t, uint64_t, uint64_t) override {}
+
+		void DrawIndexedInstanced(uint32_t IndexCountPerInstance, uint32_t InstanceCount, uint32_t StartIndexLocation,
+			int32_t BaseVertexLocation, uint32_t) override
+		{
+			const uint8_t* Instances = Find(mInstanceData, static_cast<uint64_t>(InstanceCount) * mStride);
+			const MeshDrawArgs& Args = mMeshes[mMesh];
+			bool bValid = Instances && IndexCountPerInstance == Args.IndexCount && StartIndexLocation == Args.StartIndex &&
+				BaseVertexLocation == Args.BaseVertex;
+			for (uint32_t i = 0; i < InstanceCount && bValid; ++i)
+			{
+				uint32_t Id;
+				memcpy(&Id, Instances + static_cast<size_t>(i) * mStride, sizeof(Id));
+				bValid = Id < mScene.size() && mDrawn[Id] == 0;
+				if (bValid)
+				{
+					const DrawPacket& Packet = mScene[Id].Packet;
+					bValid = Packet.Mesh == mMesh && Packet.Material == mTable && Packet.PipelineState == mPipelineState &&
+						Packet.RootSignature == mRootSignature;
+					mDrawn[Id] = 1;
+				}
+			}
+			mErrors += bValid ? 0 : 1;
+		}
+
+		bool Finish()
+		{
+			for (uint8_t bDrawn : mDrawn)
+			{
+				mErrors += bDrawn ? 0 : 1;
+			}
+			return mErrors == 0;
+		}
+
+	private:
+		const uint8_t* Find(uint64_t GpuAddress, uint64_t Size) const
+		{
+			for (uint32_t i = 0; i < mRingCount; ++i)
+			{
+				const RingView& Ring = mRings[i];
+				if (GpuAddress >= Ring.GpuAddress && GpuAddress - Ring.GpuAddress <= Ring.Size &&
+					Size <= Ring.Size - (GpuAddress - Ring.GpuAddress))
+				{
+					return Ring.Memory + (GpuAddress - Ring.GpuAddress);
+				}
+			}
+			return nullptr;
+		}
+
+	private:
+		const std::vector<SceneDraw>& mScene;
+		const MeshDrawArgs* mMeshes;
+		const RingView* mRings;
+		uint32_t mRingCount;
+		uint32_t mStride;
+
+		uint32_t mPipelineState;
+		uint32_t mRootSignature;
+		uint32_t mTable;
+		uint32_t mMesh;
+		uint64_t mInstanceData;
+		uint32_t mErrors;
+
+		std::vector<uint8_t> mDrawn;
+	};
+}
+
+StaticCacheBenchmark::StaticCacheBenchmark(const StaticCacheBenchmarkSettings& Settings)
+	: mSettings(Settings)
+{
+	Assert(mSettings.Frames > 0);
+}
+
+StaticCacheBenchmark::~StaticCacheBenchmark()
+{}
+
+bool StaticCacheBenchmark::Run()
+{
+	mResults.clear();
+	if (mSettings.PipelineStateCount == 0 || mSettings.PipelineStateCount > (1u << DrawSortPipelineStateBits) ||
+		mSettings.MaterialCount == 0 || mSettings.MaterialCount > (1u << DrawSortMaterialBits) ||
+		mSettings.RootSignatureCount == 0 || mSettings.RootSignatureCount > mSettings.PipelineStateCount ||
+		mSettings.MeshCount == 0 || mSettings.PrototypeCount == 0 || mSettings.RebindInterval == 0)
+	{
+		mLastError = "Pipeline state, root signature, material, mesh and prototype counts and the rebind interval must be above 0 and fit the sort key";
+		return false;
+	}
+	if (mSettings.InstanceDataStride < sizeof(uint32_t) || (mSettings.InstanceDataStride & 3) != 0)
+	{
+		mLastError = "Instance data stride must be a multiple of 4 bytes";
+		return false;
+	}
+
+	for (uint32_t DrawCount : mSettings.DrawCounts)
+	{
+		if (DrawCount == 0 || !RunDrawCount(DrawCount))
+		{
+			if (mLastError.empty())
+			{
+				mLastError = "Draw counts must be above 0";
+			}
+			return false;
+		}
+	}
+	return true;
+}
+
+bool StaticCacheBenchmark::RunDrawCount(uint32_t DrawCount)
+{
+	const std::vector<SceneDraw> StartScene = MakeScene(mSettings, DrawCount);
+
+	std::vector<MeshDrawArgs> Meshes(mSettings.MeshCount);
+	uint32_t StartIndex = 0;
+	for (uint32_t Mesh = 0; Mesh < mSettings.MeshCount; ++Mesh)
+	{
+		Meshes[Mesh].IndexCount = 36 + 6 * (Mesh % 64);
+		Meshes[Mesh].StartIndex = StartIndex;
+		Meshes[Mesh].BaseVertex = static_cast<int32_t>(Mesh * 1024);
+		StartIndex += Meshes[Mesh].IndexCount;
+	}
+
+	//Each object's data starts with its id, for verification
+	const uint32_t Stride = mSettings.InstanceDataStride;
+	std::vector<uint8_t> InstanceData(static_cast<size_t>(DrawCount) * Stride);
+	for (uint32_t i = 0; i < DrawCount; ++i)
+	{
+		uint8_t* Data = &InstanceData[static_cast<size_t>(i) * Stride];
+		memset(Data, static_cast<int>(i & 0xFF), Stride);
+		memcpy(Data, &i, sizeof(i));
+	}
+
+	//Three frames in flight, and two versions of the cache
+	const uint64_t AllBytes = static_cast<uint64_t>(DrawCount) * Stride + UploadRing::DefaultAlignment;
+	std::vector<uint8_t> FrameRingMemory(static_cast<size_t>(AllBytes * 3));
+	std::vector<uint8_t> StaticRingMemory(static_cast<size_t>(AllBytes * 2));
+	const RingView Rings[] =
+	{
+		{ FrameRingGpuAddress, FrameRingMemory.data(), FrameRingMemory.size() },
+		{ StaticRingGpuAddress, StaticRingMemory.data(), StaticRingMemory.size() }
+	};
+
+	InstanceBatcherSettings BatcherSettings;
+	BatcherSettings.InstanceDataStride = Stride;
+
+	DrawQueue Queue;
+	Queue.Reserve(DrawCount);
+
+	StandInCommandListLimits Limits;
+	Limits.MeshCount = mSettings.MeshCount;
+	StandInCommandList StandIn(Limits);
+
+	const char* Modes[] = { "Uncached", "Cached", "Cached rebinding" };
+	for (uint32_t Mode = 0; Mode < 3; ++Mode)
+	{
+		const bool bCached = Mode > 0;
+		const bool bRebinding = Mode == 2;
+		std::vector<SceneDraw> Scene = StartScene;
+
+		SimulatedFence Fence;
+		UploadRing FrameRing(&Fence, FrameRingMemory.data(), FrameRingGpuAddress, FrameRingMemory.size());
+		UploadRing StaticRing(&Fence, StaticRingMemory.data(), StaticRingGpuAddress, StaticRingMemory.size());
+		InstanceBatcher Batcher(BatcherSettings);
+		StaticCommandCache Cache(BatcherSettings, &StaticRing);
+
+		RenderCommandArena Arena;
+		RenderCommandStream FrameStream(&Arena);
+
+		StaticCacheBenchmarkResult Result;
+		Result.DrawCount = DrawCount;
+		Result.Mode = bRebinding ? std::string(Modes[Mode]) + " every " + std::to_string(mSettings.RebindInterval) : Modes[Mode];
+
+		uint64_t BindingVersion = 0;
+		uint64_t CommandsRecorded = 0;
+		for (uint32_t Frame = 0; Frame < mSettings.Frames; ++Frame)
+		{
+			if (bRebinding && Frame > 0 && Frame % mSettings.RebindInterval == 0)
+			{
+				Rebind(mSettings, Frame / mSettings.RebindInterval, Scene);
+				++BindingVersion;
+			}
+			const bool bRecordsCache = bCached && !Cache.IsValid(BindingVersion);
+
+			FrameStream.Reset();
+			Arena.Reset();
+
+			auto Start = Clock::now();
+			if (bRecordsCache)
+			{
+				FillQueue(Scene, SceneSubset::Static, Frame, mSettings.Frames, Queue);
+				Queue.Sort();
+				Cache.Record(BindingVersion, Queue.GetDraws(), Queue.GetCount(), Meshes.data(), InstanceData.data());
+			}
+			FillQueue(Scene, bCached ? SceneSubset::Dynamic : SceneSubset::All, Frame, mSettings.Frames, Queue);
+			Queue.Sort();
+			Batcher.Record(Queue.GetDraws(), Queue.GetCount(), Meshes.data(), InstanceData.data(), FrameRing, FrameStream);
+			Result.RecordMilliseconds += MillisecondsSince(Start);
+			CommandsRecorded += FrameStream.GetCommandCount();
+
+			StandIn.Reset();
+			Start = Clock::now();
+			if (bCached)
+			{
+				Cache.Execute(StandIn);
+			}
+			FrameStream.Replay(StandIn);
+			Result.SubmitMilliseconds += MillisecondsSince(Start);
+
+			//Whenever something new was recorded
+			if (Frame == 0 || bRecordsCache)
+			{
+				VerifyingCommandList Verifier(Scene, Meshes.data(), Rings, 2, Stride);
+				if (bCached)
+				{
+					Cache.Execute(Verifier);
+				}
+				FrameStream.Replay(Verifier);
+				if (!Verifier.Finish())
+				{
+					char Error[128];
+					snprintf(Error, sizeof(Error), "Frame %u of %s with %u draws doesn't draw every object once with its own state",
+						Frame, Result.Mode.c_str(), DrawCount);
+					mLastError = Error;
+					return false;
+				}
+			}
+
+			//The GPU finishes each frame as the next is recorded
+			FrameRing.EndFrame();
+			Fence.Signal();
+			Fence.AdvanceTo(Fence.GetLastSignalledValue() - 1);
+		}
+
+		if (bCached && Cache.GetRecordCount() != 1 + BindingVersion)
+		{
+			mLastError = "The cache re-recorded without its key changing";
+			return false;
+		}
+
+		Result.RecordMilliseconds /= mSettings.Frames;
+		Result.SubmitMilliseconds /= mSettings.Frames;
+		Result.CommandsRecorded = static_cast<uint32_t>(CommandsRecorded / mSettings.Frames);
+		Result.CacheRecords = Cache.GetRecordCount();
+		Result.RingStalls = FrameRing.GetStallCount() + StaticRing.GetStallCount();
+		mResults.push_back(Result);
+	}
+	return true;
+}
+
+bool StaticCacheBenchmark::WriteReport(const char* Filename) const
+{
+	FILE* File = fopen(Filename, "w");
+	if (!File)
+	{
+		return false;
+	}
+
+	fprintf(File, "Frames:          %u\n", mSettings.Frames);
+	fprintf(File, "Prototypes:      %u\n", mSettings.PrototypeCount);
+	fprintf(File, "Pipeline states: %u\n", mSettings.PipelineStateCount);
+	fprintf(File, "Materials:       %u\n", mSettings.MaterialCount);
+	fprintf(File, "Meshes:          %u\n", mSettings.MeshCount);
+	fprintf(File, "Static:          %.0f%% of opaque\n", mSettings.StaticFraction * 100.0f);
+	fprintf(File, "Transparent:     %.0f%%\n\n", mSettings.TransparentFraction * 100.0f);
+
+	fprintf(File, "Draws,Mode,RecordMsPerFrame,SubmitMsPerFrame,CommandsRecordedPerFrame,CacheRecords,RingStalls\n");
+	for (const StaticCacheBenchmarkResult& Result : mResults)
+	{
+		fprintf(File, "%u,%s,%.3f,%.3f,%u,%u,%llu\n", Result.DrawCount, Result.Mode.c_str(), Result.RecordMilliseconds,
+			Result.SubmitMilliseconds, Result.CommandsRecorded, Result.CacheRecords, static_cast<unsigned long long>(Result.RingStalls));
+	}
+
+	fclose(File);
+	return true;
+}
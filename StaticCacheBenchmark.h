@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//Per frame recording cost of a scene whose StaticFraction of opaque draws
+//never move, with and without a StaticCommandCache for them, for each of
+//DrawCounts draws.
+//
+//Uncached, every frame fills a DrawQueue with every draw, sorts it and
+//batches it with InstanceBatcher in to a command stream. Cached, the static
+//draws are only recorded when the cache's key changes; each frame records
+//the dynamic draws alone. The cached run is timed twice: with bindings that
+//never change, and with some static draws given new materials every
+//RebindInterval frames, which changes the key and re-records the cache.
+//Submitting - replaying the frame's streams, cached one first, in to a
+//recording stand-in - is timed on its own; on a device a D3D12StaticBundle
+//takes the cached part of that down to one ExecuteBundle.
+//Run() fails if any frame, read back, doesn't draw every object exactly once
+//with its current state and instance data.
+struct StaticCacheBenchmarkSettings
+{
+	std::vector<uint32_t> DrawCounts = { 10000, 100000 };
+	uint32_t Frames = 20;
+	uint32_t RebindInterval = 5;
+	uint32_t PrototypeCount = 2000;
+	uint32_t PipelineStateCount = 64;
+	uint32_t RootSignatureCount = 8;
+	uint32_t MaterialCount = 1024;
+	uint32_t MeshCount = 256;
+	uint32_t InstanceDataStride = 64;
+	float StaticFraction = 0.8f;
+	float TransparentFraction = 0.1f;
+};
+
+struct StaticCacheBenchmarkResult
+{
+	uint32_t DrawCount = 0;
+	std::string Mode;
+	double RecordMilliseconds = 0.0;	//Per frame
+	double SubmitMilliseconds = 0.0;
+	uint32_t CommandsRecorded = 0;		//Per frame, not counting re-records of the cache
+	uint32_t CacheRecords = 0;			//Whole run
+	uint64_t RingStalls = 0;
+};
+
+class StaticCacheBenchmark
+{
+public:
+	StaticCacheBenchmark(const StaticCacheBenchmarkSettings& Settings);
+	~StaticCacheBenchmark();
+
+	bool Run();
+	bool WriteReport(const char* Filename) const;
+
+	const std::string& GetLastError() const { return mLastError; }
+
+private:
+	bool RunDrawCount(uint32_t DrawCount);
+
+private:
+	StaticCacheBenchmarkSettings mSettings;
+	std::vector<StaticCacheBenchmarkResult> mResults;
+
+	std::string mLastError;
+};
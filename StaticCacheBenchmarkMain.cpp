@@ -0,0 +1,73 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "StaticCacheBenchmark.h"
+
+//Static command cache benchmark:
+//	StaticCacheBenchmark [-frames N] [-draws N ...] [-rebind N] [-prototypes N] [-materials N] [-meshes N] [-static F] [-transparent F]
+//Writes StaticCacheBenchmark.txt to the current directory.
+int main(int argc, char** argv)
+{
+	StaticCacheBenchmarkSettings Settings;
+	bool bCustomDraws = false;
+	bool bValid = true;
+	for (int i = 1; i < argc && bValid; ++i)
+	{
+		if (strcmp(argv[i], "-frames") == 0 && i + 1 < argc)
+		{
+			Settings.Frames = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-draws") == 0 && i + 1 < argc)
+		{
+			if (!bCustomDraws)
+			{
+				Settings.DrawCounts.clear();
+				bCustomDraws = true;
+			}
+			Settings.DrawCounts.push_back(static_cast<uint32_t>(atoi(argv[++i])));
+		}
+		else if (strcmp(argv[i], "-rebind") == 0 && i + 1 < argc)
+		{
+			Settings.RebindInterval = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-prototypes") == 0 && i + 1 < argc)
+		{
+			Settings.PrototypeCount = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-materials") == 0 && i + 1 < argc)
+		{
+			Settings.MaterialCount = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-meshes") == 0 && i + 1 < argc)
+		{
+			Settings.MeshCount = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-static") == 0 && i + 1 < argc)
+		{
+			Settings.StaticFraction = static_cast<float>(atof(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-transparent") == 0 && i + 1 < argc)
+		{
+			Settings.TransparentFraction = static_cast<float>(atof(argv[++i]));
+		}
+		else
+		{
+			bValid = false;
+		}
+	}
+
+	if (!bValid || Settings.Frames == 0)
+	{
+		fprintf(stderr, "Usage: StaticCacheBenchmark [-frames N] [-draws N ...] [-rebind N] [-prototypes N] [-materials N] [-meshes N] [-static F] [-transparent F]\n");
+		return 1;
+	}
+
+	StaticCacheBenchmark Benchmark(Settings);
+	if (!Benchmark.Run())
+	{
+		fprintf(stderr, "%s\n", Benchmark.GetLastError().c_str());
+		return 1;
+	}
+	return Benchmark.WriteReport("StaticCacheBenchmark.txt") ? 0 : 1;
+}
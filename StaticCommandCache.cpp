@@ -0,0 +1,43 @@
+#include "StaticCommandCache.h"
+#include "Common.h"
+#include "UploadRing.h"
+
+StaticCommandCache::StaticCommandCache(const InstanceBatcherSettings& Settings, UploadRing* InstanceRing)
+	: mBatcher(Settings)
+	, mInstanceRing(InstanceRing)
+	, mStream(&mArena)
+	, mKey(0)
+	, mValid(false)
+	, mRecordCount(0)
+{
+	Assert(mInstanceRing);
+}
+
+StaticCommandCache::~StaticCommandCache()
+{}
+
+void StaticCommandCache::Record(uint64_t Key, const DrawPacket* Draws, uint32_t Count, const MeshDrawArgs* Meshes,
+	const uint8_t* InstanceData)
+{
+	for (uint32_t i = 0; i < Count; ++i)
+	{
+		Check(Draws[i].SortMode == DrawSortMode::Opaque);
+	}
+
+	//The last version's instance data goes once the GPU is past what's been submitted so far
+	mInstanceRing->EndFrame();
+
+	mStream.Reset();
+	mArena.Reset();
+	mBatcher.Record(Draws, Count, Meshes, InstanceData, *mInstanceRing, mStream);
+
+	mKey = Key;
+	mValid = true;
+	++mRecordCount;
+}
+
+void StaticCommandCache::Execute(IRenderCommandList& Target) const
+{
+	Assert(mValid);
+	mStream.Replay(Target);
+}
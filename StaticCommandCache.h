@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+
+#include "DrawPacket.h"
+#include "InstanceBatcher.h"
+#include "RenderCommandStream.h"
+
+class UploadRing;
+
+//Draws of static geometry recorded once - batched by InstanceBatcher with
+//their instance data uploaded - in to a command stream of their own, then
+//executed every frame as they are until the static set or anything it binds
+//changes. Frames that only execute the cache skip filling, sorting and
+//batching those draws; a renderer submitting streams can hand the cached one
+//over as it is, and D3D12StaticBundle turns it in to a bundle.
+//
+//Key names what was recorded - e.g. the static set's version mixed with the
+//versions of the pipeline state, material and mesh tables it uses. The owner
+//changes it whenever any of them change, or calls Invalidate().
+//
+//Cached draws keep the order they were recorded in, so only opaque draws,
+//whose order is only a matter of speed, belong in one. Instance data lives
+//in InstanceRing for as long as it's cached; each Record() ends the ring's
+//frame first, so the previous version is recycled once the GPU is past every
+//frame that executed it. The ring should hold two versions, or re-recording
+//waits on the GPU.
+class StaticCommandCache
+{
+public:
+	StaticCommandCache(const InstanceBatcherSettings& Settings, UploadRing* InstanceRing);
+	~StaticCommandCache();
+
+	bool IsValid(uint64_t Key) const { return mValid && mKey == Key; }
+	bool IsRecorded() const { return mValid; }
+	void Invalidate() { mValid = false; }
+
+	//Opaque draws in key order, e.g. from a sorted DrawQueue
+	void Record(uint64_t Key, const DrawPacket* Draws, uint32_t Count, const MeshDrawArgs* Meshes, const uint8_t* InstanceData);
+
+	void Execute(IRenderCommandList& Target) const;
+
+	const RenderCommandStream& GetStream() const { return mStream; }
+
+	//Times Record() has run; D3D12StaticBundle re-records when this changes
+	uint32_t GetRecordCount() const { return mRecordCount; }
+	const InstanceBatcherStats& GetLastRecordStats() const { return mBatcher.GetLastStats(); }
+
+private:
+	StaticCommandCache(const StaticCommandCache&) = delete;
+	StaticCommandCache& operator=(const StaticCommandCache&) = delete;
+
+private:
+	InstanceBatcher mBatcher;
+	UploadRing* mInstanceRing;
+
+	//Never shared, so the cached pages are only reset by Record()
+	RenderCommandArena mArena;
+	RenderCommandStream mStream;
+
+	uint64_t mKey;
+	bool mValid;
+	uint32_t mRecordCount;
+};
@@ -1,4 +1,22 @@
 #include "TestScene.h"
+#include "PackedSceneBuilder.h"
+
+#include <cmath>
+
+namespace
+{
+	struct PositionComponent
+	{
+		float Position[3];
+	};
+
+	struct VelocityComponent
+	{
+		float Velocity[3];
+	};
+
+	const uint32_t TestEntityCount = 1024;
+}
 
 TestScene::TestScene()
 {}
@@ -6,9 +24,17 @@ TestScene::TestScene()
 TestScene::~TestScene()
 {}
 
-bool TestScene::OnInitScene()
+AsyncTask<bool> TestScene::OnInitScene()
 {
-	return true;
+	//A ring of particles drifting outwards
+	for (uint32_t i = 0; i < TestEntityCount; ++i)
+	{
+		float Angle = i * (6.2831853f / TestEntityCount);
+		PositionComponent Position = { { 0.0f, 0.0f, 0.0f } };
+		VelocityComponent Velocity = { { std::cos(Angle), 0.0f, std::sin(Angle) } };
+		mEntities.CreateEntity(Position, Velocity);
+	}
+	co_return true;
 }
 
 int TestScene::OnCloseScene()
@@ -18,10 +44,35 @@ int TestScene::OnCloseScene()
 
 void TestScene::OnUpdate(float dt)
 {
-
+	mEntities.ForEach<PositionComponent, VelocityComponent>([dt](PositionComponent& Position, const VelocityComponent& Velocity)
+	{
+		for (int Axis = 0; Axis < 3; ++Axis)
+		{
+			Position.Position[Axis] += Velocity.Velocity[Axis] * dt;
+		}
+	});
 }
 
 void TestScene::OnRender()
 {
 
-}
\ No newline at end of file
+}
+
+bool TestScene::OnSaveScene(PackedSceneBuilder& Builder) const
+{
+	//Particles are unparented points. Velocities have no place in the format
+	//so a loaded copy stands still.
+	Builder.Reserve(Builder.GetEntityCount() + mEntities.GetEntityCount());
+	mEntities.ForEach<PositionComponent>([&Builder](const PositionComponent& Position)
+	{
+		PackedSceneTransform Transform = {};
+		Transform.Rotation[3] = 1.0f;
+		for (int Axis = 0; Axis < 3; ++Axis)
+		{
+			Transform.Position[Axis] = Position.Position[Axis];
+		}
+		Transform.Scale = 1.0f;
+		Builder.AddEntity("Particle", PackedSceneNoParent, Transform);
+	});
+	return true;
+}
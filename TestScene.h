@@ -1,5 +1,6 @@
 #pragma once
 
+#include "EntityStore.h"
 #include "IScene.h"
 
 class TestScene : public IScene
@@ -8,9 +9,14 @@ public:
 	TestScene();
 	~TestScene();
 
-	bool OnInitScene() override;
+	AsyncTask<bool> OnInitScene() override;
 	int OnCloseScene() override;
 
 	void OnUpdate(float dt) override;
 	void OnRender() override;
-};
\ No newline at end of file
+
+	bool OnSaveScene(PackedSceneBuilder& Builder) const override;
+
+private:
+	EntityStore mEntities;
+};
@@ -0,0 +1,396 @@
+#include "TextureStreamer.h"
+#include "Common.h"
+
+#include <algorithm>
+#include <cmath>
+
+TextureStreamer::TextureStreamer(ITextureStreamingBackend* Backend, const TextureStreamerSettings& Settings)
+	: mBackend(Backend), mSettings(Settings), mFrameIndex(0),
+	mResidentBytes(0), mPendingBytes(0), mUploadsInFlight(0)
+{
+	Assert(mBackend);
+}
+
+TextureStreamer::~TextureStreamer()
+{}
+
+StreamedTextureHandle TextureStreamer::RegisterTexture(const StreamedTextureDesc& Desc)
+{
+	Assert(Desc.MipCount > 0);
+	Assert(Desc.BlockDimension > 0);
+
+	StreamedTextureHandle Handle;
+	if (!mFreeHandles.empty())
+	{
+		Handle = mFreeHandles.back();
+		mFreeHandles.pop_back();
+	}
+	else
+	{
+		Handle = static_cast<StreamedTextureHandle>(mTextures.size());
+		mTextures.emplace_back();
+	}
+
+	TextureState& State = mTextures[Handle];
+	State = TextureState();
+	State.Desc = Desc;
+	State.Desc.PackedTailMipCount = std::max(1u, std::min(Desc.PackedTailMipCount, Desc.MipCount));
+	State.bRegistered = true;
+
+	uint32_t FirstTailMip = FirstPackedTailMip(State);
+	State.FinestMip = mBackend->OnTextureRegistered(Handle, State.Desc);
+	if (State.FinestMip > FirstTailMip)
+	{
+		State.bRegistered = false;
+		mFreeHandles.push_back(Handle);
+		return InvalidStreamedTextureHandle;
+	}
+
+	//Nothing resident yet - the packed tail goes up straight away so there is always
+	//something to sample (low mips first).
+	State.ResidentMip = State.Desc.MipCount;
+	State.PendingMip = FirstTailMip;
+	State.RequestedMip = FirstTailMip;
+	State.FrameRequestedMip = State.Desc.MipCount;
+	State.LastRequestedFrame = mFrameIndex;
+
+	MipUploadRequest Request;
+	Request.Texture = Handle;
+	Request.FirstMip = FirstTailMip;
+	Request.LastMip = State.Desc.MipCount - 1;
+	Request.SizeInBytes = CalculateMipRangeSize(State.Desc, Request.FirstMip, Request.LastMip);
+
+	mPendingBytes += Request.SizeInBytes;
+	++mUploadsInFlight;
+	mBackend->SubmitMipUpload(Request);
+
+	return Handle;
+}
+
+void TextureStreamer::UnregisterTexture(StreamedTextureHandle Texture)
+{
+	Assert(Texture < mTextures.size() && mTextures[Texture].bRegistered);
+	TextureState& State = mTextures[Texture];
+
+	uint32_t LastMip = State.Desc.MipCount - 1;
+	if (State.ResidentMip < State.Desc.MipCount)
+	{
+		mResidentBytes -= CalculateMipRangeSize(State.Desc, State.ResidentMip, LastMip);
+	}
+	if (State.PendingMip != State.ResidentMip)
+	{
+		//Backend drops the in flight upload - it will never be reported as complete.
+		uint32_t PendingLastMip = std::min(State.ResidentMip, State.Desc.MipCount) - 1;
+		mPendingBytes -= CalculateMipRangeSize(State.Desc, State.PendingMip, PendingLastMip);
+		--mUploadsInFlight;
+	}
+
+	mBackend->OnTextureUnregistered(Texture);
+
+	State.bRegistered = false;
+	mFreeHandles.push_back(Texture);
+}
+
+void TextureStreamer::SetMemoryBudget(uint64_t BudgetInBytes)
+{
+	mSettings.MemoryBudgetInBytes = BudgetInBytes;
+}
+
+void TextureStreamer::ReportMipUsage(StreamedTextureHandle Texture, float DesiredMip)
+{
+	Assert(Texture < mTextures.size() && mTextures[Texture].bRegistered);
+	TextureState& State = mTextures[Texture];
+
+	//Round down - we'd rather be one mip too detailed than blurry - but never
+	//past what the backend can upload.
+	float Clamped = std::max(0.0f, DesiredMip);
+	uint32_t Mip = std::min(std::max(static_cast<uint32_t>(Clamped), State.FinestMip), FirstPackedTailMip(State));
+
+	if (!State.bRequestedThisFrame || Mip < State.FrameRequestedMip)
+	{
+		State.FrameRequestedMip = Mip;
+	}
+	State.bRequestedThisFrame = true;
+}
+
+void TextureStreamer::Update()
+{
+	mFrameStats = TextureStreamingFrameStats();
+	mFrameStats.FrameIndex = mFrameIndex;
+
+	ProcessCompletedUploads();
+	ResolveFeedback();
+
+	//Budget may have been lowered or feedback changed - get back under it before
+	//considering any new loads.
+	if (mResidentBytes + mPendingBytes > mSettings.MemoryBudgetInBytes)
+	{
+		EnforceBudget(mSettings.MemoryBudgetInBytes, InvalidStreamedTextureHandle);
+	}
+
+	IssueLoads();
+	GatherStats();
+
+	++mFrameIndex;
+}
+
+uint32_t TextureStreamer::GetResidentMip(StreamedTextureHandle Texture) const
+{
+	Assert(Texture < mTextures.size());
+	return mTextures[Texture].ResidentMip;
+}
+
+uint32_t TextureStreamer::GetRequestedMip(StreamedTextureHandle Texture) const
+{
+	Assert(Texture < mTextures.size());
+	return mTextures[Texture].RequestedMip;
+}
+
+float TextureStreamer::CalculateDesiredMip(const StreamedTextureDesc& Desc, float ProjectedSizeInPixels)
+{
+	if (ProjectedSizeInPixels <= 0.0f)
+	{
+		return static_cast<float>(Desc.MipCount - 1);
+	}
+
+	float LargestDimension = static_cast<float>(std::max(Desc.Width, Desc.Height));
+	float Mip = std::log2(LargestDimension / ProjectedSizeInPixels);
+	return std::min(std::max(Mip, 0.0f), static_cast<float>(Desc.MipCount - 1));
+}
+
+uint64_t TextureStreamer::CalculateMipSize(const StreamedTextureDesc& Desc, uint32_t Mip)
+{
+	uint64_t Width = std::max(1u, Desc.Width >> Mip);
+	uint64_t Height = std::max(1u, Desc.Height >> Mip);
+
+	uint64_t BlocksWide = (Width + Desc.BlockDimension - 1) / Desc.BlockDimension;
+	uint64_t BlocksHigh = (Height + Desc.BlockDimension - 1) / Desc.BlockDimension;
+	return BlocksWide * BlocksHigh * Desc.BytesPerBlock;
+}
+
+uint64_t TextureStreamer::CalculateMipRangeSize(const StreamedTextureDesc& Desc, uint32_t FirstMip, uint32_t LastMip)
+{
+	uint64_t Size = 0;
+	for (uint32_t Mip = FirstMip; Mip <= LastMip; ++Mip)
+	{
+		Size += CalculateMipSize(Desc, Mip);
+	}
+	return Size;
+}
+
+uint32_t TextureStreamer::FirstPackedTailMip(const TextureState& State) const
+{
+	return State.Desc.MipCount - State.Desc.PackedTailMipCount;
+}
+
+void TextureStreamer::ProcessCompletedUploads()
+{
+	mCompletedScratch.clear();
+	mBackend->CollectCompletedUploads(mCompletedScratch);
+
+	for (const MipUploadRequest& Completed : mCompletedScratch)
+	{
+		Assert(Completed.Texture < mTextures.size());
+		TextureState& State = mTextures[Completed.Texture];
+		Assert(State.bRegistered && State.PendingMip == Completed.FirstMip);
+
+		State.ResidentMip = Completed.FirstMip;
+		mPendingBytes -= Completed.SizeInBytes;
+		mResidentBytes += Completed.SizeInBytes;
+		--mUploadsInFlight;
+
+		++mFrameStats.UploadsCompleted;
+		mFrameStats.BytesUploaded += Completed.SizeInBytes;
+	}
+}
+
+void TextureStreamer::ResolveFeedback()
+{
+	for (TextureState& State : mTextures)
+	{
+		if (!State.bRegistered)
+		{
+			continue;
+		}
+
+		//Textures that aren't seen relax their request by a mip a frame, towards the
+		//packed tail, so their detailed mips become unwanted and are evicted first.
+		if (!State.bRequestedThisFrame)
+		{
+			State.RequestedMip = std::min(State.RequestedMip + 1, FirstPackedTailMip(State));
+			continue;
+		}
+
+		State.RequestedMip = State.FrameRequestedMip;
+		State.LastRequestedFrame = mFrameIndex;
+		State.bRequestedThisFrame = false;
+	}
+}
+
+void TextureStreamer::EnforceBudget(uint64_t TargetBytes, StreamedTextureHandle ProtectedTexture)
+{
+	//Cheapest first: mips nobody wants, then textures nobody has looked at in a while.
+	while (mResidentBytes + mPendingBytes > TargetBytes)
+	{
+		if (!EvictOneMip(ProtectedTexture, true) && !EvictOneMip(ProtectedTexture, false))
+		{
+			break;
+		}
+	}
+}
+
+bool TextureStreamer::EvictOneMip(StreamedTextureHandle ProtectedTexture, bool bOnlyUnwanted)
+{
+	StreamedTextureHandle Victim = InvalidStreamedTextureHandle;
+	uint64_t VictimLastRequested = 0;
+
+	for (StreamedTextureHandle Handle = 0; Handle < mTextures.size(); ++Handle)
+	{
+		const TextureState& State = mTextures[Handle];
+		if (!State.bRegistered || Handle == ProtectedTexture)
+		{
+			continue;
+		}
+
+		//Never touch the packed tail or a texture with an upload in flight.
+		if (State.ResidentMip >= FirstPackedTailMip(State) || State.PendingMip != State.ResidentMip)
+		{
+			continue;
+		}
+
+		if (bOnlyUnwanted)
+		{
+			if (State.ResidentMip + mSettings.EvictionHysteresisMips > State.RequestedMip)
+			{
+				continue;
+			}
+		}
+		else if (mFrameIndex - State.LastRequestedFrame < mSettings.EvictionGraceFrames)
+		{
+			continue;
+		}
+
+		if (Victim == InvalidStreamedTextureHandle || State.LastRequestedFrame < VictimLastRequested)
+		{
+			Victim = Handle;
+			VictimLastRequested = State.LastRequestedFrame;
+		}
+	}
+
+	if (Victim == InvalidStreamedTextureHandle)
+	{
+		return false;
+	}
+
+	TextureState& State = mTextures[Victim];
+	uint64_t MipSize = CalculateMipSize(State.Desc, State.ResidentMip);
+
+	++State.ResidentMip;
+	State.PendingMip = State.ResidentMip;
+	mResidentBytes -= MipSize;
+
+	++mFrameStats.MipsEvicted;
+	mFrameStats.BytesEvicted += MipSize;
+
+	mBackend->EvictMips(Victim, State.ResidentMip);
+	return true;
+}
+
+void TextureStreamer::IssueLoads()
+{
+	mCandidatesScratch.clear();
+	for (StreamedTextureHandle Handle = 0; Handle < mTextures.size(); ++Handle)
+	{
+		const TextureState& State = mTextures[Handle];
+		if (State.bRegistered && State.PendingMip == State.ResidentMip && State.RequestedMip < State.ResidentMip)
+		{
+			LoadCandidate Candidate;
+			Candidate.Texture = Handle;
+			Candidate.MipsMissing = State.ResidentMip - State.RequestedMip;
+			Candidate.LastRequestedFrame = State.LastRequestedFrame;
+			mCandidatesScratch.push_back(Candidate);
+		}
+	}
+
+	//Most blurry first, then most recently seen. Handle breaks ties so the
+	//order is deterministic.
+	std::sort(mCandidatesScratch.begin(), mCandidatesScratch.end(),
+		[](const LoadCandidate& A, const LoadCandidate& B)
+	{
+		if (A.MipsMissing != B.MipsMissing)
+		{
+			return A.MipsMissing > B.MipsMissing;
+		}
+		if (A.LastRequestedFrame != B.LastRequestedFrame)
+		{
+			return A.LastRequestedFrame > B.LastRequestedFrame;
+		}
+		return A.Texture < B.Texture;
+	});
+
+	uint64_t BytesIssuedThisFrame = 0;
+	for (const LoadCandidate& Candidate : mCandidatesScratch)
+	{
+		TextureState& State = mTextures[Candidate.Texture];
+
+		//One mip at a time, coarse to fine.
+		uint32_t Mip = State.ResidentMip - 1;
+		uint64_t MipSize = CalculateMipSize(State.Desc, Mip);
+
+		if (mUploadsInFlight >= mSettings.MaxUploadsInFlight ||
+			BytesIssuedThisFrame + MipSize > mSettings.MaxUploadBytesPerFrame)
+		{
+			++mFrameStats.RequestsDeferredByThrottle;
+			continue;
+		}
+
+		if (mResidentBytes + mPendingBytes + MipSize > mSettings.MemoryBudgetInBytes)
+		{
+			uint64_t Target = mSettings.MemoryBudgetInBytes > MipSize ? mSettings.MemoryBudgetInBytes - MipSize : 0;
+			EnforceBudget(Target, Candidate.Texture);
+
+			if (mResidentBytes + mPendingBytes + MipSize > mSettings.MemoryBudgetInBytes)
+			{
+				++mFrameStats.RequestsDeferredByBudget;
+				continue;
+			}
+		}
+
+		MipUploadRequest Request;
+		Request.Texture = Candidate.Texture;
+		Request.FirstMip = Mip;
+		Request.LastMip = Mip;
+		Request.SizeInBytes = MipSize;
+
+		State.PendingMip = Mip;
+		mPendingBytes += MipSize;
+		++mUploadsInFlight;
+		BytesIssuedThisFrame += MipSize;
+
+		++mFrameStats.UploadsIssued;
+		mBackend->SubmitMipUpload(Request);
+	}
+}
+
+void TextureStreamer::GatherStats()
+{
+	mFrameStats.BudgetInBytes = mSettings.MemoryBudgetInBytes;
+	mFrameStats.ResidentBytes = mResidentBytes;
+	mFrameStats.PendingBytes = mPendingBytes;
+	mFrameStats.UploadsInFlight = mUploadsInFlight;
+
+	for (const TextureState& State : mTextures)
+	{
+		if (!State.bRegistered)
+		{
+			continue;
+		}
+
+		++mFrameStats.TextureCount;
+		mFrameStats.WantedBytes += CalculateMipRangeSize(State.Desc, State.RequestedMip, State.Desc.MipCount - 1);
+		if (State.ResidentMip <= State.RequestedMip)
+		{
+			++mFrameStats.TexturesAtRequestedMip;
+		}
+	}
+}
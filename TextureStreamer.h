@@ -0,0 +1,191 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+//Mip-level texture streaming.
+//
+//The streamer owns the CPU side residency decisions only: which mips of which
+//textures should be resident, in what order they are loaded and which are thrown
+//away when we are over budget. Creating resources and moving bytes is left to a
+//backend (D3D12 copy queue or a GPU-less simulation) so the policy can be run
+//and inspected deterministically.
+//
+//Mip indices follow D3D12 - mip 0 is the most detailed level. A texture with
+//ResidentMip == 3 has mips 3..MipCount-1 resident.
+
+typedef uint32_t StreamedTextureHandle;
+const StreamedTextureHandle InvalidStreamedTextureHandle = 0xFFFFFFFF;
+
+struct StreamedTextureDesc
+{
+	uint32_t Width = 1;
+	uint32_t Height = 1;
+	uint32_t MipCount = 1;
+
+	//Size of one block in bytes and its dimension in texels. Uncompressed RGBA8 is
+	//4 bytes/1x1 texel blocks, BC1 is 8 bytes/4x4, BC3/BC7 are 16 bytes/4x4.
+	uint32_t BytesPerBlock = 4;
+	uint32_t BlockDimension = 1;
+
+	//Number of least detailed mips that are loaded when the texture is registered
+	//and are never evicted. For block compressed formats the tail should start at
+	//a mip at least one block in size.
+	uint32_t PackedTailMipCount = 1;
+
+	//DXGI_FORMAT of the texture - opaque to the streamer, only backends use it.
+	uint32_t Format = 0;
+};
+
+//Range of mips [FirstMip, LastMip] to upload to (or drop from) a texture.
+struct MipUploadRequest
+{
+	StreamedTextureHandle Texture = InvalidStreamedTextureHandle;
+	uint32_t FirstMip = 0;
+	uint32_t LastMip = 0;
+	uint64_t SizeInBytes = 0;
+};
+
+//Implemented by whatever actually creates/uploads GPU data.
+class ITextureStreamingBackend
+{
+public:
+	ITextureStreamingBackend() {};
+	virtual ~ITextureStreamingBackend() {};
+
+	//Returns the most detailed mip the backend can upload for the texture - 0
+	//when it can take them all. A texture it can't upload the packed tail of
+	//(MipCount or anything above the tail's first mip) is rejected and never
+	//unregistered.
+	virtual uint32_t OnTextureRegistered(StreamedTextureHandle Texture, const StreamedTextureDesc& Desc) = 0;
+	virtual void OnTextureUnregistered(StreamedTextureHandle Texture) = 0;
+
+	//Asynchronously upload the requested mips. Completion is reported via CollectCompletedUploads().
+	virtual void SubmitMipUpload(const MipUploadRequest& Request) = 0;
+	virtual void CollectCompletedUploads(std::vector<MipUploadRequest>& OutCompleted) = 0;
+
+	//Drop all mips more detailed than NewResidentMip.
+	virtual void EvictMips(StreamedTextureHandle Texture, uint32_t NewResidentMip) = 0;
+};
+
+struct TextureStreamerSettings
+{
+	//Total bytes the streamer may keep resident + in flight.
+	uint64_t MemoryBudgetInBytes = 256ull * 1024ull * 1024ull;
+
+	//Upload throttling - keeps the copy queue from starving frames.
+	uint32_t MaxUploadsInFlight = 8;
+	uint64_t MaxUploadBytesPerFrame = 16ull * 1024ull * 1024ull;
+
+	//Textures not requested for this many frames are eviction candidates even
+	//if they still want their detailed mips.
+	uint32_t EvictionGraceFrames = 30;
+
+	//Only drop detailed mips if we want at least this many levels fewer - stops
+	//a texture hovering around a mip boundary from thrashing.
+	uint32_t EvictionHysteresisMips = 1;
+};
+
+struct TextureStreamingFrameStats
+{
+	uint64_t FrameIndex = 0;
+	uint64_t BudgetInBytes = 0;
+	uint64_t ResidentBytes = 0;
+	uint64_t PendingBytes = 0;
+	uint64_t WantedBytes = 0;	 //Bytes needed to have every texture at its requested mip
+
+	uint32_t TextureCount = 0;
+	uint32_t TexturesAtRequestedMip = 0;
+	uint32_t UploadsInFlight = 0;
+
+	//Per frame counters
+	uint32_t UploadsIssued = 0;
+	uint32_t UploadsCompleted = 0;
+	uint64_t BytesUploaded = 0;
+	uint32_t MipsEvicted = 0;
+	uint64_t BytesEvicted = 0;
+	uint32_t RequestsDeferredByBudget = 0;
+	uint32_t RequestsDeferredByThrottle = 0;
+};
+
+class TextureStreamer
+{
+public:
+	TextureStreamer(ITextureStreamingBackend* Backend, const TextureStreamerSettings& Settings);
+	~TextureStreamer();
+
+	//InvalidStreamedTextureHandle if the backend can't take the texture
+	StreamedTextureHandle RegisterTexture(const StreamedTextureDesc& Desc);
+	void UnregisterTexture(StreamedTextureHandle Texture);
+
+	//Changing the budget takes effect on the next Update() - we will evict down
+	//to it if required.
+	void SetMemoryBudget(uint64_t BudgetInBytes);
+
+	//Screen space usage feedback for this frame. Multiple reports for the same texture
+	//are combined (most detailed wins).
+	void ReportMipUsage(StreamedTextureHandle Texture, float DesiredMip);
+
+	//Process completed uploads, then issue loads/evictions for this frame.
+	void Update();
+
+	uint32_t GetResidentMip(StreamedTextureHandle Texture) const;
+	uint32_t GetRequestedMip(StreamedTextureHandle Texture) const;
+	const TextureStreamingFrameStats& GetFrameStats() const { return mFrameStats; }
+
+	//Mip a texture needs when it covers ProjectedSizeInPixels (largest screen
+	//space dimension) - 1 texel per pixel.
+	static float CalculateDesiredMip(const StreamedTextureDesc& Desc, float ProjectedSizeInPixels);
+
+	static uint64_t CalculateMipSize(const StreamedTextureDesc& Desc, uint32_t Mip);
+	static uint64_t CalculateMipRangeSize(const StreamedTextureDesc& Desc, uint32_t FirstMip, uint32_t LastMip);
+
+private:
+	struct TextureState
+	{
+		StreamedTextureDesc Desc;
+		bool bRegistered = false;
+
+		uint32_t FinestMip = 0;			//Most detailed mip the backend can upload
+		uint32_t ResidentMip = 0;		//Most detailed mip resident (MipCount == nothing resident)
+		uint32_t PendingMip = 0;		//Most detailed mip once in flight uploads land
+		uint32_t RequestedMip = 0;		//Combined feedback
+		uint32_t FrameRequestedMip = 0; //Feedback for the current frame being gathered
+		bool bRequestedThisFrame = false;
+
+		uint64_t LastRequestedFrame = 0;
+	};
+
+	struct LoadCandidate
+	{
+		StreamedTextureHandle Texture;
+		uint32_t MipsMissing;
+		uint64_t LastRequestedFrame;
+	};
+
+	void ProcessCompletedUploads();
+	void ResolveFeedback();
+	void EnforceBudget(uint64_t TargetBytes, StreamedTextureHandle ProtectedTexture);
+	bool EvictOneMip(StreamedTextureHandle ProtectedTexture, bool bOnlyUnwanted);
+	void IssueLoads();
+	void GatherStats();
+
+	uint32_t FirstPackedTailMip(const TextureState& State) const;
+
+private:
+	ITextureStreamingBackend* mBackend;
+	TextureStreamerSettings mSettings;
+
+	std::vector<TextureState> mTextures;
+	std::vector<StreamedTextureHandle> mFreeHandles;
+
+	uint64_t mFrameIndex;
+	uint64_t mResidentBytes;
+	uint64_t mPendingBytes;
+	uint32_t mUploadsInFlight;
+
+	std::vector<MipUploadRequest> mCompletedScratch;
+	std::vector<LoadCandidate> mCandidatesScratch;
+
+	TextureStreamingFrameStats mFrameStats;
+};
@@ -0,0 +1,144 @@
+#include "TextureStreamingSimulation.h"
+#include "Common.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdio.h>
+
+TextureStreamingSimulation::TextureStreamingSimulation(const TextureStreamingSimulationSettings& Settings)
+	: mSettings(Settings), mBackend(Settings.Backend), mStreamer(&mBackend, Settings.Streamer),
+	mRandomState(Settings.Seed ? Settings.Seed : 1)
+{
+	CreateObjects();
+}
+
+TextureStreamingSimulation::~TextureStreamingSimulation()
+{}
+
+void TextureStreamingSimulation::Run(const CameraPath& Path)
+{
+	mFrameStats.clear();
+	mFrameStats.reserve(Path.GetSampleCount());
+
+	for (unsigned Frame = 0; Frame < Path.GetSampleCount(); ++Frame)
+	{
+		GenerateFeedback(Path.GetSample(Frame));
+
+		mBackend.Tick();
+		mStreamer.Update();
+
+		mFrameStats.push_back(mStreamer.GetFrameStats());
+	}
+}
+
+bool TextureStreamingSimulation::WriteStatsCsv(const char* Filename) const
+{
+	FILE* File = fopen(Filename, "w");
+	if (!File)
+	{
+		return false;
+	}
+
+	fprintf(File, "Frame,Budget,Resident,Pending,Wanted,Textures,AtRequestedMip,UploadsInFlight,"
+		"UploadsIssued,UploadsCompleted,BytesUploaded,MipsEvicted,BytesEvicted,DeferredByBudget,DeferredByThrottle\n");
+
+	for (const TextureStreamingFrameStats& Stats : mFrameStats)
+	{
+		fprintf(File, "%llu,%llu,%llu,%llu,%llu,%u,%u,%u,%u,%u,%llu,%u,%llu,%u,%u\n",
+			(unsigned long long)Stats.FrameIndex, (unsigned long long)Stats.BudgetInBytes,
+			(unsigned long long)Stats.ResidentBytes, (unsigned long long)Stats.PendingBytes,
+			(unsigned long long)Stats.WantedBytes, Stats.TextureCount, Stats.TexturesAtRequestedMip,
+			Stats.UploadsInFlight, Stats.UploadsIssued, Stats.UploadsCompleted,
+			(unsigned long long)Stats.BytesUploaded, Stats.MipsEvicted, (unsigned long long)Stats.BytesEvicted,
+			Stats.RequestsDeferredByBudget, Stats.RequestsDeferredByThrottle);
+	}
+
+	fclose(File);
+	return true;
+}
+
+void TextureStreamingSimulation::CreateObjects()
+{
+	Assert(mSettings.TextureCount > 0);
+
+	//Texture pool - mix of BC1 and BC7, 256 to 4096 square.
+	for (unsigned i = 0; i < mSettings.TextureCount; ++i)
+	{
+		unsigned SizeLog2 = 8 + (NextRandom() % 5);
+		bool bBC7 = (NextRandom() % 2) == 0;
+
+		StreamedTextureDesc Desc;
+		Desc.Width = 1u << SizeLog2;
+		Desc.Height = Desc.Width;
+		Desc.MipCount = SizeLog2 + 1;
+		Desc.BlockDimension = 4;
+		Desc.BytesPerBlock = bBC7 ? 16 : 8;
+		Desc.PackedTailMipCount = 5; //Down to 16x16 -> 1x1 is always resident
+
+		mTextureDescs.push_back(Desc);
+		mTextureHandles.push_back(mStreamer.RegisterTexture(Desc));
+	}
+
+	mObjects.resize(mSettings.ObjectCount);
+	for (SimulatedObject& Object : mObjects)
+	{
+		Object.Position[0] = NextRandomFloat(-mSettings.WorldExtent, mSettings.WorldExtent);
+		Object.Position[1] = NextRandomFloat(0.0f, mSettings.MaxObjectRadius * 2.0f);
+		Object.Position[2] = NextRandomFloat(-mSettings.WorldExtent, mSettings.WorldExtent);
+		Object.Radius = NextRandomFloat(mSettings.MinObjectRadius, mSettings.MaxObjectRadius);
+		Object.TextureIdx = NextRandom() % mSettings.TextureCount;
+	}
+}
+
+void TextureStreamingSimulation::GenerateFeedback(const CameraPathSample& Camera)
+{
+	float TanHalfFov = std::tan(mSettings.VerticalFovRadians * 0.5f);
+
+	//Cone test against the view direction is enough for feedback purposes - slightly
+	//wider than the vertical fov to account for the aspect ratio.
+	float CosCone = std::cos(std::min(mSettings.VerticalFovRadians, 2.5f));
+
+	for (const SimulatedObject& Object : mObjects)
+	{
+		float ToObject[3] =
+		{
+			Object.Position[0] - Camera.Position[0],
+			Object.Position[1] - Camera.Position[1],
+			Object.Position[2] - Camera.Position[2]
+		};
+		float Distance = std::sqrt(ToObject[0] * ToObject[0] + ToObject[1] * ToObject[1] + ToObject[2] * ToObject[2]);
+
+		//Inside the object - wants everything.
+		if (Distance <= Object.Radius)
+		{
+			mStreamer.ReportMipUsage(mTextureHandles[Object.TextureIdx], 0.0f);
+			continue;
+		}
+
+		float Facing = (ToObject[0] * Camera.Forward[0] + ToObject[1] * Camera.Forward[1] + ToObject[2] * Camera.Forward[2]) / Distance;
+		if (Facing < CosCone)
+		{
+			continue;
+		}
+
+		float ProjectedSizeInPixels = (Object.Radius * mSettings.ScreenHeight) / (Distance * TanHalfFov);
+		const StreamedTextureDesc& Desc = mTextureDescs[Object.TextureIdx];
+		mStreamer.ReportMipUsage(mTextureHandles[Object.TextureIdx],
+			TextureStreamer::CalculateDesiredMip(Desc, ProjectedSizeInPixels));
+	}
+}
+
+unsigned TextureStreamingSimulation::NextRandom()
+{
+	//xorshift32 - we want identical runs on every platform/CRT.
+	mRandomState ^= mRandomState << 13;
+	mRandomState ^= mRandomState >> 17;
+	mRandomState ^= mRandomState << 5;
+	return mRandomState;
+}
+
+float TextureStreamingSimulation::NextRandomFloat(float Min, float Max)
+{
+	float T = static_cast<float>(NextRandom() & 0xFFFFFF) / static_cast<float>(0xFFFFFF);
+	return Min + (Max - Min) * T;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "TextureStreamer.h"
+#include "SimulatedTextureStreamingBackend.h"
+#include "CameraPath.h"
+
+//Headless texture streaming run: a deterministic field of textured objects is
+//viewed along a camera path, screen space usage feedback is generated from the
+//projected size of each visible object and fed to a TextureStreamer backed by
+//the simulated copy queue. No GPU (or window) required.
+struct TextureStreamingSimulationSettings
+{
+	unsigned ObjectCount = 2000;
+	unsigned TextureCount = 500;		//Objects share textures from a pool this size
+	unsigned Seed = 1;
+	float WorldExtent = 500.0f;		//Objects are placed in [-Extent, Extent] on XZ
+	float MinObjectRadius = 1.0f;
+	float MaxObjectRadius = 10.0f;
+
+	float ScreenHeight = 1080.0f;
+	float VerticalFovRadians = 1.0471975f; //60 degrees
+
+	TextureStreamerSettings Streamer;
+	SimulatedTextureStreamingSettings Backend;
+};
+
+class TextureStreamingSimulation
+{
+public:
+	TextureStreamingSimulation(const TextureStreamingSimulationSettings& Settings);
+	~TextureStreamingSimulation();
+
+	//Runs one streamer frame per path sample. Stats for every frame are kept.
+	void Run(const CameraPath& Path);
+
+	const std::vector<TextureStreamingFrameStats>& GetFrameStats() const { return mFrameStats; }
+	bool WriteStatsCsv(const char* Filename) const;
+
+private:
+	struct SimulatedObject
+	{
+		float Position[3];
+		float Radius;
+		unsigned TextureIdx;
+	};
+
+	void CreateObjects();
+	void GenerateFeedback(const CameraPathSample& Camera);
+
+	unsigned NextRandom();
+	float NextRandomFloat(float Min, float Max);
+
+private:
+	TextureStreamingSimulationSettings mSettings;
+
+	SimulatedTextureStreamingBackend mBackend;
+	TextureStreamer mStreamer;
+
+	std::vector<SimulatedObject> mObjects;
+	std::vector<StreamedTextureDesc> mTextureDescs;
+	std::vector<StreamedTextureHandle> mTextureHandles;
+	std::vector<TextureStreamingFrameStats> mFrameStats;
+
+	unsigned mRandomState;
+};
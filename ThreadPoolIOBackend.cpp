@@ -0,0 +1,144 @@
+#include "ThreadPoolIOBackend.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <errno.h>
+#include <unistd.h>
+#endif
+
+ThreadPoolIOBackend::ThreadPoolIOBackend(uint32_t ThreadCount)
+	: mShutdown(false)
+{
+	if (ThreadCount == 0)
+	{
+		ThreadCount = 1;
+	}
+
+	for (uint32_t i = 0; i < ThreadCount; ++i)
+	{
+		mWorkers.emplace_back(&ThreadPoolIOBackend::WorkerMain, this);
+	}
+}
+
+ThreadPoolIOBackend::~ThreadPoolIOBackend()
+{
+	{
+		std::lock_guard<std::mutex> Lock(mMutex);
+		mShutdown = true;
+	}
+	mReadAvailable.notify_all();
+
+	for (std::thread& Worker : mWorkers)
+	{
+		Worker.join();
+	}
+}
+
+bool ThreadPoolIOBackend::Submit(const AsyncIOBackendRead* Reads, uint32_t Count)
+{
+	{
+		std::lock_guard<std::mutex> Lock(mMutex);
+		mReads.insert(mReads.end(), Reads, Reads + Count);
+	}
+
+	if (Count == 1)
+	{
+		mReadAvailable.notify_one();
+	}
+	else
+	{
+		mReadAvailable.notify_all();
+	}
+	return true;
+}
+
+uint32_t ThreadPoolIOBackend::WaitForCompletions(AsyncIOBackendCompletion* OutCompletions, uint32_t MaxCount)
+{
+	std::unique_lock<std::mutex> Lock(mMutex);
+	mCompletionAvailable.wait(Lock, [this]() { return !mCompletions.empty(); });
+
+	uint32_t Count = 0;
+	while (Count < MaxCount && !mCompletions.empty())
+	{
+		OutCompletions[Count++] = mCompletions.front();
+		mCompletions.pop_front();
+	}
+	return Count;
+}
+
+void ThreadPoolIOBackend::Wake()
+{
+	{
+		std::lock_guard<std::mutex> Lock(mMutex);
+		mCompletions.push_back({ AsyncIOWakeTag, 0 });
+	}
+	mCompletionAvailable.notify_one();
+}
+
+void ThreadPoolIOBackend::WorkerMain()
+{
+	for (;;)
+	{
+		AsyncIOBackendRead Read;
+		{
+			std::unique_lock<std::mutex> Lock(mMutex);
+			mReadAvailable.wait(Lock, [this]() { return mShutdown || !mReads.empty(); });
+
+			if (mReads.empty())
+			{
+				return;
+			}
+
+			Read = mReads.front();
+			mReads.pop_front();
+		}
+
+		int64_t Result = ReadAt(Read.File, Read.Offset, Read.Size, Read.Dest);
+
+		{
+			std::lock_guard<std::mutex> Lock(mMutex);
+			mCompletions.push_back({ Read.Tag, Result });
+		}
+		mCompletionAvailable.notify_one();
+	}
+}
+
+int64_t ThreadPoolIOBackend::ReadAt(intptr_t File, uint64_t Offset, uint32_t Size, void* Dest)
+{
+#if defined(_WIN32)
+	//Synchronous handle + OVERLAPPED offset = positional read, safe from any thread
+	OVERLAPPED Overlapped = {};
+	Overlapped.Offset = static_cast<DWORD>(Offset);
+	Overlapped.OffsetHigh = static_cast<DWORD>(Offset >> 32);
+
+	DWORD BytesRead = 0;
+	if (!ReadFile(reinterpret_cast<HANDLE>(File), Dest, Size, &BytesRead, &Overlapped) && GetLastError() != ERROR_HANDLE_EOF)
+	{
+		return -1;
+	}
+	return BytesRead;
+#else
+	//pread can return early (signals, large reads) - keep going until EOF
+	uint8_t* Out = static_cast<uint8_t*>(Dest);
+	uint32_t Total = 0;
+	while (Total < Size)
+	{
+		ssize_t Result = pread(static_cast<int>(File), Out + Total, Size - Total, static_cast<off_t>(Offset + Total));
+		if (Result < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			return -1;
+		}
+		if (Result == 0)
+		{
+			break;
+		}
+		Total += static_cast<uint32_t>(Result);
+	}
+	return Total;
+#endif
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "AsyncIOBackend.h"
+
+//Portable backend - worker threads doing blocking positional reads (pread /
+//ReadFile with an offset). Used where io_uring isn't available.
+class ThreadPoolIOBackend : public IAsyncIOBackend
+{
+public:
+	ThreadPoolIOBackend(uint32_t ThreadCount);
+	~ThreadPoolIOBackend();
+
+	const char* GetName() const override { return "ThreadPool"; }
+
+	bool Submit(const AsyncIOBackendRead* Reads, uint32_t Count) override;
+	uint32_t WaitForCompletions(AsyncIOBackendCompletion* OutCompletions, uint32_t MaxCount) override;
+	void Wake() override;
+
+	//Blocking positional read of a native handle. Returns bytes read or -1.
+	static int64_t ReadAt(intptr_t File, uint64_t Offset, uint32_t Size, void* Dest);
+
+private:
+	void WorkerMain();
+
+private:
+	std::vector<std::thread> mWorkers;
+
+	std::mutex mMutex;
+	std::condition_variable mReadAvailable;
+	std::condition_variable mCompletionAvailable;
+	std::deque<AsyncIOBackendRead> mReads;
+	std::deque<AsyncIOBackendCompletion> mCompletions;
+	bool mShutdown;
+};
@@ -0,0 +1,269 @@
+#include "TransformBenchmark.h"
+#include "Common.h"
+#include "JobSystem.h"
+#include "TransformHierarchy.h"
+
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <stdio.h>
+
+namespace
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	double MillisecondsSince(Clock::time_point Start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - Start).count();
+	}
+
+	uint32_t HashNode(uint32_t Node, uint32_t Pass)
+	{
+		uint32_t Value = Node * 0x9E3779B1u ^ (Pass + 1) * 0x85EBCA77u;
+		Value ^= Value >> 15;
+		Value *= 0x2C1B3C6Du;
+		Value ^= Value >> 12;
+		return Value;
+	}
+
+	//The same local transform for a node and pass in every mode
+	void MakeLocal(uint32_t Node, uint32_t Pass, float Position[3], float Rotation[4], float& Scale)
+	{
+		uint32_t Bits = HashNode(Node, Pass + 0x10000);
+		Position[0] = static_cast<float>(Bits & 0xFF) / 255.0f - 0.5f;
+		Position[1] = static_cast<float>((Bits >> 8) & 0xFF) / 255.0f - 0.5f;
+		Position[2] = static_cast<float>((Bits >> 16) & 0xFF) / 255.0f - 0.5f;
+
+		float Angle = static_cast<float>(Bits >> 24) / 255.0f * 3.14159265f;
+		float Axis[3] = { 0.267f, 0.535f, 0.802f };
+		float Sin = sinf(Angle * 0.5f);
+		Rotation[0] = Axis[0] * Sin;
+		Rotation[1] = Axis[1] * Sin;
+		Rotation[2] = Axis[2] * Sin;
+		Rotation[3] = cosf(Angle * 0.5f);
+
+		Scale = 0.9f + static_cast<float>(Bits % 17) * 0.0125f;
+	}
+
+	bool IsDirty(uint32_t Node, uint32_t Pass, uint32_t DirtyPercentage)
+	{
+		return HashNode(Node, Pass) % 100 < DirtyPercentage;
+	}
+
+	//What a scene graph usually looks like before anyone profiles it
+	struct RecursiveNode
+	{
+		std::vector<RecursiveNode*> Children;
+		float Position[3];
+		float Rotation[4];
+		float Scale;
+		bool bDirty;
+		Matrix3x4 World;
+	};
+
+	void UpdateRecursive(RecursiveNode* Node, const Matrix3x4* Parent, bool bParentUpdated, uint32_t& NodesUpdated)
+	{
+		bool bUpdate = Node->bDirty || bParentUpdated;
+		Node->bDirty = false;
+		if (bUpdate)
+		{
+			Matrix3x4 Local = MatrixFromTrs(MakeFloat3(Node->Position[0], Node->Position[1], Node->Position[2]),
+				MakeQuaternion(Node->Rotation[0], Node->Rotation[1], Node->Rotation[2], Node->Rotation[3]), Node->Scale);
+			Node->World = Parent ? Multiply(*Parent, Local) : Local;
+			++NodesUpdated;
+		}
+
+		for (RecursiveNode* Child : Node->Children)
+		{
+			UpdateRecursive(Child, &Node->World, bUpdate, NodesUpdated);
+		}
+	}
+}
+
+TransformBenchmark::TransformBenchmark(const TransformBenchmarkSettings& Settings)
+	: mSettings(Settings), mLevelCount(0)
+{
+	Assert(mSettings.NodeCount > 0 && mSettings.RootCount > 0 && mSettings.Iterations > 0);
+}
+
+TransformBenchmark::~TransformBenchmark()
+{}
+
+bool TransformBenchmark::Run()
+{
+	mResults.clear();
+
+	//Parents come before children in the benchmark's numbering, but the
+	//hierarchy doesn't rely on it
+	std::mt19937 Random(1234);
+	mParents.resize(mSettings.NodeCount);
+	for (uint32_t Node = 0; Node < mSettings.NodeCount; ++Node)
+	{
+		mParents[Node] = Node < mSettings.RootCount ? TransformHierarchyNoParent : static_cast<uint32_t>(Random() % Node);
+	}
+
+	for (uint32_t DirtyPercentage : mSettings.DirtyPercentages)
+	{
+		if (DirtyPercentage == 0 || DirtyPercentage > 100)
+		{
+			mLastError = "Dirty percentages must be 1 to 100";
+			return false;
+		}
+		if (!RunDirtyPercentage(DirtyPercentage))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool TransformBenchmark::RunDirtyPercentage(uint32_t DirtyPercentage)
+{
+	float Position[3];
+	float Rotation[4];
+	float Scale;
+
+	//Recursive
+	std::vector<std::unique_ptr<RecursiveNode>> Nodes;
+	std::vector<RecursiveNode*> Roots;
+	Nodes.reserve(mSettings.NodeCount);
+	for (uint32_t Node = 0; Node < mSettings.NodeCount; ++Node)
+	{
+		Nodes.emplace_back(new RecursiveNode());
+		MakeLocal(Node, 0, Nodes[Node]->Position, Nodes[Node]->Rotation, Nodes[Node]->Scale);
+		Nodes[Node]->bDirty = true;
+	}
+	for (uint32_t Node = 0; Node < mSettings.NodeCount; ++Node)
+	{
+		if (mParents[Node] == TransformHierarchyNoParent)
+		{
+			Roots.push_back(Nodes[Node].get());
+		}
+		else
+		{
+			Nodes[mParents[Node]]->Children.push_back(Nodes[Node].get());
+		}
+	}
+
+	uint32_t NodesUpdated = 0;
+	for (RecursiveNode* Root : Roots)
+	{
+		UpdateRecursive(Root, nullptr, false, NodesUpdated);
+	}
+
+	double Milliseconds = 0.0;
+	uint64_t TotalUpdated = 0;
+	for (uint32_t Pass = 1; Pass <= mSettings.Iterations; ++Pass)
+	{
+		for (uint32_t Node = 0; Node < mSettings.NodeCount; ++Node)
+		{
+			if (IsDirty(Node, Pass, DirtyPercentage))
+			{
+				MakeLocal(Node, Pass, Nodes[Node]->Position, Nodes[Node]->Rotation, Nodes[Node]->Scale);
+				Nodes[Node]->bDirty = true;
+			}
+		}
+
+		NodesUpdated = 0;
+		auto Start = Clock::now();
+		for (RecursiveNode* Root : Roots)
+		{
+			UpdateRecursive(Root, nullptr, false, NodesUpdated);
+		}
+		Milliseconds += MillisecondsSince(Start);
+		TotalUpdated += NodesUpdated;
+	}
+	AddResult(DirtyPercentage, "Recursive", Milliseconds, TotalUpdated);
+
+	//Serial and parallel
+	JobSystem Jobs(mSettings.ThreadCount);
+	for (int bParallel = 0; bParallel < 2; ++bParallel)
+	{
+		TransformHierarchy Hierarchy;
+		Hierarchy.Build(mParents.data(), mSettings.NodeCount);
+		mLevelCount = Hierarchy.GetLevelCount();
+		for (uint32_t Node = 0; Node < mSettings.NodeCount; ++Node)
+		{
+			MakeLocal(Node, 0, Position, Rotation, Scale);
+			Hierarchy.SetLocalTransform(Node, Position, Rotation, Scale);
+		}
+		Hierarchy.Update();
+
+		Milliseconds = 0.0;
+		TotalUpdated = 0;
+		for (uint32_t Pass = 1; Pass <= mSettings.Iterations; ++Pass)
+		{
+			for (uint32_t Node = 0; Node < mSettings.NodeCount; ++Node)
+			{
+				if (IsDirty(Node, Pass, DirtyPercentage))
+				{
+					MakeLocal(Node, Pass, Position, Rotation, Scale);
+					Hierarchy.SetLocalTransform(Node, Position, Rotation, Scale);
+				}
+			}
+
+			auto Start = Clock::now();
+			Hierarchy.Update(bParallel ? &Jobs : nullptr);
+			Milliseconds += MillisecondsSince(Start);
+			TotalUpdated += Hierarchy.GetLastUpdateStats().NodesUpdated;
+		}
+		AddResult(DirtyPercentage, bParallel ? "Parallel" : "Serial", Milliseconds, TotalUpdated);
+
+		//Different instruction order, so close rather than identical
+		for (uint32_t Node = 0; Node < mSettings.NodeCount; ++Node)
+		{
+			const Matrix3x4& Expected = Nodes[Node]->World;
+			const Matrix3x4& Actual = Hierarchy.GetWorldMatrix(Node);
+			for (int Row = 0; Row < 3; ++Row)
+			{
+				for (int Column = 0; Column < 4; ++Column)
+				{
+					float Error = fabsf(Actual.Rows[Row][Column] - Expected.Rows[Row][Column]);
+					if (!(Error <= 1e-4f * (1.0f + fabsf(Expected.Rows[Row][Column]))))
+					{
+						char Message[128];
+						snprintf(Message, sizeof(Message), "World matrix of node %u differs (%s, %u%% dirty)", Node,
+							bParallel ? "parallel" : "serial", DirtyPercentage);
+						mLastError = Message;
+						return false;
+					}
+				}
+			}
+		}
+	}
+	return true;
+}
+
+void TransformBenchmark::AddResult(uint32_t DirtyPercentage, const char* Mode, double Milliseconds, uint64_t NodesUpdated)
+{
+	TransformBenchmarkResult Result;
+	Result.DirtyPercentage = DirtyPercentage;
+	Result.Mode = Mode;
+	Result.MillisecondsPerPass = Milliseconds / mSettings.Iterations;
+	Result.NodesUpdatedPerPass = static_cast<uint32_t>(NodesUpdated / mSettings.Iterations);
+	mResults.push_back(Result);
+}
+
+bool TransformBenchmark::WriteReport(const char* Filename) const
+{
+	FILE* File = fopen(Filename, "w");
+	if (!File)
+	{
+		return false;
+	}
+
+	fprintf(File, "Nodes:       %u\n", mSettings.NodeCount);
+	fprintf(File, "Roots:       %u\n", mSettings.RootCount);
+	fprintf(File, "Levels:      %u\n", mLevelCount);
+	fprintf(File, "Iterations:  %u\n\n", mSettings.Iterations);
+	fprintf(File, "DirtyPercent,Mode,MsPerPass,NodesUpdatedPerPass\n");
+	for (const TransformBenchmarkResult& Result : mResults)
+	{
+		fprintf(File, "%u,%s,%.3f,%u\n", Result.DirtyPercentage, Result.Mode.c_str(),
+			Result.MillisecondsPerPass, Result.NodesUpdatedPerPass);
+	}
+
+	fclose(File);
+	return true;
+}
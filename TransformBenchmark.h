@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//World transform update speed for a random NodeCount node hierarchy, with
+//each of DirtyPercentages of the nodes given a new local transform before
+//every pass. Modes:
+//	Recursive	- individually allocated nodes with child lists, updated by
+//				  recursing from the roots, one matrix at a time
+//	Serial		- TransformHierarchy on this thread
+//	Parallel	- TransformHierarchy with big levels split across the job system
+//
+//Run() fails if the hierarchy's world matrices don't match the recursive ones.
+struct TransformBenchmarkSettings
+{
+	uint32_t NodeCount = 100000;
+	uint32_t RootCount = 16;
+	std::vector<uint32_t> DirtyPercentages = { 1, 100 };
+	uint32_t Iterations = 50;
+	uint32_t ThreadCount = 0;
+};
+
+struct TransformBenchmarkResult
+{
+	uint32_t DirtyPercentage = 0;
+	std::string Mode;
+	double MillisecondsPerPass = 0.0;
+	uint32_t NodesUpdatedPerPass = 0;
+};
+
+class TransformBenchmark
+{
+public:
+	TransformBenchmark(const TransformBenchmarkSettings& Settings);
+	~TransformBenchmark();
+
+	bool Run();
+	bool WriteReport(const char* Filename) const;
+
+	const std::string& GetLastError() const { return mLastError; }
+
+private:
+	bool RunDirtyPercentage(uint32_t DirtyPercentage);
+
+	void AddResult(uint32_t DirtyPercentage, const char* Mode, double Milliseconds, uint64_t NodesUpdated);
+
+private:
+	TransformBenchmarkSettings mSettings;
+	std::vector<uint32_t> mParents;
+	uint32_t mLevelCount;
+	std::vector<TransformBenchmarkResult> mResults;
+	std::string mLastError;
+};
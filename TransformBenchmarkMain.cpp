@@ -0,0 +1,57 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "TransformBenchmark.h"
+
+//Transform hierarchy update benchmark:
+//	TransformBenchmark [-nodes N] [-iterations N] [-threads N] [-dirty P ...]
+//Writes TransformBenchmark.txt to the current directory.
+int main(int argc, char** argv)
+{
+	TransformBenchmarkSettings Settings;
+	bool bCustomPercentages = false;
+	bool bValid = true;
+	for (int i = 1; i < argc && bValid; ++i)
+	{
+		if (strcmp(argv[i], "-nodes") == 0 && i + 1 < argc)
+		{
+			Settings.NodeCount = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-iterations") == 0 && i + 1 < argc)
+		{
+			Settings.Iterations = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc)
+		{
+			Settings.ThreadCount = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-dirty") == 0 && i + 1 < argc)
+		{
+			if (!bCustomPercentages)
+			{
+				Settings.DirtyPercentages.clear();
+				bCustomPercentages = true;
+			}
+			Settings.DirtyPercentages.push_back(static_cast<uint32_t>(atoi(argv[++i])));
+		}
+		else
+		{
+			bValid = false;
+		}
+	}
+
+	if (!bValid || Settings.NodeCount == 0 || Settings.Iterations == 0)
+	{
+		fprintf(stderr, "Usage: TransformBenchmark [-nodes N] [-iterations N] [-threads N] [-dirty P ...]\n");
+		return 1;
+	}
+
+	TransformBenchmark Benchmark(Settings);
+	if (!Benchmark.Run())
+	{
+		fprintf(stderr, "%s\n", Benchmark.GetLastError().c_str());
+		return 1;
+	}
+	return Benchmark.WriteReport("TransformBenchmark.txt") ? 0 : 1;
+}
@@ -0,0 +1,219 @@
+#include "TransformHierarchy.h"
+#include "Common.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <atomic>
+
+namespace
+{
+	//Nodes per job when a level is split - a multiple of the SIMD width
+	const uint32_t ParallelBatchSize = 1024;
+}
+
+TransformHierarchy::TransformHierarchy()
+{
+	mLevelStarts.push_back(0);
+}
+
+TransformHierarchy::~TransformHierarchy()
+{}
+
+void TransformHierarchy::Build(const uint32_t* Parents, uint32_t Count)
+{
+	//Children of each node, then breadth first from the roots - a BFS visits
+	//depths in order and keeps siblings together
+	std::vector<uint32_t> ChildStarts(Count + 1, 0);
+	for (uint32_t Node = 0; Node < Count; ++Node)
+	{
+		if (Parents[Node] != TransformHierarchyNoParent)
+		{
+			Check(Parents[Node] < Count);
+			++ChildStarts[Parents[Node] + 1];
+		}
+	}
+	for (uint32_t Node = 0; Node < Count; ++Node)
+	{
+		ChildStarts[Node + 1] += ChildStarts[Node];
+	}
+
+	std::vector<uint32_t> Children(ChildStarts[Count]);
+	std::vector<uint32_t> Fill(ChildStarts.begin(), ChildStarts.end() - 1);
+	for (uint32_t Node = 0; Node < Count; ++Node)
+	{
+		if (Parents[Node] != TransformHierarchyNoParent)
+		{
+			Children[Fill[Parents[Node]]++] = Node;
+		}
+	}
+
+	std::vector<uint32_t> Order;
+	std::vector<uint32_t> Depths;
+	Order.reserve(Count);
+	Depths.reserve(Count);
+	for (uint32_t Node = 0; Node < Count; ++Node)
+	{
+		if (Parents[Node] == TransformHierarchyNoParent)
+		{
+			Order.push_back(Node);
+			Depths.push_back(0);
+		}
+	}
+	for (size_t Head = 0; Head < Order.size(); ++Head)
+	{
+		uint32_t Node = Order[Head];
+		for (uint32_t Child = ChildStarts[Node]; Child < ChildStarts[Node + 1]; ++Child)
+		{
+			Order.push_back(Children[Child]);
+			Depths.push_back(Depths[Head] + 1);
+		}
+	}
+
+	//Anything not reached is part of a cycle
+	Check(Order.size() == Count);
+
+	mSlotOfNode.assign(Count, 0);
+	for (uint32_t Slot = 0; Slot < Count; ++Slot)
+	{
+		mSlotOfNode[Order[Slot]] = Slot;
+	}
+
+	mParentSlots.resize(Count);
+	mLevelStarts.assign(1, 0);
+	for (uint32_t Slot = 0; Slot < Count; ++Slot)
+	{
+		uint32_t Parent = Parents[Order[Slot]];
+		mParentSlots[Slot] = Parent != TransformHierarchyNoParent ? mSlotOfNode[Parent] : TransformHierarchyNoParent;
+
+		if (Slot > 0 && Depths[Slot] != Depths[Slot - 1])
+		{
+			mLevelStarts.push_back(Slot);
+		}
+	}
+	if (Count > 0)
+	{
+		mLevelStarts.push_back(Count);
+	}
+
+	mPositionX.assign(Count, 0.0f);
+	mPositionY.assign(Count, 0.0f);
+	mPositionZ.assign(Count, 0.0f);
+	mRotationX.assign(Count, 0.0f);
+	mRotationY.assign(Count, 0.0f);
+	mRotationZ.assign(Count, 0.0f);
+	mRotationW.assign(Count, 1.0f);
+	mScale.assign(Count, 1.0f);
+	mDirty.assign(Count, 1);
+	mUpdated.assign(Count, 0);
+	mWorld.resize(Count);
+}
+
+void TransformHierarchy::SetLocalTransform(uint32_t Node, const float Position[3], const float Rotation[4], float Scale)
+{
+	uint32_t Slot = mSlotOfNode[Node];
+	mPositionX[Slot] = Position[0];
+	mPositionY[Slot] = Position[1];
+	mPositionZ[Slot] = Position[2];
+	mRotationX[Slot] = Rotation[0];
+	mRotationY[Slot] = Rotation[1];
+	mRotationZ[Slot] = Rotation[2];
+	mRotationW[Slot] = Rotation[3];
+	mScale[Slot] = Scale;
+	mDirty[Slot] = 1;
+}
+
+void TransformHierarchy::Update(JobSystem* Jobs)
+{
+	mStats = TransformHierarchyStats();
+	mStats.LevelCount = GetLevelCount();
+
+	for (uint32_t Level = 0; Level < GetLevelCount(); ++Level)
+	{
+		uint32_t Begin = mLevelStarts[Level];
+		uint32_t End = mLevelStarts[Level + 1];
+		bool bRootLevel = Level == 0;
+
+		if (!Jobs || End - Begin < ParallelThreshold)
+		{
+			mStats.NodesUpdated += UpdateRange(Begin, End, bRootLevel);
+			continue;
+		}
+
+		//ParallelFor returns once the whole level is done, so the next level
+		//always sees final parents
+		++mStats.ParallelLevels;
+		std::atomic<uint32_t> NodesUpdated(0);
+		uint32_t BatchCount = (End - Begin + ParallelBatchSize - 1) / ParallelBatchSize;
+		Jobs->ParallelFor(BatchCount, 1, [this, Begin, End, bRootLevel, &NodesUpdated](uint32_t BatchBegin, uint32_t BatchEnd)
+		{
+			uint32_t RangeBegin = Begin + BatchBegin * ParallelBatchSize;
+			uint32_t RangeEnd = std::min(End, Begin + BatchEnd * ParallelBatchSize);
+			NodesUpdated.fetch_add(UpdateRange(RangeBegin, RangeEnd, bRootLevel), std::memory_order_relaxed);
+		});
+		mStats.NodesUpdated += NodesUpdated.load();
+	}
+}
+
+uint32_t TransformHierarchy::UpdateRange(uint32_t Begin, uint32_t End, bool bRootLevel)
+{
+	uint32_t NodesUpdated = 0;
+	uint32_t Slot = Begin;
+
+	for (; Slot + SimdFloat4::Width <= End; Slot += SimdFloat4::Width)
+	{
+		//Whole group is recomputed if any of it needs it - recomputing a
+		//clean node gives the same result
+		uint32_t NeedsUpdate = 0;
+		for (uint32_t Lane = 0; Lane < SimdFloat4::Width; ++Lane)
+		{
+			uint8_t bNeeds = mDirty[Slot + Lane] | (bRootLevel ? 0 : mUpdated[mParentSlots[Slot + Lane]]);
+			mUpdated[Slot + Lane] = bNeeds;
+			mDirty[Slot + Lane] = 0;
+			NeedsUpdate += bNeeds;
+		}
+		if (NeedsUpdate == 0)
+		{
+			continue;
+		}
+		NodesUpdated += NeedsUpdate;
+
+		Matrix3x4Batch<SimdFloat4> World = MatrixFromTrs(
+			Float3Batch<SimdFloat4>::LoadUnaligned(mPositionX.data(), mPositionY.data(), mPositionZ.data(), Slot),
+			QuaternionBatch<SimdFloat4>::LoadUnaligned(mRotationX.data(), mRotationY.data(), mRotationZ.data(), mRotationW.data(), Slot),
+			SimdFloat4::LoadUnaligned(&mScale[Slot]));
+
+		if (!bRootLevel)
+		{
+			const Matrix3x4* Parents[SimdFloat4::Width] =
+			{
+				&mWorld[mParentSlots[Slot + 0]], &mWorld[mParentSlots[Slot + 1]],
+				&mWorld[mParentSlots[Slot + 2]], &mWorld[mParentSlots[Slot + 3]]
+			};
+			World = Multiply(Matrix3x4Batch<SimdFloat4>::Gather(Parents), World);
+		}
+
+		Matrix3x4* Out[SimdFloat4::Width] = { &mWorld[Slot + 0], &mWorld[Slot + 1], &mWorld[Slot + 2], &mWorld[Slot + 3] };
+		World.Scatter(Out);
+	}
+
+	for (; Slot < End; ++Slot)
+	{
+		uint8_t bNeeds = mDirty[Slot] | (bRootLevel ? 0 : mUpdated[mParentSlots[Slot]]);
+		mUpdated[Slot] = bNeeds;
+		mDirty[Slot] = 0;
+		if (bNeeds)
+		{
+			UpdateSlot(Slot, bRootLevel);
+			++NodesUpdated;
+		}
+	}
+
+	return NodesUpdated;
+}
+
+void TransformHierarchy::UpdateSlot(uint32_t Slot, bool bRootLevel)
+{
+	Matrix3x4 Local = MatrixFromTrs(MakeFloat3(mPositionX[Slot], mPositionY[Slot], mPositionZ[Slot]),
+		MakeQuaternion(mRotationX[Slot], mRotationY[Slot], mRotationZ[Slot], mRotationW[Slot]), mScale[Slot]);
+	mWorld[Slot] = bRootLevel ? Local : Multiply(mWorld[mParentSlots[Slot]], Local);
+}
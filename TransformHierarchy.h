@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "VectorMath.h"
+
+class JobSystem;
+
+const uint32_t TransformHierarchyNoParent = 0xFFFFFFFF;
+
+struct TransformHierarchyStats
+{
+	uint32_t NodesUpdated = 0;		//Dirty, or below something dirty
+	uint32_t LevelCount = 0;
+	uint32_t ParallelLevels = 0;	//Levels big enough to split across jobs
+};
+
+//Parent/child transforms, stored and updated level by level.
+//
+//Nodes are kept in breadth first order - every node of depth N before any of
+//depth N+1 - with local transforms as structure of arrays. Update() walks the
+//levels in order, so a node's parent world matrix is always final by the time
+//it's read, and within a level nodes are independent: they're done four at a
+//time with SIMD (local TRS to matrix, then parent * local) and big levels are
+//split across the job system.
+//
+//Only dirty nodes and their descendants are recomputed. A group of four with
+//nothing dirty is skipped without touching its transforms.
+class TransformHierarchy
+{
+public:
+	TransformHierarchy();
+	~TransformHierarchy();
+
+	//Parents[i] is the parent of node i or TransformHierarchyNoParent, in any
+	//order as long as there are no cycles. Every node starts as identity and dirty.
+	void Build(const uint32_t* Parents, uint32_t Count);
+
+	uint32_t GetNodeCount() const { return static_cast<uint32_t>(mSlotOfNode.size()); }
+	uint32_t GetLevelCount() const { return static_cast<uint32_t>(mLevelStarts.size() - 1); }
+
+	//Rotation is a unit quaternion (x, y, z, w). Marks the node dirty.
+	void SetLocalTransform(uint32_t Node, const float Position[3], const float Rotation[4], float Scale);
+
+	//Up to date as of the last Update().
+	const Matrix3x4& GetWorldMatrix(uint32_t Node) const { return mWorld[mSlotOfNode[Node]]; }
+
+	//Recomputes world matrices for dirty subtrees. Levels with at least
+	//ParallelThreshold nodes are split across Jobs if given.
+	void Update(JobSystem* Jobs = nullptr);
+
+	const TransformHierarchyStats& GetLastUpdateStats() const { return mStats; }
+
+	static const uint32_t ParallelThreshold = 4096;
+
+private:
+	//Slots [Begin, End) of one level. Returns how many needed updating.
+	uint32_t UpdateRange(uint32_t Begin, uint32_t End, bool bRootLevel);
+
+	void UpdateSlot(uint32_t Slot, bool bRootLevel);
+
+private:
+	//Indexed by slot (breadth first position)
+	std::vector<uint32_t> mParentSlots;
+	std::vector<float> mPositionX, mPositionY, mPositionZ;
+	std::vector<float> mRotationX, mRotationY, mRotationZ, mRotationW;
+	std::vector<float> mScale;
+	std::vector<uint8_t> mDirty;
+	std::vector<uint8_t> mUpdated;		//This Update(), for the level below
+	std::vector<Matrix3x4> mWorld;
+
+	std::vector<uint32_t> mSlotOfNode;
+	std::vector<uint32_t> mLevelStarts;	//LevelCount + 1 entries
+
+	TransformHierarchyStats mStats;
+};
@@ -0,0 +1,78 @@
+#include "UploadRing.h"
+#include "Common.h"
+
+UploadRing::UploadRing(IFence* Fence, uint8_t* Memory, uint64_t GpuAddress, uint64_t Size)
+	: mFence(Fence)
+	, mMemory(Memory)
+	, mGpuAddress(GpuAddress)
+	, mSize(Size)
+	, mHead(0)
+	, mTail(0)
+	, mStallCount(0)
+{
+	Assert(mFence && mMemory && mSize > 0);
+}
+
+UploadRing::~UploadRing()
+{}
+
+UploadAllocation UploadRing::Allocate(uint64_t Size, uint64_t Alignment)
+{
+	Assert(Alignment > 0 && (Alignment & (Alignment - 1)) == 0);
+
+	uint64_t Offset = mHead % mSize;
+	uint64_t Start = (Offset + Alignment - 1) & ~(Alignment - 1);
+	if (Start + Size > mSize)
+	{
+		Start = 0;
+	}
+	uint64_t NewHead = mHead + (Start >= Offset ? Start - Offset : mSize - Offset) + Size;
+
+	while (NewHead - mTail > mSize && !mFrames.empty())
+	{
+		const Frame& Oldest = mFrames.front();
+		if (!mFence->IsComplete(Oldest.FenceValue))
+		{
+			if (Oldest.FenceValue > mFence->GetLastSignalledValue())
+			{
+				mFence->Signal();
+			}
+			mFence->WaitForValue(Oldest.FenceValue);
+			++mStallCount;
+		}
+		mTail = Oldest.End;
+		mFrames.pop_front();
+	}
+
+	//Only the current frame is left, so it's holding too much
+	Check(NewHead - mTail <= mSize);
+
+	mHead = NewHead;
+
+	UploadAllocation Allocation;
+	Allocation.Cpu = mMemory + Start;
+	Allocation.GpuAddress = mGpuAddress + Start;
+	Allocation.Offset = Start;
+	Allocation.Size = Size;
+	return Allocation;
+}
+
+void UploadRing::EndFrame()
+{
+	Frame Ended;
+	Ended.FenceValue = mFence->GetLastSignalledValue() + 1;
+	Ended.End = mHead;
+	mFrames.push_back(Ended);
+
+	Retire();
+}
+
+void UploadRing::Retire()
+{
+	uint64_t CompletedValue = mFence->GetCompletedValue();
+	while (!mFrames.empty() && mFrames.front().FenceValue <= CompletedValue)
+	{
+		mTail = mFrames.front().End;
+		mFrames.pop_front();
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+
+#include "IFence.h"
+
+struct UploadAllocation
+{
+	uint8_t* Cpu = nullptr;			//Write only for upload heap memory
+	uint64_t GpuAddress = 0;
+	uint64_t Offset = 0;			//From the start of the ring's memory
+	uint64_t Size = 0;
+};
+
+//Per frame upload memory - constants, instance data and the like - allocated
+//linearly from one persistently mapped buffer and recycled as the GPU
+//finishes with it.
+//
+//EndFrame() tags everything allocated since the last one with the fence value
+//of the next signal, as DeferredReleaseQueue does. When an allocation doesn't
+//fit, the oldest frames are retired - waiting on the fence if the GPU hasn't
+//got to them - until it does. Allocations never straddle the end of the
+//buffer; the space left there is skipped.
+//
+//Main thread only.
+class UploadRing
+{
+public:
+	static const uint64_t DefaultAlignment = 256;	//Constant buffer placement
+
+	//Memory is Size bytes the CPU writes and the GPU reads at GpuAddress - a
+	//mapped upload heap buffer, or any memory for headless runs.
+	UploadRing(IFence* Fence, uint8_t* Memory, uint64_t GpuAddress, uint64_t Size);
+	~UploadRing();
+
+	//Alignment is a power of two. Size must fit in the ring with whatever the
+	//current frame already holds.
+	UploadAllocation Allocate(uint64_t Size, uint64_t Alignment = DefaultAlignment);
+
+	void EndFrame();
+
+	//Retires frames the GPU has finished with. Cheap when there's nothing to do.
+	void Retire();
+
+	uint64_t GetSize() const { return mSize; }
+	uint64_t GetUsedBytes() const { return mHead - mTail; }
+	uint64_t GetStallCount() const { return mStallCount; }
+
+private:
+	struct Frame
+	{
+		uint64_t FenceValue;
+		uint64_t End;
+	};
+
+	IFence* mFence;
+	uint8_t* mMemory;
+	uint64_t mGpuAddress;
+	uint64_t mSize;
+
+	//Bytes ever allocated and ever retired; their difference is in use
+	uint64_t mHead;
+	uint64_t mTail;
+	std::deque<Frame> mFrames;
+
+	uint64_t mStallCount;
+};
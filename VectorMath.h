@@ -0,0 +1,589 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+#include "SimdFloat.h"
+
+//Engine math. Two flavours of the same operations:
+//	AoS	- Float3, Quaternion, Matrix3x4, Aabb: one value at a time, for
+//		  gameplay code and anything not in a hot loop
+//	SoA	- Float3Batch<V>, QuaternionBatch<V>, Matrix3x4Batch<V>, AabbBatch<V>:
+//		  V::Width values at a time, one per lane of a SimdFloat1/4/8
+//
+//Matrices are 3x4 affines, row major with the translation in column 3, and
+//transform column vectors: p' = M * [p, 1]. Multiply(A, B) applies B first.
+
+struct Float3
+{
+	float X, Y, Z;
+};
+
+inline Float3 MakeFloat3(float X, float Y, float Z) { Float3 Result = { X, Y, Z }; return Result; }
+
+inline Float3 operator+(const Float3& A, const Float3& B) { return MakeFloat3(A.X + B.X, A.Y + B.Y, A.Z + B.Z); }
+inline Float3 operator-(const Float3& A, const Float3& B) { return MakeFloat3(A.X - B.X, A.Y - B.Y, A.Z - B.Z); }
+inline Float3 operator*(const Float3& A, float S) { return MakeFloat3(A.X * S, A.Y * S, A.Z * S); }
+//Compares rather than fminf/fmaxf, which are library calls unless NaN rules are relaxed
+inline Float3 Min(const Float3& A, const Float3& B) { return MakeFloat3(B.X < A.X ? B.X : A.X, B.Y < A.Y ? B.Y : A.Y, B.Z < A.Z ? B.Z : A.Z); }
+inline Float3 Max(const Float3& A, const Float3& B) { return MakeFloat3(A.X < B.X ? B.X : A.X, A.Y < B.Y ? B.Y : A.Y, A.Z < B.Z ? B.Z : A.Z); }
+inline float Dot(const Float3& A, const Float3& B) { return A.X * B.X + A.Y * B.Y + A.Z * B.Z; }
+inline Float3 Cross(const Float3& A, const Float3& B)
+{
+	return MakeFloat3(A.Y * B.Z - A.Z * B.Y, A.Z * B.X - A.X * B.Z, A.X * B.Y - A.Y * B.X);
+}
+inline float Length(const Float3& A) { return sqrtf(Dot(A, A)); }
+inline Float3 Normalize(const Float3& A) { return A * (1.0f / Length(A)); }
+
+//Unit rotation quaternion
+struct Quaternion
+{
+	float X, Y, Z, W;
+};
+
+inline Quaternion MakeQuaternion(float X, float Y, float Z, float W) { Quaternion Result = { X, Y, Z, W }; return Result; }
+inline Quaternion QuaternionIdentity() { return MakeQuaternion(0.0f, 0.0f, 0.0f, 1.0f); }
+
+//Axis must be unit length
+inline Quaternion QuaternionFromAxisAngle(const Float3& Axis, float Angle)
+{
+	float Sin = sinf(Angle * 0.5f);
+	return MakeQuaternion(Axis.X * Sin, Axis.Y * Sin, Axis.Z * Sin, cosf(Angle * 0.5f));
+}
+
+//Rotation B then A
+inline Quaternion Multiply(const Quaternion& A, const Quaternion& B)
+{
+	return MakeQuaternion(
+		A.W * B.X + A.X * B.W + A.Y * B.Z - A.Z * B.Y,
+		A.W * B.Y - A.X * B.Z + A.Y * B.W + A.Z * B.X,
+		A.W * B.Z + A.X * B.Y - A.Y * B.X + A.Z * B.W,
+		A.W * B.W - A.X * B.X - A.Y * B.Y - A.Z * B.Z);
+}
+
+struct alignas(16) Matrix3x4
+{
+	float Rows[3][4];
+};
+
+inline Matrix3x4 Matrix3x4Identity()
+{
+	Matrix3x4 Result = { { { 1.0f, 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f, 0.0f } } };
+	return Result;
+}
+
+//Scale, then rotate, then translate
+inline Matrix3x4 MatrixFromTrs(const Float3& Position, const Quaternion& Rotation, float Scale)
+{
+	const float XX = Rotation.X * Rotation.X, YY = Rotation.Y * Rotation.Y, ZZ = Rotation.Z * Rotation.Z;
+	const float XY = Rotation.X * Rotation.Y, XZ = Rotation.X * Rotation.Z, YZ = Rotation.Y * Rotation.Z;
+	const float WX = Rotation.W * Rotation.X, WY = Rotation.W * Rotation.Y, WZ = Rotation.W * Rotation.Z;
+	const float TwoS = 2.0f * Scale;
+
+	Matrix3x4 Result;
+	Result.Rows[0][0] = (1.0f - 2.0f * (YY + ZZ)) * Scale;
+	Result.Rows[0][1] = (XY - WZ) * TwoS;
+	Result.Rows[0][2] = (XZ + WY) * TwoS;
+	Result.Rows[0][3] = Position.X;
+	Result.Rows[1][0] = (XY + WZ) * TwoS;
+	Result.Rows[1][1] = (1.0f - 2.0f * (XX + ZZ)) * Scale;
+	Result.Rows[1][2] = (YZ - WX) * TwoS;
+	Result.Rows[1][3] = Position.Y;
+	Result.Rows[2][0] = (XZ - WY) * TwoS;
+	Result.Rows[2][1] = (YZ + WX) * TwoS;
+	Result.Rows[2][2] = (1.0f - 2.0f * (XX + YY)) * Scale;
+	Result.Rows[2][3] = Position.Z;
+	return Result;
+}
+
+inline Matrix3x4 Multiply(const Matrix3x4& A, const Matrix3x4& B)
+{
+	Matrix3x4 Result;
+	for (int Row = 0; Row < 3; ++Row)
+	{
+		for (int Column = 0; Column < 4; ++Column)
+		{
+			Result.Rows[Row][Column] = A.Rows[Row][0] * B.Rows[0][Column] + A.Rows[Row][1] * B.Rows[1][Column] +
+				A.Rows[Row][2] * B.Rows[2][Column];
+		}
+		Result.Rows[Row][3] += A.Rows[Row][3];
+	}
+	return Result;
+}
+
+inline Float3 TransformPoint(const Matrix3x4& M, const Float3& P)
+{
+	return MakeFloat3(
+		M.Rows[0][0] * P.X + M.Rows[0][1] * P.Y + M.Rows[0][2] * P.Z + M.Rows[0][3],
+		M.Rows[1][0] * P.X + M.Rows[1][1] * P.Y + M.Rows[1][2] * P.Z + M.Rows[1][3],
+		M.Rows[2][0] * P.X + M.Rows[2][1] * P.Y + M.Rows[2][2] * P.Z + M.Rows[2][3]);
+}
+
+inline Float3 TransformVector(const Matrix3x4& M, const Float3& V)
+{
+	return MakeFloat3(
+		M.Rows[0][0] * V.X + M.Rows[0][1] * V.Y + M.Rows[0][2] * V.Z,
+		M.Rows[1][0] * V.X + M.Rows[1][1] * V.Y + M.Rows[1][2] * V.Z,
+		M.Rows[2][0] * V.X + M.Rows[2][1] * V.Y + M.Rows[2][2] * V.Z);
+}
+
+struct Aabb
+{
+	Float3 Min;
+	Float3 Max;
+};
+
+inline Aabb Union(const Aabb& A, const Aabb& B)
+{
+	Aabb Result = { Min(A.Min, B.Min), Max(A.Max, B.Max) };
+	return Result;
+}
+
+inline Aabb Expand(const Aabb& Box, float Margin)
+{
+	Float3 Offset = MakeFloat3(Margin, Margin, Margin);
+	Aabb Result = { Box.Min - Offset, Box.Max + Offset };
+	return Result;
+}
+
+inline bool Contains(const Aabb& Outer, const Aabb& Inner)
+{
+	return Inner.Min.X >= Outer.Min.X && Inner.Min.Y >= Outer.Min.Y && Inner.Min.Z >= Outer.Min.Z &&
+		Inner.Max.X <= Outer.Max.X && Inner.Max.Y <= Outer.Max.Y && Inner.Max.Z <= Outer.Max.Z;
+}
+
+inline bool Intersects(const Aabb& A, const Aabb& B)
+{
+	return A.Min.X <= B.Max.X && A.Min.Y <= B.Max.Y && A.Min.Z <= B.Max.Z &&
+		B.Min.X <= A.Max.X && B.Min.Y <= A.Max.Y && B.Min.Z <= A.Max.Z;
+}
+
+inline float SurfaceArea(const Aabb& Box)
+{
+	Float3 Size = Box.Max - Box.Min;
+	return 2.0f * (Size.X * Size.Y + Size.Y * Size.Z + Size.Z * Size.X);
+}
+
+//Bounds of the transformed box - centre moves by M, extents by |M|
+inline Aabb TransformAabb(const Matrix3x4& M, const Aabb& Box)
+{
+	Float3 Centre = (Box.Min + Box.Max) * 0.5f;
+	Float3 Extents = (Box.Max - Box.Min) * 0.5f;
+
+	Float3 NewCentre = TransformPoint(M, Centre);
+	Float3 NewExtents = MakeFloat3(
+		fabsf(M.Rows[0][0]) * Extents.X + fabsf(M.Rows[0][1]) * Extents.Y + fabsf(M.Rows[0][2]) * Extents.Z,
+		fabsf(M.Rows[1][0]) * Extents.X + fabsf(M.Rows[1][1]) * Extents.Y + fabsf(M.Rows[1][2]) * Extents.Z,
+		fabsf(M.Rows[2][0]) * Extents.X + fabsf(M.Rows[2][1]) * Extents.Y + fabsf(M.Rows[2][2]) * Extents.Z);
+
+	Aabb Result = { NewCentre - NewExtents, NewCentre + NewExtents };
+	return Result;
+}
+
+//Full 4x4 for projections, same column vector convention
+struct alignas(16) Matrix4x4
+{
+	float Rows[4][4];
+};
+
+inline Matrix4x4 Multiply(const Matrix4x4& A, const Matrix4x4& B)
+{
+	Matrix4x4 Result;
+	for (int Row = 0; Row < 4; ++Row)
+	{
+		for (int Column = 0; Column < 4; ++Column)
+		{
+			Result.Rows[Row][Column] = A.Rows[Row][0] * B.Rows[0][Column] + A.Rows[Row][1] * B.Rows[1][Column] +
+				A.Rows[Row][2] * B.Rows[2][Column] + A.Rows[Row][3] * B.Rows[3][Column];
+		}
+	}
+	return Result;
+}
+
+//The affine as a full matrix, bottom row 0 0 0 1
+inline Matrix4x4 MakeMatrix4x4(const Matrix3x4& M)
+{
+	Matrix4x4 Result =
+	{ {
+		{ M.Rows[0][0], M.Rows[0][1], M.Rows[0][2], M.Rows[0][3] },
+		{ M.Rows[1][0], M.Rows[1][1], M.Rows[1][2], M.Rows[1][3] },
+		{ M.Rows[2][0], M.Rows[2][1], M.Rows[2][2], M.Rows[2][3] },
+		{ 0.0f, 0.0f, 0.0f, 1.0f },
+	} };
+	return Result;
+}
+
+struct Float4
+{
+	float X, Y, Z, W;
+};
+
+//Homogeneous result, e.g. clip space from a view-projection
+inline Float4 TransformPoint(const Matrix4x4& M, const Float3& P)
+{
+	Float4 Result;
+	Result.X = M.Rows[0][0] * P.X + M.Rows[0][1] * P.Y + M.Rows[0][2] * P.Z + M.Rows[0][3];
+	Result.Y = M.Rows[1][0] * P.X + M.Rows[1][1] * P.Y + M.Rows[1][2] * P.Z + M.Rows[1][3];
+	Result.Z = M.Rows[2][0] * P.X + M.Rows[2][1] * P.Y + M.Rows[2][2] * P.Z + M.Rows[2][3];
+	Result.W = M.Rows[3][0] * P.X + M.Rows[3][1] * P.Y + M.Rows[3][2] * P.Z + M.Rows[3][3];
+	return Result;
+}
+
+//Left handed: looking down +Z with +Y up
+inline Matrix4x4 MatrixLookAtLH(const Float3& Eye, const Float3& Target, const Float3& Up)
+{
+	Float3 AxisZ = Normalize(Target - Eye);
+	Float3 AxisX = Normalize(Cross(Up, AxisZ));
+	Float3 AxisY = Cross(AxisZ, AxisX);
+
+	Matrix4x4 Result =
+	{ {
+		{ AxisX.X, AxisX.Y, AxisX.Z, -Dot(AxisX, Eye) },
+		{ AxisY.X, AxisY.Y, AxisY.Z, -Dot(AxisY, Eye) },
+		{ AxisZ.X, AxisZ.Y, AxisZ.Z, -Dot(AxisZ, Eye) },
+		{ 0.0f, 0.0f, 0.0f, 1.0f },
+	} };
+	return Result;
+}
+
+//Left handed, depth 0 at Near to 1 at Far as D3D expects
+inline Matrix4x4 MatrixPerspectiveFovLH(float FovY, float Aspect, float Near, float Far)
+{
+	float ScaleY = 1.0f / tanf(FovY * 0.5f);
+	float ScaleX = ScaleY / Aspect;
+	float Range = Far / (Far - Near);
+
+	Matrix4x4 Result =
+	{ {
+		{ ScaleX, 0.0f, 0.0f, 0.0f },
+		{ 0.0f, ScaleY, 0.0f, 0.0f },
+		{ 0.0f, 0.0f, Range, -Near * Range },
+		{ 0.0f, 0.0f, 1.0f, 0.0f },
+	} };
+	return Result;
+}
+
+//Points with Dot(Normal, p) + Distance >= 0 are on the inside
+struct Plane
+{
+	Float3 Normal;
+	float Distance;
+};
+
+struct Frustum
+{
+	Plane Planes[6];	//Left, right, bottom, top, near, far
+};
+
+//The clip space bounds -w <= x, y <= w and 0 <= z <= w as world space planes
+inline Frustum FrustumFromViewProjection(const Matrix4x4& ViewProjection)
+{
+	const float (*M)[4] = ViewProjection.Rows;
+	const float Coefficients[6][4] =
+	{
+		{ M[3][0] + M[0][0], M[3][1] + M[0][1], M[3][2] + M[0][2], M[3][3] + M[0][3] },
+		{ M[3][0] - M[0][0], M[3][1] - M[0][1], M[3][2] - M[0][2], M[3][3] - M[0][3] },
+		{ M[3][0] + M[1][0], M[3][1] + M[1][1], M[3][2] + M[1][2], M[3][3] + M[1][3] },
+		{ M[3][0] - M[1][0], M[3][1] - M[1][1], M[3][2] - M[1][2], M[3][3] - M[1][3] },
+		{ M[2][0], M[2][1], M[2][2], M[2][3] },
+		{ M[3][0] - M[2][0], M[3][1] - M[2][1], M[3][2] - M[2][2], M[3][3] - M[2][3] },
+	};
+
+	Frustum Result;
+	for (int i = 0; i < 6; ++i)
+	{
+		Float3 Normal = MakeFloat3(Coefficients[i][0], Coefficients[i][1], Coefficients[i][2]);
+		float InverseLength = 1.0f / Length(Normal);
+		Result.Planes[i].Normal = Normal * InverseLength;
+		Result.Planes[i].Distance = Coefficients[i][3] * InverseLength;
+	}
+	return Result;
+}
+
+//False only if the box is entirely outside one plane. Conservative: boxes
+//near a frustum corner can pass without touching it.
+inline bool IsAabbInFrustum(const Frustum& View, const Aabb& Box)
+{
+	Float3 Centre = (Box.Min + Box.Max) * 0.5f;
+	Float3 Extents = (Box.Max - Box.Min) * 0.5f;
+	for (const Plane& Side : View.Planes)
+	{
+		float Distance = Dot(Side.Normal, Centre) + Side.Distance;
+		float Radius = fabsf(Side.Normal.X) * Extents.X + fabsf(Side.Normal.Y) * Extents.Y + fabsf(Side.Normal.Z) * Extents.Z;
+		if (Distance < -Radius)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+//SoA batches
+
+template<typename V>
+struct Float3Batch
+{
+	V X, Y, Z;
+
+	static Float3Batch Splat(const Float3& Value)
+	{
+		Float3Batch Result = { V::Splat(Value.X), V::Splat(Value.Y), V::Splat(Value.Z) };
+		return Result;
+	}
+
+	//V::Width values from each of three arrays, starting at Index
+	static Float3Batch LoadUnaligned(const float* X, const float* Y, const float* Z, uint32_t Index)
+	{
+		Float3Batch Result = { V::LoadUnaligned(X + Index), V::LoadUnaligned(Y + Index), V::LoadUnaligned(Z + Index) };
+		return Result;
+	}
+
+	void StoreUnaligned(float* OutX, float* OutY, float* OutZ, uint32_t Index) const
+	{
+		X.StoreUnaligned(OutX + Index);
+		Y.StoreUnaligned(OutY + Index);
+		Z.StoreUnaligned(OutZ + Index);
+	}
+};
+
+template<typename V>
+struct QuaternionBatch
+{
+	V X, Y, Z, W;
+
+	static QuaternionBatch LoadUnaligned(const float* X, const float* Y, const float* Z, const float* W, uint32_t Index)
+	{
+		QuaternionBatch Result = { V::LoadUnaligned(X + Index), V::LoadUnaligned(Y + Index),
+			V::LoadUnaligned(Z + Index), V::LoadUnaligned(W + Index) };
+		return Result;
+	}
+};
+
+template<typename V>
+struct Matrix3x4Batch
+{
+	V Rows[3][4];
+
+	static Matrix3x4Batch Splat(const Matrix3x4& Value)
+	{
+		Matrix3x4Batch Result;
+		for (int Row = 0; Row < 3; ++Row)
+		{
+			for (int Column = 0; Column < 4; ++Column)
+			{
+				Result.Rows[Row][Column] = V::Splat(Value.Rows[Row][Column]);
+			}
+		}
+		return Result;
+	}
+
+	//Element (Row, Column) of matrix Index + Lane is at Elements[Row * 4 + Column][Index + Lane].
+	//Written out rather than looped - not every compiler unrolls a loop this
+	//size, and a rolled one keeps the batch in memory.
+	static Matrix3x4Batch LoadUnaligned(const float* const Elements[12], uint32_t Index)
+	{
+		Matrix3x4Batch Result;
+		Result.Rows[0][0] = V::LoadUnaligned(Elements[0] + Index);
+		Result.Rows[0][1] = V::LoadUnaligned(Elements[1] + Index);
+		Result.Rows[0][2] = V::LoadUnaligned(Elements[2] + Index);
+		Result.Rows[0][3] = V::LoadUnaligned(Elements[3] + Index);
+		Result.Rows[1][0] = V::LoadUnaligned(Elements[4] + Index);
+		Result.Rows[1][1] = V::LoadUnaligned(Elements[5] + Index);
+		Result.Rows[1][2] = V::LoadUnaligned(Elements[6] + Index);
+		Result.Rows[1][3] = V::LoadUnaligned(Elements[7] + Index);
+		Result.Rows[2][0] = V::LoadUnaligned(Elements[8] + Index);
+		Result.Rows[2][1] = V::LoadUnaligned(Elements[9] + Index);
+		Result.Rows[2][2] = V::LoadUnaligned(Elements[10] + Index);
+		Result.Rows[2][3] = V::LoadUnaligned(Elements[11] + Index);
+		return Result;
+	}
+
+	void StoreUnaligned(float* const Elements[12], uint32_t Index) const
+	{
+		Rows[0][0].StoreUnaligned(Elements[0] + Index);
+		Rows[0][1].StoreUnaligned(Elements[1] + Index);
+		Rows[0][2].StoreUnaligned(Elements[2] + Index);
+		Rows[0][3].StoreUnaligned(Elements[3] + Index);
+		Rows[1][0].StoreUnaligned(Elements[4] + Index);
+		Rows[1][1].StoreUnaligned(Elements[5] + Index);
+		Rows[1][2].StoreUnaligned(Elements[6] + Index);
+		Rows[1][3].StoreUnaligned(Elements[7] + Index);
+		Rows[2][0].StoreUnaligned(Elements[8] + Index);
+		Rows[2][1].StoreUnaligned(Elements[9] + Index);
+		Rows[2][2].StoreUnaligned(Elements[10] + Index);
+		Rows[2][3].StoreUnaligned(Elements[11] + Index);
+	}
+
+	//Lane N from *Matrices[N]
+	static Matrix3x4Batch Gather(const Matrix3x4* const Matrices[])
+	{
+		alignas(32) float Lanes[V::Width];
+		Matrix3x4Batch Result;
+		for (int Row = 0; Row < 3; ++Row)
+		{
+			for (int Column = 0; Column < 4; ++Column)
+			{
+				for (uint32_t Lane = 0; Lane < V::Width; ++Lane)
+				{
+					Lanes[Lane] = Matrices[Lane]->Rows[Row][Column];
+				}
+				Result.Rows[Row][Column] = V::Load(Lanes);
+			}
+		}
+		return Result;
+	}
+
+	//Lane N to *Matrices[N]
+	void Scatter(Matrix3x4* const Matrices[]) const
+	{
+		alignas(32) float Lanes[V::Width];
+		for (int Row = 0; Row < 3; ++Row)
+		{
+			for (int Column = 0; Column < 4; ++Column)
+			{
+				Rows[Row][Column].Store(Lanes);
+				for (uint32_t Lane = 0; Lane < V::Width; ++Lane)
+				{
+					Matrices[Lane]->Rows[Row][Column] = Lanes[Lane];
+				}
+			}
+		}
+	}
+};
+
+#if defined(SIMD_FLOAT_SSE) || defined(SIMD_FLOAT_NEON)
+
+//Four matrices are one 4x4 transpose per row
+template<>
+inline Matrix3x4Batch<SimdFloat4> Matrix3x4Batch<SimdFloat4>::Gather(const Matrix3x4* const Matrices[])
+{
+	Matrix3x4Batch Result;
+	for (int Row = 0; Row < 3; ++Row)
+	{
+		SimdFloat4* Out = Result.Rows[Row];
+		Out[0] = SimdFloat4::Load(Matrices[0]->Rows[Row]);
+		Out[1] = SimdFloat4::Load(Matrices[1]->Rows[Row]);
+		Out[2] = SimdFloat4::Load(Matrices[2]->Rows[Row]);
+		Out[3] = SimdFloat4::Load(Matrices[3]->Rows[Row]);
+		Transpose(Out[0], Out[1], Out[2], Out[3]);
+	}
+	return Result;
+}
+
+template<>
+inline void Matrix3x4Batch<SimdFloat4>::Scatter(Matrix3x4* const Matrices[]) const
+{
+	for (int Row = 0; Row < 3; ++Row)
+	{
+		SimdFloat4 Columns[4] = { Rows[Row][0], Rows[Row][1], Rows[Row][2], Rows[Row][3] };
+		Transpose(Columns[0], Columns[1], Columns[2], Columns[3]);
+		Columns[0].Store(Matrices[0]->Rows[Row]);
+		Columns[1].Store(Matrices[1]->Rows[Row]);
+		Columns[2].Store(Matrices[2]->Rows[Row]);
+		Columns[3].Store(Matrices[3]->Rows[Row]);
+	}
+}
+
+#endif
+
+template<typename V>
+struct AabbBatch
+{
+	Float3Batch<V> Min;
+	Float3Batch<V> Max;
+};
+
+template<typename V>
+Matrix3x4Batch<V> MatrixFromTrs(const Float3Batch<V>& Position, const QuaternionBatch<V>& Rotation, const V& Scale)
+{
+	const V One = V::Splat(1.0f);
+	const V Two = V::Splat(2.0f);
+	const V XX = Rotation.X * Rotation.X, YY = Rotation.Y * Rotation.Y, ZZ = Rotation.Z * Rotation.Z;
+	const V XY = Rotation.X * Rotation.Y, XZ = Rotation.X * Rotation.Z, YZ = Rotation.Y * Rotation.Z;
+	const V WX = Rotation.W * Rotation.X, WY = Rotation.W * Rotation.Y, WZ = Rotation.W * Rotation.Z;
+	const V TwoS = Two * Scale;
+
+	Matrix3x4Batch<V> Result;
+	Result.Rows[0][0] = (One - Two * (YY + ZZ)) * Scale;
+	Result.Rows[0][1] = (XY - WZ) * TwoS;
+	Result.Rows[0][2] = (XZ + WY) * TwoS;
+	Result.Rows[0][3] = Position.X;
+	Result.Rows[1][0] = (XY + WZ) * TwoS;
+	Result.Rows[1][1] = (One - Two * (XX + ZZ)) * Scale;
+	Result.Rows[1][2] = (YZ - WX) * TwoS;
+	Result.Rows[1][3] = Position.Y;
+	Result.Rows[2][0] = (XZ - WY) * TwoS;
+	Result.Rows[2][1] = (YZ + WX) * TwoS;
+	Result.Rows[2][2] = (One - Two * (XX + YY)) * Scale;
+	Result.Rows[2][3] = Position.Z;
+	return Result;
+}
+
+template<typename V>
+Matrix3x4Batch<V> Multiply(const Matrix3x4Batch<V>& A, const Matrix3x4Batch<V>& B)
+{
+	Matrix3x4Batch<V> Result;
+	for (int Row = 0; Row < 3; ++Row)
+	{
+		for (int Column = 0; Column < 4; ++Column)
+		{
+			Result.Rows[Row][Column] = A.Rows[Row][0] * B.Rows[0][Column] + A.Rows[Row][1] * B.Rows[1][Column] +
+				A.Rows[Row][2] * B.Rows[2][Column];
+		}
+		Result.Rows[Row][3] = Result.Rows[Row][3] + A.Rows[Row][3];
+	}
+	return Result;
+}
+
+template<typename V>
+Float3Batch<V> TransformPoint(const Matrix3x4Batch<V>& M, const Float3Batch<V>& P)
+{
+	Float3Batch<V> Result;
+	Result.X = M.Rows[0][0] * P.X + M.Rows[0][1] * P.Y + M.Rows[0][2] * P.Z + M.Rows[0][3];
+	Result.Y = M.Rows[1][0] * P.X + M.Rows[1][1] * P.Y + M.Rows[1][2] * P.Z + M.Rows[1][3];
+	Result.Z = M.Rows[2][0] * P.X + M.Rows[2][1] * P.Y + M.Rows[2][2] * P.Z + M.Rows[2][3];
+	return Result;
+}
+
+template<typename V>
+AabbBatch<V> TransformAabb(const Matrix3x4Batch<V>& M, const AabbBatch<V>& Box)
+{
+	const V Half = V::Splat(0.5f);
+	Float3Batch<V> Centre = { (Box.Min.X + Box.Max.X) * Half, (Box.Min.Y + Box.Max.Y) * Half, (Box.Min.Z + Box.Max.Z) * Half };
+	Float3Batch<V> Extents = { (Box.Max.X - Box.Min.X) * Half, (Box.Max.Y - Box.Min.Y) * Half, (Box.Max.Z - Box.Min.Z) * Half };
+
+	Float3Batch<V> NewCentre = TransformPoint(M, Centre);
+	Float3Batch<V> NewExtents;
+	NewExtents.X = Abs(M.Rows[0][0]) * Extents.X + Abs(M.Rows[0][1]) * Extents.Y + Abs(M.Rows[0][2]) * Extents.Z;
+	NewExtents.Y = Abs(M.Rows[1][0]) * Extents.X + Abs(M.Rows[1][1]) * Extents.Y + Abs(M.Rows[1][2]) * Extents.Z;
+	NewExtents.Z = Abs(M.Rows[2][0]) * Extents.X + Abs(M.Rows[2][1]) * Extents.Y + Abs(M.Rows[2][2]) * Extents.Z;
+
+	AabbBatch<V> Result;
+	Result.Min.X = NewCentre.X - NewExtents.X;
+	Result.Min.Y = NewCentre.Y - NewExtents.Y;
+	Result.Min.Z = NewCentre.Z - NewExtents.Z;
+	Result.Max.X = NewCentre.X + NewExtents.X;
+	Result.Max.Y = NewCentre.Y + NewExtents.Y;
+	Result.Max.Z = NewCentre.Z + NewExtents.Z;
+	return Result;
+}
+
+//Count points in X/Y/Z arrays through one matrix, V::Width at a time with a
+//scalar tail. In and out may be the same arrays.
+template<typename V>
+void TransformPoints(const Matrix3x4& M, const float* X, const float* Y, const float* Z,
+	float* OutX, float* OutY, float* OutZ, uint32_t Count)
+{
+	const Matrix3x4Batch<V> Wide = Matrix3x4Batch<V>::Splat(M);
+	uint32_t i = 0;
+	for (; i + V::Width <= Count; i += V::Width)
+	{
+		TransformPoint(Wide, Float3Batch<V>::LoadUnaligned(X, Y, Z, i)).StoreUnaligned(OutX, OutY, OutZ, i);
+	}
+
+	const Matrix3x4Batch<SimdFloat1> Narrow = Matrix3x4Batch<SimdFloat1>::Splat(M);
+	for (; i < Count; ++i)
+	{
+		TransformPoint(Narrow, Float3Batch<SimdFloat1>::LoadUnaligned(X, Y, Z, i)).StoreUnaligned(OutX, OutY, OutZ, i);
+	}
+}
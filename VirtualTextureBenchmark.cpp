@@ -0,0 +1,368 @@
+#include "VirtualTextureBenchmark.h"
+#include "Common.h"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	double MillisecondsSince(Clock::time_point Start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - Start).count();
+	}
+
+	//Pages either side of the window centre that are sampled
+	const int32_t WindowPages = 48;
+
+	uint32_t MipCountForSize(uint32_t SizeInPages)
+	{
+		uint32_t MipCount = 1;
+		while ((SizeInPages >> MipCount) > 0 && MipCount < 16)
+		{
+			++MipCount;
+		}
+		return MipCount;
+	}
+
+	//One texture's feedback for a frame. The window pans a page a frame, each
+	//texture starting elsewhere; mips get coarser away from its centre.
+	void GenerateFeedback(std::mt19937& Random, uint32_t Frame, uint32_t Texture, const VirtualTextureDesc& Desc,
+		uint32_t Count, std::vector<uint32_t>& OutPageIds)
+	{
+		std::uniform_int_distribution<int32_t> Offset(-WindowPages, WindowPages);
+
+		int32_t Size = static_cast<int32_t>(Desc.WidthInPages);
+		int32_t CentreX = static_cast<int32_t>((Frame + Texture * 37) % Desc.WidthInPages);
+		int32_t CentreY = static_cast<int32_t>((Desc.HeightInPages / 2 + Texture * 53) % Desc.HeightInPages);
+
+		OutPageIds.resize(Count);
+		for (uint32_t i = 0; i < Count; ++i)
+		{
+			int32_t DX = Offset(Random);
+			int32_t DY = Offset(Random);
+			int32_t Distance = std::max(abs(DX), abs(DY));
+
+			uint32_t Mip = 0;
+			while ((1 << (Mip + 1)) - 1 <= Distance / 6)
+			{
+				++Mip;
+			}
+			Mip = std::min(Mip, Desc.StandardMipCount - 1);
+
+			uint32_t X = static_cast<uint32_t>((CentreX + DX + Size) % Size) >> Mip;
+			uint32_t Y = static_cast<uint32_t>((CentreY + DY + Size) % Size) >> Mip;
+			OutPageIds[i] = VirtualPageId::Pack(Mip, X, Y);
+		}
+	}
+}
+
+VirtualTextureBenchmark::VirtualTextureBenchmark(const VirtualTextureBenchmarkSettings& Settings)
+	: mSettings(Settings)
+{
+	Assert(mSettings.Frames > 0);
+}
+
+VirtualTextureBenchmark::~VirtualTextureBenchmark()
+{}
+
+bool VirtualTextureBenchmark::Run()
+{
+	mResults.clear();
+	mEvictions.clear();
+
+	if (mSettings.TextureCount == 0 || mSettings.TextureSizeInPages < 2 * WindowPages + 1 ||
+		mSettings.TextureSizeInPages > 0x3FFF)
+	{
+		mLastError = "Texture size must be between 97 and 16383 pages";
+		return false;
+	}
+
+	for (uint32_t FeedbackEntries : mSettings.FeedbackEntryCounts)
+	{
+		for (uint32_t PoolTiles : mSettings.PoolTileCounts)
+		{
+			if (FeedbackEntries < mSettings.TextureCount || PoolTiles == 0)
+			{
+				mLastError = "Feedback entries must be at least one per texture and pools above 0";
+				return false;
+			}
+
+			if (!RunStreaming(FeedbackEntries, PoolTiles))
+			{
+				return false;
+			}
+		}
+	}
+
+	return mSettings.EvictionPagesPerFrame == 0 || RunEviction();
+}
+
+bool VirtualTextureBenchmark::RunStreaming(uint32_t FeedbackEntries, uint32_t PoolTiles)
+{
+	VirtualTextureDesc Desc;
+	Desc.WidthInPages = mSettings.TextureSizeInPages;
+	Desc.HeightInPages = mSettings.TextureSizeInPages;
+	Desc.StandardMipCount = MipCountForSize(mSettings.TextureSizeInPages);
+
+	VirtualTexturePageManager Manager(PoolTiles);
+	for (uint32_t Texture = 0; Texture < mSettings.TextureCount; ++Texture)
+	{
+		Manager.CreateVirtualTexture(Desc);
+	}
+
+	std::mt19937 Random(1234);
+	std::vector<std::vector<uint32_t>> Feedback(mSettings.TextureCount);
+	std::vector<VirtualPageMapping> Batch;
+
+	double FeedbackMilliseconds = 0.0;
+	double UpdateMilliseconds = 0.0;
+	uint64_t Requests = 0;
+	uint64_t Mapped = 0;
+	uint64_t Evictions = 0;
+	uint64_t Deferred = 0;
+
+	uint32_t EntriesPerTexture = FeedbackEntries / mSettings.TextureCount;
+	for (uint32_t Frame = 0; Frame < mSettings.Frames; ++Frame)
+	{
+		for (uint32_t Texture = 0; Texture < mSettings.TextureCount; ++Texture)
+		{
+			GenerateFeedback(Random, Frame, Texture, Desc, EntriesPerTexture, Feedback[Texture]);
+		}
+
+		Manager.BeginFrame();
+
+		auto Start = Clock::now();
+		for (uint32_t Texture = 0; Texture < mSettings.TextureCount; ++Texture)
+		{
+			Manager.ProcessFeedback(Texture, Feedback[Texture].data(), EntriesPerTexture);
+		}
+		FeedbackMilliseconds += MillisecondsSince(Start);
+
+		Batch.clear();
+		Start = Clock::now();
+		Manager.Update(mSettings.MaxNewPagesPerFrame, Batch);
+		UpdateMilliseconds += MillisecondsSince(Start);
+
+		const VirtualTextureStats& Stats = Manager.GetFrameStats();
+		Requests += Stats.PageRequests;
+		Mapped += Stats.PagesMapped;
+		Evictions += Stats.PagesEvicted;
+		Deferred += Stats.RequestsDeferred;
+	}
+
+	if (!Validate(Manager, mSettings.TextureCount, Desc))
+	{
+		return false;
+	}
+
+	double Frames = static_cast<double>(mSettings.Frames);
+	double TotalMilliseconds = FeedbackMilliseconds + UpdateMilliseconds;
+
+	VirtualTextureBenchmarkResult Result;
+	Result.FeedbackEntries = EntriesPerTexture * mSettings.TextureCount;
+	Result.PoolTiles = PoolTiles;
+	Result.FeedbackMillisecondsPerFrame = FeedbackMilliseconds / Frames;
+	Result.UpdateMillisecondsPerFrame = UpdateMilliseconds / Frames;
+	Result.EntriesPerMillisecond = FeedbackMilliseconds > 0.0 ? Result.FeedbackEntries * Frames / FeedbackMilliseconds : 0.0;
+	Result.RequestsPerMillisecond = TotalMilliseconds > 0.0 ? Requests / TotalMilliseconds : 0.0;
+	Result.RequestsPerFrame = Requests / Frames;
+	Result.MappedPerFrame = Mapped / Frames;
+	Result.EvictionsPerFrame = Evictions / Frames;
+	Result.DeferredPerFrame = Deferred / Frames;
+	mResults.push_back(Result);
+	return true;
+}
+
+bool VirtualTextureBenchmark::RunEviction()
+{
+	//One mip, so a request never pulls in parents and every page costs the same
+	uint32_t PagesPerFrame = mSettings.EvictionPagesPerFrame;
+	uint64_t PageCount = static_cast<uint64_t>(mSettings.Frames + 1) * PagesPerFrame;
+
+	VirtualTextureDesc Desc;
+	Desc.WidthInPages = 1024;
+	Desc.HeightInPages = static_cast<uint32_t>((PageCount + Desc.WidthInPages - 1) / Desc.WidthInPages);
+	Desc.StandardMipCount = 1;
+	if (Desc.HeightInPages > 0x3FFF)
+	{
+		mLastError = "Too many eviction pages per frame for the frame count";
+		return false;
+	}
+
+	std::vector<uint32_t> Feedback(PagesPerFrame);
+	std::vector<VirtualPageMapping> Batch;
+
+	//Room for every page, then room for one frame's pages only
+	const uint32_t PoolTiles[2] = { static_cast<uint32_t>(PageCount), PagesPerFrame };
+	const char* Modes[2] = { "Free tiles", "Evicting" };
+
+	//Quickest run of each mode
+	double UpdateMilliseconds[2] = {};
+	uint64_t Mapped[2] = {};
+	uint64_t Evictions[2] = {};
+	uint32_t Repeats = std::max(mSettings.EvictionRepeats, 1u);
+	for (uint32_t Repeat = 0; Repeat < Repeats; ++Repeat)
+	{
+		for (uint32_t ModeIdx = 0; ModeIdx < 2; ++ModeIdx)
+		{
+			VirtualTexturePageManager Manager(PoolTiles[ModeIdx]);
+			Manager.CreateVirtualTexture(Desc);
+
+			double RunMilliseconds = 0.0;
+			uint64_t RunMapped = 0;
+			uint64_t RunEvictions = 0;
+
+			//Frame 0 fills the smaller pool and isn't timed
+			for (uint32_t Frame = 0; Frame <= mSettings.Frames; ++Frame)
+			{
+				for (uint32_t i = 0; i < PagesPerFrame; ++i)
+				{
+					uint64_t Page = static_cast<uint64_t>(Frame) * PagesPerFrame + i;
+					Feedback[i] = VirtualPageId::Pack(0, static_cast<uint32_t>(Page % Desc.WidthInPages),
+						static_cast<uint32_t>(Page / Desc.WidthInPages));
+				}
+
+				Manager.BeginFrame();
+				Manager.ProcessFeedback(0, Feedback.data(), PagesPerFrame);
+
+				Batch.clear();
+				auto Start = Clock::now();
+				Manager.Update(PagesPerFrame, Batch);
+				double Elapsed = MillisecondsSince(Start);
+
+				if (Frame > 0)
+				{
+					RunMilliseconds += Elapsed;
+					RunMapped += Manager.GetFrameStats().PagesMapped;
+					RunEvictions += Manager.GetFrameStats().PagesEvicted;
+				}
+			}
+
+			if (!Validate(Manager, 1, Desc))
+			{
+				return false;
+			}
+
+			if (Repeat == 0 || RunMilliseconds < UpdateMilliseconds[ModeIdx])
+			{
+				UpdateMilliseconds[ModeIdx] = RunMilliseconds;
+			}
+			Mapped[ModeIdx] = RunMapped;
+			Evictions[ModeIdx] = RunEvictions;
+		}
+	}
+
+	if (Mapped[0] != Mapped[1] || Evictions[0] != 0 || Evictions[1] != Mapped[1])
+	{
+		mLastError = "Eviction run didn't map every page, or evicted from a pool with room";
+		return false;
+	}
+
+	double Frames = static_cast<double>(mSettings.Frames);
+	for (uint32_t ModeIdx = 0; ModeIdx < 2; ++ModeIdx)
+	{
+		VirtualTextureBenchmarkEviction Eviction;
+		Eviction.Mode = Modes[ModeIdx];
+		Eviction.UpdateMillisecondsPerFrame = UpdateMilliseconds[ModeIdx] / Frames;
+		Eviction.MappedPerFrame = Mapped[ModeIdx] / Frames;
+		Eviction.EvictionsPerFrame = Evictions[ModeIdx] / Frames;
+		if (Evictions[ModeIdx] > 0)
+		{
+			Eviction.MicrosecondsPerEviction = (UpdateMilliseconds[ModeIdx] - UpdateMilliseconds[0]) * 1000.0 / Evictions[ModeIdx];
+		}
+		mEvictions.push_back(Eviction);
+	}
+
+	if (!(mEvictions.back().MicrosecondsPerEviction > 0.0))
+	{
+		char Error[128];
+		snprintf(Error, sizeof(Error), "Evicting measured %.4f us per eviction - the runs are too noisy or too short",
+			mEvictions.back().MicrosecondsPerEviction);
+		mLastError = Error;
+		return false;
+	}
+	return true;
+}
+
+bool VirtualTextureBenchmark::Validate(const VirtualTexturePageManager& Manager, uint32_t TextureCount, const VirtualTextureDesc& Desc)
+{
+	uint64_t TilesInUse = 0;
+	for (VirtualTextureHandle Texture = 0; Texture < TextureCount; ++Texture)
+	{
+		for (uint32_t Mip = 0; Mip < Desc.StandardMipCount; ++Mip)
+		{
+			uint32_t Width = std::max(1u, Desc.WidthInPages >> Mip);
+			uint32_t Height = std::max(1u, Desc.HeightInPages >> Mip);
+			for (uint32_t Y = 0; Y < Height; ++Y)
+			{
+				for (uint32_t X = 0; X < Width; ++X)
+				{
+					if (Manager.GetPhysicalTile(Texture, Mip, X, Y) == InvalidPhysicalTile)
+					{
+						continue;
+					}
+					++TilesInUse;
+
+					if (Mip + 1 < Desc.StandardMipCount &&
+						Manager.GetPhysicalTile(Texture, Mip + 1, X >> 1, Y >> 1) == InvalidPhysicalTile)
+					{
+						char Error[128];
+						snprintf(Error, sizeof(Error), "Texture %u mip %u page (%u, %u) is mapped without its parent",
+							Texture, Mip, X, Y);
+						mLastError = Error;
+						return false;
+					}
+				}
+			}
+		}
+	}
+
+	if (TilesInUse + Manager.GetFreeTileCount() != Manager.GetPhysicalTileCount())
+	{
+		mLastError = "Tiles in use and free tiles don't add up to the pool";
+		return false;
+	}
+	return true;
+}
+
+bool VirtualTextureBenchmark::WriteReport(const char* Filename) const
+{
+	FILE* File = fopen(Filename, "w");
+	if (!File)
+	{
+		return false;
+	}
+
+	fprintf(File, "Frames:          %u\n", mSettings.Frames);
+	fprintf(File, "Textures:        %u\n", mSettings.TextureCount);
+	fprintf(File, "Texture size:    %u pages\n", mSettings.TextureSizeInPages);
+	fprintf(File, "Max new pages:   %u per frame\n\n", mSettings.MaxNewPagesPerFrame);
+
+	fprintf(File, "FeedbackEntries,PoolTiles,FeedbackMsPerFrame,UpdateMsPerFrame,EntriesPerMs,RequestsPerMs,"
+		"RequestsPerFrame,MappedPerFrame,EvictionsPerFrame,DeferredPerFrame\n");
+	for (const VirtualTextureBenchmarkResult& Result : mResults)
+	{
+		fprintf(File, "%u,%u,%.3f,%.3f,%.0f,%.0f,%.1f,%.1f,%.1f,%.1f\n", Result.FeedbackEntries, Result.PoolTiles,
+			Result.FeedbackMillisecondsPerFrame, Result.UpdateMillisecondsPerFrame, Result.EntriesPerMillisecond,
+			Result.RequestsPerMillisecond, Result.RequestsPerFrame, Result.MappedPerFrame, Result.EvictionsPerFrame,
+			Result.DeferredPerFrame);
+	}
+
+	if (!mEvictions.empty())
+	{
+		fprintf(File, "\nMode,UpdateMsPerFrame,MappedPerFrame,EvictionsPerFrame,UsPerEviction\n");
+		for (const VirtualTextureBenchmarkEviction& Eviction : mEvictions)
+		{
+			fprintf(File, "%s,%.3f,%.0f,%.0f,%.4f\n", Eviction.Mode.c_str(), Eviction.UpdateMillisecondsPerFrame,
+				Eviction.MappedPerFrame, Eviction.EvictionsPerFrame, Eviction.MicrosecondsPerEviction);
+		}
+	}
+
+	fclose(File);
+	return true;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "VirtualTexturePageManager.h"
+
+//VirtualTexturePageManager throughput on synthetic feedback buffers.
+//
+//Streaming: TextureCount virtual textures are each viewed through a window
+//that pans a page per frame. Every frame a feedback buffer of FeedbackEntries
+//packed page ids is generated (finer mips near the window centre, with the
+//duplicates a real feedback buffer has), then fed to ProcessFeedback() and
+//Update(). Run for each FeedbackEntryCounts against each PoolTileCounts.
+//
+//Eviction: the cost of one eviction, isolated. EvictionPagesPerFrame new
+//single mip pages are mapped each frame, once into a pool with room for all of
+//them and once into a pool already full of last frame's pages - the same
+//mapping work plus one eviction each. Both are run EvictionRepeats times,
+//interleaved, and each keeps its quickest run so noise in a single run can't
+//decide the result. The difference in Update() time over the evictions made
+//is the per eviction cost.
+//
+//Run() fails if a mapped page's parent isn't mapped, if the tiles in use and
+//the free tiles don't add up to the pool, or if evicting doesn't measure as
+//costing anything.
+struct VirtualTextureBenchmarkSettings
+{
+	std::vector<uint32_t> FeedbackEntryCounts = { 16384, 131072 };
+	std::vector<uint32_t> PoolTileCounts = { 2048, 16384 };
+	uint32_t Frames = 200;
+	uint32_t TextureCount = 8;
+	uint32_t TextureSizeInPages = 256;
+	uint32_t MaxNewPagesPerFrame = 256;
+	uint32_t EvictionPagesPerFrame = 4096;
+	uint32_t EvictionRepeats = 5;
+};
+
+struct VirtualTextureBenchmarkResult
+{
+	uint32_t FeedbackEntries = 0;
+	uint32_t PoolTiles = 0;
+	double FeedbackMillisecondsPerFrame = 0.0;	//ProcessFeedback()
+	double UpdateMillisecondsPerFrame = 0.0;	//Update()
+	double EntriesPerMillisecond = 0.0;			//Feedback entries through ProcessFeedback()
+	double RequestsPerMillisecond = 0.0;		//Unique page requests through both
+	double RequestsPerFrame = 0.0;
+	double MappedPerFrame = 0.0;
+	double EvictionsPerFrame = 0.0;
+	double DeferredPerFrame = 0.0;
+};
+
+struct VirtualTextureBenchmarkEviction
+{
+	std::string Mode;
+	double UpdateMillisecondsPerFrame = 0.0;
+	double MappedPerFrame = 0.0;
+	double EvictionsPerFrame = 0.0;
+	double MicrosecondsPerEviction = 0.0;
+};
+
+class VirtualTextureBenchmark
+{
+public:
+	VirtualTextureBenchmark(const VirtualTextureBenchmarkSettings& Settings);
+	~VirtualTextureBenchmark();
+
+	bool Run();
+	bool WriteReport(const char* Filename) const;
+
+	const std::string& GetLastError() const { return mLastError; }
+
+private:
+	bool RunStreaming(uint32_t FeedbackEntries, uint32_t PoolTiles);
+	bool RunEviction();
+
+	bool Validate(const VirtualTexturePageManager& Manager, uint32_t TextureCount, const VirtualTextureDesc& Desc);
+
+private:
+	VirtualTextureBenchmarkSettings mSettings;
+	std::vector<VirtualTextureBenchmarkResult> mResults;
+	std::vector<VirtualTextureBenchmarkEviction> mEvictions;
+
+	std::string mLastError;
+};
@@ -0,0 +1,63 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "VirtualTextureBenchmark.h"
+
+//Virtual texture page manager benchmark:
+//	VirtualTextureBenchmark [-frames N] [-entries N ...] [-pool N ...] [-evictionpages N]
+//Writes VirtualTextureBenchmark.txt to the current directory.
+int main(int argc, char** argv)
+{
+	VirtualTextureBenchmarkSettings Settings;
+	bool bCustomEntries = false;
+	bool bCustomPools = false;
+	bool bValid = true;
+	for (int i = 1; i < argc && bValid; ++i)
+	{
+		if (strcmp(argv[i], "-frames") == 0 && i + 1 < argc)
+		{
+			Settings.Frames = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-entries") == 0 && i + 1 < argc)
+		{
+			if (!bCustomEntries)
+			{
+				Settings.FeedbackEntryCounts.clear();
+				bCustomEntries = true;
+			}
+			Settings.FeedbackEntryCounts.push_back(static_cast<uint32_t>(atoi(argv[++i])));
+		}
+		else if (strcmp(argv[i], "-pool") == 0 && i + 1 < argc)
+		{
+			if (!bCustomPools)
+			{
+				Settings.PoolTileCounts.clear();
+				bCustomPools = true;
+			}
+			Settings.PoolTileCounts.push_back(static_cast<uint32_t>(atoi(argv[++i])));
+		}
+		else if (strcmp(argv[i], "-evictionpages") == 0 && i + 1 < argc)
+		{
+			Settings.EvictionPagesPerFrame = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else
+		{
+			bValid = false;
+		}
+	}
+
+	if (!bValid || Settings.Frames == 0)
+	{
+		fprintf(stderr, "Usage: VirtualTextureBenchmark [-frames N] [-entries N ...] [-pool N ...] [-evictionpages N]\n");
+		return 1;
+	}
+
+	VirtualTextureBenchmark Benchmark(Settings);
+	if (!Benchmark.Run())
+	{
+		fprintf(stderr, "%s\n", Benchmark.GetLastError().c_str());
+		return 1;
+	}
+	return Benchmark.WriteReport("VirtualTextureBenchmark.txt") ? 0 : 1;
+}
@@ -0,0 +1,411 @@
+#include "VirtualTexturePageManager.h"
+#include "Common.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+	const uint32_t LruNone = 0xFFFFFFFF;
+	const uint64_t NeverRequested = ~0ull;
+
+	double MicrosecondsSince(std::chrono::high_resolution_clock::time_point Start)
+	{
+		return std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - Start).count();
+	}
+}
+
+VirtualTexturePageManager::VirtualTexturePageManager(uint32_t PhysicalTileCount)
+	: mLruHead(LruNone), mLruTail(LruNone), mFrameIndex(0)
+{
+	Assert(PhysicalTileCount > 0);
+
+	mTiles.resize(PhysicalTileCount);
+	mFreeTiles.reserve(PhysicalTileCount);
+
+	//Hand out low tile indices first - keeps heap usage compact.
+	for (uint32_t Tile = PhysicalTileCount; Tile > 0; --Tile)
+	{
+		PhysicalTileInfo& Info = mTiles[Tile - 1];
+		Info.Texture = InvalidVirtualTextureHandle;
+		Info.PackedPageId = 0;
+		Info.LastUsedFrame = 0;
+		Info.Prev = LruNone;
+		Info.Next = LruNone;
+
+		mFreeTiles.push_back(Tile - 1);
+	}
+}
+
+VirtualTexturePageManager::~VirtualTexturePageManager()
+{}
+
+VirtualTextureHandle VirtualTexturePageManager::CreateVirtualTexture(const VirtualTextureDesc& Desc)
+{
+	Assert(Desc.StandardMipCount <= 16);
+	Assert(Desc.WidthInPages <= 0x3FFF && Desc.HeightInPages <= 0x3FFF);
+
+	VirtualTextureHandle Handle = 0;
+	while (Handle < mTextures.size() && mTextures[Handle].bAlive)
+	{
+		++Handle;
+	}
+	if (Handle == mTextures.size())
+	{
+		mTextures.emplace_back();
+	}
+
+	PageTable& Table = mTextures[Handle];
+	Table.Desc = Desc;
+	Table.bAlive = true;
+	Table.PhysicalTiles.resize(Desc.StandardMipCount);
+	Table.RequestFrame.resize(Desc.StandardMipCount);
+
+	for (uint32_t Mip = 0; Mip < Desc.StandardMipCount; ++Mip)
+	{
+		size_t PageCount = static_cast<size_t>(MipWidth(Table, Mip)) * MipHeight(Table, Mip);
+		Table.PhysicalTiles[Mip].assign(PageCount, InvalidPhysicalTile);
+		Table.RequestFrame[Mip].assign(PageCount, NeverRequested);
+	}
+
+	return Handle;
+}
+
+void VirtualTexturePageManager::DestroyVirtualTexture(VirtualTextureHandle Texture)
+{
+	Assert(Texture < mTextures.size() && mTextures[Texture].bAlive);
+	PageTable& Table = mTextures[Texture];
+
+	for (std::vector<uint32_t>& MipTiles : Table.PhysicalTiles)
+	{
+		for (uint32_t Tile : MipTiles)
+		{
+			if (Tile != InvalidPhysicalTile)
+			{
+				LruUnlink(Tile);
+				mTiles[Tile].Texture = InvalidVirtualTextureHandle;
+				mFreeTiles.push_back(Tile);
+			}
+		}
+	}
+
+	Table.PhysicalTiles.clear();
+	Table.RequestFrame.clear();
+	Table.bAlive = false;
+
+	//Drop any requests already gathered this frame.
+	mRequests.erase(std::remove_if(mRequests.begin(), mRequests.end(),
+		[Texture](const PageRequest& Request) { return Request.Texture == Texture; }), mRequests.end());
+}
+
+void VirtualTexturePageManager::BeginFrame()
+{
+	++mFrameIndex;
+	mFrameStats = VirtualTextureStats();
+	mRequests.clear();
+}
+
+void VirtualTexturePageManager::ProcessFeedback(VirtualTextureHandle Texture, const uint32_t* PackedPageIds, uint32_t Count)
+{
+	auto Start = std::chrono::high_resolution_clock::now();
+
+	Assert(Texture < mTextures.size() && mTextures[Texture].bAlive);
+	PageTable& Table = mTextures[Texture];
+
+	for (uint32_t i = 0; i < Count; ++i)
+	{
+		uint32_t Mip = VirtualPageId::Mip(PackedPageIds[i]);
+		uint32_t X = VirtualPageId::X(PackedPageIds[i]);
+		uint32_t Y = VirtualPageId::Y(PackedPageIds[i]);
+
+		//Feedback from the packed tail or garbage - nothing to do.
+		if (Mip >= Table.Desc.StandardMipCount || X >= MipWidth(Table, Mip) || Y >= MipHeight(Table, Mip))
+		{
+			continue;
+		}
+
+		//Walk up the chain - parents are touched after children so they are
+		//always more recently used and never evicted before them.
+		for (; Mip < Table.Desc.StandardMipCount; ++Mip, X >>= 1, Y >>= 1)
+		{
+			TouchOrRequestPage(Texture, Table, Mip, X, Y);
+		}
+	}
+
+	mFrameStats.FeedbackEntriesProcessed += Count;
+	mTotalStats.FeedbackEntriesProcessed += Count;
+
+	double Elapsed = MicrosecondsSince(Start);
+	mFrameStats.FeedbackMicroseconds += Elapsed;
+	mTotalStats.FeedbackMicroseconds += Elapsed;
+}
+
+void VirtualTexturePageManager::TouchOrRequestPage(VirtualTextureHandle Texture, PageTable& Table, uint32_t Mip, uint32_t X, uint32_t Y)
+{
+	size_t PageIdx = static_cast<size_t>(Y) * MipWidth(Table, Mip) + X;
+
+	uint32_t Tile = Table.PhysicalTiles[Mip][PageIdx];
+	if (Tile != InvalidPhysicalTile)
+	{
+		mTiles[Tile].LastUsedFrame = mFrameIndex;
+		LruUnlink(Tile);
+		LruPushFront(Tile);
+		return;
+	}
+
+	uint64_t& RequestFrame = Table.RequestFrame[Mip][PageIdx];
+	if (RequestFrame == mFrameIndex)
+	{
+		return;
+	}
+	RequestFrame = mFrameIndex;
+
+	PageRequest Request;
+	Request.Texture = Texture;
+	Request.PackedPageId = VirtualPageId::Pack(Mip, X, Y);
+	mRequests.push_back(Request);
+
+	++mFrameStats.PageRequests;
+	++mTotalStats.PageRequests;
+}
+
+void VirtualTexturePageManager::Update(uint32_t MaxNewPages, std::vector<VirtualPageMapping>& OutBatch)
+{
+	auto Start = std::chrono::high_resolution_clock::now();
+
+	//Coarsest first - a page is only mapped once its parent is.
+	std::sort(mRequests.begin(), mRequests.end(), [](const PageRequest& A, const PageRequest& B)
+	{
+		uint32_t MipA = VirtualPageId::Mip(A.PackedPageId);
+		uint32_t MipB = VirtualPageId::Mip(B.PackedPageId);
+		if (MipA != MipB)
+		{
+			return MipA > MipB;
+		}
+		if (A.Texture != B.Texture)
+		{
+			return A.Texture < B.Texture;
+		}
+		return A.PackedPageId < B.PackedPageId;
+	});
+
+	uint32_t Mapped = 0;
+	uint64_t Deferred = 0;
+	for (const PageRequest& Request : mRequests)
+	{
+		PageTable& Table = mTextures[Request.Texture];
+		uint32_t Mip = VirtualPageId::Mip(Request.PackedPageId);
+		uint32_t X = VirtualPageId::X(Request.PackedPageId);
+		uint32_t Y = VirtualPageId::Y(Request.PackedPageId);
+
+		size_t PageIdx = static_cast<size_t>(Y) * MipWidth(Table, Mip) + X;
+		if (Table.PhysicalTiles[Mip][PageIdx] != InvalidPhysicalTile)
+		{
+			continue;
+		}
+
+		if (Mapped >= MaxNewPages)
+		{
+			++Deferred;
+			continue;
+		}
+
+		//Parent didn't make it this frame - neither can we.
+		if (Mip + 1 < Table.Desc.StandardMipCount)
+		{
+			size_t ParentIdx = static_cast<size_t>(Y >> 1) * MipWidth(Table, Mip + 1) + (X >> 1);
+			if (Table.PhysicalTiles[Mip + 1][ParentIdx] == InvalidPhysicalTile)
+			{
+				++Deferred;
+				continue;
+			}
+		}
+
+		uint32_t Tile = AllocateTile(OutBatch);
+		if (Tile == InvalidPhysicalTile)
+		{
+			++Deferred;
+			continue;
+		}
+
+		PhysicalTileInfo& Info = mTiles[Tile];
+		Info.Texture = Request.Texture;
+		Info.PackedPageId = Request.PackedPageId;
+		Info.LastUsedFrame = mFrameIndex;
+		LruPushFront(Tile);
+
+		Table.PhysicalTiles[Mip][PageIdx] = Tile;
+
+		VirtualPageMapping Mapping;
+		Mapping.Texture = Request.Texture;
+		Mapping.Mip = Mip;
+		Mapping.X = X;
+		Mapping.Y = Y;
+		Mapping.PhysicalTile = Tile;
+		OutBatch.push_back(Mapping);
+
+		//Re-touch the parents so they stay ahead of the new page in the LRU.
+		for (uint32_t ParentMip = Mip + 1; ParentMip < Table.Desc.StandardMipCount; ++ParentMip)
+		{
+			uint32_t Shift = ParentMip - Mip;
+			size_t ParentIdx = static_cast<size_t>(Y >> Shift) * MipWidth(Table, ParentMip) + (X >> Shift);
+			uint32_t ParentTile = Table.PhysicalTiles[ParentMip][ParentIdx];
+
+			LruUnlink(ParentTile);
+			LruPushFront(ParentTile);
+		}
+
+		++Mapped;
+	}
+
+	mRequests.clear();
+
+	mFrameStats.PagesMapped += Mapped;
+	mTotalStats.PagesMapped += Mapped;
+	mFrameStats.RequestsDeferred += Deferred;
+	mTotalStats.RequestsDeferred += Deferred;
+
+	double Elapsed = MicrosecondsSince(Start);
+	mFrameStats.UpdateMicroseconds += Elapsed;
+	mTotalStats.UpdateMicroseconds += Elapsed;
+}
+
+uint32_t VirtualTexturePageManager::GetPhysicalTile(VirtualTextureHandle Texture, uint32_t Mip, uint32_t X, uint32_t Y) const
+{
+	Assert(Texture < mTextures.size() && mTextures[Texture].bAlive);
+	const PageTable& Table = mTextures[Texture];
+
+	if (Mip >= Table.Desc.StandardMipCount || X >= MipWidth(Table, Mip) || Y >= MipHeight(Table, Mip))
+	{
+		return InvalidPhysicalTile;
+	}
+	return Table.PhysicalTiles[Mip][static_cast<size_t>(Y) * MipWidth(Table, Mip) + X];
+}
+
+void VirtualTexturePageManager::BuildResidencyMap(VirtualTextureHandle Texture, std::vector<uint8_t>& OutMinMip) const
+{
+	Assert(Texture < mTextures.size() && mTextures[Texture].bAlive);
+	const PageTable& Table = mTextures[Texture];
+
+	uint32_t Width = Table.Desc.WidthInPages;
+	uint32_t Height = Table.Desc.HeightInPages;
+	OutMinMip.assign(static_cast<size_t>(Width) * Height, static_cast<uint8_t>(Table.Desc.StandardMipCount));
+
+	//Coarse to fine - a finer resident page overwrites its parent's value. The
+	//parent-before-child invariant keeps the chain above it resident too.
+	for (uint32_t Mip = Table.Desc.StandardMipCount; Mip > 0; --Mip)
+	{
+		uint32_t CurrentMip = Mip - 1;
+		for (uint32_t Y = 0; Y < Height; ++Y)
+		{
+			for (uint32_t X = 0; X < Width; ++X)
+			{
+				size_t PageIdx = static_cast<size_t>(Y >> CurrentMip) * MipWidth(Table, CurrentMip) + (X >> CurrentMip);
+				if (Table.PhysicalTiles[CurrentMip][PageIdx] != InvalidPhysicalTile)
+				{
+					OutMinMip[static_cast<size_t>(Y) * Width + X] = static_cast<uint8_t>(CurrentMip);
+				}
+			}
+		}
+	}
+}
+
+uint32_t VirtualTexturePageManager::MipWidth(const PageTable& Table, uint32_t Mip) const
+{
+	return std::max(1u, Table.Desc.WidthInPages >> Mip);
+}
+
+uint32_t VirtualTexturePageManager::MipHeight(const PageTable& Table, uint32_t Mip) const
+{
+	return std::max(1u, Table.Desc.HeightInPages >> Mip);
+}
+
+uint32_t VirtualTexturePageManager::AllocateTile(std::vector<VirtualPageMapping>& OutBatch)
+{
+	if (!mFreeTiles.empty())
+	{
+		uint32_t Tile = mFreeTiles.back();
+		mFreeTiles.pop_back();
+		return Tile;
+	}
+
+	//Least recently used - unless even that was needed this frame, in which case
+	//the pool is simply too small for the working set.
+	if (mLruTail == LruNone || mTiles[mLruTail].LastUsedFrame == mFrameIndex)
+	{
+		return InvalidPhysicalTile;
+	}
+
+	uint32_t Tile = mLruTail;
+	EvictTile(Tile, OutBatch);
+	return Tile;
+}
+
+void VirtualTexturePageManager::EvictTile(uint32_t Tile, std::vector<VirtualPageMapping>& OutBatch)
+{
+	PhysicalTileInfo& Info = mTiles[Tile];
+	PageTable& Table = mTextures[Info.Texture];
+
+	uint32_t Mip = VirtualPageId::Mip(Info.PackedPageId);
+	uint32_t X = VirtualPageId::X(Info.PackedPageId);
+	uint32_t Y = VirtualPageId::Y(Info.PackedPageId);
+	Table.PhysicalTiles[Mip][static_cast<size_t>(Y) * MipWidth(Table, Mip) + X] = InvalidPhysicalTile;
+
+	VirtualPageMapping Unmap;
+	Unmap.Texture = Info.Texture;
+	Unmap.Mip = Mip;
+	Unmap.X = X;
+	Unmap.Y = Y;
+	Unmap.PhysicalTile = InvalidPhysicalTile;
+	OutBatch.push_back(Unmap);
+
+	LruUnlink(Tile);
+	Info.Texture = InvalidVirtualTextureHandle;
+
+	++mFrameStats.PagesEvicted;
+	++mTotalStats.PagesEvicted;
+}
+
+void VirtualTexturePageManager::LruUnlink(uint32_t Tile)
+{
+	PhysicalTileInfo& Info = mTiles[Tile];
+
+	if (Info.Prev != LruNone)
+	{
+		mTiles[Info.Prev].Next = Info.Next;
+	}
+	else if (mLruHead == Tile)
+	{
+		mLruHead = Info.Next;
+	}
+
+	if (Info.Next != LruNone)
+	{
+		mTiles[Info.Next].Prev = Info.Prev;
+	}
+	else if (mLruTail == Tile)
+	{
+		mLruTail = Info.Prev;
+	}
+
+	Info.Prev = LruNone;
+	Info.Next = LruNone;
+}
+
+void VirtualTexturePageManager::LruPushFront(uint32_t Tile)
+{
+	PhysicalTileInfo& Info = mTiles[Tile];
+	Info.Prev = LruNone;
+	Info.Next = mLruHead;
+
+	if (mLruHead != LruNone)
+	{
+		mTiles[mLruHead].Prev = Tile;
+	}
+	mLruHead = Tile;
+
+	if (mLruTail == LruNone)
+	{
+		mLruTail = Tile;
+	}
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+//Page table / physical tile pool for sparse (tiled) virtual textures.
+//
+//This is the CPU side only - no D3D12 in here so it can be run (and measured)
+//anywhere. Each virtual texture is split in to pages (one D3D12 64KB tile each),
+//the pages of every virtual texture share one pool of physical tiles which is
+//recycled least recently used first. Feedback (which pages the GPU wanted last
+//frame) drives page requests, and each Update() produces one batch of mapping
+//changes for the API layer (D3D12VirtualTexture) to apply with
+//UpdateTileMappings.
+//
+//Packed mips (the tail that D3D12 maps as a unit) are not managed here - they
+//are mapped once when the texture is created and never evicted.
+
+typedef uint32_t VirtualTextureHandle;
+const VirtualTextureHandle InvalidVirtualTextureHandle = 0xFFFFFFFF;
+const uint32_t InvalidPhysicalTile = 0xFFFFFFFF;
+
+struct VirtualTextureDesc
+{
+	//Pages across/down at mip 0 (see D3D12_SUBRESOURCE_TILING).
+	uint32_t WidthInPages = 1;
+	uint32_t HeightInPages = 1;
+
+	//Mips that are made of standard (non packed) tiles.
+	uint32_t StandardMipCount = 1;
+};
+
+//Packs a page address so feedback can be written as a single uint by a shader:
+//	[31:28] Mip  [27:14] Y  [13:0] X
+struct VirtualPageId
+{
+	static uint32_t Pack(uint32_t Mip, uint32_t X, uint32_t Y) { return (Mip << 28) | ((Y & 0x3FFF) << 14) | (X & 0x3FFF); }
+	static uint32_t Mip(uint32_t Packed) { return Packed >> 28; }
+	static uint32_t Y(uint32_t Packed) { return (Packed >> 14) & 0x3FFF; }
+	static uint32_t X(uint32_t Packed) { return Packed & 0x3FFF; }
+};
+
+//One entry of the batch produced by Update(). PhysicalTile == InvalidPhysicalTile
+//means unmap the page.
+struct VirtualPageMapping
+{
+	VirtualTextureHandle Texture;
+	uint32_t Mip;
+	uint32_t X;
+	uint32_t Y;
+	uint32_t PhysicalTile;
+};
+
+struct VirtualTextureStats
+{
+	uint64_t FeedbackEntriesProcessed = 0;
+	uint64_t PageRequests = 0;			//Unique missing pages requested
+	uint64_t PagesMapped = 0;
+	uint64_t PagesEvicted = 0;
+	uint64_t RequestsDeferred = 0;		//Pool exhausted by pages in use this frame / per frame limit
+
+	double FeedbackMicroseconds = 0.0;	//ProcessFeedback()
+	double UpdateMicroseconds = 0.0;	//Update() - includes eviction
+};
+
+class VirtualTexturePageManager
+{
+public:
+	VirtualTexturePageManager(uint32_t PhysicalTileCount);
+	~VirtualTexturePageManager();
+
+	VirtualTextureHandle CreateVirtualTexture(const VirtualTextureDesc& Desc);
+
+	//Returns every tile of the texture to the pool. No unmaps are emitted - the
+	//reserved resource is expected to be going away with it.
+	void DestroyVirtualTexture(VirtualTextureHandle Texture);
+
+	void BeginFrame();
+
+	//Pages sampled this frame (packed with VirtualPageId). Resident pages are
+	//marked as used, missing pages are requested together with any missing
+	//coarser pages covering them so data always arrives coarse to fine.
+	void ProcessFeedback(VirtualTextureHandle Texture, const uint32_t* PackedPageIds, uint32_t Count);
+
+	//Services up to MaxNewPages requests, coarsest first, evicting least recently
+	//used tiles as needed. The resulting mapping changes are appended to OutBatch.
+	void Update(uint32_t MaxNewPages, std::vector<VirtualPageMapping>& OutBatch);
+
+	uint32_t GetPhysicalTile(VirtualTextureHandle Texture, uint32_t Mip, uint32_t X, uint32_t Y) const;
+
+	//Finest resident mip for each mip 0 page (row major), StandardMipCount where
+	//only the packed tail covers it. Intended as a min-LOD clamp texture so
+	//shaders never sample unmapped tiles.
+	void BuildResidencyMap(VirtualTextureHandle Texture, std::vector<uint8_t>& OutMinMip) const;
+
+	uint32_t GetFreeTileCount() const { return static_cast<uint32_t>(mFreeTiles.size()); }
+	uint32_t GetPhysicalTileCount() const { return static_cast<uint32_t>(mTiles.size()); }
+
+	const VirtualTextureStats& GetFrameStats() const { return mFrameStats; }
+	const VirtualTextureStats& GetTotalStats() const { return mTotalStats; }
+
+private:
+	struct PageTable
+	{
+		VirtualTextureDesc Desc;
+		bool bAlive = false;
+
+		//Per mip: physical tile for each page and the frame it was last requested
+		//(dedupes requests within a frame).
+		std::vector<std::vector<uint32_t>> PhysicalTiles;
+		std::vector<std::vector<uint64_t>> RequestFrame;
+	};
+
+	struct PhysicalTileInfo
+	{
+		VirtualTextureHandle Texture;
+		uint32_t PackedPageId;
+		uint64_t LastUsedFrame;
+
+		//Intrusive LRU list - head is most recently used.
+		uint32_t Prev;
+		uint32_t Next;
+	};
+
+	struct PageRequest
+	{
+		VirtualTextureHandle Texture;
+		uint32_t PackedPageId;
+	};
+
+	uint32_t MipWidth(const PageTable& Table, uint32_t Mip) const;
+	uint32_t MipHeight(const PageTable& Table, uint32_t Mip) const;
+
+	void TouchOrRequestPage(VirtualTextureHandle Texture, PageTable& Table, uint32_t Mip, uint32_t X, uint32_t Y);
+	uint32_t AllocateTile(std::vector<VirtualPageMapping>& OutBatch);
+	void EvictTile(uint32_t Tile, std::vector<VirtualPageMapping>& OutBatch);
+
+	void LruUnlink(uint32_t Tile);
+	void LruPushFront(uint32_t Tile);
+
+private:
+	std::vector<PageTable> mTextures;
+	std::vector<PhysicalTileInfo> mTiles;
+	std::vector<uint32_t> mFreeTiles;
+	uint32_t mLruHead;
+	uint32_t mLruTail;
+
+	std::vector<PageRequest> mRequests;
+
+	uint64_t mFrameIndex;
+	VirtualTextureStats mFrameStats;
+	VirtualTextureStats mTotalStats;
+};
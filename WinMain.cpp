@@ -1,38 +1,44 @@
 #include <windows.h>
 #include <wrl.h> 
+#include <stdio.h>
+#include <string.h>
+#include <memory>
 
 #include <dxgi1_4.h>
 #include <d3d12.h>
 
 #include <dxgidebug.h>
 
-#include <DirectXMath.h>
-#include <DirectXPackedVector.h>
-
 #include "d3dx12.h"
 
+#include "Common.h"
+#include "CoroutineBenchmark.h"
+#include "CoroutineScheduler.h"
+#include "D3D12QueueFence.h"
+#include "D3D12RenderCommandList.h"
+#include "D3D12StaticScene.h"
+#include "DeferredReleaseChecks.h"
+#include "DeferredReleaseQueue.h"
+#include "EntityBenchmark.h"
 #include "GameTimer.h"
+#include "JobSystem.h"
+#include "PackedFileScene.h"
+#include "PackedSceneBuilder.h"
+#include "ResidencySimulation.h"
+#include "SceneManager.h"
+#include "SceneTransitionSimulation.h"
+#include "StateFilteringCommandList.h"
+#include "TestScene.h"
+#include "TextureStreamingSimulation.h"
+#include "WorldStreamingSimulation.h"
 
 //Link D3D12 dependencies 
 #pragma comment(lib, "d3dcompiler.lib")
 #pragma comment(lib, "d3d12.lib")
 #pragma comment(lib, "dxgi.lib")
 
-using namespace DirectX;
 using namespace Microsoft::WRL;
 
-#define Assert(x) \
-	if (!(x)) { MessageBoxA(0, #x, "Assert Failed", MB_OK); __debugbreak(); }
-
-#define Check(x) \
-	if (!(x)) { MessageBoxA(0, #x, "Check Failed", MB_OK); __debugbreak(); }
-
-#define CheckHResult(HResult) \
-	Check(SUCCEEDED(HResult))
-
-#define RIID(x) \
-	IID_PPV_ARGS(x)
-
 //Global settings/data
 const unsigned SwapchainBufferCount = 2;
 const DXGI_FORMAT SwapchainBufferFormat = DXGI_FORMAT_B8G8R8A8_UNORM;
@@ -55,7 +61,6 @@ ComPtr<ID3D12Debug1> DebugController;
 ComPtr<IDXGIFactory4> DXGIFactory;
 
 ComPtr<ID3D12Device1> Device;
-ComPtr<ID3D12Fence1> D3D12Fence;
 ComPtr<ID3D12CommandQueue> DirectGraphicsCommandQueue;
 ComPtr<ID3D12CommandAllocator> DirectGraphicsCommandListAllocator;
 ComPtr<ID3D12GraphicsCommandList1> CommandList;
@@ -63,6 +68,21 @@ ComPtr<IDXGISwapChain1> Swapchain;
 ComPtr<ID3D12Resource> SwapchainColourBuffers[SwapchainBufferCount];
 ComPtr<ID3D12Resource> DepthStencilBufferResource;
 
+//Fence on the direct queue + GPU objects waiting on it before they can be freed
+std::unique_ptr<D3D12QueueFence> DirectQueueFence;
+std::unique_ptr<DeferredReleaseQueue> ReleaseQueue;
+std::unique_ptr<CoroutineScheduler> MainThreadScheduler;
+std::unique_ptr<JobSystem> Jobs;
+std::unique_ptr<SceneManager> Scenes;
+
+//CommandList in renderer ids, behind a filter that drops redundant state
+D3D12RenderObjects RenderObjects;
+std::unique_ptr<D3D12RenderCommandList> RenderCommands;
+std::unique_ptr<StateFilteringCommandList> FilteredCommands;
+
+//Static geometry drawn before the scene, if -staticscene was given
+std::unique_ptr<D3D12StaticScene> StaticScene;
+
 //Descriptor heaps for swapchain resources (RTV's and DSV)
 ComPtr<ID3D12DescriptorHeap> SwapchainRTVDescriptorHeap;
 ComPtr<ID3D12DescriptorHeap> SwapchainDSVDescriptorHeap;
@@ -72,10 +92,9 @@ UINT RTVDescriptorStride;
 UINT DSVDescriptorStride;
 UINT CBVDescriptorStride;
 
-D3D12_VIEWPORT Viewport;
+RenderViewport Viewport;
 
 //Graphics runtime data
-unsigned CurrentFenceValue = 0;
 unsigned CurrentSwapchainColourBufferIdx = 0;
 
 unsigned ScreenWidth = 0;
@@ -142,23 +161,9 @@ D3D12_CPU_DESCRIPTOR_HANDLE GetCPUDescriptorHandleForDepthStencilBuffer()
 
 void FlushCommandQueue()
 {
-	//Increment the fence value we are waiting on...
-	CurrentFenceValue++;
-
 	//Add instruction to queue to set a new fence point after previous instructions
-	CheckHResult(DirectGraphicsCommandQueue->Signal(D3D12Fence.Get(), CurrentFenceValue));
-
-	//Wait until GPU has completed tasks up until this fence point...
-	if (D3D12Fence.Get()->GetCompletedValue() < CurrentFenceValue)
-	{
-		HANDLE EventHandle = CreateEventEx(nullptr, false, false, EVENT_ALL_ACCESS);
-
-		//Fire event when GPU hits the current fence
-		CheckHResult(D3D12Fence.Get()->SetEventOnCompletion(CurrentFenceValue, EventHandle));
-
-		WaitForSingleObject(EventHandle, INFINITE);
-		CloseHandle(EventHandle);
-	}
+	//and wait until GPU has completed tasks up until this fence point...
+	DirectQueueFence->WaitForValue(DirectQueueFence->Signal());
 }
 
 bool InitD3D12()
@@ -180,9 +185,6 @@ bool InitD3D12()
 	//Device
 	CheckHResult(D3D12CreateDevice(0, D3D_FEATURE_LEVEL_12_1, IID_PPV_ARGS(Device.GetAddressOf())));
 
-	//A fence
-	CheckHResult(Device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(D3D12Fence.GetAddressOf())));
-
 	//Cache Descriptor set sizes
 	RTVDescriptorStride = Device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
 	DSVDescriptorStride = Device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_DSV);
@@ -195,6 +197,10 @@ bool InitD3D12()
 	CommandQueueDesc.NodeMask = 0;
 	CheckHResult(Device->CreateCommandQueue(&CommandQueueDesc, IID_PPV_ARGS(DirectGraphicsCommandQueue.GetAddressOf())));
 
+	//A fence for the queue + deferred release of anything the queue may still be using
+	DirectQueueFence.reset(new D3D12QueueFence(Device.Get(), DirectGraphicsCommandQueue.Get()));
+	ReleaseQueue.reset(new DeferredReleaseQueue(DirectQueueFence.get()));
+
 	//Command list allocator 
 	CheckHResult(Device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT,
 		IID_PPV_ARGS(DirectGraphicsCommandListAllocator.GetAddressOf())));
@@ -202,6 +208,8 @@ bool InitD3D12()
 	//Command list from above allocator
 	CheckHResult(Device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT,
 		DirectGraphicsCommandListAllocator.Get(), nullptr, IID_PPV_ARGS(CommandList.GetAddressOf())));
+	RenderCommands.reset(new D3D12RenderCommandList(CommandList.Get(), &RenderObjects));
+	FilteredCommands.reset(new StateFilteringCommandList(RenderCommands.get()));
 
 	DXGI_SWAP_CHAIN_DESC1 SwapchainDesc = {};
 	SwapchainDesc.BufferCount = SwapchainBufferCount;
@@ -290,8 +298,8 @@ bool InitD3D12()
 
 	//Viewport
 	Viewport = {};
-	Viewport.TopLeftX = 0.0f;
-	Viewport.TopLeftY = 0.0f;
+	Viewport.X = 0.0f;
+	Viewport.Y = 0.0f;
 	Viewport.Width = static_cast<float>(ScreenWidth);
 	Viewport.Height = static_cast<float>(ScreenHeight);
 	Viewport.MinDepth = 0.0f;
@@ -314,19 +322,69 @@ bool InitD3D12()
 	return true;
 }
 
-bool InitScene()
+//Loads the mesh and uploads it before the first frame
+bool InitStaticScene(const char* MeshFilename, const D3D12StaticSceneSettings& Settings)
 {
-	return true;
+	StaticScene.reset(new D3D12StaticScene(Device.Get(), DirectQueueFence.get(), ReleaseQueue.get(), Settings));
+
+	CheckHResult(DirectGraphicsCommandListAllocator->Reset());
+	CheckHResult(CommandList.Get()->Reset(DirectGraphicsCommandListAllocator.Get(), nullptr));
+	bool bCreated = StaticScene->Create(MeshFilename, CommandList.Get(), RenderObjects,
+		SwapchainBufferFormat, DepthStencilBufferFormat);
+	CheckHResult(CommandList.Get()->Close());
+
+	ID3D12CommandList* CommandListsToSubmit[] = { CommandList.Get() };
+	DirectGraphicsCommandQueue.Get()->ExecuteCommandLists(1, CommandListsToSubmit);
+	FlushCommandQueue();
+	ReleaseQueue->Drain();
+
+	if (!bCreated)
+	{
+		OutputDebugStringA(StaticScene->GetLastError().c_str());
+		StaticScene.reset();
+		RenderObjects = D3D12RenderObjects();
+		ReleaseQueue->Flush();
+	}
+	return bCreated;
+}
+
+//SceneFilename is a PackedScene file to load in place of the test scene, or nullptr
+bool InitScene(const char* SceneFilename)
+{
+	//Load coroutines resume through this, once a frame
+	MainThreadScheduler.reset(new CoroutineScheduler());
+	Jobs.reset(new JobSystem());
+
+	//Swapped in on the first update its load completes by
+	Scenes.reset(new SceneManager(MainThreadScheduler.get(), ReleaseQueue.get()));
+	if (SceneFilename)
+	{
+		return Scenes->RequestScene(std::unique_ptr<IScene>(
+			new PackedFileScene(SceneFilename, Jobs.get(), MainThreadScheduler.get())));
+	}
+	return Scenes->RequestScene(std::unique_ptr<IScene>(new TestScene()));
+}
+
+//Writes the active scene out as a PackedScene file
+bool SaveScene(const char* Filename)
+{
+	IScene* Scene = Scenes->GetActiveScene();
+	PackedSceneBuilder Builder;
+	return Scene && Scene->OnSaveScene(Builder) && Builder.Write(Filename);
 }
 
 void UpdateScene(float Delta)
-{}
+{
+	MainThreadScheduler->Pump();
+	Scenes->Update(Delta);
+}
 
 void RenderScene()
 {
 	//Reuse the command list
 	CheckHResult(DirectGraphicsCommandListAllocator->Reset());
 	CheckHResult(CommandList.Get()->Reset(DirectGraphicsCommandListAllocator.Get(), nullptr));
+	FilteredCommands->Invalidate();
 
 	//Transition backbuffer from present to render target. 
 	D3D12_RESOURCE_BARRIER RenderTargetTransition = CD3DX12_RESOURCE_BARRIER::Transition(
@@ -335,7 +393,7 @@ void RenderScene()
 	CommandList.Get()->ResourceBarrier(1, &RenderTargetTransition);
 
 	//Reset viewport
-	CommandList.Get()->RSSetViewports(1, &Viewport);
+	FilteredCommands->SetViewport(Viewport);
 
 	//Clear the backbuffer RTV
 	static const float SwapchainRenderTargetClear[4] = { 0.0f, 0.0f, 1.0f, 0.0f };
@@ -344,9 +402,17 @@ void RenderScene()
 		SwapchainRenderTargetClear, 0, nullptr);
 
 	//Set OM render target for rendering. 
-	CommandList.Get()->OMSetRenderTargets(1, 
-		&GetCPUDescriptorHandleForSwapchainColourBuffer(CurrentSwapchainColourBufferIdx),
-		true, &GetCPUDescriptorHandleForDepthStencilBuffer());
+	uint64_t RenderTarget = GetCPUDescriptorHandleForSwapchainColourBuffer(CurrentSwapchainColourBufferIdx).ptr;
+	FilteredCommands->SetRenderTargets(1, &RenderTarget, GetCPUDescriptorHandleForDepthStencilBuffer().ptr);
+	CommandList.Get()->ClearDepthStencilView(GetCPUDescriptorHandleForDepthStencilBuffer(),
+		D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0, 0, nullptr);
+
+	if (StaticScene)
+	{
+		StaticScene->Render(CommandList.Get(), *FilteredCommands);
+	}
+
+	Scenes->Render();
 
 	//Transition for render target -> From render target to present. 
 	RenderTargetTransition = CD3DX12_RESOURCE_BARRIER::Transition(
@@ -369,6 +435,9 @@ void RenderScene()
 
 	//Wait for GPU to finish before rendering next frame... TODO: Improve
 	FlushCommandQueue();
+
+	//Free anything released while recording that the GPU is now done with
+	ReleaseQueue->Drain();
 }
 
 int PreShutdown()
@@ -377,32 +446,284 @@ int PreShutdown()
 	{
 		//Flush command queue before shutting resources down
 		FlushCommandQueue();
+		ReleaseQueue->Flush();
 	}
 
 	return 0;
 }
 
+//Writes the static scene's recording times to StaticSceneRecording.txt
+int ShutdownStaticScene()
+{
+	int Result = 0;
+	if (StaticScene)
+	{
+		Result = StaticScene->WriteReport("StaticSceneRecording.txt") ? 0 : 1;
+		StaticScene.reset();
+		RenderObjects = D3D12RenderObjects();
+		ReleaseQueue->Flush();
+	}
+	return Result;
+}
+
 int ShutdownScene()
 {
-	return 0;
+	//Scenes are destroyed through the release queue, so flush it again
+	int Result = Scenes->Shutdown();
+	ReleaseQueue->Flush();
+	Scenes.reset();
+
+	MainThreadScheduler.reset();
+	Jobs.reset();
+	return Result;
 }
 
 int ShutdownEngine()
 {
+	FilteredCommands.reset();
+	RenderCommands.reset();
+	ReleaseQueue.reset();
+	DirectQueueFence.reset();
 	return 0;
 }
 
+//Headless texture streaming run: -texturestreamingsim [camerapath.txt]
+//Writes per frame residency/budget stats to TextureStreamingStats.csv
+int RunTextureStreamingSimulation(const char* Args)
+{
+	CameraPath Path;
+
+	char CameraPathFilename[MAX_PATH] = {};
+	if (sscanf(Args, " %259s", CameraPathFilename) != 1 || !Path.LoadFromFile(CameraPathFilename))
+	{
+		Path.GenerateCircuit(3600, 250.0f, 5.0f);
+	}
+
+	TextureStreamingSimulationSettings Settings;
+	TextureStreamingSimulation Simulation(Settings);
+	Simulation.Run(Path);
+
+	return Simulation.WriteStatsCsv("TextureStreamingStats.csv") ? 0 : 1;
+}
+
+//Headless world streaming replay: -worldstreamingsim [camerapath.txt]
+//Writes hitch frames and peak memory (time sliced vs unsliced integration) to
+//WorldStreaming.txt and per frame stats to WorldStreamingStats.csv
+int RunWorldStreamingSimulation(const char* Args)
+{
+	CameraPath Path;
+
+	char CameraPathFilename[MAX_PATH] = {};
+	if (sscanf(Args, " %259s", CameraPathFilename) != 1 || !Path.LoadFromFile(CameraPathFilename))
+	{
+		Path.GenerateCircuit(1200, 600.0f, 2.0f);
+	}
+
+	WorldStreamingSimulationSettings Settings;
+	WorldStreamingSimulation Simulation(Settings);
+	Simulation.Run(Path);
+
+	return Simulation.WriteReport("WorldStreaming.txt") && Simulation.WriteStatsCsv("WorldStreamingStats.csv") ? 0 : 1;
+}
+
+//Headless scene transition run: -scenetransitionsim [transitions]
+//Writes per transition load time and worst frame (background vs blocking
+//loads) to SceneTransition.txt
+int RunSceneTransitionSimulation(const char* Args)
+{
+	SceneTransitionSimulationSettings Settings;
+
+	unsigned TransitionCount = 0;
+	if (sscanf(Args, " %u", &TransitionCount) == 1 && TransitionCount > 0)
+	{
+		Settings.TransitionCount = TransitionCount;
+	}
+
+	SceneTransitionSimulation Simulation(Settings);
+	Simulation.Run();
+
+	return Simulation.WriteReport("SceneTransition.txt") ? 0 : 1;
+}
+
+//Headless residency run: -residencysim [budget in MB]
+//Writes eviction counts and stall time to ResidencySimulation.txt
+int RunResidencySimulation(const char* Args)
+{
+	ResidencySimulationSettings Settings;
+
+	unsigned BudgetMB = 0;
+	if (sscanf(Args, " %u", &BudgetMB) == 1 && BudgetMB > 0)
+	{
+		Settings.BudgetInBytes = static_cast<uint64_t>(BudgetMB) * 1024ull * 1024ull;
+	}
+
+	ResidencySimulation Simulation(Settings);
+	Simulation.Run();
+
+	return Simulation.WriteReport("ResidencySimulation.txt") ? 0 : 1;
+}
+
+//Headless coroutine benchmark: -coroutinebench [iterations]
+//Writes awaits per second and the simulated fence checks to CoroutineBenchmark.txt
+int RunCoroutineBenchmark(const char* Args)
+{
+	CoroutineBenchmarkSettings Settings;
+
+	unsigned Iterations = 0;
+	if (sscanf(Args, " %u", &Iterations) == 1 && Iterations > 0)
+	{
+		Settings.Iterations = Iterations;
+	}
+
+	CoroutineBenchmark Benchmark(Settings);
+	if (!Benchmark.Run())
+	{
+		OutputDebugStringA(Benchmark.GetLastError().c_str());
+		return 1;
+	}
+
+	return Benchmark.WriteReport("CoroutineBenchmark.txt") ? 0 : 1;
+}
+
+//Headless deferred release checks: -releasechecks [frames]
+//Writes the simulated fence checks to DeferredReleaseChecks.txt
+int RunDeferredReleaseChecks(const char* Args)
+{
+	DeferredReleaseChecksSettings Settings;
+
+	unsigned Frames = 0;
+	if (sscanf(Args, " %u", &Frames) == 1 && Frames > 0)
+	{
+		Settings.Frames = Frames;
+	}
+
+	DeferredReleaseChecks Checks(Settings);
+	if (!Checks.Run())
+	{
+		OutputDebugStringA(Checks.GetLastError().c_str());
+		return 1;
+	}
+
+	return Checks.WriteReport("DeferredReleaseChecks.txt") ? 0 : 1;
+}
+
+//Headless entity store benchmark: -entitybench [iterations]
+//Writes entities per millisecond by component count to EntityBenchmark.txt
+int RunEntityBenchmark(const char* Args)
+{
+	EntityBenchmarkSettings Settings;
+
+	unsigned Iterations = 0;
+	if (sscanf(Args, " %u", &Iterations) == 1 && Iterations > 0)
+	{
+		Settings.Iterations = Iterations;
+	}
+
+	EntityBenchmark Benchmark(Settings);
+	if (!Benchmark.Run())
+	{
+		OutputDebugStringA(Benchmark.GetLastError().c_str());
+		return 1;
+	}
+
+	return Benchmark.WriteReport("EntityBenchmark.txt") ? 0 : 1;
+}
+
+//The filename after Switch on the command line, if it's there
+bool GetFilenameArg(const char* CmdLine, const char* Switch, char (&Filename)[260])
+{
+	const char* Arg = strstr(CmdLine, Switch);
+	return Arg && sscanf(Arg + strlen(Switch), " %259s", Filename) == 1;
+}
+
 int APIENTRY WinMain(HINSTANCE Instance, HINSTANCE PrevInstance,
 	LPSTR CmdLine, int CmdShow)
 {
+	//Headless modes - no window or device
+	const char* TextureStreamingSimArg = strstr(CmdLine, "-texturestreamingsim");
+	if (TextureStreamingSimArg)
+	{
+		return RunTextureStreamingSimulation(TextureStreamingSimArg + strlen("-texturestreamingsim"));
+	}
+
+	const char* WorldStreamingSimArg = strstr(CmdLine, "-worldstreamingsim");
+	if (WorldStreamingSimArg)
+	{
+		return RunWorldStreamingSimulation(WorldStreamingSimArg + strlen("-worldstreamingsim"));
+	}
+
+	const char* SceneTransitionSimArg = strstr(CmdLine, "-scenetransitionsim");
+	if (SceneTransitionSimArg)
+	{
+		return RunSceneTransitionSimulation(SceneTransitionSimArg + strlen("-scenetransitionsim"));
+	}
+
+	const char* ResidencySimArg = strstr(CmdLine, "-residencysim");
+	if (ResidencySimArg)
+	{
+		return RunResidencySimulation(ResidencySimArg + strlen("-residencysim"));
+	}
+
+	const char* EntityBenchArg = strstr(CmdLine, "-entitybench");
+	if (EntityBenchArg)
+	{
+		return RunEntityBenchmark(EntityBenchArg + strlen("-entitybench"));
+	}
+
+	const char* CoroutineBenchArg = strstr(CmdLine, "-coroutinebench");
+	if (CoroutineBenchArg)
+	{
+		return RunCoroutineBenchmark(CoroutineBenchArg + strlen("-coroutinebench"));
+	}
+
+	const char* ReleaseChecksArg = strstr(CmdLine, "-releasechecks");
+	if (ReleaseChecksArg)
+	{
+		return RunDeferredReleaseChecks(ReleaseChecksArg + strlen("-releasechecks"));
+	}
+
+	//Scene files: -scene file.pscene loads one in place of the test scene,
+	//-savescene file.pscene writes the active scene out on exit
+	char SceneFilename[260] = {};
+	char SaveSceneFilename[260] = {};
+	bool bLoadScene = GetFilenameArg(CmdLine, "-scene", SceneFilename);
+	bool bSaveScene = GetFilenameArg(CmdLine, "-savescene", SaveSceneFilename);
+
+	//Static geometry: -staticscene file.mesh [objects] draws a grid of the mesh
+	//before the scene, recorded every frame or, with -staticcache, once in to
+	//a cached bundle. -staticrebind frames changes some objects' materials
+	//that often, which re-records the cache.
+	char StaticMeshFilename[260] = {};
+	bool bStaticScene = GetFilenameArg(CmdLine, "-staticscene", StaticMeshFilename);
+	D3D12StaticSceneSettings StaticSceneSettings;
+	StaticSceneSettings.bCached = strstr(CmdLine, "-staticcache") != nullptr;
+	unsigned StaticObjectCount = 0;
+	const char* StaticSceneArg = strstr(CmdLine, "-staticscene");
+	if (StaticSceneArg && sscanf(StaticSceneArg + strlen("-staticscene"), " %*s %u", &StaticObjectCount) == 1 && StaticObjectCount > 0)
+	{
+		StaticSceneSettings.ObjectCount = StaticObjectCount;
+	}
+	const char* StaticRebindArg = strstr(CmdLine, "-staticrebind");
+	unsigned StaticRebindInterval = 0;
+	if (StaticRebindArg && sscanf(StaticRebindArg + strlen("-staticrebind"), " %u", &StaticRebindInterval) == 1)
+	{
+		StaticSceneSettings.RebindInterval = StaticRebindInterval;
+	}
+
 	//Create a window
 	Assert(InitWindow(Instance, PrevInstance, CmdLine, CmdShow));
 
 	//Init D3D12
 	Assert(InitD3D12());
 
+	//Init static geometry - the app runs without it if it can't be created
+	if (bStaticScene)
+	{
+		InitStaticScene(StaticMeshFilename, StaticSceneSettings);
+	}
+
 	//Init scene
-	Assert(InitScene());
+	Assert(InitScene(bLoadScene ? SceneFilename : nullptr));
 
 	//Init game timer
 	GameTimer Timer;
@@ -429,7 +750,12 @@ int APIENTRY WinMain(HINSTANCE Instance, HINSTANCE PrevInstance,
 	}
 
 	//Close
+	if (bSaveScene && !SaveScene(SaveSceneFilename))
+	{
+		OutputDebugStringA("Couldn't save the scene\n");
+	}
 	Assert(PreShutdown() == 0)
+	Assert(ShutdownStaticScene() == 0);
 	Assert(ShutdownScene() == 0);
 	Assert(ShutdownEngine() == 0);
 	return 0;
@@ -0,0 +1,388 @@
+#include "WorldStreamer.h"
+#include "Common.h"
+#include "CoroutineScheduler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	double MillisecondsSince(Clock::time_point Start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - Start).count();
+	}
+
+	struct LoadCandidate
+	{
+		float DistanceSq;
+		WorldCellCoord Coord;
+	};
+}
+
+WorldStreamer::WorldStreamer(IWorldCellSource* Source, IWorldCellHandler* Handler, CoroutineScheduler* Scheduler,
+	const WorldStreamerSettings& Settings)
+	: mSource(Source), mHandler(Handler), mScheduler(Scheduler), mSettings(Settings),
+	mMemoryInBytes(0), mLoadsInFlight(0), mFrameIndex(0)
+{
+	Assert(mSource && mHandler && mScheduler);
+	Assert(mSettings.CellSize > 0.0f && mSettings.UnloadRadius >= mSettings.LoadRadius);
+
+	mSettings.MaxLoadsInFlight = std::max(mSettings.MaxLoadsInFlight, 1u);
+	mSettings.IntegrationBatchSize = std::max(mSettings.IntegrationBatchSize, 1u);
+}
+
+WorldStreamer::~WorldStreamer()
+{
+	//Load coroutines point at their cell
+	Assert(mLoadsInFlight == 0);
+	UnloadAll();
+}
+
+WorldCellCoord WorldStreamer::GetCellAt(const float Position[3]) const
+{
+	WorldCellCoord Coord;
+	Coord.X = static_cast<int32_t>(std::floor(Position[0] / mSettings.CellSize));
+	Coord.Z = static_cast<int32_t>(std::floor(Position[2] / mSettings.CellSize));
+	return Coord;
+}
+
+uint64_t WorldStreamer::MakeKey(const WorldCellCoord& Coord)
+{
+	return (static_cast<uint64_t>(static_cast<uint32_t>(Coord.X)) << 32) | static_cast<uint32_t>(Coord.Z);
+}
+
+float WorldStreamer::GetDistanceSq(const WorldCellCoord& Coord, const float Position[3]) const
+{
+	//To the nearest point of the cell, so the cell the camera is in is at 0
+	float MinX = Coord.X * mSettings.CellSize;
+	float MinZ = Coord.Z * mSettings.CellSize;
+	float DX = std::max(std::max(MinX - Position[0], Position[0] - (MinX + mSettings.CellSize)), 0.0f);
+	float DZ = std::max(std::max(MinZ - Position[2], Position[2] - (MinZ + mSettings.CellSize)), 0.0f);
+	return DX * DX + DZ * DZ;
+}
+
+void WorldStreamer::Update(const float CameraPosition[3])
+{
+	Clock::time_point Start = Clock::now();
+
+	mFrameStats = WorldStreamingFrameStats();
+	mFrameStats.FrameIndex = mFrameIndex++;
+
+	//Drop cells that are out of range. A load can't be interrupted, so a
+	//loading cell is dropped when it arrives - unless it comes back in to
+	//range first.
+	float UnloadRadiusSq = mSettings.UnloadRadius * mSettings.UnloadRadius;
+	std::vector<Cell*> OutOfRange;
+	for (auto& Entry : mCells)
+	{
+		Cell* Existing = Entry.second.get();
+		Existing->DistanceSq = GetDistanceSq(Existing->Coord, CameraPosition);
+		if (Existing->DistanceSq > UnloadRadiusSq)
+		{
+			OutOfRange.push_back(Existing);
+		}
+		else
+		{
+			Existing->bUnloadRequested = false;
+		}
+	}
+	for (Cell* ToUnload : OutOfRange)
+	{
+		UnloadCell(ToUnload);
+	}
+
+	StartLoads(CameraPosition);
+
+	//Removal first, so a frame doesn't add objects while dropped ones are
+	//still waiting to go
+	Clock::time_point SliceStart = Clock::now();
+	RemoveCells(SliceStart);
+	Integrate(SliceStart);
+
+	for (auto& Entry : mCells)
+	{
+		switch (Entry.second->State)
+		{
+		case CellState::Loading:
+			++mFrameStats.CellsLoading;
+			break;
+		case CellState::Integrating:
+			++mFrameStats.CellsAwaitingIntegration;
+			break;
+		case CellState::Active:
+			++mFrameStats.CellsActive;
+			break;
+		case CellState::Removing:
+			++mFrameStats.CellsAwaitingRemoval;
+			break;
+		default:
+			break;
+		}
+	}
+
+	mFrameStats.MemoryInBytes = mMemoryInBytes;
+	mFrameStats.BudgetInBytes = mSettings.MemoryBudgetInBytes;
+	mFrameStats.MainThreadMs = MillisecondsSince(Start);
+}
+
+void WorldStreamer::UnloadAll()
+{
+	std::vector<Cell*> AllCells;
+	for (auto& Entry : mCells)
+	{
+		AllCells.push_back(Entry.second.get());
+	}
+	for (Cell* ToUnload : AllCells)
+	{
+		UnloadCell(ToUnload);
+	}
+
+	for (Cell* ToRemove : mRemovalQueue)
+	{
+		RemoveCell(ToRemove);
+	}
+	mRemovalQueue.clear();
+}
+
+AsyncTask<void> WorldStreamer::LoadCell(Cell* ToLoad)
+{
+	bool bLoaded = co_await mSource->LoadCell(ToLoad->Coord, ToLoad->Data);
+	--mLoadsInFlight;
+
+	if (ToLoad->bUnloadRequested)
+	{
+		mMemoryInBytes -= ToLoad->MemorySize;
+		mCells.erase(MakeKey(ToLoad->Coord));
+		co_return;
+	}
+
+	if (!bLoaded)
+	{
+		//Keep the cell as failed so it isn't retried every frame. It goes
+		//when it leaves range like any other.
+		mMemoryInBytes -= ToLoad->MemorySize;
+		ToLoad->MemorySize = 0;
+		ToLoad->Data = WorldCellData();
+		ToLoad->State = CellState::Failed;
+		co_return;
+	}
+
+	//Trust what actually arrived over the estimate
+	uint64_t LoadedSize = ToLoad->Data.GetMemorySize();
+	mMemoryInBytes = mMemoryInBytes - ToLoad->MemorySize + LoadedSize;
+	ToLoad->MemorySize = LoadedSize;
+
+	ToLoad->State = CellState::Integrating;
+	mIntegrationQueue.push_back(ToLoad);
+}
+
+void WorldStreamer::UnloadCell(Cell* ToUnload)
+{
+	if (ToUnload->State == CellState::Loading)
+	{
+		ToUnload->bUnloadRequested = true;
+		return;
+	}
+	if (ToUnload->State == CellState::Removing)
+	{
+		return;
+	}
+
+	if (ToUnload->State == CellState::Integrating)
+	{
+		mIntegrationQueue.erase(std::find(mIntegrationQueue.begin(), mIntegrationQueue.end(), ToUnload));
+	}
+
+	mMemoryInBytes -= ToUnload->MemorySize;
+	ToUnload->MemorySize = 0;
+	++mFrameStats.CellsUnloaded;
+
+	//Anything in the world is taken out within the frame budget. The cell
+	//stays in the map until then, so it can't be loaded again and integrated
+	//ahead of its own removal.
+	if (ToUnload->IntegratedCount > 0)
+	{
+		ToUnload->State = CellState::Removing;
+		mRemovalQueue.push_back(ToUnload);
+		return;
+	}
+	mCells.erase(MakeKey(ToUnload->Coord));
+}
+
+bool WorldStreamer::IsOutOfTime(Clock::time_point SliceStart) const
+{
+	return mSettings.IntegrationBudgetMs > 0.0 && MillisecondsSince(SliceStart) >= mSettings.IntegrationBudgetMs;
+}
+
+void WorldStreamer::RemoveCells(Clock::time_point SliceStart)
+{
+	//Budget is checked after each cell, so some progress is always made
+	size_t Removed = 0;
+	while (Removed < mRemovalQueue.size())
+	{
+		RemoveCell(mRemovalQueue[Removed++]);
+		if (IsOutOfTime(SliceStart))
+		{
+			break;
+		}
+	}
+	mRemovalQueue.erase(mRemovalQueue.begin(), mRemovalQueue.begin() + Removed);
+}
+
+void WorldStreamer::RemoveCell(Cell* ToRemove)
+{
+	Assert(ToRemove->State == CellState::Removing);
+	mHandler->RemoveCell(ToRemove->Coord);
+	++mFrameStats.CellsRemoved;
+	mCells.erase(MakeKey(ToRemove->Coord));
+}
+
+bool WorldStreamer::EvictFartherThan(float DistanceSq, uint64_t BytesNeeded)
+{
+	std::vector<Cell*> Candidates;
+	uint64_t Evictable = 0;
+	for (auto& Entry : mCells)
+	{
+		Cell* Existing = Entry.second.get();
+		if (Existing->State != CellState::Loading && Existing->State != CellState::Removing && Existing->DistanceSq > DistanceSq)
+		{
+			Candidates.push_back(Existing);
+			Evictable += Existing->MemorySize;
+		}
+	}
+
+	//Don't throw anything away unless it makes enough room
+	if (mMemoryInBytes - Evictable + BytesNeeded > mSettings.MemoryBudgetInBytes)
+	{
+		return false;
+	}
+
+	std::sort(Candidates.begin(), Candidates.end(), [](const Cell* A, const Cell* B)
+	{
+		return A->DistanceSq > B->DistanceSq;
+	});
+
+	for (Cell* ToEvict : Candidates)
+	{
+		if (mMemoryInBytes + BytesNeeded <= mSettings.MemoryBudgetInBytes)
+		{
+			break;
+		}
+		UnloadCell(ToEvict);
+	}
+	return true;
+}
+
+void WorldStreamer::StartLoads(const float CameraPosition[3])
+{
+	if (mLoadsInFlight >= mSettings.MaxLoadsInFlight)
+	{
+		return;
+	}
+
+	float LoadRadiusSq = mSettings.LoadRadius * mSettings.LoadRadius;
+	int32_t MinX = static_cast<int32_t>(std::floor((CameraPosition[0] - mSettings.LoadRadius) / mSettings.CellSize));
+	int32_t MaxX = static_cast<int32_t>(std::floor((CameraPosition[0] + mSettings.LoadRadius) / mSettings.CellSize));
+	int32_t MinZ = static_cast<int32_t>(std::floor((CameraPosition[2] - mSettings.LoadRadius) / mSettings.CellSize));
+	int32_t MaxZ = static_cast<int32_t>(std::floor((CameraPosition[2] + mSettings.LoadRadius) / mSettings.CellSize));
+
+	std::vector<LoadCandidate> Candidates;
+	for (int32_t Z = MinZ; Z <= MaxZ; ++Z)
+	{
+		for (int32_t X = MinX; X <= MaxX; ++X)
+		{
+			LoadCandidate Candidate;
+			Candidate.Coord.X = X;
+			Candidate.Coord.Z = Z;
+			Candidate.DistanceSq = GetDistanceSq(Candidate.Coord, CameraPosition);
+
+			if (Candidate.DistanceSq <= LoadRadiusSq && mCells.find(MakeKey(Candidate.Coord)) == mCells.end() &&
+				mSource->HasCell(Candidate.Coord))
+			{
+				Candidates.push_back(Candidate);
+			}
+		}
+	}
+
+	std::sort(Candidates.begin(), Candidates.end(), [](const LoadCandidate& A, const LoadCandidate& B)
+	{
+		return A.DistanceSq < B.DistanceSq;
+	});
+
+	for (size_t CandidateIdx = 0; CandidateIdx < Candidates.size() && mLoadsInFlight < mSettings.MaxLoadsInFlight; ++CandidateIdx)
+	{
+		const LoadCandidate& Candidate = Candidates[CandidateIdx];
+
+		//Nearest first - if this one doesn't fit nothing after it should load
+		//ahead of it
+		uint64_t Size = mSource->GetCellMemorySize(Candidate.Coord);
+		if (mMemoryInBytes + Size > mSettings.MemoryBudgetInBytes && !EvictFartherThan(Candidate.DistanceSq, Size))
+		{
+			mFrameStats.LoadsDeferredByBudget += static_cast<uint32_t>(Candidates.size() - CandidateIdx);
+			break;
+		}
+
+		std::unique_ptr<Cell> NewCell(new Cell());
+		NewCell->Coord = Candidate.Coord;
+		NewCell->State = CellState::Loading;
+		NewCell->MemorySize = Size;
+		NewCell->IntegratedCount = 0;
+		NewCell->bUnloadRequested = false;
+		NewCell->DistanceSq = Candidate.DistanceSq;
+
+		Cell* ToLoad = NewCell.get();
+		mCells[MakeKey(Candidate.Coord)] = std::move(NewCell);
+		mMemoryInBytes += Size;
+		++mLoadsInFlight;
+		++mFrameStats.LoadsStarted;
+
+		mScheduler->Spawn(LoadCell(ToLoad));
+	}
+}
+
+void WorldStreamer::Integrate(Clock::time_point SliceStart)
+{
+	//Removals may have used up the frame
+	if (mIntegrationQueue.empty() || IsOutOfTime(SliceStart))
+	{
+		return;
+	}
+
+	//Nearest cells first
+	std::sort(mIntegrationQueue.begin(), mIntegrationQueue.end(), [](const Cell* A, const Cell* B)
+	{
+		return A->DistanceSq < B->DistanceSq;
+	});
+
+	//Budget is checked after each batch, so some progress is made whenever
+	//removals have left any time
+	size_t Finished = 0;
+	bool bOutOfTime = false;
+	while (Finished < mIntegrationQueue.size() && !bOutOfTime)
+	{
+		Cell* ToIntegrate = mIntegrationQueue[Finished];
+		uint32_t ObjectCount = static_cast<uint32_t>(ToIntegrate->Data.Objects.size());
+
+		while (ToIntegrate->IntegratedCount < ObjectCount && !bOutOfTime)
+		{
+			uint32_t Begin = ToIntegrate->IntegratedCount;
+			uint32_t End = std::min(ObjectCount, Begin + mSettings.IntegrationBatchSize);
+			mHandler->IntegrateObjects(ToIntegrate->Coord, ToIntegrate->Data, Begin, End);
+			ToIntegrate->IntegratedCount = End;
+			mFrameStats.ObjectsIntegrated += End - Begin;
+
+			bOutOfTime = IsOutOfTime(SliceStart);
+		}
+
+		if (ToIntegrate->IntegratedCount == ObjectCount)
+		{
+			ToIntegrate->State = CellState::Active;
+			++Finished;
+		}
+	}
+
+	mIntegrationQueue.erase(mIntegrationQueue.begin(), mIntegrationQueue.begin() + Finished);
+}
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "AsyncTask.h"
+
+class CoroutineScheduler;
+
+//World streaming by grid cell.
+//
+//The world is split in to square cells on XZ. Cells within LoadRadius of the
+//camera are loaded in the background (nearest first, within a memory budget)
+//and cells beyond UnloadRadius are dropped. Loaded cells are then integrated
+//in to the world on the main thread a batch of objects at a time, spending at
+//most IntegrationBudgetMs per frame, so a big cell arriving is spread over
+//several frames rather than causing a hitch. Removing a dropped cell from the
+//world comes out of the same per frame budget; its memory leaves the budget
+//as soon as it's dropped.
+//
+//Where cells come from (disk, procedural) and what integrating an object means
+//(adding it to the scene, creating GPU resources) are left to an
+//IWorldCellSource and an IWorldCellHandler.
+
+struct WorldCellCoord
+{
+	int32_t X;
+	int32_t Z;
+
+	bool operator==(const WorldCellCoord& Other) const { return X == Other.X && Z == Other.Z; }
+};
+
+struct WorldObject
+{
+	float Position[3];
+	float Yaw;
+	float Scale;
+	uint32_t MeshId;
+	uint32_t MaterialId;
+};
+
+//A loaded cell - placed objects plus whatever bulk data they reference
+//(geometry, textures) as one blob.
+struct WorldCellData
+{
+	std::vector<WorldObject> Objects;
+	std::vector<uint8_t> Payload;
+
+	uint64_t GetMemorySize() const { return Objects.size() * sizeof(WorldObject) + Payload.size(); }
+};
+
+class IWorldCellSource
+{
+public:
+	IWorldCellSource() {};
+	virtual ~IWorldCellSource() {};
+
+	virtual bool HasCell(const WorldCellCoord& Coord) const = 0;
+
+	//Size the cell will be once loaded, so it can be budgeted before loading.
+	virtual uint64_t GetCellMemorySize(const WorldCellCoord& Coord) const = 0;
+
+	//Loads the cell in to OutData. Resumed on the scheduler (main) thread, so
+	//anything heavy must be awaited on a job or the I/O queue.
+	virtual AsyncTask<bool> LoadCell(WorldCellCoord Coord, WorldCellData& OutData) = 0;
+};
+
+class IWorldCellHandler
+{
+public:
+	IWorldCellHandler() {};
+	virtual ~IWorldCellHandler() {};
+
+	//Main thread. Adds objects [Begin, End) of a loaded cell to the world. A
+	//cell is integrated in order over as many calls as the time budget needs.
+	virtual void IntegrateObjects(const WorldCellCoord& Coord, const WorldCellData& Data, uint32_t Begin, uint32_t End) = 0;
+
+	//Main thread. Removes everything integrated from the cell so far. The
+	//cell's data is kept until this returns.
+	virtual void RemoveCell(const WorldCellCoord& Coord) = 0;
+};
+
+struct WorldStreamerSettings
+{
+	float CellSize = 100.0f;
+	float LoadRadius = 350.0f;
+	float UnloadRadius = 450.0f;	//Larger than LoadRadius so cells on the edge don't thrash
+
+	//Loaded, loading and integrating cells together.
+	uint64_t MemoryBudgetInBytes = 128ull * 1024ull * 1024ull;
+
+	uint32_t MaxLoadsInFlight = 4;
+
+	//Main thread time per frame for removing dropped cells and integrating
+	//loaded ones. 0 = do all of it in the frame it comes up.
+	double IntegrationBudgetMs = 1.0;
+	uint32_t IntegrationBatchSize = 32;		//Objects between clock checks
+};
+
+struct WorldStreamingFrameStats
+{
+	uint64_t FrameIndex = 0;
+	uint64_t MemoryInBytes = 0;
+	uint64_t BudgetInBytes = 0;
+
+	uint32_t CellsActive = 0;
+	uint32_t CellsLoading = 0;
+	uint32_t CellsAwaitingIntegration = 0;	//Loaded or part integrated
+	uint32_t CellsAwaitingRemoval = 0;		//Dropped, still in the world
+
+	uint32_t LoadsStarted = 0;
+	uint32_t CellsUnloaded = 0;
+	uint32_t CellsRemoved = 0;				//Taken out of the world
+	uint32_t LoadsDeferredByBudget = 0;
+	uint32_t ObjectsIntegrated = 0;
+
+	double MainThreadMs = 0.0;		//Spent in Update()
+};
+
+class WorldStreamer
+{
+public:
+	WorldStreamer(IWorldCellSource* Source, IWorldCellHandler* Handler, CoroutineScheduler* Scheduler,
+		const WorldStreamerSettings& Settings);
+	~WorldStreamer();
+
+	//Once per frame on the main thread, after the scheduler has been pumped.
+	void Update(const float CameraPosition[3]);
+
+	//Removes every cell, straight away rather than within the budget. Loads
+	//in flight are dropped when they finish - pump the scheduler until
+	//HasLoadsInFlight() is false before destroying.
+	void UnloadAll();
+	bool HasLoadsInFlight() const { return mLoadsInFlight > 0; }
+
+	uint64_t GetMemoryInBytes() const { return mMemoryInBytes; }
+	const WorldStreamingFrameStats& GetFrameStats() const { return mFrameStats; }
+
+	WorldCellCoord GetCellAt(const float Position[3]) const;
+
+private:
+	typedef std::chrono::high_resolution_clock Clock;
+
+	enum class CellState
+	{
+		Loading,
+		Integrating,	//Loaded, objects [0, IntegratedCount) are in the world
+		Active,
+		Failed,			//Not retried until it has left range
+		Removing		//Dropped, waiting for its turn to be taken out of the world
+	};
+
+	struct Cell
+	{
+		WorldCellCoord Coord;
+		CellState State;
+		uint64_t MemorySize;		//Reserved from the budget when the load starts
+		uint32_t IntegratedCount;
+		bool bUnloadRequested;		//Dropped when its load finishes
+		float DistanceSq;			//To the camera as of this frame
+		WorldCellData Data;
+	};
+
+	static uint64_t MakeKey(const WorldCellCoord& Coord);
+
+	AsyncTask<void> LoadCell(Cell* ToLoad);
+
+	float GetDistanceSq(const WorldCellCoord& Coord, const float Position[3]) const;
+	void UnloadCell(Cell* ToUnload);
+	bool EvictFartherThan(float DistanceSq, uint64_t BytesNeeded);
+	void StartLoads(const float CameraPosition[3]);
+	bool IsOutOfTime(Clock::time_point SliceStart) const;
+	void RemoveCells(Clock::time_point SliceStart);
+	void RemoveCell(Cell* ToRemove);
+	void Integrate(Clock::time_point SliceStart);
+
+private:
+	IWorldCellSource* mSource;
+	IWorldCellHandler* mHandler;
+	CoroutineScheduler* mScheduler;
+	WorldStreamerSettings mSettings;
+
+	std::unordered_map<uint64_t, std::unique_ptr<Cell>> mCells;
+	std::vector<Cell*> mIntegrationQueue;
+	std::vector<Cell*> mRemovalQueue;		//Oldest first
+
+	uint64_t mMemoryInBytes;
+	uint32_t mLoadsInFlight;
+	uint64_t mFrameIndex;
+	WorldStreamingFrameStats mFrameStats;
+};
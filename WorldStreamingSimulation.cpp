@@ -0,0 +1,241 @@
+#include "WorldStreamingSimulation.h"
+#include "Common.h"
+#include "CoroutineScheduler.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <stdio.h>
+#include <thread>
+
+namespace
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	uint64_t MakeCellKey(const WorldCellCoord& Coord)
+	{
+		return (static_cast<uint64_t>(static_cast<uint32_t>(Coord.X)) << 32) | static_cast<uint32_t>(Coord.Z);
+	}
+}
+
+WorldStreamingSimulation::WorldStreamingSimulation(const WorldStreamingSimulationSettings& Settings)
+	: mSettings(Settings)
+{
+	mSettings.World.CellSize = mSettings.Streamer.CellSize;
+}
+
+WorldStreamingSimulation::~WorldStreamingSimulation()
+{}
+
+void WorldStreamingSimulation::Run(const CameraPath& Path)
+{
+	mSummaries.clear();
+	mFrameStats.clear();
+
+	mSummaries.push_back(RunMode(Path, "TimeSliced", mSettings.Streamer.IntegrationBudgetMs, &mFrameStats));
+	mSummaries.push_back(RunMode(Path, "Unsliced", 0.0, nullptr));
+}
+
+WorldStreamingRunSummary WorldStreamingSimulation::RunMode(const CameraPath& Path, const char* Mode,
+	double IntegrationBudgetMs, std::vector<WorldStreamingFrameStats>* OutFrameStats)
+{
+	WorldStreamerSettings StreamerSettings = mSettings.Streamer;
+	StreamerSettings.IntegrationBudgetMs = IntegrationBudgetMs;
+
+	JobSystem Jobs(mSettings.ThreadCount);
+	CoroutineScheduler Scheduler;
+	ProceduralWorldCellSource Source(mSettings.World, &Jobs, &Scheduler);
+	WorldStreamer Streamer(&Source, this, &Scheduler, StreamerSettings);
+
+	WorldStreamingRunSummary Summary;
+	Summary.Mode = Mode;
+	Summary.FrameCount = Path.GetSampleCount();
+
+	std::vector<double> StreamingMs;
+	StreamingMs.reserve(Path.GetSampleCount());
+
+	std::chrono::duration<double, std::milli> FrameDuration(mSettings.FrameMilliseconds);
+	Clock::time_point NextFrame = Clock::now();
+
+	for (unsigned Frame = 0; Frame < Path.GetSampleCount(); ++Frame)
+	{
+		//Main thread streaming cost - load completions plus the streamer update
+		Clock::time_point FrameStart = Clock::now();
+		Scheduler.Pump();
+		Streamer.Update(Path.GetSample(Frame).Position);
+		double FrameMs = std::chrono::duration<double, std::milli>(Clock::now() - FrameStart).count();
+
+		const WorldStreamingFrameStats& Stats = Streamer.GetFrameStats();
+		if (OutFrameStats)
+		{
+			OutFrameStats->push_back(Stats);
+			OutFrameStats->back().MainThreadMs = FrameMs;
+		}
+
+		StreamingMs.push_back(FrameMs);
+		if (FrameMs > mSettings.HitchThresholdMs)
+		{
+			Summary.HitchFrames.push_back(Frame);
+		}
+		Summary.PeakMemoryInBytes = std::max(Summary.PeakMemoryInBytes, Stats.MemoryInBytes);
+		Summary.FramesOverBudget += Stats.MemoryInBytes > Stats.BudgetInBytes ? 1 : 0;
+		Summary.LoadsStarted += Stats.LoadsStarted;
+		Summary.CellsUnloaded += Stats.CellsUnloaded;
+		Summary.ObjectsIntegrated += Stats.ObjectsIntegrated;
+		Summary.PeakCellsActive = std::max(Summary.PeakCellsActive, Stats.CellsActive);
+
+		//Real time pacing so background loads progress as they would in game
+		NextFrame += std::chrono::duration_cast<Clock::duration>(FrameDuration);
+		std::this_thread::sleep_until(NextFrame);
+	}
+
+	Streamer.UnloadAll();
+	while (Streamer.HasLoadsInFlight() || Scheduler.GetRunningTaskCount() > 0)
+	{
+		if (Scheduler.Pump() == 0)
+		{
+			std::this_thread::yield();
+		}
+	}
+	Assert(mWorldCells.empty());
+
+	if (!StreamingMs.empty())
+	{
+		double Total = 0.0;
+		for (double Ms : StreamingMs)
+		{
+			Total += Ms;
+		}
+		Summary.AverageStreamingMs = Total / StreamingMs.size();
+
+		std::sort(StreamingMs.begin(), StreamingMs.end());
+		Summary.MaxStreamingMs = StreamingMs.back();
+		Summary.P99StreamingMs = StreamingMs[std::min(StreamingMs.size() - 1, static_cast<size_t>(StreamingMs.size() * 0.99))];
+	}
+
+	return Summary;
+}
+
+void WorldStreamingSimulation::IntegrateObjects(const WorldCellCoord& Coord, const WorldCellData& Data, uint32_t Begin, uint32_t End)
+{
+	std::vector<IntegratedObject>& Cell = mWorldCells[MakeCellKey(Coord)];
+
+	for (uint32_t ObjectIdx = Begin; ObjectIdx < End; ++ObjectIdx)
+	{
+		const WorldObject& Object = Data.Objects[ObjectIdx];
+
+		IntegratedObject Integrated;
+		float Sin = std::sin(Object.Yaw) * Object.Scale;
+		float Cos = std::cos(Object.Yaw) * Object.Scale;
+		float World[12] =
+		{
+			Cos, 0.0f, Sin, Object.Position[0],
+			0.0f, Object.Scale, 0.0f, Object.Position[1],
+			-Sin, 0.0f, Cos, Object.Position[2]
+		};
+		std::copy(World, World + 12, Integrated.World);
+
+		//World space bounds of a generated hull around the object
+		uint32_t State = Object.MeshId * 2654435761u + ObjectIdx + 1;
+		for (int Axis = 0; Axis < 3; ++Axis)
+		{
+			Integrated.BoundsMin[Axis] = 1e30f;
+			Integrated.BoundsMax[Axis] = -1e30f;
+		}
+		for (uint32_t Point = 0; Point < mSettings.CollisionPointsPerObject; ++Point)
+		{
+			float Local[3];
+			for (int Axis = 0; Axis < 3; ++Axis)
+			{
+				State ^= State << 13;
+				State ^= State >> 17;
+				State ^= State << 5;
+				Local[Axis] = (State & 0xFFFF) * (2.0f / 65535.0f) - 1.0f;
+			}
+			for (int Axis = 0; Axis < 3; ++Axis)
+			{
+				const float* Row = World + Axis * 4;
+				float Value = Row[0] * Local[0] + Row[1] * Local[1] + Row[2] * Local[2] + Row[3];
+				Integrated.BoundsMin[Axis] = std::min(Integrated.BoundsMin[Axis], Value);
+				Integrated.BoundsMax[Axis] = std::max(Integrated.BoundsMax[Axis], Value);
+			}
+		}
+
+		Cell.push_back(Integrated);
+	}
+}
+
+void WorldStreamingSimulation::RemoveCell(const WorldCellCoord& Coord)
+{
+	mWorldCells.erase(MakeCellKey(Coord));
+}
+
+bool WorldStreamingSimulation::WriteReport(const char* Filename) const
+{
+	FILE* File = fopen(Filename, "w");
+	if (!File)
+	{
+		return false;
+	}
+
+	const WorldStreamerSettings& Streamer = mSettings.Streamer;
+	fprintf(File, "Cell size %.0f, load/unload radius %.0f/%.0f, budget %.1f MB, %u loads in flight\n",
+		Streamer.CellSize, Streamer.LoadRadius, Streamer.UnloadRadius,
+		Streamer.MemoryBudgetInBytes / (1024.0 * 1024.0), Streamer.MaxLoadsInFlight);
+	fprintf(File, "Frame %.2f ms, hitch threshold %.2f ms, integration budget %.2f ms\n\n",
+		mSettings.FrameMilliseconds, mSettings.HitchThresholdMs, Streamer.IntegrationBudgetMs);
+
+	for (const WorldStreamingRunSummary& Summary : mSummaries)
+	{
+		fprintf(File, "%s\n", Summary.Mode.c_str());
+		fprintf(File, "  Frames:             %u\n", Summary.FrameCount);
+		fprintf(File, "  Hitch frames:       %u\n", static_cast<uint32_t>(Summary.HitchFrames.size()));
+		fprintf(File, "  Streaming ms:       avg %.3f, p99 %.3f, max %.3f\n",
+			Summary.AverageStreamingMs, Summary.P99StreamingMs, Summary.MaxStreamingMs);
+		fprintf(File, "  Peak memory:        %.1f MB\n", Summary.PeakMemoryInBytes / (1024.0 * 1024.0));
+		fprintf(File, "  Frames over budget: %u\n", Summary.FramesOverBudget);
+		fprintf(File, "  Loads started:      %u\n", Summary.LoadsStarted);
+		fprintf(File, "  Cells unloaded:     %u\n", Summary.CellsUnloaded);
+		fprintf(File, "  Peak active cells:  %u\n", Summary.PeakCellsActive);
+		fprintf(File, "  Objects integrated: %llu\n", (unsigned long long)Summary.ObjectsIntegrated);
+
+		if (!Summary.HitchFrames.empty())
+		{
+			fprintf(File, "  Hitches at:        ");
+			for (uint32_t Frame : Summary.HitchFrames)
+			{
+				fprintf(File, " %u", Frame);
+			}
+			fprintf(File, "\n");
+		}
+		fprintf(File, "\n");
+	}
+
+	fclose(File);
+	return true;
+}
+
+bool WorldStreamingSimulation::WriteStatsCsv(const char* Filename) const
+{
+	FILE* File = fopen(Filename, "w");
+	if (!File)
+	{
+		return false;
+	}
+
+	fprintf(File, "Frame,Memory,Budget,CellsActive,CellsLoading,CellsAwaitingIntegration,CellsAwaitingRemoval,LoadsStarted,"
+		"CellsUnloaded,CellsRemoved,LoadsDeferredByBudget,ObjectsIntegrated,MainThreadMs\n");
+
+	for (const WorldStreamingFrameStats& Stats : mFrameStats)
+	{
+		fprintf(File, "%llu,%llu,%llu,%u,%u,%u,%u,%u,%u,%u,%u,%u,%.3f\n",
+			(unsigned long long)Stats.FrameIndex, (unsigned long long)Stats.MemoryInBytes,
+			(unsigned long long)Stats.BudgetInBytes, Stats.CellsActive, Stats.CellsLoading,
+			Stats.CellsAwaitingIntegration, Stats.CellsAwaitingRemoval, Stats.LoadsStarted, Stats.CellsUnloaded,
+			Stats.CellsRemoved, Stats.LoadsDeferredByBudget, Stats.ObjectsIntegrated, Stats.MainThreadMs);
+	}
+
+	fclose(File);
+	return true;
+}
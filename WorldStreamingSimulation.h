@@ -0,0 +1,82 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "CameraPath.h"
+#include "ProceduralWorldCellSource.h"
+#include "WorldStreamer.h"
+
+//Headless world streaming replay: a procedural world is streamed along a
+//camera path in real time (frames are paced to FrameMilliseconds, loads run
+//on real worker threads) and the main thread cost of streaming is recorded
+//every frame. A frame is a hitch when that cost exceeds HitchThresholdMs.
+//
+//The path is replayed twice, with integration time sliced and with every
+//loaded cell integrated in the frame it arrives, to show what slicing buys.
+//Integrating an object builds its world matrix and a bounding box from a
+//generated collision hull, standing in for scene/physics registration.
+struct WorldStreamingSimulationSettings
+{
+	WorldStreamerSettings Streamer;
+	ProceduralWorldSettings World;
+
+	double FrameMilliseconds = 1000.0 / 60.0;
+	double HitchThresholdMs = 4.0;
+	uint32_t CollisionPointsPerObject = 48;
+	uint32_t ThreadCount = 0;
+};
+
+struct WorldStreamingRunSummary
+{
+	std::string Mode;
+	uint32_t FrameCount = 0;
+	std::vector<uint32_t> HitchFrames;
+	double MaxStreamingMs = 0.0;
+	double AverageStreamingMs = 0.0;
+	double P99StreamingMs = 0.0;
+	uint64_t PeakMemoryInBytes = 0;
+	uint32_t FramesOverBudget = 0;
+	uint32_t LoadsStarted = 0;
+	uint32_t CellsUnloaded = 0;
+	uint64_t ObjectsIntegrated = 0;
+	uint32_t PeakCellsActive = 0;
+};
+
+class WorldStreamingSimulation : private IWorldCellHandler
+{
+public:
+	WorldStreamingSimulation(const WorldStreamingSimulationSettings& Settings);
+	~WorldStreamingSimulation();
+
+	void Run(const CameraPath& Path);
+
+	bool WriteReport(const char* Filename) const;
+
+	//Per frame stats of the time sliced run.
+	bool WriteStatsCsv(const char* Filename) const;
+
+private:
+	struct IntegratedObject
+	{
+		float World[12];		//3x4 row major
+		float BoundsMin[3];
+		float BoundsMax[3];
+	};
+
+	WorldStreamingRunSummary RunMode(const CameraPath& Path, const char* Mode, double IntegrationBudgetMs,
+		std::vector<WorldStreamingFrameStats>* OutFrameStats);
+
+	void IntegrateObjects(const WorldCellCoord& Coord, const WorldCellData& Data, uint32_t Begin, uint32_t End) override;
+	void RemoveCell(const WorldCellCoord& Coord) override;
+
+private:
+	WorldStreamingSimulationSettings mSettings;
+
+	//The "world" the streamer integrates in to
+	std::unordered_map<uint64_t, std::vector<IntegratedObject>> mWorldCells;
+
+	std::vector<WorldStreamingRunSummary> mSummaries;
+	std::vector<WorldStreamingFrameStats> mFrameStats;
+};